@@ -1,122 +1,120 @@
 ﻿using System;
-using System.Collections.Generic;
-using System.ComponentModel;
-using System.Linq;
+using System.Runtime.InteropServices;
 using System.Text;
-using System.Threading.Tasks;
-using System.Globalization;
-using System.IO;
-using System.Runtime.CompilerServices;
+using Ophidian.Losgap.Interop;
 
 namespace Ophidian.Losgap.AssetManagement {
 	public static partial class AssetLoader {
-		private static unsafe ModelDataStream LoadObj(string objFile) {
-			List<Vector3> positions = new List<Vector3>();
-			List<Vector2> texCoords = new List<Vector2>();
-			List<Vector3> normals = new List<Vector3>();
-			List<ModelVertex> vertices = new List<ModelVertex>(); // A list of vertices in the order required to construct each face
-			List<uint> indices = new List<uint>();
+		private const string NATIVE_DLL_NAME = "CoreNative.dll";
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		private struct ObjModelCounts {
+			public uint NumPositions;
+			public uint NumTexCoords;
+			public uint NumNormals;
+			public uint NumVertices;
+			public uint NumIndices;
+		}
 
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ObjLoader_Load")]
+		private static extern InteropBool ObjLoader_Load(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string filePath,
+			IntPtr outModel, // ObjModel**
+			IntPtr outCounts // ObjModelCounts*
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ObjLoader_Parse")]
+		private static extern InteropBool ObjLoader_Parse(
+			IntPtr failReason,
+			IntPtr text, // const char*
+			uint textLength,
+			IntPtr outModel, // ObjModel**
+			IntPtr outCounts // ObjModelCounts*
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ObjLoader_CopyModel")]
+		private static extern InteropErrorCode ObjLoader_CopyModel(
+			IntPtr model,
+			IntPtr outPositionArr,
+			IntPtr outTexCoordArr,
+			IntPtr outNormalArr,
+			IntPtr outVertexArr,
+			IntPtr outIndexArr
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ObjLoader_FreeModel")]
+		private static extern InteropErrorCode ObjLoader_FreeModel(
+			IntPtr model
+			);
+
+		// Parsing, triangulation and vertex deduplication all happen in ObjLoader (CoreNative); see ObjLoader.h for what is supported.
+		// Each distinct position/tex coord/normal combination becomes one vertex, shared between every face that uses it.
+		private static unsafe ModelDataStream LoadObj(string objFile) {
 			Assure.NotNull(objFile);
 			Assure.True(IOUtils.IsValidFilePath(objFile));
 
-			// Read file into String Array
-			string[] objFileContent = File.ReadAllLines(objFile);
-
-			// Process File
-			uint[] pIndices = new uint[10];
-			uint[] nIndices = new uint[10];
-			uint[] tIndices = new uint[10];
-			int indexArrLen = 10;
-
-			
-
-			foreach (string[] lineParts in objFileContent.Select(line => line.ToUpper().Split(new[] { ' ' }, StringSplitOptions.RemoveEmptyEntries))) {
-				if (lineParts.Length == 0) continue;
-
-				switch (lineParts[0]) {
-					case "VT": // Tex coord line - Reads it properly. Not the cause of the UV problem. - UV Problems FIXED. V Axis Mirrored
-						texCoords.Add(new Vector2(
-							float.Parse(lineParts[1], CultureInfo.InvariantCulture),
-							float.Parse(lineParts[2], CultureInfo.InvariantCulture)
-							));
-						break;
-						
-					case "VN": // Normal line
-						normals.Add(new Vector3(
-							float.Parse(lineParts[1], CultureInfo.InvariantCulture),
-							float.Parse(lineParts[2], CultureInfo.InvariantCulture),
-							float.Parse(lineParts[3], CultureInfo.InvariantCulture)
-						));
-						break;
-					case "V": // Positions line
-						positions.Add(new Vector3(
-							float.Parse(lineParts[1], CultureInfo.InvariantCulture),
-							float.Parse(lineParts[2], CultureInfo.InvariantCulture),
-							float.Parse(lineParts[3], CultureInfo.InvariantCulture)
-						));
-						break;
-					case "F": // Face
-						int numVertices = lineParts.Length - 1;
-						if (indexArrLen < numVertices) {
-							indexArrLen = numVertices * 2;
-							pIndices = new uint[indexArrLen];
-							nIndices = new uint[indexArrLen];
-							tIndices = new uint[indexArrLen];
-						}
-
-						for (int vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex) {
-							string[] indexParts = lineParts[vertexIndex + 1].Split('/');
-
-							pIndices[vertexIndex] = UInt32.Parse(indexParts[0], CultureInfo.InvariantCulture) - 1U;
+			IntPtr model;
+			ObjModelCounts counts;
+			InteropUtils.CallNative(ObjLoader_Load, objFile, (IntPtr) (&model), (IntPtr) (&counts)).ThrowOnFailure();
+			return CopyAndFreeObjModel(model, counts);
+		}
 
-							if (indexParts.Length >= 2 && indexParts[1] != String.Empty) {
-								tIndices[vertexIndex] = UInt32.Parse(indexParts[1], CultureInfo.InvariantCulture) - 1U;
-							}
-							else tIndices[vertexIndex] = 0;
+		// Parses OBJ text that is already in memory exactly as LoadObj parses a file's contents.
+		internal static unsafe ModelDataStream ParseObj(string objText) {
+			Assure.NotNull(objText);
+
+			byte[] textBytes = Encoding.UTF8.GetBytes(objText);
+			IntPtr model;
+			ObjModelCounts counts;
+			fixed (byte* textPtr = textBytes) {
+				InteropUtils.CallNative(
+					ObjLoader_Parse,
+					(IntPtr) textPtr,
+					(uint) textBytes.Length,
+					(IntPtr) (&model),
+					(IntPtr) (&counts)
+				).ThrowOnFailure();
+			}
+			return CopyAndFreeObjModel(model, counts);
+		}
 
-							if (indexParts.Length >= 3 && indexParts[2] != String.Empty) {
-								nIndices[vertexIndex] = UInt32.Parse(indexParts[2], CultureInfo.InvariantCulture) - 1U;
+		private static unsafe ModelDataStream CopyAndFreeObjModel(IntPtr model, ObjModelCounts counts) {
+			try {
+				Vector3[] positions = new Vector3[counts.NumPositions];
+				Vector2[] texCoords = new Vector2[counts.NumTexCoords];
+				Vector3[] normals = new Vector3[counts.NumNormals];
+				ModelVertex[] vertices = new ModelVertex[counts.NumVertices];
+				uint[] indices = new uint[counts.NumIndices];
+
+				fixed (Vector3* positionsPtr = positions) {
+					fixed (Vector2* texCoordsPtr = texCoords) {
+						fixed (Vector3* normalsPtr = normals) {
+							fixed (ModelVertex* verticesPtr = vertices) {
+								fixed (uint* indicesPtr = indices) {
+									ObjLoader_CopyModel(
+										model,
+										(IntPtr) positionsPtr,
+										(IntPtr) texCoordsPtr,
+										(IntPtr) normalsPtr,
+										(IntPtr) verticesPtr,
+										(IntPtr) indicesPtr
+									).ThrowOnFailure();
+								}
 							}
-							else nIndices[vertexIndex] = 0;
-						}
-
-
-						
-						IEnumerable<ModelVertex> triangulatedVertices = TriangulateFace(numVertices, pIndices, tIndices, nIndices);
-						foreach (ModelVertex mv in triangulatedVertices) {
-							vertices.Add(mv);
 						}
-						break;
+					}
 				}
 
+				return new ModelDataStream(vertices, positions, texCoords, normals, indices);
 			}
-
-			texCoords = TexCoordsMirror(texCoords);
-
-			uint[] indexArray = new uint[vertices.Count];
-			for (uint i = 0U; i < indexArray.Length; ++i) {
-				indexArray[i] = i;
+			finally {
+				ObjLoader_FreeModel(model).ThrowOnFailure();
 			}
-			GC.Collect();
-			return new ModelDataStream(vertices.ToArray(), positions.ToArray(), texCoords.ToArray(), normals.ToArray(), indexArray);
-		}
-
-		private static List<Vector2> TexCoordsMirror(List<Vector2> listInput) {
-			return listInput.Select(input => new Vector2(input.X, 0.5f + (0.5f - input.Y))).ToList();
-		}
-
-		private static unsafe IEnumerable<ModelVertex> TriangulateFace(int numVertices, uint[] pIndices, uint[] tIndices, uint[] nIndices) {
-			Assure.GreaterThan(numVertices, 2);
-			ModelVertex[] result = new ModelVertex[(numVertices - 2) * 3];
-
-			for (int i = 2, resultIndex = 0; i < numVertices; i++) {
-				result[resultIndex++] = new ModelVertex(pIndices[0], tIndices[0], nIndices[0]);
-				result[resultIndex++] = new ModelVertex(pIndices[i - 1], tIndices[i - 1], nIndices[i - 1]);
-				result[resultIndex++] = new ModelVertex(pIndices[i], tIndices[i], nIndices[i]);
-			}
-
-			return result;
 		}
 	}
 }
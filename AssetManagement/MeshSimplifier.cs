@@ -0,0 +1,316 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 01:31 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+
+namespace Ophidian.Losgap.AssetManagement {
+	/// <summary>
+	/// Makes coarser versions of triangle meshes, for use as levels of detail (see
+	/// <c>GeometryCacheBuilder.AddModelLOD()</c>). Meant to be run once when models are loaded (or offline), not
+	/// every frame.
+	/// </summary>
+	/// <remarks>
+	/// Edges are collapsed one at a time, cheapest first, where the cost of moving a vertex on to its neighbour is the squared distance
+	/// from the new position to the planes of the triangles that have been merged in to the vertex so far (weighted by area; the
+	/// "quadric error metric"). Vertices are only ever moved on to other vertices, so the simplified mesh indexes the same vertex list
+	/// as the original. Vertices are welded by position first, so seams in texture coordinates or normals don't stop edges collapsing;
+	/// vertices on open edges of the mesh never move, and collapses that would flip a triangle over (from how it faced originally, not
+	/// just before the collapse) or pinch the surface are skipped.
+	/// </remarks>
+	public static class MeshSimplifier {
+		private const double FLIP_TOLERANCE = 0.05; // Minimum cosine between a triangle's normal after a collapse and both its last and original normals
+
+		private struct Collapse {
+			public double Cost;
+			public int From;
+			public int To;
+			public uint FromStamp;
+			public uint ToStamp;
+		}
+
+		private sealed class ExactPositionComparer : IEqualityComparer<Vector3> {
+			public bool Equals(Vector3 x, Vector3 y) {
+				return x.EqualsExactly(y);
+			}
+
+			public int GetHashCode(Vector3 obj) {
+				return obj.GetHashCode();
+			}
+		}
+
+		/// <summary>
+		/// Returns the indices of a simplified version of the given triangles (three indices in to <paramref name="vertexPositions"/>
+		/// each), with roughly <paramref name="targetTriangleRatio"/> times as many triangles (fewer can not always be reached without
+		/// damaging the shape). Triangles whose corners don't move keep their original indices.
+		/// </summary>
+		/// <param name="vertexPositions">The position of every vertex. Must not be null.</param>
+		/// <param name="indices">The mesh's triangles. Must not be null, and its length must be a multiple of 3.</param>
+		/// <param name="targetTriangleRatio">The fraction of triangles to keep. Must be greater than 0 and no more than 1.</param>
+		[System.Diagnostics.CodeAnalysis.SuppressMessage("Microsoft.Naming", "CA1726:UsePreferredTerms", MessageId = "indices",
+			Justification = "Indices is more in-tune with the graphics-programming side of the world.")]
+		public static uint[] Simplify(IList<Vector3> vertexPositions, IList<uint> indices, float targetTriangleRatio) {
+			if (vertexPositions == null) throw new ArgumentNullException("vertexPositions");
+			if (indices == null) throw new ArgumentNullException("indices");
+			if (indices.Count % 3 != 0) throw new ArgumentException("Index count must be a multiple of 3.", "indices");
+			if (!(targetTriangleRatio > 0f) || targetTriangleRatio > 1f) {
+				throw new ArgumentOutOfRangeException("targetTriangleRatio", "Target triangle ratio must be greater than 0 and no more than 1.");
+			}
+			for (int i = 0; i < indices.Count; ++i) {
+				if (indices[i] >= vertexPositions.Count) throw new ArgumentException("Index " + indices[i] + " is out of range.", "indices");
+			}
+
+			// Weld vertices by position, remembering the first original vertex at each position
+			Dictionary<Vector3, int> positionMap = new Dictionary<Vector3, int>(new ExactPositionComparer());
+			List<Vector3> positions = new List<Vector3>();
+			List<uint> firstVertices = new List<uint>();
+			int[] weldedVertices = new int[vertexPositions.Count];
+			for (int i = 0; i < vertexPositions.Count; ++i) {
+				int welded;
+				if (!positionMap.TryGetValue(vertexPositions[i], out welded)) {
+					welded = positions.Count;
+					positionMap.Add(vertexPositions[i], welded);
+					positions.Add(vertexPositions[i]);
+					firstVertices.Add((uint) i);
+				}
+				weldedVertices[i] = welded;
+			}
+
+			int numVertices = positions.Count;
+			int numTriangles = indices.Count / 3;
+			int[] triangles = new int[numTriangles * 3];
+			bool[] triangleAlive = new bool[numTriangles];
+			Vector3[] originalNormals = new Vector3[numTriangles];
+			List<int>[] vertexTriangles = new List<int>[numVertices];
+			for (int v = 0; v < numVertices; ++v) vertexTriangles[v] = new List<int>();
+			double[] quadrics = new double[numVertices * 10];
+			int numLiveTriangles = 0;
+
+			for (int t = 0; t < numTriangles; ++t) {
+				int a = triangles[t * 3 + 0] = weldedVertices[indices[t * 3 + 0]];
+				int b = triangles[t * 3 + 1] = weldedVertices[indices[t * 3 + 1]];
+				int c = triangles[t * 3 + 2] = weldedVertices[indices[t * 3 + 2]];
+				if (a == b || b == c || c == a) continue;
+				triangleAlive[t] = true;
+				++numLiveTriangles;
+				vertexTriangles[a].Add(t);
+				vertexTriangles[b].Add(t);
+				vertexTriangles[c].Add(t);
+
+				Vector3 normal = originalNormals[t] = Vector3.Cross(positions[b] - positions[a], positions[c] - positions[a]);
+				double doubleArea = normal.Length;
+				if (doubleArea <= 0.0) continue;
+				double nx = normal.X / doubleArea, ny = normal.Y / doubleArea, nz = normal.Z / doubleArea;
+				double d = -(nx * positions[a].X + ny * positions[a].Y + nz * positions[a].Z);
+				AddPlaneQuadric(quadrics, a, nx, ny, nz, d, doubleArea);
+				AddPlaneQuadric(quadrics, b, nx, ny, nz, d, doubleArea);
+				AddPlaneQuadric(quadrics, c, nx, ny, nz, d, doubleArea);
+			}
+
+			int targetTriangles = Math.Max((int) (numLiveTriangles * targetTriangleRatio), 1);
+			if (numLiveTriangles > targetTriangles) {
+				// Lock vertices on open or non-manifold edges, so that the outline of the mesh stays put
+				bool[] vertexLocked = new bool[numVertices];
+				Dictionary<long, int> edgeCounts = new Dictionary<long, int>();
+				for (int t = 0; t < numTriangles; ++t) {
+					if (!triangleAlive[t]) continue;
+					for (int e = 0; e < 3; ++e) {
+						long edgeKey = EdgeKey(triangles[t * 3 + e], triangles[t * 3 + (e + 1) % 3]);
+						int count;
+						edgeCounts.TryGetValue(edgeKey, out count);
+						edgeCounts[edgeKey] = count + 1;
+					}
+				}
+				foreach (KeyValuePair<long, int> edgeCount in edgeCounts) {
+					if (edgeCount.Value == 2) continue;
+					vertexLocked[(int) (edgeCount.Key >> 32)] = true;
+					vertexLocked[(int) (edgeCount.Key & 0xFFFFFFFFL)] = true;
+				}
+
+				bool[] vertexAlive = new bool[numVertices];
+				for (int v = 0; v < numVertices; ++v) vertexAlive[v] = vertexTriangles[v].Count > 0;
+				uint[] vertexStamps = new uint[numVertices];
+				List<Collapse> heap = new List<Collapse>();
+				HashSet<int> neighbourWorkspace = new HashSet<int>();
+				HashSet<int> otherNeighbourWorkspace = new HashSet<int>();
+
+				for (int t = 0; t < numTriangles; ++t) {
+					if (!triangleAlive[t]) continue;
+					for (int e = 0; e < 3; ++e) {
+						int a = triangles[t * 3 + e];
+						int b = triangles[t * 3 + (e + 1) % 3];
+						if (!vertexLocked[a]) PushCollapse(heap, quadrics, positions, vertexStamps, a, b);
+						if (!vertexLocked[b]) PushCollapse(heap, quadrics, positions, vertexStamps, b, a);
+					}
+				}
+
+				while (numLiveTriangles > targetTriangles && heap.Count > 0) {
+					Collapse collapse = PopCollapse(heap);
+					int from = collapse.From;
+					int to = collapse.To;
+					if (!vertexAlive[from] || !vertexAlive[to]) continue;
+					if (vertexStamps[from] != collapse.FromStamp || vertexStamps[to] != collapse.ToStamp) continue; // Stale
+					if (!CanCollapse(from, to, triangles, triangleAlive, vertexTriangles, positions, originalNormals, neighbourWorkspace, otherNeighbourWorkspace)) {
+						continue;
+					}
+
+					// Move 'from' on to 'to': triangles using both disappear, the rest of 'from's triangles now use 'to'
+					foreach (int t in vertexTriangles[from]) {
+						if (!triangleAlive[t]) continue;
+						int fromCorner = -1;
+						bool hasTo = false;
+						for (int c = 0; c < 3; ++c) {
+							if (triangles[t * 3 + c] == from) fromCorner = c;
+							else if (triangles[t * 3 + c] == to) hasTo = true;
+						}
+						if (fromCorner < 0) continue;
+						if (hasTo) {
+							triangleAlive[t] = false;
+							--numLiveTriangles;
+						}
+						else {
+							triangles[t * 3 + fromCorner] = to;
+							vertexTriangles[to].Add(t);
+						}
+					}
+					vertexTriangles[from].Clear();
+					vertexAlive[from] = false;
+					for (int q = 0; q < 10; ++q) quadrics[to * 10 + q] += quadrics[from * 10 + q];
+					vertexTriangles[to].RemoveAll(t => !triangleAlive[t]);
+
+					// Every collapse on to or away from 'to' now costs something different
+					++vertexStamps[to];
+					CollectNeighbours(to, triangles, triangleAlive, vertexTriangles, neighbourWorkspace);
+					foreach (int neighbour in neighbourWorkspace) {
+						if (!vertexLocked[to]) PushCollapse(heap, quadrics, positions, vertexStamps, to, neighbour);
+						if (!vertexLocked[neighbour]) PushCollapse(heap, quadrics, positions, vertexStamps, neighbour, to);
+					}
+				}
+			}
+
+			// Corners that didn't move keep their own vertex; moved ones use the first vertex at their new position
+			List<uint> result = new List<uint>(numLiveTriangles * 3);
+			for (int t = 0; t < numTriangles; ++t) {
+				if (!triangleAlive[t]) continue;
+				for (int c = 0; c < 3; ++c) {
+					uint originalVertex = indices[t * 3 + c];
+					int welded = triangles[t * 3 + c];
+					result.Add(welded == weldedVertices[originalVertex] ? originalVertex : firstVertices[welded]);
+				}
+			}
+			return result.ToArray();
+		}
+
+		private static long EdgeKey(int a, int b) {
+			return a < b ? ((long) a << 32) | (uint) b : ((long) b << 32) | (uint) a;
+		}
+
+		private static void AddPlaneQuadric(double[] quadrics, int vertex, double a, double b, double c, double d, double weight) {
+			int q = vertex * 10;
+			quadrics[q + 0] += weight * a * a;
+			quadrics[q + 1] += weight * a * b;
+			quadrics[q + 2] += weight * a * c;
+			quadrics[q + 3] += weight * a * d;
+			quadrics[q + 4] += weight * b * b;
+			quadrics[q + 5] += weight * b * c;
+			quadrics[q + 6] += weight * b * d;
+			quadrics[q + 7] += weight * c * c;
+			quadrics[q + 8] += weight * c * d;
+			quadrics[q + 9] += weight * d * d;
+		}
+
+		private static void PushCollapse(List<Collapse> heap, double[] quadrics, List<Vector3> positions, uint[] vertexStamps, int from, int to) {
+			// Error of (from's quadric + to's quadric) at to's position
+			int qa = from * 10, qb = to * 10;
+			double x = positions[to].X, y = positions[to].Y, z = positions[to].Z;
+			double cost = 0.0;
+			for (int i = 0; i < 2; ++i) {
+				int q = i == 0 ? qa : qb;
+				cost += quadrics[q + 0] * x * x + 2.0 * quadrics[q + 1] * x * y + 2.0 * quadrics[q + 2] * x * z + 2.0 * quadrics[q + 3] * x
+					+ quadrics[q + 4] * y * y + 2.0 * quadrics[q + 5] * y * z + 2.0 * quadrics[q + 6] * y
+					+ quadrics[q + 7] * z * z + 2.0 * quadrics[q + 8] * z
+					+ quadrics[q + 9];
+			}
+
+			heap.Add(new Collapse { Cost = cost, From = from, To = to, FromStamp = vertexStamps[from], ToStamp = vertexStamps[to] });
+			int child = heap.Count - 1;
+			while (child > 0) {
+				int parent = (child - 1) >> 1;
+				if (heap[parent].Cost <= heap[child].Cost) break;
+				Collapse swap = heap[parent];
+				heap[parent] = heap[child];
+				heap[child] = swap;
+				child = parent;
+			}
+		}
+
+		private static Collapse PopCollapse(List<Collapse> heap) {
+			Collapse result = heap[0];
+			heap[0] = heap[heap.Count - 1];
+			heap.RemoveAt(heap.Count - 1);
+			int parent = 0;
+			while (true) {
+				int smallest = parent;
+				int left = (parent << 1) + 1;
+				int right = left + 1;
+				if (left < heap.Count && heap[left].Cost < heap[smallest].Cost) smallest = left;
+				if (right < heap.Count && heap[right].Cost < heap[smallest].Cost) smallest = right;
+				if (smallest == parent) break;
+				Collapse swap = heap[parent];
+				heap[parent] = heap[smallest];
+				heap[smallest] = swap;
+				parent = smallest;
+			}
+			return result;
+		}
+
+		private static void CollectNeighbours(int vertex, int[] triangles, bool[] triangleAlive, List<int>[] vertexTriangles, HashSet<int> outNeighbours) {
+			outNeighbours.Clear();
+			foreach (int t in vertexTriangles[vertex]) {
+				if (!triangleAlive[t]) continue;
+				for (int c = 0; c < 3; ++c) {
+					if (triangles[t * 3 + c] != vertex) outNeighbours.Add(triangles[t * 3 + c]);
+				}
+			}
+		}
+
+		private static bool CanCollapse(int from, int to, int[] triangles, bool[] triangleAlive, List<int>[] vertexTriangles,
+			List<Vector3> positions, Vector3[] originalNormals, HashSet<int> fromNeighbours, HashSet<int> toNeighbours) {
+			// The two must still share an edge, and (the link condition) share no neighbours other than the (up to) two opposite that
+			// edge, otherwise the collapse would pinch the surface
+			CollectNeighbours(from, triangles, triangleAlive, vertexTriangles, fromNeighbours);
+			if (!fromNeighbours.Contains(to)) return false;
+			CollectNeighbours(to, triangles, triangleAlive, vertexTriangles, toNeighbours);
+			toNeighbours.IntersectWith(fromNeighbours);
+			if (toNeighbours.Count > 2) return false;
+
+			// None of the triangles that remain may turn over (or collapse to a line), either in this collapse or (as several collapses
+			// that each turn a triangle a little could) since the mesh was loaded
+			Vector3 newPosition = positions[to];
+			foreach (int t in vertexTriangles[from]) {
+				if (!triangleAlive[t]) continue;
+				int fromCorner = -1;
+				bool hasTo = false;
+				for (int c = 0; c < 3; ++c) {
+					if (triangles[t * 3 + c] == from) fromCorner = c;
+					else if (triangles[t * 3 + c] == to) hasTo = true;
+				}
+				if (fromCorner < 0 || hasTo) continue;
+
+				Vector3 a = positions[triangles[t * 3 + fromCorner]];
+				Vector3 b = positions[triangles[t * 3 + (fromCorner + 1) % 3]];
+				Vector3 c2 = positions[triangles[t * 3 + (fromCorner + 2) % 3]];
+				Vector3 oldNormal = Vector3.Cross(b - a, c2 - a);
+				Vector3 newNormal = Vector3.Cross(b - newPosition, c2 - newPosition);
+				double oldLength = oldNormal.Length;
+				double newLength = newNormal.Length;
+				double originalLength = originalNormals[t].Length;
+				if (newLength <= 0.0) return false;
+				if (oldLength > 0.0 && Vector3.Dot(oldNormal, newNormal) < FLIP_TOLERANCE * oldLength * newLength) return false;
+				if (originalLength > 0.0 && Vector3.Dot(originalNormals[t], newNormal) < FLIP_TOLERANCE * originalLength * newLength) return false;
+			}
+			return true;
+		}
+	}
+}
@@ -33,6 +33,18 @@ namespace Ophidian.Losgap.AssetManagement {
 		public uint[] GetIndices() {
 			return Indices;
 		}
+
+		/// <summary>
+		/// Returns the indices of a simplified version of this model (see <see cref="MeshSimplifier.Simplify"/>) with roughly
+		/// <paramref name="triangleRatio"/> times as many triangles, indexing the same vertices as <see cref="GetIndices"/>.
+		/// </summary>
+		public uint[] GetLODIndices(float triangleRatio) {
+			Vector3[] vertexPositions = new Vector3[NumVertices];
+			for (int i = 0; i < NumVertices; ++i) {
+				vertexPositions[i] = Positions[Vertices[i].PositionIndex];
+			}
+			return MeshSimplifier.Simplify(vertexPositions, Indices, triangleRatio);
+		}
 		public TVertex[] GetVerticesWithoutTangents<TVertex>(ConstructorInfo positionNormalTexCoordCtor) where TVertex : struct {
 			Assure.NotNull(positionNormalTexCoordCtor);
 
@@ -52,8 +64,8 @@ namespace Ophidian.Losgap.AssetManagement {
 			Assure.Equal(Indices.Length % 3, 0);
 			Assure.NotEqual(TexCoords.Length, 0);
 
-			TVertex[] result = new TVertex[NumVertices];
-
+			// Vertices are shared between faces, so each one's tangent is the average of those of the faces around it
+			Vector3[] tangents = new Vector3[NumVertices];
 			for (int tri = 0; tri < Indices.Length / 3; ++tri) {
 				var c1 = Vertices[Indices[tri * 3 + 0]];
 				var c2 = Vertices[Indices[tri * 3 + 1]];
@@ -82,24 +94,24 @@ namespace Ophidian.Losgap.AssetManagement {
 					(t2 * y1 - t1 * y2) * r,
 					(t2 * z1 - t1 * z2) * r
 				);
+				float tanLength = tan.Length;
+				if (Single.IsNaN(tanLength) || Single.IsInfinity(tanLength) || tanLength < MathUtils.FlopsErrorMargin) continue; // Degenerate UVs
 
-				result[tri * 3 + 0] = (TVertex) positionNormalTangentTexCoordCtor.Invoke(new object[] {
-					v1, 
-					Normals.Length > 0 ? Normals[c1.NormalIndex] : Vector3.BACKWARD,
-					tan,
-					w1
-				});
-				result[tri * 3 + 1] = (TVertex) positionNormalTangentTexCoordCtor.Invoke(new object[] {
-					v2, 
-					Normals.Length > 0 ? Normals[c2.NormalIndex] : Vector3.BACKWARD,
-					tan,
-					w2
-				});
-				result[tri * 3 + 2] = (TVertex) positionNormalTangentTexCoordCtor.Invoke(new object[] {
-					v3, 
-					Normals.Length > 0 ? Normals[c3.NormalIndex] : Vector3.BACKWARD,
-					tan,
-					w3
+				tan /= tanLength;
+				tangents[Indices[tri * 3 + 0]] += tan;
+				tangents[Indices[tri * 3 + 1]] += tan;
+				tangents[Indices[tri * 3 + 2]] += tan;
+			}
+
+			TVertex[] result = new TVertex[NumVertices];
+			for (int i = 0; i < NumVertices; ++i) {
+				Vector3 normal = Normals.Length > 0 ? Normals[Vertices[i].NormalIndex] : Vector3.BACKWARD;
+				Vector3 tangent = tangents[i].LengthSquared > MathUtils.FlopsErrorMargin ? tangents[i].ToUnit() : normal.AnyPerpendicular();
+				result[i] = (TVertex) positionNormalTangentTexCoordCtor.Invoke(new object[] {
+					Positions[Vertices[i].PositionIndex], 
+					normal,
+					tangent,
+					TexCoords[Vertices[i].TexCoordIndex]
 				});
 			}
 
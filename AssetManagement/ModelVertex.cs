@@ -1,10 +1,12 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Linq;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Threading.Tasks;
 
 namespace Ophidian.Losgap.AssetManagement {
+	[StructLayout(LayoutKind.Sequential)] // Copied straight from ObjVertex in CoreNative
 	internal struct ModelVertex {
 		public readonly uint PositionIndex;
 		public readonly uint TexCoordIndex;
@@ -0,0 +1,144 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 20:12 by Ben Bowen
+
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace Ophidian.Losgap.Interop {
+	/// <summary>
+	/// Gives each thread access to its native per-frame linear allocator (FrameArena in CoreNative). Memory reserved here is 16-byte
+	/// aligned, contiguous, and valid until the calling thread next calls <see cref="Reset"/>; it is intended for scratch data handed to
+	/// native code (e.g. render command arguments).
+	/// </summary>
+	/// <remarks>
+	/// The arena's bookkeeping lives in native memory that this class reads and writes directly, so reserving memory normally requires
+	/// no native call at all. Only when the current block is full (or, in debug native builds, when resetting) is the native side invoked.
+	/// </remarks>
+	public static unsafe class FrameArena {
+		private const string NATIVE_DLL_NAME = "CoreNative.dll";
+		private const ulong ALIGNMENT = 16UL;
+		// Registering an existing name returns its ID, so this is the same gauge the native Reset() sets (METRIC_ARENA_HIGH_WATER_MARK)
+		private static readonly uint highWaterMarkMetricID = NativeMetrics.Register("Core.FrameArenaHighWaterMark", NativeMetricType.Gauge);
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		private struct FrameArenaState {
+			public IntPtr Base;
+			public ulong Capacity;
+			public ulong Offset;
+			public ulong RetiredBytes;
+			public ulong HighWaterMark;
+			public uint GuardBytes;
+		}
+
+		[ThreadStatic]
+		private static IntPtr threadArena;
+		[ThreadStatic]
+		private static IntPtr threadArenaState;
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrameArena_GetThreadArena")]
+		private static extern InteropBool FrameArena_GetThreadArena(
+			IntPtr failReason,
+			IntPtr outArena, // FrameArena**
+			IntPtr outState // FrameArenaState**
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrameArena_ReleaseThreadArena")]
+		private static extern InteropBool FrameArena_ReleaseThreadArena(
+			IntPtr failReason
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrameArena_Allocate")]
+		private static extern InteropBool FrameArena_Allocate(
+			IntPtr failReason,
+			IntPtr arena,
+			uint numBytes,
+			IntPtr outAllocation // void**
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrameArena_Reset")]
+		private static extern InteropBool FrameArena_Reset(
+			IntPtr failReason,
+			IntPtr arena
+			);
+
+		/// <summary>
+		/// The most memory (in bytes) the calling thread's arena has had in use at once since it was created.
+		/// </summary>
+		public static ulong HighWaterMark {
+			get {
+				return GetThreadArenaState()->HighWaterMark;
+			}
+		}
+
+		/// <summary>
+		/// Reserves <paramref name="numBytes"/> of 16-byte-aligned memory from the calling thread's arena.
+		/// The memory is not zeroed.
+		/// </summary>
+		/// <param name="numBytes">The number of bytes to reserve.</param>
+		/// <returns>A pointer to the reserved memory, valid until this thread next calls <see cref="Reset"/>.</returns>
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static IntPtr Reserve(uint numBytes) {
+			FrameArenaState* state = GetThreadArenaState();
+			if (state->GuardBytes == 0U) {
+				ulong allocationStart = (state->Offset + ALIGNMENT - 1UL) & ~(ALIGNMENT - 1UL);
+				ulong allocationEnd = allocationStart + numBytes;
+				if (allocationEnd <= state->Capacity) {
+					state->Offset = allocationEnd;
+					if (state->RetiredBytes + allocationEnd > state->HighWaterMark) state->HighWaterMark = state->RetiredBytes + allocationEnd;
+					return state->Base + (int) allocationStart;
+				}
+			}
+			return ReserveNative(numBytes);
+		}
+
+		/// <summary>
+		/// Releases everything reserved from the calling thread's arena. Any pointers previously returned by <see cref="Reserve"/> on
+		/// this thread are invalid after this call.
+		/// </summary>
+		public static void Reset() {
+			FrameArenaState* state = GetThreadArenaState();
+			if (state->RetiredBytes == 0UL && state->GuardBytes == 0U) {
+				state->Offset = 0UL;
+				NativeMetrics.Record(highWaterMarkMetricID, (long) state->HighWaterMark);
+				return;
+			}
+			InteropUtils.CallNative(FrameArena_Reset, threadArena).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Frees the calling thread's arena. Should be called by threads that used the arena before they exit; any remaining arenas are
+		/// freed when the native module is unloaded.
+		/// </summary>
+		public static void ReleaseThreadArena() {
+			if (threadArena == IntPtr.Zero) return;
+			InteropUtils.CallNative(FrameArena_ReleaseThreadArena).ThrowOnFailure();
+			threadArena = IntPtr.Zero;
+			threadArenaState = IntPtr.Zero;
+		}
+
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		private static FrameArenaState* GetThreadArenaState() {
+			if (threadArenaState == IntPtr.Zero) AcquireThreadArena();
+			return (FrameArenaState*) threadArenaState;
+		}
+
+		private static void AcquireThreadArena() {
+			IntPtr arena, state;
+			InteropUtils.CallNative(FrameArena_GetThreadArena, (IntPtr) (&arena), (IntPtr) (&state)).ThrowOnFailure();
+			threadArena = arena;
+			threadArenaState = state;
+		}
+
+		private static IntPtr ReserveNative(uint numBytes) {
+			IntPtr result;
+			InteropUtils.CallNative(FrameArena_Allocate, threadArena, numBytes, (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+	}
+}
@@ -0,0 +1,33 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 19:05 by Ben Bowen
+
+using System;
+
+namespace Ophidian.Losgap.Interop {
+	/// <summary>
+	/// The value returned by native methods that use the fast export convention (<c>EXPORT_FAST</c>). These methods take no
+	/// fail-reason buffer; on failure the message is kept natively and fetched by <see cref="InteropUtils.ThrowOnFailure"/>.
+	/// </summary>
+	/// <remarks>
+	/// The values here must match the <c>INTEROP_ERROR_*</c> definitions in CoreNative's Macro.h.
+	/// </remarks>
+	public enum InteropErrorCode : uint {
+		/// <summary>
+		/// The call succeeded.
+		/// </summary>
+		None = 0U,
+		/// <summary>
+		/// The call failed with a LosgapException.
+		/// </summary>
+		LosgapException = 1U,
+		/// <summary>
+		/// The call failed with a standard library exception.
+		/// </summary>
+		StdException = 2U,
+		/// <summary>
+		/// The call failed with an exception of unknown type.
+		/// </summary>
+		UnknownException = 3U
+	}
+}
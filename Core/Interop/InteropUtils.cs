@@ -53,6 +53,31 @@ namespace Ophidian.Losgap.Interop {
 			Optimal = 8
 		}
 
+		private const string CORE_NATIVE_DLL_NAME = "CoreNative.dll";
+
+		[DllImport(CORE_NATIVE_DLL_NAME, CallingConvention = DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InteropError_GetLastMessage")]
+		private static extern IntPtr InteropError_GetLastMessage(); // const char16_t*
+
+		/// <summary>
+		/// Throws a new <see cref="NativeOperationFailedException"/> if <paramref name="errorCode"/> indicates that a fast-convention
+		/// native call failed, with the message that the native side recorded for this thread. Nothing is allocated on success.
+		/// </summary>
+		/// <remarks>
+		/// Must be called on the same thread as the native call that returned <paramref name="errorCode"/>, before any other
+		/// fast-convention call is made on that thread.
+		/// </remarks>
+		/// <param name="errorCode">The value returned by the native call.</param>
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		public static void ThrowOnFailure(this InteropErrorCode errorCode) {
+			if (errorCode != InteropErrorCode.None) ThrowLastNativeError(errorCode);
+		}
+
+		private static void ThrowLastNativeError(InteropErrorCode errorCode) {
+			string failureMessage = Marshal.PtrToStringUni(InteropError_GetLastMessage());
+			throw new NativeOperationFailedException(failureMessage ?? ("Unknown internal error (" + errorCode + ")."));
+		}
+
 		#region CallNative Methods
 		/// <summary>
 		/// Calls a native (extern) method with the standard P/Invoke template, and no further arguments.
@@ -0,0 +1,78 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 17:48 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap {
+	/// <summary>
+	/// Controls the lifetime of the native job system in CoreNative, which the native modules use for their own internal parallel work.
+	/// The pipeline starts it alongside the <see cref="ParallelizationProvider"/>, with only as many threads as there are cores left
+	/// over once the provider's slaves are counted, so that native and managed work together don't oversubscribe the machine.
+	/// </summary>
+	internal static class NativeJobSystem {
+		private const string NATIVE_DLL_NAME = "CoreNative.dll";
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "JobSystem_Init")]
+		private static extern InteropBool JobSystem_Init(
+			IntPtr failReason,
+			uint numWorkers,
+			IntPtr affinityMaskArr // ulong*
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "JobSystem_Shutdown")]
+		private static extern InteropBool JobSystem_Shutdown(
+			IntPtr failReason
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "JobSystem_GetWorkerCount")]
+		private static extern InteropBool JobSystem_GetWorkerCount(
+			IntPtr failReason,
+			IntPtr outNumWorkers // uint*
+			);
+
+		/// <summary>
+		/// Starts the native workers. The thread that waits on native work always helps out, so the number of workers spawned is
+		/// one fewer than <paramref name="numThreads"/>.
+		/// </summary>
+		/// <param name="numThreads">The total number of threads native work may occupy, including the caller.</param>
+		/// <param name="affinityMasks">Optionally, one affinity mask per spawned worker (0 leaves a worker unpinned).</param>
+		public static unsafe void Start(uint numThreads, ulong[] affinityMasks = null) {
+			Assure.GreaterThan(numThreads, 0U);
+			uint numWorkers = numThreads - 1U;
+			if (affinityMasks != null && affinityMasks.Length < numWorkers) {
+				throw new ArgumentException("Must supply an affinity mask for every worker.", "affinityMasks");
+			}
+			fixed (ulong* affinityMasksPtr = affinityMasks) {
+				InteropUtils.CallNative(
+					JobSystem_Init,
+					numWorkers,
+					(IntPtr) affinityMasksPtr
+				).ThrowOnFailure();
+			}
+			Logger.Log("Native job system started with " + numWorkers + " workers.");
+		}
+
+		public static void Stop() {
+			InteropUtils.CallNative(
+				JobSystem_Shutdown
+			).ThrowOnFailure();
+		}
+
+		public static unsafe uint WorkerCount {
+			get {
+				uint result;
+				InteropUtils.CallNative(
+					JobSystem_GetWorkerCount,
+					(IntPtr) (&result)
+				).ThrowOnFailure();
+				return result;
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 21:09 by Ben Bowen
+
+using System;
+using System.Linq;
+
+namespace Ophidian.Losgap {
+	/// <summary>
+	/// The value of one native metric at the time of a <see cref="NativeMetrics.Snapshot"/>.
+	/// </summary>
+	public struct NativeMetric {
+		/// <summary>
+		/// The number of buckets in every histogram. Bucket 0 counts values below 1, bucket <c>i</c> counts values in
+		/// [2^(i-1), 2^i), and the last bucket counts everything larger.
+		/// </summary>
+		public const int NUM_HISTOGRAM_BUCKETS = 16;
+		/// <summary>
+		/// The name the metric was registered with, e.g. "Rendering.DrawCalls".
+		/// </summary>
+		public readonly string Name;
+		/// <summary>
+		/// The kind of metric this is.
+		/// </summary>
+		public readonly NativeMetricType Type;
+		/// <summary>
+		/// The number of values recorded since the last reset (always 1 for gauges).
+		/// </summary>
+		public readonly ulong Count;
+		/// <summary>
+		/// The sum of the values recorded since the last reset, or the current value for gauges.
+		/// </summary>
+		public readonly long Sum;
+		private readonly ulong[] buckets;
+
+		internal NativeMetric(string name, NativeMetricType type, ulong count, long sum, ulong[] buckets) {
+			Name = name;
+			Type = type;
+			Count = count;
+			Sum = sum;
+			this.buckets = buckets;
+		}
+
+		/// <summary>
+		/// The mean recorded value since the last reset, or 0 if nothing was recorded.
+		/// </summary>
+		public double Mean {
+			get {
+				return Count == 0UL ? 0d : (double) Sum / Count;
+			}
+		}
+
+		/// <summary>
+		/// Returns the number of values counted in the given histogram bucket.
+		/// </summary>
+		/// <param name="bucketIndex">The bucket index, in [0, <see cref="NUM_HISTOGRAM_BUCKETS"/>).</param>
+		/// <returns>The number of values in that bucket.</returns>
+		public ulong GetBucketCount(int bucketIndex) {
+			Assure.BetweenOrEqualTo(bucketIndex, 0, NUM_HISTOGRAM_BUCKETS - 1, "Invalid bucket index.");
+			return buckets[bucketIndex];
+		}
+
+		public override string ToString() {
+			switch (Type) {
+				case NativeMetricType.Gauge: return Name + ": " + Sum;
+				case NativeMetricType.Histogram:
+					return Name + ": n=" + Count + ", mean=" + Mean.ToString("0.##") + " [" + String.Join(", ", buckets.Select(b => b.ToString())) + "]";
+				default: return Name + ": " + Sum;
+			}
+		}
+	}
+}
@@ -0,0 +1,25 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 21:05 by Ben Bowen
+
+using System;
+
+namespace Ophidian.Losgap {
+	/// <summary>
+	/// The kinds of metric that can be registered with <see cref="NativeMetrics"/>.
+	/// </summary>
+	public enum NativeMetricType : uint {
+		/// <summary>
+		/// A running total. Every recorded value is added to it.
+		/// </summary>
+		Counter = 0U,
+		/// <summary>
+		/// A single value. Every recorded value replaces the last one.
+		/// </summary>
+		Gauge = 1U,
+		/// <summary>
+		/// A distribution. Every recorded value is counted in to one of <see cref="NativeMetric.NUM_HISTOGRAM_BUCKETS"/> power-of-two buckets.
+		/// </summary>
+		Histogram = 2U
+	}
+}
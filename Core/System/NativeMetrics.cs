@@ -0,0 +1,132 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 21:14 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap {
+	/// <summary>
+	/// Exposes the shared native metrics registry in CoreNative, which the native modules use to count draw calls, flushed commands,
+	/// contacts, ray tests, allocations, load times and so on. Collection is off until <see cref="Enabled"/> is set, and costs next to
+	/// nothing while it is.
+	/// </summary>
+	public static unsafe class NativeMetrics {
+		private const string NATIVE_DLL_NAME = "CoreNative.dll";
+		/// <summary>
+		/// The maximum length of a metric name.
+		/// </summary>
+		public const int MAX_METRIC_NAME_LENGTH = 47;
+		private const int MAX_METRICS = 128;
+		private static bool enabled;
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		private struct MetricSnapshot {
+			public fixed char Name[MAX_METRIC_NAME_LENGTH + 1];
+			public NativeMetricType Type;
+			public ulong Count;
+			public long Sum;
+			public fixed ulong Buckets[NativeMetric.NUM_HISTOGRAM_BUCKETS];
+		}
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Metrics_Register")]
+		private static extern InteropBool Metrics_Register(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string name,
+			NativeMetricType type,
+			IntPtr outMetricID // uint*
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Metrics_SetEnabled")]
+		private static extern InteropBool Metrics_SetEnabled(
+			IntPtr failReason,
+			InteropBool enabled
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Metrics_Record")]
+		private static extern InteropBool Metrics_Record(
+			IntPtr failReason,
+			uint metricID,
+			long value
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Metrics_Snapshot")]
+		private static extern InteropBool Metrics_Snapshot(
+			IntPtr failReason,
+			IntPtr outSnapshotArr, // MetricSnapshot*
+			uint arrLen,
+			InteropBool resetAfterwards,
+			IntPtr outNumMetrics // uint*
+			);
+
+		/// <summary>
+		/// Whether metrics are currently being collected. Off by default.
+		/// </summary>
+		public static bool Enabled {
+			get {
+				return enabled;
+			}
+			set {
+				InteropUtils.CallNative(Metrics_SetEnabled, (InteropBool) value).ThrowOnFailure();
+				enabled = value;
+			}
+		}
+
+		/// <summary>
+		/// Registers a metric, or returns the ID of the existing one if a metric of the same name and type has already been registered.
+		/// </summary>
+		/// <param name="name">The metric name, at most <see cref="MAX_METRIC_NAME_LENGTH"/> characters. Prefix it with the module name, e.g. "Entities.ActiveCount".</param>
+		/// <param name="type">The kind of metric.</param>
+		/// <returns>The ID to pass to <see cref="Record"/>.</returns>
+		public static uint Register(string name, NativeMetricType type) {
+			Assure.NotNull(name);
+			Assure.LessThanOrEqualTo(name.Length, MAX_METRIC_NAME_LENGTH, "Metric name is too long.");
+			uint result;
+			InteropUtils.CallNative(Metrics_Register, name, type, (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Adds <paramref name="value"/> to a counter, sets a gauge to it, or counts it in a histogram, depending on the metric's type.
+		/// Does nothing (and does not call in to native code) while <see cref="Enabled"/> is false.
+		/// </summary>
+		/// <param name="metricID">The ID returned by <see cref="Register"/>.</param>
+		/// <param name="value">The value to record.</param>
+		public static void Record(uint metricID, long value) {
+			if (!enabled) return;
+			InteropUtils.CallNative(Metrics_Record, metricID, value).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Returns the current value of every registered metric.
+		/// </summary>
+		/// <param name="resetAfterwards">If true, counters and histograms start again from zero for the next snapshot; use this
+		/// once per frame to get per-frame values.</param>
+		/// <returns>One <see cref="NativeMetric"/> per registered metric, in registration order.</returns>
+		public static NativeMetric[] Snapshot(bool resetAfterwards = false) {
+			MetricSnapshot* snapshotArr = stackalloc MetricSnapshot[MAX_METRICS];
+			uint numMetrics;
+			InteropUtils.CallNative(
+				Metrics_Snapshot,
+				(IntPtr) snapshotArr,
+				(uint) MAX_METRICS,
+				(InteropBool) resetAfterwards,
+				(IntPtr) (&numMetrics)
+			).ThrowOnFailure();
+
+			NativeMetric[] result = new NativeMetric[Math.Min(numMetrics, (uint) MAX_METRICS)];
+			for (int i = 0; i < result.Length; ++i) {
+				MetricSnapshot* snapshot = snapshotArr + i;
+				ulong[] buckets = new ulong[NativeMetric.NUM_HISTOGRAM_BUCKETS];
+				for (int b = 0; b < buckets.Length; ++b) buckets[b] = snapshot->Buckets[b];
+				result[i] = new NativeMetric(new string(snapshot->Name), snapshot->Type, snapshot->Count, snapshot->Sum, buckets);
+			}
+			return result;
+		}
+	}
+}
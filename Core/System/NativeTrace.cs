@@ -0,0 +1,122 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 22:02 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap {
+	/// <summary>
+	/// Exposes the native trace recorder in CoreNative, which records begin/end events from both native code and managed code on one
+	/// clock, and writes them out as a Chrome trace (open the file at chrome://tracing). The native modules already trace their
+	/// expensive operations (flushing render commands, physics ticks, concave hull creation, texture loading), and the pipeline traces
+	/// every module's <see cref="ILosgapModule.PipelineIterate"/>.
+	/// Tracing is off until <see cref="Enabled"/> is set.
+	/// </summary>
+	public static class NativeTrace {
+		private const string NATIVE_DLL_NAME = "CoreNative.dll";
+		private static bool enabled;
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Trace_SetEnabled")]
+		private static extern InteropBool Trace_SetEnabled(
+			IntPtr failReason,
+			InteropBool enabled
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Trace_RegisterName")]
+		private static extern InteropBool Trace_RegisterName(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string name,
+			IntPtr outInternedName // const char**
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Trace_Begin")]
+		private static extern InteropErrorCode Trace_Begin(
+			IntPtr internedName
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Trace_End")]
+		private static extern InteropErrorCode Trace_End(
+			IntPtr internedName
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Trace_Clear")]
+		private static extern InteropBool Trace_Clear(
+			IntPtr failReason
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "Trace_WriteChromeTrace")]
+		private static extern InteropBool Trace_WriteChromeTrace(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string filePath
+			);
+
+		/// <summary>
+		/// Whether trace events are currently being recorded. Off by default.
+		/// </summary>
+		public static bool Enabled {
+			get {
+				return enabled;
+			}
+			set {
+				InteropUtils.CallNative(Trace_SetEnabled, (InteropBool) value).ThrowOnFailure();
+				enabled = value;
+			}
+		}
+
+		/// <summary>
+		/// Copies the given event name in to native memory, once, and returns a handle to pass to <see cref="Begin"/> and <see cref="End"/>.
+		/// Registering the same name again returns the same handle.
+		/// </summary>
+		/// <param name="name">The event name, as it should appear in the trace.</param>
+		/// <returns>A handle that stays valid for the lifetime of the process.</returns>
+		public static unsafe IntPtr RegisterName(string name) {
+			Assure.NotNull(name);
+			IntPtr result;
+			InteropUtils.CallNative(Trace_RegisterName, name, (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Records the start of an event on the calling thread. Does nothing (and does not call in to native code) while
+		/// <see cref="Enabled"/> is false.
+		/// </summary>
+		/// <param name="nameHandle">A handle returned by <see cref="RegisterName"/>.</param>
+		public static void Begin(IntPtr nameHandle) {
+			if (enabled) Trace_Begin(nameHandle).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Records the end of an event on the calling thread. Does nothing (and does not call in to native code) while
+		/// <see cref="Enabled"/> is false.
+		/// </summary>
+		/// <param name="nameHandle">The handle that was passed to the matching <see cref="Begin"/>.</param>
+		public static void End(IntPtr nameHandle) {
+			if (enabled) Trace_End(nameHandle).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Discards every event recorded so far. Other threads may keep recording meanwhile (their later events are kept).
+		/// </summary>
+		public static void Clear() {
+			InteropUtils.CallNative(Trace_Clear).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Writes the most recent events from every thread to <paramref name="filePath"/> in Chrome's trace_event JSON format.
+		/// Events that other threads overwrite while they're being written out are skipped, so disable tracing first for a complete capture.
+		/// </summary>
+		/// <param name="filePath">The file to write. Overwritten if it exists.</param>
+		public static void WriteChromeTrace(string filePath) {
+			Assure.NotNull(filePath);
+			InteropUtils.CallNative(Trace_WriteChromeTrace, filePath).ThrowOnFailure();
+		}
+	}
+}
@@ -17,6 +17,8 @@ namespace Ophidian.Losgap {
 		internal readonly ParallelizationProvider ParallelizationProvider;
 		private readonly ILosgapModule[] modules;
 		private readonly long[] lastTickTimes;
+		private readonly uint?[] moduleTickTimeMetrics;
+		private readonly IntPtr[] moduleTraceNames;
 		private readonly Stopwatch pipelineTimer = Stopwatch.StartNew();
 #if DEBUG
 		private const double FRAME_TIMEOUT_MS = 4000d;
@@ -32,6 +34,8 @@ namespace Ophidian.Losgap {
 
 			this.modules = modules;
 			lastTickTimes = new long[modules.Length];
+			moduleTickTimeMetrics = new uint?[modules.Length];
+			moduleTraceNames = new IntPtr[modules.Length];
 
 			ParallelizationProvider = new ParallelizationProvider();
 
@@ -70,48 +74,61 @@ namespace Ophidian.Losgap {
 			isDisposed = true;
 		}
 
-		//private static readonly Dictionary<ILosgapModule, int> frameCounts = new Dictionary<ILosgapModule, int>();
-		//private static readonly Dictionary<ILosgapModule, double> cumulativeTickTimes = new Dictionary<ILosgapModule, double>();
-		//private static Stopwatch timer = Stopwatch.StartNew();
-
 		public void Start() {
-			while (!isDisposed) {
+			// The slaves are already one thread per core (less whatever MaxThreadCount holds back), so native workers only get the cores
+			// the slaves don't occupy; the master (or whichever thread waits on native work) always helps out too
+			int numSlaves = (int) ParallelizationProvider.NumThreads - 1;
+			NativeJobSystem.Start((uint) Math.Max(Environment.ProcessorCount - numSlaves, 1));
+			try {
+				while (!isDisposed) {
 #if DEBUG
-				frameTimer.Start();
+					frameTimer.Start();
 #endif
-				for (int i = 0; i < modules.Length; ++i) {
+					for (int i = 0; i < modules.Length; ++i) {
 #if DEBUG
-					frameTimeoutCulprit = modules[i];
+						frameTimeoutCulprit = modules[i];
 #endif
-					long elapsedMs = pipelineTimer.ElapsedMilliseconds;
-					long tickDeltaMs = elapsedMs - lastTickTimes[i];
-					if (tickDeltaMs > modules[i].TickIntervalMs) {
-						//if (!frameCounts.ContainsKey(modules[i])) {
-						//	frameCounts.Add(modules[i], 0);
-						//	cumulativeTickTimes.Add(modules[i], 0f);
-						//}
-						//var timeBefore = timer.Elapsed;
-						modules[i].PipelineIterate(ParallelizationProvider, tickDeltaMs);
-						lastTickTimes[i] = elapsedMs;
-						//var iterateTime = (timer.Elapsed - timeBefore).TotalSeconds;
-						//cumulativeTickTimes[modules[i]] += iterateTime;
-						//if (++frameCounts[modules[i]] == 1000) {
-						//	Logger.Log("TIMER: " + modules[i].GetType().Name + ": " + (cumulativeTickTimes[modules[i]] / 1000d) + "s avg");
-
-						//	frameCounts[modules[i]] = 0;
-						//	cumulativeTickTimes[modules[i]] = 0;
-						//}
+						long elapsedMs = pipelineTimer.ElapsedMilliseconds;
+						long tickDeltaMs = elapsedMs - lastTickTimes[i];
+						if (tickDeltaMs > modules[i].TickIntervalMs) {
+							if (NativeMetrics.Enabled || NativeTrace.Enabled) IterateModuleInstrumented(i, tickDeltaMs);
+							else modules[i].PipelineIterate(ParallelizationProvider, tickDeltaMs);
+							lastTickTimes[i] = elapsedMs;
+						}
 					}
-				}
 
 #if DEBUG
-				frameTimer.Stop();
+					frameTimer.Stop();
 #endif
 
-				ParallelizationProvider.MasterHydratePMIQueue();
+					ParallelizationProvider.MasterHydratePMIQueue();
+				}
+
+				ParallelizationProvider.WaitForSlavesToExit();
+			}
+			finally {
+				NativeJobSystem.Stop();
+			}
+		}
+
+		private void IterateModuleInstrumented(int moduleIndex, long tickDeltaMs) {
+			string moduleName = modules[moduleIndex].GetType().Name;
+			if (moduleTraceNames[moduleIndex] == IntPtr.Zero) moduleTraceNames[moduleIndex] = NativeTrace.RegisterName(moduleName + ".PipelineIterate");
+			if (moduleTickTimeMetrics[moduleIndex] == null) {
+				string metricName = "Pipeline." + moduleName + "TickUs";
+				if (metricName.Length > NativeMetrics.MAX_METRIC_NAME_LENGTH) metricName = metricName.Substring(0, NativeMetrics.MAX_METRIC_NAME_LENGTH);
+				moduleTickTimeMetrics[moduleIndex] = NativeMetrics.Register(metricName, NativeMetricType.Histogram);
 			}
 
-			ParallelizationProvider.WaitForSlavesToExit();
+			long ticksBefore = pipelineTimer.ElapsedTicks;
+			NativeTrace.Begin(moduleTraceNames[moduleIndex]);
+			try {
+				modules[moduleIndex].PipelineIterate(ParallelizationProvider, tickDeltaMs);
+			}
+			finally {
+				NativeTrace.End(moduleTraceNames[moduleIndex]);
+			}
+			NativeMetrics.Record(moduleTickTimeMetrics[moduleIndex].Value, (pipelineTimer.ElapsedTicks - ticksBefore) * 1000000L / Stopwatch.Frequency);
 		}
 
 #if DEBUG
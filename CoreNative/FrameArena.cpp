@@ -0,0 +1,166 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "FrameArena.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <malloc.h>
+#include <mutex>
+
+namespace losgap {
+	/*
+	Owns every thread's arena, so that arenas belonging to threads that never released them are still freed when the DLL unloads.
+	*/
+	class ThreadArenaRegistry {
+	private:
+		std::mutex registryLock;
+		std::vector<FrameArena*> arenas;
+
+	public:
+		ThreadArenaRegistry() { }
+		~ThreadArenaRegistry() {
+			for (FrameArena* arena : arenas) delete arena;
+		}
+		DISALLOW_COPY_ASSIGN_MOVE(ThreadArenaRegistry);
+
+		void Add(FrameArena* arena) {
+			std::lock_guard<std::mutex> lock { registryLock };
+			arenas.push_back(arena);
+		}
+		void Remove(FrameArena* arena) {
+			std::lock_guard<std::mutex> lock { registryLock };
+			arenas.erase(std::remove(arenas.begin(), arenas.end(), arena), arenas.end());
+		}
+	};
+
+	ThreadArenaRegistry threadArenaRegistry;
+	const MetricID METRIC_ARENA_BLOCK_ALLOCATIONS = Metrics::Register("Core.FrameArenaBlockAllocations", MetricCounter);
+	// Also set by the managed FrameArena.Reset() when it resets without calling in here
+	const MetricID METRIC_ARENA_HIGH_WATER_MARK = Metrics::Register("Core.FrameArenaHighWaterMark", MetricGauge);
+	__declspec(thread) FrameArena* threadArena = nullptr;
+
+	uint64_t AlignUp(uint64_t offset) {
+		return (offset + FrameArena::ALIGNMENT - 1U) & ~(FrameArena::ALIGNMENT - 1U);
+	}
+
+	FrameArena::FrameArena(uint64_t initialCapacity) : state(), retiredBlocks() {
+		state.GuardBytes = GUARD_BYTES;
+		StartNewBlock(initialCapacity);
+	}
+
+	FrameArena::~FrameArena() {
+		for (const RetiredBlock& block : retiredBlocks) _aligned_free(block.Base);
+		_aligned_free(state.Base);
+	}
+
+	FrameArena* FrameArena::GetThreadArena() {
+		if (threadArena == nullptr) {
+			threadArena = new FrameArena { DEFAULT_CAPACITY };
+			threadArenaRegistry.Add(threadArena);
+		}
+		return threadArena;
+	}
+	EXPORT(FrameArena_GetThreadArena, FrameArena** outArena, FrameArenaState** outState) {
+		*outArena = FrameArena::GetThreadArena();
+		*outState = (*outArena)->GetState();
+		EXPORT_END;
+	}
+
+	void FrameArena::ReleaseThreadArena() {
+		if (threadArena == nullptr) return;
+		threadArenaRegistry.Remove(threadArena);
+		delete threadArena;
+		threadArena = nullptr;
+	}
+	EXPORT(FrameArena_ReleaseThreadArena) {
+		FrameArena::ReleaseThreadArena();
+		EXPORT_END;
+	}
+
+	void FrameArena::StartNewBlock(uint64_t minCapacity) {
+		uint64_t capacity = state.Capacity == 0U ? DEFAULT_CAPACITY : state.Capacity * 2U;
+		while (capacity < minCapacity) capacity *= 2U;
+
+		uint8_t* newBase = static_cast<uint8_t*>(_aligned_malloc(static_cast<size_t>(capacity), static_cast<size_t>(ALIGNMENT)));
+		if (newBase == nullptr) throw LosgapException { "Could not allocate " + std::to_string(capacity) + " bytes for frame arena." };
+		Metrics::Increment(METRIC_ARENA_BLOCK_ALLOCATIONS);
+
+		if (state.Base != nullptr) {
+			RetiredBlock retiredBlock = { state.Base, state.Offset };
+			retiredBlocks.push_back(retiredBlock);
+			state.RetiredBytes += state.Offset;
+		}
+		state.Base = newBase;
+		state.Capacity = capacity;
+		state.Offset = 0U;
+	}
+
+	void* FrameArena::Allocate(uint32_t numBytes) {
+		uint64_t allocationStart = AlignUp(state.Offset);
+		uint64_t dataStart = state.GuardBytes > 0U ? allocationStart + ALIGNMENT : allocationStart;
+		uint64_t allocationEnd = dataStart + numBytes + state.GuardBytes;
+		if (allocationEnd > state.Capacity) {
+			StartNewBlock(ALIGNMENT + numBytes + state.GuardBytes);
+			return Allocate(numBytes);
+		}
+
+		uint8_t* result = state.Base + dataStart;
+		if (state.GuardBytes > 0U) {
+			*reinterpret_cast<uint64_t*>(state.Base + allocationStart) = numBytes;
+			memset(result + numBytes, GUARD_PATTERN, state.GuardBytes);
+		}
+		state.Offset = allocationEnd;
+		if (state.RetiredBytes + allocationEnd > state.HighWaterMark) state.HighWaterMark = state.RetiredBytes + allocationEnd;
+		return result;
+	}
+	EXPORT(FrameArena_Allocate, FrameArena* arena, uint32_t numBytes, void** outAllocation) {
+		*outAllocation = arena->Allocate(numBytes);
+		EXPORT_END;
+	}
+
+	bool FrameArena::CheckGuards(const uint8_t* blockBase, uint64_t numBytesUsed) const {
+		uint64_t allocationStart = 0U;
+		while (allocationStart < numBytesUsed) {
+			uint64_t numBytes = *reinterpret_cast<const uint64_t*>(blockBase + allocationStart);
+			const uint8_t* guard = blockBase + allocationStart + ALIGNMENT + numBytes;
+			for (uint32_t i = 0U; i < state.GuardBytes; ++i) {
+				if (guard[i] != GUARD_PATTERN) return false;
+			}
+			allocationStart = AlignUp(allocationStart + ALIGNMENT + numBytes + state.GuardBytes);
+		}
+		return true;
+	}
+
+	void FrameArena::Reset() {
+		bool guardsIntact = true;
+		if (state.GuardBytes > 0U) {
+			for (const RetiredBlock& block : retiredBlocks) guardsIntact &= CheckGuards(block.Base, block.NumBytesUsed);
+			guardsIntact &= CheckGuards(state.Base, state.Offset);
+		}
+
+		if (!retiredBlocks.empty()) {
+			for (const RetiredBlock& block : retiredBlocks) _aligned_free(block.Base);
+			retiredBlocks.clear();
+			uint8_t* oldBase = state.Base;
+			state.Base = nullptr;
+			StartNewBlock(state.HighWaterMark);
+			_aligned_free(oldBase);
+		}
+		state.Offset = 0U;
+		state.RetiredBytes = 0U;
+		Metrics::SetGauge(METRIC_ARENA_HIGH_WATER_MARK, static_cast<int64_t>(state.HighWaterMark));
+
+		if (!guardsIntact) throw LosgapException { "Frame arena guard bytes were overwritten: an allocation was overrun this frame." };
+	}
+	EXPORT(FrameArena_Reset, FrameArena* arena) {
+		arena->Reset();
+		EXPORT_END;
+	}
+
+	EXPORT(FrameArena_GetHighWaterMark, FrameArena* arena, uint64_t* outHighWaterMark) {
+		*outHighWaterMark = arena->GetHighWaterMark();
+		EXPORT_END;
+	}
+}
@@ -0,0 +1,71 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include "LosgapException.h"
+#include <cstdint>
+#include <vector>
+
+namespace losgap {
+	/*
+	The part of a FrameArena that managed code reads and writes directly. Allocations that fit in the current block are made by
+	bumping Offset, on either side of the interop boundary, so this layout must match FrameArena.cs.
+	*/
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct FrameArenaState {
+		uint8_t* Base;
+		uint64_t Capacity;
+		uint64_t Offset;
+		uint64_t RetiredBytes;
+		uint64_t HighWaterMark;
+		uint32_t GuardBytes;
+	};
+#pragma pack(pop)
+
+	/*
+	A per-thread linear allocator for scratch memory that only needs to live until the end of the frame (e.g. render command arguments).
+	Every allocation is 16-byte aligned. Reset() frees everything at once; when a frame overflowed the block, the overflow blocks are kept
+	alive until then (so earlier pointers stay valid) and the block is regrown to the high-water mark so the next frame fits.
+	In DEBUG builds every allocation is followed by guard bytes, which are checked on Reset().
+	*/
+	class __declspec(dllexport) FrameArena {
+	public:
+		static const uint64_t ALIGNMENT = 16U;
+		static const uint64_t DEFAULT_CAPACITY = 64U * 1024U;
+		static const uint8_t GUARD_PATTERN = 0xFDU;
+#ifdef DEBUG
+		static const uint32_t GUARD_BYTES = 16U;
+#else
+		static const uint32_t GUARD_BYTES = 0U;
+#endif
+
+	private:
+		struct RetiredBlock {
+			uint8_t* Base;
+			uint64_t NumBytesUsed;
+		};
+
+		FrameArenaState state;
+		std::vector<RetiredBlock> retiredBlocks;
+
+		void StartNewBlock(uint64_t minCapacity);
+		bool CheckGuards(const uint8_t* blockBase, uint64_t numBytesUsed) const;
+
+	public:
+		explicit FrameArena(uint64_t initialCapacity);
+		~FrameArena();
+		DISALLOW_COPY_ASSIGN_MOVE(FrameArena);
+
+		static FrameArena* GetThreadArena();
+		static void ReleaseThreadArena();
+
+		void* Allocate(uint32_t numBytes);
+		void Reset();
+
+		FrameArenaState* GetState() { return &state; }
+		uint64_t GetHighWaterMark() const { return state.HighWaterMark; }
+	};
+}
@@ -0,0 +1,34 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "InteropError.h"
+
+namespace losgap {
+	__declspec(thread) char16_t lastInteropErrorMessage[MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
+
+	void InteropError::SetLastMessage(const LosgapString& message) {
+		message.CopyTo(lastInteropErrorMessage, MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1);
+	}
+
+	void InteropError::SetLastMessage(const char* message) {
+		// Widened by hand rather than through LosgapString to avoid allocating. Messages from std::exception::what() are
+		// ASCII in practice; anything else is replaced rather than decoded.
+		size_t i = 0U;
+		if (message != nullptr) {
+			for (; i < MAX_INTEROP_FAIL_REASON_STRING_LENGTH && message[i] != '\0'; ++i) {
+				unsigned char c = static_cast<unsigned char>(message[i]);
+				lastInteropErrorMessage[i] = c < 0x80U ? static_cast<char16_t>(c) : u'?';
+			}
+		}
+		lastInteropErrorMessage[i] = u'\0';
+	}
+
+	const char16_t* InteropError::GetLastMessage() {
+		return lastInteropErrorMessage;
+	}
+}
+
+extern "C" __declspec(dllexport) const char16_t* InteropError_GetLastMessage() {
+	return losgap::InteropError::GetLastMessage();
+}
@@ -0,0 +1,21 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include "LosgapString.h"
+
+namespace losgap {
+	/*
+	Holds the failure message for the last EXPORT_FAST call that failed on each thread. The buffer is thread-local and fixed-size,
+	so recording a failure never allocates, and managed code only fetches the message (via InteropError_GetLastMessage) on failure.
+	*/
+	class __declspec(dllexport) InteropError {
+	public:
+		static void SetLastMessage(const LosgapString& message);
+		static void SetLastMessage(const char* message);
+		static const char16_t* GetLastMessage();
+	};
+}
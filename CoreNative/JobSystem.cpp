@@ -0,0 +1,308 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "JobSystem.h"
+#include "Metrics.h"
+#include "Platform.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace losgap {
+	const uint32_t IDLE_SPINS_BEFORE_SLEEP = 64U;
+	const MetricID METRIC_JOBS_RUN = Metrics::Register("Core.JobsRun", MetricCounter);
+	const MetricID METRIC_JOBS_STOLEN = Metrics::Register("Core.JobsStolen", MetricCounter);
+
+	/*
+	A fixed-capacity Chase-Lev deque. Only the owning worker may Push or Pop (at the bottom); any thread may Steal (from the top).
+	*/
+	class WorkStealingDeque {
+	private:
+		static const int64_t CAPACITY = 4096;
+		static const int64_t INDEX_MASK = CAPACITY - 1;
+		Job jobs[CAPACITY];
+		std::atomic<int64_t> top;
+		std::atomic<int64_t> bottom;
+
+	public:
+		WorkStealingDeque() : top(0), bottom(0) { }
+		DISALLOW_COPY_ASSIGN_MOVE(WorkStealingDeque);
+
+		bool Push(const Job& job) {
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= CAPACITY) return false;
+			jobs[b & INDEX_MASK] = job;
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		bool Pop(Job& outJob) {
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			if (t > b) {
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			outJob = jobs[b & INDEX_MASK];
+			if (t != b) return true;
+
+			// Last job in the deque: race any thieves for it
+			bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return won;
+		}
+
+		bool Steal(Job& outJob) {
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b) return false;
+
+			outJob = jobs[t & INDEX_MASK];
+			return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+	};
+
+	std::atomic<bool> jobSystemRunning { false };
+	std::vector<std::thread> workerThreads;
+	std::vector<WorkStealingDeque*> workerDeques;
+
+	std::mutex injectionQueueLock;
+	std::deque<Job> injectionQueue;
+	std::atomic<int32_t> injectionQueueSize { 0 };
+
+	std::mutex sleepLock;
+	std::condition_variable wakeCondition;
+	std::atomic<int32_t> numQueuedJobs { 0 };
+	std::atomic<int32_t> numSleepingThreads { 0 };
+
+	__declspec(thread) int32_t currentWorkerIndex = -1;
+	__declspec(thread) uint32_t stealSeed = 0U;
+
+	void WakeWorkers(int32_t numNewJobs) {
+		numQueuedJobs.fetch_add(numNewJobs);
+		if (numSleepingThreads.load() > 0) {
+			std::lock_guard<std::mutex> lock { sleepLock };
+			wakeCondition.notify_all();
+		}
+	}
+
+	bool TryTakeJob(Job& outJob) {
+		if (currentWorkerIndex >= 0 && workerDeques[currentWorkerIndex]->Pop(outJob)) {
+			numQueuedJobs.fetch_sub(1);
+			return true;
+		}
+
+		if (injectionQueueSize.load(std::memory_order_acquire) > 0) {
+			std::lock_guard<std::mutex> lock { injectionQueueLock };
+			if (!injectionQueue.empty()) {
+				outJob = injectionQueue.front();
+				injectionQueue.pop_front();
+				injectionQueueSize.fetch_sub(1, std::memory_order_release);
+				numQueuedJobs.fetch_sub(1);
+				return true;
+			}
+		}
+
+		uint32_t numDeques = static_cast<uint32_t>(workerDeques.size());
+		if (numDeques == 0U) return false;
+		if (stealSeed == 0U) stealSeed = Platform::GetCurrentThreadID() | 1U;
+		// xorshift, so that thieves don't all hammer the same victim
+		stealSeed ^= stealSeed << 13;
+		stealSeed ^= stealSeed >> 17;
+		stealSeed ^= stealSeed << 5;
+		uint32_t firstVictim = stealSeed % numDeques;
+		for (uint32_t i = 0U; i < numDeques; ++i) {
+			uint32_t victim = (firstVictim + i) % numDeques;
+			if (static_cast<int32_t>(victim) == currentWorkerIndex) continue;
+			if (workerDeques[victim]->Steal(outJob)) {
+				numQueuedJobs.fetch_sub(1);
+				Metrics::Increment(METRIC_JOBS_STOLEN);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void WorkerMain(uint32_t workerIndex) {
+		currentWorkerIndex = static_cast<int32_t>(workerIndex);
+		stealSeed = workerIndex * 2654435761U + 1U;
+
+		Job job;
+		uint32_t idleSpins = 0U;
+		while (jobSystemRunning.load(std::memory_order_acquire)) {
+			if (TryTakeJob(job)) {
+				JobSystem::RunJob(job);
+				idleSpins = 0U;
+				continue;
+			}
+			if (++idleSpins < IDLE_SPINS_BEFORE_SLEEP) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock { sleepLock };
+			numSleepingThreads.fetch_add(1);
+			wakeCondition.wait(lock, [] { return numQueuedJobs.load() > 0 || !jobSystemRunning.load(); });
+			numSleepingThreads.fetch_sub(1);
+			idleSpins = 0U;
+		}
+
+		currentWorkerIndex = -1;
+	}
+
+	void JobSystem::RunJob(const Job& job) {
+		Metrics::Increment(METRIC_JOBS_RUN);
+		try {
+			job.Func(job.Data, job.Index);
+		}
+		catch (...) {
+			job.Counter->CaptureException(std::current_exception());
+		}
+		// Must be the last access to the job: the waiter may destroy the counter as soon as it hits zero
+		if (job.Counter->Decrement()) {
+			// Taking the lock means a waiter can't miss this between checking the counter and going to sleep
+			std::lock_guard<std::mutex> lock { sleepLock };
+			if (numSleepingThreads.load() > 0) wakeCondition.notify_all();
+		}
+	}
+
+	void JobSystem::Init(uint32_t numWorkers, const uint64_t* affinityMaskArr) {
+		if (IsRunning()) throw LosgapException { "Job system is already running." };
+
+		for (uint32_t i = 0U; i < numWorkers; ++i) workerDeques.push_back(new WorkStealingDeque { });
+		jobSystemRunning.store(true, std::memory_order_release);
+		for (uint32_t i = 0U; i < numWorkers; ++i) {
+			workerThreads.emplace_back(WorkerMain, i);
+			if (affinityMaskArr != nullptr && affinityMaskArr[i] != 0ULL) {
+				if (!Platform::SetThreadAffinity(workerThreads[i], affinityMaskArr[i])) {
+					Shutdown();
+					throw LosgapException { "Could not set affinity mask for job worker " + std::to_string(i) + "." };
+				}
+			}
+		}
+	}
+	EXPORT(JobSystem_Init, uint32_t numWorkers, const uint64_t* affinityMaskArr) {
+		JobSystem::Init(numWorkers, affinityMaskArr);
+		EXPORT_END;
+	}
+
+	void JobSystem::Shutdown() {
+		if (!IsRunning()) return;
+
+		{
+			std::lock_guard<std::mutex> lock { sleepLock };
+			jobSystemRunning.store(false, std::memory_order_release);
+			wakeCondition.notify_all();
+		}
+		for (std::thread& worker : workerThreads) worker.join();
+		workerThreads.clear();
+
+		// Anything still queued belongs to someone who is (or will be) waiting on it, so finish it here
+		Job job;
+		while (TryTakeJob(job)) RunJob(job);
+
+		for (WorkStealingDeque* deque : workerDeques) delete deque;
+		workerDeques.clear();
+	}
+	EXPORT(JobSystem_Shutdown) {
+		JobSystem::Shutdown();
+		EXPORT_END;
+	}
+
+	bool JobSystem::IsRunning() {
+		return jobSystemRunning.load(std::memory_order_acquire);
+	}
+
+	uint32_t JobSystem::GetWorkerCount() {
+		return static_cast<uint32_t>(workerThreads.size());
+	}
+	EXPORT(JobSystem_GetWorkerCount, uint32_t* outNumWorkers) {
+		*outNumWorkers = JobSystem::GetWorkerCount();
+		EXPORT_END;
+	}
+
+	void JobSystem::Submit(const Job* jobArr, uint32_t numJobs, JobCounter& counter) {
+		if (numJobs == 0U) return;
+		counter.Add(static_cast<int32_t>(numJobs));
+
+		if (!IsRunning()) {
+			for (uint32_t i = 0U; i < numJobs; ++i) {
+				Job job = jobArr[i];
+				job.Counter = &counter;
+				RunJob(job);
+			}
+			return;
+		}
+
+		int32_t numQueued = 0;
+		if (currentWorkerIndex >= 0) {
+			WorkStealingDeque* ownDeque = workerDeques[currentWorkerIndex];
+			for (uint32_t i = 0U; i < numJobs; ++i) {
+				Job job = jobArr[i];
+				job.Counter = &counter;
+				if (ownDeque->Push(job)) ++numQueued;
+				else RunJob(job);
+			}
+		}
+		else {
+			std::lock_guard<std::mutex> lock { injectionQueueLock };
+			for (uint32_t i = 0U; i < numJobs; ++i) {
+				Job job = jobArr[i];
+				job.Counter = &counter;
+				injectionQueue.push_back(job);
+			}
+			numQueued = static_cast<int32_t>(numJobs);
+			injectionQueueSize.fetch_add(numQueued, std::memory_order_release);
+		}
+
+		if (numQueued > 0) WakeWorkers(numQueued);
+	}
+
+	void JobSystem::SubmitIndexed(JobFunc func, void* jobData, uint32_t firstIndex, uint32_t numJobs, JobCounter& counter) {
+		const uint32_t SUBMISSION_BATCH_SIZE = 64U;
+		Job batch[SUBMISSION_BATCH_SIZE];
+		for (uint32_t batchStart = 0U; batchStart < numJobs; batchStart += SUBMISSION_BATCH_SIZE) {
+			uint32_t batchSize = numJobs - batchStart;
+			if (batchSize > SUBMISSION_BATCH_SIZE) batchSize = SUBMISSION_BATCH_SIZE;
+			for (uint32_t i = 0U; i < batchSize; ++i) {
+				Job job = { func, jobData, firstIndex + batchStart + i, &counter };
+				batch[i] = job;
+			}
+			Submit(batch, batchSize, counter);
+		}
+	}
+
+	void JobSystem::Wait(JobCounter& counter) {
+		Job job;
+		uint32_t idleSpins = 0U;
+		while (!counter.IsDone()) {
+			if (TryTakeJob(job)) {
+				RunJob(job);
+				idleSpins = 0U;
+				continue;
+			}
+			if (++idleSpins < IDLE_SPINS_BEFORE_SLEEP) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Woken either by the last job in the group finishing or by new jobs being queued (which may be the ones being waited on)
+			std::unique_lock<std::mutex> lock { sleepLock };
+			numSleepingThreads.fetch_add(1);
+			wakeCondition.wait(lock, [&counter] { return counter.IsDone() || numQueuedJobs.load() > 0; });
+			numSleepingThreads.fetch_sub(1);
+			idleSpins = 0U;
+		}
+		counter.RethrowCapturedException();
+	}
+}
@@ -0,0 +1,139 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include "LosgapException.h"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+
+namespace losgap {
+	typedef void (*JobFunc)(void* jobData, uint32_t jobIndex);
+
+	/*
+	Counts the jobs that are still outstanding in a group. Every job decrements the counter it was submitted with when it finishes,
+	so waiting for a counter to reach zero joins the whole group, and work that depends on the group can be submitted after that.
+	The first exception thrown by any job in the group is kept and rethrown from JobSystem::Wait.
+	*/
+	class JobCounter {
+	private:
+		std::atomic<int32_t> count;
+		std::atomic_flag exceptionClaimed;
+		std::exception_ptr capturedException;
+
+	public:
+		JobCounter() : count(0) { exceptionClaimed.clear(); }
+		DISALLOW_COPY_ASSIGN_MOVE(JobCounter);
+
+		void Add(int32_t numJobs) { count.fetch_add(numJobs, std::memory_order_relaxed); }
+		bool Decrement() { return count.fetch_sub(1, std::memory_order_acq_rel) == 1; } // True for the job that finishes the group
+		bool IsDone() const { return count.load(std::memory_order_acquire) == 0; }
+
+		void CaptureException(std::exception_ptr exception) {
+			if (!exceptionClaimed.test_and_set()) capturedException = exception;
+		}
+		void RethrowCapturedException() {
+			if (!capturedException) return;
+			std::exception_ptr exception = capturedException;
+			capturedException = nullptr;
+			exceptionClaimed.clear();
+			std::rethrow_exception(exception);
+		}
+	};
+
+	/*
+	A single unit of work. Jobs are plain function pointers with an opaque argument, so submitting one never allocates.
+	*/
+	struct Job {
+		JobFunc Func;
+		void* Data;
+		uint32_t Index;
+		JobCounter* Counter;
+	};
+
+	/*
+	A static class that owns the native worker threads. Each worker has its own work-stealing deque; idle workers steal from the others,
+	and threads that aren't workers (e.g. managed threads calling in) submit to a shared queue instead. Threads that wait on a counter
+	run queued jobs while they wait, so nested fork/join is safe, and sleep (rather than spin) once there's nothing left for them to run.
+	When the system isn't running, every job is run inline on the submitting thread, so callers never need a serial fallback of their own.
+	*/
+	class __declspec(dllexport) JobSystem {
+	private:
+		template <typename TFunc>
+		struct ParallelForContext {
+			const TFunc* Func;
+			uint32_t NumIterations;
+			uint32_t BlockSize;
+
+			static void RunBlock(void* jobData, uint32_t blockIndex) {
+				const ParallelForContext* context = static_cast<const ParallelForContext*>(jobData);
+				uint32_t blockStart = blockIndex * context->BlockSize;
+				uint32_t blockEnd = blockStart + context->BlockSize;
+				if (blockEnd > context->NumIterations) blockEnd = context->NumIterations;
+				for (uint32_t i = blockStart; i < blockEnd; ++i) (*context->Func)(i);
+			}
+		};
+
+		template <typename TFunc>
+		static void InvokeFunctor(void* jobData, uint32_t) {
+			(*static_cast<const TFunc*>(jobData))();
+		}
+
+		template <typename TFunc>
+		static Job MakeFunctorJob(const TFunc& func, JobCounter& counter) {
+			Job result = { &InvokeFunctor<TFunc>, const_cast<TFunc*>(&func), 0U, &counter };
+			return result;
+		}
+
+	public:
+		static void Init(uint32_t numWorkers, const uint64_t* affinityMaskArr);
+		static void Shutdown();
+		static bool IsRunning();
+		static uint32_t GetWorkerCount();
+
+		static void Submit(const Job* jobArr, uint32_t numJobs, JobCounter& counter);
+		static void SubmitIndexed(JobFunc func, void* jobData, uint32_t firstIndex, uint32_t numJobs, JobCounter& counter);
+		static void Wait(JobCounter& counter);
+		static void RunJob(const Job& job);
+
+		/*
+		Calls func(i) for every i in [0, numIterations), in blocks of blockSize, and returns when all have finished.
+		The calling thread runs the first block itself.
+		*/
+		template <typename TFunc>
+		static void ParallelFor(uint32_t numIterations, uint32_t blockSize, const TFunc& func) {
+			if (numIterations == 0U) return;
+			if (blockSize == 0U) blockSize = 1U;
+			uint32_t numBlocks = (numIterations - 1U) / blockSize + 1U;
+
+			ParallelForContext<TFunc> context = { &func, numIterations, blockSize };
+			if (numBlocks == 1U || !IsRunning()) {
+				for (uint32_t b = 0U; b < numBlocks; ++b) ParallelForContext<TFunc>::RunBlock(&context, b);
+				return;
+			}
+
+			JobCounter counter { };
+			SubmitIndexed(&ParallelForContext<TFunc>::RunBlock, &context, 1U, numBlocks - 1U, counter);
+			counter.Add(1);
+			Job firstBlock = { &ParallelForContext<TFunc>::RunBlock, &context, 0U, &counter };
+			RunJob(firstBlock);
+			Wait(counter);
+		}
+
+		/*
+		Runs every given functor concurrently and returns when all have finished. The calling thread runs the first one itself.
+		*/
+		template <typename TFirst, typename TSecond, typename... TRest>
+		static void ForkJoin(const TFirst& first, const TSecond& second, const TRest&... rest) {
+			JobCounter counter { };
+			Job forkedJobs[] = { MakeFunctorJob(second, counter), MakeFunctorJob(rest, counter)... };
+			Submit(forkedJobs, static_cast<uint32_t>(sizeof(forkedJobs) / sizeof(Job)), counter);
+			counter.Add(1);
+			RunJob(MakeFunctorJob(first, counter));
+			Wait(counter);
+		}
+	};
+}
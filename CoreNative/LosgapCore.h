@@ -6,4 +6,7 @@
 #include "Macro.h"
 #include "LosgapString.h"
 #include "LosgapException.h"
+#include "InteropError.h"
+#include "Metrics.h"
+#include "TraceRecorder.h"
 #include "RAIICOMWrapper.h"
\ No newline at end of file
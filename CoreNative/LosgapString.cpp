@@ -2,80 +2,97 @@
 // See http://www.losgap.com/ for licensing information
 
 #include "LosgapString.h"
+#include "UTFTranscoder.h"
 
-#include <codecvt>
 #include <sstream>
+#ifdef _WIN32
 #include <winerror.h>
+#endif
 #include <cstdarg>
+#include <cstring>
 
 namespace losgap {
-	const LosgapString LosgapString::EMPTY { "" };
+#ifdef _WIN32
+	static_assert(sizeof(wchar_t) == sizeof(char16_t), "wchar_t strings are treated as UTF-16.");
+#endif
+	const size_t NULL_STRING_LENGTH = static_cast<size_t>(-1);
 
-	const char16_t* copyChar16String(const char16_t* source, size_t strlen) {
-		if (source == nullptr) return nullptr;
-		char16_t* copy = new char16_t[strlen + 1];
-		memcpy_s(copy, (strlen + 1) * sizeof(char16_t), source, (strlen + 1) * sizeof(char16_t));
-		return copy;
-	}
+	const LosgapString LosgapString::EMPTY { "" };
 
 #pragma region Ctor
-	const char16_t* CtorInit(const char16_t* stringToCopy, size_t& outLength) {
-		outLength = std::char_traits<char16_t>::length(stringToCopy);
-		return copyChar16String(stringToCopy, outLength);
+	char16_t* LosgapString::Allocate(size_t length) {
+		char16_t* storage = length <= INLINE_CAPACITY ? inlineValue : new char16_t[length + 1U];
+		storage[length] = u'\0';
+		this->value = storage;
+		this->length = length;
+		return storage;
 	}
-	const char16_t* CtorInit(const char* stringToCopy, size_t& outLength) {
-		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter { };
-		std::u16string convertedString = converter.from_bytes(stringToCopy);
 
-		return CtorInit(convertedString.c_str(), outLength);
-	}
-	const char16_t* CtorInit(const wchar_t* stringToCopy, size_t& outLength) {
-		std::wstring wideString { stringToCopy };
-		return CtorInit(std::string { wideString.begin(), wideString.end() }.c_str(), outLength);
+	void LosgapString::Init(const char16_t* value, const size_t length) {
+		if (value == nullptr) {
+			this->value = nullptr;
+			this->length = NULL_STRING_LENGTH;
+			return;
+		}
+		char16_t* storage = Allocate(length);
+		memcpy(storage, value, length * sizeof(char16_t));
 	}
-	const char16_t* CtorInit(const std::string& stringToCopy, size_t& outLength) {
-		return CtorInit(stringToCopy.c_str(), outLength);
+
+	void LosgapString::InitFromUTF8(const char* value, const size_t length) {
+		if (value == nullptr) {
+			Init(nullptr, 0U);
+			return;
+		}
+		size_t convertedLength = UTFTranscoder::MeasureUTF8AsUTF16(value, length);
+		char16_t* storage = Allocate(convertedLength);
+		UTFTranscoder::TranscodeUTF8ToUTF16(value, length, storage, convertedLength);
 	}
-	const char16_t* CtorInit(const std::wstring& stringToCopy, size_t& outLength) {
-		return CtorInit(std::string { stringToCopy.begin(), stringToCopy.end() }.c_str(), outLength);
+
+	void LosgapString::Release() {
+		if (value != inlineValue) delete[] value;
+		value = nullptr;
+		length = NULL_STRING_LENGTH;
 	}
 
-	void LosgapString::Init(const char16_t* value, const size_t length) {
-		this->value = value;
-		this->length = length;
+	void LosgapString::MoveFrom(LosgapString& other) {
+		if (other.value == nullptr || other.value == other.inlineValue) {
+			Init(other.value, other.length);
+			return;
+		}
+		value = other.value;
+		length = other.length;
+		other.value = nullptr;
+		other.length = NULL_STRING_LENGTH;
 	}
 
-	LosgapString::LosgapString(const char16_t* stringToCopy) : value(nullptr), length(-1) {
+	LosgapString::LosgapString(const char16_t* stringToCopy) : value(nullptr), length(NULL_STRING_LENGTH) {
 		if (stringToCopy == nullptr) return;
-		size_t outLength;
-		const char16_t* result = CtorInit(stringToCopy, outLength);
-		Init(result, outLength);
+		Init(stringToCopy, std::char_traits<char16_t>::length(stringToCopy));
 	}
-	LosgapString::LosgapString(const char* stringToCopy) : value(nullptr), length(-1) {
+	LosgapString::LosgapString(const char* stringToCopy) : value(nullptr), length(NULL_STRING_LENGTH) {
 		if (stringToCopy == nullptr) return;
-		size_t outLength;
-		const char16_t* result = CtorInit(stringToCopy, outLength);
-		Init(result, outLength);
+		InitFromUTF8(stringToCopy, strlen(stringToCopy));
+	}
+	LosgapString::LosgapString(const std::string& stringToCopy) : value(nullptr), length(NULL_STRING_LENGTH) {
+		InitFromUTF8(stringToCopy.c_str(), stringToCopy.length());
 	}
-	LosgapString::LosgapString(const wchar_t* stringToCopy) : value(nullptr), length(-1) {
+#ifdef _WIN32
+	LosgapString::LosgapString(const wchar_t* stringToCopy) : value(nullptr), length(NULL_STRING_LENGTH) {
 		if (stringToCopy == nullptr) return;
-		size_t outLength;
-		const char16_t* result = CtorInit(stringToCopy, outLength);
-		Init(result, outLength);
+		Init(reinterpret_cast<const char16_t*>(stringToCopy), wcslen(stringToCopy));
 	}
-	LosgapString::LosgapString(const std::string& stringToCopy) : value(nullptr), length(-1) {
-		size_t outLength;
-		const char16_t* result = CtorInit(stringToCopy, outLength);
-		Init(result, outLength);
+	LosgapString::LosgapString(const std::wstring& stringToCopy) : value(nullptr), length(NULL_STRING_LENGTH) {
+		Init(reinterpret_cast<const char16_t*>(stringToCopy.c_str()), stringToCopy.length());
 	}
-	LosgapString::LosgapString(const std::wstring& stringToCopy) : value(nullptr), length(-1) {
-		size_t outLength;
-		const char16_t* result = CtorInit(stringToCopy, outLength);
-		Init(result, outLength);
+#endif
+	LosgapString::LosgapString(const LosgapString& c) : value(nullptr), length(NULL_STRING_LENGTH) {
+		Init(c.value, c.length);
+	}
+	LosgapString::LosgapString(LosgapString&& m) : value(nullptr), length(NULL_STRING_LENGTH) {
+		MoveFrom(m);
 	}
-	LosgapString::LosgapString(const LosgapString& c) : value(AsNewChar16String(c).release()), length(c.length) { }
 	LosgapString::~LosgapString() {
-		SAFE_DELETE_ARR(value);
+		Release();
 	}
 #pragma endregion
 
@@ -83,161 +100,183 @@ namespace losgap {
 		return length;
 	}
 
-#pragma region AsNewXXX
-	std::unique_ptr<const char16_t> LosgapString::AsNewChar16String(const LosgapString& string) {
-		size_t strlen = std::char_traits<char16_t>::length(string.value);
-		return std::unique_ptr<const char16_t> { copyChar16String(string.value, strlen) };
+	const char16_t* LosgapString::GetValue() const {
+		return value;
 	}
-	std::unique_ptr<const char> LosgapString::AsNewCString(const LosgapString& string) {
-		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
-		std::string stdString = converter.to_bytes(string.value);
 
-		size_t strlen = stdString.length();
-		char* strCopy = new char[strlen + 1];
-		strcpy_s(strCopy, strlen + 1, stdString.c_str());
-
-		return std::unique_ptr<const char> { strCopy };
+	bool LosgapString::CopyAsCString(const char16_t* source, char* dest, size_t destArrayLength) {
+		if (dest == nullptr || destArrayLength == 0U) return false;
+		if (source == nullptr) {
+			dest[0] = '\0';
+			return true;
+		}
+		size_t sourceLength = std::char_traits<char16_t>::length(source);
+		size_t numBytesWritten = UTFTranscoder::TranscodeUTF16ToUTF8(source, sourceLength, dest, destArrayLength - 1U);
+		dest[numBytesWritten] = '\0';
+		return numBytesWritten == UTFTranscoder::MeasureUTF16AsUTF8(source, sourceLength);
 	}
-	std::unique_ptr<const wchar_t> LosgapString::AsNewCWString(const LosgapString& string) {
-		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
-		std::string stdString = converter.to_bytes(string.value);
-		std::wstring stdWstring { stdString.begin(), stdString.end() };
-
-		size_t strlen = stdWstring.length();
-		wchar_t* strCopy = new wchar_t[strlen + 1];
-		wcsncpy_s(strCopy, strlen + 1, stdWstring.c_str(), strlen + 1);
 
-		return std::unique_ptr<const wchar_t> { strCopy };
+#pragma region AsNewXXX
+	std::unique_ptr<const char16_t[]> LosgapString::AsNewChar16String(const LosgapString& string) {
+		if (string.value == nullptr) return std::unique_ptr<const char16_t[]> { };
+		char16_t* copy = new char16_t[string.length + 1U];
+		memcpy(copy, string.value, (string.length + 1U) * sizeof(char16_t));
+		return std::unique_ptr<const char16_t[]> { copy };
+	}
+	std::unique_ptr<const char[]> LosgapString::AsNewCString(const LosgapString& string) {
+		size_t sourceLength = string.value == nullptr ? 0U : string.length;
+		size_t convertedLength = UTFTranscoder::MeasureUTF16AsUTF8(string.value, sourceLength);
+		char* strCopy = new char[convertedLength + 1U];
+		UTFTranscoder::TranscodeUTF16ToUTF8(string.value, sourceLength, strCopy, convertedLength);
+		strCopy[convertedLength] = '\0';
+		return std::unique_ptr<const char[]> { strCopy };
 	}
 	std::string LosgapString::AsNewString(const LosgapString& string) {
-		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
-		return converter.to_bytes(string.value);
+		size_t sourceLength = string.value == nullptr ? 0U : string.length;
+		std::string result(UTFTranscoder::MeasureUTF16AsUTF8(string.value, sourceLength), '\0');
+		if (!result.empty()) UTFTranscoder::TranscodeUTF16ToUTF8(string.value, sourceLength, &result[0], result.length());
+		return result;
+	}
+#ifdef _WIN32
+	std::unique_ptr<const wchar_t[]> LosgapString::AsNewCWString(const LosgapString& string) {
+		size_t sourceLength = string.value == nullptr ? 0U : string.length;
+		wchar_t* strCopy = new wchar_t[sourceLength + 1U];
+		if (sourceLength > 0U) memcpy(strCopy, string.value, sourceLength * sizeof(wchar_t));
+		strCopy[sourceLength] = L'\0';
+		return std::unique_ptr<const wchar_t[]> { strCopy };
 	}
 	std::wstring LosgapString::AsNewWString(const LosgapString& string) {
-		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
-		std::string stdString = converter.to_bytes(string.value);
-		return std::wstring { stdString.begin(), stdString.end() };
+		if (string.value == nullptr) return std::wstring { };
+		return std::wstring { reinterpret_cast<const wchar_t*>(string.value), string.length };
 	}
+#endif
 #pragma endregion
 
 #pragma region Concat
+	LosgapString LosgapString::Join(const LosgapString* const* parts, size_t numParts) {
+		size_t totalLength = 0U;
+		for (size_t i = 0U; i < numParts; ++i) {
+			if (parts[i]->value != nullptr) totalLength += parts[i]->length;
+		}
+
+		LosgapString result { u"" };
+		char16_t* dest = result.Allocate(totalLength);
+		for (size_t i = 0U; i < numParts; ++i) {
+			if (parts[i]->value == nullptr) continue;
+			memcpy(dest, parts[i]->value, parts[i]->length * sizeof(char16_t));
+			dest += parts[i]->length;
+		}
+		return result;
+	}
+
 	LosgapString LosgapString::Concat(const LosgapString& stringA) {
 		return LosgapString { stringA };
 	}
 	LosgapString LosgapString::Concat(const LosgapString& stringA, const LosgapString& stringB) {
-		return stringA + stringB;
+		const LosgapString* parts[] = { &stringA, &stringB };
+		return Join(parts, 2U);
 	}
 	LosgapString LosgapString::Concat(const LosgapString& stringA, const LosgapString& stringB, const LosgapString& stringC) {
-		return stringA + stringB + stringC;
+		const LosgapString* parts[] = { &stringA, &stringB, &stringC };
+		return Join(parts, 3U);
 	}
 	LosgapString LosgapString::Concat(const LosgapString& stringA, const LosgapString& stringB, const LosgapString& stringC, const LosgapString& stringD) {
-		return stringA + stringB + stringC + stringD;
+		const LosgapString* parts[] = { &stringA, &stringB, &stringC, &stringD };
+		return Join(parts, 4U);
 	}
 	LosgapString LosgapString::Concat(const LosgapString& stringA, const LosgapString& stringB, const LosgapString& stringC, const LosgapString& stringD, const LosgapString& stringE) {
-		return stringA + stringB + stringC + stringD + stringE;
+		const LosgapString* parts[] = { &stringA, &stringB, &stringC, &stringD, &stringE };
+		return Join(parts, 5U);
 	}
 	LosgapString LosgapString::Concat(const LosgapString& stringA, const LosgapString& stringB, const LosgapString& stringC, const LosgapString& stringD, const LosgapString& stringE, const LosgapString& stringF) {
-		return stringA + stringB + stringC + stringD + stringE + stringF;
+		const LosgapString* parts[] = { &stringA, &stringB, &stringC, &stringD, &stringE, &stringF };
+		return Join(parts, 6U);
 	}
 #pragma endregion
 
 #pragma region CopyTo
 	void LosgapString::CopyTo(char16_t* dest, size_t destArrayLength) const {
-		if (dest == nullptr) return;
-		if (length + 1 <= destArrayLength) {
-			memcpy_s(dest, destArrayLength * sizeof(char16_t), value, (length + 1) * sizeof(char16_t));
-		}
-		else {
-			memcpy_s(dest, destArrayLength * sizeof(char16_t), value, (destArrayLength - 1) * sizeof(char16_t));
-			dest[destArrayLength - 1] = 0;
-		}
-		size_t charsToCopy = ((length + 1) < destArrayLength ? (length + 1) : destArrayLength);
-		
+		if (dest == nullptr || destArrayLength == 0U) return;
+		size_t sourceLength = value == nullptr ? 0U : length;
+		size_t charsToCopy = sourceLength < destArrayLength ? sourceLength : destArrayLength - 1U;
+		if (charsToCopy > 0U) memcpy(dest, value, charsToCopy * sizeof(char16_t));
+		dest[charsToCopy] = u'\0';
 	}
 	void LosgapString::CopyTo(char* dest, size_t destArrayLength) const {
-		if (dest == nullptr) return;
-		std::unique_ptr<const char> asNewCStr = AsNewCString(*this);
-		size_t length = strlen(asNewCStr.get());
-		if (length + 1 <= destArrayLength) {
-			memcpy_s(dest, destArrayLength * sizeof(char), asNewCStr.get(), (length + 1) * sizeof(char));
-		}
-		else {
-			memcpy_s(dest, destArrayLength * sizeof(char), asNewCStr.get(), (destArrayLength - 1) * sizeof(char));
-			dest[destArrayLength - 1] = 0;
-		}
+		if (dest == nullptr || destArrayLength == 0U) return;
+		size_t sourceLength = value == nullptr ? 0U : length;
+		size_t numBytesWritten = UTFTranscoder::TranscodeUTF16ToUTF8(value, sourceLength, dest, destArrayLength - 1U);
+		dest[numBytesWritten] = '\0';
 	}
+#ifdef _WIN32
 	void LosgapString::CopyTo(wchar_t* dest, size_t destArrayLength) const {
-		if (dest == nullptr) return;
-		std::unique_ptr<const wchar_t> asNewCWStr = AsNewCWString(*this);
-		size_t length = wcslen(asNewCWStr.get());
-		if (length + 1 <= destArrayLength) {
-			memcpy_s(dest, destArrayLength * sizeof(wchar_t), asNewCWStr.get(), (length + 1) * sizeof(wchar_t));
-		}
-		else {
-			memcpy_s(dest, destArrayLength * sizeof(wchar_t), asNewCWStr.get(), (destArrayLength - 1) * sizeof(wchar_t));
-			dest[destArrayLength - 1] = 0;
-		}
+		CopyTo(reinterpret_cast<char16_t*>(dest), destArrayLength);
 	}
+#endif
 #pragma endregion
 
 #pragma region Operators
 	LosgapString& LosgapString::operator=(const LosgapString& rhs) { 
-		SAFE_DELETE_ARR(value);
-		value = AsNewChar16String(rhs).release();
-		length = rhs.length;
+		if (this == &rhs) return *this;
+		Release();
+		Init(rhs.value, rhs.length);
+
+		return *this;
+	}
+	LosgapString& LosgapString::operator=(LosgapString&& rhs) {
+		if (this == &rhs) return *this;
+		Release();
+		MoveFrom(rhs);
 
 		return *this;
 	}
 	LosgapString LosgapString::operator+(const LosgapString& rhs) const {
-		size_t newStrlen = length + rhs.length;
-		char16_t* newString = new char16_t[newStrlen + 1];
-		memcpy_s(newString, (newStrlen + 1) * sizeof(char16_t), value, length * sizeof(char16_t));
-		memcpy_s(newString + length, (newStrlen + 1 - length) * sizeof(char16_t), rhs.value, (rhs.length + 1) * sizeof(char16_t));
-		newString[newStrlen] = '\0';
-		return { newString };
+		return Concat(*this, rhs);
 	}
 
 	std::ostream& operator<<(std::ostream& lhs, const LosgapString& rhs) {
-		lhs << rhs.AsNewCString(rhs).get();
+		lhs << LosgapString::AsNewString(rhs);
 		return lhs;
 	}
 
-	// TODO these are inefficient
 	LosgapString operator+(const char16_t* lhs, const LosgapString& rhs) {
-		return LosgapString { LosgapString { lhs } +rhs };
+		return LosgapString { lhs } + rhs;
 	}
 	LosgapString operator+(const LosgapString& lhs, const char16_t* rhs) {
-		return LosgapString { lhs + LosgapString { rhs } };
+		return lhs + LosgapString { rhs };
 	}
 	LosgapString operator+(const char* lhs, const LosgapString& rhs) {
-		return LosgapString { LosgapString { lhs } +rhs };
+		return LosgapString { lhs } + rhs;
 	}
 	LosgapString operator+(const LosgapString& lhs, const char* rhs) {
-		return LosgapString { lhs + LosgapString { rhs } };
-	}
-	LosgapString operator+(const wchar_t* lhs, const LosgapString& rhs) {
-		return LosgapString { LosgapString { lhs } +rhs };
-	}
-	LosgapString operator+(const LosgapString& lhs, const wchar_t* rhs) {
-		return LosgapString { lhs + LosgapString { rhs } };
+		return lhs + LosgapString { rhs };
 	}
 	LosgapString operator+(const std::string& lhs, const LosgapString& rhs) {
-		return LosgapString { LosgapString { lhs } +rhs };
+		return LosgapString { lhs } + rhs;
 	}
 	LosgapString operator+(const LosgapString& lhs, const std::string& rhs) {
-		return LosgapString { lhs + LosgapString { rhs } };
+		return lhs + LosgapString { rhs };
+	}
+#ifdef _WIN32
+	LosgapString operator+(const wchar_t* lhs, const LosgapString& rhs) {
+		return LosgapString { lhs } + rhs;
+	}
+	LosgapString operator+(const LosgapString& lhs, const wchar_t* rhs) {
+		return lhs + LosgapString { rhs };
 	}
 	LosgapString operator+(const std::wstring& lhs, const LosgapString& rhs) {
-		return LosgapString { LosgapString { lhs } +rhs };
+		return LosgapString { lhs } + rhs;
 	}
 	LosgapString operator+(const LosgapString& lhs, const std::wstring& rhs) {
-		return LosgapString { lhs + LosgapString { rhs } };
+		return lhs + LosgapString { rhs };
 	}
+#endif
 #pragma endregion
 }
 
 losgap::LosgapString __declspec(dllexport) losgapMacro::GetHResultDescription(uint32_t result) {
 	switch (result) {
+#ifdef _WIN32
 		case E_INVALIDARG:
 			return "The application supplied an invalid argument to an internal call. Please check that all inputs make sense and are valid at the point of the error.";
 		case DXGI_ERROR_DEVICE_HUNG:
@@ -272,6 +311,7 @@ losgap::LosgapString __declspec(dllexport) losgapMacro::GetHResultDescription(ui
 			return "The application could not get sufficient access (are you running as administrator?).";
 		case DXGI_ERROR_NAME_ALREADY_EXISTS:
 			return "The application could not instantiate or name a resource (is another copy already running?).";
+#endif
 		default:
 			std::stringstream oss;
 			oss << "Unknown error encountered: 0x" << std::hex << result;
@@ -11,33 +11,55 @@
 
 namespace losgap {
 	/* 
-	A low performance but high usability string wrapper, encompassing the five million other string types in C++.
+	A high usability string wrapper, encompassing the five million other string types in C++. Strings of up to INLINE_CAPACITY
+	characters are stored inline without touching the heap, and all UTF-8 conversion goes through UTFTranscoder.
 	*/
 	class __declspec(dllexport) LosgapString {
 	private:
+		static const size_t INLINE_CAPACITY = 23U;
+
 		const char16_t* value;
 		size_t length;
+		char16_t inlineValue[INLINE_CAPACITY + 1U];
 
+		char16_t* Allocate(size_t length);
 		void Init(const char16_t* value, const size_t length);
+		void InitFromUTF8(const char* value, const size_t length);
+		void Release();
+		void MoveFrom(LosgapString& other);
+		static LosgapString Join(const LosgapString* const* parts, size_t numParts);
 
 	public:
 		static const LosgapString EMPTY;
 
 		LosgapString(const char16_t* stringToCopy);
 		LosgapString(const char* stringToCopy);
-		LosgapString(const wchar_t* stringToCopy);
 		LosgapString(const std::string& stringToCopy);
+#ifdef _WIN32
+		// wchar_t strings are only UTF-16 (and so only supported) on Windows
+		LosgapString(const wchar_t* stringToCopy);
 		LosgapString(const std::wstring& stringToCopy);
+#endif
 		LosgapString(const LosgapString& c);
-		DECLARE_DEFAULT_DESTRUCTOR(LosgapString);
+		LosgapString(LosgapString&& m);
+		~LosgapString();
 
 		size_t GetLength() const;
+		const char16_t* GetValue() const;
+
+		/*
+		Converts a UTF-16 string (e.g. an INTEROP_STRING) straight in to a caller-owned UTF-8 buffer, without constructing a LosgapString.
+		Returns false if the result had to be truncated to fit.
+		*/
+		static bool CopyAsCString(const char16_t* source, char* dest, size_t destArrayLength);
 
-		static std::unique_ptr<const char16_t> AsNewChar16String(const LosgapString& string);
-		static std::unique_ptr<const char> AsNewCString(const LosgapString& string);
-		static std::unique_ptr<const wchar_t> AsNewCWString(const LosgapString& string);
+		static std::unique_ptr<const char16_t[]> AsNewChar16String(const LosgapString& string);
+		static std::unique_ptr<const char[]> AsNewCString(const LosgapString& string);
 		static std::string AsNewString(const LosgapString& string);
+#ifdef _WIN32
+		static std::unique_ptr<const wchar_t[]> AsNewCWString(const LosgapString& string);
 		static std::wstring AsNewWString(const LosgapString& string);
+#endif
 
 		static LosgapString Concat(const LosgapString& stringA);
 		static LosgapString Concat(const LosgapString& stringA, const LosgapString& stringB);
@@ -48,20 +70,25 @@ namespace losgap {
 
 		void CopyTo(char16_t* dest, size_t destArrayLength) const;
 		void CopyTo(char* dest, size_t destArrayLength) const;
+#ifdef _WIN32
 		void CopyTo(wchar_t* dest, size_t destArrayLength) const;
+#endif
 		
 		LosgapString& operator=(const LosgapString& rhs);
+		LosgapString& operator=(LosgapString&& rhs);
 		LosgapString operator+(const LosgapString& rhs) const;
 		friend __declspec(dllexport) LosgapString operator+(const LosgapString& lhs, const char16_t* rhs);
 		friend __declspec(dllexport) LosgapString operator+(const char16_t* lhs, const LosgapString& rhs);
 		friend __declspec(dllexport) LosgapString operator+(const LosgapString& lhs, const char* rhs);
 		friend __declspec(dllexport) LosgapString operator+(const char* lhs, const LosgapString& rhs);
-		friend __declspec(dllexport) LosgapString operator+(const LosgapString& lhs, const wchar_t* rhs);
-		friend __declspec(dllexport) LosgapString operator+(const wchar_t* lhs, const LosgapString& rhs);
 		friend __declspec(dllexport) LosgapString operator+(const LosgapString& lhs, const std::string& rhs);
 		friend __declspec(dllexport) LosgapString operator+(const std::string& lhs, const LosgapString& rhs);
+#ifdef _WIN32
+		friend __declspec(dllexport) LosgapString operator+(const LosgapString& lhs, const wchar_t* rhs);
+		friend __declspec(dllexport) LosgapString operator+(const wchar_t* lhs, const LosgapString& rhs);
 		friend __declspec(dllexport) LosgapString operator+(const LosgapString& lhs, const std::wstring& rhs);
 		friend __declspec(dllexport) LosgapString operator+(const std::wstring& lhs, const LosgapString& rhs);
+#endif
 		friend __declspec(dllexport) std::ostream& operator<<(std::ostream& lhs, const LosgapString& rhs);
 	};
 }
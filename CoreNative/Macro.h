@@ -3,6 +3,33 @@
 
 #pragma once
 
+#pragma region Portability
+// Only the render command translator and capture replay (plus the parts of CoreNative they use) are built off Windows; see
+// CMakeLists.txt. These stand in for the MSVC extensions that code relies on.
+#ifndef _WIN32
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#define __declspec(attribute) LOSGAP_DECLSPEC_##attribute
+#define LOSGAP_DECLSPEC_dllexport __attribute__((visibility("default")))
+#define LOSGAP_DECLSPEC_thread __thread
+
+inline void* _aligned_malloc(size_t size, size_t alignment) {
+	void* result = nullptr;
+	return posix_memalign(&result, alignment, size) == 0 ? result : nullptr;
+}
+inline void _aligned_free(void* ptr) { free(ptr); }
+
+template <size_t DestLength>
+inline int strcpy_s(char (&dest)[DestLength], const char* source) {
+	strncpy(dest, source, DestLength - 1U);
+	dest[DestLength - 1U] = '\0';
+	return 0;
+}
+#endif
+#pragma endregion
+
 #pragma region Alloc/Dealloc
 
 #define ALIGNED_NEW(type, alignment) new(_aligned_malloc(sizeof(type), alignment)) type
@@ -53,10 +80,19 @@ if (comObj != nullptr) {	\
 #define INTEROP_BOOL_TRUE ((INTEROP_BOOL) 255)
 #define INTEROP_BOOL_FALSE ((INTEROP_BOOL) 0)
 
+#ifdef _WIN32
 #define EXPORT(funcName, ...)																			\
 	extern "C" __declspec(dllexport) INTEROP_BOOL funcName(char16_t* const failureReason, __VA_ARGS__) {	\
 	try																										\
 
+#else
+// GCC and Clang only drop the comma before an empty __VA_ARGS__ when it is pasted
+#define EXPORT(funcName, ...)																			\
+	extern "C" __declspec(dllexport) INTEROP_BOOL funcName(char16_t* const failureReason, ##__VA_ARGS__) {	\
+	try																										\
+
+#endif
+
 #define EXPORT_END										\
 		EXPORT_OK										\
 	}													\
@@ -82,6 +118,41 @@ if (comObj != nullptr) {	\
 
 #define EXPORT_OK return INTEROP_BOOL_TRUE;
 
+// Hot-path alternative to EXPORT: no fail-reason buffer is passed in. Instead the function returns one of the error codes below,
+// and on failure the message is left in losgap::InteropError for the caller to fetch.
+#define INTEROP_ERROR_CODE uint32_t
+#define INTEROP_ERROR_NONE ((INTEROP_ERROR_CODE) 0)
+#define INTEROP_ERROR_LOSGAP_EXCEPTION ((INTEROP_ERROR_CODE) 1)
+#define INTEROP_ERROR_STD_EXCEPTION ((INTEROP_ERROR_CODE) 2)
+#define INTEROP_ERROR_UNKNOWN_EXCEPTION ((INTEROP_ERROR_CODE) 3)
+
+#define EXPORT_FAST(funcName, ...)															\
+	extern "C" __declspec(dllexport) INTEROP_ERROR_CODE funcName(__VA_ARGS__) {				\
+	try																						\
+
+#define EXPORT_FAST_END																		\
+		return INTEROP_ERROR_NONE;															\
+	}																						\
+	catch (losgap::LosgapException& e) {													\
+		losgap::InteropError::SetLastMessage(e.Message);									\
+		return INTEROP_ERROR_LOSGAP_EXCEPTION;												\
+	}																						\
+	catch (std::exception& e) {																\
+		losgap::InteropError::SetLastMessage(e.what());										\
+		return INTEROP_ERROR_STD_EXCEPTION;													\
+	}																						\
+	catch (...) {																			\
+		losgap::InteropError::SetLastMessage("Unknown exception occurred.");				\
+		return INTEROP_ERROR_UNKNOWN_EXCEPTION;												\
+	}																						\
+
+#pragma endregion
+
+#pragma region Test Exports
+// Exports that only exist for LosgapTests (test hooks and benchmarks) are only compiled in to debug builds, unless asked for explicitly
+#if defined(DEBUG) && !defined(LOSGAP_TEST_EXPORTS)
+#define LOSGAP_TEST_EXPORTS
+#endif
 #pragma endregion
 
 #pragma region WinAPI
@@ -0,0 +1,186 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "Metrics.h"
+#include "Platform.h"
+#include <cstring>
+#include <thread>
+
+namespace losgap {
+	const uint32_t MAX_METRICS_SHARDS = 64U;
+
+	/*
+	One thread's share of every counter and histogram. Only the owning thread writes to a shard (so no read-modify-write is needed),
+	except for the last shard, which is shared by any threads beyond MAX_METRICS_SHARDS - 1.
+	*/
+	struct MetricsShard {
+		std::atomic<int64_t> Sums[MAX_METRICS];
+		std::atomic<uint64_t> Counts[MAX_METRICS];
+		std::atomic<uint64_t> Buckets[MAX_METRICS][NUM_HISTOGRAM_BUCKETS];
+		bool IsShared;
+	};
+
+	// Everything below is zero-initialized and never dynamically initialized, so other modules may register metrics from their own
+	// static initializers regardless of the order in which this one's run.
+	std::atomic_flag registryLock = ATOMIC_FLAG_INIT;
+	uint32_t numMetrics;
+	char metricNames[MAX_METRICS][MAX_METRIC_NAME_LENGTH + 1U];
+	MetricType metricTypes[MAX_METRICS];
+	std::atomic<int64_t> gaugeValues[MAX_METRICS];
+	MetricsShard* shards[MAX_METRICS_SHARDS];
+	uint32_t numShards;
+	int64_t baselineSums[MAX_METRICS];
+	uint64_t baselineCounts[MAX_METRICS];
+	uint64_t baselineBuckets[MAX_METRICS][NUM_HISTOGRAM_BUCKETS];
+	__declspec(thread) MetricsShard* threadShard;
+
+	std::atomic<bool> Metrics::isEnabled;
+
+	class RegistryLockGuard {
+	public:
+		RegistryLockGuard() {
+			while (registryLock.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+		}
+		~RegistryLockGuard() {
+			registryLock.clear(std::memory_order_release);
+		}
+		DISALLOW_COPY_ASSIGN_MOVE(RegistryLockGuard);
+	};
+
+	MetricsShard* GetThreadShard() {
+		if (threadShard != nullptr) return threadShard;
+
+		RegistryLockGuard lock { };
+		if (numShards < MAX_METRICS_SHARDS) {
+			MetricsShard* newShard = new MetricsShard;
+			for (uint32_t m = 0U; m < MAX_METRICS; ++m) {
+				newShard->Sums[m].store(0, std::memory_order_relaxed);
+				newShard->Counts[m].store(0U, std::memory_order_relaxed);
+				for (uint32_t b = 0U; b < NUM_HISTOGRAM_BUCKETS; ++b) newShard->Buckets[m][b].store(0U, std::memory_order_relaxed);
+			}
+			newShard->IsShared = (numShards == MAX_METRICS_SHARDS - 1U);
+			shards[numShards++] = newShard;
+		}
+		threadShard = shards[numShards - 1U];
+		return threadShard;
+	}
+
+	template <typename T>
+	void AddToSlot(std::atomic<T>& slot, T amount, bool isShared) {
+		if (isShared) slot.fetch_add(amount, std::memory_order_relaxed);
+		else slot.store(slot.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	MetricID Metrics::Register(const char* name, MetricType type) {
+		if (name == nullptr) throw LosgapException { "Metric name must not be null." };
+		if (strlen(name) > MAX_METRIC_NAME_LENGTH) {
+			throw LosgapException { "Metric name '" + std::string(name) + "' is longer than " + std::to_string(MAX_METRIC_NAME_LENGTH) + " characters." };
+		}
+
+		RegistryLockGuard lock { };
+		for (uint32_t m = 0U; m < numMetrics; ++m) {
+			if (strcmp(metricNames[m], name) != 0) continue;
+			if (metricTypes[m] != type) throw LosgapException { "Metric '" + std::string(name) + "' is already registered with a different type." };
+			return m;
+		}
+		if (numMetrics == MAX_METRICS) throw LosgapException { "Can not register more than " + std::to_string(MAX_METRICS) + " metrics." };
+
+		strcpy_s(metricNames[numMetrics], name);
+		metricTypes[numMetrics] = type;
+		return numMetrics++;
+	}
+	EXPORT(Metrics_Register, INTEROP_STRING name, MetricType type, MetricID* outMetricID) {
+		if (name == nullptr) throw LosgapException { "Metric name must not be null." };
+		char nameAsCString[MAX_METRIC_NAME_LENGTH + 1U];
+		if (!LosgapString::CopyAsCString(name, nameAsCString, MAX_METRIC_NAME_LENGTH + 1U)) {
+			throw LosgapException { "Metric name is longer than " + std::to_string(MAX_METRIC_NAME_LENGTH) + " characters." };
+		}
+		*outMetricID = Metrics::Register(nameAsCString, type);
+		EXPORT_END;
+	}
+
+	EXPORT(Metrics_SetEnabled, INTEROP_BOOL enabled) {
+		Metrics::SetEnabled(INTEROP_BOOL_TO_CBOOL(enabled));
+		EXPORT_END;
+	}
+
+	void Metrics::AddToShard(MetricID metricID, int64_t value) {
+		MetricsShard* shard = GetThreadShard();
+		AddToSlot(shard->Sums[metricID], value, shard->IsShared);
+		AddToSlot(shard->Counts[metricID], static_cast<uint64_t>(1U), shard->IsShared);
+	}
+
+	void Metrics::AddToHistogramShard(MetricID metricID, int64_t value) {
+		uint32_t bucket = 0U;
+		for (uint64_t remainder = value > 0 ? static_cast<uint64_t>(value) : 0U; remainder > 0U && bucket < NUM_HISTOGRAM_BUCKETS - 1U; remainder >>= 1) {
+			++bucket;
+		}
+
+		MetricsShard* shard = GetThreadShard();
+		AddToSlot(shard->Sums[metricID], value, shard->IsShared);
+		AddToSlot(shard->Counts[metricID], static_cast<uint64_t>(1U), shard->IsShared);
+		AddToSlot(shard->Buckets[metricID][bucket], static_cast<uint64_t>(1U), shard->IsShared);
+	}
+
+	void Metrics::SetGauge(MetricID gaugeID, int64_t value) {
+		if (IsEnabled()) gaugeValues[gaugeID].store(value, std::memory_order_relaxed);
+	}
+	EXPORT(Metrics_Record, MetricID metricID, int64_t value) {
+		if (metricID >= numMetrics) throw LosgapException { "Invalid metric ID: " + std::to_string(metricID) + "." };
+		switch (metricTypes[metricID]) {
+			case MetricCounter: Metrics::Increment(metricID, value); break;
+			case MetricGauge: Metrics::SetGauge(metricID, value); break;
+			default: Metrics::Observe(metricID, value); break;
+		}
+		EXPORT_END;
+	}
+
+	uint32_t Metrics::Snapshot(MetricSnapshot* outSnapshotArr, uint32_t arrLen, bool resetAfterwards) {
+		RegistryLockGuard lock { };
+		for (uint32_t m = 0U; m < numMetrics; ++m) {
+			int64_t sum = 0;
+			uint64_t count = 0U;
+			uint64_t buckets[NUM_HISTOGRAM_BUCKETS] = { };
+			for (uint32_t s = 0U; s < numShards; ++s) {
+				sum += shards[s]->Sums[m].load(std::memory_order_relaxed);
+				count += shards[s]->Counts[m].load(std::memory_order_relaxed);
+				for (uint32_t b = 0U; b < NUM_HISTOGRAM_BUCKETS; ++b) buckets[b] += shards[s]->Buckets[m][b].load(std::memory_order_relaxed);
+			}
+
+			if (m < arrLen) {
+				MetricSnapshot& snapshot = outSnapshotArr[m];
+				for (uint32_t c = 0U; c <= MAX_METRIC_NAME_LENGTH; ++c) snapshot.Name[c] = static_cast<char16_t>(metricNames[m][c]);
+				snapshot.Type = metricTypes[m];
+				if (metricTypes[m] == MetricGauge) {
+					snapshot.Count = 1U;
+					snapshot.Sum = gaugeValues[m].load(std::memory_order_relaxed);
+				}
+				else {
+					snapshot.Count = count - baselineCounts[m];
+					snapshot.Sum = sum - baselineSums[m];
+				}
+				for (uint32_t b = 0U; b < NUM_HISTOGRAM_BUCKETS; ++b) snapshot.Buckets[b] = buckets[b] - baselineBuckets[m][b];
+			}
+
+			// Shards are never written by anyone but their owner, so 'resetting' just moves the baseline rather than zeroing them
+			if (resetAfterwards) {
+				baselineSums[m] = sum;
+				baselineCounts[m] = count;
+				for (uint32_t b = 0U; b < NUM_HISTOGRAM_BUCKETS; ++b) baselineBuckets[m][b] = buckets[b];
+			}
+		}
+		return numMetrics;
+	}
+	EXPORT(Metrics_Snapshot, MetricSnapshot* outSnapshotArr, uint32_t arrLen, INTEROP_BOOL resetAfterwards, uint32_t* outNumMetrics) {
+		*outNumMetrics = Metrics::Snapshot(outSnapshotArr, arrLen, INTEROP_BOOL_TO_CBOOL(resetAfterwards));
+		EXPORT_END;
+	}
+
+	ScopedMetricTimer::ScopedMetricTimer(MetricID histogramID) : histogramID(histogramID), startTicks(Metrics::IsEnabled() ? Platform::GetTicks() : 0) { }
+
+	ScopedMetricTimer::~ScopedMetricTimer() {
+		if (!Metrics::IsEnabled() || startTicks == 0) return;
+		Metrics::Observe(histogramID, (Platform::GetTicks() - startTicks) * 1000000LL / Platform::GetTicksPerSecond());
+	}
+}
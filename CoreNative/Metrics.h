@@ -0,0 +1,86 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include "LosgapException.h"
+#include <atomic>
+#include <cstdint>
+
+namespace losgap {
+	enum MetricType : uint32_t {
+		MetricCounter = 0U,
+		MetricGauge = 1U,
+		MetricHistogram = 2U
+	};
+
+	typedef uint32_t MetricID;
+
+	const uint32_t MAX_METRICS = 128U;
+	const uint32_t MAX_METRIC_NAME_LENGTH = 47U;
+	const uint32_t NUM_HISTOGRAM_BUCKETS = 16U;
+
+	/*
+	An interop struct holding the value of one metric at the time of a snapshot. For counters Sum is the total since the last reset;
+	for gauges it is the latest value. Histograms also fill Count and Buckets: bucket i holds values in [2^(i-1), 2^i), bucket 0 holds
+	values below 1 and the last bucket holds everything above.
+	*/
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct MetricSnapshot {
+		char16_t Name[MAX_METRIC_NAME_LENGTH + 1U];
+		MetricType Type;
+		uint64_t Count;
+		int64_t Sum;
+		uint64_t Buckets[NUM_HISTOGRAM_BUCKETS];
+	};
+#pragma pack(pop)
+
+	/*
+	A static registry of named counters, gauges and histograms, shared by all the native modules. Register metrics once (e.g. from a
+	namespace-scope initializer) and keep the returned ID; registering the same name twice returns the same ID.
+	Updates go to a per-thread shard with no locking, and are skipped entirely unless something has enabled collection.
+	*/
+	class __declspec(dllexport) Metrics {
+	private:
+		static std::atomic<bool> isEnabled;
+
+		static void AddToShard(MetricID metricID, int64_t value);
+		static void AddToHistogramShard(MetricID metricID, int64_t value);
+
+	public:
+		static MetricID Register(const char* name, MetricType type);
+
+		static bool IsEnabled() { return isEnabled.load(std::memory_order_relaxed); }
+		static void SetEnabled(bool enabled) { isEnabled.store(enabled, std::memory_order_relaxed); }
+
+		static void Increment(MetricID counterID, int64_t amount = 1) {
+			if (IsEnabled()) AddToShard(counterID, amount);
+		}
+		static void SetGauge(MetricID gaugeID, int64_t value);
+		static void Observe(MetricID histogramID, int64_t value) {
+			if (IsEnabled()) AddToHistogramShard(histogramID, value);
+		}
+
+		/*
+		Writes up to arrLen metrics in to outSnapshotArr and returns the number registered. If resetAfterwards is true, counters
+		and histograms restart from zero for the next snapshot (e.g. to report per-frame values).
+		*/
+		static uint32_t Snapshot(MetricSnapshot* outSnapshotArr, uint32_t arrLen, bool resetAfterwards);
+	};
+
+	/*
+	Observes the microseconds elapsed between construction and destruction in to a histogram.
+	*/
+	class __declspec(dllexport) ScopedMetricTimer {
+	private:
+		MetricID histogramID;
+		int64_t startTicks;
+
+	public:
+		explicit ScopedMetricTimer(MetricID histogramID);
+		~ScopedMetricTimer();
+		DISALLOW_COPY_ASSIGN_MOVE(ScopedMetricTimer);
+	};
+}
@@ -0,0 +1,395 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "ObjLoader.h"
+#include "InteropError.h"
+#include "TraceRecorder.h"
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <Windows.h>
+
+namespace losgap {
+	const uint32_t EMPTY_VERTEX_SLOT = 0xFFFFFFFFU;
+	const uint32_t MIN_VERTEX_TABLE_CAPACITY = 1024U; // Must be a power of two
+	const int32_t MAX_FLOAT_MANTISSA_DIGITS = 19; // As many decimal digits as always fit in a uint64_t
+
+	/*
+	Open-addressed (linear probing) map from each vertex's index tuple to its position in the vertex list. The table only stores
+	vertex indices; the tuples themselves are looked up in the list, so it stays at 4 bytes a slot. It is kept at most half full.
+	*/
+	class ObjVertexTable {
+	private:
+		std::vector<uint32_t> slots;
+		uint32_t mask;
+
+		static uint32_t Hash(const ObjVertex& vertex) {
+			uint32_t hash = vertex.PositionIndex * 0x9E3779B1U;
+			hash ^= vertex.TexCoordIndex * 0x85EBCA77U + (hash << 6) + (hash >> 2);
+			hash ^= vertex.NormalIndex * 0xC2B2AE3DU + (hash << 6) + (hash >> 2);
+			hash ^= hash >> 16;
+			hash *= 0x7FEB352DU;
+			hash ^= hash >> 15;
+			return hash;
+		}
+
+		void Rehash(uint32_t capacity, const std::vector<ObjVertex>& vertices) {
+			slots.assign(capacity, EMPTY_VERTEX_SLOT);
+			mask = capacity - 1U;
+			for (uint32_t v = 0U; v < vertices.size(); ++v) {
+				uint32_t slot = Hash(vertices[v]) & mask;
+				while (slots[slot] != EMPTY_VERTEX_SLOT) slot = (slot + 1U) & mask;
+				slots[slot] = v;
+			}
+		}
+
+	public:
+		ObjVertexTable() : slots(MIN_VERTEX_TABLE_CAPACITY, EMPTY_VERTEX_SLOT), mask(MIN_VERTEX_TABLE_CAPACITY - 1U) { }
+
+		/*
+		Returns the index of the vertex in vertices that matches the given one, adding it to the end first if there isn't one.
+		*/
+		uint32_t FindOrAdd(const ObjVertex& vertex, std::vector<ObjVertex>& vertices) {
+			uint32_t slot = Hash(vertex) & mask;
+			while (slots[slot] != EMPTY_VERTEX_SLOT) {
+				const ObjVertex& existing = vertices[slots[slot]];
+				if (existing.PositionIndex == vertex.PositionIndex
+					&& existing.TexCoordIndex == vertex.TexCoordIndex
+					&& existing.NormalIndex == vertex.NormalIndex) {
+					return slots[slot];
+				}
+				slot = (slot + 1U) & mask;
+			}
+
+			if (vertices.size() >= EMPTY_VERTEX_SLOT - 1U) throw LosgapException { "OBJ model has too many unique vertices." };
+			uint32_t newVertex = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(vertex);
+			slots[slot] = newVertex;
+			if (vertices.size() * 2U > slots.size()) Rehash(static_cast<uint32_t>(slots.size()) * 2U, vertices);
+			return newVertex;
+		}
+	};
+
+	inline bool IsObjWhitespace(char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+	}
+
+	inline bool IsDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	inline void SkipObjWhitespace(const char*& c, const char* lineEnd) {
+		while (c < lineEnd && IsObjWhitespace(*c)) ++c;
+	}
+
+	inline bool IsEndOfObjStatement(const char* c, const char* lineEnd) {
+		return c == lineEnd || *c == '#';
+	}
+
+	/*
+	Parses a decimal float (with optional sign, fraction and exponent) starting at c, and moves c past it. Up to
+	MAX_FLOAT_MANTISSA_DIGITS significant digits are accumulated as an integer, which is then scaled by a power of ten in double
+	precision, so results are within an ulp of float.Parse's. Returns false if there is no number at c.
+	*/
+	bool ParseObjFloat(const char*& c, const char* lineEnd, float& outValue) {
+		static const double_t EXACT_POWERS_OF_TEN[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+		const int32_t MAX_EXACT_POWER_OF_TEN = 22;
+
+		const char* start = c;
+		bool isNegative = false;
+		if (c < lineEnd && (*c == '-' || *c == '+')) {
+			isNegative = *c == '-';
+			++c;
+		}
+
+		uint64_t mantissa = 0U;
+		int32_t numMantissaDigits = 0;
+		int32_t exponent = 0;
+		bool hasDigits = false;
+		for (; c < lineEnd && IsDigit(*c); ++c) {
+			hasDigits = true;
+			if (numMantissaDigits < MAX_FLOAT_MANTISSA_DIGITS) {
+				mantissa = mantissa * 10U + static_cast<uint64_t>(*c - '0');
+				if (mantissa != 0U) ++numMantissaDigits;
+			}
+			else ++exponent;
+		}
+		if (c < lineEnd && *c == '.') {
+			++c;
+			for (; c < lineEnd && IsDigit(*c); ++c) {
+				hasDigits = true;
+				if (numMantissaDigits < MAX_FLOAT_MANTISSA_DIGITS) {
+					mantissa = mantissa * 10U + static_cast<uint64_t>(*c - '0');
+					if (mantissa != 0U) ++numMantissaDigits;
+					--exponent;
+				}
+			}
+		}
+		if (!hasDigits) {
+			c = start;
+			return false;
+		}
+
+		if (c < lineEnd && (*c == 'e' || *c == 'E')) {
+			const char* exponentStart = c++;
+			bool isExponentNegative = false;
+			if (c < lineEnd && (*c == '-' || *c == '+')) {
+				isExponentNegative = *c == '-';
+				++c;
+			}
+			if (c == lineEnd || !IsDigit(*c)) {
+				c = exponentStart;
+			}
+			else {
+				int32_t explicitExponent = 0;
+				for (; c < lineEnd && IsDigit(*c); ++c) {
+					if (explicitExponent < 10000) explicitExponent = explicitExponent * 10 + (*c - '0');
+				}
+				exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+			}
+		}
+
+		double_t value = static_cast<double_t>(mantissa);
+		if (mantissa != 0U && exponent != 0) {
+			if (exponent > MAX_EXACT_POWER_OF_TEN || exponent < -MAX_EXACT_POWER_OF_TEN) value *= std::pow(10.0, static_cast<double_t>(exponent));
+			else if (exponent > 0) value *= EXACT_POWERS_OF_TEN[exponent];
+			else value /= EXACT_POWERS_OF_TEN[-exponent];
+		}
+		outValue = static_cast<float>(isNegative ? -value : value);
+		return true;
+	}
+
+	/*
+	Parses a (possibly negative) decimal integer starting at c, and moves c past it. Returns false if there is no number at c.
+	*/
+	bool ParseObjIndex(const char*& c, const char* lineEnd, int64_t& outValue) {
+		const char* start = c;
+		bool isNegative = false;
+		if (c < lineEnd && (*c == '-' || *c == '+')) {
+			isNegative = *c == '-';
+			++c;
+		}
+		if (c == lineEnd || !IsDigit(*c)) {
+			c = start;
+			return false;
+		}
+
+		int64_t value = 0;
+		for (; c < lineEnd && IsDigit(*c); ++c) {
+			if (value < 0x100000000LL) value = value * 10 + (*c - '0');
+		}
+		outValue = isNegative ? -value : value;
+		return true;
+	}
+
+	/*
+	Turns a 1-based (or, if negative, relative to the end) OBJ index in to a 0-based one in to a list of numElements elements.
+	*/
+	uint32_t ResolveObjIndex(int64_t index, size_t numElements, const char* elementName, uint32_t lineNumber) {
+		int64_t resolvedIndex = index > 0 ? index - 1 : static_cast<int64_t>(numElements) + index;
+		if (index == 0 || resolvedIndex < 0 || resolvedIndex >= static_cast<int64_t>(numElements)) {
+			throw LosgapException {
+				"OBJ face on line " + std::to_string(lineNumber) + " refers to " + elementName + " " + std::to_string(index)
+					+ ", but only " + std::to_string(numElements) + " have been defined."
+			};
+		}
+		return static_cast<uint32_t>(resolvedIndex);
+	}
+
+	void ParseObjFloats(const char*& c, const char* lineEnd, uint32_t numRequired, uint32_t numOptional, std::vector<float>& outFloats,
+		uint32_t lineNumber) {
+		for (uint32_t f = 0U; f < numRequired + numOptional; ++f) {
+			SkipObjWhitespace(c, lineEnd);
+			float value = 0.0f;
+			if (!ParseObjFloat(c, lineEnd, value) && f < numRequired) {
+				throw LosgapException { "Expected " + std::to_string(numRequired) + " numbers on line " + std::to_string(lineNumber) + " of OBJ file." };
+			}
+			outFloats.push_back(value);
+		}
+	}
+
+	inline bool ObjKeywordEquals(const char* keyword, size_t keywordLength, const char* expected) {
+		for (size_t i = 0U; i < keywordLength; ++i) {
+			if (expected[i] == '\0' || (keyword[i] | 0x20) != expected[i]) return false;
+		}
+		return expected[keywordLength] == '\0';
+	}
+
+	ObjModelCounts ObjModel::GetCounts() const {
+		ObjModelCounts result;
+		result.NumPositions = static_cast<uint32_t>(Positions.size() / 3U);
+		result.NumTexCoords = static_cast<uint32_t>(TexCoords.size() / 2U);
+		result.NumNormals = static_cast<uint32_t>(Normals.size() / 3U);
+		result.NumVertices = static_cast<uint32_t>(Vertices.size());
+		result.NumIndices = static_cast<uint32_t>(Indices.size());
+		return result;
+	}
+
+	void ObjLoader::Parse(const char* text, size_t textLength, ObjModel& outModel) {
+		outModel.Positions.clear();
+		outModel.TexCoords.clear();
+		outModel.Normals.clear();
+		outModel.Vertices.clear();
+		outModel.Indices.clear();
+
+		ObjVertexTable vertexTable;
+		std::vector<uint32_t> faceCorners;
+		const char* textEnd = text + textLength;
+		uint32_t lineNumber = 1U;
+		for (const char* lineStart = text; lineStart < textEnd; ++lineNumber) {
+			const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', textEnd - lineStart));
+			if (lineEnd == nullptr) lineEnd = textEnd;
+			const char* c = lineStart;
+			lineStart = lineEnd + 1;
+
+			SkipObjWhitespace(c, lineEnd);
+			const char* keyword = c;
+			while (c < lineEnd && !IsObjWhitespace(*c)) ++c;
+			size_t keywordLength = c - keyword;
+
+			if (ObjKeywordEquals(keyword, keywordLength, "v")) {
+				ParseObjFloats(c, lineEnd, 3U, 0U, outModel.Positions, lineNumber);
+			}
+			else if (ObjKeywordEquals(keyword, keywordLength, "vt")) {
+				ParseObjFloats(c, lineEnd, 1U, 1U, outModel.TexCoords, lineNumber);
+				float& v = outModel.TexCoords.back();
+				v = 1.0f - v; // OBJ puts the origin at the bottom left
+			}
+			else if (ObjKeywordEquals(keyword, keywordLength, "vn")) {
+				ParseObjFloats(c, lineEnd, 3U, 0U, outModel.Normals, lineNumber);
+			}
+			else if (ObjKeywordEquals(keyword, keywordLength, "f")) {
+				size_t numPositions = outModel.Positions.size() / 3U;
+				size_t numTexCoords = outModel.TexCoords.size() / 2U;
+				size_t numNormals = outModel.Normals.size() / 3U;
+				faceCorners.clear();
+
+				for (SkipObjWhitespace(c, lineEnd); !IsEndOfObjStatement(c, lineEnd); SkipObjWhitespace(c, lineEnd)) {
+					ObjVertex corner = { 0U, 0U, 0U };
+					int64_t index;
+					if (!ParseObjIndex(c, lineEnd, index)) {
+						throw LosgapException { "Malformed face corner on line " + std::to_string(lineNumber) + " of OBJ file." };
+					}
+					corner.PositionIndex = ResolveObjIndex(index, numPositions, "position", lineNumber);
+					if (c < lineEnd && *c == '/') {
+						++c;
+						if (ParseObjIndex(c, lineEnd, index)) corner.TexCoordIndex = ResolveObjIndex(index, numTexCoords, "tex coord", lineNumber);
+						if (c < lineEnd && *c == '/') {
+							++c;
+							if (ParseObjIndex(c, lineEnd, index)) corner.NormalIndex = ResolveObjIndex(index, numNormals, "normal", lineNumber);
+						}
+					}
+					if (c < lineEnd && !IsObjWhitespace(*c)) {
+						throw LosgapException { "Malformed face corner on line " + std::to_string(lineNumber) + " of OBJ file." };
+					}
+
+					faceCorners.push_back(vertexTable.FindOrAdd(corner, outModel.Vertices));
+				}
+
+				if (faceCorners.size() < 3U) {
+					throw LosgapException { "OBJ face on line " + std::to_string(lineNumber) + " has fewer than three corners." };
+				}
+				for (size_t corner = 2U; corner < faceCorners.size(); ++corner) {
+					outModel.Indices.push_back(faceCorners[0]);
+					outModel.Indices.push_back(faceCorners[corner - 1U]);
+					outModel.Indices.push_back(faceCorners[corner]);
+				}
+			}
+		}
+
+		if (outModel.Indices.size() > 0xFFFFFFFFU) throw LosgapException { "OBJ model has too many triangles." };
+	}
+
+	/*
+	A read-only view of a whole file. Empty files are never mapped (Windows can't map them), and are left with a null view.
+	*/
+	class MappedObjFile {
+	private:
+		HANDLE file;
+		HANDLE mapping;
+		const char* view;
+		size_t size;
+
+	public:
+		explicit MappedObjFile(const LosgapString& filePath) : file(INVALID_HANDLE_VALUE), mapping(nullptr), view(nullptr), size(0U) {
+			std::unique_ptr<const wchar_t[]> filePathW = LosgapString::AsNewCWString(filePath);
+			file = CreateFileW(filePathW.get(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				throw LosgapException {
+					"Could not open OBJ file '" + LosgapString::AsNewString(filePath) + "' (error " + std::to_string(GetLastError()) + ")."
+				};
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize)) {
+				DWORD error = GetLastError();
+				CloseHandle(file);
+				throw LosgapException { "Could not get size of OBJ file (error " + std::to_string(error) + ")." };
+			}
+			size = static_cast<size_t>(fileSize.QuadPart);
+			if (size == 0U) return;
+
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr) view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			if (view == nullptr) {
+				DWORD error = GetLastError();
+				if (mapping != nullptr) CloseHandle(mapping);
+				CloseHandle(file);
+				throw LosgapException { "Could not map OBJ file in to memory (error " + std::to_string(error) + ")." };
+			}
+		}
+		~MappedObjFile() {
+			if (view != nullptr) UnmapViewOfFile(view);
+			if (mapping != nullptr) CloseHandle(mapping);
+			CloseHandle(file);
+		}
+		DISALLOW_COPY_ASSIGN_MOVE(MappedObjFile);
+
+		const char* GetView() const { return view; }
+		size_t GetSize() const { return size; }
+	};
+
+	void ObjLoader::Load(const LosgapString& filePath, ObjModel& outModel) {
+		ScopedTrace trace { "ObjLoader::Load" };
+		MappedObjFile mappedFile { filePath };
+		Parse(mappedFile.GetView(), mappedFile.GetSize(), outModel);
+	}
+
+	EXPORT(ObjLoader_Load, INTEROP_STRING filePath, ObjModel** outModel, ObjModelCounts* outCounts) {
+		if (filePath == nullptr) throw LosgapException { "OBJ file path must not be null." };
+		std::unique_ptr<ObjModel> model { new ObjModel };
+		ObjLoader::Load(filePath, *model);
+		*outCounts = model->GetCounts();
+		*outModel = model.release();
+		EXPORT_END;
+	}
+
+	EXPORT(ObjLoader_Parse, const char* text, uint32_t textLength, ObjModel** outModel, ObjModelCounts* outCounts) {
+		if (text == nullptr && textLength > 0U) throw LosgapException { "OBJ text must not be null." };
+		std::unique_ptr<ObjModel> model { new ObjModel };
+		ObjLoader::Parse(text, textLength, *model);
+		*outCounts = model->GetCounts();
+		*outModel = model.release();
+		EXPORT_END;
+	}
+
+	EXPORT_FAST(ObjLoader_CopyModel, const ObjModel* model, float* outPositionArr, float* outTexCoordArr, float* outNormalArr,
+		ObjVertex* outVertexArr, uint32_t* outIndexArr) {
+		if (!model->Positions.empty()) memcpy(outPositionArr, model->Positions.data(), model->Positions.size() * sizeof(float));
+		if (!model->TexCoords.empty()) memcpy(outTexCoordArr, model->TexCoords.data(), model->TexCoords.size() * sizeof(float));
+		if (!model->Normals.empty()) memcpy(outNormalArr, model->Normals.data(), model->Normals.size() * sizeof(float));
+		if (!model->Vertices.empty()) memcpy(outVertexArr, model->Vertices.data(), model->Vertices.size() * sizeof(ObjVertex));
+		if (!model->Indices.empty()) memcpy(outIndexArr, model->Indices.data(), model->Indices.size() * sizeof(uint32_t));
+		EXPORT_FAST_END;
+	}
+
+	EXPORT_FAST(ObjLoader_FreeModel, ObjModel* model) {
+		delete model;
+		EXPORT_FAST_END;
+	}
+}
@@ -0,0 +1,65 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include "LosgapString.h"
+#include "LosgapException.h"
+#include <cstdint>
+#include <vector>
+
+namespace losgap {
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	One unique corner of a face: which position, tex coord and normal it uses. Matches ModelVertex in AssetManagement.
+	*/
+	struct ObjVertex {
+		uint32_t PositionIndex;
+		uint32_t TexCoordIndex;
+		uint32_t NormalIndex;
+	};
+
+	struct ObjModelCounts {
+		uint32_t NumPositions;
+		uint32_t NumTexCoords;
+		uint32_t NumNormals;
+		uint32_t NumVertices;
+		uint32_t NumIndices;
+	};
+#pragma pack(pop)
+
+	/*
+	A loaded OBJ model. Positions and normals are three floats each, tex coords two (with V already flipped to the top-left origin
+	the renderer uses). Each face corner that uses a new combination of position, tex coord and normal becomes one vertex, and every
+	other corner that uses the same combination indexes that vertex instead. Corners with no tex coord or normal use index 0.
+	*/
+	struct ObjModel {
+		std::vector<float> Positions;
+		std::vector<float> TexCoords;
+		std::vector<float> Normals;
+		std::vector<ObjVertex> Vertices;
+		std::vector<uint32_t> Indices;
+
+		ObjModelCounts GetCounts() const;
+	};
+
+	/*
+	A static class that loads Wavefront OBJ files. Only the v, vt, vn and f statements are read (everything else, such as groups and
+	materials, is skipped). Faces with more than three corners are fan-triangulated, and negative (relative) indices are supported.
+	*/
+	class ObjLoader {
+	public:
+		/*
+		Maps the file in to memory and parses it with Parse().
+		*/
+		static void Load(const LosgapString& filePath, ObjModel& outModel);
+
+		/*
+		Parses OBJ text (which need not be null-terminated) in to outModel, replacing its contents. Throws a LosgapException giving
+		the line number for anything malformed, or for any index that refers to an element not yet defined.
+		*/
+		static void Parse(const char* text, size_t textLength, ObjModel& outModel);
+	};
+}
@@ -0,0 +1,70 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "Platform.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <chrono>
+#include <functional>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace losgap {
+#ifdef _WIN32
+	int64_t Platform::GetTicks() {
+		LARGE_INTEGER result;
+		QueryPerformanceCounter(&result);
+		return result.QuadPart;
+	}
+
+	int64_t Platform::GetTicksPerSecond() {
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+	}
+
+	uint32_t Platform::GetCurrentThreadID() {
+		return static_cast<uint32_t>(GetCurrentThreadId());
+	}
+
+	uint32_t Platform::GetCurrentProcessID() {
+		return static_cast<uint32_t>(GetCurrentProcessId());
+	}
+
+	bool Platform::SetThreadAffinity(std::thread& thread, uint64_t affinityMask) {
+		return SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(affinityMask)) != 0;
+	}
+#else
+	int64_t Platform::GetTicks() {
+		return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	int64_t Platform::GetTicksPerSecond() {
+		return 1000000000LL;
+	}
+
+	uint32_t Platform::GetCurrentThreadID() {
+		return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	}
+
+	uint32_t Platform::GetCurrentProcessID() {
+		return static_cast<uint32_t>(getpid());
+	}
+
+	bool Platform::SetThreadAffinity(std::thread& thread, uint64_t affinityMask) {
+#ifdef __linux__
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		for (uint32_t i = 0U; i < 64U; ++i) {
+			if ((affinityMask & (1ULL << i)) != 0ULL) CPU_SET(i, &cpuSet);
+		}
+		return pthread_setaffinity_np(thread.native_handle(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+		return false;
+#endif
+	}
+#endif
+}
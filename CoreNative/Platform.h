@@ -0,0 +1,35 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include <cstdint>
+#include <thread>
+
+namespace losgap {
+	/*
+	A static class wrapping the OS services used by the parts of CoreNative that are also built off Windows (see CMakeLists.txt), so
+	that they do not call the Win32 API directly. On Windows each function is a thin wrapper around the Win32 call; elsewhere the
+	standard library (or pthreads) stands in.
+	*/
+	class __declspec(dllexport) Platform {
+	public:
+		/*
+		A monotonic, high-resolution tick count (QueryPerformanceCounter on Windows, steady_clock elsewhere). Only differences between
+		two readings are meaningful; divide them by GetTicksPerSecond() to get seconds.
+		*/
+		static int64_t GetTicks();
+		static int64_t GetTicksPerSecond();
+
+		static uint32_t GetCurrentThreadID();
+		static uint32_t GetCurrentProcessID();
+
+		/*
+		Restricts the given thread to the logical processors in the given mask. Returns false if the OS refused (or, off Windows and
+		Linux, does not support it).
+		*/
+		static bool SetThreadAffinity(std::thread& thread, uint64_t affinityMask);
+	};
+}
@@ -13,7 +13,7 @@ namespace losgap {
 	private:
 		T comObjectPtr;
 	public:
-		DEFINE_DEFAULT_CONSTRUCTOR(RAIICOMWrapper);
+		RAIICOMWrapper() = default;
 		RAIICOMWrapper(T comObjectPtr) : comObjectPtr(comObjectPtr) { }
 		~RAIICOMWrapper() { RELEASE_COM(comObjectPtr); }
 
@@ -2,6 +2,9 @@
 // See http://www.losgap.com/ for licensing information
 
 #include "LosgapCore.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <codecvt>
 
 EXPORT(ReturnSuccess) {
 	EXPORT_END;
@@ -9,4 +12,64 @@ EXPORT(ReturnSuccess) {
 EXPORT(ReturnFailure, const char16_t* const customFailureMessage) {
 	EXPORT_FAIL(customFailureMessage);
 	EXPORT_END;
-}
\ No newline at end of file
+}
+EXPORT_FAST(ReturnFastSuccess) {
+	EXPORT_FAST_END;
+}
+EXPORT_FAST(ReturnFastFailure, const char16_t* const customFailureMessage) {
+	throw losgap::LosgapException { customFailureMessage };
+	EXPORT_FAST_END;
+}
+
+#ifdef LOSGAP_TEST_EXPORTS
+EXPORT(JobSystemParallelSum, uint32_t numIterations, uint32_t blockSize, uint64_t* outSum) {
+	std::atomic<uint64_t> sum { 0ULL };
+	losgap::JobSystem::ParallelFor(numIterations, blockSize, [&sum](uint32_t i) { sum.fetch_add(i); });
+	*outSum = sum.load();
+	EXPORT_END;
+}
+
+EXPORT(LosgapStringRoundTrip, const char16_t* input, char16_t* outBuffer, uint32_t bufferLen) {
+	std::string asUTF8 = losgap::LosgapString::AsNewString(input);
+	losgap::LosgapString { asUTF8 }.CopyTo(outBuffer, bufferLen);
+	EXPORT_END;
+}
+
+/*
+Times constructing strings from UTF-8 and converting them back, once the way LosgapString used to (codecvt plus a heap copy for
+every string) and once through the current LosgapString.
+*/
+EXPORT(BenchmarkLosgapString, uint32_t numIterations, double* outLegacyMs, double* outCurrentMs) {
+	const char* const INPUTS[] = { "Shaders\\Default.cso", "A much longer path that will never fit in the inline buffer\\Meshes\\Lizard.obj" };
+	const uint32_t NUM_INPUTS = sizeof(INPUTS) / sizeof(INPUTS[0]);
+	size_t checksum = 0U;
+
+	auto legacyStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0U; i < numIterations; ++i) {
+		const char* input = INPUTS[i % NUM_INPUTS];
+		std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter { };
+		std::u16string converted = converter.from_bytes(input);
+		char16_t* copy = new char16_t[converted.length() + 1U];
+		memcpy(copy, converted.c_str(), (converted.length() + 1U) * sizeof(char16_t));
+		std::string narrowed = converter.to_bytes(copy);
+		checksum += narrowed.length();
+		delete[] copy;
+	}
+	auto legacyEnd = std::chrono::high_resolution_clock::now();
+
+	const size_t PATH_BUFFER_LEN = 260U;
+	char pathBuffer[PATH_BUFFER_LEN];
+	auto currentStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0U; i < numIterations; ++i) {
+		losgap::LosgapString converted { INPUTS[i % NUM_INPUTS] };
+		converted.CopyTo(pathBuffer, PATH_BUFFER_LEN);
+		checksum += converted.GetLength();
+	}
+	auto currentEnd = std::chrono::high_resolution_clock::now();
+
+	if (checksum == 0U && numIterations > 0U) throw losgap::LosgapException { "Benchmark produced no output." };
+	*outLegacyMs = std::chrono::duration<double, std::milli>(legacyEnd - legacyStart).count();
+	*outCurrentMs = std::chrono::duration<double, std::milli>(currentEnd - currentStart).count();
+	EXPORT_END;
+}
+#endif
@@ -0,0 +1,155 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "TraceRecorder.h"
+#include "InteropError.h"
+#include "Platform.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace losgap {
+	struct TraceEventRecord {
+		const char* Name;
+		int64_t Timestamp;
+		char Phase;
+	};
+
+	/*
+	Only the owning thread writes to a buffer's events and NumWritten, which only ever increases; the newest EVENTS_PER_THREAD events are
+	the valid ones. Clearing never touches NumWritten (the owner could undo it with its next store), but instead moves FirstUncleared,
+	which only readers use (always under traceRegistryLock), up to it.
+	*/
+	struct ThreadTraceBuffer {
+		uint32_t ThreadID;
+		std::atomic<uint64_t> NumWritten;
+		uint64_t FirstUncleared;
+		TraceEventRecord Events[TraceRecorder::EVENTS_PER_THREAD];
+	};
+
+	std::atomic<bool> TraceRecorder::isEnabled;
+
+	std::mutex traceRegistryLock;
+	std::vector<ThreadTraceBuffer*> threadTraceBuffers;
+	std::set<std::string> internedTraceNames;
+	__declspec(thread) ThreadTraceBuffer* threadTraceBuffer;
+
+	ThreadTraceBuffer* GetThreadTraceBuffer() {
+		if (threadTraceBuffer != nullptr) return threadTraceBuffer;
+
+		ThreadTraceBuffer* newBuffer = new ThreadTraceBuffer;
+		newBuffer->ThreadID = Platform::GetCurrentThreadID();
+		newBuffer->NumWritten.store(0U, std::memory_order_relaxed);
+		newBuffer->FirstUncleared = 0U;
+		{
+			std::lock_guard<std::mutex> lock { traceRegistryLock };
+			threadTraceBuffers.push_back(newBuffer);
+		}
+		threadTraceBuffer = newBuffer;
+		return newBuffer;
+	}
+
+	void TraceRecorder::RecordEvent(const char* name, char phase) {
+		int64_t timestamp = Platform::GetTicks();
+
+		ThreadTraceBuffer* buffer = GetThreadTraceBuffer();
+		uint64_t eventIndex = buffer->NumWritten.load(std::memory_order_relaxed);
+		// Keeps this event's writes after the previous event's publication, so a reader that sees them also sees the slot is reused
+		std::atomic_thread_fence(std::memory_order_release);
+		TraceEventRecord& record = buffer->Events[eventIndex % EVENTS_PER_THREAD];
+		record.Name = name;
+		record.Timestamp = timestamp;
+		record.Phase = phase;
+		buffer->NumWritten.store(eventIndex + 1U, std::memory_order_release);
+	}
+
+	EXPORT(Trace_SetEnabled, INTEROP_BOOL enabled) {
+		TraceRecorder::SetEnabled(INTEROP_BOOL_TO_CBOOL(enabled));
+		EXPORT_END;
+	}
+
+	const char* TraceRecorder::RegisterName(const char* name) {
+		if (name == nullptr) throw LosgapException { "Trace event name must not be null." };
+		std::lock_guard<std::mutex> lock { traceRegistryLock };
+		return internedTraceNames.insert(name).first->c_str();
+	}
+	EXPORT(Trace_RegisterName, INTEROP_STRING name, const char** outInternedName) {
+		if (name == nullptr) throw LosgapException { "Trace event name must not be null." };
+		*outInternedName = TraceRecorder::RegisterName(LosgapString::AsNewString(name).c_str());
+		EXPORT_END;
+	}
+
+	EXPORT_FAST(Trace_Begin, const char* internedName) {
+		TraceRecorder::Begin(internedName);
+		EXPORT_FAST_END;
+	}
+	EXPORT_FAST(Trace_End, const char* internedName) {
+		TraceRecorder::End(internedName);
+		EXPORT_FAST_END;
+	}
+
+	void TraceRecorder::Clear() {
+		std::lock_guard<std::mutex> lock { traceRegistryLock };
+		for (ThreadTraceBuffer* buffer : threadTraceBuffers) buffer->FirstUncleared = buffer->NumWritten.load(std::memory_order_acquire);
+	}
+	EXPORT(Trace_Clear) {
+		TraceRecorder::Clear();
+		EXPORT_END;
+	}
+
+	void WriteJSONString(std::ofstream& outStream, const char* value) {
+		outStream << '"';
+		for (const char* c = value; *c != '\0'; ++c) {
+			if (*c == '"' || *c == '\\') outStream << '\\' << *c;
+			else if (static_cast<unsigned char>(*c) < 0x20U) outStream << ' ';
+			else outStream << *c;
+		}
+		outStream << '"';
+	}
+
+	void TraceRecorder::WriteChromeTrace(const char* filePath) {
+		if (filePath == nullptr) throw LosgapException { "Trace file path must not be null." };
+		std::ofstream outStream { filePath, std::ofstream::trunc };
+		if (!outStream) throw LosgapException { "Could not open trace file '" + std::string(filePath) + "' for writing." };
+
+		double_t microsecondsPerTick = 1000000.0 / static_cast<double_t>(Platform::GetTicksPerSecond());
+		uint32_t processID = Platform::GetCurrentProcessID();
+
+		outStream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+		bool isFirstEvent = true;
+		std::lock_guard<std::mutex> lock { traceRegistryLock };
+		for (ThreadTraceBuffer* buffer : threadTraceBuffers) {
+			uint64_t numWritten = buffer->NumWritten.load(std::memory_order_acquire);
+			uint64_t firstEvent = numWritten > EVENTS_PER_THREAD ? numWritten - EVENTS_PER_THREAD : 0U;
+			if (firstEvent < buffer->FirstUncleared) firstEvent = buffer->FirstUncleared;
+			for (uint64_t e = firstEvent; e < numWritten; ++e) {
+				// Copy the event out and only then check its slot wasn't being reused by the (still recording) owner meanwhile; if it was,
+				// the copy may be torn, and so may every event up to the one being written now, so skip ahead past them
+				TraceEventRecord record = buffer->Events[e % EVENTS_PER_THREAD];
+				std::atomic_thread_fence(std::memory_order_acquire);
+				uint64_t numWrittenNow = buffer->NumWritten.load(std::memory_order_relaxed);
+				if (numWrittenNow >= e + EVENTS_PER_THREAD) {
+					e = numWrittenNow - EVENTS_PER_THREAD;
+					continue;
+				}
+				outStream << (isFirstEvent ? "\n" : ",\n") << "{\"name\":";
+				WriteJSONString(outStream, record.Name);
+				outStream << ",\"ph\":\"" << record.Phase << "\",\"ts\":" << (static_cast<double_t>(record.Timestamp) * microsecondsPerTick)
+					<< ",\"pid\":" << processID << ",\"tid\":" << buffer->ThreadID << "}";
+				isFirstEvent = false;
+			}
+		}
+		outStream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		if (!outStream) throw LosgapException { "Could not write trace file '" + std::string(filePath) + "'." };
+	}
+	EXPORT(Trace_WriteChromeTrace, INTEROP_STRING filePath) {
+		if (filePath == nullptr) throw LosgapException { "Trace file path must not be null." };
+		TraceRecorder::WriteChromeTrace(LosgapString::AsNewString(filePath).c_str());
+		EXPORT_END;
+	}
+}
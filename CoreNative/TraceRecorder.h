@@ -0,0 +1,65 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include "LosgapException.h"
+#include <atomic>
+#include <cstdint>
+
+namespace losgap {
+	/*
+	A static class that records begin/end events in to a lock-free ring buffer per thread, and writes them out in Chrome's trace_event
+	JSON format (load the file at chrome://tracing). Event names are never copied, so they must outlive the recording: native callers
+	use string literals, and managed callers intern their names with RegisterName() first.
+	While tracing is disabled, recording an event is a single flag check.
+	*/
+	class __declspec(dllexport) TraceRecorder {
+		friend class ScopedTrace;
+	private:
+		static std::atomic<bool> isEnabled;
+
+		static void RecordEvent(const char* name, char phase);
+
+	public:
+		static const uint32_t EVENTS_PER_THREAD = 65536U;
+
+		static bool IsEnabled() { return isEnabled.load(std::memory_order_relaxed); }
+		static void SetEnabled(bool enabled) { isEnabled.store(enabled, std::memory_order_relaxed); }
+
+		static const char* RegisterName(const char* name);
+		static void Begin(const char* name) { if (IsEnabled()) RecordEvent(name, 'B'); }
+		static void End(const char* name) { if (IsEnabled()) RecordEvent(name, 'E'); }
+
+		/*
+		Discards all events recorded so far. Safe to call while other threads are recording (their later events are kept).
+		*/
+		static void Clear();
+
+		/*
+		Writes every event still held in the ring buffers to the given file. If other threads are still recording, any of their oldest
+		events that get overwritten while being written out are skipped rather than written torn, so prefer to disable tracing first for
+		a complete capture.
+		*/
+		static void WriteChromeTrace(const char* filePath);
+	};
+
+	/*
+	Records a begin event on construction and the matching end event on destruction (only if the begin was recorded).
+	*/
+	class __declspec(dllexport) ScopedTrace {
+	private:
+		const char* name;
+
+	public:
+		explicit ScopedTrace(const char* name) : name(TraceRecorder::IsEnabled() ? name : nullptr) {
+			if (this->name != nullptr) TraceRecorder::RecordEvent(this->name, 'B');
+		}
+		~ScopedTrace() {
+			if (name != nullptr) TraceRecorder::RecordEvent(name, 'E');
+		}
+		DISALLOW_COPY_ASSIGN_MOVE(ScopedTrace);
+	};
+}
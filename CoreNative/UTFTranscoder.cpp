@@ -0,0 +1,183 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "UTFTranscoder.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF_TRANSCODER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace losgap {
+	const uint32_t MAX_CODE_POINT = 0x10FFFFU;
+
+	inline bool IsHighSurrogate(uint32_t codeUnit) { return codeUnit >= 0xD800U && codeUnit <= 0xDBFFU; }
+	inline bool IsLowSurrogate(uint32_t codeUnit) { return codeUnit >= 0xDC00U && codeUnit <= 0xDFFFU; }
+
+	/*
+	Decodes one (non-ASCII) code point starting at source. Returns the number of bytes consumed, which on error is the length of the
+	longest valid prefix (at least 1), so that the following byte is re-examined as a possible lead byte.
+	*/
+	size_t DecodeUTF8(const unsigned char* source, size_t bytesRemaining, uint32_t& outCodePoint) {
+		unsigned char leadByte = source[0];
+		size_t numContinuationBytes;
+		uint32_t minCodePoint;
+		if (leadByte >= 0xC2U && leadByte <= 0xDFU) {
+			numContinuationBytes = 1U;
+			minCodePoint = 0x80U;
+			outCodePoint = leadByte & 0x1FU;
+		}
+		else if (leadByte >= 0xE0U && leadByte <= 0xEFU) {
+			numContinuationBytes = 2U;
+			minCodePoint = 0x800U;
+			outCodePoint = leadByte & 0x0FU;
+		}
+		else if (leadByte >= 0xF0U && leadByte <= 0xF4U) {
+			numContinuationBytes = 3U;
+			minCodePoint = 0x10000U;
+			outCodePoint = leadByte & 0x07U;
+		}
+		else {
+			outCodePoint = UTFTranscoder::REPLACEMENT_CHARACTER;
+			return 1U;
+		}
+
+		for (size_t i = 1U; i <= numContinuationBytes; ++i) {
+			if (i >= bytesRemaining || (source[i] & 0xC0U) != 0x80U) {
+				outCodePoint = UTFTranscoder::REPLACEMENT_CHARACTER;
+				return i;
+			}
+			outCodePoint = (outCodePoint << 6) | (source[i] & 0x3FU);
+		}
+
+		if (outCodePoint < minCodePoint || outCodePoint > MAX_CODE_POINT || IsHighSurrogate(outCodePoint) || IsLowSurrogate(outCodePoint)) {
+			outCodePoint = UTFTranscoder::REPLACEMENT_CHARACTER;
+		}
+		return numContinuationBytes + 1U;
+	}
+
+	template <bool WRITE>
+	size_t UTF8ToUTF16(const char* source, size_t sourceLength, char16_t* dest, size_t destLength) {
+		const unsigned char* sourceBytes = reinterpret_cast<const unsigned char*>(source);
+		size_t in = 0U;
+		size_t out = 0U;
+		while (in < sourceLength) {
+#ifdef UTF_TRANSCODER_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			while (in + 16U <= sourceLength && out + 16U <= destLength) {
+				__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sourceBytes + in));
+				if (_mm_movemask_epi8(bytes) != 0) break;
+				if (WRITE) {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + out), _mm_unpacklo_epi8(bytes, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + out + 8U), _mm_unpackhi_epi8(bytes, zero));
+				}
+				in += 16U;
+				out += 16U;
+			}
+			if (in >= sourceLength) break;
+#endif
+			unsigned char leadByte = sourceBytes[in];
+			if (leadByte < 0x80U) {
+				if (out + 1U > destLength) break;
+				if (WRITE) dest[out] = leadByte;
+				++out;
+				++in;
+				continue;
+			}
+
+			uint32_t codePoint;
+			size_t bytesConsumed = DecodeUTF8(sourceBytes + in, sourceLength - in, codePoint);
+			if (codePoint >= 0x10000U) {
+				if (out + 2U > destLength) break;
+				if (WRITE) {
+					codePoint -= 0x10000U;
+					dest[out] = static_cast<char16_t>(0xD800U + (codePoint >> 10));
+					dest[out + 1U] = static_cast<char16_t>(0xDC00U + (codePoint & 0x3FFU));
+				}
+				out += 2U;
+			}
+			else {
+				if (out + 1U > destLength) break;
+				if (WRITE) dest[out] = static_cast<char16_t>(codePoint);
+				++out;
+			}
+			in += bytesConsumed;
+		}
+		return out;
+	}
+
+	template <bool WRITE>
+	size_t UTF16ToUTF8(const char16_t* source, size_t sourceLength, char* dest, size_t destLength) {
+		size_t in = 0U;
+		size_t out = 0U;
+		while (in < sourceLength) {
+#ifdef UTF_TRANSCODER_SSE2
+			const __m128i nonASCIIMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+			const __m128i zero = _mm_setzero_si128();
+			while (in + 8U <= sourceLength && out + 8U <= destLength) {
+				__m128i codeUnits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + in));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(codeUnits, nonASCIIMask), zero)) != 0xFFFF) break;
+				if (WRITE) _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + out), _mm_packus_epi16(codeUnits, codeUnits));
+				in += 8U;
+				out += 8U;
+			}
+			if (in >= sourceLength) break;
+#endif
+			uint32_t codePoint = source[in];
+			size_t unitsConsumed = 1U;
+			if (IsHighSurrogate(codePoint)) {
+				if (in + 1U < sourceLength && IsLowSurrogate(source[in + 1U])) {
+					codePoint = 0x10000U + ((codePoint - 0xD800U) << 10) + (source[in + 1U] - 0xDC00U);
+					unitsConsumed = 2U;
+				}
+				else codePoint = UTFTranscoder::REPLACEMENT_CHARACTER;
+			}
+			else if (IsLowSurrogate(codePoint)) codePoint = UTFTranscoder::REPLACEMENT_CHARACTER;
+
+			size_t numBytes = codePoint < 0x80U ? 1U : (codePoint < 0x800U ? 2U : (codePoint < 0x10000U ? 3U : 4U));
+			if (out + numBytes > destLength) break;
+			if (WRITE) {
+				switch (numBytes) {
+					case 1U:
+						dest[out] = static_cast<char>(codePoint);
+						break;
+					case 2U:
+						dest[out] = static_cast<char>(0xC0U | (codePoint >> 6));
+						dest[out + 1U] = static_cast<char>(0x80U | (codePoint & 0x3FU));
+						break;
+					case 3U:
+						dest[out] = static_cast<char>(0xE0U | (codePoint >> 12));
+						dest[out + 1U] = static_cast<char>(0x80U | ((codePoint >> 6) & 0x3FU));
+						dest[out + 2U] = static_cast<char>(0x80U | (codePoint & 0x3FU));
+						break;
+					default:
+						dest[out] = static_cast<char>(0xF0U | (codePoint >> 18));
+						dest[out + 1U] = static_cast<char>(0x80U | ((codePoint >> 12) & 0x3FU));
+						dest[out + 2U] = static_cast<char>(0x80U | ((codePoint >> 6) & 0x3FU));
+						dest[out + 3U] = static_cast<char>(0x80U | (codePoint & 0x3FU));
+						break;
+				}
+			}
+			out += numBytes;
+			in += unitsConsumed;
+		}
+		return out;
+	}
+
+	size_t UTFTranscoder::MeasureUTF8AsUTF16(const char* source, size_t sourceLength) {
+		return UTF8ToUTF16<false>(source, sourceLength, nullptr, SIZE_MAX);
+	}
+
+	size_t UTFTranscoder::MeasureUTF16AsUTF8(const char16_t* source, size_t sourceLength) {
+		return UTF16ToUTF8<false>(source, sourceLength, nullptr, SIZE_MAX);
+	}
+
+	size_t UTFTranscoder::TranscodeUTF8ToUTF16(const char* source, size_t sourceLength, char16_t* dest, size_t destLength) {
+		return UTF8ToUTF16<true>(source, sourceLength, dest, destLength);
+	}
+
+	size_t UTFTranscoder::TranscodeUTF16ToUTF8(const char16_t* source, size_t sourceLength, char* dest, size_t destLength) {
+		return UTF16ToUTF8<true>(source, sourceLength, dest, destLength);
+	}
+}
@@ -0,0 +1,27 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+#include "Macro.h"
+#include <cstdint>
+#include <cstddef>
+
+namespace losgap {
+	/*
+	A static class that converts between UTF-8 and UTF-16 without allocating. Runs of ASCII are converted 16 (or 8) at a time with SSE2.
+	Malformed input (bad sequences, unpaired surrogates) is replaced with U+FFFD rather than rejected.
+	The Transcode functions write as many whole code points as fit in destLength code units, don't write a null terminator,
+	and return the number of code units written. The Measure functions return the number of code units a full conversion needs.
+	*/
+	class __declspec(dllexport) UTFTranscoder {
+	public:
+		static const char16_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+		static size_t MeasureUTF8AsUTF16(const char* source, size_t sourceLength);
+		static size_t MeasureUTF16AsUTF8(const char16_t* source, size_t sourceLength);
+		static size_t TranscodeUTF8ToUTF16(const char* source, size_t sourceLength, char16_t* dest, size_t destLength);
+		static size_t TranscodeUTF16ToUTF8(const char16_t* source, size_t sourceLength, char* dest, size_t destLength);
+	};
+}
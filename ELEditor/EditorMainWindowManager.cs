@@ -384,6 +384,7 @@ namespace Egodystonic.EscapeLizards.Editor {
 			AssetLocator.MainCamera = AssetLocator.MainGeometryPass.Input = new IlluminatingCamera(GameplayConstants.EGG_ILLUMINATION_RADIUS, Vector3.ONE);
 			AssetLocator.ShadowcasterCamera = shadowPass.LightCam = new Camera();
 			AssetLocator.ShadowcasterCamera.OrthographicDimensions = new Vector3(1000f, 1000f, PhysicsManager.ONE_METRE_SCALED * 100f);
+			shadowPass.ReceiverCam = AssetLocator.MainCamera;
 
 			RenderingModule.AddRenderPass(shadowPass);
 			RenderingModule.AddRenderPass(AssetLocator.MainGeometryPass);
@@ -0,0 +1,96 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 16:20 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Entities {
+	/// <summary>
+	/// Describes which broadphase the physics world should use, and (for the sweep-and-prune types) the bounds of the world.
+	/// Bodies that move outside the bounds of a sweep-and-prune broadphase are clamped to its edges, so pad them generously.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+	public struct BroadphaseDesc : IEquatable<BroadphaseDesc> {
+		public const uint DEFAULT_MAX_HANDLES = 16384U;
+		public const uint MAX_AXIS_SWEEP_16_HANDLES = 32767U;
+		private readonly Vector4 worldMin;
+		private readonly Vector4 worldMax;
+		private readonly PhysicsBroadphaseType type;
+		private readonly uint maxHandles;
+
+		public static BroadphaseDesc DynamicTree {
+			get {
+				return new BroadphaseDesc(PhysicsBroadphaseType.DynamicTree, Vector3.ONE * -1000f, Vector3.ONE * 1000f, DEFAULT_MAX_HANDLES);
+			}
+		}
+
+		public Vector3 WorldMin {
+			get {
+				return (Vector3) worldMin;
+			}
+		}
+
+		public Vector3 WorldMax {
+			get {
+				return (Vector3) worldMax;
+			}
+		}
+
+		public PhysicsBroadphaseType Type {
+			get {
+				return type;
+			}
+		}
+
+		public uint MaxHandles {
+			get {
+				return maxHandles;
+			}
+		}
+
+		public BroadphaseDesc(PhysicsBroadphaseType type, Vector3 worldMin, Vector3 worldMax, uint maxHandles = DEFAULT_MAX_HANDLES) {
+			Assure.LessThan(worldMin.X, worldMax.X, "World min must be less than world max on every axis.");
+			Assure.LessThan(worldMin.Y, worldMax.Y, "World min must be less than world max on every axis.");
+			Assure.LessThan(worldMin.Z, worldMax.Z, "World min must be less than world max on every axis.");
+			Assure.GreaterThan(maxHandles, 0U);
+			if (type == PhysicsBroadphaseType.AxisSweep16) Assure.LessThanOrEqualTo(maxHandles, MAX_AXIS_SWEEP_16_HANDLES);
+			this.type = type;
+			this.worldMin = worldMin;
+			this.worldMax = worldMax;
+			this.maxHandles = maxHandles;
+		}
+
+		public bool Equals(BroadphaseDesc other) {
+			return worldMin.Equals(other.worldMin) && worldMax.Equals(other.worldMax) && type == other.type && maxHandles == other.maxHandles;
+		}
+
+		public override bool Equals(object obj) {
+			if (ReferenceEquals(null, obj)) return false;
+			return obj is BroadphaseDesc && Equals((BroadphaseDesc) obj);
+		}
+
+		public override int GetHashCode() {
+			unchecked {
+				int hashCode = worldMin.GetHashCode();
+				hashCode = (hashCode * 397) ^ worldMax.GetHashCode();
+				hashCode = (hashCode * 397) ^ (int) type;
+				hashCode = (hashCode * 397) ^ (int) maxHandles;
+				return hashCode;
+			}
+		}
+
+		public static bool operator ==(BroadphaseDesc left, BroadphaseDesc right) {
+			return left.Equals(right);
+		}
+
+		public static bool operator !=(BroadphaseDesc left, BroadphaseDesc right) {
+			return !left.Equals(right);
+		}
+
+		public override string ToString() {
+			return type + " (" + WorldMin + " -> " + WorldMax + ", max " + maxHandles + " handles)";
+		}
+	}
+}
@@ -260,6 +260,67 @@ namespace Ophidian.Losgap.Entities {
 			SetPhysicsProperties(restitution, linearDamping, angularDamping, friction, rollingFriction);
 		}
 
+		/// <summary>
+		/// Does the same as calling <see cref="SetPhysicsShape"/> on every given entity (entities[i] gets shapeHandles[i]), but creates
+		/// all the bodies in one batch (see <see cref="PhysicsManager.CreateRigidBodies"/>), which is far cheaper when loading levels.
+		/// </summary>
+		public static void SetPhysicsShapes(
+			IList<Entity> entities,
+			IList<PhysicsShapeHandle> shapeHandles,
+			Vector3 physicsShapeOffset,
+			float mass,
+			bool forceIntransigence = false,
+			bool disablePerformanceDeactivation = false,
+			bool collideOnlyWithWorld = false,
+			bool collideWithOnlyDynamics = false,
+			float restitution = PhysicsManager.DEFAULT_RESTITUTION,
+			float linearDamping = PhysicsManager.DEFAULT_LINEAR_DAMPING,
+			float angularDamping = PhysicsManager.DEFAULT_ANGULAR_DAMPING,
+			float friction = PhysicsManager.DEFAULT_FRICTION,
+			float rollingFriction = PhysicsManager.DEFAULT_ROLLING_FRICTION) {
+			Assure.NotNull(entities);
+			Assure.NotNull(shapeHandles);
+			Assure.Equal(entities.Count, shapeHandles.Count, "Every entity needs exactly one shape.");
+			if (entities.Count == 0) return;
+
+			LosgapSystem.InvokeOnMaster(() => {
+				RigidBodyDesc[] bodyDescs = new RigidBodyDesc[entities.Count];
+				for (int i = 0; i < entities.Count; ++i) {
+					Entity entity = entities[i];
+					lock (entity.InstanceMutationLock) {
+						if (entity.physicsBody != PhysicsBodyHandle.NULL) {
+							entity.physicsBody.Dispose();
+							entity.physicsBody = PhysicsBodyHandle.NULL;
+						}
+						if (entity.physicsShapeOffset == null) entity.physicsShapeOffset = new AlignedAllocation<Vector4>(TRANSFORM_ALIGNMENT, (uint) sizeof(Vector4));
+						entity.physicsShapeOffset.Value.Write(physicsShapeOffset);
+						bodyDescs[i] = new RigidBodyDesc(
+							shapeHandles[i],
+							mass,
+							disablePerformanceDeactivation,
+							forceIntransigence,
+							collideOnlyWithWorld,
+							collideWithOnlyDynamics,
+							entity.transform.AlignedPointer + 32,
+							entity.transform.AlignedPointer + 16,
+							entity.physicsShapeOffset.Value.AlignedPointer
+						);
+					}
+				}
+
+				PhysicsBodyHandle[] bodies = PhysicsManager.CreateRigidBodies(bodyDescs);
+				for (int i = 0; i < entities.Count; ++i) {
+					lock (entities[i].InstanceMutationLock) {
+						entities[i].physicsBody = bodies[i];
+					}
+				}
+			});
+
+			foreach (Entity entity in entities) {
+				entity.SetPhysicsProperties(restitution, linearDamping, angularDamping, friction, rollingFriction);
+			}
+		}
+
 		public void SetPhysicsProperties(
 			float restitution = PhysicsManager.DEFAULT_RESTITUTION,
 			float linearDamping = PhysicsManager.DEFAULT_LINEAR_DAMPING,
@@ -294,6 +355,21 @@ namespace Ophidian.Losgap.Entities {
 			PhysicsManager.SetBodyGravity(physicsBodyLocal, gravity);
 		}
 
+		/// <summary>
+		/// Tells the physics engine that this entity's (massless or intransigent) body will never move by itself, so that the broadphase
+		/// can stop updating it every tick. Intended for level geometry.
+		/// </summary>
+		public void MarkPhysicsBodyStatic() {
+			PhysicsBodyHandle physicsBodyLocal;
+			lock (InstanceMutationLock) {
+				if (physicsBody == PhysicsBodyHandle.NULL) {
+					throw new InvalidOperationException("Must set physics shape before using physics-based entity members.");
+				}
+				physicsBodyLocal = physicsBody;
+			}
+			PhysicsManager.SetBodyStatic(physicsBodyLocal);
+		}
+
 		public void EnableContinuousCollisionDetection(float minSpeedForCCD, float ccdProjectionRadius) {
 			PhysicsBodyHandle physicsBodyLocal;
 			lock (InstanceMutationLock) {
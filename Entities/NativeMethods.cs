@@ -22,9 +22,15 @@ namespace Ophidian.Losgap.Entities {
 			);
 
 		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
-			EntryPoint = "PhysicsManager_Tick")]
-		public static extern InteropBool PhysicsManager_Tick(
+			EntryPoint = "PhysicsManager_InitWithBroadphase")]
+		public static extern InteropBool PhysicsManager_InitWithBroadphase(
 			IntPtr failReason,
+			IntPtr broadphaseDesc // BroadphaseDesc*
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsManager_Tick")]
+		public static extern InteropErrorCode PhysicsManager_Tick(
 			float deltaTime
 			);
 
@@ -51,6 +57,13 @@ namespace Ophidian.Losgap.Entities {
 		#endregion
 
 		#region World
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsManager_SetBroadphase")]
+		public static extern InteropBool PhysicsManager_SetBroadphase(
+			IntPtr failReason,
+			IntPtr broadphaseDesc // BroadphaseDesc*
+			);
+
 		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
 			EntryPoint = "PhysicsManager_SetGravity")]
 		public static extern InteropBool PhysicsManager_SetGravity(
@@ -214,6 +227,30 @@ namespace Ophidian.Losgap.Entities {
 			IntPtr failReason,
 			PhysicsBodyHandle body
 			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsManager_CreateRigidBodiesBatch")]
+		public static extern InteropBool PhysicsManager_CreateRigidBodiesBatch(
+			IntPtr failReason,
+			IntPtr descArr, // RigidBodyDesc*
+			uint numBodies,
+			IntPtr outBodyHandleArr // PhysicsBodyHandle*
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsManager_DestroyRigidBodiesBatch")]
+		public static extern InteropBool PhysicsManager_DestroyRigidBodiesBatch(
+			IntPtr failReason,
+			IntPtr bodyHandleArr, // PhysicsBodyHandle*
+			uint numBodies
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsManager_SetBodyStatic")]
+		public static extern InteropBool PhysicsManager_SetBodyStatic(
+			IntPtr failReason,
+			PhysicsBodyHandle body
+			);
 		#endregion
 
 		#region Body Manipulation
@@ -341,5 +378,31 @@ namespace Ophidian.Losgap.Entities {
 			);
 		#endregion
 
+		#region Journal
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsJournal_BeginRecording")]
+		public static extern InteropBool PhysicsJournal_BeginRecording(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string journalFilePath
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsJournal_EndRecording")]
+		public static extern InteropBool PhysicsJournal_EndRecording(
+			IntPtr failReason
+			);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "PhysicsJournal_Replay")]
+		public static extern InteropBool PhysicsJournal_Replay(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string journalFilePath,
+			IntPtr broadphaseOverride, // BroadphaseDesc*
+			IntPtr outTimingArr, // PhysicsJournalTickTiming*
+			uint arrLen,
+			IntPtr outNumTicks // uint*
+			);
+		#endregion
+
 	}
 }
\ No newline at end of file
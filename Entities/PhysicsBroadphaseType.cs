@@ -0,0 +1,25 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 16:12 by Ben Bowen
+
+using System;
+
+namespace Ophidian.Losgap.Entities {
+	/// <summary>
+	/// The broadphase implementations that the physics world can be built on.
+	/// </summary>
+	public enum PhysicsBroadphaseType : uint {
+		/// <summary>
+		/// An incrementally-updated bounding volume tree. Needs no world bounds; the default.
+		/// </summary>
+		DynamicTree = 0U,
+		/// <summary>
+		/// Sweep-and-prune with 16-bit quantized bounds. Cheap for mostly-static worlds with fixed extents.
+		/// </summary>
+		AxisSweep16 = 1U,
+		/// <summary>
+		/// Sweep-and-prune with 32-bit quantized bounds, for large worlds or more than 32767 bodies.
+		/// </summary>
+		AxisSweep32 = 2U
+	}
+}
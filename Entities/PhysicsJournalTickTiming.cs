@@ -0,0 +1,23 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 11:02 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Entities {
+	/// <summary>
+	/// The cost of a single tick from a replayed physics journal.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+	public struct PhysicsJournalTickTiming {
+		public readonly uint TickIndex;
+		public readonly float DeltaTime;
+		public readonly double TickDurationMs;
+
+		public override string ToString() {
+			return "Tick " + TickIndex + " (dt " + DeltaTime + "s): " + TickDurationMs + "ms";
+		}
+	}
+}
@@ -405,6 +405,47 @@ namespace Ophidian.Losgap.Entities {
 			});
 		}
 
+		/// <summary>
+		/// Creates every described body in one native call. With the tree broadphase, the new bodies' pairs are found in one pass
+		/// over the rebuilt tree rather than one query per body. Prefer this over <see cref="CreateRigidBody"/> when loading levels.
+		/// </summary>
+		internal unsafe static PhysicsBodyHandle[] CreateRigidBodies(RigidBodyDesc[] bodyDescs) {
+			Assure.NotNull(bodyDescs);
+			PhysicsBodyHandle[] result = new PhysicsBodyHandle[bodyDescs.Length];
+			if (bodyDescs.Length == 0) return result;
+			LosgapSystem.InvokeOnMaster(() => {
+				fixed (RigidBodyDesc* descsPtr = bodyDescs) {
+					fixed (PhysicsBodyHandle* resultPtr = result) {
+						InteropUtils.CallNative(
+							NativeMethods.PhysicsManager_CreateRigidBodiesBatch,
+							(IntPtr) descsPtr,
+							(uint) bodyDescs.Length,
+							(IntPtr) resultPtr
+						).ThrowOnFailure();
+					}
+				}
+			});
+			return result;
+		}
+
+		/// <summary>
+		/// Destroys every given body in one native call. Like <see cref="CreateRigidBodies"/> (and unlike
+		/// <see cref="DestroyRigidBody"/>), this does not return until the bodies are gone.
+		/// </summary>
+		internal unsafe static void DestroyRigidBodies(PhysicsBodyHandle[] bodies) {
+			Assure.NotNull(bodies);
+			if (bodies.Length == 0) return;
+			LosgapSystem.InvokeOnMaster(() => {
+				fixed (PhysicsBodyHandle* bodiesPtr = bodies) {
+					InteropUtils.CallNative(
+						NativeMethods.PhysicsManager_DestroyRigidBodiesBatch,
+						(IntPtr) bodiesPtr,
+						(uint) bodies.Length
+					).ThrowOnFailure();
+				}
+			});
+		}
+
 		internal static void SetBodyProperties(PhysicsBodyHandle body,
 			float restitution,
 			float linearDamping,
@@ -586,11 +627,7 @@ namespace Ophidian.Losgap.Entities {
 
 		internal static void Tick(float deltaTime) {
 			// WARNING: No longer thread-safe
-			unsafe {
-				char* failReason = stackalloc char[InteropUtils.MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
-				bool success = NativeMethods.PhysicsManager_Tick((IntPtr) failReason, deltaTime);
-				if (!success) throw new NativeOperationFailedException(Marshal.PtrToStringUni((IntPtr) failReason));
-			}
+			NativeMethods.PhysicsManager_Tick(deltaTime).ThrowOnFailure();
 		}
 
 		internal static void UpdateBodyTransform(PhysicsBodyHandle bodyHandle) {
@@ -602,6 +639,113 @@ namespace Ophidian.Losgap.Entities {
 			}
 		}
 
+		/// <summary>
+		/// Starts logging every mutating physics call (and every tick) to a binary journal at the given path.
+		/// Must be called before the engine is started, so that the journal sees the world being created: once the physics world
+		/// exists, this throws a <see cref="NativeOperationFailedException"/>.
+		/// </summary>
+		/// <param name="journalFilePath">The file to write to. Any existing file is overwritten.</param>
+		public static void BeginJournalRecording(string journalFilePath) {
+			Assure.NotNull(journalFilePath);
+			InteropUtils.CallNative(
+				NativeMethods.PhysicsJournal_BeginRecording,
+				journalFilePath
+			).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Stops the journal started with <see cref="BeginJournalRecording"/> and flushes it to disk.
+		/// </summary>
+		public static void EndJournalRecording() {
+			InteropUtils.CallNative(
+				NativeMethods.PhysicsJournal_EndRecording
+			).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Replays a recorded journal on the calling thread, without rendering or any managed entities,
+		/// and returns the time taken by each recorded tick. The engine must not be running.
+		/// </summary>
+		/// <param name="journalFilePath">The journal to replay.</param>
+		/// <param name="maxTicks">The maximum number of tick timings to return.</param>
+		/// <param name="broadphaseOverride">If provided, replaces whichever broadphase the recorded session used.</param>
+		public static unsafe PhysicsJournalTickTiming[] ReplayJournal(string journalFilePath, uint maxTicks, BroadphaseDesc? broadphaseOverride = null) {
+			Assure.NotNull(journalFilePath);
+			PhysicsJournalTickTiming[] timings = new PhysicsJournalTickTiming[maxTicks];
+			uint outNumTicks;
+			AlignedAllocation<BroadphaseDesc>? overrideAligned = null;
+			if (broadphaseOverride != null) {
+				overrideAligned = new AlignedAllocation<BroadphaseDesc>(16L, (uint) sizeof(BroadphaseDesc));
+				*((BroadphaseDesc*) overrideAligned.Value.AlignedPointer) = broadphaseOverride.Value;
+			}
+			try {
+				fixed (PhysicsJournalTickTiming* timingsPtr = timings) {
+					InteropUtils.CallNative(
+						NativeMethods.PhysicsJournal_Replay,
+						journalFilePath,
+						overrideAligned != null ? overrideAligned.Value.AlignedPointer : IntPtr.Zero,
+						(IntPtr) timingsPtr,
+						maxTicks,
+						(IntPtr) (&outNumTicks)
+					).ThrowOnFailure();
+				}
+			}
+			finally {
+				if (overrideAligned != null) overrideAligned.Value.Dispose();
+			}
+			if (outNumTicks < maxTicks) Array.Resize(ref timings, (int) outNumTicks);
+			return timings;
+		}
+
+		/// <summary>
+		/// Replays the same journal once per candidate broadphase and returns the mean tick time (in milliseconds) for each,
+		/// in the same order as the candidates.
+		/// </summary>
+		/// <param name="journalFilePath">The journal to replay.</param>
+		/// <param name="maxTicks">The maximum number of ticks to replay per candidate.</param>
+		/// <param name="candidates">The broadphases to compare.</param>
+		public static double[] CompareBroadphases(string journalFilePath, uint maxTicks, params BroadphaseDesc[] candidates) {
+			Assure.NotNull(candidates);
+			double[] result = new double[candidates.Length];
+			for (int i = 0; i < candidates.Length; ++i) {
+				PhysicsJournalTickTiming[] timings = ReplayJournal(journalFilePath, maxTicks, candidates[i]);
+				result[i] = timings.Length > 0 ? timings.Average(t => t.TickDurationMs) : 0d;
+			}
+			return result;
+		}
+
+		/// <summary>
+		/// Replaces the physics world's broadphase. Any bodies that already exist are moved in to the new one. Intended to be called
+		/// when loading a level, which is also the time to supply world bounds derived from the level for the sweep-and-prune types.
+		/// </summary>
+		/// <param name="broadphaseDesc">The broadphase to switch to.</param>
+		public static unsafe void SetBroadphase(BroadphaseDesc broadphaseDesc) {
+			LosgapSystem.InvokeOnMaster(() => {
+				AlignedAllocation<BroadphaseDesc> descAligned = new AlignedAllocation<BroadphaseDesc>(16L, (uint) sizeof(BroadphaseDesc));
+				*((BroadphaseDesc*) descAligned.AlignedPointer) = broadphaseDesc;
+				try {
+					InteropUtils.CallNative(
+						NativeMethods.PhysicsManager_SetBroadphase,
+						descAligned.AlignedPointer
+					).ThrowOnFailure();
+				}
+				finally {
+					descAligned.Dispose();
+				}
+			});
+		}
+
+		/// <summary>
+		/// Marks a massless or intransigent body as static: it stops taking part in the per-tick AABB update, and the
+		/// broadphase treats it as fixed. Moving it afterwards through <see cref="UpdateBodyTransform"/> is still supported.
+		/// </summary>
+		internal static void SetBodyStatic(PhysicsBodyHandle body) {
+			LosgapSystem.InvokeOnMaster(() => InteropUtils.CallNative(
+				NativeMethods.PhysicsManager_SetBodyStatic,
+				body
+			).ThrowOnFailure());
+		}
+
 		public static void SetPhysicsTickrate(float tickrateHz) {
 			unsafe {
 				char* failReason = stackalloc char[InteropUtils.MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
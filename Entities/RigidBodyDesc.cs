@@ -0,0 +1,39 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 14:40 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Entities {
+	/// <summary>
+	/// Describes a single rigid body to be created through <see cref="PhysicsManager.CreateRigidBodies"/>.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+	internal struct RigidBodyDesc {
+		public readonly IntPtr TranslationPtr;
+		public readonly IntPtr RotationPtr;
+		public readonly IntPtr ShapeOffsetPtr;
+		public readonly PhysicsShapeHandle ShapeHandle;
+		public readonly float Mass;
+		public readonly InteropBool AlwaysActive;
+		public readonly InteropBool ForceIntransigence;
+		public readonly InteropBool CollideOnlyAgainstWorld;
+		public readonly InteropBool CollideAgainstDynamicsOnly;
+
+		public RigidBodyDesc(PhysicsShapeHandle shapeHandle, float mass, bool alwaysActive, bool forceIntransigence, bool collideOnlyAgainstWorld, bool collideAgainstDynamicsOnly, IntPtr translationPtr, IntPtr rotationPtr, IntPtr shapeOffsetPtr) {
+			Assure.GreaterThanOrEqualTo(mass, 0f);
+			if (collideOnlyAgainstWorld && collideAgainstDynamicsOnly) throw new ArgumentException("Can't collide against world and only dynamics simultaneously.");
+			TranslationPtr = translationPtr;
+			RotationPtr = rotationPtr;
+			ShapeOffsetPtr = shapeOffsetPtr;
+			ShapeHandle = shapeHandle;
+			Mass = mass;
+			AlwaysActive = alwaysActive;
+			ForceIntransigence = forceIntransigence;
+			CollideOnlyAgainstWorld = collideOnlyAgainstWorld;
+			CollideAgainstDynamicsOnly = collideAgainstDynamicsOnly;
+		}
+	}
+}
@@ -536,6 +536,7 @@ namespace Egodystonic.EscapeLizards {
 			AssetLocator.MainCamera = AssetLocator.MainGeometryPass.Input = AssetLocator.AlphaPass.Input = new Camera();
 			AssetLocator.ShadowcasterCamera = shadowPass.LightCam = new Camera();
 			AssetLocator.ShadowcasterCamera.OrthographicDimensions = new Vector3(1000f, 1000f, PhysicsManager.ONE_METRE_SCALED * 100f);
+			shadowPass.ReceiverCam = AssetLocator.MainCamera;
 			RenderingModule.AddRenderPass(shadowPass);
 			RenderingModule.AddRenderPass(AssetLocator.MainGeometryPass);
 			RenderingModule.AddRenderPass(AssetLocator.LightPass);
@@ -555,6 +556,9 @@ namespace Egodystonic.EscapeLizards {
 				coinModelVertices,
 				coinModelStream.GetIndices()
 			);
+			// Levels hold lots of coins, most of them a long way off: draw those with fewer triangles
+			gameObjectGCB.AddModelLOD(AssetLocator.LizardCoinModel, coinModelStream.GetLODIndices(0.5f), 0.08f);
+			gameObjectGCB.AddModelLOD(AssetLocator.LizardCoinModel, coinModelStream.GetLODIndices(0.2f), 0.03f);
 			AssetLocator.LizardCoinMaterial = new Material("Game Object Mat: Lizard Coin", AssetLocator.GeometryFragmentShader);
 			AssetLocator.LizardCoinMaterial.SetMaterialResource(
 				(ResourceViewBinding) AssetLocator.GeometryFragmentShader.GetBindingByIdentifier("DiffuseMap"),
@@ -1516,7 +1520,8 @@ namespace Egodystonic.EscapeLizards {
 
 				Logger.Log("Pretriangulating '" + fullFilePath + "'; storing data in '" + pretriangulationFileFullPath + "'...");
 				var loadedFile = LevelDescription.Load(fullFilePath, false);
-				var precalculatedData = loadedFile.PrecalculateGeometryTriangulation();
+				Dictionary<int, MeshClusterer.Cluster[]> precalculatedClusters;
+				var precalculatedData = loadedFile.PrecalculateGeometryTriangulation(out precalculatedClusters);
 
 				var fileStream = File.Open(pretriangulationFileFullPath, FileMode.Create, FileAccess.Write, FileShare.None);
 				BinaryWriter bw = new BinaryWriter(fileStream);
@@ -1541,6 +1546,7 @@ namespace Egodystonic.EscapeLizards {
 					}
 					foreach (var index in kvp.Value.Item2) bw.Write(index);
 				}
+				LevelDescription.WritePrecalculatedClusters(bw, precalculatedClusters);
 
 				fileStream.Dispose();
 				loadedFile.Dispose();
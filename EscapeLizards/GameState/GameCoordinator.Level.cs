@@ -772,6 +772,10 @@ namespace Egodystonic.EscapeLizards {
 		private const float EUSOCIAL_MOVEMENT_DISTANCE = PhysicsManager.ONE_METRE_SCALED * 7f;
 		private static readonly List<GeometryEntity> eusocialMovableEntities = new List<GeometryEntity>();
 		private static Vector3[] MAJOR_AXES = { Vector3.UP, Vector3.DOWN, Vector3.LEFT, Vector3.RIGHT, Vector3.FORWARD, Vector3.BACKWARD };
+		private const uint OCCLUSION_BUFFER_WIDTH = 256U;
+		private const uint OCCLUSION_BUFFER_HEIGHT = 128U;
+		private static OcclusionBuffer mainOcclusionBuffer;
+		private static OcclusionBuffer shadowOcclusionBuffer;
 
 		public static GameLevelDescription CurrentlyLoadedLevel {
 			get {
@@ -874,6 +878,7 @@ namespace Egodystonic.EscapeLizards {
 			}
 			currentLevelDataIsBaked = false;
 			lastIntroID = new LevelID(255, 255);
+			DisposeOcclusionBuffers();
 
 			Sounds_LevelFail(LevelFailReason.GameCancelled);
 			DisposeHUD();
@@ -899,11 +904,58 @@ namespace Egodystonic.EscapeLizards {
 			currentSkyLevel.ReinitializeAll();
 			currentGameLevel.ReinitializeAll();
 			currentGameLevel.PerformCalculations();	
+			GeometryCache.BuildStaticInstanceTrees();
+			SetUpOcclusionBuffers();
+
+			// Nothing that matters to the game exists outside the fall-out zone, so its extents are used as the sweep-and-prune world bounds.
+			// The bounds are taken from the sphere around the zone (with plenty of slack) so that they still hold when the board is tilted.
+			float physicsWorldRadius = (currentGameLevel.GameZoneRadii + Vector3.ONE * GameplayConstants.FALL_OUT_RADIUS_BUFFER).Length * 2f;
+			PhysicsManager.SetBroadphase(new BroadphaseDesc(
+				PhysicsBroadphaseType.AxisSweep32,
+				Vector3.ONE * -physicsWorldRadius,
+				Vector3.ONE * physicsWorldRadius
+			));
 
 			currentLevelDataIsBaked = true;
 
 			return true;
 		}
+
+		// The level's walls and terrain hide whatever is behind them from the main camera and the shadow caster camera (each of which needs
+		// its own buffer). The Eusocial level moves its geometry around, so nothing there is static enough to occlude.
+		private static void SetUpOcclusionBuffers() {
+			if (currentLevelIsEusocial) {
+				DisposeOcclusionBuffers();
+				return;
+			}
+			if (mainOcclusionBuffer == null) {
+				mainOcclusionBuffer = new OcclusionBuffer(OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT);
+				shadowOcclusionBuffer = new OcclusionBuffer(OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT);
+				AssetLocator.MainGeometryPass.OcclusionBuffer = mainOcclusionBuffer;
+				AssetLocator.MainGeometryPass.ShadowPass.OcclusionBuffer = shadowOcclusionBuffer;
+			}
+			mainOcclusionBuffer.ClearOccluders();
+			shadowOcclusionBuffer.ClearOccluders();
+			currentGameLevel.AddOccluders(mainOcclusionBuffer);
+			currentGameLevel.AddOccluders(shadowOcclusionBuffer);
+		}
+
+		private static void DisposeOcclusionBuffers() {
+			if (mainOcclusionBuffer == null) return;
+			AssetLocator.MainGeometryPass.OcclusionBuffer = null;
+			AssetLocator.MainGeometryPass.ShadowPass.OcclusionBuffer = null;
+			mainOcclusionBuffer.Dispose();
+			shadowOcclusionBuffer.Dispose();
+			mainOcclusionBuffer = null;
+			shadowOcclusionBuffer = null;
+		}
+
+		// The whole board tilts together, so the occluders are moved with it rather than added again
+		private static void SetOccluderTransform(Transform boardTransform) {
+			if (mainOcclusionBuffer == null) return;
+			mainOcclusionBuffer.OccluderTransform = boardTransform;
+			shadowOcclusionBuffer.OccluderTransform = boardTransform;
+		}
 		#endregion
 
 		#region Board Control
@@ -918,6 +970,7 @@ namespace Egodystonic.EscapeLizards {
 		private static readonly Sphere vultureEggSphere = new Sphere(Vector3.ZERO, GameplayConstants.VULTURE_EGG_COLLISION_RADIUS_MULTIPLIER * GameplayConstants.EGG_COLLISION_RADIUS);
 		private static Quaternion targetTilt;
 		private static Quaternion currentTilt;
+		private static Transform currentBoardTransform = Transform.DEFAULT_TRANSFORM;
 		private static EggEntity egg;
 		private static EggCameraBoom eggBoom;
 		private static Vector3 boardDownDir = Vector3.DOWN;
@@ -1373,6 +1426,8 @@ namespace Egodystonic.EscapeLizards {
 					else entity.RotateAround(pivotPoint, tiltThisFrame);
 				}
 				currentTilt *= tiltThisFrame;
+				currentBoardTransform = currentBoardTransform.RotateAround(pivotPoint, tiltThisFrame);
+				SetOccluderTransform(currentBoardTransform);
 
 				Vector3 newDrift = cameraAttracterEntity.Transform.Translation - initialCamAttracterPos;
 				Vector3 driftDelta = newDrift - currentBoardDrift;
@@ -1421,6 +1476,8 @@ namespace Egodystonic.EscapeLizards {
 			activeTilts.Clear();
 			targetTilt = Quaternion.IDENTITY;
 			currentTilt = Quaternion.IDENTITY;
+			currentBoardTransform = Transform.DEFAULT_TRANSFORM;
+			SetOccluderTransform(currentBoardTransform);
 			currentSkyLevel.AdjustSkyboxAccordingToDrift(-currentBoardDrift);
 			currentBoardDrift = Vector3.ZERO;
 			PhysicsManager.SetGravityOnAllBodies(Vector3.DOWN * GameplayConstants.GRAVITY_ACCELERATION);
@@ -203,6 +203,8 @@ namespace Egodystonic.EscapeLizards {
 						activePhysicsShapes.Clear();
 					}
 					List<PhysicsShapeHandle> unusedHandles = activePhysicsShapes.Values.Distinct().ToList();
+					List<Entity> physicalEntities = new List<Entity>();
+					List<PhysicsShapeHandle> physicalEntityShapes = new List<PhysicsShapeHandle>();
 					foreach (KeyValuePair<LevelGeometryEntity, GeometryEntity> kvp in currentGeometryEntities) {
 						PhysicsShapeHandle physicsShape = PhysicsShapeHandle.NULL;
 						if (kvp.Key.Geometry is LevelGeometry_Model) {
@@ -215,10 +217,15 @@ namespace Egodystonic.EscapeLizards {
 						}
 						if (physicsShape == PhysicsShapeHandle.NULL) physicsShape = kvp.Key.Geometry.CreatePhysicsShape(out physicsShapeOffset);
 						if (physicsShape == PhysicsShapeHandle.NULL) continue; // Some geometry is non-collidable (i.e. planes)
-						kvp.Value.SetPhysicsShape(physicsShape, Vector3.ZERO, LevelGeometry.GEOMETRY_MASS, forceIntransigence: true);
+						physicalEntities.Add(kvp.Value);
+						physicalEntityShapes.Add(physicsShape);
 						activePhysicsShapes[kvp.Key] = physicsShape;
 						if (!fullReset && unusedHandles.Contains(physicsShape)) unusedHandles.Remove(physicsShape);
 					}
+					Entity.SetPhysicsShapes(physicalEntities, physicalEntityShapes, Vector3.ZERO, LevelGeometry.GEOMETRY_MASS, forceIntransigence: true);
+					foreach (Entity physicalEntity in physicalEntities) {
+						if (!(physicalEntity is PresetMovementEntity)) physicalEntity.MarkPhysicsBodyStatic();
+					}
 
 					if (!fullReset) {
 						foreach (var unusedHandle in unusedHandles) {
@@ -248,6 +255,7 @@ namespace Egodystonic.EscapeLizards {
 			PhysicsShapeHandle physicsShape = activePhysicsShapes[levelGeometryEntity];
 			if (physicsShape == PhysicsShapeHandle.NULL) return; // Some geometry is non-collidable (i.e. planes)
 			rep.SetPhysicsShape(physicsShape, Vector3.ZERO, LevelGeometry.GEOMETRY_MASS, forceIntransigence: true);
+			if (!(rep is PresetMovementEntity)) rep.MarkPhysicsBodyStatic();
 
 			if (rep is PresetMovementEntity) {
 				foreach (LevelGameObject levelGameObject in GameObjects.Where(go => go.GroundingGeometryEntity == levelGeometryEntity)) {
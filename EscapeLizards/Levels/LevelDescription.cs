@@ -27,6 +27,8 @@ namespace Egodystonic.EscapeLizards {
 		private const string FILE_ELEMENT_NAME_GEOMETRY = "geometry";
 		private const string FILE_ELEMENT_NAME_MATERIALS = "materials";
 		private const string FILE_ELEMENT_NAME_GEOM_ENTITIES = "geomEntities";
+		private const int PTD_CLUSTER_SECTION_MARKER = 0x54534C43; // "CLST": optional, after the triangulated geometry
+		private const int MIN_CLUSTERED_TRIANGLES = (int) MeshClusterer.MAX_CLUSTER_TRIANGLES * 8; // Smaller geometry is drawn whole
 
 		protected readonly object instanceMutationLock = new object();
 		protected readonly List<LevelGeometry> geometry = new List<LevelGeometry>();
@@ -48,6 +50,7 @@ namespace Egodystonic.EscapeLizards {
 		protected readonly Dictionary<LevelGeometryEntity, GeometryEntity> currentGeometryEntities = new Dictionary<LevelGeometryEntity, GeometryEntity>();	
 
 		protected readonly Dictionary<int, Tuple<List<DefaultVertex>, List<uint>>> precalculatedTriangles = new Dictionary<int, Tuple<List<DefaultVertex>, List<uint>>>();
+		protected readonly Dictionary<int, MeshClusterer.Cluster[]> precalculatedClusters = new Dictionary<int, MeshClusterer.Cluster[]>();
 
 		public string Title {
 			get {
@@ -153,6 +156,29 @@ namespace Egodystonic.EscapeLizards {
 
 							loadedLevel.precalculatedTriangles.Add(geomID, Tuple.Create(vertexList, indexList));
 						}
+
+						if (fileStream.Position < fileStream.Length && br.ReadInt32() == PTD_CLUSTER_SECTION_MARKER) {
+							int clusteredGeomCount = br.ReadInt32();
+							for (int g = 0; g < clusteredGeomCount; ++g) {
+								int geomID = br.ReadInt32();
+								MeshClusterer.Cluster[] clusters = new MeshClusterer.Cluster[br.ReadInt32()];
+								for (int i = 0; i < clusters.Length; ++i) {
+									clusters[i] = new MeshClusterer.Cluster {
+										CenterX = br.ReadSingle(),
+										CenterY = br.ReadSingle(),
+										CenterZ = br.ReadSingle(),
+										Radius = br.ReadSingle(),
+										ConeAxisX = br.ReadSingle(),
+										ConeAxisY = br.ReadSingle(),
+										ConeAxisZ = br.ReadSingle(),
+										ConeCutoff = br.ReadSingle(),
+										FirstIndex = br.ReadUInt32(),
+										NumIndices = br.ReadUInt32()
+									};
+								}
+								loadedLevel.precalculatedClusters.Add(geomID, clusters);
+							}
+						}
 					}
 
 					GCSettings.LargeObjectHeapCompactionMode = GCLargeObjectHeapCompactionMode.CompactOnce;
@@ -458,17 +484,27 @@ namespace Egodystonic.EscapeLizards {
 						}
 					}
 
+					// Large geometry is split in to clusters so that only the parts in view are drawn; ideally that was done when the level
+					// was pretriangulated, but if not it's done now (except in the editor, where the cache is rebuilt after every change)
+					MeshClusterer.Cluster[] clusters;
+					if (!precalculatedClusters.TryGetValue(thisGeom.ID, out clusters) && !EntryPoint.InEditor) {
+						clusters = ClusterGeometry(outVertices, ref outIndices);
+					}
+
 					if (thisGeom is LevelGeometry_Model && thisGeom.Transform == Transform.DEFAULT_TRANSFORM) {
 						string filename = ((LevelGeometry_Model)thisGeom).ModelFileName;
 						if (cachedDefaultModelHandles.ContainsKey(filename)) currentModelHandles.Add(thisGeom, cachedDefaultModelHandles[filename]);
 						else {
 							var newHandle = gcb.AddModel(Title + "_Geometry_" + i + "_[" + thisGeom + "]", outVertices, outIndices);
+							if (clusters != null) gcb.AddModelClusters(newHandle, clusters);
 							currentModelHandles.Add(thisGeom, newHandle);
 							cachedDefaultModelHandles.Add(filename, newHandle);
 						}
 					}
 					else {
-						currentModelHandles.Add(thisGeom, gcb.AddModel(Title + "_Geometry_" + i + "_[" + thisGeom + "]", outVertices, outIndices));	
+						var newHandle = gcb.AddModel(Title + "_Geometry_" + i + "_[" + thisGeom + "]", outVertices, outIndices);
+						if (clusters != null) gcb.AddModelClusters(newHandle, clusters);
+						currentModelHandles.Add(thisGeom, newHandle);
 					}
 					
 					
@@ -519,8 +555,36 @@ namespace Egodystonic.EscapeLizards {
 			}
 		}
 
-		public Dictionary<int, Tuple<List<DefaultVertex>, List<uint>>> PrecalculateGeometryTriangulation() {
+		/// <summary>
+		/// Adds the level's static geometry (its walls and terrain, but not the skydome or anything that moves on its own) to the given
+		/// buffer as occluders, placed where the geometry starts.
+		/// </summary>
+		public void AddOccluders(OcclusionBuffer buffer) {
+			Assure.NotNull(buffer);
+			var geometryPositions = new Dictionary<LevelGeometry, Tuple<List<Vector3>, List<uint>>>();
+			lock (instanceMutationLock) {
+				foreach (LevelGeometryEntity levelEntity in levelGeometryEntities) {
+					if (!levelEntity.IsStatic || levelEntity.Geometry.IsSkydome) continue;
+					Tuple<List<Vector3>, List<uint>> triangles;
+					if (!geometryPositions.TryGetValue(levelEntity.Geometry, out triangles)) {
+						List<DefaultVertex> outVertices;
+						List<uint> outIndices;
+						if (precalculatedTriangles.ContainsKey(levelEntity.Geometry.ID)) {
+							outVertices = precalculatedTriangles[levelEntity.Geometry.ID].Item1;
+							outIndices = precalculatedTriangles[levelEntity.Geometry.ID].Item2;
+						}
+						else levelEntity.Geometry.GetVertexData(out outVertices, out outIndices);
+						triangles = Tuple.Create(outVertices.Select(v => v.Position).ToList(), outIndices);
+						geometryPositions.Add(levelEntity.Geometry, triangles);
+					}
+					buffer.AddOccluder(triangles.Item1, triangles.Item2, levelEntity.InitialMovementStep.Transform);
+				}
+			}
+		}
+
+		public Dictionary<int, Tuple<List<DefaultVertex>, List<uint>>> PrecalculateGeometryTriangulation(out Dictionary<int, MeshClusterer.Cluster[]> clusters) {
 			Dictionary<int, Tuple<List<DefaultVertex>, List<uint>>> result = new Dictionary<int, Tuple<List<DefaultVertex>, List<uint>>>();
+			clusters = new Dictionary<int, MeshClusterer.Cluster[]>();
 			for (int i = 0; i < geometry.Count; ++i) {
 				LevelGeometry thisGeom = geometry[i];
 				List<DefaultVertex> outVertices;
@@ -538,12 +602,46 @@ namespace Egodystonic.EscapeLizards {
 					}
 				}
 
+				if (!thisGeom.IsSkydome) {
+					MeshClusterer.Cluster[] geomClusters = ClusterGeometry(outVertices, ref outIndices);
+					if (geomClusters != null) clusters.Add(thisGeom.ID, geomClusters);
+				}
+
 				result.Add(thisGeom.ID, Tuple.Create(outVertices, outIndices));
 			}
 
 			return result;
 		}
 
+		public static void WritePrecalculatedClusters(BinaryWriter bw, Dictionary<int, MeshClusterer.Cluster[]> clusters) {
+			bw.Write(PTD_CLUSTER_SECTION_MARKER);
+			bw.Write(clusters.Count);
+			foreach (var kvp in clusters) {
+				bw.Write(kvp.Key);
+				bw.Write(kvp.Value.Length);
+				foreach (var cluster in kvp.Value) {
+					bw.Write(cluster.CenterX);
+					bw.Write(cluster.CenterY);
+					bw.Write(cluster.CenterZ);
+					bw.Write(cluster.Radius);
+					bw.Write(cluster.ConeAxisX);
+					bw.Write(cluster.ConeAxisY);
+					bw.Write(cluster.ConeAxisZ);
+					bw.Write(cluster.ConeCutoff);
+					bw.Write(cluster.FirstIndex);
+					bw.Write(cluster.NumIndices);
+				}
+			}
+		}
+
+		private static MeshClusterer.Cluster[] ClusterGeometry(List<DefaultVertex> vertices, ref List<uint> indices) {
+			if (indices.Count / 3 < MIN_CLUSTERED_TRIANGLES) return null;
+
+			MeshClusterer.Cluster[] result;
+			indices = MeshClusterer.BuildClusters(vertices.Select(v => v.Position).ToArray(), indices.ToArray(), out result).ToList();
+			return result;
+		}
+
 		public void RecreateMaterials() {
 			lock (instanceMutationLock) {
 				if (!materialsOutOfDate) return;
@@ -681,6 +779,7 @@ namespace Egodystonic.EscapeLizards {
 				textureViews.Clear();
 
 				precalculatedTriangles.Clear();
+				precalculatedClusters.Clear();
 			}
 
 			GCSettings.LargeObjectHeapCompactionMode = GCLargeObjectHeapCompactionMode.CompactOnce;
@@ -0,0 +1,144 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 02:48 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.AssetManagement {
+	[TestClass]
+	public class MeshSimplifierTest {
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		/// <summary>
+		/// A unit sphere around the origin with its triangles facing outwards. The poles and seam repeat their positions (as a textured
+		/// sphere's would), so the triangles touching the poles are degenerate until welded away.
+		/// </summary>
+		private static void CreateSphere(int numRings, int numSegments, out Vector3[] outPositions, out uint[] outIndices) {
+			List<Vector3> positions = new List<Vector3>();
+			List<uint> indices = new List<uint>();
+			for (int r = 0; r <= numRings; ++r) {
+				double polarAngle = Math.PI * r / numRings;
+				double ringRadius = r == 0 || r == numRings ? 0.0 : Math.Sin(polarAngle);
+				for (int s = 0; s <= numSegments; ++s) {
+					double azimuth = 2.0 * Math.PI * (s % numSegments) / numSegments;
+					positions.Add(new Vector3((float) (ringRadius * Math.Cos(azimuth)), (float) Math.Cos(polarAngle), (float) (ringRadius * Math.Sin(azimuth))));
+				}
+			}
+			for (int r = 0; r < numRings; ++r) {
+				for (int s = 0; s < numSegments; ++s) {
+					uint topLeft = (uint) (r * (numSegments + 1) + s);
+					uint bottomLeft = topLeft + (uint) (numSegments + 1);
+					indices.AddRange(new[] { topLeft, topLeft + 1U, bottomLeft + 1U, topLeft, bottomLeft + 1U, bottomLeft });
+				}
+			}
+			outPositions = positions.ToArray();
+			outIndices = indices.ToArray();
+		}
+
+		private static bool IsDegenerate(Vector3[] positions, uint[] indices, int triangle) {
+			Vector3 a = positions[indices[triangle * 3 + 0]];
+			Vector3 b = positions[indices[triangle * 3 + 1]];
+			Vector3 c = positions[indices[triangle * 3 + 2]];
+			return a.EqualsExactly(b) || b.EqualsExactly(c) || c.EqualsExactly(a);
+		}
+
+		private static HashSet<long> GetOpenEdges(uint[] indices) {
+			Dictionary<long, int> edgeCounts = new Dictionary<long, int>();
+			for (int i = 0; i < indices.Length; ++i) {
+				uint a = indices[i];
+				uint b = indices[i % 3 == 2 ? i - 2 : i + 1];
+				long edgeKey = a < b ? ((long) a << 32) | b : ((long) b << 32) | a;
+				int count;
+				edgeCounts.TryGetValue(edgeKey, out count);
+				edgeCounts[edgeKey] = count + 1;
+			}
+			return new HashSet<long>(edgeCounts.Where(kvp => kvp.Value == 1).Select(kvp => kvp.Key));
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestSimplifyReachesTriangleTarget() {
+			// Define variables and constants
+			const float TARGET_RATIO = 0.25f;
+			Vector3[] positions;
+			uint[] indices;
+
+			// Set up context
+			CreateSphere(16, 32, out positions, out indices);
+			int numLiveTriangles = Enumerable.Range(0, indices.Length / 3).Count(t => !IsDegenerate(positions, indices, t));
+
+			// Execute
+			uint[] result = MeshSimplifier.Simplify(positions, indices, TARGET_RATIO);
+
+			// Assert outcome
+			Assert.AreEqual(0, result.Length % 3);
+			Assert.AreEqual((int) (numLiveTriangles * TARGET_RATIO), result.Length / 3);
+			Assert.IsTrue(result.All(index => index < positions.Length));
+			Assert.IsFalse(Enumerable.Range(0, result.Length / 3).Any(t => IsDegenerate(positions, result, t)));
+			Assert.IsTrue(MeshSimplifier.Simplify(positions, indices, 1f).SequenceEqual(
+				Enumerable.Range(0, indices.Length / 3).Where(t => !IsDegenerate(positions, indices, t)).SelectMany(t => indices.Skip(t * 3).Take(3))
+			));
+		}
+
+		[TestMethod]
+		public void TestSimplifyDoesNotFlipTriangles() {
+			// Define variables and constants
+			float[] targetRatios = { 0.5f, 0.25f, 0.1f, 0.05f };
+			Vector3[] positions;
+			uint[] indices;
+
+			// Set up context
+			CreateSphere(16, 32, out positions, out indices);
+
+			foreach (float targetRatio in targetRatios) {
+				// Execute
+				uint[] result = MeshSimplifier.Simplify(positions, indices, targetRatio);
+
+				// Assert outcome
+				for (int i = 0; i < result.Length; i += 3) {
+					Vector3 a = positions[result[i + 0]];
+					Vector3 b = positions[result[i + 1]];
+					Vector3 c = positions[result[i + 2]];
+					Assert.IsTrue(Vector3.Dot(Vector3.Cross(b - a, c - a), a + b + c) > 0f, "Triangle " + (i / 3) + " faces inwards at ratio " + targetRatio + ".");
+				}
+			}
+		}
+
+		[TestMethod]
+		public void TestSimplifyKeepsBoundaryLocked() {
+			// Define variables and constants
+			const int GRID_SIZE = 17;
+			List<Vector3> positions = new List<Vector3>();
+			List<uint> indices = new List<uint>();
+
+			// Set up context
+			for (int z = 0; z < GRID_SIZE; ++z) {
+				for (int x = 0; x < GRID_SIZE; ++x) {
+					positions.Add(new Vector3(x, (float) (0.5 * Math.Sin(x * 0.4) * Math.Cos(z * 0.3)), z));
+				}
+			}
+			for (int z = 0; z < GRID_SIZE - 1; ++z) {
+				for (int x = 0; x < GRID_SIZE - 1; ++x) {
+					uint corner = (uint) (z * GRID_SIZE + x);
+					indices.AddRange(new[] { corner, corner + GRID_SIZE, corner + GRID_SIZE + 1U, corner, corner + GRID_SIZE + 1U, corner + 1U });
+				}
+			}
+			HashSet<long> originalOpenEdges = GetOpenEdges(indices.ToArray());
+
+			// Execute
+			uint[] result = MeshSimplifier.Simplify(positions, indices, 0.1f);
+
+			// Assert outcome
+			Assert.IsTrue(result.Length < indices.Count / 2);
+			Assert.AreEqual((GRID_SIZE - 1) * 4, originalOpenEdges.Count);
+			Assert.IsTrue(originalOpenEdges.SetEquals(GetOpenEdges(result)));
+		}
+		#endregion
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 20:47 by Ben Bowen
+
+using System;
+using System.Linq;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.Interop;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap {
+	[TestClass]
+	public class FrameArenaTest {
+
+		[TestInitialize]
+		public void SetUp() { }
+
+
+		#region Tests
+		[TestMethod]
+		public unsafe void TestReserveAndReset() {
+			// Define variables and constants
+			const uint NUM_SMALL_ALLOCATIONS = 1000U;
+			const uint LARGE_ALLOCATION_SIZE = 1024U * 1024U;
+
+			// Set up context
+			FrameArena.Reset();
+			IntPtr[] smallAllocations = new IntPtr[NUM_SMALL_ALLOCATIONS];
+
+			// Execute
+			for (uint i = 0U; i < NUM_SMALL_ALLOCATIONS; ++i) {
+				smallAllocations[i] = FrameArena.Reserve(i % 37U + 1U);
+				*(byte*) smallAllocations[i] = (byte) i;
+			}
+			byte* largeAllocation = (byte*) FrameArena.Reserve(LARGE_ALLOCATION_SIZE);
+			largeAllocation[LARGE_ALLOCATION_SIZE - 1U] = 0xAB;
+
+			// Assert outcome
+			for (uint i = 0U; i < NUM_SMALL_ALLOCATIONS; ++i) {
+				Assert.AreEqual(0L, (long) smallAllocations[i] % 16L);
+				Assert.AreEqual((byte) i, *(byte*) smallAllocations[i]);
+				if (i > 0U) Assert.AreNotEqual(smallAllocations[i - 1U], smallAllocations[i]);
+			}
+			Assert.AreEqual(0L, (long) largeAllocation % 16L);
+			Assert.AreEqual((byte) 0xAB, largeAllocation[LARGE_ALLOCATION_SIZE - 1U]);
+			Assert.IsTrue(FrameArena.HighWaterMark >= LARGE_ALLOCATION_SIZE);
+
+			FrameArena.Reset();
+			IntPtr firstAfterReset = FrameArena.Reserve(1U);
+			FrameArena.Reset();
+			Assert.AreEqual(firstAfterReset, FrameArena.Reserve(1U));
+			FrameArena.Reset();
+		}
+
+		[TestMethod]
+		public void TestResetSetsHighWaterMarkGauge() {
+			// Define variables and constants
+			const string GAUGE_NAME = "Core.FrameArenaHighWaterMark";
+
+			// Set up context
+			uint gaugeID = NativeMetrics.Register(GAUGE_NAME, NativeMetricType.Gauge);
+			FrameArena.Reset();
+			NativeMetrics.Enabled = true;
+			NativeMetrics.Record(gaugeID, 0L);
+
+			// Execute
+			FrameArena.Reserve(64U);
+			FrameArena.Reset(); // Nothing was retired, so this takes the managed path
+			NativeMetric[] snapshot = NativeMetrics.Snapshot();
+			NativeMetrics.Enabled = false;
+
+			// Assert outcome
+			Assert.AreEqual((long) FrameArena.HighWaterMark, snapshot.Single(m => m.Name == GAUGE_NAME).Sum);
+			Assert.IsTrue(FrameArena.HighWaterMark >= 64UL);
+		}
+		#endregion
+	}
+}
@@ -29,6 +29,57 @@ namespace Ophidian.Losgap {
 			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string customFailureMessage
 		);
 
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ReturnFastSuccess")]
+		private static extern InteropErrorCode ReturnFastSuccess();
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ReturnFastFailure")]
+		private static extern InteropErrorCode ReturnFastFailure(
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string customFailureMessage
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "JobSystem_Init")]
+		private static extern InteropBool JobSystem_Init(
+			IntPtr failReason,
+			uint numWorkers,
+			IntPtr affinityMaskArr
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "JobSystem_Shutdown")]
+		private static extern InteropBool JobSystem_Shutdown(
+			IntPtr failReason
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "JobSystemParallelSum")]
+		private static extern InteropBool JobSystemParallelSum(
+			IntPtr failReason,
+			uint numIterations,
+			uint blockSize,
+			IntPtr outSum
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "LosgapStringRoundTrip")]
+		private static extern InteropBool LosgapStringRoundTrip(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string input,
+			IntPtr outBuffer,
+			uint bufferLen
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "BenchmarkLosgapString")]
+		private static extern InteropBool BenchmarkLosgapString(
+			IntPtr failReason,
+			uint numIterations,
+			IntPtr outLegacyMs,
+			IntPtr outCurrentMs
+		);
+
 		[TestInitialize]
 		public void SetUp() { }
 
@@ -145,6 +196,173 @@ namespace Ophidian.Losgap {
 			Assert.IsNull(null, successNCR.FailureMessage);
 			Assert.AreEqual(manualFailureMessage, failureNCR.FailureMessage);
 		}
+
+		[TestMethod]
+		public void TestFastConventionErrorCodes() {
+			// Define variables and constants
+			const string EXPECTED_FAIL_REASON = "Fast failure.";
+
+			// Set up context
+
+
+			// Execute
+			InteropErrorCode successCode = ReturnFastSuccess();
+			InteropErrorCode failureCode = ReturnFastFailure(EXPECTED_FAIL_REASON);
+			string failureMessage = null;
+			try {
+				failureCode.ThrowOnFailure();
+			}
+			catch (NativeOperationFailedException e) {
+				failureMessage = e.Message;
+			}
+
+			// Assert outcome
+			Assert.AreEqual(InteropErrorCode.None, successCode);
+			Assert.AreEqual(InteropErrorCode.LosgapException, failureCode);
+			Assert.AreEqual(EXPECTED_FAIL_REASON, failureMessage);
+			successCode.ThrowOnFailure();
+		}
+
+		[TestMethod]
+		public unsafe void TestJobSystemParallelFor() {
+			// Define variables and constants
+			const uint NUM_ITERATIONS = 100000U;
+			const ulong EXPECTED_SUM = (NUM_ITERATIONS * (ulong) (NUM_ITERATIONS - 1U)) / 2UL;
+			uint[] blockSizes = { 1U, 7U, 1000U, NUM_ITERATIONS * 2U };
+
+			// Set up context
+			ulong serialSum;
+			InteropUtils.CallNative(JobSystemParallelSum, NUM_ITERATIONS, 100U, (IntPtr) (&serialSum)).ThrowOnFailure();
+			InteropUtils.CallNative(JobSystem_Init, (uint) Environment.ProcessorCount, IntPtr.Zero).ThrowOnFailure();
+
+			// Execute
+			ulong[] parallelSums = new ulong[blockSizes.Length];
+			try {
+				for (int i = 0; i < blockSizes.Length; ++i) {
+					ulong sum;
+					InteropUtils.CallNative(JobSystemParallelSum, NUM_ITERATIONS, blockSizes[i], (IntPtr) (&sum)).ThrowOnFailure();
+					parallelSums[i] = sum;
+				}
+			}
+			finally {
+				InteropUtils.CallNative(JobSystem_Shutdown).ThrowOnFailure();
+			}
+
+			// Assert outcome
+			Assert.AreEqual(EXPECTED_SUM, serialSum);
+			foreach (ulong sum in parallelSums) {
+				Assert.AreEqual(EXPECTED_SUM, sum);
+			}
+		}
+
+		[TestMethod]
+		public unsafe void TestLosgapStringUTFRoundTrip() {
+			// Define variables and constants
+			const uint BUFFER_LEN = 128U;
+			string[] inputs = {
+				String.Empty,
+				"Short",
+				"A string that is far too long to be stored inline in a LosgapString",
+				"Zw\u00f6lf Boxk\u00e4mpfer",
+				"\u8725\u8734\u9003\u8131",
+				"Surrogates: \ud83e\udd8e \ud83d\udc0d"
+			};
+
+			// Set up context
+			char* buffer = stackalloc char[(int) BUFFER_LEN];
+
+			// Execute
+			string[] outputs = new string[inputs.Length];
+			for (int i = 0; i < inputs.Length; ++i) {
+				InteropUtils.CallNative(LosgapStringRoundTrip, inputs[i], (IntPtr) buffer, BUFFER_LEN).ThrowOnFailure();
+				outputs[i] = new string(buffer);
+			}
+
+			// Assert outcome
+			for (int i = 0; i < inputs.Length; ++i) {
+				Assert.AreEqual(inputs[i], outputs[i]);
+			}
+		}
+
+		[TestMethod, TestCategory("Benchmark")]
+		public unsafe void TestLosgapStringBenchmark() {
+			// Define variables and constants
+			const uint NUM_ITERATIONS = 100000U;
+
+			// Set up context
+			double legacyMs, currentMs;
+
+			// Execute
+			InteropUtils.CallNative(BenchmarkLosgapString, NUM_ITERATIONS, (IntPtr) (&legacyMs), (IntPtr) (&currentMs)).ThrowOnFailure();
+			Console.WriteLine("Legacy: " + legacyMs + "ms; Current: " + currentMs + "ms");
+
+			// Assert outcome (the timings are only reported: which is faster depends on the machine and its load, not on correctness)
+			Assert.IsTrue(legacyMs >= 0d && currentMs >= 0d);
+		}
+
+		[TestMethod]
+		public void TestNativeMetrics() {
+			// Define variables and constants
+			const string COUNTER_NAME = "Tests.Counter";
+			const string HISTOGRAM_NAME = "Tests.Histogram";
+			long[] histogramValues = { 0L, 1L, 3L, 3L, 1000L };
+
+			// Set up context
+			uint counterID = NativeMetrics.Register(COUNTER_NAME, NativeMetricType.Counter);
+			uint histogramID = NativeMetrics.Register(HISTOGRAM_NAME, NativeMetricType.Histogram);
+			NativeMetrics.Enabled = true;
+			NativeMetrics.Snapshot(true);
+
+			// Execute
+			NativeMetrics.Record(counterID, 5L);
+			NativeMetrics.Record(counterID, 2L);
+			foreach (long value in histogramValues) NativeMetrics.Record(histogramID, value);
+			NativeMetric[] snapshot = NativeMetrics.Snapshot(true);
+			NativeMetric[] snapshotAfterReset = NativeMetrics.Snapshot();
+			NativeMetrics.Enabled = false;
+
+			// Assert outcome
+			Assert.AreEqual(counterID, NativeMetrics.Register(COUNTER_NAME, NativeMetricType.Counter));
+			NativeMetric counter = snapshot.Single(m => m.Name == COUNTER_NAME);
+			NativeMetric histogram = snapshot.Single(m => m.Name == HISTOGRAM_NAME);
+			Assert.AreEqual(7L, counter.Sum);
+			Assert.AreEqual((ulong) histogramValues.Length, histogram.Count);
+			Assert.AreEqual(histogramValues.Sum(), histogram.Sum);
+			Assert.AreEqual(1UL, histogram.GetBucketCount(0));
+			Assert.AreEqual(1UL, histogram.GetBucketCount(1));
+			Assert.AreEqual(2UL, histogram.GetBucketCount(2));
+			Assert.AreEqual(1UL, histogram.GetBucketCount(10));
+			Assert.AreEqual(0L, snapshotAfterReset.Single(m => m.Name == COUNTER_NAME).Sum);
+			Assert.AreEqual(0UL, snapshotAfterReset.Single(m => m.Name == HISTOGRAM_NAME).Count);
+		}
+
+		[TestMethod]
+		public void TestNativeTraceChromeOutput() {
+			// Define variables and constants
+			const string EVENT_NAME = "Tests.\"Quoted\" Event";
+			string traceFilePath = Path.Combine(Path.GetTempPath(), "NativeTraceTest.json");
+
+			// Set up context
+			IntPtr nameHandle = NativeTrace.RegisterName(EVENT_NAME);
+			NativeTrace.Clear();
+			NativeTrace.Enabled = true;
+
+			// Execute
+			NativeTrace.Begin(nameHandle);
+			NativeTrace.End(nameHandle);
+			NativeTrace.Enabled = false;
+			NativeTrace.Begin(nameHandle);
+			NativeTrace.WriteChromeTrace(traceFilePath);
+			string traceFileContents = File.ReadAllText(traceFilePath);
+			File.Delete(traceFilePath);
+
+			// Assert outcome
+			Assert.AreEqual(nameHandle, NativeTrace.RegisterName(EVENT_NAME));
+			Assert.IsTrue(traceFileContents.StartsWith("{\"traceEvents\":["));
+			Assert.AreEqual(1, traceFileContents.Split(new[] { "\"ph\":\"B\"" }, StringSplitOptions.None).Length - 1);
+			Assert.AreEqual(1, traceFileContents.Split(new[] { "\"ph\":\"E\"" }, StringSplitOptions.None).Length - 1);
+			Assert.IsTrue(traceFileContents.Contains("\"name\":\"Tests.\\\"Quoted\\\" Event\""));
+		}
 		#endregion
 	}
 }
\ No newline at end of file
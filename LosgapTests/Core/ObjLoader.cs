@@ -0,0 +1,309 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 03:06 by Ben Bowen
+
+using System;
+using System.Globalization;
+using System.Linq;
+using System.Text;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.AssetManagement;
+using Ophidian.Losgap.Interop;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap {
+	[TestClass]
+	public class ObjLoaderTest {
+
+		private struct TestVertex {
+			public readonly Vector3 Position;
+			public readonly Vector3 Normal;
+			public readonly Vector3 Tangent;
+			public readonly Vector2 TexCoord;
+
+			public TestVertex(Vector3 position, Vector3 normal, Vector2 texCoord) : this(position, normal, Vector3.ZERO, texCoord) { }
+
+			public TestVertex(Vector3 position, Vector3 normal, Vector3 tangent, Vector2 texCoord) {
+				Position = position;
+				Normal = normal;
+				Tangent = tangent;
+				TexCoord = texCoord;
+			}
+		}
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		private static TestVertex[] GetVerticesWithoutTangents(ModelDataStream model) {
+			return model.GetVerticesWithoutTangents<TestVertex>(
+				typeof(TestVertex).GetConstructor(new[] { typeof(Vector3), typeof(Vector3), typeof(Vector2) })
+			);
+		}
+
+		private static TestVertex[] GetVertices(ModelDataStream model) {
+			return model.GetVertices<TestVertex>(
+				typeof(TestVertex).GetConstructor(new[] { typeof(Vector3), typeof(Vector3), typeof(Vector3), typeof(Vector2) })
+			);
+		}
+
+		/// <summary>
+		/// A decimal number with an optional sign, point and exponent, in any of the forms that OBJ exporters write.
+		/// </summary>
+		private static string CreateRandomFloatString(Random random) {
+			StringBuilder result = new StringBuilder();
+			switch (random.Next(3)) {
+				case 0: result.Append('-'); break;
+				case 1: result.Append('+'); break;
+			}
+			int numIntegerDigits = random.Next(13);
+			int numFractionDigits = random.Next(13);
+			if (numIntegerDigits == 0 && numFractionDigits == 0) numIntegerDigits = 1;
+			for (int i = 0; i < numIntegerDigits; ++i) result.Append((char) ('0' + random.Next(10)));
+			if (numFractionDigits > 0 || random.Next(2) == 0) result.Append('.');
+			for (int i = 0; i < numFractionDigits; ++i) result.Append((char) ('0' + random.Next(10)));
+			if (random.Next(3) == 0) {
+				result.Append(random.Next(2) == 0 ? 'e' : 'E');
+				result.Append(random.Next(-20, 21));
+			}
+			return result.ToString();
+		}
+
+		private static int GetULPDistance(float a, float b) {
+			if (a == b) return 0; // Also treats -0 and 0 as equal
+			int aBits = BitConverter.ToInt32(BitConverter.GetBytes(a), 0);
+			int bBits = BitConverter.ToInt32(BitConverter.GetBytes(b), 0);
+			if ((aBits < 0) != (bBits < 0)) return Int32.MaxValue;
+			return Math.Abs(aBits - bBits);
+		}
+
+		private static void AssertParseFails(string objText, int expectedLineNumber) {
+			try {
+				AssetLoader.ParseObj(objText);
+				Assert.Fail("Expected parsing to fail on line " + expectedLineNumber + ".");
+			}
+			catch (NativeOperationFailedException e) {
+				Assert.IsTrue(e.Message.Contains("line " + expectedLineNumber + " "), e.Message);
+			}
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestFloatsMatchFloatParse() {
+			// Define variables and constants
+			const int NUM_FACES = 1000;
+			Random random = new Random(20161020);
+			string[] floatStrings = new string[NUM_FACES * 9];
+			for (int i = 0; i < floatStrings.Length; ++i) floatStrings[i] = CreateRandomFloatString(random);
+			StringBuilder objText = new StringBuilder();
+			for (int f = 0; f < NUM_FACES; ++f) {
+				for (int v = 0; v < 3; ++v) {
+					int firstString = f * 9 + v * 3;
+					objText.AppendLine("v " + floatStrings[firstString] + " " + floatStrings[firstString + 1] + " " + floatStrings[firstString + 2]);
+				}
+				objText.AppendLine("f -3 -2 -1");
+			}
+
+			// Set up context
+			TestVertex[] vertices = GetVerticesWithoutTangents(AssetLoader.ParseObj(objText.ToString()));
+
+			// Execute
+			float[] parsedFloats = vertices.SelectMany(v => new[] { v.Position.X, v.Position.Y, v.Position.Z }).ToArray();
+
+			// Assert outcome
+			Assert.AreEqual(floatStrings.Length, parsedFloats.Length);
+			for (int i = 0; i < floatStrings.Length; ++i) {
+				float expected = Single.Parse(floatStrings[i], CultureInfo.InvariantCulture);
+				Assert.IsTrue(
+					GetULPDistance(expected, parsedFloats[i]) <= 1,
+					"'" + floatStrings[i] + "' parsed as " + parsedFloats[i].ToString("R") + " instead of " + expected.ToString("R") + "."
+				);
+			}
+		}
+
+		[TestMethod]
+		public void TestNegativeIndices() {
+			// Define variables and constants
+			const string OBJ_TEXT = "v 0 0 0\n" +
+				"v 1 0 0\n" +
+				"v 2 0 0\n" +
+				"v 3 0 0\n" +
+				"f -4 -3 -2\n" +
+				"v 4 0 0\n" +
+				"f -1 -2 -5\n";
+
+			// Set up context
+			ModelDataStream model = AssetLoader.ParseObj(OBJ_TEXT);
+
+			// Execute
+			TestVertex[] vertices = GetVerticesWithoutTangents(model);
+			uint[] indices = model.GetIndices();
+
+			// Assert outcome
+			Assert.AreEqual(6, indices.Length);
+			float[] expectedX = { 0f, 1f, 2f, 4f, 3f, 0f };
+			for (int i = 0; i < indices.Length; ++i) {
+				Assert.AreEqual(expectedX[i], vertices[indices[i]].Position.X);
+			}
+
+			AssertParseFails(OBJ_TEXT + "f -1 -2 -6\n", 8);
+		}
+
+		[TestMethod]
+		public void TestFaceCornerForms() {
+			// Define variables and constants
+			const string OBJ_TEXT = "v 0 0 0\n" +
+				"v 1 0 0\n" +
+				"v 0 1 0\n" +
+				"vt 0.25 0.75\n" +
+				"vt 0.5 0\n" +
+				"vn 0 0 -1\n" +
+				"vn 0 1 0\n" +
+				"f 1//1 2//1 3//2\n" +
+				"f 1/1 2/2 3/1\n" +
+				"f 1/2/2 2/1/1 3/2/1\n";
+
+			// Set up context
+			ModelDataStream model = AssetLoader.ParseObj(OBJ_TEXT);
+
+			// Execute
+			TestVertex[] vertices = GetVerticesWithoutTangents(model);
+			uint[] indices = model.GetIndices();
+
+			// Assert outcome
+			// Corners that leave out the tex coord or normal use the first, so they share vertices with corners that name it
+			Assert.AreEqual(7, vertices.Length);
+			Assert.AreEqual(9, indices.Length);
+			Assert.AreEqual(indices[0], indices[3]);
+			Assert.AreEqual(indices[1], indices[7]);
+
+			// v//n
+			Assert.AreEqual(Vector3.BACKWARD, vertices[indices[0]].Normal);
+			Assert.AreEqual(Vector3.BACKWARD, vertices[indices[1]].Normal);
+			Assert.AreEqual(Vector3.UP, vertices[indices[2]].Normal);
+			Assert.AreEqual(new Vector2(0.25f, 0.25f), vertices[indices[0]].TexCoord);
+
+			// v/t (with V flipped)
+			Assert.AreEqual(new Vector2(0.25f, 0.25f), vertices[indices[3]].TexCoord);
+			Assert.AreEqual(new Vector2(0.5f, 1f), vertices[indices[4]].TexCoord);
+			Assert.AreEqual(new Vector2(0.25f, 0.25f), vertices[indices[5]].TexCoord);
+			Assert.AreEqual(Vector3.BACKWARD, vertices[indices[3]].Normal);
+
+			// v/t/n
+			Assert.AreEqual(new Vector2(0.5f, 1f), vertices[indices[6]].TexCoord);
+			Assert.AreEqual(Vector3.UP, vertices[indices[6]].Normal);
+			Assert.AreEqual(new Vector3(1f, 0f, 0f), vertices[indices[7]].Position);
+			Assert.AreEqual(Vector3.BACKWARD, vertices[indices[8]].Normal);
+		}
+
+		[TestMethod]
+		public void TestDeduplication() {
+			// Define variables and constants
+			const string OBJ_TEXT = "v 0 0 0\n" +
+				"v 1 0 0\n" +
+				"v 1 1 0\n" +
+				"v 0 1 0\n" +
+				"vt 0 0\n" +
+				"vn 0 0 -1\n" +
+				"vn 0 0 1\n" +
+				"f 1/1/1 2/1/1 3/1/1\n" +
+				"f 1/1/1 3/1/1 4/1/1\n" +
+				"f 1/1/2 3/1/2 2/1/2\n";
+
+			// Set up context
+			ModelDataStream model = AssetLoader.ParseObj(OBJ_TEXT);
+
+			// Execute
+			uint[] indices = model.GetIndices();
+
+			// Assert outcome
+			Assert.AreEqual(7U, model.NumVertices); // 4 shared by the first two faces, 3 more for the third's other normal
+			Assert.AreEqual(9, indices.Length);
+			Assert.AreEqual(indices[0], indices[3]);
+			Assert.AreEqual(indices[2], indices[4]);
+			Assert.AreNotEqual(indices[0], indices[6]);
+			Assert.AreNotEqual(indices[2], indices[7]);
+		}
+
+		[TestMethod]
+		public void TestErrorsGiveLineNumbers() {
+			const string POSITIONS = "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+
+			AssertParseFails(POSITIONS + "f 1 2 4\n", 4);
+			AssertParseFails(POSITIONS + "# comment\n\nf 1 2 0\n", 6);
+			AssertParseFails(POSITIONS + "f 1/1 2/1 3/1\n", 4);
+			AssertParseFails(POSITIONS + "f 1//1 2//1 3//1\n", 4);
+			AssertParseFails(POSITIONS + "f 1 2 x\n", 4);
+			AssertParseFails(POSITIONS + "f 1 2 3a\n", 4);
+			AssertParseFails(POSITIONS + "f 1 2\n", 4);
+			AssertParseFails("v 0 0\n", 1);
+			AssertParseFails(POSITIONS + "vn 0 1\n", 4);
+			AssertParseFails("v 0 0 0\r\nv 1 0 0\r\nv 0 1 0\r\nf 1 2 3\r\nf 1 2 3 5\r\n", 5);
+		}
+
+		[TestMethod]
+		public void TestCube() {
+			// Define variables and constants
+			const string OBJ_TEXT = "o Cube\n" +
+				"v -1 -1 -1\n" +
+				"v 1 -1 -1\n" +
+				"v 1 1 -1\n" +
+				"v -1 1 -1\n" +
+				"v -1 -1 1\n" +
+				"v 1 -1 1\n" +
+				"v 1 1 1\n" +
+				"v -1 1 1\n" +
+				"s off\n" +
+				"f 1 4 3 2\n" +
+				"f 5 6 7 8\n" +
+				"f 1 5 8 4\n" +
+				"f 2 3 7 6\n" +
+				"f 1 2 6 5\n" +
+				"f 4 8 7 3\n";
+
+			// Set up context
+			ModelDataStream model = AssetLoader.ParseObj(OBJ_TEXT);
+
+			// Execute
+			uint[] indices = model.GetIndices();
+			TestVertex[] vertices = GetVerticesWithoutTangents(model);
+
+			// Assert outcome
+			Assert.AreEqual(8U, model.NumVertices);
+			Assert.AreEqual(36, indices.Length);
+			Assert.IsTrue(indices.All(i => i < 8U));
+			Assert.AreEqual(8, vertices.Select(v => v.Position).Distinct().Count());
+		}
+
+		[TestMethod]
+		public void TestGetVerticesAveragesTangents() {
+			// Define variables and constants
+			// Both triangles share their first corner; U runs along X across the first and along Y across the second
+			const string OBJ_TEXT = "v 0 0 0\n" +
+				"v 1 0 0\n" +
+				"v 0 1 0\n" +
+				"v 0 2 0\n" +
+				"v -1 0 0\n" +
+				"vt 0 0\n" +
+				"vt 1 0\n" +
+				"vt 0 1\n" +
+				"f 1/1 2/2 3/3\n" +
+				"f 1/1 4/2 5/3\n";
+
+			// Set up context
+			ModelDataStream model = AssetLoader.ParseObj(OBJ_TEXT);
+
+			// Execute
+			TestVertex[] vertices = GetVertices(model);
+
+			// Assert outcome
+			Assert.AreEqual(5, vertices.Length);
+			Assert.IsTrue(vertices[0].Tangent.EqualsWithTolerance(new Vector3(1f, 1f, 0f).ToUnit(), 0.0001f), vertices[0].Tangent.ToString());
+			Assert.IsTrue(vertices[1].Tangent.EqualsWithTolerance(Vector3.RIGHT, 0.0001f), vertices[1].Tangent.ToString());
+			Assert.IsTrue(vertices[2].Tangent.EqualsWithTolerance(Vector3.RIGHT, 0.0001f), vertices[2].Tangent.ToString());
+			Assert.IsTrue(vertices[3].Tangent.EqualsWithTolerance(Vector3.UP, 0.0001f), vertices[3].Tangent.ToString());
+			Assert.IsTrue(vertices[4].Tangent.EqualsWithTolerance(Vector3.UP, 0.0001f), vertices[4].Tangent.ToString());
+			Assert.IsTrue(vertices.All(v => v.Normal == Vector3.BACKWARD));
+		}
+		#endregion
+	}
+}
@@ -0,0 +1,226 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:44 by Ben Bowen
+
+using System;
+using System.Linq;
+using System.Runtime.InteropServices;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.Interop;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class FrustumCullerTest {
+		private const string NATIVE_DLL_NAME = "RenderingNative.dll";
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "CullSpheresScalar")]
+		private static extern InteropBool CullSpheresScalar(
+			IntPtr failReason,
+			IntPtr frustum, // FrustumPlanes*
+			IntPtr sphereArr, // BoundingSphere*
+			uint numSpheres,
+			IntPtr outVisibleIndices, // uint*
+			IntPtr outNumVisible // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "BenchmarkFrustumCuller")]
+		private static extern InteropBool BenchmarkFrustumCuller(
+			IntPtr failReason,
+			IntPtr frustum, // FrustumPlanes*
+			IntPtr sphereArr, // BoundingSphere*
+			uint numSpheres,
+			uint numIterations,
+			IntPtr outScalarMs,
+			IntPtr outSIMDMs
+		);
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		private static FrustumCuller.FrustumPlanes CreateTestFrustum() {
+			return FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+		}
+
+		private static FrustumCuller.BoundingSphere[] CreateRandomSpheres(int numSpheres) {
+			Random random = new Random(1);
+			FrustumCuller.BoundingSphere[] result = new FrustumCuller.BoundingSphere[numSpheres];
+			for (int i = 0; i < numSpheres; ++i) {
+				result[i] = new FrustumCuller.BoundingSphere(
+					new Vector3((float) random.NextDouble() * 240f - 120f, (float) random.NextDouble() * 240f - 120f, (float) random.NextDouble() * 240f - 120f),
+					(float) random.NextDouble() * 5f
+				);
+			}
+			return result;
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestCullSpheres() {
+			// Define variables and constants
+			FrustumCuller.BoundingSphere[] spheres = {
+				new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, 10f), 1f), // Inside
+				new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, -10f), 1f), // Behind
+				new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, 0.5f), 0.6f), // Crossing the near plane
+				new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, 0.5f), 0.4f), // Just in front of the near plane
+				new FrustumCuller.BoundingSphere(new Vector3(50f, 0f, 10f), 1f), // Far off to the right
+				new FrustumCuller.BoundingSphere(new Vector3(11.5f, 0f, 10f), 1f), // Just off to the right
+				new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, 150f), 1f), // Beyond the far plane
+				new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, 100.5f), 1f) // Crossing the far plane
+			};
+			uint[] visibleIndices = new uint[spheres.Length];
+
+			// Set up context
+			FrustumCuller.FrustumPlanes frustum = CreateTestFrustum();
+
+			// Execute
+			uint numVisible = FrustumCuller.CullSpheres(frustum, spheres, (uint) spheres.Length, visibleIndices);
+
+			// Assert outcome
+			Assert.IsTrue(new uint[] { 0U, 2U, 7U }.SequenceEqual(visibleIndices.Take((int) numVisible)));
+		}
+
+		[TestMethod]
+		public unsafe void TestCullSpheresMatchesScalarReference() {
+			// Define variables and constants
+			const int NUM_SPHERES = 100003; // Not a multiple of four, so that the remainder is tested too
+			FrustumCuller.BoundingSphere[] spheres = CreateRandomSpheres(NUM_SPHERES);
+			uint[] visibleIndices = new uint[NUM_SPHERES];
+			uint[] referenceVisibleIndices = new uint[NUM_SPHERES];
+			uint referenceNumVisible;
+
+			// Set up context
+			FrustumCuller.FrustumPlanes frustum = CreateTestFrustum();
+
+			// Execute
+			uint numVisible = FrustumCuller.CullSpheres(frustum, spheres, NUM_SPHERES, visibleIndices);
+			fixed (FrustumCuller.BoundingSphere* spheresPtr = spheres) {
+				fixed (uint* referenceVisibleIndicesPtr = referenceVisibleIndices) {
+					InteropUtils.CallNative(
+						CullSpheresScalar,
+						(IntPtr) (&frustum),
+						(IntPtr) spheresPtr,
+						(uint) NUM_SPHERES,
+						(IntPtr) referenceVisibleIndicesPtr,
+						(IntPtr) (&referenceNumVisible)
+					).ThrowOnFailure();
+				}
+			}
+
+			// Assert outcome
+			Assert.IsTrue(numVisible > 0U && numVisible < NUM_SPHERES);
+			Assert.AreEqual(referenceNumVisible, numVisible);
+			Assert.IsTrue(referenceVisibleIndices.Take((int) numVisible).SequenceEqual(visibleIndices.Take((int) numVisible)));
+		}
+
+		[TestMethod]
+		public void TestCullInstances() {
+			// Define variables and constants
+			Vector3[] positions = {
+				new Vector3(-1f, -1f, -1f), new Vector3(1f, 1f, 1f), // Model 0: a 2x2x2 cube around the origin
+				new Vector3(-0.5f, 0f, 20f), new Vector3(0.5f, 0f, 20f) // Model 1: a line 20 units in front of the origin
+			};
+			Quaternion halfTurn = Quaternion.FromAxialRotation(Vector3.UP, MathUtils.PI);
+			Transform[] transforms = {
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, 10f)), // In front of the camera
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, -10f)), // Behind the camera
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, -10f)), // Behind, but the model puts it in front
+				new Transform(Vector3.ONE, halfTurn, new Vector3(0f, 0f, -10f)), // As above, but turned to face away
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(13f, 0f, 10f)), // Just off to the right
+				new Transform(Vector3.ONE * 2f, Quaternion.IDENTITY, new Vector3(13f, 0f, 10f)) // As above, but big enough to poke in to view
+			};
+			uint[] modelIndices = { 0U, 0U, 1U, 1U, 0U, 0U };
+			uint[] visibleIndices = new uint[transforms.Length];
+
+			// Set up context
+			FrustumCuller.FrustumPlanes frustum = CreateTestFrustum();
+			FrustumCuller.BoundingSphere[] modelBounds = FrustumCuller.CalculateModelBounds(positions, new[] { 2U, 2U });
+
+			// Execute
+			uint numVisible = FrustumCuller.CullInstances(frustum, modelBounds, transforms, modelIndices, (uint) transforms.Length, visibleIndices);
+
+			// Assert outcome
+			Assert.AreEqual(0f, modelBounds[0].Z);
+			Assert.AreEqual((float) Math.Sqrt(3f), modelBounds[0].Radius, 0.0001f);
+			Assert.AreEqual(20f, modelBounds[1].Z);
+			Assert.AreEqual(0.5f, modelBounds[1].Radius);
+			Assert.IsTrue(new uint[] { 0U, 2U, 5U }.SequenceEqual(visibleIndices.Take((int) numVisible)));
+		}
+
+		[TestMethod]
+		public void TestCullShadowCasters() {
+			// Define variables and constants
+			const float LIGHT_DEPTH = 100f;
+			Vector3[] positions = { new Vector3(-1f, -1f, -1f), new Vector3(1f, 1f, 1f) };
+			Transform[] transforms = {
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 20f, 10f)), // Above the camera's view, shadow falls in to it
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, -20f, 10f)), // Below the camera's view, shadow falls away
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 100f, 10f)), // Above the light's near plane
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, 10f)), // In the camera's view
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, -50f, 10f)) // Below the light's far plane
+			};
+			uint[] modelIndices = new uint[transforms.Length];
+			uint[] visibleIndices = new uint[transforms.Length];
+
+			// Set up context
+			// An orthographic light 200 units wide and 100 deep (near plane at 1), at Y = 60 and shining straight down
+			Matrix lightVPMat = new Matrix(
+				0.01f, 0f, 0f, 0f,
+				0f, 0f, -1f / (LIGHT_DEPTH - 1f), 0f,
+				0f, 0.01f, 0f, 0f,
+				0f, 0f, 59f / (LIGHT_DEPTH - 1f), 1f
+			);
+			Matrix receiverVPMat = new Matrix(
+				1f, 0f, 0f, 0f,
+				0f, 1f, 0f, 0f,
+				0f, 0f, 100f / 99f, 1f,
+				0f, 0f, -100f / 99f, 0f
+			);
+			FrustumCuller.FrustumPlanes casterFrustum = FrustumCuller.CreateShadowCasterFrustum(lightVPMat);
+			FrustumCuller.FrustumPlanes receiverFrustum = FrustumCuller.CreateShadowReceiverFrustum(receiverVPMat, Vector3.DOWN, LIGHT_DEPTH);
+			FrustumCuller.BoundingSphere[] modelBounds = FrustumCuller.CalculateModelBounds(positions, new[] { 2U });
+
+			// Execute
+			uint numCasters = FrustumCuller.CullShadowCasters(casterFrustum, null, modelBounds, transforms, modelIndices, (uint) transforms.Length, visibleIndices);
+			uint[] casters = visibleIndices.Take((int) numCasters).ToArray();
+			uint numVisibleCasters = FrustumCuller.CullShadowCasters(casterFrustum, receiverFrustum, modelBounds, transforms, modelIndices, (uint) transforms.Length, visibleIndices);
+			uint[] visibleCasters = visibleIndices.Take((int) numVisibleCasters).ToArray();
+
+			// Assert outcome
+			Assert.IsTrue(new uint[] { 0U, 1U, 2U, 3U }.SequenceEqual(casters));
+			Assert.IsTrue(new uint[] { 0U, 2U, 3U }.SequenceEqual(visibleCasters));
+		}
+
+		[TestMethod, TestCategory("Benchmark")]
+		public unsafe void TestFrustumCullerBenchmark() {
+			// Define variables and constants
+			const int NUM_SPHERES = 100000;
+			const uint NUM_ITERATIONS = 100U;
+			FrustumCuller.BoundingSphere[] spheres = CreateRandomSpheres(NUM_SPHERES);
+			double scalarMs, simdMs;
+
+			// Set up context
+			FrustumCuller.FrustumPlanes frustum = CreateTestFrustum();
+
+			// Execute
+			fixed (FrustumCuller.BoundingSphere* spheresPtr = spheres) {
+				InteropUtils.CallNative(
+					BenchmarkFrustumCuller,
+					(IntPtr) (&frustum),
+					(IntPtr) spheresPtr,
+					(uint) NUM_SPHERES,
+					NUM_ITERATIONS,
+					(IntPtr) (&scalarMs),
+					(IntPtr) (&simdMs)
+				).ThrowOnFailure();
+			}
+			Console.WriteLine("Scalar: " + scalarMs / NUM_ITERATIONS + "ms; SIMD: " + simdMs / NUM_ITERATIONS + "ms (per " + NUM_SPHERES + " spheres)");
+
+			// Assert outcome (the timings are only reported: which is faster depends on the machine and its load, not on correctness)
+			Assert.IsTrue(scalarMs >= 0d && simdMs >= 0d);
+		}
+		#endregion
+	}
+}
@@ -153,6 +153,115 @@ namespace Ophidian.Losgap.Rendering {
 			gcA.Dispose();
 			gcB.Dispose();
 		}
+
+		[TestMethod]
+		public void ShouldAppendLODsAfterModels() {
+			// Define variables and constants
+			GeometryCacheBuilder<TestVertex> testVertexCacheBuilder = new GeometryCacheBuilder<TestVertex>();
+			TestVertex[] modelVerts = {
+				new TestVertex(Vector3.ONE * 0f, Vector2.ONE * 0f),
+				new TestVertex(Vector3.ONE * 1f, Vector2.ONE * 1f),
+				new TestVertex(Vector3.ONE * 2f, Vector2.ONE * 2f),
+				new TestVertex(Vector3.ONE * 3f, Vector2.ONE * 3f)
+			};
+			uint[] modelIndices = { 0U, 1U, 2U, 0U, 2U, 3U };
+			uint[] lodIndices = { 0U, 1U, 2U };
+
+			uint outVBStartIndex, outIBStartIndex, outVBCount, outIBCount;
+
+			// Set up context
+			ModelHandle modelA = testVertexCacheBuilder.AddModel("SAL_a", modelVerts, modelIndices);
+			ModelHandle modelB = testVertexCacheBuilder.AddModel("SAL_b", modelVerts, modelIndices);
+			testVertexCacheBuilder.AddModelLOD(modelA, lodIndices, 0.2f);
+			try {
+				testVertexCacheBuilder.AddModelLOD(modelA, lodIndices, 0.3f); // Coarser levels must be drawn smaller
+				Assert.Fail();
+			}
+			catch (ArgumentOutOfRangeException) { }
+			try {
+				testVertexCacheBuilder.AddModelLOD(modelA, new[] { 4U }, 0.1f);
+				Assert.Fail();
+			}
+			catch (ArgumentException) { }
+
+			// Execute
+			GeometryCache result = testVertexCacheBuilder.Build();
+
+			// Assert outcome
+			Assert.IsTrue(result.HasLODs);
+			Assert.AreEqual(3U, result.NumLODs);
+			Assert.AreEqual(0U, result.ModelFirstLODs[modelA.ModelIndex]);
+			Assert.AreEqual(2U, result.ModelFirstLODs[modelB.ModelIndex]);
+			Assert.AreEqual(3U, result.ModelFirstLODs[2]);
+			Assert.AreEqual(Single.PositiveInfinity, result.LODMaxScreenSizes[0]);
+			Assert.AreEqual(0.2f, result.LODMaxScreenSizes[1]);
+			Assert.AreEqual((uint) (modelIndices.Length * 2 + lodIndices.Length), result.IndexBuffer.Length);
+
+			result.GetModelBufferValues(modelB.ModelIndex, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
+			Assert.AreEqual(4U, outVBStartIndex);
+			Assert.AreEqual(6U, outIBStartIndex);
+			Assert.AreEqual(6U, outIBCount);
+
+			result.GetLODBufferValues(1U, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
+			Assert.AreEqual(0U, outVBStartIndex);
+			Assert.AreEqual(4U, outVBCount);
+			Assert.AreEqual(12U, outIBStartIndex);
+			Assert.AreEqual(3U, outIBCount);
+
+			result.GetLODBufferValues(2U, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
+			Assert.AreEqual(4U, outVBStartIndex);
+			Assert.AreEqual(6U, outIBStartIndex);
+			Assert.AreEqual(6U, outIBCount);
+
+			result.Dispose();
+		}
+
+		[TestMethod]
+		public void ShouldFlattenModelClusters() {
+			// Define variables and constants
+			GeometryCacheBuilder<TestVertex> testVertexCacheBuilder = new GeometryCacheBuilder<TestVertex>();
+			TestVertex[] modelVerts = {
+				new TestVertex(Vector3.ONE * 0f, Vector2.ONE * 0f),
+				new TestVertex(Vector3.ONE * 1f, Vector2.ONE * 1f),
+				new TestVertex(Vector3.ONE * 2f, Vector2.ONE * 2f),
+				new TestVertex(Vector3.ONE * 3f, Vector2.ONE * 3f)
+			};
+			uint[] modelIndices = { 0U, 1U, 2U, 0U, 2U, 3U };
+			MeshClusterer.Cluster[] clusters = {
+				new MeshClusterer.Cluster { FirstIndex = 0U, NumIndices = 3U, ConeCutoff = 1f },
+				new MeshClusterer.Cluster { FirstIndex = 3U, NumIndices = 3U, ConeCutoff = 1f }
+			};
+
+			// Set up context
+			ModelHandle modelA = testVertexCacheBuilder.AddModel("SFMC_a", modelVerts, modelIndices);
+			ModelHandle modelB = testVertexCacheBuilder.AddModel("SFMC_b", modelVerts, modelIndices);
+			ModelHandle modelC = testVertexCacheBuilder.AddModel("SFMC_c", modelVerts, modelIndices);
+			testVertexCacheBuilder.AddModelClusters(modelC, clusters);
+			try {
+				testVertexCacheBuilder.AddModelClusters(modelA, new[] { new MeshClusterer.Cluster { FirstIndex = 3U, NumIndices = 6U } });
+				Assert.Fail();
+			}
+			catch (ArgumentException) { }
+			try {
+				testVertexCacheBuilder.AddModelClusters(modelC, clusters);
+				Assert.Fail();
+			}
+			catch (InvalidOperationException) { }
+
+			// Execute
+			GeometryCache result = testVertexCacheBuilder.Build();
+
+			// Assert outcome
+			Assert.IsTrue(result.HasClusters);
+			Assert.AreEqual(2, result.Clusters.Length);
+			Assert.AreEqual(0U, result.ModelFirstClusters[modelA.ModelIndex]);
+			Assert.AreEqual(0U, result.ModelFirstClusters[modelB.ModelIndex]);
+			Assert.AreEqual(0U, result.ModelFirstClusters[modelC.ModelIndex]);
+			Assert.AreEqual(2U, result.ModelFirstClusters[3]);
+			Assert.AreEqual(3U, result.Clusters[1].FirstIndex);
+
+			result.Dispose();
+		}
 		#endregion
 	}
 }
\ No newline at end of file
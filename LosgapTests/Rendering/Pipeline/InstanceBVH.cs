@@ -0,0 +1,375 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 02:31 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class InstanceBVHTest {
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		// Instances here are only ever translated (no rotation, unit scale), so each one's world sphere is its model sphere moved by its
+		// translation. The brute-force checks below test every sphere exactly as the tree tests its leaves.
+		private static FrustumCuller.BoundingSphere PlaceSphere(FrustumCuller.BoundingSphere modelBounds, Transform transform) {
+			return new FrustumCuller.BoundingSphere(
+				new Vector3(modelBounds.X + transform.Translation.X, modelBounds.Y + transform.Translation.Y, modelBounds.Z + transform.Translation.Z),
+				modelBounds.Radius
+			);
+		}
+
+		private static bool SpheresTouch(FrustumCuller.BoundingSphere a, FrustumCuller.BoundingSphere b) {
+			float x = b.X - a.X;
+			float y = b.Y - a.Y;
+			float z = b.Z - a.Z;
+			float reach = b.Radius + a.Radius;
+			return x * x + y * y + z * z <= reach * reach;
+		}
+
+		private static bool RayTouchesSphere(Ray ray, FrustumCuller.BoundingSphere sphere) {
+			Vector3 origin = ray.StartPoint;
+			Vector3 direction = ray.Orientation;
+			float toCentreX = sphere.X - origin.X;
+			float toCentreY = sphere.Y - origin.Y;
+			float toCentreZ = sphere.Z - origin.Z;
+			float along = toCentreX * direction.X + toCentreY * direction.Y + toCentreZ * direction.Z;
+			if (along < 0f) along = 0f;
+			else if (along > ray.Length) along = ray.Length;
+			float x = toCentreX - direction.X * along;
+			float y = toCentreY - direction.Y * along;
+			float z = toCentreZ - direction.Z * along;
+			return x * x + y * y + z * z <= sphere.Radius * sphere.Radius;
+		}
+
+		private static Vector3 NextPoint(Random random, Vector3 min, Vector3 max) {
+			return new Vector3(
+				min.X + (float) random.NextDouble() * (max.X - min.X),
+				min.Y + (float) random.NextDouble() * (max.Y - min.Y),
+				min.Z + (float) random.NextDouble() * (max.Z - min.Z)
+			);
+		}
+
+		private static void AssertSameKeys(IEnumerable<ulong> expectedKeys, ulong[] foundKeys, uint numFound, string query) {
+			ulong[] expected = expectedKeys.OrderBy(key => key).ToArray();
+			ulong[] found = foundKeys.Take((int) numFound).OrderBy(key => key).ToArray();
+			Assert.IsTrue(expected.SequenceEqual(found), query + " found " + found.Length + " instances, brute force found " + expected.Length + ".");
+		}
+
+		// Checks a frustum, sphere and ray query against every instance (keyed by its index in worldSpheres; null spheres are not in the tree)
+		private static void AssertQueriesMatchBruteForce(InstanceBVH bvh, FrustumCuller.BoundingSphere?[] worldSpheres, FrustumCuller.FrustumPlanes frustum,
+			FrustumCuller.BoundingSphere querySphere, Ray queryRay) {
+			ulong[] foundKeys = new ulong[1];
+			FrustumCuller.BoundingSphere[] presentSpheres = worldSpheres.Where(sphere => sphere.HasValue).Select(sphere => sphere.Value).ToArray();
+			ulong[] presentKeys = Enumerable.Range(0, worldSpheres.Length).Where(i => worldSpheres[i].HasValue).Select(i => (ulong) i).ToArray();
+			uint[] visibleIndices = new uint[presentSpheres.Length];
+
+			uint numVisible = FrustumCuller.CullSpheres(frustum, presentSpheres, (uint) presentSpheres.Length, visibleIndices);
+			uint numFound = bvh.QueryFrustum(frustum, ref foundKeys);
+			AssertSameKeys(visibleIndices.Take((int) numVisible).Select(i => presentKeys[i]), foundKeys, numFound, "Frustum query");
+
+			numFound = bvh.QuerySphere(querySphere, ref foundKeys);
+			AssertSameKeys(presentKeys.Where((key, i) => SpheresTouch(presentSpheres[i], querySphere)), foundKeys, numFound, "Sphere query");
+
+			numFound = bvh.QueryRay(queryRay, ref foundKeys);
+			AssertSameKeys(presentKeys.Where((key, i) => RayTouchesSphere(queryRay, presentSpheres[i])), foundKeys, numFound, "Ray query");
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestInsertionKeepsTreeBalanced() {
+			// Define variables and constants
+			const int NUM_INSTANCES = 1024;
+			const uint MAX_BALANCED_HEIGHT = 20U; // AVL trees are at most ~1.44 * log2(n) tall
+			FrustumCuller.BoundingSphere modelBounds = new FrustumCuller.BoundingSphere(Vector3.ZERO, 1f);
+			ulong[] foundKeys = new ulong[1];
+
+			// Set up context
+			InstanceBVH testBVH = new InstanceBVH();
+
+			// Execute
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				testBVH.Insert((ulong) i, modelBounds, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.RIGHT * 3f * i));
+			}
+
+			// Assert outcome
+			Assert.AreEqual((uint) NUM_INSTANCES, testBVH.Count);
+			Assert.IsTrue(testBVH.Height <= MAX_BALANCED_HEIGHT);
+
+			// Execute
+			for (int i = 0; i < NUM_INSTANCES; i += 2) {
+				Assert.IsTrue(testBVH.Remove((ulong) i));
+			}
+			for (int i = 1; i < NUM_INSTANCES; i += 2) {
+				Assert.IsTrue(testBVH.Update((ulong) i, modelBounds, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.UP * 3f * i)));
+			}
+			uint numFound = testBVH.QuerySphere(new FrustumCuller.BoundingSphere(Vector3.UP * 3f * 101f, 1.5f), ref foundKeys);
+
+			// Assert outcome
+			Assert.AreEqual((uint) NUM_INSTANCES / 2U, testBVH.Count);
+			Assert.IsTrue(testBVH.Height <= MAX_BALANCED_HEIGHT);
+			Assert.AreEqual(1U, numFound);
+			Assert.AreEqual(101UL, foundKeys[0]);
+
+			testBVH.Dispose();
+		}
+
+		[TestMethod]
+		public void TestBuiltAndInsertedTreesMatchBruteForce() {
+			// Define variables and constants
+			const int NUM_INSTANCES = 2000;
+			const int NUM_QUERIES = 100;
+			Vector3 sceneMin = new Vector3(-80f, -80f, -20f);
+			Vector3 sceneMax = new Vector3(80f, 80f, 120f);
+			FrustumCuller.BoundingSphere[] modelBounds = {
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 0.5f),
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 1.5f),
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 6f)
+			};
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Random random = new Random(20161020);
+			ulong[] keys = new ulong[NUM_INSTANCES];
+			Transform[] transforms = new Transform[NUM_INSTANCES];
+			uint[] modelIndices = new uint[NUM_INSTANCES];
+			FrustumCuller.BoundingSphere?[] worldSpheres = new FrustumCuller.BoundingSphere?[NUM_INSTANCES];
+
+			// Set up context
+			InstanceBVH builtBVH = new InstanceBVH();
+			InstanceBVH insertedBVH = new InstanceBVH();
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				keys[i] = (ulong) i;
+				transforms[i] = Transform.DEFAULT_TRANSFORM.With(translation: NextPoint(random, sceneMin, sceneMax));
+				modelIndices[i] = (uint) random.Next(modelBounds.Length);
+				worldSpheres[i] = PlaceSphere(modelBounds[modelIndices[i]], transforms[i]);
+			}
+
+			// Execute
+			builtBVH.Build(keys, modelBounds, transforms, modelIndices, (uint) NUM_INSTANCES);
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				insertedBVH.Insert(keys[i], modelBounds[modelIndices[i]], transforms[i]);
+			}
+
+			// Assert outcome
+			Assert.AreEqual((uint) NUM_INSTANCES, builtBVH.Count);
+			Assert.AreEqual((uint) NUM_INSTANCES, insertedBVH.Count);
+			for (int q = 0; q < NUM_QUERIES; ++q) {
+				FrustumCuller.BoundingSphere querySphere = new FrustumCuller.BoundingSphere(
+					NextPoint(random, sceneMin, sceneMax),
+					(float) random.NextDouble() * 20f
+				);
+				Vector3 rayStart = NextPoint(random, sceneMin, sceneMax);
+				Ray queryRay = q % 4 == 0
+					? new Ray(rayStart, NextPoint(random, sceneMin, sceneMax) - rayStart) // Unbounded
+					: Ray.FromStartAndEndPoint(rayStart, NextPoint(random, sceneMin, sceneMax));
+
+				AssertQueriesMatchBruteForce(builtBVH, worldSpheres, frustum, querySphere, queryRay);
+				AssertQueriesMatchBruteForce(insertedBVH, worldSpheres, frustum, querySphere, queryRay);
+			}
+
+			builtBVH.Dispose();
+			insertedBVH.Dispose();
+		}
+
+		[TestMethod]
+		public void TestFrustumQueryTakesSubtreesFullyInside() {
+			// Define variables and constants
+			const int GRID_SIZE = 8;
+			const int NUM_INSIDE_INSTANCES = GRID_SIZE * GRID_SIZE * GRID_SIZE;
+			const int NUM_EDGE_INSTANCES = 200;
+			FrustumCuller.BoundingSphere[] modelBounds = { new FrustumCuller.BoundingSphere(Vector3.ZERO, 0.5f) };
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Random random = new Random(1);
+			ulong[] keys = new ulong[NUM_INSIDE_INSTANCES + NUM_EDGE_INSTANCES];
+			Transform[] transforms = new Transform[NUM_INSIDE_INSTANCES + NUM_EDGE_INSTANCES];
+			uint[] modelIndices = new uint[NUM_INSIDE_INSTANCES + NUM_EDGE_INSTANCES];
+			FrustumCuller.BoundingSphere?[] worldSpheres = new FrustumCuller.BoundingSphere?[NUM_INSIDE_INSTANCES + NUM_EDGE_INSTANCES];
+			ulong[] builtFoundKeys = new ulong[1];
+			ulong[] insertedFoundKeys = new ulong[1];
+
+			// Set up context
+			InstanceBVH builtBVH = new InstanceBVH();
+			InstanceBVH insertedBVH = new InstanceBVH();
+			// A block well inside the frustum (which widens by one unit either side per unit along +Z), so the root box is fully inside it
+			for (int i = 0; i < NUM_INSIDE_INSTANCES; ++i) {
+				keys[i] = (ulong) i;
+				transforms[i] = Transform.DEFAULT_TRANSFORM.With(translation: new Vector3(
+					(i % GRID_SIZE) * 2f - GRID_SIZE,
+					(i / GRID_SIZE % GRID_SIZE) * 2f - GRID_SIZE,
+					40f + (i / (GRID_SIZE * GRID_SIZE)) * 2f
+				));
+				worldSpheres[i] = PlaceSphere(modelBounds[0], transforms[i]);
+			}
+
+			// Execute
+			builtBVH.Build(keys, modelBounds, transforms, modelIndices, (uint) NUM_INSIDE_INSTANCES);
+			for (int i = 0; i < NUM_INSIDE_INSTANCES; ++i) {
+				insertedBVH.Insert(keys[i], modelBounds[0], transforms[i]);
+			}
+			uint numBuiltFound = builtBVH.QueryFrustum(frustum, ref builtFoundKeys);
+			uint numInsertedFound = insertedBVH.QueryFrustum(frustum, ref insertedFoundKeys);
+
+			// Assert outcome
+			AssertSameKeys(keys.Take(NUM_INSIDE_INSTANCES), builtFoundKeys, numBuiltFound, "Frustum query of the built tree");
+			AssertSameKeys(keys.Take(NUM_INSIDE_INSTANCES), insertedFoundKeys, numInsertedFound, "Frustum query of the inserted tree");
+
+			// Execute
+			// Scatter more instances around the right-hand plane and behind the near plane, so that some subtrees are fully inside and
+			// others straddle the frustum
+			for (int i = NUM_INSIDE_INSTANCES; i < NUM_INSIDE_INSTANCES + NUM_EDGE_INSTANCES; ++i) {
+				keys[i] = (ulong) i;
+				float z = (float) random.NextDouble() * 60f - 5f;
+				transforms[i] = Transform.DEFAULT_TRANSFORM.With(translation: new Vector3(z + (float) random.NextDouble() * 4f - 2f, 0f, z));
+				worldSpheres[i] = PlaceSphere(modelBounds[0], transforms[i]);
+				insertedBVH.Insert(keys[i], modelBounds[0], transforms[i]);
+			}
+			builtBVH.Build(keys, modelBounds, transforms, modelIndices, (uint) keys.Length);
+
+			// Assert outcome
+			FrustumCuller.BoundingSphere querySphere = new FrustumCuller.BoundingSphere(new Vector3(0f, 0f, 45f), 3f);
+			Ray queryRay = new Ray(Vector3.ZERO, Vector3.FORWARD);
+			AssertQueriesMatchBruteForce(builtBVH, worldSpheres, frustum, querySphere, queryRay);
+			AssertQueriesMatchBruteForce(insertedBVH, worldSpheres, frustum, querySphere, queryRay);
+
+			builtBVH.Dispose();
+			insertedBVH.Dispose();
+		}
+
+		[TestMethod]
+		public void TestUpdatesInsideAndOutsideMarginMatchBruteForce() {
+			// Define variables and constants
+			const int NUM_INSTANCES = 500;
+			const float INSTANCE_RADIUS = 2f;
+			const float SMALL_MOVE = INSTANCE_RADIUS * 0.15f; // Inside the 25% fattened margin
+			const float LARGE_MOVE = INSTANCE_RADIUS * 10f;
+			Vector3 sceneMin = new Vector3(-50f, -50f, 0f);
+			Vector3 sceneMax = new Vector3(50f, 50f, 100f);
+			FrustumCuller.BoundingSphere[] modelBounds = { new FrustumCuller.BoundingSphere(Vector3.ZERO, INSTANCE_RADIUS) };
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Random random = new Random(2);
+			Transform[] transforms = new Transform[NUM_INSTANCES];
+			FrustumCuller.BoundingSphere?[] worldSpheres = new FrustumCuller.BoundingSphere?[NUM_INSTANCES];
+			ulong[] foundKeys = new ulong[1];
+
+			// Set up context
+			InstanceBVH testBVH = new InstanceBVH();
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				transforms[i] = Transform.DEFAULT_TRANSFORM.With(translation: NextPoint(random, sceneMin, sceneMax));
+				testBVH.Insert((ulong) i, modelBounds[0], transforms[i]);
+			}
+
+			// Execute
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				transforms[i] = transforms[i].With(translation: transforms[i].Translation + Vector3.RIGHT * SMALL_MOVE);
+				worldSpheres[i] = PlaceSphere(modelBounds[0], transforms[i]);
+				Assert.IsTrue(testBVH.Update((ulong) i, modelBounds[0], transforms[i]));
+			}
+
+			// Assert outcome
+			// Just touching each instance's far side: the old sphere is out of reach, so only a leaf test against the new one finds it
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				FrustumCuller.BoundingSphere edgeSphere = new FrustumCuller.BoundingSphere(
+					transforms[i].Translation + Vector3.RIGHT * (INSTANCE_RADIUS + 0.1f),
+					0.15f
+				);
+				uint numFound = testBVH.QuerySphere(edgeSphere, ref foundKeys);
+				Assert.IsTrue(foundKeys.Take((int) numFound).Contains((ulong) i));
+			}
+			for (int q = 0; q < NUM_INSTANCES; q += 25) {
+				FrustumCuller.BoundingSphere querySphere = new FrustumCuller.BoundingSphere(transforms[q].Translation, INSTANCE_RADIUS * 3f);
+				Ray queryRay = new Ray(Vector3.ZERO, transforms[q].Translation);
+				AssertQueriesMatchBruteForce(testBVH, worldSpheres, frustum, querySphere, queryRay);
+			}
+
+			// Execute
+			for (int i = 0; i < NUM_INSTANCES; i += 2) {
+				Vector3 oldTranslation = transforms[i].Translation;
+				transforms[i] = transforms[i].With(translation: oldTranslation + Vector3.UP * LARGE_MOVE);
+				worldSpheres[i] = PlaceSphere(modelBounds[0], transforms[i]);
+				Assert.IsTrue(testBVH.Update((ulong) i, modelBounds[0], transforms[i]));
+			}
+
+			// Assert outcome
+			Assert.AreEqual((uint) NUM_INSTANCES, testBVH.Count);
+			for (int q = 0; q < NUM_INSTANCES; q += 25) {
+				// Centred on where the moved instances were and where they went
+				FrustumCuller.BoundingSphere querySphere = new FrustumCuller.BoundingSphere(transforms[q].Translation - Vector3.UP * LARGE_MOVE, INSTANCE_RADIUS * 3f);
+				Ray queryRay = new Ray(Vector3.ZERO, transforms[q].Translation);
+				AssertQueriesMatchBruteForce(testBVH, worldSpheres, frustum, querySphere, queryRay);
+				querySphere = new FrustumCuller.BoundingSphere(transforms[q].Translation, INSTANCE_RADIUS * 3f);
+				AssertQueriesMatchBruteForce(testBVH, worldSpheres, frustum, querySphere, queryRay);
+			}
+
+			testBVH.Dispose();
+		}
+
+		[TestMethod]
+		public void TestMovedStaticInstancesMoveToDynamicTree() {
+			// Define variables and constants
+			const int NUM_INSTANCES = 300;
+			const int NUM_QUERIES = 50;
+			Vector3 sceneMin = new Vector3(-40f, -40f, 0f);
+			Vector3 sceneMax = new Vector3(40f, 40f, 80f);
+			FrustumCuller.BoundingSphere[] modelBounds = { new FrustumCuller.BoundingSphere(Vector3.ZERO, 1f) };
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Random random = new Random(3);
+			ModelInstanceManager testMIM = new ModelInstanceManager(modelBounds);
+			ModelInstanceHandle[] instances = new ModelInstanceHandle[NUM_INSTANCES];
+			List<ModelInstanceHandle> foundInstances = new List<ModelInstanceHandle>();
+			ulong[] foundKeys = new ulong[1];
+
+			// Set up context
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				instances[i] = testMIM.AllocateInstance((uint) i % 3U, 0U, 0U, Transform.DEFAULT_TRANSFORM.With(translation: NextPoint(random, sceneMin, sceneMax)));
+			}
+			testMIM.BuildStaticTree();
+
+			// Execute
+			// Every third instance moves after the static build: half of those only slightly, the rest across the scene
+			for (int i = 0; i < NUM_INSTANCES; i += 3) {
+				Vector3 newTranslation = i % 2 == 0
+					? instances[i].Transform.Translation + Vector3.LEFT * 0.1f
+					: NextPoint(random, sceneMin, sceneMax);
+				instances[i].Transform = Transform.DEFAULT_TRANSFORM.With(translation: newTranslation);
+			}
+			// Moving again finds the instance already in the dynamic tree
+			instances[0].Transform = Transform.DEFAULT_TRANSFORM.With(translation: Vector3.FORWARD * 30f);
+			FrustumCuller.BoundingSphere[] worldSpheres = instances.Select(mih => PlaceSphere(modelBounds[0], mih.Transform)).ToArray();
+
+			// Assert outcome
+			for (int q = 0; q < NUM_QUERIES; ++q) {
+				FrustumCuller.BoundingSphere querySphere = new FrustumCuller.BoundingSphere(NextPoint(random, sceneMin, sceneMax), (float) random.NextDouble() * 15f);
+				foundInstances.Clear();
+				testMIM.FindInstances(new Sphere(new Vector3(querySphere.X, querySphere.Y, querySphere.Z), querySphere.Radius), foundInstances);
+				ModelInstanceHandle[] expectedInstances = instances.Where((mih, i) => SpheresTouch(worldSpheres[i], querySphere)).ToArray();
+				Assert.AreEqual(expectedInstances.Length, foundInstances.Count);
+				Assert.IsTrue(expectedInstances.All(foundInstances.Contains));
+
+				Vector3 rayStart = NextPoint(random, sceneMin, sceneMax);
+				Ray queryRay = Ray.FromStartAndEndPoint(rayStart, NextPoint(random, sceneMin, sceneMax));
+				foundInstances.Clear();
+				testMIM.FindInstances(queryRay, foundInstances);
+				expectedInstances = instances.Where((mih, i) => RayTouchesSphere(queryRay, worldSpheres[i])).ToArray();
+				Assert.AreEqual(expectedInstances.Length, foundInstances.Count);
+				Assert.IsTrue(expectedInstances.All(foundInstances.Contains));
+			}
+
+			uint[] visibleIndices = new uint[NUM_INSTANCES];
+			uint numVisible = FrustumCuller.CullSpheres(frustum, worldSpheres, (uint) NUM_INSTANCES, visibleIndices);
+			uint? numKeys = testMIM.FindInstanceKeys(frustum, ref foundKeys);
+			Assert.IsTrue(numKeys.HasValue);
+			AssertSameKeys(
+				visibleIndices.Take((int) numVisible).Select(i => ((ulong) instances[i].MaterialIndex << 32) | instances[i].InstanceIndex),
+				foundKeys,
+				numKeys.Value,
+				"Frustum query"
+			);
+
+			testMIM.Dispose();
+		}
+		#endregion
+	}
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:58 by Ben Bowen
+
+using System;
+using System.Threading.Tasks;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class InstanceMatrixWriterTest {
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		private static Transform[] CreateRandomTransforms(int numTransforms) {
+			Random random = new Random(1);
+			Func<float> nextFloat = () => (float) random.NextDouble() * 10f - 5f;
+			Transform[] result = new Transform[numTransforms];
+			for (int i = 0; i < numTransforms; ++i) {
+				result[i] = new Transform(
+					new Vector3(nextFloat(), nextFloat(), nextFloat()),
+					new Quaternion(nextFloat(), nextFloat(), nextFloat(), nextFloat()),
+					new Vector3(nextFloat(), nextFloat(), nextFloat())
+				);
+			}
+			return result;
+		}
+
+		#region Tests
+		[TestMethod]
+		public unsafe void TestWriteTransposedMatrices() {
+			// Define variables and constants
+			const int NUM_TRANSFORMS = 1003; // Not a multiple of 4, to test the remainder
+			Transform[] transforms = CreateRandomTransforms(NUM_TRANSFORMS);
+			transforms[0] = new Transform(Vector3.ONE, Quaternion.IDENTITY, Vector3.ZERO);
+			uint[] order = new uint[NUM_TRANSFORMS];
+			Matrix[] matrices = new Matrix[NUM_TRANSFORMS];
+
+			// Set up context
+			for (int i = 0; i < NUM_TRANSFORMS; ++i) order[i] = (uint) (NUM_TRANSFORMS - 1 - i);
+
+			// Execute
+			fixed (Matrix* matricesPtr = matrices) {
+				InstanceMatrixWriter.WriteTransposedMatrices(transforms, order, (uint) NUM_TRANSFORMS, matricesPtr);
+			}
+
+			// Assert outcome
+			Assert.AreEqual(Matrix.IDENTITY, matrices[NUM_TRANSFORMS - 1]);
+			for (int i = 0; i < NUM_TRANSFORMS; ++i) {
+				Assert.IsTrue(transforms[order[i]].AsMatrixTransposed.EqualsWithTolerance(matrices[i], 0.0001f), "Matrix " + i + " was wrong.");
+			}
+		}
+
+		[TestMethod]
+		public unsafe void TestWriteTransposedMatricesInParallel() {
+			// Define variables and constants
+			const int NUM_TRANSFORMS = 4000;
+			const int NUM_RANGES = 8;
+			const int RANGE_LENGTH = NUM_TRANSFORMS / NUM_RANGES;
+			Transform[] transforms = CreateRandomTransforms(NUM_TRANSFORMS);
+			uint[][] rangeOrders = new uint[NUM_RANGES][];
+			Matrix[] matrices = new Matrix[NUM_TRANSFORMS];
+
+			// Set up context
+			for (int r = 0; r < NUM_RANGES; ++r) {
+				rangeOrders[r] = new uint[RANGE_LENGTH];
+				for (int i = 0; i < RANGE_LENGTH; ++i) rangeOrders[r][i] = (uint) (r * RANGE_LENGTH + i);
+			}
+
+			// Execute
+			fixed (Matrix* matricesPtr = matrices) {
+				Matrix* destination = matricesPtr;
+				Parallel.For(0, NUM_RANGES, r => InstanceMatrixWriter.WriteTransposedMatrices(
+					transforms,
+					rangeOrders[r],
+					RANGE_LENGTH,
+					destination + r * RANGE_LENGTH
+				));
+			}
+
+			// Assert outcome
+			for (int i = 0; i < NUM_TRANSFORMS; ++i) {
+				Assert.IsTrue(transforms[i].AsMatrixTransposed.EqualsWithTolerance(matrices[i], 0.0001f), "Matrix " + i + " was wrong.");
+			}
+		}
+		#endregion
+	}
+}
@@ -0,0 +1,222 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 02:36 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.Interop;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class LODSelectorTest {
+		private const string NATIVE_DLL_NAME = "RenderingNative.dll";
+		private const float LOD_1_MAX_SCREEN_SIZE = 0.2f;
+		private const float LOD_2_MAX_SCREEN_SIZE = 0.05f;
+		private const float PROJECTION_SCALE = 1f;
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "CalculateScreenSizes")]
+		private static extern InteropBool CalculateScreenSizes(
+			IntPtr failReason,
+			IntPtr modelSphereArr, // BoundingSphere*
+			uint numModels,
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances,
+			IntPtr viewPosition, // Vector3*
+			float projectionScale,
+			InteropBool isPerspective,
+			IntPtr outScreenSizeArr // float*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "CalculateScreenSizesScalar")]
+		private static extern InteropBool CalculateScreenSizesScalar(
+			IntPtr failReason,
+			IntPtr modelSphereArr, // BoundingSphere*
+			uint numModels,
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances,
+			IntPtr viewPosition, // Vector3*
+			float projectionScale,
+			InteropBool isPerspective,
+			IntPtr outScreenSizeArr // float*
+		);
+
+		private struct TestVertex {
+			[VertexComponent("POSITION")]
+			public readonly Vector3 Position;
+
+			public TestVertex(Vector3 position) {
+				Position = position;
+			}
+		}
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		/// <summary>
+		/// Builds a cache with one model (a tetrahedron) that has two coarser levels of detail, drawn at or below
+		/// <see cref="LOD_1_MAX_SCREEN_SIZE"/> and <see cref="LOD_2_MAX_SCREEN_SIZE"/>.
+		/// </summary>
+		private static GeometryCache CreateLODCache() {
+			GeometryCacheBuilder<TestVertex> cacheBuilder = new GeometryCacheBuilder<TestVertex>();
+			TestVertex[] vertices = {
+				new TestVertex(new Vector3(1f, 1f, 1f)),
+				new TestVertex(new Vector3(-1f, -1f, 1f)),
+				new TestVertex(new Vector3(-1f, 1f, -1f)),
+				new TestVertex(new Vector3(1f, -1f, -1f))
+			};
+			ModelHandle model = cacheBuilder.AddModel("LODSelectorTest_Tetrahedron", vertices, new[] { 0U, 1U, 2U, 0U, 3U, 1U, 0U, 2U, 3U, 1U, 3U, 2U });
+			cacheBuilder.AddModelLOD(model, new[] { 0U, 1U, 2U, 0U, 3U, 1U }, LOD_1_MAX_SCREEN_SIZE);
+			cacheBuilder.AddModelLOD(model, new[] { 0U, 1U, 2U }, LOD_2_MAX_SCREEN_SIZE);
+			return cacheBuilder.Build();
+		}
+
+		/// <summary>
+		/// Returns the (flattened) LOD index picked for an instance of the cache's model placed so that its screen size is
+		/// <paramref name="screenSize"/>, starting from (and updating) <paramref name="lodState"/>.
+		/// </summary>
+		private static uint SelectLODAtScreenSize(GeometryCache cache, float screenSize, ref byte lodState) {
+			float distance = cache.ModelBounds[0].Radius * PROJECTION_SCALE / screenSize;
+			Vector3 modelCentre = new Vector3(cache.ModelBounds[0].X, cache.ModelBounds[0].Y, cache.ModelBounds[0].Z);
+			Transform[] transforms = { Transform.DEFAULT_TRANSFORM.With(translation: Vector3.FORWARD * distance - modelCentre) };
+			uint[] drawRanges = { 0U };
+			byte[] lodStates = { lodState };
+			LODSelector.SelectLODs(cache, transforms, drawRanges, 1U, Vector3.ZERO, PROJECTION_SCALE, true,
+				LODSelector.DEFAULT_HYSTERESIS, lodStates, drawRanges);
+			lodState = lodStates[0];
+			return drawRanges[0];
+		}
+
+		private static unsafe float[] GetScreenSizes(Func<IntPtr, IntPtr, uint, IntPtr, IntPtr, uint, IntPtr, float, InteropBool, IntPtr, InteropBool> calculateFunc,
+			FrustumCuller.BoundingSphere[] modelBounds, Transform[] transforms, uint[] modelIndices, Vector3 viewPosition, bool isPerspective) {
+			float[] result = new float[transforms.Length];
+			fixed (FrustumCuller.BoundingSphere* modelBoundsPtr = modelBounds) {
+				fixed (Transform* transformsPtr = transforms) {
+					fixed (uint* modelIndicesPtr = modelIndices) {
+						fixed (float* resultPtr = result) {
+							InteropUtils.CallNative(
+								calculateFunc,
+								(IntPtr) modelBoundsPtr,
+								(uint) modelBounds.Length,
+								(IntPtr) transformsPtr,
+								(IntPtr) modelIndicesPtr,
+								(uint) transforms.Length,
+								(IntPtr) (&viewPosition),
+								PROJECTION_SCALE,
+								(InteropBool) isPerspective,
+								(IntPtr) resultPtr
+							).ThrowOnFailure();
+						}
+					}
+				}
+			}
+			return result;
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestSelectLODsMovesBetweenLevels() {
+			// Define variables and constants
+			GeometryCache cache = CreateLODCache();
+			byte lodState = 0;
+
+			// Set up context
+			uint firstLOD = cache.ModelFirstLODs[0];
+
+			// Execute / Assert outcome
+			Assert.AreEqual(firstLOD + 0U, SelectLODAtScreenSize(cache, 0.5f, ref lodState));
+			Assert.AreEqual(0, lodState);
+			Assert.AreEqual(firstLOD + 1U, SelectLODAtScreenSize(cache, 0.1f, ref lodState));
+			Assert.AreEqual(1, lodState);
+			Assert.AreEqual(firstLOD + 2U, SelectLODAtScreenSize(cache, 0.01f, ref lodState));
+			Assert.AreEqual(2, lodState);
+			Assert.AreEqual(firstLOD + 0U, SelectLODAtScreenSize(cache, 0.9f, ref lodState)); // Straight back past both thresholds
+			Assert.AreEqual(0, lodState);
+			Assert.AreEqual(firstLOD + 2U, SelectLODAtScreenSize(cache, 0.001f, ref lodState)); // And out again
+
+			Vector3 insideCamera = new Vector3(cache.ModelBounds[0].X, cache.ModelBounds[0].Y, cache.ModelBounds[0].Z);
+			uint[] drawRanges = { 0U };
+			byte[] lodStates = { 2 };
+			LODSelector.SelectLODs(cache, new[] { Transform.DEFAULT_TRANSFORM }, drawRanges, 1U, insideCamera, PROJECTION_SCALE, true,
+				LODSelector.DEFAULT_HYSTERESIS, lodStates, drawRanges);
+			Assert.AreEqual(firstLOD, drawRanges[0]); // Cameras inside an instance always see it at its finest
+
+			cache.Dispose();
+		}
+
+		[TestMethod]
+		public void TestSelectLODsHysteresis() {
+			// Define variables and constants
+			const float JUST_PAST = 1f - LODSelector.DEFAULT_HYSTERESIS * 0.5f; // Past the threshold, but within the hysteresis band
+			const float CLEARLY_PAST = 1f - LODSelector.DEFAULT_HYSTERESIS * 1.5f; // Past the hysteresis band
+			GeometryCache cache = CreateLODCache();
+			byte lodState = 0;
+
+			// Set up context
+			uint firstLOD = cache.ModelFirstLODs[0];
+
+			// Execute / Assert outcome
+			Assert.AreEqual(firstLOD + 0U, SelectLODAtScreenSize(cache, LOD_1_MAX_SCREEN_SIZE * JUST_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 1U, SelectLODAtScreenSize(cache, LOD_1_MAX_SCREEN_SIZE * CLEARLY_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 1U, SelectLODAtScreenSize(cache, LOD_1_MAX_SCREEN_SIZE / JUST_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 1U, SelectLODAtScreenSize(cache, LOD_1_MAX_SCREEN_SIZE * JUST_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 0U, SelectLODAtScreenSize(cache, LOD_1_MAX_SCREEN_SIZE / CLEARLY_PAST, ref lodState));
+
+			Assert.AreEqual(firstLOD + 1U, SelectLODAtScreenSize(cache, LOD_2_MAX_SCREEN_SIZE / JUST_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 1U, SelectLODAtScreenSize(cache, LOD_2_MAX_SCREEN_SIZE * JUST_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 2U, SelectLODAtScreenSize(cache, LOD_2_MAX_SCREEN_SIZE * CLEARLY_PAST, ref lodState));
+			Assert.AreEqual(firstLOD + 2U, SelectLODAtScreenSize(cache, LOD_2_MAX_SCREEN_SIZE / JUST_PAST, ref lodState));
+
+			cache.Dispose();
+		}
+
+		[TestMethod]
+		public void TestCalculateScreenSizesMatchesScalarReference() {
+			// Define variables and constants
+			const int NUM_INSTANCES = 1003; // Not a multiple of four, so that the remainder is tested too
+			FrustumCuller.BoundingSphere[] modelBounds = {
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 1f),
+				new FrustumCuller.BoundingSphere(new Vector3(0.5f, -1f, 2f), 3f)
+			};
+			Transform[] transforms = new Transform[NUM_INSTANCES];
+			uint[] modelIndices = new uint[NUM_INSTANCES];
+			Vector3 viewPosition = new Vector3(1f, 2f, 3f);
+			Random random = new Random(1);
+
+			// Set up context
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				transforms[i] = new Transform(
+					Vector3.ONE * ((float) random.NextDouble() * 3f + 0.1f),
+					Quaternion.FromAxialRotation(
+						new Vector3((float) random.NextDouble() + 0.1f, (float) random.NextDouble(), (float) random.NextDouble()),
+						(float) random.NextDouble() * MathUtils.TWO_PI
+					),
+					new Vector3((float) random.NextDouble() * 200f - 100f, (float) random.NextDouble() * 200f - 100f, (float) random.NextDouble() * 200f - 100f)
+				);
+				modelIndices[i] = (uint) i % 2U;
+			}
+			transforms[5] = Transform.DEFAULT_TRANSFORM.With(translation: viewPosition); // Camera inside the instance, in the SSE2 path
+			transforms[NUM_INSTANCES - 1] = transforms[5]; // And in the scalar remainder
+
+			// Execute
+			float[] perspectiveSizes = GetScreenSizes(CalculateScreenSizes, modelBounds, transforms, modelIndices, viewPosition, true);
+			float[] referencePerspectiveSizes = GetScreenSizes(CalculateScreenSizesScalar, modelBounds, transforms, modelIndices, viewPosition, true);
+			float[] orthographicSizes = GetScreenSizes(CalculateScreenSizes, modelBounds, transforms, modelIndices, viewPosition, false);
+			float[] referenceOrthographicSizes = GetScreenSizes(CalculateScreenSizesScalar, modelBounds, transforms, modelIndices, viewPosition, false);
+
+			// Assert outcome
+			Assert.AreEqual(Single.MaxValue, perspectiveSizes[5]);
+			Assert.AreEqual(Single.MaxValue, perspectiveSizes[NUM_INSTANCES - 1]);
+			for (int i = 0; i < NUM_INSTANCES; ++i) {
+				Assert.AreEqual(referencePerspectiveSizes[i], perspectiveSizes[i], referencePerspectiveSizes[i] * 0.00001f);
+				Assert.AreEqual(referenceOrthographicSizes[i], orthographicSizes[i], referenceOrthographicSizes[i] * 0.00001f);
+			}
+		}
+		#endregion
+	}
+}
\ No newline at end of file
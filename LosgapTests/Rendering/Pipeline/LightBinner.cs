@@ -0,0 +1,84 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 00:16 by Ben Bowen
+
+using System;
+using System.Linq;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.Interop;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class LightBinnerTest {
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		// Five lights, so that both the four-at-a-time path and the remainder are used
+		private static LightProperties[] CreateTestLights() {
+			return new[] {
+				new LightProperties(new Vector3(0f, 0f, 10f), 1f, Vector3.ONE), // Centred
+				new LightProperties(new Vector3(5f, 0f, 10f), 1f, Vector3.ONE), // Right of centre
+				new LightProperties(new Vector3(0f, 0f, -10f), 1f, Vector3.ONE), // Behind the camera
+				new LightProperties(new Vector3(-5f, -5f, 10f), 1f, Vector3.ONE), // Bottom left
+				new LightProperties(new Vector3(0f, 0f, 0.5f), 2f, Vector3.ONE) // Across the camera's plane
+			};
+		}
+
+		private static void AssertRect(LightBinner.ScreenRect rect, float minX, float minY, float maxX, float maxY) {
+			const float TOLERANCE = 0.0001f;
+			Assert.AreEqual(minX, rect.MinX, TOLERANCE);
+			Assert.AreEqual(minY, rect.MinY, TOLERANCE);
+			Assert.AreEqual(maxX, rect.MaxX, TOLERANCE);
+			Assert.AreEqual(maxY, rect.MaxY, TOLERANCE);
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestCalculateScreenRects() {
+			// Define variables and constants
+			LightProperties[] lights = CreateTestLights();
+			LightBinner.ScreenRect[] rects = new LightBinner.ScreenRect[lights.Length];
+
+			// Set up context
+
+			// Execute
+			LightBinner.CalculateScreenRects(lights, (uint) lights.Length, TestCamera.CreateViewProjMat(), rects);
+
+			// Assert outcome
+			AssertRect(rects[0], 4f / 9f, 4f / 9f, 5f / 9f, 5f / 9f);
+			AssertRect(rects[1], 15f / 22f, 4f / 9f, 5f / 6f, 5f / 9f);
+			Assert.IsTrue(rects[2].IsEmpty);
+			AssertRect(rects[3], 1f / 6f, 1f / 6f, 7f / 22f, 7f / 22f);
+			AssertRect(rects[4], 0f, 0f, 1f, 1f);
+		}
+
+		[TestMethod]
+		public void TestBinLights() {
+			// Define variables and constants
+			const uint NUM_TILES_X = 2U;
+			const uint NUM_TILES_Y = 2U;
+			LightProperties[] lights = CreateTestLights();
+			uint[] tileOffsets = new uint[NUM_TILES_X * NUM_TILES_Y + 1U];
+			uint[] lightIndices = new uint[lights.Length * NUM_TILES_X * NUM_TILES_Y];
+
+			// Set up context
+
+			// Execute
+			uint numIndices = LightBinner.BinLights(lights, (uint) lights.Length, TestCamera.CreateViewProjMat(), NUM_TILES_X, NUM_TILES_Y, tileOffsets, lightIndices);
+
+			// Assert outcome
+			Assert.AreEqual(11U, numIndices);
+			Assert.IsTrue(new uint[] { 0U, 3U, 6U, 8U, 11U }.SequenceEqual(tileOffsets));
+			Assert.IsTrue(new uint[] { 0U, 3U, 4U, 0U, 1U, 4U, 0U, 4U, 0U, 1U, 4U }.SequenceEqual(lightIndices.Take((int) numIndices)));
+
+			try {
+				LightBinner.BinLights(lights, (uint) lights.Length, TestCamera.CreateViewProjMat(), NUM_TILES_X, NUM_TILES_Y, tileOffsets, new uint[numIndices - 1U]);
+				Assert.Fail();
+			}
+			catch (NativeOperationFailedException) { }
+		}
+		#endregion
+	}
+}
@@ -0,0 +1,248 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 02:57 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class MeshClustererTest {
+		private const int SPHERE_RINGS = 24;
+		private const int SPHERE_SEGMENTS = 48;
+
+		[TestInitialize]
+		public void SetUp() { }
+
+		/// <summary>
+		/// A unit sphere around the origin, with front faces (wound clockwise) facing outwards. Its poles are fans of degenerate
+		/// triangles, as a textured sphere's are.
+		/// </summary>
+		private static void CreateSphere(out Vector3[] outPositions, out uint[] outIndices) {
+			List<Vector3> positions = new List<Vector3>();
+			List<uint> indices = new List<uint>();
+			for (int r = 0; r <= SPHERE_RINGS; ++r) {
+				double polarAngle = Math.PI * r / SPHERE_RINGS;
+				double ringRadius = r == 0 || r == SPHERE_RINGS ? 0.0 : Math.Sin(polarAngle);
+				for (int s = 0; s <= SPHERE_SEGMENTS; ++s) {
+					double azimuth = 2.0 * Math.PI * (s % SPHERE_SEGMENTS) / SPHERE_SEGMENTS;
+					positions.Add(new Vector3((float) (ringRadius * Math.Cos(azimuth)), (float) Math.Cos(polarAngle), (float) (ringRadius * Math.Sin(azimuth))));
+				}
+			}
+			for (int r = 0; r < SPHERE_RINGS; ++r) {
+				for (int s = 0; s < SPHERE_SEGMENTS; ++s) {
+					uint above = (uint) (r * (SPHERE_SEGMENTS + 1) + s);
+					uint below = above + SPHERE_SEGMENTS + 1U;
+					indices.AddRange(new[] { above, above + 1U, below + 1U, above, below + 1U, below });
+				}
+			}
+			outPositions = positions.ToArray();
+			outIndices = indices.ToArray();
+		}
+
+		/// <summary>
+		/// A flat square of 16 x 16 quads, 8 units across, centred on the origin in the XY plane with its front faces towards -Z.
+		/// </summary>
+		private static void CreatePlane(out Vector3[] outPositions, out uint[] outIndices) {
+			const int NUM_QUADS = 16;
+			List<Vector3> positions = new List<Vector3>();
+			List<uint> indices = new List<uint>();
+			for (int y = 0; y <= NUM_QUADS; ++y) {
+				for (int x = 0; x <= NUM_QUADS; ++x) {
+					positions.Add(new Vector3(x * 0.5f - 4f, y * 0.5f - 4f, 0f));
+				}
+			}
+			for (int y = 0; y < NUM_QUADS; ++y) {
+				for (int x = 0; x < NUM_QUADS; ++x) {
+					uint corner = (uint) (y * (NUM_QUADS + 1) + x);
+					uint above = corner + NUM_QUADS + 1U;
+					indices.AddRange(new[] { corner, above, corner + 1U, corner + 1U, above, above + 1U });
+				}
+			}
+			outPositions = positions.ToArray();
+			outIndices = indices.ToArray();
+		}
+
+		private static bool[] GetDrawnTriangles(MeshClusterer.IndexRange[] ranges, uint numRanges, uint firstIndex, int numTriangles) {
+			bool[] result = new bool[numTriangles];
+			for (uint r = 0U; r < numRanges; ++r) {
+				for (uint i = ranges[r].FirstIndex - firstIndex; i < ranges[r].FirstIndex - firstIndex + ranges[r].NumIndices; i += 3U) {
+					result[i / 3U] = true;
+				}
+			}
+			return result;
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestBuildClustersKeepsEveryTriangle() {
+			// Define variables and constants
+			Vector3[] positions;
+			uint[] indices;
+			MeshClusterer.Cluster[] clusters;
+
+			// Set up context
+			CreateSphere(out positions, out indices);
+
+			// Execute
+			uint[] result = MeshClusterer.BuildClusters(positions, indices, out clusters);
+
+			// Assert outcome
+			Func<uint[], IEnumerable<string>> getTriangles = triIndices => Enumerable.Range(0, triIndices.Length / 3)
+				.Select(t => triIndices[t * 3] + "," + triIndices[t * 3 + 1] + "," + triIndices[t * 3 + 2]) // Winding included
+				.OrderBy(triangle => triangle, StringComparer.Ordinal);
+			Assert.AreEqual(indices.Length, result.Length);
+			Assert.IsTrue(getTriangles(indices).SequenceEqual(getTriangles(result)));
+		}
+
+		[TestMethod]
+		public void TestBuildClustersLimitsClusterSize() {
+			// Define variables and constants
+			Vector3[] positions;
+			uint[] indices;
+			MeshClusterer.Cluster[] clusters;
+
+			// Set up context
+			CreateSphere(out positions, out indices);
+
+			// Execute
+			MeshClusterer.BuildClusters(positions, indices, out clusters);
+
+			// Assert outcome
+			Assert.AreEqual((int) MeshClusterer.GetNumClusters((uint) indices.Length), clusters.Length);
+			Assert.AreEqual((indices.Length / 3 + 127) / 128, clusters.Length);
+			uint nextIndex = 0U;
+			for (int c = 0; c < clusters.Length; ++c) {
+				Assert.AreEqual(nextIndex, clusters[c].FirstIndex); // Contiguous, in index buffer order
+				if (c < clusters.Length - 1) Assert.AreEqual(MeshClusterer.MAX_CLUSTER_TRIANGLES * 3U, clusters[c].NumIndices);
+				else Assert.IsTrue(clusters[c].NumIndices > 0U && clusters[c].NumIndices <= MeshClusterer.MAX_CLUSTER_TRIANGLES * 3U);
+				nextIndex += clusters[c].NumIndices;
+			}
+			Assert.AreEqual((uint) indices.Length, nextIndex);
+		}
+
+		[TestMethod]
+		public void TestCullClustersConeCulling() {
+			// Define variables and constants
+			const uint FIRST_INDEX = 30U;
+			Vector3[] positions;
+			uint[] indices;
+			MeshClusterer.Cluster[] clusters;
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Transform facingCamera = Transform.DEFAULT_TRANSFORM.With(translation: Vector3.FORWARD * 10f);
+			Transform facingAway = facingCamera.With(rotation: Quaternion.FromAxialRotation(Vector3.UP, MathUtils.PI));
+
+			// Set up context
+			CreatePlane(out positions, out indices);
+			MeshClusterer.BuildClusters(positions, indices, out clusters);
+			MeshClusterer.IndexRange[] ranges = new MeshClusterer.IndexRange[clusters.Length];
+
+			// Execute
+			uint numFacingRanges = MeshClusterer.CullClusters(frustum, Vector3.ZERO, true, clusters, 0U, (uint) clusters.Length, facingCamera, FIRST_INDEX, ranges);
+			MeshClusterer.IndexRange facingRange = ranges[0];
+			uint numAwayRanges = MeshClusterer.CullClusters(frustum, Vector3.ZERO, true, clusters, 0U, (uint) clusters.Length, facingAway, FIRST_INDEX, ranges);
+			uint numUnculledAwayRanges = MeshClusterer.CullClusters(frustum, Vector3.ZERO, false, clusters, 0U, (uint) clusters.Length, facingAway, FIRST_INDEX, ranges);
+
+			// Assert outcome
+			Assert.IsTrue(clusters.Length > 1);
+			Assert.IsTrue(clusters.All(cluster => cluster.ConeCutoff < 1f));
+			Assert.AreEqual(1U, numFacingRanges);
+			Assert.AreEqual(FIRST_INDEX, facingRange.FirstIndex);
+			Assert.AreEqual((uint) indices.Length, facingRange.NumIndices);
+			Assert.AreEqual(0U, numAwayRanges);
+			Assert.AreEqual(1U, numUnculledAwayRanges);
+			Assert.AreEqual((uint) indices.Length, ranges[0].NumIndices);
+		}
+
+		[TestMethod]
+		public void TestCullClustersNeverCullsFrontFacingTriangles() {
+			// Define variables and constants
+			const int NUM_PLACEMENTS = 200;
+			Vector3[] positions;
+			uint[] indices;
+			MeshClusterer.Cluster[] clusters;
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Random random = new Random(1);
+			int numConeCulledTriangles = 0;
+
+			// Set up context
+			CreateSphere(out positions, out indices);
+			uint[] clusteredIndices = MeshClusterer.BuildClusters(positions, indices, out clusters);
+			MeshClusterer.IndexRange[] ranges = new MeshClusterer.IndexRange[clusters.Length];
+			int numTriangles = clusteredIndices.Length / 3;
+
+			for (int p = 0; p < NUM_PLACEMENTS; ++p) {
+				Transform transform = new Transform(
+					Vector3.ONE * ((float) random.NextDouble() * 2.5f + 0.5f),
+					Quaternion.FromAxialRotation(
+						new Vector3((float) random.NextDouble() - 0.5f, (float) random.NextDouble() - 0.5f, (float) random.NextDouble() - 0.5f + 0.01f),
+						(float) random.NextDouble() * MathUtils.TWO_PI
+					),
+					new Vector3((float) random.NextDouble() * 10f - 5f, (float) random.NextDouble() * 10f - 5f, (float) random.NextDouble() * 20f + 5f)
+				);
+				Matrix worldMat = transform.AsMatrix;
+
+				// Execute
+				uint numInFrustum = MeshClusterer.CullClusters(frustum, Vector3.ZERO, false, clusters, 0U, (uint) clusters.Length, transform, 0U, ranges);
+				bool[] inFrustum = GetDrawnTriangles(ranges, numInFrustum, 0U, numTriangles);
+				uint numDrawn = MeshClusterer.CullClusters(frustum, Vector3.ZERO, true, clusters, 0U, (uint) clusters.Length, transform, 0U, ranges);
+				bool[] drawn = GetDrawnTriangles(ranges, numDrawn, 0U, numTriangles);
+
+				// Assert outcome
+				for (int t = 0; t < numTriangles; ++t) {
+					if (!inFrustum[t] || drawn[t]) continue;
+					++numConeCulledTriangles;
+					Vector3 a = positions[clusteredIndices[t * 3]] * worldMat;
+					Vector3 b = positions[clusteredIndices[t * 3 + 1]] * worldMat;
+					Vector3 c = positions[clusteredIndices[t * 3 + 2]] * worldMat;
+					Vector3 normal = Vector3.Cross(b - a, c - a);
+					foreach (Vector3 corner in new[] { a, b, c }) {
+						Assert.IsTrue(Vector3.Dot(normal, Vector3.ZERO - corner) <= 0f, "Front-facing triangle " + t + " culled in placement " + p + ".");
+					}
+				}
+			}
+			Assert.IsTrue(numConeCulledTriangles > 0);
+		}
+
+		[TestMethod]
+		public void TestCullClustersSkipsConesForMirroredAndNonUniformTransforms() {
+			// Define variables and constants
+			const uint FIRST_INDEX = 10U;
+			Vector3[] positions;
+			uint[] indices;
+			MeshClusterer.Cluster[] clusters;
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			Transform uniform = Transform.DEFAULT_TRANSFORM.With(translation: Vector3.FORWARD * 6f);
+			Transform[] skippedTransforms = {
+				uniform.With(scale: new Vector3(-1f, 1f, 1f)),
+				uniform.With(scale: new Vector3(-1f, -1f, -1f)),
+				uniform.With(scale: new Vector3(1f, 2f, 1f))
+			};
+
+			// Set up context
+			CreateSphere(out positions, out indices);
+			MeshClusterer.BuildClusters(positions, indices, out clusters);
+			MeshClusterer.IndexRange[] ranges = new MeshClusterer.IndexRange[clusters.Length];
+
+			// Execute
+			uint numUniformRanges = MeshClusterer.CullClusters(frustum, Vector3.ZERO, true, clusters, 0U, (uint) clusters.Length, uniform, FIRST_INDEX, ranges);
+
+			// Assert outcome
+			Assert.IsTrue(ranges.Take((int) numUniformRanges).Sum(range => (long) range.NumIndices) < indices.Length); // Some clusters face away
+
+			foreach (Transform transform in skippedTransforms) {
+				// Execute
+				uint numRanges = MeshClusterer.CullClusters(frustum, Vector3.ZERO, true, clusters, 0U, (uint) clusters.Length, transform, FIRST_INDEX, ranges);
+
+				// Assert outcome
+				Assert.AreEqual(1U, numRanges);
+				Assert.AreEqual(FIRST_INDEX, ranges[0].FirstIndex);
+				Assert.AreEqual((uint) indices.Length, ranges[0].NumIndices);
+			}
+		}
+		#endregion
+	}
+}
\ No newline at end of file
@@ -78,6 +78,109 @@ namespace Ophidian.Losgap.Rendering {
 			testFS.Dispose();
 			fsCBuffer.Dispose();
 		}
+
+		[TestMethod]
+		public void TestFindInstances() {
+			// Define variables and constants
+			const int NUM_ROW_INSTANCES = 10;
+			const float ROW_SPACING = 10f;
+			FrustumCuller.BoundingSphere[] modelBounds = {
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 1f),
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 2f)
+			};
+			ModelInstanceManager testMIM = new ModelInstanceManager(modelBounds);
+			List<ModelInstanceHandle> foundInstances = new List<ModelInstanceHandle>();
+
+			// Set up context
+			ModelInstanceHandle[] rowInstances = new ModelInstanceHandle[NUM_ROW_INSTANCES];
+			for (int i = 0; i < NUM_ROW_INSTANCES; ++i) {
+				rowInstances[i] = testMIM.AllocateInstance((uint) i % 2U, 0U, 0U, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.RIGHT * ROW_SPACING * i));
+			}
+			ModelInstanceHandle largeInstance = testMIM.AllocateInstance(0U, 1U, 0U, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.UP * 50f));
+
+			// Execute
+			testMIM.FindInstances(new Sphere(ROW_SPACING * 2f, 0f, 0f, 5f), foundInstances);
+
+			// Assert outcome
+			Assert.AreEqual(1, foundInstances.Count);
+			Assert.AreEqual(rowInstances[2], foundInstances[0]);
+
+			// Execute
+			foundInstances.Clear();
+			testMIM.FindInstances(new Ray(Vector3.RIGHT * -5f, Vector3.RIGHT, ROW_SPACING * 2f + 5f), foundInstances);
+
+			// Assert outcome
+			Assert.AreEqual(3, foundInstances.Count);
+			for (int i = 0; i < 3; ++i) {
+				Assert.IsTrue(foundInstances.Contains(rowInstances[i]));
+			}
+
+			// Execute
+			testMIM.BuildStaticTree();
+			rowInstances[2].Transform = Transform.DEFAULT_TRANSFORM.With(translation: Vector3.UP * 51.5f);
+			rowInstances[0].Dispose();
+			foundInstances.Clear();
+			testMIM.FindInstances(new Sphere(Vector3.UP * 50f, 1f), foundInstances);
+			testMIM.FindInstances(new Ray(Vector3.RIGHT * -5f, Vector3.RIGHT, ROW_SPACING * 2f + 5f), foundInstances);
+
+			// Assert outcome
+			Assert.AreEqual(3, foundInstances.Count);
+			Assert.IsTrue(foundInstances.Contains(largeInstance));
+			Assert.IsTrue(foundInstances.Contains(rowInstances[2]));
+			Assert.IsTrue(foundInstances.Contains(rowInstances[1]));
+
+			testMIM.Dispose();
+		}
+
+		[TestMethod]
+		public void TestFindInstanceKeys() {
+			// Define variables and constants
+			const int NUM_ROW_INSTANCES = 10;
+			const float ROW_SPACING = 5f;
+			FrustumCuller.BoundingSphere[] modelBounds = {
+				new FrustumCuller.BoundingSphere(Vector3.ZERO, 1f)
+			};
+			ModelInstanceManager testMIM = new ModelInstanceManager(modelBounds);
+			FrustumCuller.FrustumPlanes frustum = FrustumCuller.CreateFrustum(TestCamera.CreateViewProjMat());
+			ulong[] foundKeys = new ulong[1];
+			uint start, end;
+
+			// Set up context
+			ModelInstanceHandle[] rowInstances = new ModelInstanceHandle[NUM_ROW_INSTANCES];
+			for (int i = 0; i < NUM_ROW_INSTANCES; ++i) {
+				rowInstances[i] = testMIM.AllocateInstance((uint) i % 2U, 0U, 0U, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.FORWARD * ROW_SPACING * (i + 1)));
+			}
+			testMIM.AllocateInstance(0U, 0U, 0U, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.BACKWARD * ROW_SPACING));
+			testMIM.BuildStaticTree();
+			ModelInstanceHandle dynamicInstance = testMIM.AllocateInstance(1U, 0U, 0U, Transform.DEFAULT_TRANSFORM.With(translation: Vector3.FORWARD * ROW_SPACING));
+			rowInstances[3].Transform = Transform.DEFAULT_TRANSFORM.With(translation: Vector3.BACKWARD * ROW_SPACING * 2f);
+
+			// Execute
+			uint? numKeys = testMIM.FindInstanceKeys(frustum, ref foundKeys);
+
+			// Assert outcome
+			Assert.IsTrue(numKeys.HasValue);
+			Assert.AreEqual((uint) NUM_ROW_INSTANCES, numKeys.Value);
+			for (uint i = 1U; i < numKeys.Value; ++i) {
+				Assert.IsTrue(foundKeys[i - 1U] < foundKeys[i]);
+			}
+
+			ModelInstanceManager.GetMaterialKeyRange(foundKeys, numKeys.Value, 0U, out start, out end);
+			Assert.AreEqual(5U, end - start);
+			for (uint i = start; i < end; ++i) {
+				Assert.IsTrue(rowInstances.Any(mih => mih.MaterialIndex == 0U && mih.InstanceIndex == (uint) foundKeys[i]));
+			}
+
+			ModelInstanceManager.GetMaterialKeyRange(foundKeys, numKeys.Value, 1U, out start, out end);
+			Assert.AreEqual(5U, end - start);
+			Assert.IsTrue(Enumerable.Range((int) start, (int) (end - start)).Any(i => (uint) foundKeys[i] == dynamicInstance.InstanceIndex));
+			Assert.IsFalse(Enumerable.Range((int) start, (int) (end - start)).Any(i => (uint) foundKeys[i] == rowInstances[3].InstanceIndex));
+
+			ModelInstanceManager.GetMaterialKeyRange(foundKeys, numKeys.Value, 2U, out start, out end);
+			Assert.AreEqual(start, end);
+
+			testMIM.Dispose();
+		}
 		#endregion
 	}
 }
\ No newline at end of file
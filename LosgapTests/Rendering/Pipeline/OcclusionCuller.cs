@@ -0,0 +1,149 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 00:41 by Ben Bowen
+
+using System;
+using System.Linq;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+// ReSharper disable JoinDeclarationAndInitializer
+namespace Ophidian.Losgap.Rendering {
+	[TestClass]
+	public class OcclusionCullerTest {
+		[TestInitialize]
+		public void SetUp() { }
+
+		// A 10x10 wall, 10 units in front of the test camera (so it covers the middle half of the screen)
+		private static OcclusionBuffer CreateWallBuffer() {
+			return CreateWallBuffer(5f);
+		}
+
+		private static OcclusionBuffer CreateWallBuffer(float halfWidth) {
+			OcclusionBuffer result = new OcclusionBuffer(64U, 48U);
+			result.AddOccluder(
+				new[] {
+					new Vector3(-halfWidth, -5f, 10f), new Vector3(halfWidth, -5f, 10f),
+					new Vector3(halfWidth, 5f, 10f), new Vector3(-halfWidth, 5f, 10f)
+				},
+				new[] { 0U, 1U, 2U, 0U, 2U, 3U }
+			);
+			result.Rasterize(TestCamera.CreateViewProjMat());
+			return result;
+		}
+
+		#region Tests
+		[TestMethod]
+		public void TestTestBoxes() {
+			// Define variables and constants
+			OcclusionBuffer.OcclusionBox[] boxes = {
+				new OcclusionBuffer.OcclusionBox(new Vector3(-1f, -1f, 20f), new Vector3(1f, 1f, 22f)), // Behind the wall
+				new OcclusionBuffer.OcclusionBox(new Vector3(-1f, -1f, 5f), new Vector3(1f, 1f, 6f)), // In front of the wall
+				new OcclusionBuffer.OcclusionBox(new Vector3(12f, -1f, 20f), new Vector3(14f, 1f, 22f)), // Beside the wall
+				new OcclusionBuffer.OcclusionBox(new Vector3(-1f, -1f, 0.5f), new Vector3(1f, 1f, 2f)), // Crossing the near plane
+				new OcclusionBuffer.OcclusionBox(new Vector3(40f, -1f, 20f), new Vector3(42f, 1f, 22f)), // Off screen
+				new OcclusionBuffer.OcclusionBox(new Vector3(-2f, -2f, 10.5f), new Vector3(2f, 2f, 11f)), // Just behind the wall
+				new OcclusionBuffer.OcclusionBox(new Vector3(-12f, -1f, 20f), new Vector3(-8f, 1f, 22f)) // Partly behind the wall
+			};
+			uint[] visibilityBits = { UInt32.MaxValue };
+
+			// Set up context
+			OcclusionBuffer buffer = CreateWallBuffer();
+
+			// Execute
+			buffer.TestBoxes(boxes, (uint) boxes.Length, visibilityBits);
+
+			// Assert outcome
+			Assert.AreEqual(0x4EU, visibilityBits[0]);
+			buffer.Dispose();
+		}
+
+		[TestMethod]
+		public void TestCullInstances() {
+			// Define variables and constants
+			FrustumCuller.BoundingSphere[] modelBounds = { new FrustumCuller.BoundingSphere(Vector3.ZERO, 1f) };
+			Transform[] transforms = {
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, 20f)), // Behind the wall
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, 5f)), // In front of the wall
+				new Transform(Vector3.ONE * 8f, Quaternion.IDENTITY, new Vector3(0f, 0f, 20f)), // Behind the wall, but too big to hide
+				new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(2f, 2f, 30f)) // Behind the wall
+			};
+			uint[] modelIndices = { 0U, 0U, 0U, 0U };
+			uint[] visibleIndices = new uint[transforms.Length];
+
+			// Set up context
+			OcclusionBuffer buffer = CreateWallBuffer();
+
+			// Execute
+			uint numVisible = buffer.CullInstances(modelBounds, transforms, modelIndices, (uint) transforms.Length, visibleIndices);
+
+			// Assert outcome
+			Assert.IsTrue(new uint[] { 1U, 2U }.SequenceEqual(visibleIndices.Take((int) numVisible)));
+			buffer.Dispose();
+		}
+
+		[TestMethod]
+		public void TestCoverageIsInnerConservative() {
+			// Define variables and constants
+			const float WALL_HALF_WIDTH = 5.1875f; // Puts the wall's left edge at x = 15.4, to the right of the centre of pixel 15
+			OcclusionBuffer.OcclusionBox[] boxes = {
+				new OcclusionBuffer.OcclusionBox(new Vector3(-10.6f, -0.1f, 20f), new Vector3(-10.45f, 0.1f, 20.05f)), // Beside the wall, in pixel 15
+				new OcclusionBuffer.OcclusionBox(new Vector3(-1f, -1f, 20f), new Vector3(1f, 1f, 22f)) // Behind the wall, across its diagonal
+			};
+			uint[] visibilityBits = { UInt32.MaxValue };
+
+			// Set up context
+			OcclusionBuffer buffer = CreateWallBuffer(WALL_HALF_WIDTH);
+
+			// Execute
+			buffer.TestBoxes(boxes, (uint) boxes.Length, visibilityBits);
+
+			// Assert outcome
+			Assert.AreEqual(0x1U, visibilityBits[0]);
+			buffer.Dispose();
+		}
+
+		[TestMethod]
+		public void TestRasterizationIsDeterministic() {
+			// Define variables and constants
+			const int NUM_TRIANGLES = 500;
+			const int NUM_BOXES = 2000;
+			Random random = new Random(1);
+			Vector3[] positions = new Vector3[NUM_TRIANGLES * 3];
+			uint[] indices = new uint[NUM_TRIANGLES * 3];
+			for (int i = 0; i < positions.Length; ++i) {
+				positions[i] = new Vector3((float) random.NextDouble() * 40f - 20f, (float) random.NextDouble() * 40f - 20f, (float) random.NextDouble() * 50f + 5f);
+				indices[i] = (uint) i;
+			}
+			OcclusionBuffer.OcclusionBox[] boxes = new OcclusionBuffer.OcclusionBox[NUM_BOXES];
+			for (int i = 0; i < NUM_BOXES; ++i) {
+				Vector3 min = new Vector3((float) random.NextDouble() * 60f - 30f, (float) random.NextDouble() * 60f - 30f, (float) random.NextDouble() * 60f + 5f);
+				boxes[i] = new OcclusionBuffer.OcclusionBox(min, min + Vector3.ONE * (float) random.NextDouble() * 3f);
+			}
+			uint[] serialBits = new uint[NUM_BOXES / 32 + 1];
+			uint[] parallelBits = new uint[NUM_BOXES / 32 + 1];
+
+			// Set up context
+			OcclusionBuffer buffer = new OcclusionBuffer(256U, 128U);
+			buffer.AddOccluder(positions, indices);
+
+			// Execute
+			buffer.Rasterize(TestCamera.CreateViewProjMat());
+			buffer.TestBoxes(boxes, NUM_BOXES, serialBits);
+			NativeJobSystem.Start(4U);
+			try {
+				buffer.Rasterize(TestCamera.CreateViewProjMat());
+				buffer.TestBoxes(boxes, NUM_BOXES, parallelBits);
+			}
+			finally {
+				NativeJobSystem.Stop();
+			}
+
+			// Assert outcome
+			Assert.IsTrue(serialBits.Any(word => word != 0U));
+			Assert.IsTrue(serialBits.Any(word => word != UInt32.MaxValue));
+			Assert.IsTrue(serialBits.SequenceEqual(parallelBits));
+			buffer.Dispose();
+		}
+		#endregion
+	}
+}
@@ -6,8 +6,10 @@ using System;
 using System.Collections;
 using System.Collections.Generic;
 using System.Linq;
+using System.Runtime.InteropServices;
 using System.Security.Principal;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.Interop;
 
 // ReSharper disable JoinDeclarationAndInitializer
 namespace Ophidian.Losgap.Rendering {
@@ -780,6 +782,182 @@ namespace Ophidian.Losgap.Rendering {
 
 			cb.Dispose();
 		}
+
+		[TestMethod]
+		public unsafe void TestRedundantStateFilter() {
+			// Define variables and constants
+			IntPtr* cbufferArr = stackalloc IntPtr[2];
+			cbufferArr[0] = new IntPtr(0x100);
+			cbufferArr[1] = new IntPtr(0x200);
+			IntPtr* rtvArr = stackalloc IntPtr[1];
+			rtvArr[0] = new IntPtr(0x300);
+			IntPtr* srvArr = stackalloc IntPtr[1];
+			srvArr[0] = new IntPtr(0x400);
+			RenderCommand[] commands = {
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)),
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)),
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x20)),
+				new RenderCommand(RenderCommandInstruction.FSSetCBuffers, (IntPtr) cbufferArr, 2U, 0U),
+				new RenderCommand(RenderCommandInstruction.FSSetCBuffers, (IntPtr) (cbufferArr + 1), 1U, 1U),
+				new RenderCommand(RenderCommandInstruction.VSSetCBuffers, (IntPtr) (cbufferArr + 1), 1U, 1U),
+				new RenderCommand(RenderCommandInstruction.FSSetResources, (IntPtr) srvArr, 1U, 0U),
+				new RenderCommand(RenderCommandInstruction.SetRenderTargets, (IntPtr) rtvArr, IntPtr.Zero, 1U),
+				new RenderCommand(RenderCommandInstruction.FSSetResources, (IntPtr) srvArr, 1U, 0U),
+				new RenderCommand(RenderCommandInstruction.FinishCommandList, IntPtr.Zero),
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x20)),
+			};
+			uint numFiltered;
+
+			// Set up context
+			GCHandle pinnedCommands = GCHandle.Alloc(commands, GCHandleType.Pinned);
+
+			// Execute
+			try {
+				InteropUtils.CallNative(
+					NativeMethods.RenderPassManager_FilterRedundantState,
+					pinnedCommands.AddrOfPinnedObject(),
+					(uint) commands.Length,
+					(IntPtr) (&numFiltered)
+				).ThrowOnFailure();
+			}
+			finally {
+				pinnedCommands.Free();
+			}
+
+			// Assert outcome
+			Assert.AreEqual(2U, numFiltered);
+			Assert.AreEqual(RenderCommandInstruction.SetRSState, commands[0].Instruction);
+			Assert.AreEqual(RenderCommandInstruction.NoOperation, commands[1].Instruction);
+			Assert.AreEqual(RenderCommandInstruction.SetRSState, commands[2].Instruction);
+			Assert.AreEqual(RenderCommandInstruction.NoOperation, commands[4].Instruction);
+			Assert.AreEqual(RenderCommandInstruction.VSSetCBuffers, commands[5].Instruction);
+			Assert.AreEqual(RenderCommandInstruction.FSSetResources, commands[8].Instruction);
+			Assert.AreEqual(RenderCommandInstruction.SetRSState, commands[10].Instruction);
+		}
+
+		[TestMethod]
+		public void TestDrawSorterEmitCommands() {
+			// Define variables and constants
+			DrawSorter.DrawRecord[] records = {
+				new DrawSorter.DrawRecord { Model = 2U, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Model = 1U, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Model = 2U, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Model = 1U, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Model = 0U, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Model = 0U, NumInstances = 0U }
+			};
+			DrawSorter.ModelBufferRange[] models = {
+				new DrawSorter.ModelBufferRange { FirstVertexIndex = 0, FirstIndexIndex = 0U, NumIndices = 30U },
+				new DrawSorter.ModelBufferRange { FirstVertexIndex = 100, FirstIndexIndex = 30U, NumIndices = 60U },
+				new DrawSorter.ModelBufferRange { FirstVertexIndex = 200, FirstIndexIndex = 90U, NumIndices = 90U }
+			};
+			uint[] order = { 4U, 3U, 1U, 5U, 2U, 0U };
+			RenderCommand[] commands = new RenderCommand[records.Length];
+			uint numCommands;
+
+			// Set up context
+
+			// Execute
+			numCommands = DrawSorter.EmitCommands(records, order, (uint) records.Length, models, true, 10U, commands);
+
+			// Assert outcome
+			Assert.AreEqual(3U, numCommands);
+			Assert.AreEqual(RenderCommand.DrawIndexedInstanced(0, 0U, 30U, 10U, 1U), commands[0]);
+			Assert.AreEqual(RenderCommand.DrawIndexedInstanced(100, 30U, 60U, 11U, 2U), commands[1]);
+			Assert.AreEqual(RenderCommand.DrawIndexedInstanced(200, 90U, 90U, 13U, 2U), commands[2]);
+		}
+
+		[TestMethod]
+		public void TestDrawSorterSortAndEmitState() {
+			// Define variables and constants
+			DrawSorter.DrawRecord[] records = {
+				new DrawSorter.DrawRecord { Shader = 1U, Material = 1U, Model = 0U, Depth = 5f, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Shader = 0U, Material = 0U, Model = 1U, Depth = 9f, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Shader = 1U, Material = 1U, Model = 0U, Depth = 1f, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Shader = 0U, Material = 0U, Model = 1U, Depth = 3f, NumInstances = 1U },
+				new DrawSorter.DrawRecord { Shader = 1U, Material = 2U, Model = 0U, Depth = 2f, NumInstances = 1U }
+			};
+			DrawSorter.ModelBufferRange[] models = {
+				new DrawSorter.ModelBufferRange { FirstVertexIndex = 0, FirstIndexIndex = 0U, NumIndices = 30U },
+				new DrawSorter.ModelBufferRange { FirstVertexIndex = 100, FirstIndexIndex = 30U, NumIndices = 60U }
+			};
+			RenderCommand[] shaderCommands = {
+				new RenderCommand(RenderCommandInstruction.FSSetShader, 10),
+				new RenderCommand(RenderCommandInstruction.FSSetShader, 11),
+				new RenderCommand(RenderCommandInstruction.ClearDepthStencil, 11)
+			};
+			uint[] shaderCommandOffsets = { 0U, 1U, 3U };
+			RenderCommand[] materialCommands = {
+				new RenderCommand(RenderCommandInstruction.SetVertexBuffers, 20, 0),
+				new RenderCommand(RenderCommandInstruction.SetVertexBuffers, 21, 0),
+				new RenderCommand(RenderCommandInstruction.SetVertexBuffers, 22, 0)
+			};
+			uint[] materialCommandOffsets = { 0U, 1U, 2U, 3U };
+			uint[] opaqueOrder = new uint[records.Length];
+			uint[] alphaOrder = new uint[records.Length];
+			RenderCommand[] commands = new RenderCommand[10];
+			uint numCommands;
+
+			// Set up context
+			DrawSorter.Sort(DrawSorter.AlphaBackToFront, records, (uint) records.Length, alphaOrder);
+
+			// Execute
+			DrawSorter.Sort(DrawSorter.OpaqueStateFirst, records, (uint) records.Length, opaqueOrder);
+			numCommands = DrawSorter.EmitCommands(
+				records,
+				opaqueOrder,
+				(uint) records.Length,
+				models,
+				shaderCommands,
+				shaderCommandOffsets,
+				materialCommands,
+				materialCommandOffsets,
+				true,
+				0U,
+				commands
+			);
+
+			// Assert outcome
+			Assert.IsTrue(new uint[] { 1U, 0U, 3U, 4U, 2U }.SequenceEqual(alphaOrder));
+			Assert.IsTrue(new uint[] { 3U, 1U, 2U, 0U, 4U }.SequenceEqual(opaqueOrder));
+			Assert.AreEqual(9U, numCommands);
+			Assert.AreEqual(shaderCommands[0], commands[0]);
+			Assert.AreEqual(materialCommands[0], commands[1]);
+			Assert.AreEqual(RenderCommand.DrawIndexedInstanced(100, 30U, 60U, 0U, 2U), commands[2]);
+			Assert.AreEqual(shaderCommands[1], commands[3]);
+			Assert.AreEqual(shaderCommands[2], commands[4]);
+			Assert.AreEqual(materialCommands[1], commands[5]);
+			Assert.AreEqual(RenderCommand.DrawIndexedInstanced(0, 0U, 30U, 2U, 2U), commands[6]);
+			Assert.AreEqual(materialCommands[2], commands[7]);
+			Assert.AreEqual(RenderCommand.DrawIndexedInstanced(0, 0U, 30U, 4U, 1U), commands[8]);
+		}
+
+		[TestMethod]
+		public void TestDrawSorterSortByDistance() {
+			// Define variables and constants
+			Vector3 viewPosition = new Vector3(0f, 0f, -10f);
+			Transform[] transforms = new Transform[9]; // Enough for one four-wide block plus a remainder
+			float[] translationZs = { 30f, -9f, 5f, 30f, 0f, 100f, -10f, 20f, -12f };
+			uint[] models = { 1U, 0U, 1U, 0U, 1U, 0U, 1U, 0U, 1U };
+			uint[] frontToBack = new uint[transforms.Length];
+			uint[] backToFront = new uint[transforms.Length];
+			uint[] groupedFrontToBack = new uint[transforms.Length];
+
+			// Set up context
+			for (int i = 0; i < transforms.Length; ++i) {
+				transforms[i] = new Transform(Vector3.ONE, Quaternion.IDENTITY, new Vector3(0f, 0f, translationZs[i]));
+			}
+
+			// Execute
+			DrawSorter.SortByDistance(transforms, null, (uint) transforms.Length, viewPosition, false, frontToBack);
+			DrawSorter.SortByDistance(transforms, null, (uint) transforms.Length, viewPosition, true, backToFront);
+			DrawSorter.SortByDistance(transforms, models, (uint) transforms.Length, viewPosition, false, groupedFrontToBack);
+
+			// Assert outcome
+			Assert.IsTrue(new uint[] { 6U, 1U, 8U, 4U, 2U, 7U, 0U, 3U, 5U }.SequenceEqual(frontToBack));
+			Assert.IsTrue(new uint[] { 5U, 0U, 3U, 7U, 2U, 4U, 8U, 1U, 6U }.SequenceEqual(backToFront));
+			Assert.IsTrue(new uint[] { 1U, 7U, 3U, 5U, 6U, 8U, 4U, 2U, 0U }.SequenceEqual(groupedFrontToBack));
+		}
 		#endregion
 	}
 }
\ No newline at end of file
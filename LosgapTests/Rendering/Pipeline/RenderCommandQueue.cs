@@ -3,12 +3,56 @@
 // Created on 24 02 2015 at 15:07 by Ben Bowen
 
 using System;
+using System.IO;
+using System.Runtime.InteropServices;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
+using Ophidian.Losgap.Interop;
 
 // ReSharper disable JoinDeclarationAndInitializer
 namespace Ophidian.Losgap.Rendering {
 	[TestClass]
 	public class RenderCommandQueueTest {
+		private const string NATIVE_DLL_NAME = "RenderingNative.dll";
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RecordParallelCommandStreams")]
+		private static extern InteropBool RecordParallelCommandStreams(
+			IntPtr failReason,
+			IntPtr commandStreamArr, // byte**
+			IntPtr commandStreamLenArr, // uint*
+			uint numStreams,
+			IntPtr outLog, // char16_t*
+			uint outLogLen
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "ProfileCommandStream")]
+		private static extern InteropBool ProfileCommandStream(
+			IntPtr failReason,
+			IntPtr commandStream,
+			uint commandStreamLenBytes,
+			IntPtr outSnapshot // FlushProfileSnapshot*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "CaptureCommandStream")]
+		private static extern InteropBool CaptureCommandStream(
+			IntPtr failReason,
+			IntPtr deviceContext,
+			IntPtr commandStream,
+			uint commandStreamLenBytes
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "CaptureParallelCommandStreams")]
+		private static extern InteropBool CaptureParallelCommandStreams(
+			IntPtr failReason,
+			IntPtr immediateContext,
+			IntPtr deferredContextArr, // ID3D11DeviceContext**
+			IntPtr commandStreamArr, // byte**
+			IntPtr commandStreamLenArr, // uint*
+			uint numStreams
+		);
 
 		[TestInitialize]
 		public void SetUp() { }
@@ -24,8 +68,8 @@ namespace Ophidian.Losgap.Rendering {
 			Action c = () => Console.WriteLine("C");
 
 			testRCQ.QueueAction(a);
-			testRCQ.QueueCommand(new RenderCommand(RenderCommandInstruction.FSSetShader, 1, 2, 3));
-			testRCQ.QueueCommand(new RenderCommand(RenderCommandInstruction.ClearDepthStencil, -1, -2, -3));
+			testRCQ.QueueCommand(new RenderCommand(RenderCommandInstruction.FSSetShader, 1));
+			testRCQ.QueueCommand(new RenderCommand(RenderCommandInstruction.ClearDepthStencil, -1));
 			uint comSlot = testRCQ.ReserveCommandSlot();
 			testRCQ.QueueAction(b);
 			testRCQ.QueueCommand(new RenderCommand(RenderCommandInstruction.SetVertexBuffers, 9, 10));
@@ -36,16 +80,274 @@ namespace Ophidian.Losgap.Rendering {
 			RCQItem[] queuedItems = testRCQ.GetCurrentQueue();
 
 			Assert.AreEqual(a, (Action) queuedItems[0]);
-			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.FSSetShader, 1, 2, 3), (RenderCommand) queuedItems[1]);
-			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.ClearDepthStencil, -1, -2, -3), (RenderCommand) queuedItems[2]);
+			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.FSSetShader, 1), (RenderCommand) queuedItems[1]);
+			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.ClearDepthStencil, -1), (RenderCommand) queuedItems[2]);
 			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.SetIndexBuffer), (RenderCommand) queuedItems[3]);
 			Assert.AreEqual(b, (Action) queuedItems[4]);
 			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.SetVertexBuffers, 9, 10), (RenderCommand) queuedItems[5]);
-#if !DEVELOPMENT && !RELEASE
-			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.NoOperation, 12345678, 12345678, 12345678), (RenderCommand) queuedItems[6]);
-#endif
+			Assert.AreEqual(new RenderCommand(RenderCommandInstruction.NoOperation), (RenderCommand) queuedItems[6]);
 			Assert.AreEqual(c, (Action) queuedItems[7]);
-		} 
+		}
+
+		[TestMethod]
+		public unsafe void TestCompactStreamRoundTrip() {
+			// Define variables and constants
+			RenderCommand[] commands = {
+				RenderCommand.DrawIndexedInstanced(100, 200U, 300U, 400U, 500U),
+				RenderCommand.DrawIndexedInstanced(-5, 1U, 2U, 3U, 4U),
+				RenderCommand.DrawIndexedInstanced(0x1000000, 1U, 2U, 3U, 4U),
+				new RenderCommand(RenderCommandInstruction.SetPrimitiveTopology, (int) RenderCommand.DEFAULT_PRIMITIVE_TOPOLOGY),
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x1234)),
+				new RenderCommand(RenderCommandInstruction.FSSetResources, new IntPtr(0x2000), 16U, 3U),
+				new RenderCommand(RenderCommandInstruction.SetInstanceBuffer, new IntPtr(0x3000), 1U),
+				new RenderCommand(RenderCommandInstruction.CBDiscardWrite, new IntPtr(0x4000), new IntPtr(0x5000), 64U),
+				new RenderCommand(RenderCommandInstruction.SetRenderTargets, new IntPtr(0x6000), new IntPtr(0x7000), 2U),
+				RenderCommand.Draw(7, 8U),
+				new RenderCommand(RenderCommandInstruction.NoOperation)
+			};
+			const uint STREAM_LEN = 1024U;
+			RenderCommand[] nativeDecodedCommands = new RenderCommand[commands.Length];
+			uint numNativeDecodedCommands;
+
+			// Set up context
+			AlignedAllocation<byte> stream = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, STREAM_LEN);
+			uint streamLen = 0U;
+
+			// Execute
+			foreach (RenderCommand command in commands) streamLen = CompactCommandStream.Encode(command, stream.AlignedPointer, streamLen);
+			fixed (RenderCommand* nativeDecodedCommandsPtr = nativeDecodedCommands) {
+				InteropUtils.CallNative(
+					NativeMethods.RenderPassManager_DecodeCompactInstructions,
+					stream.AlignedPointer,
+					streamLen,
+					(IntPtr) nativeDecodedCommandsPtr,
+					(uint) nativeDecodedCommands.Length,
+					(IntPtr) (&numNativeDecodedCommands)
+				).ThrowOnFailure();
+			}
+
+			// Assert outcome
+			Assert.IsTrue(streamLen <= commands.Length * sizeof(RenderCommand) / 2);
+			Assert.AreEqual((uint) commands.Length, numNativeDecodedCommands);
+			uint streamOffset = 0U;
+			for (int i = 0; i < commands.Length; ++i) {
+				Assert.AreEqual(commands[i], CompactCommandStream.Decode(stream.AlignedPointer, ref streamOffset));
+				Assert.AreEqual(commands[i], nativeDecodedCommands[i]);
+			}
+			Assert.AreEqual(streamLen, streamOffset);
+
+			stream.Dispose();
+		}
+
+		[TestMethod]
+		public unsafe void TestCompactStreamTruncation() {
+			// Define variables and constants
+			RenderCommand[] commands = {
+				RenderCommand.DrawIndexedInstanced(0x1000000, 1U, 2U, 3U, 4U),
+				new RenderCommand(RenderCommandInstruction.CBDiscardWrite, new IntPtr(0x4000), new IntPtr(0x5000), 64U)
+			};
+			const uint STREAM_LEN = 1024U;
+			RenderCommand[] nativeDecodedCommands = new RenderCommand[commands.Length];
+			uint numNativeDecodedCommands;
+			int numFailedDecodes = 0;
+			bool boundaryDecodeFailed = false;
+
+			// Set up context
+			AlignedAllocation<byte> stream = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, STREAM_LEN);
+			uint firstCommandLen = CompactCommandStream.Encode(commands[0], stream.AlignedPointer, 0U);
+			uint streamLen = CompactCommandStream.Encode(commands[1], stream.AlignedPointer, firstCommandLen);
+
+			// Execute
+			for (uint truncatedLen = sizeof(uint); truncatedLen < streamLen; truncatedLen += sizeof(uint)) {
+				try {
+					fixed (RenderCommand* nativeDecodedCommandsPtr = nativeDecodedCommands) {
+						InteropUtils.CallNative(
+							NativeMethods.RenderPassManager_DecodeCompactInstructions,
+							stream.AlignedPointer,
+							truncatedLen,
+							(IntPtr) nativeDecodedCommandsPtr,
+							(uint) nativeDecodedCommands.Length,
+							(IntPtr) (&numNativeDecodedCommands)
+						).ThrowOnFailure();
+					}
+				}
+				catch (NativeOperationFailedException) {
+					++numFailedDecodes;
+					if (truncatedLen == firstCommandLen) boundaryDecodeFailed = true;
+				}
+			}
+
+			// Assert outcome
+			Assert.IsFalse(boundaryDecodeFailed);
+			Assert.AreEqual((int) (streamLen / sizeof(uint)) - 2, numFailedDecodes); // Every cut except the one between the two commands fails
+
+			stream.Dispose();
+		}
+
+		[TestMethod]
+		public unsafe void TestParallelFlushOrder() {
+			// Define variables and constants
+			RenderCommand[][] streamCommands = {
+				new[] {
+					new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)),
+					RenderCommand.Draw(0, 3U)
+				},
+				new[] {
+					new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x20)),
+					RenderCommand.Draw(3, 6U),
+					new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x20)) // Redundant
+				},
+				new RenderCommand[0]
+			};
+			const uint STREAM_LEN = 1024U;
+			const uint LOG_LEN = 1024U;
+			const string EXPECTED_LOG = "RSSetState(16)\nDraw(3, 0)\nRSSetState(32)\nDraw(6, 3)\n";
+
+			// Set up context
+			AlignedAllocation<byte>[] streams = new AlignedAllocation<byte>[streamCommands.Length];
+			IntPtr* streamPtrs = stackalloc IntPtr[streamCommands.Length];
+			uint* streamLens = stackalloc uint[streamCommands.Length];
+			for (int i = 0; i < streamCommands.Length; ++i) {
+				streams[i] = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, STREAM_LEN);
+				streamPtrs[i] = streams[i].AlignedPointer;
+				streamLens[i] = 0U;
+				foreach (RenderCommand command in streamCommands[i]) {
+					streamLens[i] = CompactCommandStream.Encode(command, streamPtrs[i], streamLens[i]);
+				}
+			}
+			char* log = stackalloc char[(int) LOG_LEN];
+
+			// Execute
+			InteropUtils.CallNative(
+				RecordParallelCommandStreams,
+				(IntPtr) streamPtrs,
+				(IntPtr) streamLens,
+				(uint) streamCommands.Length,
+				(IntPtr) log,
+				LOG_LEN
+			).ThrowOnFailure();
+
+			// Assert outcome
+			Assert.AreEqual(EXPECTED_LOG, new string(log));
+
+			foreach (AlignedAllocation<byte> stream in streams) stream.Dispose();
+		}
+
+		[TestMethod]
+		public unsafe void TestFlushProfile() {
+			// Define variables and constants
+			const uint STREAM_LEN = 1024U;
+			const uint CBUFFER_DATA_LEN = 64U;
+			byte* cbufferData = stackalloc byte[(int) CBUFFER_DATA_LEN];
+			RenderCommand[] commands = {
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)),
+				new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)), // Redundant
+				new RenderCommand(RenderCommandInstruction.CBDiscardWrite, new IntPtr(0x30), (IntPtr) cbufferData, CBUFFER_DATA_LEN),
+				RenderCommand.Draw(0, 3U),
+				RenderCommand.Draw(3, 3U)
+			};
+
+			// Set up context
+			AlignedAllocation<byte> stream = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, STREAM_LEN);
+			uint streamLen = 0U;
+			foreach (RenderCommand command in commands) streamLen = CompactCommandStream.Encode(command, stream.AlignedPointer, streamLen);
+			RenderFlushProfiler.FlushProfileSnapshot snapshot;
+
+			// Execute
+			InteropUtils.CallNative(ProfileCommandStream, stream.AlignedPointer, streamLen, (IntPtr) (&snapshot)).ThrowOnFailure();
+			RenderFlushProfile profile = RenderFlushProfiler.ToProfile(&snapshot);
+
+			// Assert outcome
+			Assert.IsFalse(profile.IsImmediateContext);
+			Assert.AreEqual(1UL, profile.NumFlushes);
+			Assert.AreEqual(4UL, profile.TotalCount);
+			Assert.AreEqual(1UL, profile.TotalSkippedCount);
+			Assert.AreEqual(1UL, profile.GetInstructionProfile((int) RenderCommandInstruction.SetRSState).Count);
+			Assert.AreEqual(1UL, profile.GetInstructionProfile((int) RenderCommandInstruction.SetRSState).SkippedCount);
+			Assert.AreEqual(2UL, profile.GetInstructionProfile((int) RenderCommandInstruction.Draw).Count);
+			Assert.AreEqual("Draw", profile.GetInstructionProfile((int) RenderCommandInstruction.Draw).Instruction);
+			Assert.AreEqual((ulong) CBUFFER_DATA_LEN, profile.ConstantBufferBytesWritten);
+			Assert.AreEqual(0UL, profile.BufferBytesWritten);
+
+			stream.Dispose();
+		}
+
+		[TestMethod]
+		public unsafe void TestCaptureReplay() {
+			// Define variables and constants
+			const uint STREAM_LEN = 1024U;
+			const uint CBUFFER_DATA_LEN = 64U;
+			const uint NUM_REPETITIONS = 2U;
+			byte* cbufferData = stackalloc byte[(int) CBUFFER_DATA_LEN];
+			RenderCommand[][] deferredCommands = {
+				new[] {
+					new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)),
+					RenderCommand.Draw(0, 3U),
+					new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)), // Redundant
+					new RenderCommand(RenderCommandInstruction.CBDiscardWrite, new IntPtr(0x30), (IntPtr) cbufferData, CBUFFER_DATA_LEN)
+				},
+				new[] {
+					new RenderCommand(RenderCommandInstruction.SetRSState, new IntPtr(0x10)),
+					RenderCommand.DrawIndexedInstanced(0, 0U, 6U, 0U, 4U)
+				}
+			};
+			RenderCommand[] immediateCommands = {
+				new RenderCommand(RenderCommandInstruction.SwapChainPresent, new IntPtr(0x50))
+			};
+			IntPtr immediateContext = new IntPtr(0x1000);
+			IntPtr* deferredContexts = stackalloc IntPtr[2];
+			deferredContexts[0] = new IntPtr(0x2000);
+			deferredContexts[1] = new IntPtr(0x3000);
+			string captureFilePath = Path.Combine(Path.GetTempPath(), "RenderCaptureTest.bin");
+
+			// Set up context
+			AlignedAllocation<byte>[] streams = new AlignedAllocation<byte>[deferredCommands.Length + 1];
+			IntPtr* streamPtrs = stackalloc IntPtr[streams.Length];
+			uint* streamLens = stackalloc uint[streams.Length];
+			for (int i = 0; i < streams.Length; ++i) {
+				streams[i] = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, STREAM_LEN);
+				streamPtrs[i] = streams[i].AlignedPointer;
+				streamLens[i] = 0U;
+				foreach (RenderCommand command in (i < deferredCommands.Length ? deferredCommands[i] : immediateCommands)) {
+					streamLens[i] = CompactCommandStream.Encode(command, streamPtrs[i], streamLens[i]);
+				}
+			}
+
+			// Execute
+			RenderCapture.Begin(captureFilePath);
+			InteropUtils.CallNative(
+				CaptureParallelCommandStreams,
+				immediateContext,
+				(IntPtr) deferredContexts,
+				(IntPtr) streamPtrs,
+				(IntPtr) streamLens,
+				(uint) deferredCommands.Length
+			).ThrowOnFailure();
+			InteropUtils.CallNative(
+				CaptureCommandStream,
+				immediateContext,
+				streamPtrs[deferredCommands.Length],
+				streamLens[deferredCommands.Length]
+			).ThrowOnFailure();
+			RenderCapture.End();
+			RenderCaptureReplayResult result = RenderCapture.ReplayOnCountingContexts(captureFilePath, NUM_REPETITIONS);
+			File.Delete(captureFilePath);
+
+			// Assert outcome
+			Assert.IsFalse(RenderCapture.IsCapturing);
+			Assert.AreEqual(3U, result.NumContexts);
+			Assert.AreEqual(9UL * NUM_REPETITIONS, result.NumCommands); // Including one FinishCommandList per deferred context
+			Assert.AreEqual(1UL * NUM_REPETITIONS, result.NumSkippedCommands);
+			Assert.AreEqual(11UL * NUM_REPETITIONS, result.NumContextCalls);
+			Assert.AreEqual(2UL * NUM_REPETITIONS, result.NumDrawCalls);
+			Assert.AreEqual(5UL * NUM_REPETITIONS, result.NumInstancesDrawn);
+			Assert.AreEqual(1UL * NUM_REPETITIONS, result.NumMaps);
+			Assert.AreEqual(2UL * NUM_REPETITIONS, result.NumCommandListsFinished);
+			Assert.AreEqual(2UL * NUM_REPETITIONS, result.NumCommandListsExecuted);
+			Assert.AreEqual(1UL * NUM_REPETITIONS, result.NumPresents);
+
+			foreach (AlignedAllocation<byte> stream in streams) stream.Dispose();
+		}
 		#endregion
 	}
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 02:04 by Ben Bowen
+
+using System;
+using System.Linq;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// The camera shared by the culling and binning tests: at the origin looking down +Z, with a 90 degree field of view and near/far
+	/// planes at <see cref="NEAR_PLANE"/> and <see cref="FAR_PLANE"/>.
+	/// </summary>
+	internal static class TestCamera {
+		public const float NEAR_PLANE = 1f;
+		public const float FAR_PLANE = 100f;
+
+		public static Matrix CreateViewProjMat() {
+			return new Matrix(
+				1f, 0f, 0f, 0f,
+				0f, 1f, 0f, 0f,
+				0f, 0f, FAR_PLANE / (FAR_PLANE - NEAR_PLANE), 1f,
+				0f, 0f, -NEAR_PLANE * FAR_PLANE / (FAR_PLANE - NEAR_PLANE), 0f
+			);
+		}
+	}
+}
\ No newline at end of file
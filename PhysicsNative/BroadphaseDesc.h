@@ -0,0 +1,33 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "btBulletDynamicsCommon.h"
+
+namespace losgap {
+	/*
+	An enumeration of the broadphase implementations that the physics world can be built on
+	*/
+	enum BroadphaseType : uint32_t {
+		DynamicTree = 0U,
+		AxisSweep16 = 1U,
+		AxisSweep32 = 2U
+	};
+
+	/*
+	An interop struct detailing which broadphase to use and, for the sweep-and-prune types, the bounds of the world.
+	Sweep-and-prune quantizes positions against these bounds, so bodies that leave them are clamped to the edges.
+	*/
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct BroadphaseDesc {
+		btVector3 WorldMin;
+		btVector3 WorldMax;
+		BroadphaseType Type;
+		uint32_t MaxHandles;
+
+		BroadphaseDesc() : WorldMin(btVector3 { -1000.0f, -1000.0f, -1000.0f }), WorldMax(btVector3 { 1000.0f, 1000.0f, 1000.0f }), Type(DynamicTree), MaxHandles(16384U) { }
+	};
+#pragma pack(pop)
+}
@@ -0,0 +1,726 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "PhysicsJournal.h"
+#include "PhysicsManager.h"
+#include "LosgapMotionState.h"
+#include <fstream>
+#include <unordered_map>
+#include "../CoreNative/Platform.h"
+
+namespace losgap {
+	const uint32_t JOURNAL_MAGIC = 0x4A50534CU; // "LSPJ"
+	const uint32_t JOURNAL_VERSION = 1U;
+	const size_t JOURNAL_FLUSH_THRESHOLD_BYTES = 64U * 1024U;
+
+	std::atomic<bool> PhysicsJournal::isRecording { false };
+	std::mutex PhysicsJournal::journalLock;
+	std::vector<char> PhysicsJournal::writeBuffer;
+
+	std::ofstream journalFile;
+
+	/*
+	The managed-side memory that a recorded body's motion state reads from. Kept so that transform sets and kinematic
+	motion (which Bullet reads straight from the motion state every step) can be captured by value.
+	*/
+	struct JournalBodySource {
+		const btVector3* TranslationPtr;
+		const btQuaternion* RotationPtr;
+		const btVector3* TranslationOffsetPtr;
+		bool IsKinematic;
+	};
+	std::unordered_map<const btRigidBody*, JournalBodySource> recordedBodies;
+
+#pragma region Recording
+	void PhysicsJournal::WriteBytes(const void* data, size_t numBytes) {
+		const char* dataAsChars = static_cast<const char*>(data);
+		writeBuffer.insert(writeBuffer.end(), dataAsChars, dataAsChars + numBytes);
+	}
+
+	void PhysicsJournal::FlushBuffer() {
+		if (writeBuffer.empty()) return;
+		journalFile.write(&writeBuffer.front(), writeBuffer.size());
+		writeBuffer.clear();
+	}
+
+	void PhysicsJournal::WriteHullPoints(const btConvexHullShape* hull) {
+		uint32_t numPoints = static_cast<uint32_t>(hull->getNumPoints());
+		WriteValue(numPoints);
+		const btVector3* points = hull->getUnscaledPoints();
+		for (uint32_t i = 0U; i < numPoints; ++i) {
+			WriteValue(points[i]);
+		}
+	}
+
+	void PhysicsJournal::BeginRecording(const char* journalFilePath) {
+		if (journalFilePath == nullptr) throw LosgapException { "Journal file path must not be null." };
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (IsRecording()) throw LosgapException { "A physics journal is already being recorded." };
+		// A journal has to see every body created, or later calls on those bodies could never be replayed
+		if (PhysicsManager::IsRunning()) throw LosgapException { "Physics journal recording must begin before the physics engine is started." };
+
+		journalFile.open(journalFilePath, std::ofstream::binary | std::ofstream::trunc);
+		if (!journalFile) throw LosgapException { "Could not open physics journal file for writing." };
+
+		writeBuffer.reserve(JOURNAL_FLUSH_THRESHOLD_BYTES * 2U);
+		WriteValue(JOURNAL_MAGIC);
+		WriteValue(JOURNAL_VERSION);
+		recordedBodies.clear();
+		isRecording.store(true);
+	}
+	EXPORT(PhysicsJournal_BeginRecording, INTEROP_STRING journalFilePath) {
+		if (journalFilePath == nullptr) throw LosgapException { "Journal file path must not be null." };
+		auto stringPtr = LosgapString::AsNewCString(journalFilePath);
+		PhysicsJournal::BeginRecording(stringPtr.get());
+		EXPORT_END;
+	}
+
+	void PhysicsJournal::EndRecording() {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+		isRecording.store(false);
+		FlushBuffer();
+		journalFile.close();
+		recordedBodies.clear();
+	}
+	EXPORT(PhysicsJournal_EndRecording) {
+		PhysicsJournal::EndRecording();
+		EXPORT_END;
+	}
+
+	void PhysicsJournal::RecordTick(float_t deltaTime) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		WriteValue(JournalTick);
+		WriteValue(deltaTime);
+
+		uint32_t numKinematicBodies = 0U;
+		for (auto& kvp : recordedBodies) {
+			if (kvp.second.IsKinematic) ++numKinematicBodies;
+		}
+		WriteValue(numKinematicBodies);
+		for (auto& kvp : recordedBodies) {
+			if (!kvp.second.IsKinematic) continue;
+			WriteValues(static_cast<const void*>(kvp.first), *kvp.second.TranslationPtr, *kvp.second.RotationPtr, *kvp.second.TranslationOffsetPtr);
+		}
+
+		// Ticks are the natural frame boundary, so this is the only place we touch the disk
+		if (writeBuffer.size() >= JOURNAL_FLUSH_THRESHOLD_BYTES) FlushBuffer();
+	}
+
+	void PhysicsJournal::RecordCreateConvexHullShape(const btConvexHullShape* shape, const CollisionShapeOptionsDesc& shapeOptions) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		WriteValues(JournalCreateConvexHullShape, static_cast<const void*>(shape), shapeOptions);
+		WriteHullPoints(shape);
+	}
+
+	void PhysicsJournal::RecordCreateCompoundHullShape(const btCompoundShape* shape, const CollisionShapeOptionsDesc& shapeOptions) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		// Both compound shape types are recorded by their resultant hulls, so that a replay never depends on V-HACD or .acd files
+		uint32_t numChildren = static_cast<uint32_t>(shape->getNumChildShapes());
+		WriteValues(JournalCreateCompoundHullShape, static_cast<const void*>(shape), shapeOptions, numChildren);
+		for (uint32_t i = 0U; i < numChildren; ++i) {
+			const btConvexHullShape* childHull = static_cast<const btConvexHullShape*>(shape->getChildShape(static_cast<int>(i)));
+			WriteValue(childHull->getLocalScaling());
+			WriteHullPoints(childHull);
+		}
+	}
+
+	void PhysicsJournal::WriteRigidBodyCreation(const btRigidBody* body, const btVector3* translationPtr, const btQuaternion* rotationPtr, const btVector3* translationOffsetPtr, const btCollisionShape* collisionShape, btScalar bodyMass, bool alwaysActive, bool forceIntransigence, bool worldColOnly, bool nonWallCol) {
+		recordedBodies[body] = JournalBodySource { translationPtr, rotationPtr, translationOffsetPtr, forceIntransigence };
+		WriteValues(
+			static_cast<const void*>(body),
+			*translationPtr, *rotationPtr, *translationOffsetPtr,
+			static_cast<const void*>(collisionShape), bodyMass,
+			alwaysActive, forceIntransigence, worldColOnly, nonWallCol
+		);
+	}
+
+	void PhysicsJournal::RecordCreateRigidBody(const btRigidBody* body, const btVector3* translationPtr, const btQuaternion* rotationPtr, const btVector3* translationOffsetPtr, const btCollisionShape* collisionShape, btScalar bodyMass, bool alwaysActive, bool forceIntransigence, bool worldColOnly, bool nonWallCol) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		WriteValue(JournalCreateRigidBody);
+		WriteRigidBodyCreation(body, translationPtr, rotationPtr, translationOffsetPtr, collisionShape, bodyMass, alwaysActive, forceIntransigence, worldColOnly, nonWallCol);
+	}
+
+	void PhysicsJournal::RecordCreateRigidBodiesBatch(const RigidBodyDesc* descArr, btRigidBody* const* bodyArr, uint32_t numBodies) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		// Recorded as one batch (rather than N creations) because the broadphase tree shape affects pair order, and therefore the solve
+		WriteValues(JournalCreateRigidBodiesBatch, numBodies);
+		for (uint32_t i = 0U; i < numBodies; ++i) {
+			const RigidBodyDesc& desc = descArr[i];
+			WriteRigidBodyCreation(
+				bodyArr[i], desc.TranslationPtr, desc.RotationPtr, desc.TranslationOffsetPtr, desc.CollisionShape, desc.Mass,
+				INTEROP_BOOL_TO_CBOOL(desc.AlwaysActive), INTEROP_BOOL_TO_CBOOL(desc.ForceIntransigence),
+				INTEROP_BOOL_TO_CBOOL(desc.WorldColOnly), INTEROP_BOOL_TO_CBOOL(desc.NonWallCol)
+			);
+		}
+	}
+
+	void PhysicsJournal::RecordUpdateBodyTransform(const btRigidBody* body) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		// Unreachable while BeginRecording() refuses to start with a live world; never fail the caller's (already applied) update
+		auto source = recordedBodies.find(body);
+		if (source == recordedBodies.end()) return;
+		WriteValues(
+			JournalUpdateBodyTransform, static_cast<const void*>(body),
+			*source->second.TranslationPtr, *source->second.RotationPtr, *source->second.TranslationOffsetPtr
+		);
+	}
+
+	void PhysicsJournal::RecordDestroyRigidBody(const btRigidBody* body) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		recordedBodies.erase(body);
+		WriteValues(JournalDestroyRigidBody, static_cast<const void*>(body));
+	}
+
+	void PhysicsJournal::RecordDestroyRigidBodiesBatch(btRigidBody* const* bodyArr, uint32_t numBodies) {
+		std::lock_guard<std::mutex> lock { journalLock };
+		if (!IsRecording()) return;
+
+		WriteValues(JournalDestroyRigidBodiesBatch, numBodies);
+		for (uint32_t i = 0U; i < numBodies; ++i) {
+			recordedBodies.erase(bodyArr[i]);
+			WriteValue(static_cast<const void*>(bodyArr[i]));
+		}
+	}
+#pragma endregion
+
+#pragma region Replay
+	/*
+	Reads values back out of an in-memory journal, in the same encoding that PhysicsJournal writes them
+	*/
+	class JournalReader {
+	private:
+		const std::vector<char>& data;
+		size_t cursor;
+
+		void ReadBytes(void* dest, size_t numBytes) {
+			if (cursor + numBytes > data.size()) throw LosgapException { "Physics journal is truncated or corrupt." };
+			memcpy(dest, &data[cursor], numBytes);
+			cursor += numBytes;
+		}
+
+	public:
+		JournalReader(const std::vector<char>& data) : data(data), cursor(0U) { }
+
+		bool AtEnd() const { return cursor >= data.size(); }
+
+		uint8_t ReadByte() { uint8_t result; ReadBytes(&result, sizeof(result)); return result; }
+		bool ReadBool() { return ReadByte() != 0U; }
+		float_t ReadFloat() { float_t result; ReadBytes(&result, sizeof(result)); return result; }
+		uint32_t ReadUInt() { uint32_t result; ReadBytes(&result, sizeof(result)); return result; }
+		uint64_t ReadId() { uint64_t result; ReadBytes(&result, sizeof(result)); return result; }
+		btVector3 ReadVector() {
+			btScalar components[3];
+			ReadBytes(components, sizeof(components));
+			return btVector3 { components[0], components[1], components[2] };
+		}
+		btQuaternion ReadQuaternion() {
+			btScalar components[4];
+			ReadBytes(components, sizeof(components));
+			return btQuaternion { components[0], components[1], components[2], components[3] };
+		}
+		BroadphaseDesc ReadBroadphaseDesc() {
+			BroadphaseDesc result { };
+			result.WorldMin = ReadVector();
+			result.WorldMax = ReadVector();
+			result.Type = static_cast<BroadphaseType>(ReadUInt());
+			result.MaxHandles = ReadUInt();
+			return result;
+		}
+		CollisionShapeOptionsDesc ReadShapeOptions() {
+			CollisionShapeOptionsDesc result { };
+			result.Scaling = ReadVector();
+			return result;
+		}
+		void ReadHullPoints(std::vector<btScalar>& outComponents) {
+			uint32_t numPoints = ReadUInt();
+			size_t firstComponent = outComponents.size();
+			outComponents.resize(firstComponent + numPoints * 3U);
+			if (numPoints > 0U) ReadBytes(&outComponents[firstComponent], numPoints * 3U * sizeof(btScalar));
+		}
+	};
+
+	/*
+	Stands in for the managed memory that live bodies' motion states point at
+	*/
+	struct ReplayBodyState {
+		btVector3 Translation;
+		btQuaternion Rotation;
+		btVector3 TranslationOffset;
+	};
+
+	/*
+	Maps journal ids back to the objects created during this replay
+	*/
+	class ReplaySession {
+	private:
+		std::unordered_map<uint64_t, btCollisionShape*> shapes;
+		std::unordered_map<uint64_t, btRigidBody*> bodies;
+		std::unordered_map<uint64_t, ReplayBodyState*> bodyStates;
+		std::unordered_map<uint64_t, btFixedConstraint*> constraints;
+
+		template <typename T>
+		static T* Lookup(const std::unordered_map<uint64_t, T*>& map, uint64_t id) {
+			auto result = map.find(id);
+			if (result == map.end()) throw LosgapException { "Physics journal references an object that was never created." };
+			return result->second;
+		}
+
+	public:
+		bool WorldIsLive;
+
+		ReplaySession() : WorldIsLive(false) { }
+		DISALLOW_COPY_ASSIGN(ReplaySession);
+
+		void AddShape(uint64_t id, btCollisionShape* shape) { shapes[id] = shape; }
+		btCollisionShape* GetShape(uint64_t id) { return Lookup(shapes, id); }
+		void RemoveShape(uint64_t id) { shapes.erase(id); }
+
+		ReplayBodyState* CreateBodyState(uint64_t id) {
+			ReplayBodyState* result = ALIGNED_NEW(ReplayBodyState, 16) { };
+			bodyStates[id] = result;
+			return result;
+		}
+		ReplayBodyState* GetBodyState(uint64_t id) { return Lookup(bodyStates, id); }
+		ReplayBodyState* ReadBodyCreation(JournalReader& reader, RigidBodyDesc& outDesc, uint64_t& outId) {
+			outId = reader.ReadId();
+			ReplayBodyState* state = CreateBodyState(outId);
+			state->Translation = reader.ReadVector();
+			state->Rotation = reader.ReadQuaternion();
+			state->TranslationOffset = reader.ReadVector();
+			outDesc.TranslationPtr = &state->Translation;
+			outDesc.RotationPtr = &state->Rotation;
+			outDesc.TranslationOffsetPtr = &state->TranslationOffset;
+			outDesc.CollisionShape = GetShape(reader.ReadId());
+			outDesc.Mass = reader.ReadFloat();
+			outDesc.AlwaysActive = CBOOL_TO_INTEROP_BOOL(reader.ReadBool());
+			outDesc.ForceIntransigence = CBOOL_TO_INTEROP_BOOL(reader.ReadBool());
+			outDesc.WorldColOnly = CBOOL_TO_INTEROP_BOOL(reader.ReadBool());
+			outDesc.NonWallCol = CBOOL_TO_INTEROP_BOOL(reader.ReadBool());
+			return state;
+		}
+		void AddBody(uint64_t id, btRigidBody* body) { bodies[id] = body; }
+		btRigidBody* GetBody(uint64_t id) { return Lookup(bodies, id); }
+		void DestroyBody(uint64_t id) {
+			btRigidBody* body = GetBody(id);
+			btMotionState* motionState = body->getMotionState();
+			if (WorldIsLive) PhysicsManager::DestroyRigidBody(body);
+			else delete body;
+			delete motionState;
+			ForgetBody(id);
+		}
+		void DestroyBodies(const std::vector<uint64_t>& ids) {
+			std::vector<btRigidBody*> bodyArr;
+			std::vector<btMotionState*> motionStates;
+			for (uint64_t id : ids) {
+				bodyArr.push_back(GetBody(id));
+				motionStates.push_back(bodyArr.back()->getMotionState());
+			}
+			if (!bodyArr.empty()) PhysicsManager::DestroyRigidBodies(&bodyArr.front(), static_cast<uint32_t>(bodyArr.size()));
+			for (btMotionState* motionState : motionStates) delete motionState;
+			for (uint64_t id : ids) ForgetBody(id);
+		}
+		void ForgetBody(uint64_t id) {
+			bodies.erase(id);
+			ReplayBodyState* state = GetBodyState(id);
+			state->~ReplayBodyState();
+			_aligned_free(state);
+			bodyStates.erase(id);
+		}
+
+		void AddConstraint(uint64_t id, btFixedConstraint* constraint) { constraints[id] = constraint; }
+		btFixedConstraint* GetConstraint(uint64_t id) { return Lookup(constraints, id); }
+		void RemoveConstraint(uint64_t id) { constraints.erase(id); }
+
+		/*
+		Tears down whatever is still alive: a journal may end mid-session (e.g. the game crashed), and a replay may fail part way through.
+		Carries on past any failure so that as much as possible is released, and returns a description of every failure (empty if none).
+		*/
+		std::string TearDown() {
+			std::string failures;
+			for (auto& kvp : constraints) {
+				try {
+					PhysicsManager::DestroyConstraint(kvp.second);
+				}
+				catch (const LosgapException& e) {
+					AppendFailure(failures, "destroying constraint " + std::to_string(kvp.first), e);
+				}
+			}
+			constraints.clear();
+			while (!bodies.empty()) {
+				uint64_t id = bodies.begin()->first;
+				try {
+					DestroyBody(id);
+				}
+				catch (const LosgapException& e) {
+					AppendFailure(failures, "destroying body " + std::to_string(id), e);
+					bodies.erase(id);
+				}
+			}
+			for (auto& kvp : bodyStates) {
+				kvp.second->~ReplayBodyState();
+				_aligned_free(kvp.second);
+			}
+			bodyStates.clear();
+			for (auto& kvp : shapes) {
+				try {
+					PhysicsManager::DestroyShape(kvp.second);
+				}
+				catch (const LosgapException& e) {
+					AppendFailure(failures, "destroying shape " + std::to_string(kvp.first), e);
+				}
+			}
+			shapes.clear();
+			if (WorldIsLive) {
+				try {
+					PhysicsManager::Shutdown();
+				}
+				catch (const LosgapException& e) {
+					AppendFailure(failures, "shutting down the physics engine", e);
+				}
+				WorldIsLive = false;
+			}
+			return failures;
+		}
+
+	private:
+		static void AppendFailure(std::string& failures, const std::string& action, const LosgapException& e) {
+			if (!failures.empty()) failures += "; ";
+			failures += action + ": " + LosgapString::AsNewString(e.Message);
+		}
+	};
+
+	uint32_t PhysicsJournal::Replay(const char* journalFilePath, const BroadphaseDesc* broadphaseOverride, PhysicsJournalTickTiming* outTimingArr, uint32_t arrLen) {
+		if (journalFilePath == nullptr) throw LosgapException { "Journal file path must not be null." };
+		if (IsRecording()) throw LosgapException { "Can not replay a physics journal while one is being recorded." };
+		// Replay starts the engine itself (as the journal did), and tears it down again afterwards
+		if (PhysicsManager::IsRunning()) throw LosgapException { "Physics journals can only be replayed while the physics engine is not running." };
+
+		std::ifstream journalFileR { journalFilePath, std::ifstream::binary | std::ifstream::ate };
+		if (!journalFileR) throw LosgapException { "Could not open physics journal file for reading." };
+		std::vector<char> journalData(static_cast<size_t>(journalFileR.tellg()));
+		journalFileR.seekg(0, std::ifstream::beg);
+		if (!journalData.empty()) journalFileR.read(&journalData.front(), journalData.size());
+
+		JournalReader reader { journalData };
+		if (reader.ReadUInt() != JOURNAL_MAGIC) throw LosgapException { "Given file is not a physics journal." };
+		if (reader.ReadUInt() != JOURNAL_VERSION) throw LosgapException { "Physics journal was written by an incompatible version." };
+
+		int64_t ticksPerSecond = Platform::GetTicksPerSecond();
+		uint32_t tickIndex = 0U;
+		std::vector<btScalar> hullComponents;
+		std::vector<uint32_t> hullNumPoints;
+		std::vector<btVector3> hullScaling;
+		std::vector<uint64_t> batchIds;
+		std::vector<RigidBodyDesc> batchDescs;
+		std::vector<btRigidBody*> batchBodies;
+
+		ReplaySession session { };
+		try {
+			while (!reader.AtEnd()) {
+				PhysicsJournalOp op = static_cast<PhysicsJournalOp>(reader.ReadByte());
+				switch (op) {
+					case JournalTick: {
+						float_t deltaTime = reader.ReadFloat();
+						uint32_t numKinematicBodies = reader.ReadUInt();
+						for (uint32_t i = 0U; i < numKinematicBodies; ++i) {
+							ReplayBodyState* state = session.GetBodyState(reader.ReadId());
+							state->Translation = reader.ReadVector();
+							state->Rotation = reader.ReadQuaternion();
+							state->TranslationOffset = reader.ReadVector();
+						}
+
+						int64_t tickStart = Platform::GetTicks();
+						PhysicsManager::Tick(deltaTime);
+						int64_t tickEnd = Platform::GetTicks();
+
+						if (tickIndex < arrLen && outTimingArr != nullptr) {
+							outTimingArr[tickIndex] = PhysicsJournalTickTiming {
+								tickIndex,
+								deltaTime,
+								static_cast<double_t>(tickEnd - tickStart) * 1000.0 / static_cast<double_t>(ticksPerSecond)
+							};
+						}
+						++tickIndex;
+						break;
+					}
+					case JournalUpdateBodyTransform: {
+						uint64_t bodyId = reader.ReadId();
+						ReplayBodyState* state = session.GetBodyState(bodyId);
+						state->Translation = reader.ReadVector();
+						state->Rotation = reader.ReadQuaternion();
+						state->TranslationOffset = reader.ReadVector();
+						PhysicsManager::UpdateBodyTransform(session.GetBody(bodyId));
+						break;
+					}
+					case JournalAddForceToBody: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::AddForceToBody(body, reader.ReadVector());
+						break;
+					}
+					case JournalAddTorqueToBody: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::AddTorqueToBody(body, reader.ReadVector());
+						break;
+					}
+					case JournalAddForceImpulseToBody: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::AddForceImpulseToBody(body, reader.ReadVector());
+						break;
+					}
+					case JournalAddTorqueImpulseToBody: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::AddTorqueImpulseToBody(body, reader.ReadVector());
+						break;
+					}
+					case JournalRemoveAllForceAndTorqueFromBody: {
+						PhysicsManager::RemoveAllForceAndTorqueFromBody(session.GetBody(reader.ReadId()));
+						break;
+					}
+					case JournalSetBodyLinearVelocity: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::SetBodyLinearVelocity(body, reader.ReadVector());
+						break;
+					}
+					case JournalSetBodyAngularVelocity: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::SetBodyAngularVelocity(body, reader.ReadVector());
+						break;
+					}
+					case JournalReactivateBody: {
+						PhysicsManager::ReactivateBody(session.GetBody(reader.ReadId()));
+						break;
+					}
+					case JournalSetBodyStatic: {
+						PhysicsManager::SetBodyStatic(session.GetBody(reader.ReadId()));
+						break;
+					}
+					case JournalSetBodyMass: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::SetBodyMass(body, reader.ReadFloat());
+						break;
+					}
+					case JournalSetBodyGravity: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						PhysicsManager::SetBodyGravity(body, reader.ReadVector());
+						break;
+					}
+					case JournalSetBodyProperties: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						float_t restitution = reader.ReadFloat();
+						float_t linearDamping = reader.ReadFloat();
+						float_t angularDamping = reader.ReadFloat();
+						float_t friction = reader.ReadFloat();
+						float_t rollingFriction = reader.ReadFloat();
+						PhysicsManager::SetBodyProperties(body, restitution, linearDamping, angularDamping, friction, rollingFriction);
+						break;
+					}
+					case JournalSetBodyCCD: {
+						btRigidBody* body = session.GetBody(reader.ReadId());
+						float_t minSpeed = reader.ReadFloat();
+						float_t ccdRadius = reader.ReadFloat();
+						PhysicsManager::SetBodyCCD(body, minSpeed, ccdRadius);
+						break;
+					}
+					case JournalCreateRigidBody: {
+						uint64_t bodyId;
+						RigidBodyDesc desc;
+						session.ReadBodyCreation(reader, desc, bodyId);
+						session.AddBody(bodyId, PhysicsManager::CreateRigidBody(
+							desc.TranslationPtr, desc.RotationPtr, desc.TranslationOffsetPtr, desc.CollisionShape, desc.Mass,
+							INTEROP_BOOL_TO_CBOOL(desc.AlwaysActive), INTEROP_BOOL_TO_CBOOL(desc.ForceIntransigence),
+							INTEROP_BOOL_TO_CBOOL(desc.WorldColOnly), INTEROP_BOOL_TO_CBOOL(desc.NonWallCol)
+						));
+						break;
+					}
+					case JournalCreateRigidBodiesBatch: {
+						uint32_t numBodies = reader.ReadUInt();
+						batchIds.resize(numBodies);
+						batchDescs.resize(numBodies);
+						batchBodies.resize(numBodies);
+						for (uint32_t i = 0U; i < numBodies; ++i) {
+							session.ReadBodyCreation(reader, batchDescs[i], batchIds[i]);
+						}
+						if (numBodies > 0U) {
+							PhysicsManager::CreateRigidBodies(&batchDescs.front(), numBodies, &batchBodies.front());
+							for (uint32_t i = 0U; i < numBodies; ++i) session.AddBody(batchIds[i], batchBodies[i]);
+						}
+						break;
+					}
+					case JournalDestroyRigidBody: {
+						session.DestroyBody(reader.ReadId());
+						break;
+					}
+					case JournalDestroyRigidBodiesBatch: {
+						uint32_t numBodies = reader.ReadUInt();
+						batchIds.resize(numBodies);
+						for (uint32_t i = 0U; i < numBodies; ++i) batchIds[i] = reader.ReadId();
+						session.DestroyBodies(batchIds);
+						break;
+					}
+					case JournalCreateBoxShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						session.AddShape(shapeId, PhysicsManager::CreateBoxShape(reader.ReadVector(), shapeOptions));
+						break;
+					}
+					case JournalCreateSimpleSphereShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						session.AddShape(shapeId, PhysicsManager::CreateSimpleSphereShape(reader.ReadFloat(), shapeOptions));
+						break;
+					}
+					case JournalCreateScaledSphereShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						float_t radius = reader.ReadFloat();
+						session.AddShape(shapeId, PhysicsManager::CreateScaledSphereShape(radius, reader.ReadVector(), shapeOptions));
+						break;
+					}
+					case JournalCreateConeShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						float_t radius = reader.ReadFloat();
+						float_t height = reader.ReadFloat();
+						session.AddShape(shapeId, PhysicsManager::CreateConeShape(radius, height, shapeOptions));
+						break;
+					}
+					case JournalCreateCylinderShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						float_t radius = reader.ReadFloat();
+						float_t height = reader.ReadFloat();
+						session.AddShape(shapeId, PhysicsManager::CreateCylinderShape(radius, height, shapeOptions));
+						break;
+					}
+					case JournalCreateConvexHullShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						hullComponents.clear();
+						reader.ReadHullPoints(hullComponents);
+						const btScalar* componentsPtr = hullComponents.empty() ? nullptr : &hullComponents.front();
+						session.AddShape(shapeId, PhysicsManager::CreateConvexHullShape(componentsPtr, static_cast<int>(hullComponents.size()), shapeOptions));
+						break;
+					}
+					case JournalCreateCompoundHullShape: {
+						uint64_t shapeId = reader.ReadId();
+						CollisionShapeOptionsDesc shapeOptions = reader.ReadShapeOptions();
+						uint32_t numChildren = reader.ReadUInt();
+						hullComponents.clear();
+						hullNumPoints.clear();
+						hullScaling.clear();
+						for (uint32_t i = 0U; i < numChildren; ++i) {
+							hullScaling.push_back(reader.ReadVector());
+							size_t componentsBefore = hullComponents.size();
+							reader.ReadHullPoints(hullComponents);
+							hullNumPoints.push_back(static_cast<uint32_t>((hullComponents.size() - componentsBefore) / 3U));
+						}
+						session.AddShape(shapeId, PhysicsManager::CreateCompoundHullShape(
+							hullComponents.empty() ? nullptr : &hullComponents.front(),
+							hullNumPoints.empty() ? nullptr : &hullNumPoints.front(),
+							hullScaling.empty() ? nullptr : &hullScaling.front(),
+							numChildren,
+							shapeOptions
+						));
+						break;
+					}
+					case JournalDestroyShape: {
+						uint64_t shapeId = reader.ReadId();
+						PhysicsManager::DestroyShape(session.GetShape(shapeId));
+						session.RemoveShape(shapeId);
+						break;
+					}
+					case JournalCreateFixedConstraint: {
+						uint64_t constraintId = reader.ReadId();
+						btRigidBody* parent = session.GetBody(reader.ReadId());
+						btRigidBody* child = session.GetBody(reader.ReadId());
+						btVector3 parentInitialTranslation = reader.ReadVector();
+						btQuaternion parentInitialRotation = reader.ReadQuaternion();
+						btVector3 childInitialTranslation = reader.ReadVector();
+						btQuaternion childInitialRotation = reader.ReadQuaternion();
+						session.AddConstraint(constraintId, PhysicsManager::CreateFixedConstraint(
+							*parent, *child,
+							btTransform { parentInitialRotation, parentInitialTranslation },
+							btTransform { childInitialRotation, childInitialTranslation }
+						));
+						break;
+					}
+					case JournalDestroyConstraint: {
+						uint64_t constraintId = reader.ReadId();
+						PhysicsManager::DestroyConstraint(session.GetConstraint(constraintId));
+						session.RemoveConstraint(constraintId);
+						break;
+					}
+					case JournalSetTickrate: {
+						PhysicsManager::SetTickrate(reader.ReadFloat());
+						break;
+					}
+					case JournalSetGravity: {
+						PhysicsManager::SetGravity(reader.ReadVector());
+						break;
+					}
+					case JournalInit: {
+						if (broadphaseOverride != nullptr) PhysicsManager::Init(*broadphaseOverride);
+						else PhysicsManager::Init();
+						session.WorldIsLive = true;
+						break;
+					}
+					case JournalInitWithBroadphase: {
+						BroadphaseDesc broadphaseDesc = reader.ReadBroadphaseDesc();
+						PhysicsManager::Init(broadphaseOverride != nullptr ? *broadphaseOverride : broadphaseDesc);
+						session.WorldIsLive = true;
+						break;
+					}
+					case JournalSetBroadphase: {
+						BroadphaseDesc broadphaseDesc = reader.ReadBroadphaseDesc();
+						PhysicsManager::SetBroadphase(broadphaseOverride != nullptr ? *broadphaseOverride : broadphaseDesc);
+						break;
+					}
+					case JournalShutdown: {
+						PhysicsManager::Shutdown();
+						session.WorldIsLive = false;
+						break;
+					}
+					default: {
+						throw LosgapException { "Unknown physics journal record: " + std::to_string(static_cast<uint32_t>(op)) };
+					}
+				}
+			}
+		}
+		catch (const LosgapException& e) {
+			std::string teardownFailures = session.TearDown();
+			if (teardownFailures.empty()) throw;
+			throw LosgapException { LosgapString::AsNewString(e.Message) + " (tearing down the replay then also failed: " + teardownFailures + ")" };
+		}
+		catch (...) {
+			session.TearDown();
+			throw;
+		}
+
+		std::string teardownFailures = session.TearDown();
+		if (!teardownFailures.empty()) throw LosgapException { "Could not tear down the physics journal replay: " + teardownFailures };
+		return tickIndex;
+	}
+	EXPORT(PhysicsJournal_Replay, INTEROP_STRING journalFilePath, const BroadphaseDesc* broadphaseOverride, PhysicsJournalTickTiming* outTimingArr, uint32_t arrLen, uint32_t* outNumTicks) {
+		if (journalFilePath == nullptr) throw LosgapException { "Journal file path must not be null." };
+		auto stringPtr = LosgapString::AsNewCString(journalFilePath);
+		*outNumTicks = PhysicsJournal::Replay(stringPtr.get(), broadphaseOverride, outTimingArr, arrLen);
+		EXPORT_END;
+	}
+#pragma endregion
+}
@@ -0,0 +1,131 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "..\CoreNative\LosgapCore.h"
+#include "btBulletDynamicsCommon.h"
+#include "CollisionShapeOptionsDesc.h"
+#include "RigidBodyDesc.h"
+#include "BroadphaseDesc.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace losgap {
+	/*
+	The record types that can appear in a physics journal. These values are written to disk, so only ever append new ones.
+	*/
+	enum PhysicsJournalOp : uint8_t {
+		JournalInit = 1U,
+		JournalShutdown,
+		JournalSetTickrate,
+		JournalSetGravity,
+		JournalTick,
+		JournalCreateBoxShape,
+		JournalCreateSimpleSphereShape,
+		JournalCreateScaledSphereShape,
+		JournalCreateConeShape,
+		JournalCreateCylinderShape,
+		JournalCreateConvexHullShape,
+		JournalCreateCompoundHullShape,
+		JournalDestroyShape,
+		JournalCreateRigidBody,
+		JournalSetBodyProperties,
+		JournalSetBodyCCD,
+		JournalDestroyRigidBody,
+		JournalUpdateBodyTransform,
+		JournalAddForceToBody,
+		JournalAddTorqueToBody,
+		JournalAddForceImpulseToBody,
+		JournalAddTorqueImpulseToBody,
+		JournalRemoveAllForceAndTorqueFromBody,
+		JournalSetBodyLinearVelocity,
+		JournalSetBodyAngularVelocity,
+		JournalReactivateBody,
+		JournalSetBodyMass,
+		JournalSetBodyGravity,
+		JournalCreateFixedConstraint,
+		JournalDestroyConstraint,
+		JournalCreateRigidBodiesBatch,
+		JournalDestroyRigidBodiesBatch,
+		JournalInitWithBroadphase,
+		JournalSetBroadphase,
+		JournalSetBodyStatic,
+	};
+
+	/*
+	An interop struct detailing the cost of a single replayed tick
+	*/
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct PhysicsJournalTickTiming {
+		uint32_t TickIndex;
+		float_t DeltaTime;
+		double_t TickDurationMs;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that records every mutating physics call in to a compact binary journal, and replays those journals headlessly.
+	Replays always run on the calling thread, so a journal reproduces the recorded session bit-for-bit on the same build.
+	*/
+	class PhysicsJournal {
+	private:
+		static std::atomic<bool> isRecording;
+		static std::mutex journalLock;
+		static std::vector<char> writeBuffer;
+
+		static void WriteBytes(const void* data, size_t numBytes);
+		static void FlushBuffer();
+
+		static void WriteValue(PhysicsJournalOp value) { WriteBytes(&value, sizeof(value)); }
+		static void WriteValue(bool value) { uint8_t asByte = value ? 1U : 0U; WriteBytes(&asByte, sizeof(asByte)); }
+		static void WriteValue(float_t value) { WriteBytes(&value, sizeof(value)); }
+		static void WriteValue(uint32_t value) { WriteBytes(&value, sizeof(value)); }
+		static void WriteValue(const btVector3& value) { WriteBytes(value.m_floats, sizeof(btScalar) * 3U); }
+		static void WriteValue(const btQuaternion& value) { WriteBytes(&value[0], sizeof(btScalar) * 4U); }
+		static void WriteValue(const CollisionShapeOptionsDesc& value) { WriteValue(value.Scaling); }
+		static void WriteValue(const BroadphaseDesc& value) { WriteValues(value.WorldMin, value.WorldMax, static_cast<uint32_t>(value.Type), value.MaxHandles); }
+		static void WriteValue(const void* objectPtr) { uint64_t id = reinterpret_cast<uint64_t>(objectPtr); WriteBytes(&id, sizeof(id)); }
+
+		static void WriteValues() { }
+		template <typename T, typename... Rest>
+		static void WriteValues(const T& first, const Rest&... rest) {
+			WriteValue(first);
+			WriteValues(rest...);
+		}
+
+		static void WriteHullPoints(const btConvexHullShape* hull);
+		static void WriteRigidBodyCreation(const btRigidBody* body, const btVector3* translationPtr, const btQuaternion* rotationPtr, const btVector3* translationOffsetPtr, const btCollisionShape* collisionShape, btScalar bodyMass, bool alwaysActive, bool forceIntransigence, bool worldColOnly, bool nonWallCol);
+
+	public:
+		static void BeginRecording(const char* journalFilePath);
+		static void EndRecording();
+		static bool IsRecording() { return isRecording.load(std::memory_order_relaxed); }
+
+		/*
+		Writes one record. Callers should check IsRecording() first so that nothing is evaluated when recording is off.
+		*/
+		template <typename... Args>
+		static void Record(PhysicsJournalOp op, const Args&... args) {
+			std::lock_guard<std::mutex> lock { journalLock };
+			if (!IsRecording()) return;
+			WriteValue(op);
+			WriteValues(args...);
+		}
+
+		static void RecordTick(float_t deltaTime);
+		static void RecordCreateConvexHullShape(const btConvexHullShape* shape, const CollisionShapeOptionsDesc& shapeOptions);
+		static void RecordCreateCompoundHullShape(const btCompoundShape* shape, const CollisionShapeOptionsDesc& shapeOptions);
+		static void RecordCreateRigidBody(const btRigidBody* body, const btVector3* translationPtr, const btQuaternion* rotationPtr, const btVector3* translationOffsetPtr, const btCollisionShape* collisionShape, btScalar bodyMass, bool alwaysActive, bool forceIntransigence, bool worldColOnly, bool nonWallCol);
+		static void RecordUpdateBodyTransform(const btRigidBody* body);
+		static void RecordDestroyRigidBody(const btRigidBody* body);
+		static void RecordCreateRigidBodiesBatch(const RigidBodyDesc* descArr, btRigidBody* const* bodyArr, uint32_t numBodies);
+		static void RecordDestroyRigidBodiesBatch(btRigidBody* const* bodyArr, uint32_t numBodies);
+
+		/*
+		If broadphaseOverride is non-null, it replaces whichever broadphase the journal asked for, so that the same session can be timed on each type.
+		*/
+		static uint32_t Replay(const char* journalFilePath, const BroadphaseDesc* broadphaseOverride, PhysicsJournalTickTiming* outTimingArr, uint32_t arrLen);
+	};
+}
@@ -5,6 +5,7 @@
 
 #include "PhysicsManager.h"
 #include "LosgapMotionState.h"
+#include "PhysicsJournal.h"
 #include "..\bullet3-2.83.5\v-hacd-master\v-hacd-master\src\VHACD_Lib\public\VHACD.h"
 #include <mutex>
 #include <vector>
@@ -24,6 +25,7 @@ namespace losgap {
 	btCollisionDispatcher* collisionDispatcher = nullptr;
 	btConstraintSolver* constraintSolver = nullptr;
 	btDynamicsWorld* dynamicsWorld = nullptr;
+	BroadphaseType activeBroadphaseType = DynamicTree;
 	const btVector3 ZERO_VECTOR { 0.0f, 0.0f, 0.0f };
 	float tickrate = TICK_RATE_INTERNAL;
 	float substeps = tickrate / 20.0f;
@@ -35,13 +37,30 @@ namespace losgap {
 
 	VHACD::IVHACD* convexDecompositionInterface = VHACD::CreateVHACD();
 
+	const MetricID METRIC_TICK_TIME = Metrics::Register("Physics.TickTimeUs", MetricHistogram);
+	const MetricID METRIC_CONTACT_MANIFOLDS = Metrics::Register("Physics.ContactManifolds", MetricCounter);
+	const MetricID METRIC_CONTACTS = Metrics::Register("Physics.Contacts", MetricCounter);
+	const MetricID METRIC_RAY_TESTS = Metrics::Register("Physics.RayTests", MetricCounter);
+	const MetricID METRIC_BODY_BATCH_TIME = Metrics::Register("Physics.BodyBatchTimeUs", MetricHistogram);
+
+	// Sleeping bodies are skipped by the per-step AABB update (see Init), so every path that moves a body or sets it in motion comes
+	// through here. Bodies with mass are woken and picked up by the next step; massless (static) bodies stay asleep and have their
+	// broadphase proxy refreshed immediately.
+	void RefreshInactiveBody(btRigidBody* const body) {
+		if (body->isActive()) return;
+		if (body->getInvMass() != 0.0f) body->activate(true);
+		else dynamicsWorld->updateSingleAabb(body);
+	}
+
 #pragma region Lifetime
 	void TickCallback(btDynamicsWorld* world, btScalar timeStep) {
 		int numManifolds = world->getDispatcher()->getNumManifolds();
+		Metrics::Increment(METRIC_CONTACT_MANIFOLDS, numManifolds);
 		for (int i = 0; i < numManifolds; i++) {
 			btPersistentManifold* contactManifold = world->getDispatcher()->getManifoldByIndexInternal(i);
 
 			int numContacts = contactManifold->getNumContacts();
+			Metrics::Increment(METRIC_CONTACTS, numContacts);
 			for (int j = 0; j < numContacts; ++j) {
 				btManifoldPoint& pt = contactManifold->getContactPoint(j);
 				if (pt.getDistance() <= 0.5f) {
@@ -53,8 +72,40 @@ namespace losgap {
 		}
 	}
 
+	btBroadphaseInterface* CreateBroadphase(const BroadphaseDesc& broadphaseDesc) {
+		if (broadphaseDesc.Type == DynamicTree) return new btDbvtBroadphase { };
+
+		if (broadphaseDesc.WorldMin.x() >= broadphaseDesc.WorldMax.x()
+			|| broadphaseDesc.WorldMin.y() >= broadphaseDesc.WorldMax.y()
+			|| broadphaseDesc.WorldMin.z() >= broadphaseDesc.WorldMax.z()) {
+			throw LosgapException { "World minimum bounds must be less than world maximum bounds on every axis." };
+		}
+		if (broadphaseDesc.MaxHandles == 0U) throw LosgapException { "Max handles must be greater than zero." };
+
+		switch (broadphaseDesc.Type) {
+			case AxisSweep16:
+				// 16-bit handles are indexed with an unsigned short, and Bullet reserves the top value as a sentinel
+				if (broadphaseDesc.MaxHandles > 32767U) throw LosgapException { "16-bit sweep-and-prune supports at most 32767 handles." };
+				return new btAxisSweep3 { broadphaseDesc.WorldMin, broadphaseDesc.WorldMax, static_cast<unsigned short>(broadphaseDesc.MaxHandles) };
+			case AxisSweep32:
+				return new bt32BitAxisSweep3 { broadphaseDesc.WorldMin, broadphaseDesc.WorldMax, broadphaseDesc.MaxHandles };
+			default:
+				throw LosgapException { "Unknown broadphase type '" + std::to_string(static_cast<uint32_t>(broadphaseDesc.Type)) + "'." };
+		}
+	}
+
 	void PhysicsManager::Init() {
-		broadphaseInstance = new btDbvtBroadphase { };
+		Init(BroadphaseDesc { });
+	}
+	EXPORT(PhysicsManager_Init) {
+		PhysicsManager::Init();
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalInit);
+		EXPORT_END;
+	}
+
+	void PhysicsManager::Init(const BroadphaseDesc& broadphaseDesc) {
+		broadphaseInstance = CreateBroadphase(broadphaseDesc);
+		activeBroadphaseType = broadphaseDesc.Type;
 		collisionConfig = new btDefaultCollisionConfiguration { };
 		collisionDispatcher = new btCollisionDispatcher { collisionConfig };
 		constraintSolver = new btSequentialImpulseConstraintSolver { };
@@ -66,14 +117,18 @@ namespace losgap {
 		};
 
 		dynamicsWorld->setInternalTickCallback(TickCallback);
+		// Only active bodies have their AABBs pushed to the broadphase each step; bodies marked static (see SetBodyStatic) are left alone.
+		// Anything that moves or accelerates a sleeping body must call RefreshInactiveBody so its proxy doesn't go stale.
+		dynamicsWorld->setForceUpdateAllAabbs(false);
 
 		btContactSolverInfo& contactSolver = dynamicsWorld->getSolverInfo();
 		contactSolver.m_numIterations = 750;
 		contactSolver.m_splitImpulse = 1;
 		contactSolver.m_splitImpulsePenetrationThreshold = 0.0f;
 	}
-	EXPORT(PhysicsManager_Init) {
-		PhysicsManager::Init();
+	EXPORT(PhysicsManager_InitWithBroadphase, const BroadphaseDesc& broadphaseDesc) {
+		PhysicsManager::Init(broadphaseDesc);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalInitWithBroadphase, broadphaseDesc);
 		EXPORT_END;
 	}
 
@@ -91,12 +146,15 @@ namespace losgap {
 	}
 
 	void PhysicsManager::Tick(btScalar deltaTime) {
+		ScopedTrace trace { "PhysicsManager::Tick" };
+		ScopedMetricTimer tickTimer { METRIC_TICK_TIME };
 		collisionList.clear();
 		dynamicsWorld->stepSimulation(deltaTime, substeps, 1.0f / tickrate);
 	}
-	EXPORT(PhysicsManager_Tick, float_t deltaTime) {
+	EXPORT_FAST(PhysicsManager_Tick, float_t deltaTime) {
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordTick(deltaTime);
 		PhysicsManager::Tick(deltaTime);
-		EXPORT_END;
+		EXPORT_FAST_END;
 	}
 
 	void PhysicsManager::SetTickrate(float tickrate) {
@@ -105,6 +163,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_SetTickrate, float_t tickrate) {
 		PhysicsManager::SetTickrate(tickrate);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetTickrate, tickrate);
 		EXPORT_END;
 	}
 
@@ -117,21 +176,70 @@ namespace losgap {
 		SAFE_DELETE(broadphaseInstance);
 	}
 	EXPORT(PhysicsManager_Shutdown) {
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalShutdown);
 		PhysicsManager::Shutdown();
 		EXPORT_END;
 	}
+
+	bool PhysicsManager::IsRunning() {
+		return dynamicsWorld != nullptr;
+	}
 #pragma endregion
 
 #pragma region World
+	void PhysicsManager::SetBroadphase(const BroadphaseDesc& broadphaseDesc) {
+		btCollisionObjectArray& collisionObjects = dynamicsWorld->getCollisionObjectArray();
+		if (broadphaseDesc.Type != DynamicTree && static_cast<uint32_t>(collisionObjects.size()) >= broadphaseDesc.MaxHandles) {
+			throw LosgapException { "The new broadphase does not have enough handles for the " + std::to_string(collisionObjects.size()) + " bodies already in the world." };
+		}
+
+		btBroadphaseInterface* newBroadphase = CreateBroadphase(broadphaseDesc);
+
+		// Anything already in the world (e.g. the player's egg when a level is loaded) is moved across with the same collision filtering.
+		// This is the proxy half of btCollisionWorld's remove/addCollisionObject, without resetting anything else on the bodies (like gravity).
+		for (int i = 0; i < collisionObjects.size(); ++i) {
+			btCollisionObject* const collisionObject = collisionObjects[i];
+			btBroadphaseProxy* const oldProxy = collisionObject->getBroadphaseHandle();
+			if (oldProxy == nullptr) continue;
+			short int filterGroup = oldProxy->m_collisionFilterGroup;
+			short int filterMask = oldProxy->m_collisionFilterMask;
+			broadphaseInstance->getOverlappingPairCache()->cleanProxyFromPairs(oldProxy, collisionDispatcher);
+			broadphaseInstance->destroyProxy(oldProxy, collisionDispatcher);
+
+			btVector3 aabbMin, aabbMax;
+			collisionObject->getCollisionShape()->getAabb(collisionObject->getWorldTransform(), aabbMin, aabbMax);
+			collisionObject->setBroadphaseHandle(newBroadphase->createProxy(
+				aabbMin, aabbMax,
+				collisionObject->getCollisionShape()->getShapeType(),
+				collisionObject,
+				filterGroup, filterMask,
+				collisionDispatcher,
+				nullptr
+			));
+		}
+
+		dynamicsWorld->setBroadphase(newBroadphase);
+		SAFE_DELETE(broadphaseInstance);
+		broadphaseInstance = newBroadphase;
+		activeBroadphaseType = broadphaseDesc.Type;
+	}
+	EXPORT(PhysicsManager_SetBroadphase, const BroadphaseDesc& broadphaseDesc) {
+		PhysicsManager::SetBroadphase(broadphaseDesc);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBroadphase, broadphaseDesc);
+		EXPORT_END;
+	}
+
 	void PhysicsManager::SetGravity(const btVector3& gravity) {
 		dynamicsWorld->setGravity(gravity);
 	}
 	EXPORT(PhysicsManager_SetGravity, const btVector3& gravity) {
 		PhysicsManager::SetGravity(gravity);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetGravity, gravity);
 		EXPORT_END;
 	}
 
 	btRigidBody* PhysicsManager::RayTestNearest(const btVector3& rayStart, const btVector3& rayEnd, btVector3* outHitPoint) {
+		Metrics::Increment(METRIC_RAY_TESTS);
 		btCollisionWorld::ClosestRayResultCallback crrc { rayStart, rayEnd };
 		dynamicsWorld->rayTest(rayStart, rayEnd, crrc);
 		if (!crrc.hasHit()) return nullptr;
@@ -144,6 +252,7 @@ namespace losgap {
 	}
 
 	uint32_t PhysicsManager::RayTestAll(const btVector3& rayStart, const btVector3& rayEnd, RayTestCollisionDesc* const outCollisionDescArr, uint32_t arrLen) {
+		Metrics::Increment(METRIC_RAY_TESTS);
 		btCollisionWorld::AllHitsRayResultCallback ahrrc { rayStart, rayEnd };
 		dynamicsWorld->rayTest(rayStart, rayEnd, ahrrc);
 		auto collisionObjects = ahrrc.m_collisionObjects;
@@ -176,6 +285,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateBoxShape, const btVector3& halfExtents, CollisionShapeOptionsDesc* shapeOptions, btBoxShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateBoxShape(halfExtents, *shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalCreateBoxShape, *outShapePtr, *shapeOptions, halfExtents);
 		EXPORT_END;
 	}
 
@@ -186,6 +296,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateSimpleSphereShape, float_t radius, CollisionShapeOptionsDesc* shapeOptions, btSphereShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateSimpleSphereShape(radius, *shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalCreateSimpleSphereShape, *outShapePtr, *shapeOptions, radius);
 		EXPORT_END;
 	}
 
@@ -196,6 +307,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateScaledSphereShape, float_t radius, const btVector3& scaling, CollisionShapeOptionsDesc* shapeOptions, btMultiSphereShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateScaledSphereShape(radius, scaling, *shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalCreateScaledSphereShape, *outShapePtr, *shapeOptions, radius, scaling);
 		EXPORT_END;
 	}
 
@@ -206,6 +318,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateConeShape, float_t radius, float_t height, CollisionShapeOptionsDesc* shapeOptions, btConeShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateConeShape(radius, height, *shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalCreateConeShape, *outShapePtr, *shapeOptions, radius, height);
 		EXPORT_END;
 	}
 
@@ -217,6 +330,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateCylinderShape, float_t radius, float_t height, CollisionShapeOptionsDesc* shapeOptions, btCylinderShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateCylinderShape(radius, height, *shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalCreateCylinderShape, *outShapePtr, *shapeOptions, radius, height);
 		EXPORT_END;
 	}
 
@@ -230,6 +344,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateConvexHullShape, btScalar* vertexComponentArr, int numVertices, CollisionShapeOptionsDesc* shapeOptions, btConvexHullShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateConvexHullShape(vertexComponentArr, numVertices, *shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordCreateConvexHullShape(*outShapePtr, *shapeOptions);
 		EXPORT_END;
 	}
 
@@ -257,10 +372,34 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateCompoundCurveShape, const btScalar* const vertexComponentArr, const uint32_t numTrapPrisms, const CollisionShapeOptionsDesc& shapeOptions, btCompoundShape** outShapePtr) {
 		*outShapePtr = PhysicsManager::CreateCompoundCurveShape(vertexComponentArr, numTrapPrisms, shapeOptions);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordCreateCompoundHullShape(*outShapePtr, shapeOptions);
 		EXPORT_END;
 	}
 
+	btCompoundShape* PhysicsManager::CreateCompoundHullShape(const btScalar* const vertexComponentArr, const uint32_t* const hullNumPointsArr, const btVector3* const hullScalingArr, const uint32_t numHulls, const CollisionShapeOptionsDesc& shapeOptions) {
+		btCompoundShape* result = new btCompoundShape { };
+		btTransform defaultTransform { };
+		defaultTransform.setIdentity();
+
+		// Scaling goes on first so that it doesn't propagate to the hulls, which arrive already carrying their final scaling
+		SetShapeOptions(*result, shapeOptions);
+
+		const btScalar* hullComponents = vertexComponentArr;
+		for (uint32_t i = 0U; i < numHulls; ++i) {
+			CollisionShapeOptionsDesc hullOptions { };
+			hullOptions.Scaling = hullScalingArr[i];
+			result->addChildShape(defaultTransform, CreateConvexHullShape(hullComponents, hullNumPointsArr[i] * 3U, hullOptions));
+			hullComponents += hullNumPointsArr[i] * 3U;
+		}
+
+		std::lock_guard<std::mutex> lock { globalCompoundShapeLock };
+		liveCompoundShapes.push_back(result);
+
+		return result;
+	}
+
 	btCompoundShape* PhysicsManager::CreateConcaveHullShape(const btScalar* const vertexComponentArr, const int numVertices, const int* const indices, const int numIndices, const CollisionShapeOptionsDesc& shapeOptions, const char* acdFilePath) {
+		ScopedTrace trace { "PhysicsManager::CreateConcaveHullShape" };
 		btCompoundShape* result = new btCompoundShape { };
 		CollisionShapeOptionsDesc bulletConvexHullOptions { };
 		btTransform defaultTransform { };
@@ -353,6 +492,7 @@ namespace losgap {
 			auto stringPtr = LosgapString::AsNewCString(acdFilePath);
 			*outShapePtr = PhysicsManager::CreateConcaveHullShape(vertexComponentArr, numVertices, indices, numIndices, shapeOptions, stringPtr.get());
 		}
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordCreateCompoundHullShape(*outShapePtr, shapeOptions);
 		EXPORT_END;
 	}
 
@@ -378,6 +518,7 @@ namespace losgap {
 		else delete shape;
 	}
 	EXPORT(PhysicsManager_DestroyShape, btCollisionShape* shape) {
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalDestroyShape, shape);
 		PhysicsManager::DestroyShape(shape);
 		EXPORT_END;
 	}
@@ -440,6 +581,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_CreateRigidBody, btVector3* translationPtr, btQuaternion* rotationPtr, btVector3* translationOffsetPtr, btCollisionShape* collisionShape, float_t bodyMass, INTEROP_BOOL alwaysActive, INTEROP_BOOL forceIntransigence, INTEROP_BOOL worldColOnly, INTEROP_BOOL nonWallCol, btRigidBody** outRigidBodyPtr) {
 		*outRigidBodyPtr = PhysicsManager::CreateRigidBody(translationPtr, rotationPtr, translationOffsetPtr, collisionShape, bodyMass, INTEROP_BOOL_TO_CBOOL(alwaysActive), INTEROP_BOOL_TO_CBOOL(forceIntransigence), INTEROP_BOOL_TO_CBOOL(worldColOnly), INTEROP_BOOL_TO_CBOOL(nonWallCol));
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordCreateRigidBody(*outRigidBodyPtr, translationPtr, rotationPtr, translationOffsetPtr, collisionShape, bodyMass, INTEROP_BOOL_TO_CBOOL(alwaysActive), INTEROP_BOOL_TO_CBOOL(forceIntransigence), INTEROP_BOOL_TO_CBOOL(worldColOnly), INTEROP_BOOL_TO_CBOOL(nonWallCol));
 		EXPORT_END;
 	}
 
@@ -451,6 +593,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_SetBodyProperties, btRigidBody* const body, float_t restitution, float_t linearDamping, float_t angularDamping, float_t friction, float_t rollingFriction) {
 		PhysicsManager::SetBodyProperties(body, restitution, linearDamping, angularDamping, friction, rollingFriction);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyProperties, body, restitution, linearDamping, angularDamping, friction, rollingFriction);
 		EXPORT_END;
 	}
 
@@ -460,6 +603,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_SetBodyCCD, btRigidBody* const body, float_t minSpeed, float_t ccdRadius) {
 		PhysicsManager::SetBodyCCD(body, minSpeed, ccdRadius);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyCCD, body, minSpeed, ccdRadius);
 		EXPORT_END;
 	}
 
@@ -468,9 +612,91 @@ namespace losgap {
 		delete body;
 	}
 	EXPORT(PhysicsManager_DestroyRigidBody, btRigidBody* body) {
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordDestroyRigidBody(body);
 		PhysicsManager::DestroyRigidBody(body);
 		EXPORT_END;
 	}
+
+	btRigidBody* CreateRigidBodyFromDesc(const RigidBodyDesc& desc) {
+		return PhysicsManager::CreateRigidBody(
+			desc.TranslationPtr, desc.RotationPtr, desc.TranslationOffsetPtr, desc.CollisionShape, desc.Mass,
+			INTEROP_BOOL_TO_CBOOL(desc.AlwaysActive), INTEROP_BOOL_TO_CBOOL(desc.ForceIntransigence),
+			INTEROP_BOOL_TO_CBOOL(desc.WorldColOnly), INTEROP_BOOL_TO_CBOOL(desc.NonWallCol)
+		);
+	}
+
+	void PhysicsManager::CreateRigidBodies(const RigidBodyDesc* const descArr, uint32_t numBodies, btRigidBody** outBodyArr) {
+		ScopedTrace trace { "PhysicsManager::CreateRigidBodies" };
+		ScopedMetricTimer batchTimer { METRIC_BODY_BATCH_TIME };
+		if (descArr == nullptr) throw LosgapException { "Body description array must not be null." };
+		if (outBodyArr == nullptr) throw LosgapException { "Output body array must not be null." };
+
+		// The sweep-and-prune broadphases find their pairs while sorting each new handle in to place, so there's nothing to batch there
+		if (activeBroadphaseType != DynamicTree) {
+			for (uint32_t i = 0U; i < numBodies; ++i) {
+				outBodyArr[i] = CreateRigidBodyFromDesc(descArr[i]);
+			}
+			return;
+		}
+
+		// Each new tree proxy normally queries both trees for its pairs as soon as it is inserted. With collision deferred, the inserts
+		// only place leaves; the whole batch is then rebuilt top-down, and its pairs found with one tree-vs-tree pass over the result.
+		btDbvtBroadphase* dbvtBroadphase = static_cast<btDbvtBroadphase*>(broadphaseInstance);
+		bool wasDeferred = dbvtBroadphase->m_deferedcollide;
+		dbvtBroadphase->m_deferedcollide = true;
+		try {
+			for (uint32_t i = 0U; i < numBodies; ++i) {
+				outBodyArr[i] = CreateRigidBodyFromDesc(descArr[i]);
+			}
+			if (numBodies > 0U) {
+				dbvtBroadphase->m_sets[0].optimizeTopDown();
+				dbvtBroadphase->calculateOverlappingPairs(collisionDispatcher);
+			}
+		}
+		catch (...) {
+			dbvtBroadphase->m_deferedcollide = wasDeferred;
+			throw;
+		}
+		dbvtBroadphase->m_deferedcollide = wasDeferred;
+	}
+	EXPORT(PhysicsManager_CreateRigidBodiesBatch, RigidBodyDesc* descArr, uint32_t numBodies, btRigidBody** outBodyArr) {
+		PhysicsManager::CreateRigidBodies(descArr, numBodies, outBodyArr);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordCreateRigidBodiesBatch(descArr, outBodyArr, numBodies);
+		EXPORT_END;
+	}
+
+	void PhysicsManager::DestroyRigidBodies(btRigidBody* const* const bodyArr, uint32_t numBodies) {
+		ScopedTrace trace { "PhysicsManager::DestroyRigidBodies" };
+		ScopedMetricTimer batchTimer { METRIC_BODY_BATCH_TIME };
+		if (bodyArr == nullptr) throw LosgapException { "Body array must not be null." };
+
+		// Removing leaves never leaves the tree worse balanced than it was, so unlike creation there is nothing to rebuild afterwards
+		for (uint32_t i = 0U; i < numBodies; ++i) {
+			DestroyRigidBody(bodyArr[i]);
+		}
+	}
+	EXPORT(PhysicsManager_DestroyRigidBodiesBatch, btRigidBody** bodyArr, uint32_t numBodies) {
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordDestroyRigidBodiesBatch(bodyArr, numBodies);
+		PhysicsManager::DestroyRigidBodies(bodyArr, numBodies);
+		EXPORT_END;
+	}
+
+	void PhysicsManager::SetBodyStatic(btRigidBody* const body) {
+		if (body->getInvMass() != 0.0f) throw LosgapException { "Only massless or intransigent bodies can be marked static." };
+
+		// Putting the body to sleep (and overriding DISABLE_DEACTIVATION) takes it out of the per-step AABB update, and for intransigent
+		// (kinematic) bodies also stops the motion state being polled every step. The tree broadphase then migrates its proxy to the fixed
+		// set after a few steps, so it's never re-inserted in to the dynamic set again.
+		body->setLinearVelocity(ZERO_VECTOR);
+		body->setAngularVelocity(ZERO_VECTOR);
+		body->forceActivationState(ISLAND_SLEEPING);
+		dynamicsWorld->updateSingleAabb(body);
+	}
+	EXPORT(PhysicsManager_SetBodyStatic, btRigidBody* body) {
+		PhysicsManager::SetBodyStatic(body);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyStatic, body);
+		EXPORT_END;
+	}
 #pragma endregion
 
 #pragma region Body Manipulation
@@ -478,41 +704,51 @@ namespace losgap {
 		btTransform transform;
 		body->getMotionState()->getWorldTransform(transform);
 		body->setWorldTransform(transform);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_UpdateBodyTransform, btRigidBody* body) {
 		PhysicsManager::UpdateBodyTransform(body);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::RecordUpdateBodyTransform(body);
 		EXPORT_END;
 	}
 
 	void PhysicsManager::AddForceToBody(btRigidBody* const body, const btVector3& force) {
 		body->applyCentralForce(force);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_AddForceToBody, btRigidBody* const body, const btVector3& force) {
 		PhysicsManager::AddForceToBody(body, force);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalAddForceToBody, body, force);
 		EXPORT_END;
 	}
 
 	void PhysicsManager::AddTorqueToBody(btRigidBody* const body, const btVector3& torque) {
 		body->applyTorque(torque);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_AddTorqueToBody, btRigidBody* const body, const btVector3& torque) {
 		PhysicsManager::AddTorqueToBody(body, torque);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalAddTorqueToBody, body, torque);
 		EXPORT_END;
 	}
 
 	void PhysicsManager::AddForceImpulseToBody(btRigidBody* const body, const btVector3& force) {
 		body->applyCentralImpulse(force);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_AddForceImpulseToBody, btRigidBody* const body, const btVector3& force) {
 		PhysicsManager::AddForceImpulseToBody(body, force);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalAddForceImpulseToBody, body, force);
 		EXPORT_END;
 	}
 
 	void PhysicsManager::AddTorqueImpulseToBody(btRigidBody* const body, const btVector3& torque) {
 		body->applyTorqueImpulse(torque);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_AddTorqueImpulseToBody, btRigidBody* const body, const btVector3& torque) {
 		PhysicsManager::AddTorqueImpulseToBody(body, torque);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalAddTorqueImpulseToBody, body, torque);
 		EXPORT_END;
 	}
 
@@ -521,6 +757,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_RemoveAllForceAndTorqueFromBody, btRigidBody* const body) {
 		PhysicsManager::RemoveAllForceAndTorqueFromBody(body);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalRemoveAllForceAndTorqueFromBody, body);
 		EXPORT_END;
 	}
 
@@ -542,17 +779,21 @@ namespace losgap {
 
 	void PhysicsManager::SetBodyLinearVelocity(btRigidBody* const body, const btVector3& velocity) {
 		body->setLinearVelocity(velocity);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_SetBodyLinearVelocity, btRigidBody* const body, btVector3& velocity) {
 		PhysicsManager::SetBodyLinearVelocity(body, velocity);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyLinearVelocity, body, velocity);
 		EXPORT_END;
 	}
 
 	void PhysicsManager::SetBodyAngularVelocity(btRigidBody* const body, const btVector3& velocity) {
 		body->setAngularVelocity(velocity);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_SetBodyAngularVelocity, btRigidBody* const body, btVector3& velocity) {
 		PhysicsManager::SetBodyAngularVelocity(body, velocity);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyAngularVelocity, body, velocity);
 		EXPORT_END;
 	}
 
@@ -561,6 +802,7 @@ namespace losgap {
 	}
 	EXPORT(PhysicsManager_ReactivateBody, btRigidBody* const body) {
 		PhysicsManager::ReactivateBody(body);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalReactivateBody, body);
 		EXPORT_END;
 	}
 
@@ -568,17 +810,21 @@ namespace losgap {
 		btVector3 inertia;
 		body->getCollisionShape()->calculateLocalInertia(newMass, inertia);
 		body->setMassProps(newMass, inertia);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_SetBodyMass, btRigidBody* const body, float_t newMass) {
 		PhysicsManager::SetBodyMass(body, newMass);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyMass, body, newMass);
 		EXPORT_END;
 	}
 
 	void PhysicsManager::SetBodyGravity(btRigidBody* const body, const btVector3& gravity) {
 		body->setGravity(gravity);
+		RefreshInactiveBody(body);
 	}
 	EXPORT(PhysicsManager_SetBodyGravity, btRigidBody* const body, const btVector3& gravity) {
 		PhysicsManager::SetBodyGravity(body, gravity);
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalSetBodyGravity, body, gravity);
 		EXPORT_END;
 	}
 #pragma endregion
@@ -595,6 +841,10 @@ namespace losgap {
 		btTransform initialParentTransform { parentInitialRotation, parentInitialTranslation };
 		btTransform initialChildTransform { childInitialRotation, childInitialTranslation };
 		*outConstraint = PhysicsManager::CreateFixedConstraint(*parent, *child, initialParentTransform, initialChildTransform);
+		if (PhysicsJournal::IsRecording()) {
+			PhysicsJournal::Record(JournalCreateFixedConstraint, *outConstraint, parent, child,
+				parentInitialTranslation, parentInitialRotation, childInitialTranslation, childInitialRotation);
+		}
 		EXPORT_END;
 	}
 
@@ -602,6 +852,7 @@ namespace losgap {
 		delete constraint;
 	}
 	EXPORT(PhysicsManager_DestroyConstraint, btFixedConstraint* constraint) {
+		if (PhysicsJournal::IsRecording()) PhysicsJournal::Record(JournalDestroyConstraint, constraint);
 		PhysicsManager::DestroyConstraint(constraint);
 		EXPORT_END;
 	}
@@ -7,6 +7,8 @@
 #include "btBulletDynamicsCommon.h"
 #include "CollisionShapeOptionsDesc.h"
 #include "RayTestCollisionDesc.h"
+#include "RigidBodyDesc.h"
+#include "BroadphaseDesc.h"
 
 namespace losgap {
 	/*
@@ -16,13 +18,16 @@ namespace losgap {
 	public:
 #pragma region Lifetime
 		static void Init();
+		static void Init(const BroadphaseDesc& broadphaseDesc);
 		static void Tick(btScalar deltaTime);
 		static void SetTickrate(float tickrate);
 		static const btCollisionObject** GetCollisionPairsArray(uint32_t& numPairs);
 		static void Shutdown();
+		static bool IsRunning();
 #pragma endregion
 
 #pragma region World
+		static void SetBroadphase(const BroadphaseDesc& broadphaseDesc);
 		static void SetGravity(const btVector3& gravity);
 		static btRigidBody* RayTestNearest(const btVector3& rayStart, const btVector3& rayEnd, btVector3* outHitPoint);
 		static uint32_t RayTestAll(const btVector3& rayStart, const btVector3& rayEnd, RayTestCollisionDesc* outCollisionDescArr, uint32_t arrLen);
@@ -37,6 +42,7 @@ namespace losgap {
 		static btConvexHullShape* CreateConvexHullShape(const btScalar* const vertexComponentArr, int numVertices, const CollisionShapeOptionsDesc& shapeOptions);
 		static btCompoundShape* CreateConcaveHullShape(const btScalar* const vertexComponentArr, int numVertices, const int* const indices, const int numIndices, const CollisionShapeOptionsDesc& shapeOptions, const char* acdFilePath);
 		static btCompoundShape* CreateCompoundCurveShape(const btScalar* const vertexComponentArr, const uint32_t numTrapPrisms, const CollisionShapeOptionsDesc& shapeOptions);
+		static btCompoundShape* CreateCompoundHullShape(const btScalar* const vertexComponentArr, const uint32_t* const hullNumPointsArr, const btVector3* const hullScalingArr, const uint32_t numHulls, const CollisionShapeOptionsDesc& shapeOptions);
 		static void DestroyShape(btCollisionShape* shape);
 #pragma endregion
 
@@ -45,6 +51,9 @@ namespace losgap {
 		static void SetBodyProperties(btRigidBody* const body, btScalar restitution, btScalar linearDamping, btScalar angularDamping, btScalar friction, btScalar rollingFriction);
 		static void SetBodyCCD(btRigidBody* const body, btScalar minSpeed, btScalar ccdRadius);
 		static void DestroyRigidBody(btRigidBody* const body);
+		static void CreateRigidBodies(const RigidBodyDesc* const descArr, uint32_t numBodies, btRigidBody** outBodyArr);
+		static void DestroyRigidBodies(btRigidBody* const* const bodyArr, uint32_t numBodies);
+		static void SetBodyStatic(btRigidBody* const body);
 #pragma endregion
 
 #pragma region Body Manipulation
@@ -0,0 +1,26 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "btBulletDynamicsCommon.h"
+
+namespace losgap {
+	/*
+	An interop struct detailing a single rigid body to be created as part of a batch
+	*/
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct RigidBodyDesc {
+		btVector3* TranslationPtr;
+		btQuaternion* RotationPtr;
+		btVector3* TranslationOffsetPtr;
+		btCollisionShape* CollisionShape;
+		float_t Mass;
+		INTEROP_BOOL AlwaysActive;
+		INTEROP_BOOL ForceIntransigence;
+		INTEROP_BOOL WorldColOnly;
+		INTEROP_BOOL NonWallCol;
+	};
+#pragma pack(pop)
+}
@@ -271,13 +271,31 @@ namespace Ophidian.Losgap.Rendering {
 
 		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
 			EntryPoint = "RenderPassManager_FlushInstructions")]
-		public static extern InteropBool RenderPassManager_FlushInstructions(
-			IntPtr failReason,
+		public static extern InteropErrorCode RenderPassManager_FlushInstructions(
 			DeviceContextHandle deviceContext,
 			IntPtr commandListStart,
 			uint numCommands
 		);
 
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderPassManager_FlushCompactInstructions")]
+		public static extern InteropErrorCode RenderPassManager_FlushCompactInstructions(
+			DeviceContextHandle deviceContext,
+			IntPtr commandStream,
+			uint commandStreamLenBytes
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderPassManager_DecodeCompactInstructions")]
+		public static extern InteropBool RenderPassManager_DecodeCompactInstructions(
+			IntPtr failReason,
+			IntPtr commandStream,
+			uint commandStreamLenBytes,
+			IntPtr outCommandArr,
+			uint outCommandArrLen,
+			IntPtr outNumCommands
+		);
+
 		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
 			EntryPoint = "RenderPassManager_ExecuteCommandList")]
 		public static extern InteropBool RenderPassManager_ExecuteCommandList(
@@ -286,11 +304,398 @@ namespace Ophidian.Losgap.Rendering {
 			IntPtr commandList
 		);
 
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderPassManager_FilterRedundantState")]
+		public static extern InteropBool RenderPassManager_FilterRedundantState(
+			IntPtr failReason,
+			IntPtr commandArr,
+			uint numCommands,
+			IntPtr outNumFiltered
+		);
+
 		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
 			EntryPoint = "RenderPassManager_PresentBackBuffer")]
 		public static extern InteropBool RenderPassManager_PresentBackBuffer(
 			IntPtr failReason,
 			SwapChainHandle swapChainHandle
 		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "DrawSorter_Sort")]
+		public static extern InteropErrorCode DrawSorter_Sort(
+			IntPtr layout, // SortKeyLayout*
+			IntPtr recordArr, // DrawRecord*
+			uint numRecords,
+			IntPtr outOrder // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "DrawSorter_SetDepths")]
+		public static extern InteropErrorCode DrawSorter_SetDepths(
+			IntPtr transformArr, // Transform*
+			uint numRecords,
+			IntPtr viewPosition, // Vector3*
+			IntPtr recordArr // DrawRecord*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "DrawSorter_EmitCommands")]
+		public static extern InteropErrorCode DrawSorter_EmitCommands(
+			IntPtr recordArr, // DrawRecord*
+			IntPtr order, // uint*
+			uint numRecords,
+			IntPtr tables, // DrawStateTables*
+			InteropBool packInstances,
+			uint firstPackedInstance,
+			IntPtr outCommandArr, // RenderCommand*
+			uint outCommandArrLen,
+			IntPtr outNumCommands // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "DrawSorter_SortByDistance")]
+		public static extern InteropErrorCode DrawSorter_SortByDistance(
+			IntPtr transformArr, // Transform*
+			IntPtr groupArr, // uint*
+			uint numInstances,
+			IntPtr viewPosition, // Vector3*
+			InteropBool backToFront,
+			IntPtr outOrder // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderPassManager_FlushParallel")]
+		public static extern InteropErrorCode RenderPassManager_FlushParallel(
+			DeviceContextHandle immediateContext,
+			IntPtr deferredContextArr, // DeviceContextHandle*
+			IntPtr commandStreamArr, // byte**
+			IntPtr commandStreamLenArr, // uint*
+			uint numStreams
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FlushProfiler_SetEnabled")]
+		public static extern InteropBool FlushProfiler_SetEnabled(
+			IntPtr failReason,
+			InteropBool enabled
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FlushProfiler_Snapshot")]
+		public static extern InteropBool FlushProfiler_Snapshot(
+			IntPtr failReason,
+			IntPtr outSnapshotArr, // FlushProfileSnapshot*
+			uint arrLen,
+			InteropBool resetAfterwards,
+			IntPtr outNumProfiles // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderCommandCapture_BeginCapture")]
+		public static extern InteropBool RenderCommandCapture_BeginCapture(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string captureFilePath
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderCommandCapture_EndCapture")]
+		public static extern InteropBool RenderCommandCapture_EndCapture(
+			IntPtr failReason
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "RenderCommandReplay_ReplayOnCountingContexts")]
+		public static extern InteropBool RenderCommandReplay_ReplayOnCountingContexts(
+			IntPtr failReason,
+			[MarshalAs(InteropUtils.INTEROP_STRING_TYPE)] string captureFilePath,
+			uint numRepetitions,
+			IntPtr outResult // RenderCaptureReplayResult*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrustumCuller_CreateFrustum")]
+		public static extern InteropErrorCode FrustumCuller_CreateFrustum(
+			IntPtr viewProjMat, // Matrix*
+			IntPtr outFrustum // FrustumPlanes*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrustumCuller_CullSpheres")]
+		public static extern InteropErrorCode FrustumCuller_CullSpheres(
+			IntPtr frustum, // FrustumPlanes*
+			IntPtr sphereArr, // BoundingSphere*
+			uint numSpheres,
+			IntPtr outVisibleIndices, // uint*
+			IntPtr outNumVisible // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrustumCuller_CullInstances")]
+		public static extern InteropErrorCode FrustumCuller_CullInstances(
+			IntPtr frustum, // FrustumPlanes*
+			IntPtr modelSphereArr, // BoundingSphere*
+			uint numModels,
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances,
+			IntPtr outVisibleIndices, // uint*
+			IntPtr outNumVisible // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrustumCuller_CreateShadowCasterFrustum")]
+		public static extern InteropErrorCode FrustumCuller_CreateShadowCasterFrustum(
+			IntPtr lightViewProjMat, // Matrix*
+			IntPtr outFrustum // FrustumPlanes*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrustumCuller_CreateShadowReceiverFrustum")]
+		public static extern InteropErrorCode FrustumCuller_CreateShadowReceiverFrustum(
+			IntPtr receiverViewProjMat, // Matrix*
+			IntPtr lightDirection, // Vector3*
+			float shadowLength,
+			IntPtr outFrustum // FrustumPlanes*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "FrustumCuller_CullShadowCasters")]
+		public static extern InteropErrorCode FrustumCuller_CullShadowCasters(
+			IntPtr casterFrustum, // FrustumPlanes*
+			IntPtr receiverFrustum, // FrustumPlanes* (nullable)
+			IntPtr modelSphereArr, // BoundingSphere*
+			uint numModels,
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances,
+			IntPtr outVisibleIndices, // uint*
+			IntPtr outNumVisible // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceMatrixWriter_WriteTransposedMatrices")]
+		public static extern InteropErrorCode InstanceMatrixWriter_WriteTransposedMatrices(
+			IntPtr transformArr, // Transform*
+			IntPtr indexArr, // uint*
+			uint numIndices,
+			IntPtr outMatrixArr // Matrix*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "LightBinner_CalculateScreenRects")]
+		public static extern InteropErrorCode LightBinner_CalculateScreenRects(
+			IntPtr lightArr, // LightProperties*
+			uint numLights,
+			IntPtr viewProjMat, // Matrix*
+			IntPtr outRectArr // ScreenRect*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "LightBinner_BinLights")]
+		public static extern InteropErrorCode LightBinner_BinLights(
+			IntPtr lightArr, // LightProperties*
+			uint numLights,
+			IntPtr viewProjMat, // Matrix*
+			uint numTilesX,
+			uint numTilesY,
+			IntPtr outTileOffsetArr, // uint*
+			IntPtr outLightIndexArr, // uint*
+			uint outLightIndexArrLen,
+			IntPtr outNumIndices // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "OcclusionCuller_GetHiZLength")]
+		public static extern InteropErrorCode OcclusionCuller_GetHiZLength(
+			uint width,
+			uint height,
+			IntPtr outHiZLength // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "OcclusionCuller_FindEdgeNeighbours")]
+		public static extern InteropErrorCode OcclusionCuller_FindEdgeNeighbours(
+			IntPtr vertexArr, // Vector3*
+			uint numVertices,
+			IntPtr indexArr, // uint*
+			uint numIndices,
+			IntPtr outNeighbourArr // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "OcclusionCuller_RasterizeOccluders")]
+		public static extern InteropErrorCode OcclusionCuller_RasterizeOccluders(
+			IntPtr buffer, // OcclusionBuffer*
+			IntPtr viewProjMat, // Matrix*
+			IntPtr vertexArr, // Vector3*
+			uint numVertices,
+			IntPtr indexArr, // uint*
+			IntPtr edgeNeighbourArr, // uint*
+			uint numIndices
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "OcclusionCuller_TestBoxes")]
+		public static extern InteropErrorCode OcclusionCuller_TestBoxes(
+			IntPtr buffer, // OcclusionBuffer*
+			IntPtr viewProjMat, // Matrix*
+			IntPtr boxArr, // OcclusionBox*
+			uint numBoxes,
+			IntPtr outVisibilityBits // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "OcclusionCuller_CullInstances")]
+		public static extern InteropErrorCode OcclusionCuller_CullInstances(
+			IntPtr buffer, // OcclusionBuffer*
+			IntPtr viewProjMat, // Matrix*
+			IntPtr modelSphereArr, // BoundingSphere*
+			uint numModels,
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances,
+			IntPtr outVisibleIndices, // uint*
+			IntPtr outNumVisible // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_Create")]
+		public static extern InteropErrorCode InstanceBVH_Create(
+			IntPtr outBVH // InstanceBVH**
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_Destroy")]
+		public static extern InteropErrorCode InstanceBVH_Destroy(
+			IntPtr bvh // InstanceBVH*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_GetCount")]
+		public static extern InteropErrorCode InstanceBVH_GetCount(
+			IntPtr bvh, // InstanceBVH*
+			IntPtr outCount // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_GetHeight")]
+		public static extern InteropErrorCode InstanceBVH_GetHeight(
+			IntPtr bvh, // InstanceBVH*
+			IntPtr outHeight // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_Build")]
+		public static extern InteropErrorCode InstanceBVH_Build(
+			IntPtr bvh, // InstanceBVH*
+			IntPtr keyArr, // ulong*
+			IntPtr modelSphereArr, // BoundingSphere*
+			uint numModels,
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_Insert")]
+		public static extern InteropErrorCode InstanceBVH_Insert(
+			IntPtr bvh, // InstanceBVH*
+			ulong key,
+			IntPtr modelSphere, // BoundingSphere*
+			IntPtr transform // Transform*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_Update")]
+		public static extern InteropErrorCode InstanceBVH_Update(
+			IntPtr bvh, // InstanceBVH*
+			ulong key,
+			IntPtr modelSphere, // BoundingSphere*
+			IntPtr transform, // Transform*
+			IntPtr outFound // InteropBool*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_Remove")]
+		public static extern InteropErrorCode InstanceBVH_Remove(
+			IntPtr bvh, // InstanceBVH*
+			ulong key,
+			IntPtr outRemoved // InteropBool*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_QueryFrustum")]
+		public static extern InteropErrorCode InstanceBVH_QueryFrustum(
+			IntPtr bvh, // InstanceBVH*
+			IntPtr frustum, // FrustumPlanes*
+			IntPtr outKeyArr, // ulong*
+			uint outKeyArrLen,
+			IntPtr outNumKeys // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_QuerySphere")]
+		public static extern InteropErrorCode InstanceBVH_QuerySphere(
+			IntPtr bvh, // InstanceBVH*
+			IntPtr sphere, // BoundingSphere*
+			IntPtr outKeyArr, // ulong*
+			uint outKeyArrLen,
+			IntPtr outNumKeys // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "InstanceBVH_QueryRay")]
+		public static extern InteropErrorCode InstanceBVH_QueryRay(
+			IntPtr bvh, // InstanceBVH*
+			IntPtr origin, // Vector3*
+			IntPtr direction, // Vector3*
+			float maxDistance,
+			IntPtr outKeyArr, // ulong*
+			uint outKeyArrLen,
+			IntPtr outNumKeys // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "LODSelector_SelectLODs")]
+		public static extern InteropErrorCode LODSelector_SelectLODs(
+			IntPtr table, // LODTable*
+			IntPtr modelSphereArr, // BoundingSphere*
+			IntPtr transformArr, // Transform*
+			IntPtr modelIndexArr, // uint*
+			uint numInstances,
+			IntPtr viewPosition, // Vector3*
+			float projectionScale,
+			InteropBool isPerspective,
+			float hysteresis,
+			IntPtr lodStateArr, // byte*
+			IntPtr outDrawRangeArr // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "MeshClusterer_BuildClusters")]
+		public static extern InteropErrorCode MeshClusterer_BuildClusters(
+			IntPtr positionArr, // Vector3*
+			uint numVertices,
+			IntPtr indexArr, // uint*
+			uint numIndices,
+			uint maxTrianglesPerCluster,
+			IntPtr outIndexArr, // uint*
+			IntPtr outClusterArr, // MeshCluster*
+			IntPtr outNumClusters // uint*
+		);
+
+		[DllImport(NATIVE_DLL_NAME, CallingConvention = InteropUtils.DEFAULT_CALLING_CONVENTION,
+			EntryPoint = "MeshClusterer_CullClusters")]
+		public static extern InteropErrorCode MeshClusterer_CullClusters(
+			IntPtr frustum, // FrustumPlanes*
+			IntPtr viewPosition, // Vector3*
+			InteropBool cullBackFacing,
+			IntPtr clusterArr, // MeshCluster*
+			uint numClusters,
+			IntPtr transform, // Transform*
+			uint firstIndex,
+			IntPtr outRangeArr, // IndexRange*
+			IntPtr outNumRanges // uint*
+		);
 	}
 }
\ No newline at end of file
@@ -23,6 +23,11 @@ namespace Ophidian.Losgap.Rendering {
 	/// <see cref="SceneLayerRenderingExtensions.CreateModelInstance">SceneLayer.CreateModelInstance()</see> with the relevant model indices. 
 	/// </remarks>
 	public unsafe sealed class GeometryCache : IDisposable {
+		/// <summary>
+		/// The most levels of detail (including the model itself) that any one model can have. Must match MAX_LODS_PER_MODEL in
+		/// RenderingNative.
+		/// </summary>
+		public const uint MAX_LODS_PER_MODEL = 8U;
 		private static readonly object staticMutationLock = new object();
 		private static readonly Dictionary<int, GeometryCache> activeCaches = new Dictionary<int, GeometryCache>();
 		private static readonly List<GeometryCache> activeCacheList = new List<GeometryCache>();
@@ -35,6 +40,40 @@ namespace Ophidian.Losgap.Rendering {
 		/// </summary>
 		public readonly Type VertexType;
 		internal readonly int ID;
+		/// <summary>
+		/// A bounding sphere per model in model space, or null if the vertex type has no Vector3 "POSITION" component (in which case
+		/// instances of this cache's models are never culled).
+		/// </summary>
+		internal readonly FrustumCuller.BoundingSphere[] ModelBounds;
+		/// <summary>
+		/// Every model's levels of detail, flattened in to one list: model <c>m</c>'s are <c>ModelFirstLODs[m]</c> up to
+		/// <c>ModelFirstLODs[m + 1]</c>, finest (the model itself) first. Has <see cref="NumModels"/> + 1 entries.
+		/// </summary>
+		internal readonly uint[] ModelFirstLODs;
+		/// <summary>
+		/// The largest screen size each level of detail is drawn at (see <see cref="GeometryCacheBuilder{TVertex}.AddModelLOD"/>); infinite
+		/// for each model's finest.
+		/// </summary>
+		internal readonly float[] LODMaxScreenSizes;
+		/// <summary>
+		/// The number of levels of detail in <see cref="ModelFirstLODs"/>, across all models.
+		/// </summary>
+		internal readonly uint NumLODs;
+		/// <summary>
+		/// True if any model in this cache has more than one level of detail.
+		/// </summary>
+		internal readonly bool HasLODs;
+		/// <summary>
+		/// Every clustered model's clusters (see <see cref="GeometryCacheBuilder{TVertex}.AddModelClusters"/>), flattened in to one list:
+		/// model <c>m</c>'s are <c>Clusters[ModelFirstClusters[m]]</c> up to <c>Clusters[ModelFirstClusters[m + 1]]</c>. Both are null
+		/// if no model in this cache is clustered.
+		/// </summary>
+		internal readonly MeshClusterer.Cluster[] Clusters;
+		internal readonly uint[] ModelFirstClusters;
+		/// <summary>
+		/// True if any model in this cache is split in to clusters.
+		/// </summary>
+		internal readonly bool HasClusters;
 		private readonly object instanceMutationLock = new object();
 		private readonly Dictionary<VertexShader, GeometryInputLayout> assembledInputLayouts = new Dictionary<VertexShader, GeometryInputLayout>();
 		private readonly IVertexBuffer[] vertexComponentBuffers;
@@ -45,7 +84,10 @@ namespace Ophidian.Losgap.Rendering {
 		private readonly AlignedAllocation<uint> indexStartPointsAlloc;
 		private readonly uint* componentStartPoints;
 		private readonly uint* indexStartPoints;
-		private readonly ModelInstanceManager instanceManager = new ModelInstanceManager();
+		private readonly uint[] lodModelIndices;
+		private readonly uint[] lodIndexStartPoints;
+		private readonly uint[] lodIndexCounts;
+		private readonly ModelInstanceManager instanceManager;
 		private readonly Dictionary<string, ModelHandle> nameToHandleMap = new Dictionary<string, ModelHandle>();
 		private bool isDisposed = false;
 		private readonly Func<VertexShader, GeometryInputLayout> createInputLayoutFunc;
@@ -118,7 +160,9 @@ namespace Ophidian.Losgap.Rendering {
 
 		internal GeometryCache(IVertexBuffer[] vertexComponentBuffers, string[] vertexComponentSemantics, ResourceFormat[] vertexComponentFormats,
 			IndexBuffer indices, AlignedAllocation<uint> componentStartPointsAlloc, AlignedAllocation<uint> indexStartPointsAlloc, uint numModels,
-			Type vertexType, int cacheID, Dictionary<string, ModelHandle> nameToHandleMap, bool orderFirst) {
+			Type vertexType, int cacheID, Dictionary<string, ModelHandle> nameToHandleMap, bool orderFirst, FrustumCuller.BoundingSphere[] modelBounds = null,
+			uint[] modelFirstLODs = null, float[] lodMaxScreenSizes = null, uint[] lodIndexStartPoints = null, uint[] lodIndexCounts = null,
+			MeshClusterer.Cluster[] clusters = null, uint[] modelFirstClusters = null) {
 			Assure.NotNull(vertexComponentBuffers);
 			Assure.NotNull(vertexComponentSemantics);
 			Assure.NotNull(vertexComponentFormats);
@@ -127,6 +171,14 @@ namespace Ophidian.Losgap.Rendering {
 			Assure.Equal(vertexComponentFormats.Length, vertexComponentSemantics.Length, "One or more vertex component arrays have different lengths.");
 			Assure.GreaterThan(vertexComponentBuffers.Length, 0, "Geometry cache with no vertex buffers is invalid.");
 			Assure.NotNull(nameToHandleMap);
+			Assure.True(modelBounds == null || modelBounds.Length == numModels, "There must be exactly one bounding sphere per model.");
+			Assure.True(
+				(modelFirstLODs == null && lodMaxScreenSizes == null && lodIndexStartPoints == null && lodIndexCounts == null)
+				|| (modelFirstLODs != null && lodMaxScreenSizes != null && lodIndexStartPoints != null && lodIndexCounts != null),
+				"Level of detail arrays must be given all together or not at all."
+			);
+			Assure.True((clusters == null) == (modelFirstClusters == null), "Cluster arrays must be given together or not at all.");
+			Assure.True(modelFirstClusters == null || modelFirstClusters.Length == numModels + 1U, "There must be exactly one first cluster per model.");
 			this.vertexComponentBuffers = vertexComponentBuffers;
 			this.vertexComponentSemantics = vertexComponentSemantics;
 			this.vertexComponentFormats = vertexComponentFormats;
@@ -139,6 +191,35 @@ namespace Ophidian.Losgap.Rendering {
 			this.VertexType = vertexType;
 			this.ID = cacheID;
 			this.nameToHandleMap = nameToHandleMap;
+			this.ModelBounds = modelBounds;
+			if (modelFirstLODs == null) { // One level of detail per model: the model itself
+				modelFirstLODs = new uint[numModels + 1U];
+				lodMaxScreenSizes = new float[numModels];
+				lodIndexStartPoints = new uint[numModels];
+				lodIndexCounts = new uint[numModels];
+				for (uint i = 0U; i < numModels; ++i) {
+					modelFirstLODs[i] = i;
+					lodMaxScreenSizes[i] = Single.PositiveInfinity;
+					lodIndexStartPoints[i] = indexStartPoints[i];
+					lodIndexCounts[i] = indexStartPoints[i + 1U] - indexStartPoints[i];
+				}
+				modelFirstLODs[numModels] = numModels;
+			}
+			Assure.Equal((uint) modelFirstLODs.Length, numModels + 1U, "There must be exactly one first level of detail per model.");
+			this.ModelFirstLODs = modelFirstLODs;
+			this.LODMaxScreenSizes = lodMaxScreenSizes;
+			this.NumLODs = modelFirstLODs[numModels];
+			this.HasLODs = NumLODs > numModels;
+			this.lodIndexStartPoints = lodIndexStartPoints;
+			this.lodIndexCounts = lodIndexCounts;
+			this.Clusters = clusters;
+			this.ModelFirstClusters = modelFirstClusters;
+			this.HasClusters = clusters != null;
+			this.lodModelIndices = new uint[NumLODs];
+			for (uint i = 0U; i < numModels; ++i) {
+				for (uint l = modelFirstLODs[i]; l < modelFirstLODs[i + 1U]; ++l) lodModelIndices[l] = i;
+			}
+			this.instanceManager = new ModelInstanceManager(modelBounds);
 			lock (staticMutationLock) {
 				activeCaches.Add(ID, this);
 				if (orderFirst) activeCacheList.Insert(0, this);
@@ -181,6 +262,20 @@ namespace Ophidian.Losgap.Rendering {
 			throw new KeyNotFoundException("No model with name '" + modelName + "' exists in any active geometry cache.");
 		}
 
+		/// <summary>
+		/// Rebuilds every active cache's spatial index of static instances from all of its current instances. Call once a level (or any
+		/// other mostly-static scene) has finished loading, so that <see cref="FindInstances(Sphere, List{ModelInstanceHandle})"/> and
+		/// its overloads search a tree that was built all at once. Instances that move afterwards are moved back
+		/// in to the dynamic index automatically.
+		/// </summary>
+		public static void BuildStaticInstanceTrees() {
+			lock (staticMutationLock) {
+				foreach (GeometryCache cache in ActiveCaches) {
+					cache.instanceManager.BuildStaticTree();
+				}
+			}
+		}
+
 		internal static GeometryCache GetCacheByID(int id) {
 			Assure.True(activeCaches.ContainsKey(id), "No active geometry cache with ID '" + id + "' exists!");
 			return activeCaches[id];
@@ -262,11 +357,50 @@ namespace Ophidian.Losgap.Rendering {
 			ibCount = indexStartPoints[modelIndex + 1] - ibStartIndex;
 		}
 
+		/// <summary>
+		/// As <see cref="GetModelBufferValues"/>, but for one level of detail (an index in to the flattened list described by
+		/// <see cref="ModelFirstLODs"/>). Every level of a model shares its vertices.
+		/// </summary>
+		[MethodImpl(MethodImplOptions.AggressiveInlining)]
+		internal void GetLODBufferValues(uint lodIndex, out uint vbStartIndex, out uint ibStartIndex, out uint vbCount, out uint ibCount) {
+			Assure.LessThan(lodIndex, NumLODs);
+
+			uint modelIndex = lodModelIndices[lodIndex];
+			vbStartIndex = componentStartPoints[modelIndex];
+			vbCount = componentStartPoints[modelIndex + 1] - vbStartIndex;
+
+			ibStartIndex = lodIndexStartPoints[lodIndex];
+			ibCount = lodIndexCounts[lodIndex];
+		}
+
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		internal ModelInstanceHandle AllocInstance(uint modelIndex, uint sceneLayerIndex, uint materialIndex, Transform initialTransform) {
 			return instanceManager.AllocateInstance(materialIndex, modelIndex, sceneLayerIndex, initialTransform);
 		}
 
+		/// <summary>
+		/// Adds every instance of this cache's models whose bounding sphere touches the given <paramref name="sphere"/> to
+		/// <paramref name="outInstances"/> (in no particular order). Finds nothing if this cache has no model bounds.
+		/// </summary>
+		public void FindInstances(Sphere sphere, List<ModelInstanceHandle> outInstances) {
+			instanceManager.FindInstances(sphere, outInstances);
+		}
+
+		/// <summary>
+		/// Adds every instance of this cache's models whose bounding sphere is touched by the given <paramref name="ray"/> to
+		/// <paramref name="outInstances"/> (in no particular order). Finds nothing if this cache has no model bounds.
+		/// </summary>
+		public void FindInstances(Ray ray, List<ModelInstanceHandle> outInstances) {
+			instanceManager.FindInstances(ray, outInstances);
+		}
+
+		/// <summary>
+		/// See <see cref="ModelInstanceManager.FindInstanceKeys"/>: used by render passes to visit only the instances in view.
+		/// </summary>
+		internal uint? FindInstanceKeys(FrustumCuller.FrustumPlanes frustum, ref ulong[] outKeys) {
+			return instanceManager.FindInstanceKeys(frustum, ref outKeys);
+		}
+
 		[MethodImpl(MethodImplOptions.AggressiveInlining)]
 		internal ArraySlice<KeyValuePair<Material, ModelInstanceManager.MIDArray>> GetModelInstanceData() {
 			return instanceManager.GetModelInstanceData();
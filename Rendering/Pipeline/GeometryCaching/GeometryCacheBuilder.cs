@@ -19,6 +19,7 @@ namespace Ophidian.Losgap.Rendering {
 	/// Every field in the given type must be annotated with a single <see cref="VertexComponentAttribute"/>.</typeparam>
 	public sealed class GeometryCacheBuilder<TVertex> {
 		private const int START_POINT_ARRAY_ALIGNMENT = 7; // Prime number to avoid page alignment
+		private const string POSITION_SEMANTIC = "POSITION"; // Models are only given bounds (and so culled) if they have Vector3 positions
 		private static int nextCacheID = -1;
 		private readonly int cacheID = Interlocked.Increment(ref nextCacheID);
 		private readonly object instanceMutationLock = new object();
@@ -27,6 +28,9 @@ namespace Ophidian.Losgap.Rendering {
 		private readonly List<uint> vertexCounts = new List<uint>();
 		private readonly List<uint> indexCounts = new List<uint>();
 		private readonly List<string> modelNames = new List<string>();
+		private readonly Dictionary<uint, List<KeyValuePair<float, uint[]>>> modelLODs = new Dictionary<uint, List<KeyValuePair<float, uint[]>>>();
+		private readonly Dictionary<uint, MeshClusterer.Cluster[]> modelClusters = new Dictionary<uint, MeshClusterer.Cluster[]>();
+		private FrustumCuller.BoundingSphere[] modelBounds = null;
 		private bool isBuilt = false;
 		private bool orderFirst = false;
 
@@ -72,6 +76,80 @@ namespace Ophidian.Losgap.Rendering {
 			}
 		}
 
+		/// <summary>
+		/// Adds a coarser level of detail to a model previously added with <see cref="AddModel"/>: a second index list over the same
+		/// vertices (e.g. one made by <c>MeshSimplifier.Simplify()</c>), drawn instead of the previous level once an instance's
+		/// screen size drops to <paramref name="maxScreenSize"/> or below. Levels must be added from finest to coarsest.
+		/// </summary>
+		/// <param name="model">The model to add the level of detail to. Must have been returned by this builder.</param>
+		/// <param name="indices">The list of 0-based indices in to the model's vertex list. Must not be null.</param>
+		/// <param name="maxScreenSize">The largest screen size (the projected diameter of an instance's bounding sphere, as a fraction of
+		/// the viewport's height) that this level is drawn at. Must be smaller than that of the previous level.</param>
+		[System.Diagnostics.CodeAnalysis.SuppressMessage("Microsoft.Naming", "CA1726:UsePreferredTerms", MessageId = "indices",
+			Justification = "Indices is more in-tune with the graphics-programming side of the world.")]
+		public void AddModelLOD(ModelHandle model, IList<uint> indices, float maxScreenSize) {
+			if (indices == null) throw new ArgumentNullException("indices");
+			if (indices.Count == 0) throw new ArgumentException("Invalid level of detail: Empty index list.", "indices");
+			if (!(maxScreenSize > 0f)) throw new ArgumentOutOfRangeException("maxScreenSize", "Maximum screen size must be greater than zero.");
+
+			lock (instanceMutationLock) {
+				if (isBuilt) throw new InvalidOperationException("Can not add levels of detail after cache has been built.");
+				if (model.GeoCacheID != cacheID || model.ModelIndex >= vertexCounts.Count) {
+					throw new ArgumentException("Given model was not added to this builder.", "model");
+				}
+				uint vertexCount = vertexCounts[(int) model.ModelIndex];
+				for (int i = 0; i < indices.Count; ++i) {
+					if (indices[i] >= vertexCount) throw new ArgumentException("Level of detail index " + indices[i] + " is out of range.", "indices");
+				}
+
+				List<KeyValuePair<float, uint[]>> lods;
+				if (!modelLODs.TryGetValue(model.ModelIndex, out lods)) {
+					lods = new List<KeyValuePair<float, uint[]>>();
+					modelLODs.Add(model.ModelIndex, lods);
+				}
+				if (lods.Count + 1 >= GeometryCache.MAX_LODS_PER_MODEL) {
+					throw new InvalidOperationException("Models can have at most " + GeometryCache.MAX_LODS_PER_MODEL + " levels of detail.");
+				}
+				if (lods.Count > 0 && maxScreenSize >= lods[lods.Count - 1].Key) {
+					throw new ArgumentOutOfRangeException("maxScreenSize", "Each level of detail must have a smaller maximum screen size than the last.");
+				}
+				lods.Add(new KeyValuePair<float, uint[]>(maxScreenSize, indices.ToArray()));
+			}
+		}
+
+		/// <summary>
+		/// Splits a model previously added with <see cref="AddModel"/> in to clusters (made by <see cref="MeshClusterer.BuildClusters"/>,
+		/// whose reordered indices must be the ones the model was added with), so that each frame only the clusters in view and facing the
+		/// camera are drawn. Clustered models are drawn one instance at a time, so this is only worthwhile for large meshes that are
+		/// instanced rarely (such as level geometry), and clusters are only used while the model is drawn at its finest level of detail.
+		/// </summary>
+		/// <param name="model">The model to add the clusters to. Must have been returned by this builder.</param>
+		/// <param name="clusters">The model's clusters. Must not be null or empty, and each must lie within the model's index list.</param>
+		public void AddModelClusters(ModelHandle model, IList<MeshClusterer.Cluster> clusters) {
+			if (clusters == null) throw new ArgumentNullException("clusters");
+			if (clusters.Count == 0) throw new ArgumentException("Invalid cluster list: No clusters.", "clusters");
+
+			lock (instanceMutationLock) {
+				if (isBuilt) throw new InvalidOperationException("Can not add clusters after cache has been built.");
+				if (model.GeoCacheID != cacheID || model.ModelIndex >= vertexCounts.Count) {
+					throw new ArgumentException("Given model was not added to this builder.", "model");
+				}
+				if (modelClusters.ContainsKey(model.ModelIndex)) {
+					throw new InvalidOperationException("Given model already has clusters.");
+				}
+				uint indexCount = indexCounts[(int) model.ModelIndex];
+				for (int i = 0; i < clusters.Count; ++i) {
+					MeshClusterer.Cluster cluster = clusters[i];
+					if (cluster.NumIndices == 0U || cluster.NumIndices % 3U != 0U || cluster.NumIndices > MeshClusterer.MAX_CLUSTER_TRIANGLES * 3U
+						|| cluster.FirstIndex % 3U != 0U || cluster.FirstIndex > indexCount || cluster.NumIndices > indexCount - cluster.FirstIndex) {
+						throw new ArgumentException("Cluster " + i + " is not a valid run of triangles in the model's index list.", "clusters");
+					}
+				}
+
+				modelClusters.Add(model.ModelIndex, clusters.ToArray());
+			}
+		}
+
 		/// <summary>
 		/// Builds the <see cref="GeometryCache"/> with all the models that have previously been added with <see cref="AddModel"/>.
 		/// This method may only be called once per GeometryCacheBuilder.
@@ -125,8 +203,6 @@ namespace Ophidian.Losgap.Rendering {
 						.Invoke(this, new object[] { component, i, vertexComponentBuffers, vertexComponentSemantics, vertexComponentFormats });
 				}
 
-				IndexBuffer indexBuffer = BufferFactory.NewIndexBuffer().WithInitialData(indices.ToArray()).WithUsage(ResourceUsage.Immutable);
-
 				Assure.Equal(vertexCounts.Count, indexCounts.Count);
 				AlignedAllocation<uint> componentStartPointsAlloc = AlignedAllocation<uint>.AllocArray(
 					START_POINT_ARRAY_ALIGNMENT, 
@@ -152,6 +228,61 @@ namespace Ophidian.Losgap.Rendering {
 				componentStartPtr[vertexCounts.Count] = (uint) vertices.Count;
 				indexStartPtr[vertexCounts.Count] = (uint) indices.Count;
 
+				// Flatten every model's levels of detail in to one list (each model's own first), and put the indices of the extra levels
+				// after all the models' first ones, so that the start points above still describe each model as a whole
+				uint numLODs = (uint) vertexCounts.Count;
+				uint numIndices = (uint) indices.Count;
+				foreach (List<KeyValuePair<float, uint[]>> lods in modelLODs.Values) {
+					numLODs += (uint) lods.Count;
+					for (int i = 0; i < lods.Count; ++i) numIndices += (uint) lods[i].Value.Length;
+				}
+				uint[] indexArr = new uint[numIndices];
+				indices.CopyTo(indexArr);
+				uint[] modelFirstLODs = new uint[vertexCounts.Count + 1];
+				float[] lodMaxScreenSizes = new float[numLODs];
+				uint[] lodIndexStartPoints = new uint[numLODs];
+				uint[] lodIndexCounts = new uint[numLODs];
+				uint lodCounter = 0U;
+				ibCounter = (uint) indices.Count;
+				for (int i = 0; i < vertexCounts.Count; ++i) {
+					modelFirstLODs[i] = lodCounter;
+					lodMaxScreenSizes[lodCounter] = Single.PositiveInfinity;
+					lodIndexStartPoints[lodCounter] = indexStartPtr[i];
+					lodIndexCounts[lodCounter] = indexCounts[i];
+					++lodCounter;
+
+					List<KeyValuePair<float, uint[]>> lods;
+					if (!modelLODs.TryGetValue((uint) i, out lods)) continue;
+					foreach (KeyValuePair<float, uint[]> lod in lods) {
+						lodMaxScreenSizes[lodCounter] = lod.Key;
+						lodIndexStartPoints[lodCounter] = ibCounter;
+						lodIndexCounts[lodCounter] = (uint) lod.Value.Length;
+						Array.Copy(lod.Value, 0, indexArr, ibCounter, lod.Value.Length);
+						ibCounter += (uint) lod.Value.Length;
+						++lodCounter;
+					}
+				}
+				modelFirstLODs[vertexCounts.Count] = lodCounter;
+
+				// Flatten the clustered models' clusters in to one list too (models without any simply have none)
+				MeshClusterer.Cluster[] clusterArr = null;
+				uint[] modelFirstClusters = null;
+				if (modelClusters.Count > 0) {
+					clusterArr = new MeshClusterer.Cluster[modelClusters.Values.Sum(clusters => clusters.Length)];
+					modelFirstClusters = new uint[vertexCounts.Count + 1];
+					uint clusterCounter = 0U;
+					for (int i = 0; i < vertexCounts.Count; ++i) {
+						modelFirstClusters[i] = clusterCounter;
+						MeshClusterer.Cluster[] clusters;
+						if (!modelClusters.TryGetValue((uint) i, out clusters)) continue;
+						Array.Copy(clusters, 0, clusterArr, clusterCounter, clusters.Length);
+						clusterCounter += (uint) clusters.Length;
+					}
+					modelFirstClusters[vertexCounts.Count] = clusterCounter;
+				}
+
+				IndexBuffer indexBuffer = BufferFactory.NewIndexBuffer().WithInitialData(indexArr).WithUsage(ResourceUsage.Immutable);
+
 				Dictionary<string, ModelHandle> modelNameToHandleMap = new Dictionary<string, ModelHandle>();
 				for (uint i = 0U; i < modelNames.Count; ++i) {
 					modelNameToHandleMap.Add(modelNames[(int) i], new ModelHandle(cacheID, i));
@@ -170,7 +301,14 @@ namespace Ophidian.Losgap.Rendering {
 					typeof(TVertex),
 					cacheID,
 					modelNameToHandleMap,
-					orderFirst
+					orderFirst,
+					modelBounds,
+					modelFirstLODs,
+					lodMaxScreenSizes,
+					lodIndexStartPoints,
+					lodIndexCounts,
+					clusterArr,
+					modelFirstClusters
 				);
 			}
 		}
@@ -190,6 +328,9 @@ namespace Ophidian.Losgap.Rendering {
 
 			vertexComponentBuffers[componentIndex] = componentBuffer;
 			vertexComponentSemantics[componentIndex] = component.GetCustomAttribute<VertexComponentAttribute>().SemanticName;
+			if (vertexComponentSemantics[componentIndex] == POSITION_SEMANTIC && initialData is Vector3[]) {
+				modelBounds = FrustumCuller.CalculateModelBounds(initialData as Vector3[], vertexCounts);
+			}
 			ResourceFormat componentFormat = (ResourceFormat) component.GetCustomAttribute<VertexComponentAttribute>().D3DResourceFormat;
 			if (componentFormat == ResourceFormat.Unknown) {
 				componentFormat = BaseResource.GetFormatForType(typeof(TComponent));
@@ -0,0 +1,159 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 00:57 by Ben Bowen
+
+using System;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to a native bounding volume hierarchy over model instances (InstanceBVH in RenderingNative), keyed by 64-bit
+	/// values (see <see cref="ModelInstanceManager"/>). Not thread-safe: the owner must lock around every call.
+	/// </summary>
+	internal sealed unsafe class InstanceBVH : IDisposable {
+		private readonly IntPtr nativeTree;
+		private bool isDisposed = false;
+
+		public uint Count {
+			get {
+				uint result;
+				NativeMethods.InstanceBVH_GetCount(nativeTree, (IntPtr) (&result)).ThrowOnFailure();
+				return result;
+			}
+		}
+
+		/// <summary>
+		/// The number of levels below the root (0 when empty). Insertions rebalance the tree, so this stays logarithmic in
+		/// <see cref="Count"/> however the instances are added.
+		/// </summary>
+		public uint Height {
+			get {
+				uint result;
+				NativeMethods.InstanceBVH_GetHeight(nativeTree, (IntPtr) (&result)).ThrowOnFailure();
+				return result;
+			}
+		}
+
+		public InstanceBVH() {
+			IntPtr result;
+			NativeMethods.InstanceBVH_Create((IntPtr) (&result)).ThrowOnFailure();
+			nativeTree = result;
+		}
+
+		/// <summary>
+		/// Replaces the whole tree with the first <paramref name="numInstances"/> instances: <c>modelBounds[modelIndices[i]]</c> placed
+		/// with <c>transforms[i]</c>, keyed <c>keys[i]</c>.
+		/// </summary>
+		public void Build(ulong[] keys, FrustumCuller.BoundingSphere[] modelBounds, Transform[] transforms, uint[] modelIndices, uint numInstances) {
+			Assure.NotNull(keys);
+			Assure.NotNull(modelBounds);
+			Assure.NotNull(transforms);
+			Assure.NotNull(modelIndices);
+			Assure.LessThanOrEqualTo(numInstances, keys.Length);
+			Assure.LessThanOrEqualTo(numInstances, transforms.Length);
+			Assure.LessThanOrEqualTo(numInstances, modelIndices.Length);
+
+			fixed (ulong* keysPtr = keys) {
+				fixed (FrustumCuller.BoundingSphere* modelBoundsPtr = modelBounds) {
+					fixed (Transform* transformsPtr = transforms) {
+						fixed (uint* modelIndicesPtr = modelIndices) {
+							NativeMethods.InstanceBVH_Build(
+								nativeTree,
+								(IntPtr) keysPtr,
+								(IntPtr) modelBoundsPtr,
+								(uint) modelBounds.Length,
+								(IntPtr) transformsPtr,
+								(IntPtr) modelIndicesPtr,
+								numInstances
+							).ThrowOnFailure();
+						}
+					}
+				}
+			}
+		}
+
+		public void Insert(ulong key, FrustumCuller.BoundingSphere modelBounds, Transform transform) {
+			NativeMethods.InstanceBVH_Insert(nativeTree, key, (IntPtr) (&modelBounds), (IntPtr) (&transform)).ThrowOnFailure();
+		}
+
+		/// <summary>
+		/// Returns false if the key isn't in this tree.
+		/// </summary>
+		public bool Update(ulong key, FrustumCuller.BoundingSphere modelBounds, Transform transform) {
+			InteropBool result;
+			NativeMethods.InstanceBVH_Update(nativeTree, key, (IntPtr) (&modelBounds), (IntPtr) (&transform), (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Returns false if the key isn't in this tree.
+		/// </summary>
+		public bool Remove(ulong key) {
+			InteropBool result;
+			NativeMethods.InstanceBVH_Remove(nativeTree, key, (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Writes the key of every instance at least partially inside the frustum to <paramref name="outKeys"/> (replacing it with a larger
+		/// array first if it is too small), and returns how many were written.
+		/// </summary>
+		public uint QueryFrustum(FrustumCuller.FrustumPlanes frustum, ref ulong[] outKeys) {
+			uint numKeys;
+			do {
+				fixed (ulong* keysPtr = outKeys) {
+					NativeMethods.InstanceBVH_QueryFrustum(nativeTree, (IntPtr) (&frustum), (IntPtr) keysPtr, (uint) outKeys.Length, (IntPtr) (&numKeys)).ThrowOnFailure();
+				}
+			} while (!EnsureKeyCapacity(numKeys, ref outKeys));
+			return numKeys;
+		}
+
+		/// <summary>
+		/// As <see cref="QueryFrustum"/>, for every instance touching the given sphere.
+		/// </summary>
+		public uint QuerySphere(FrustumCuller.BoundingSphere sphere, ref ulong[] outKeys) {
+			uint numKeys;
+			do {
+				fixed (ulong* keysPtr = outKeys) {
+					NativeMethods.InstanceBVH_QuerySphere(nativeTree, (IntPtr) (&sphere), (IntPtr) keysPtr, (uint) outKeys.Length, (IntPtr) (&numKeys)).ThrowOnFailure();
+				}
+			} while (!EnsureKeyCapacity(numKeys, ref outKeys));
+			return numKeys;
+		}
+
+		/// <summary>
+		/// As <see cref="QueryFrustum"/>, for every instance touched by the given ray.
+		/// </summary>
+		public uint QueryRay(Ray ray, ref ulong[] outKeys) {
+			Vector3 origin = ray.StartPoint;
+			Vector3 direction = ray.Orientation;
+			uint numKeys;
+			do {
+				fixed (ulong* keysPtr = outKeys) {
+					NativeMethods.InstanceBVH_QueryRay(
+						nativeTree,
+						(IntPtr) (&origin),
+						(IntPtr) (&direction),
+						ray.Length,
+						(IntPtr) keysPtr,
+						(uint) outKeys.Length,
+						(IntPtr) (&numKeys)
+					).ThrowOnFailure();
+				}
+			} while (!EnsureKeyCapacity(numKeys, ref outKeys));
+			return numKeys;
+		}
+
+		public void Dispose() {
+			if (isDisposed) return;
+			isDisposed = true;
+			NativeMethods.InstanceBVH_Destroy(nativeTree).ThrowOnFailure();
+		}
+
+		private static bool EnsureKeyCapacity(uint numKeys, ref ulong[] keys) {
+			if (numKeys <= keys.Length) return true;
+			keys = new ulong[numKeys * 2U];
+			return false;
+		}
+	}
+}
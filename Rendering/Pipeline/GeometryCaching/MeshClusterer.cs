@@ -0,0 +1,136 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 01:46 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to the native mesh clusterer (MeshClusterer in RenderingNative): splits large meshes (e.g. level geometry) in to
+	/// small clusters of neighbouring triangles, so that the parts of a mesh that are out of view or facing away from the camera can be
+	/// skipped each frame, rather than drawing the whole mesh whenever any of it is visible. Add the clusters to a cache with
+	/// <see cref="GeometryCacheBuilder{TVertex}.AddModelClusters"/>.
+	/// </summary>
+	public static unsafe class MeshClusterer {
+		/// <summary>
+		/// The most triangles any one cluster holds. Must match MAX_CLUSTER_TRIANGLES in RenderingNative.
+		/// </summary>
+		public const uint MAX_CLUSTER_TRIANGLES = 128U;
+
+		/// <summary>
+		/// A run of neighbouring triangles in a model's index list, with a bounding sphere and a normal cone (in model space) that every
+		/// triangle's front face points in to. Clusters whose triangles face too many ways have a zero cone axis and a cutoff of 1.
+		/// </summary>
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct Cluster {
+			public float CenterX;
+			public float CenterY;
+			public float CenterZ;
+			public float Radius;
+			public float ConeAxisX;
+			public float ConeAxisY;
+			public float ConeAxisZ;
+			/// <summary>
+			/// The sine of the cone's half-angle.
+			/// </summary>
+			public float ConeCutoff;
+			/// <summary>
+			/// The cluster's first index, relative to the start of its model's index list.
+			/// </summary>
+			public uint FirstIndex;
+			public uint NumIndices;
+		}
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		internal struct IndexRange {
+			public uint FirstIndex;
+			public uint NumIndices;
+		}
+
+		/// <summary>
+		/// The number of clusters <see cref="BuildClusters"/> makes for a mesh with the given number of indices.
+		/// </summary>
+		public static uint GetNumClusters(uint numIndices) {
+			return (numIndices / 3U + MAX_CLUSTER_TRIANGLES - 1U) / MAX_CLUSTER_TRIANGLES;
+		}
+
+		/// <summary>
+		/// Splits the mesh made of <paramref name="positions"/> and <paramref name="indices"/> in to clusters, and returns its index list
+		/// reordered so that each cluster's triangles are contiguous (the triangles themselves, and their winding, are unchanged). The
+		/// returned indices should be given to <see cref="GeometryCacheBuilder{TVertex}.AddModel"/> in place of the originals.
+		/// </summary>
+		/// <param name="positions">The position of each of the mesh's vertices. Must not be null.</param>
+		/// <param name="indices">The mesh's triangle list. Must not be null, and its length must be a multiple of three.</param>
+		/// <param name="clusters">Set to the mesh's clusters, in index buffer order.</param>
+		/// <returns>The reordered index list.</returns>
+		[System.Diagnostics.CodeAnalysis.SuppressMessage("Microsoft.Naming", "CA1726:UsePreferredTerms", MessageId = "indices",
+			Justification = "Indices is more in-tune with the graphics-programming side of the world.")]
+		public static uint[] BuildClusters(Vector3[] positions, uint[] indices, out Cluster[] clusters) {
+			if (positions == null) throw new ArgumentNullException("positions");
+			if (indices == null) throw new ArgumentNullException("indices");
+			if (indices.Length % 3 != 0) throw new ArgumentException("Index count must be a multiple of three.", "indices");
+
+			uint[] result = new uint[indices.Length];
+			clusters = new Cluster[GetNumClusters((uint) indices.Length)];
+			if (indices.Length == 0) return result;
+
+			uint numClusters;
+			fixed (Vector3* positionsPtr = positions) {
+				fixed (uint* indicesPtr = indices) {
+					fixed (uint* resultPtr = result) {
+						fixed (Cluster* clustersPtr = clusters) {
+							NativeMethods.MeshClusterer_BuildClusters(
+								(IntPtr) positionsPtr,
+								(uint) positions.Length,
+								(IntPtr) indicesPtr,
+								(uint) indices.Length,
+								MAX_CLUSTER_TRIANGLES,
+								(IntPtr) resultPtr,
+								(IntPtr) clustersPtr,
+								(IntPtr) (&numClusters)
+							).ThrowOnFailure();
+						}
+					}
+				}
+			}
+			Assure.Equal(numClusters, (uint) clusters.Length);
+			return result;
+		}
+
+		/// <summary>
+		/// Culls the <paramref name="numClusters"/> clusters starting at <c>clusters[firstCluster]</c> (all from one model, placed with
+		/// <paramref name="transform"/>) against <paramref name="frustum"/> and, if <paramref name="cullBackFacing"/> is set, drops those
+		/// facing entirely away from <paramref name="viewPosition"/>. Runs of visible clusters are merged, offset by
+		/// <paramref name="firstIndex"/> (the model's first index in the cache's index buffer), and written to
+		/// <paramref name="outRanges"/>, which must have room for <paramref name="numClusters"/>. Returns the number of ranges written.
+		/// </summary>
+		internal static uint CullClusters(FrustumCuller.FrustumPlanes frustum, Vector3 viewPosition, bool cullBackFacing, Cluster[] clusters,
+			uint firstCluster, uint numClusters, Transform transform, uint firstIndex, IndexRange[] outRanges) {
+			Assure.NotNull(clusters);
+			Assure.NotNull(outRanges);
+			Assure.LessThanOrEqualTo(firstCluster + numClusters, clusters.Length);
+			Assure.LessThanOrEqualTo(numClusters, outRanges.Length);
+			if (numClusters == 0U) return 0U;
+
+			uint numRanges;
+			fixed (Cluster* clustersPtr = clusters) {
+				fixed (IndexRange* rangesPtr = outRanges) {
+					NativeMethods.MeshClusterer_CullClusters(
+						(IntPtr) (&frustum),
+						(IntPtr) (&viewPosition),
+						cullBackFacing,
+						(IntPtr) (clustersPtr + firstCluster),
+						numClusters,
+						(IntPtr) (&transform),
+						firstIndex,
+						(IntPtr) rangesPtr,
+						(IntPtr) (&numRanges)
+					).ThrowOnFailure();
+				}
+			}
+			return numRanges;
+		}
+	}
+}
\ No newline at end of file
@@ -14,12 +14,14 @@ namespace Ophidian.Losgap.Rendering {
 		public uint ModelIndex;
 		public uint SceneLayerIndex;
 		public Transform Transform;
+		public byte LODIndex; // The level of detail (relative to the model's first) the geometry pass last drew this instance at
 
 		public ModelInstanceData(uint modelIndex, uint sceneLayerIndex, Transform transform) {
 			InUse = true;
 			ModelIndex = modelIndex;
 			SceneLayerIndex = sceneLayerIndex;
 			Transform = transform;
+			LODIndex = 0;
 		}
 
 		/// <summary>
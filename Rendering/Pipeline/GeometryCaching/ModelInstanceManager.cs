@@ -14,14 +14,30 @@ namespace Ophidian.Losgap.Rendering {
 		private const uint INITIAL_INSTANCE_ALLOCATION = 4U;
 		private const uint MAX_SIZE_BEFORE_LINEAR_GROWTH = INITIAL_INSTANCE_ALLOCATION << 4;
 		private const uint LINEAR_GROWTH_AMOUNT = MAX_SIZE_BEFORE_LINEAR_GROWTH;
+		private const uint INITIAL_QUERY_KEY_CAPACITY = 64U;
 		private readonly object instanceMutationLock = new object();
 		private readonly Dictionary<uint, MIDArray> materialMap = new Dictionary<uint, MIDArray>();
 		private KeyValuePair<Material, MIDArray>[] modelInstanceDataHoldingArray = new KeyValuePair<Material, MIDArray>[0];
 		private bool isDisposed = false;
 		private readonly Func<uint, MIDArray> createNewMIDArrayAct;
+		// Spatial indices over every instance (both null when there are no model bounds). Instances start out in the dynamic tree;
+		// BuildStaticTree() moves everything to the static one, and anything that moves afterwards goes back to the dynamic tree.
+		private readonly FrustumCuller.BoundingSphere[] modelBounds;
+		private readonly InstanceBVH staticTree;
+		private readonly InstanceBVH dynamicTree;
+		private ulong[] queryKeys = new ulong[INITIAL_QUERY_KEY_CAPACITY];
 
-		public ModelInstanceManager() {
+		public ModelInstanceManager() : this(null) { }
+
+		/// <param name="modelBounds">A bounding sphere per model in model space (see <see cref="GeometryCache.ModelBounds"/>), or null
+		/// if instances should not be spatially indexed (in which case FindInstances never finds any).</param>
+		public ModelInstanceManager(FrustumCuller.BoundingSphere[] modelBounds) {
 			createNewMIDArrayAct = CreateNewMIDArray;
+			this.modelBounds = modelBounds;
+			if (modelBounds != null) {
+				staticTree = new InstanceBVH();
+				dynamicTree = new InstanceBVH();
+			}
 		}
 
 		private bool MatMapContainsKey(uint key) {
@@ -79,6 +95,7 @@ namespace Ophidian.Losgap.Rendering {
 				for (uint i = midArray.Length - 1U; i < midArray.Length; --i) {
 					if (!data[i].InUse) {
 						data[i] = new ModelInstanceData(modelIndex, sceneLayerIndex, initialTransform);
+						if (dynamicTree != null) dynamicTree.Insert(GetTreeKey(materialIndex, i), modelBounds[modelIndex], initialTransform);
 						return new ModelInstanceHandle(this, materialIndex, i);
 					}
 				}
@@ -94,6 +111,7 @@ namespace Ophidian.Losgap.Rendering {
 				UnsafeUtils.ZeroMem(((IntPtr) newData) + (int) oldNumBytes, numBytes - oldNumBytes);
 				materialMap[materialIndex] = new MIDArray(newData, newSize);
 				newData[midArray.Length] = new ModelInstanceData(modelIndex, sceneLayerIndex, initialTransform);
+				if (dynamicTree != null) dynamicTree.Insert(GetTreeKey(materialIndex, midArray.Length), modelBounds[modelIndex], initialTransform);
 				return new ModelInstanceHandle(this, materialIndex, midArray.Length);
 			}
 		}
@@ -104,6 +122,10 @@ namespace Ophidian.Losgap.Rendering {
 				Assure.True(MatMapContainsKey(materialIndex), "Invalid material index.");
 				Assure.True(materialMap.GetNoBoxing(materialIndex).Length > instanceIndex, "Invalid instance index.");
 				materialMap.GetNoBoxing(materialIndex).Data[instanceIndex].InUse = false;
+				if (staticTree != null) {
+					ulong treeKey = GetTreeKey(materialIndex, instanceIndex);
+					if (!staticTree.Remove(treeKey)) dynamicTree.Remove(treeKey);
+				}
 			}
 		}
 
@@ -136,7 +158,108 @@ namespace Ophidian.Losgap.Rendering {
 			using (RenderingModule.RenderStateBarrier.AcquirePermit(withLock: instanceMutationLock)) {
 				Assure.True(MatMapContainsKey(materialIndex), "Invalid material index.");
 				Assure.True(materialMap.GetNoBoxing(materialIndex).Length > instanceIndex, "Invalid instance index.");
-				materialMap.GetNoBoxing(materialIndex).Data[instanceIndex].Transform = transform;
+				ModelInstanceData* data = materialMap.GetNoBoxing(materialIndex).Data + instanceIndex;
+				data->Transform = transform;
+				if (dynamicTree != null) {
+					ulong treeKey = GetTreeKey(materialIndex, instanceIndex);
+					FrustumCuller.BoundingSphere bounds = modelBounds[data->ModelIndex];
+					if (!dynamicTree.Update(treeKey, bounds, transform)) {
+						// Static instances that move are dynamic from then on
+						staticTree.Remove(treeKey);
+						dynamicTree.Insert(treeKey, bounds, transform);
+					}
+				}
+			}
+		}
+
+		/// <summary>
+		/// Rebuilds the static spatial index from every current instance, and empties the dynamic one. Intended to be called once the
+		/// static part of a scene (e.g. a level) has been loaded: instances are queried faster from a tree built all at once.
+		/// </summary>
+		public void BuildStaticTree() {
+			lock (instanceMutationLock) {
+				if (isDisposed || staticTree == null) return;
+				uint numInstances = 0U;
+				foreach (KeyValuePair<uint, MIDArray> kvp in materialMap) {
+					for (uint i = 0U; i < kvp.Value.Length; ++i) {
+						if (kvp.Value.Data[i].InUse) ++numInstances;
+					}
+				}
+
+				ulong[] keys = new ulong[numInstances];
+				Transform[] transforms = new Transform[numInstances];
+				uint[] modelIndices = new uint[numInstances];
+				uint instanceIndex = 0U;
+				foreach (KeyValuePair<uint, MIDArray> kvp in materialMap) {
+					for (uint i = 0U; i < kvp.Value.Length; ++i) {
+						ModelInstanceData* data = kvp.Value.Data + i;
+						if (!data->InUse) continue;
+						keys[instanceIndex] = GetTreeKey(kvp.Key, i);
+						transforms[instanceIndex] = data->Transform;
+						modelIndices[instanceIndex] = data->ModelIndex;
+						++instanceIndex;
+					}
+				}
+
+				staticTree.Build(keys, modelBounds, transforms, modelIndices, numInstances);
+				dynamicTree.Build(keys, modelBounds, transforms, modelIndices, 0U);
+			}
+		}
+
+		/// <summary>
+		/// Writes the key of every instance at least partially inside the given frustum (its material index in the top 32 bits and its
+		/// instance index in the bottom 32) to <paramref name="outKeys"/> in ascending order, replacing the array with a larger one first
+		/// if it is too small. Each material's instances are therefore contiguous and in instance order (see
+		/// <see cref="GetMaterialKeyRange"/>). Returns how many were written, or null if instances are not spatially indexed.
+		/// </summary>
+		public uint? FindInstanceKeys(FrustumCuller.FrustumPlanes frustum, ref ulong[] outKeys) {
+			Assure.NotNull(outKeys);
+			lock (instanceMutationLock) {
+				if (isDisposed || staticTree == null) return null;
+				uint numStaticKeys = staticTree.QueryFrustum(frustum, ref outKeys);
+				uint numDynamicKeys = dynamicTree.QueryFrustum(frustum, ref queryKeys);
+				uint numKeys = numStaticKeys + numDynamicKeys;
+				if (outKeys.Length < numKeys) Array.Resize(ref outKeys, (int) (numKeys << 1));
+				Array.Copy(queryKeys, 0L, outKeys, numStaticKeys, numDynamicKeys);
+				Array.Sort(outKeys, 0, (int) numKeys);
+				return numKeys;
+			}
+		}
+
+		/// <summary>
+		/// Finds the keys belonging to the given material in the first <paramref name="numKeys"/> of <paramref name="keys"/>, which must be
+		/// sorted as <see cref="FindInstanceKeys"/> leaves them: they are the ones from <paramref name="start"/> up to (but not including)
+		/// <paramref name="end"/>, and the instance index of each is its bottom 32 bits.
+		/// </summary>
+		public static void GetMaterialKeyRange(ulong[] keys, uint numKeys, uint materialIndex, out uint start, out uint end) {
+			Assure.NotNull(keys);
+			Assure.LessThanOrEqualTo(numKeys, keys.Length);
+			start = LowerBound(keys, numKeys, GetTreeKey(materialIndex, 0U));
+			end = materialIndex == UInt32.MaxValue ? numKeys : LowerBound(keys, numKeys, GetTreeKey(materialIndex + 1U, 0U));
+		}
+
+		/// <summary>
+		/// Adds every instance whose bounding sphere touches the given <paramref name="sphere"/> to <paramref name="outInstances"/>.
+		/// </summary>
+		public void FindInstances(Sphere sphere, List<ModelInstanceHandle> outInstances) {
+			Assure.NotNull(outInstances);
+			FrustumCuller.BoundingSphere querySphere = new FrustumCuller.BoundingSphere(sphere.Center, sphere.Radius);
+			lock (instanceMutationLock) {
+				if (isDisposed || staticTree == null) return;
+				AddFoundInstances(staticTree.QuerySphere(querySphere, ref queryKeys), outInstances);
+				AddFoundInstances(dynamicTree.QuerySphere(querySphere, ref queryKeys), outInstances);
+			}
+		}
+
+		/// <summary>
+		/// Adds every instance whose bounding sphere is touched by the given <paramref name="ray"/> to <paramref name="outInstances"/>.
+		/// </summary>
+		public void FindInstances(Ray ray, List<ModelInstanceHandle> outInstances) {
+			Assure.NotNull(outInstances);
+			lock (instanceMutationLock) {
+				if (isDisposed || staticTree == null) return;
+				AddFoundInstances(staticTree.QueryRay(ray, ref queryKeys), outInstances);
+				AddFoundInstances(dynamicTree.QueryRay(ray, ref queryKeys), outInstances);
 			}
 		}
 
@@ -148,6 +271,11 @@ namespace Ophidian.Losgap.Rendering {
 
 				materialMap.Clear();
 
+				if (staticTree != null) {
+					staticTree.Dispose();
+					dynamicTree.Dispose();
+				}
+
 				isDisposed = true;
 			}
 		}
@@ -162,6 +290,26 @@ namespace Ophidian.Losgap.Rendering {
 			return "MIM-" + GetHashCode().ToString("X");
 		}
 
+		private static ulong GetTreeKey(uint materialIndex, uint instanceIndex) {
+			return ((ulong) materialIndex << 32) | instanceIndex;
+		}
+
+		private static uint LowerBound(ulong[] sortedKeys, uint numKeys, ulong key) {
+			uint low = 0U, high = numKeys;
+			while (low < high) {
+				uint mid = low + ((high - low) >> 1);
+				if (sortedKeys[mid] < key) low = mid + 1U;
+				else high = mid;
+			}
+			return low;
+		}
+
+		private void AddFoundInstances(uint numKeys, List<ModelInstanceHandle> outInstances) {
+			for (uint i = 0U; i < numKeys; ++i) {
+				outInstances.Add(new ModelInstanceHandle(this, (uint) (queryKeys[i] >> 32), (uint) queryKeys[i]));
+			}
+		}
+
 		private MIDArray CreateNewMIDArray(uint materialIndex) {
 			uint numBytes = (uint) sizeof(ModelInstanceData) * INITIAL_INSTANCE_ALLOCATION;
 			ModelInstanceData* data = (ModelInstanceData*) Marshal.AllocHGlobal(new IntPtr(numBytes));
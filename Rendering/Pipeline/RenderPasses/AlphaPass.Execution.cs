@@ -21,7 +21,25 @@ namespace Ophidian.Losgap.Rendering {
 
 		private static byte frameNum;
 		[ThreadStatic]
-		private static FastClearList<Transform>[] materialFilteringWorkspace;
+		private static DrawSorter.DrawRecord[] drawRecordWorkspace;
+		[ThreadStatic]
+		private static Transform[] drawTransformWorkspace;
+		[ThreadStatic]
+		private static uint[] drawOrderWorkspace;
+		[ThreadStatic]
+		private static RenderCommand[] drawCommandWorkspace;
+		[ThreadStatic]
+		private static RenderCommand[] shaderCommandWorkspace;
+		[ThreadStatic]
+		private static uint[] shaderCommandOffsetWorkspace;
+		[ThreadStatic]
+		private static RenderCommand[] materialCommandWorkspace;
+		[ThreadStatic]
+		private static uint[] materialCommandOffsetWorkspace;
+		[ThreadStatic]
+		private static DrawSorter.ModelBufferRange[] modelRangeWorkspace;
+		[ThreadStatic]
+		private static GeometryCache modelRangeWorkspaceCache;
 		[ThreadStatic]
 		private static Matrix[] instanceConcatWorkspace;
 		[ThreadStatic]
@@ -37,7 +55,7 @@ namespace Ophidian.Losgap.Rendering {
 
 		private readonly Action setUpCacheForLocalThreadAct;
 		private readonly Action<int> renderCacheIterateMatAct;
-		private readonly Action setInstanceBufferAndFlushCommandsAct;
+		private readonly Action setInstanceBufferAct;
 
 		/// <summary>
 		/// Disposes managed resources and invalides the render pass permanently.
@@ -105,9 +123,10 @@ namespace Ophidian.Losgap.Rendering {
 				}
 				gpuInstanceBuffer.DiscardWrite(cpuInstanceBuffer); // Happens immediately (required)
 
-				// Set instance buffer and flush all commands, first on immediate context, then on each deferred
+				// Set instance buffer and flush all commands, first on immediate context, then on all deferred contexts at once
 				SetInstanceBufferAndFlushCommands();
-				pp.InvokeOnAll(setInstanceBufferAndFlushCommandsAct, false);
+				pp.InvokeOnAll(setInstanceBufferAct, false);
+				FlushDeferredRenderCommands(pp);
 			}
 
 			// Present
@@ -154,21 +173,28 @@ namespace Ophidian.Losgap.Rendering {
 			// Skip this material if it or its shader are disposed
 			if (currentMaterial.IsDisposed || currentMaterial.Shader.IsDisposed) return;
 
-			// Prepare shader according to material params, and switch to it or update it
-			if (lastSetFragmentShader != currentMaterial.Shader || lastFrameNum != frameNum) {
-				lastSetFragmentShader = currentMaterial.Shader;
-				lastFrameNum = frameNum;
-				QueueShaderSwitch(lastSetFragmentShader);
+			// Prepare shader according to material params, and record the switch to it (if this thread isn't already using it) and its
+			// update as this material's state: the sorter writes them ahead of the first draw, so nothing is queued if nothing is drawn
+			FragmentShader materialShader = currentMaterial.Shader;
+			bool switchesShader = lastSetFragmentShader != materialShader || lastFrameNum != frameNum;
+			if (shaderCommandOffsetWorkspace == null) {
+				shaderCommandOffsetWorkspace = new uint[2];
+				materialCommandOffsetWorkspace = new uint[2];
 			}
-			QueueShaderResourceUpdate(lastSetFragmentShader, currentMaterial.FragmentShaderResourcePackage);
-
+			if (switchesShader) shaderCommandOffsetWorkspace[1] = RecordShaderSwitch(materialShader, ref shaderCommandWorkspace, 0U);
+			materialCommandOffsetWorkspace[1] = RecordShaderResourceUpdate(
+				materialShader,
+				currentMaterial.FragmentShaderResourcePackage,
+				ref materialCommandWorkspace,
+				0U
+			);
 
-			// Filter & sort
-			if (materialFilteringWorkspace == null || materialFilteringWorkspace.Length < currentCache.NumModels) {
-				materialFilteringWorkspace = new FastClearList<Transform>[currentCache.NumModels];
-				for (int i = 0; i < materialFilteringWorkspace.Length; ++i) materialFilteringWorkspace[i] = new FastClearList<Transform>();
+			// Filter
+			if (drawRecordWorkspace == null || drawRecordWorkspace.Length < currentMID.Length) {
+				drawRecordWorkspace = new DrawSorter.DrawRecord[currentMID.Length << 1];
+				drawTransformWorkspace = new Transform[currentMID.Length << 1];
+				drawOrderWorkspace = new uint[currentMID.Length << 1];
 			}
-			for (int i = 0; i < materialFilteringWorkspace.Length; ++i) materialFilteringWorkspace[i].Clear();
 
 			ModelInstanceData* midData = currentMID.Data;
 			uint numInstances = 0U;
@@ -178,37 +204,56 @@ namespace Ophidian.Losgap.Rendering {
 				SceneLayer layer = currentSceneLayers[curMID.SceneLayerIndex];
 				if (layer == null || !layer.GetRenderingEnabled() || !addedSceneLayers.Contains(layer)) continue;
 
-				materialFilteringWorkspace[curMID.ModelIndex].Add(curMID.Transform);
+				drawTransformWorkspace[numInstances] = curMID.Transform;
+				drawRecordWorkspace[numInstances] = new DrawSorter.DrawRecord {
+					Model = curMID.ModelIndex,
+					NumInstances = 1U
+				};
 				++numInstances;
 			}
+			if (numInstances == 0U) return;
 
-			// Concatenate & queue render commands
-			if (instanceConcatWorkspace == null || instanceConcatWorkspace.Length < numInstances) {
-				instanceConcatWorkspace = new Matrix[numInstances << 1]; // x2 so we don't create loads of garbage if the count keeps increasing by 1
+			// Sort strictly back-to-front from the camera so that blending composes correctly, and turn that in to state and draw commands
+			// (only consecutive instances of the same model can be merged in to one draw)
+			DrawSorter.SetDepths(drawTransformWorkspace, drawRecordWorkspace, numInstances, Input.Position);
+			DrawSorter.Sort(DrawSorter.AlphaBackToFront, drawRecordWorkspace, numInstances, drawOrderWorkspace);
+
+			if (modelRangeWorkspaceCache != currentCache) {
+				DrawSorter.GetModelBufferRanges(currentCache, ref modelRangeWorkspace);
+				modelRangeWorkspaceCache = currentCache;
+			}
+
+			uint numStateCommands = (switchesShader ? shaderCommandOffsetWorkspace[1] : 0U) + materialCommandOffsetWorkspace[1];
+			if (drawCommandWorkspace == null || drawCommandWorkspace.Length < numStateCommands + numInstances) {
+				drawCommandWorkspace = new RenderCommand[(numStateCommands + numInstances) << 1];
 			}
 
 			uint instanceStartOffset = RenderCache_IterateMaterial_ConcatReserve(numInstances);
-			uint nextWorkspaceIndex = 0;
-			uint outVBStartIndex, outIBStartIndex, outVBCount, outIBCount;
-
-			for (uint mI = 0U; mI < materialFilteringWorkspace.Length; ++mI) {
-				FastClearList<Transform> filteredTransformList = materialFilteringWorkspace[mI];
-				int numFilteredTransforms = filteredTransformList.Count;
-				if (numFilteredTransforms == 0) continue;
-
-				currentCache.GetModelBufferValues(mI, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
-
-				QueueRenderCommand(RenderCommand.DrawIndexedInstanced(
-					(int) outVBStartIndex,
-					outIBStartIndex,
-					outIBCount,
-					nextWorkspaceIndex + instanceStartOffset,
-					(uint) numFilteredTransforms
-				));
-
-				for (int iI = 0; iI < numFilteredTransforms; ++iI) {
-					instanceConcatWorkspace[nextWorkspaceIndex++] = filteredTransformList[iI].AsMatrixTransposed;
-				}
+			uint numDrawCommands = DrawSorter.EmitCommands(
+				drawRecordWorkspace,
+				drawOrderWorkspace,
+				numInstances,
+				modelRangeWorkspace,
+				switchesShader ? shaderCommandWorkspace : null,
+				switchesShader ? shaderCommandOffsetWorkspace : null,
+				materialCommandWorkspace,
+				materialCommandOffsetWorkspace,
+				true,
+				instanceStartOffset,
+				drawCommandWorkspace
+			);
+			for (uint i = 0U; i < numDrawCommands; ++i) QueueRenderCommand(drawCommandWorkspace[i]);
+			if (switchesShader) {
+				lastSetFragmentShader = materialShader;
+				lastFrameNum = frameNum;
+			}
+
+			// Concatenate instance data in draw order
+			if (instanceConcatWorkspace == null || instanceConcatWorkspace.Length < numInstances) {
+				instanceConcatWorkspace = new Matrix[numInstances << 1]; // x2 so we don't create loads of garbage if the count keeps increasing by 1
+			}
+			fixed (Matrix* instanceConcatWorkspacePtr = instanceConcatWorkspace) {
+				InstanceMatrixWriter.WriteTransposedMatrices(drawTransformWorkspace, drawOrderWorkspace, numInstances, instanceConcatWorkspacePtr);
 			}
 
 			RenderCache_IterateMaterial_Concat(instanceConcatWorkspace, instanceStartOffset, numInstances);
@@ -234,11 +279,15 @@ namespace Ophidian.Losgap.Rendering {
 			}
 		}
 
-		private void SetInstanceBufferAndFlushCommands() {
+		private void SetInstanceBuffer() {
 			QueueRenderCommand(
 				reservedSetIBCommandSlot,
 				RenderCommand.SetInstanceBuffer(gpuInstanceBuffer, vertexShader.InstanceDataBinding.SlotIndex)
 			);
+		}
+
+		private void SetInstanceBufferAndFlushCommands() {
+			SetInstanceBuffer();
 			FlushRenderCommands();
 		}
 	}
@@ -173,7 +173,7 @@ namespace Ophidian.Losgap.Rendering {
 		public AlphaPass(string name) : base(name) {
 			setUpCacheForLocalThreadAct = SetUpCacheForLocalThread;
 			renderCacheIterateMatAct = RenderCache_IterateMaterial;
-			setInstanceBufferAndFlushCommandsAct = SetInstanceBufferAndFlushCommands;
+			setInstanceBufferAct = SetInstanceBuffer;
 		}
 
 		/// <summary>
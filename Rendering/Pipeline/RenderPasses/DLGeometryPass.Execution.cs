@@ -12,12 +12,8 @@ using Ophidian.Losgap.Interop;
 
 namespace Ophidian.Losgap.Rendering {
 	public unsafe partial class DLGeometryPass {
-		[ThreadStatic]
-		private static ModelInstanceData[] sortedModelData;
-		[ThreadStatic]
-		private static MIDComparer localMidComparer;
-
 		private const int INITIAL_TRANSFORM_BUF_LEN = 1;
+		private const int INITIAL_VISIBLE_KEY_BUF_LEN = 64;
 		private static readonly Texture2DBuilder<TexelFormat.RGBA32Float> gBufferBuilder =
 			TextureFactory.NewTexture2D<TexelFormat.RGBA32Float>()
 			.WithPermittedBindings(GPUBindings.ReadableShaderResource | GPUBindings.RenderTarget)
@@ -27,6 +23,13 @@ namespace Ophidian.Losgap.Rendering {
 
 		private GeometryCache currentCache;
 		private VertexShader currentVS;
+		private FrustumCuller.FrustumPlanes currentFrustum;
+		private ulong[] visibleInstanceKeys = new ulong[INITIAL_VISIBLE_KEY_BUF_LEN];
+		private uint numVisibleInstanceKeys;
+		private bool currentInstancesAreIndexed;
+		private OcclusionBuffer currentOcclusionBuffer;
+		private float currentProjectionScale;
+		private bool currentProjectionIsPerspective;
 		private ArraySlice<KeyValuePair<Material, ModelInstanceManager.MIDArray>> currentInstanceData;
 		private SceneLayer[] currentSceneLayers = new SceneLayer[0];
 		private ShaderResourceView previousShadowBufferSRV;
@@ -58,9 +61,33 @@ namespace Ophidian.Losgap.Rendering {
 
 		private static byte frameNum;
 		[ThreadStatic]
-		private static FastClearList<Transform>[] materialFilteringWorkspace;
+		private static DrawSorter.DrawRecord[] drawRecordWorkspace;
+		[ThreadStatic]
+		private static Transform[] drawTransformWorkspace;
+		[ThreadStatic]
+		private static uint[] drawOrderWorkspace;
+		[ThreadStatic]
+		private static uint[] drawModelWorkspace;
+		[ThreadStatic]
+		private static uint[] drawSlotWorkspace;
+		[ThreadStatic]
+		private static byte[] drawLODWorkspace;
+		[ThreadStatic]
+		private static RenderCommand[] drawCommandWorkspace;
 		[ThreadStatic]
-		private static Matrix[] instanceConcatWorkspace;
+		private static RenderCommand[] shaderCommandWorkspace;
+		[ThreadStatic]
+		private static uint[] shaderCommandOffsetWorkspace;
+		[ThreadStatic]
+		private static RenderCommand[] materialCommandWorkspace;
+		[ThreadStatic]
+		private static uint[] materialCommandOffsetWorkspace;
+		[ThreadStatic]
+		private static MeshClusterer.IndexRange[] clusterRangeWorkspace;
+		[ThreadStatic]
+		private static DrawSorter.ModelBufferRange[] modelRangeWorkspace;
+		[ThreadStatic]
+		private static GeometryCache modelRangeWorkspaceCache;
 		[ThreadStatic]
 		private static FragmentShader lastSetFragmentShader;
 		[ThreadStatic]
@@ -68,14 +95,15 @@ namespace Ophidian.Losgap.Rendering {
 		[ThreadStatic]
 		private static uint reservedSetIBCommandSlot;
 		private Matrix[] cpuInstanceBuffer = new Matrix[INITIAL_TRANSFORM_BUF_LEN];
+		private Matrix* currentCPUInstanceBufferPtr;
 		private VertexBuffer<Matrix> gpuInstanceBuffer;
-		private uint cpuInstanceBufferCurIndex;
+		private int cpuInstanceBufferCurIndex;
 		private FragmentShader geomFSWithShadowSupport;
 		private ShaderResourcePackage geomFSShadowUnbindPackage;
 
 		private readonly Action setUpCacheForLocalThreadAct;
 		private readonly Action<int> renderCacheIterateMatAct;
-		private readonly Action setInstanceBufferAndFlushCommandsAct;
+		private readonly Action setInstanceBufferAct;
 
 		public FragmentShader GeomFSWithShadowSupport {
 			set {
@@ -146,14 +174,25 @@ namespace Ophidian.Losgap.Rendering {
 			// Clear main DSV
 			QueueRenderCommand(RenderCommand.ClearDepthStencil(primaryDSBufferDSV));
 
+			// Draw the occluders once for the whole frame (every cache is seen from the same camera)
+			currentOcclusionBuffer = occlusionBuffer != null && !occlusionBuffer.IsDisposed ? occlusionBuffer : null;
+			if (currentOcclusionBuffer != null) {
+				currentOcclusionBuffer.Rasterize(*((Matrix*) Input.GetRecalculatedViewMatrix()) * *((Matrix*) Output.GetRecalculatedProjectionMatrix(Input)));
+			}
+
 			List<GeometryCache> activeCaches = GeometryCache.ActiveCaches;
 			foreach (GeometryCache c in activeCaches) {
 				if (!deferredGeometryVertexShaders.ContainsKey(c)) continue;
 				currentVS = deferredGeometryVertexShaders[c];
 
 				// Set view/proj matrices
+				Matrix mainCameraProjMat = *((Matrix*) Output.GetRecalculatedProjectionMatrix(Input));
+				Matrix mainCameraVPMat = *((Matrix*) Input.GetRecalculatedViewMatrix()) * mainCameraProjMat;
+				currentProjectionScale = mainCameraProjMat.RowB.Y;
+				currentProjectionIsPerspective = Input.OrthographicDimensions == null;
+				currentFrustum = FrustumCuller.CreateFrustum(mainCameraVPMat);
 				var vpMatrices = new GeomPassProjViewMatrices {
-					MainCameraVPMat = (*((Matrix*)Input.GetRecalculatedViewMatrix()) * *((Matrix*)Output.GetRecalculatedProjectionMatrix(Input))).Transpose,
+					MainCameraVPMat = mainCameraVPMat.Transpose,
 					ShadowCameraVPMat = (*((Matrix*)shadowPass.LightCam.GetRecalculatedViewMatrix()) * *((Matrix*)Output.GetRecalculatedProjectionMatrix(shadowPass.LightCam))).Transpose
 				};
 				byte* vpMatPtr = (byte*) &vpMatrices;
@@ -178,26 +217,45 @@ namespace Ophidian.Losgap.Rendering {
 				Thread.MemoryBarrier();
 				currentInstanceData = currentCache.GetModelInstanceData();
 
+				// Find the instances in view once for the whole cache, from its spatial index, so that each material only visits its own
+				uint? numVisibleKeys = currentCache.FindInstanceKeys(currentFrustum, ref visibleInstanceKeys);
+				currentInstancesAreIndexed = numVisibleKeys.HasValue;
+				numVisibleInstanceKeys = numVisibleKeys.GetValueOrDefault();
+
 				// Set up each thread
 				pp.InvokeOnAll(setUpCacheForLocalThreadAct, true); // membar here
 
+				// Make room for every instance up front, so that each material can write its matrices straight in to place without locking
+				uint maxInstances = 0U;
+				for (int i = 0; i < currentInstanceData.Length; ++i) maxInstances += currentInstanceData[i].Value.Length;
+				if (cpuInstanceBuffer.Length < maxInstances) {
+					cpuInstanceBuffer = new Matrix[maxInstances << 1]; // x2 to avoid excessive garbage when the limit keeps increasing by small amounts
+				}
+
 				// Iterate all model instances (ordered by material)
-				pp.Execute((int) currentInstanceData.Length, (int) (currentInstanceData.Length / (pp.NumThreads << 3)) + 1, renderCacheIterateMatAct);
+				fixed (Matrix* cpuInstanceBufferPtr = cpuInstanceBuffer) {
+					currentCPUInstanceBufferPtr = cpuInstanceBufferPtr;
+					pp.Execute((int) currentInstanceData.Length, (int) (currentInstanceData.Length / (pp.NumThreads << 3)) + 1, renderCacheIterateMatAct);
+					currentCPUInstanceBufferPtr = null;
+				}
 
 				// Set instance buffer and write to it
 				if (gpuInstanceBuffer == null || gpuInstanceBuffer.Length < cpuInstanceBuffer.Length) {
 					if (gpuInstanceBuffer != null) gpuInstanceBuffer.Dispose();
 					gpuInstanceBuffer = gpuInstanceBufferBuilder.WithLength((uint) cpuInstanceBuffer.Length).Create();
 				}
-				gpuInstanceBuffer.DiscardWrite(cpuInstanceBuffer); // Happens immediately (required)
+				if (cpuInstanceBufferCurIndex > 0) { // Only the written part; happens immediately (required)
+					gpuInstanceBuffer.DiscardWrite(new ArraySlice<Matrix>(cpuInstanceBuffer, 0U, (uint) cpuInstanceBufferCurIndex));
+				}
 
 				// Unbind shadow buffer
 				QueueShaderSwitch(geomFSWithShadowSupport);
 				QueueShaderResourceUpdate(geomFSWithShadowSupport, geomFSShadowUnbindPackage);
 
-				// Set instance buffer and flush all commands, first on immediate context, then on each deferred
+				// Set instance buffer and flush all commands, first on immediate context, then on all deferred contexts at once
 				SetInstanceBufferAndFlushCommands();
-				pp.InvokeOnAll(setInstanceBufferAndFlushCommandsAct, false);
+				pp.InvokeOnAll(setInstanceBufferAct, false);
+				FlushDeferredRenderCommands(pp);
 			}
 		}
 
@@ -243,146 +301,271 @@ namespace Ophidian.Losgap.Rendering {
 			// Skip this material if it or its shader are disposed
 			if (currentMaterial.IsDisposed || currentMaterial.Shader.IsDisposed) return;
 
-			// Skip this material if we're not using it
-			bool inUse = false;
-			for (int i = 0; i < currentMID.Length; ++i) {
-				if (currentMID.Data[i].InUse) {
-					inUse = true;
-					break;
+			// Skip this material if we're not using it (or, when the cache's instances are indexed, if none of its instances are in view)
+			uint firstVisibleKey = 0U, endVisibleKey = 0U;
+			if (currentInstancesAreIndexed) {
+				ModelInstanceManager.GetMaterialKeyRange(visibleInstanceKeys, numVisibleInstanceKeys, currentMaterial.Index, out firstVisibleKey, out endVisibleKey);
+				if (firstVisibleKey == endVisibleKey) return;
+			}
+			else {
+				bool inUse = false;
+				for (int i = 0; i < currentMID.Length; ++i) {
+					if (currentMID.Data[i].InUse) {
+						inUse = true;
+						break;
+					}
 				}
+				if (!inUse) return;
 			}
-			if (!inUse) return;
 
-			// Prepare shader according to material params, and switch to it or update it
-			if (lastSetFragmentShader != currentMaterial.Shader || lastFrameNum != frameNum) {
-				lastSetFragmentShader = currentMaterial.Shader;
-				lastFrameNum = frameNum;
-				QueueShaderSwitch(lastSetFragmentShader);
+			// Prepare shader according to material params, and record the switch to it (if this thread isn't already using it) and its
+			// update as this material's state: the sorter writes them ahead of the first draw, so nothing is queued if every instance is culled
+			FragmentShader materialShader = currentMaterial.Shader;
+			bool switchesShader = lastSetFragmentShader != materialShader || lastFrameNum != frameNum;
+			if (shaderCommandOffsetWorkspace == null) {
+				shaderCommandOffsetWorkspace = new uint[2];
+				materialCommandOffsetWorkspace = new uint[2];
 			}
+			if (switchesShader) shaderCommandOffsetWorkspace[1] = RecordShaderSwitch(materialShader, ref shaderCommandWorkspace, 0U);
 			var queuedSRP = currentMaterial.FragmentShaderResourcePackage;
-			if (lastSetFragmentShader == geomFSWithShadowSupport) {
+			if (materialShader == geomFSWithShadowSupport) {
 				if (modifiedSRP == null) modifiedSRP = new ShaderResourcePackage();
 				modifiedSRP.CopyFrom(queuedSRP);
-				modifiedSRP.SetValue((ResourceViewBinding) lastSetFragmentShader.GetBindingByIdentifier("ShadowMap"), previousShadowBufferSRV);
+				modifiedSRP.SetValue((ResourceViewBinding) materialShader.GetBindingByIdentifier("ShadowMap"), previousShadowBufferSRV);
 				queuedSRP = modifiedSRP;
 			}
-			QueueShaderResourceUpdate(lastSetFragmentShader, queuedSRP);
-
-			// Filter & sort
-			if (materialFilteringWorkspace == null || materialFilteringWorkspace.Length < currentCache.NumModels) {
-				materialFilteringWorkspace = new FastClearList<Transform>[currentCache.NumModels];
-				for (int i = 0; i < materialFilteringWorkspace.Length; ++i) materialFilteringWorkspace[i] = new FastClearList<Transform>();
+			materialCommandOffsetWorkspace[1] = RecordShaderResourceUpdate(materialShader, queuedSRP, ref materialCommandWorkspace, 0U);
+
+			// Filter
+			if (drawRecordWorkspace == null || drawRecordWorkspace.Length < currentMID.Length) {
+				drawRecordWorkspace = new DrawSorter.DrawRecord[currentMID.Length << 1];
+				drawTransformWorkspace = new Transform[currentMID.Length << 1];
+				drawOrderWorkspace = new uint[currentMID.Length << 1];
+				drawModelWorkspace = new uint[currentMID.Length << 1];
+				drawSlotWorkspace = new uint[currentMID.Length << 1];
+				drawLODWorkspace = new byte[currentMID.Length << 1];
 			}
-			for (int i = 0; i < materialFilteringWorkspace.Length; ++i) materialFilteringWorkspace[i].Clear();
 
-			SortByProximityToCamera(currentMID);
 			uint numInstances = 0U;
-			for (uint i = 0U; i < currentMID.Length; ++i) {
-				ModelInstanceData curMID = sortedModelData[i];
+			uint numCandidates = currentInstancesAreIndexed ? endVisibleKey - firstVisibleKey : currentMID.Length;
+			for (uint c = 0U; c < numCandidates; ++c) {
+				uint i = currentInstancesAreIndexed ? (uint) visibleInstanceKeys[firstVisibleKey + c] : c;
+				ModelInstanceData curMID = currentMID.Data[i];
 				if (!curMID.InUse) continue;
 				SceneLayer layer = currentSceneLayers[curMID.SceneLayerIndex];
 				if (layer == null || !layer.GetRenderingEnabled() || !addedSceneLayers.Contains(layer)) continue;
 
+				Transform transform = curMID.Transform;
 				if (curMID.ModelIndex == __VEGG_MH.ModelIndex && currentCache.ID == __VEGG_MH.GeoCacheID) {
-					int instanceIndex = 0;
-					for (int j = 0; j < currentMID.Length; ++j) {
-						if (currentMID.Data[j].Transform == curMID.Transform) {
-							instanceIndex = j;
-							break;
-						}
-					}
 					Quaternion rot = Quaternion.IDENTITY;
 					foreach (var kvp in __VEGG_MIH_ARR) {
-						if (kvp.Key.InstanceIndex == instanceIndex) {
+						if (kvp.Key.InstanceIndex == i) {
 							rot = kvp.Value;
 							break;
 						}
 					}
-					materialFilteringWorkspace[curMID.ModelIndex].Add(curMID.Transform.RotateBy(rot));
+					transform = transform.RotateBy(rot);
+				}
+				if (curMID.ModelIndex == __EGGHACK_MH.ModelIndex && currentCache.ID == __EGGHACK_MH.GeoCacheID) {
+					transform = transform.RotateBy(__EGGHACK_ROT);
 				}
-				else materialFilteringWorkspace[curMID.ModelIndex].Add(curMID.Transform);
+
+				drawTransformWorkspace[numInstances] = transform;
+				drawModelWorkspace[numInstances] = curMID.ModelIndex;
+				drawSlotWorkspace[numInstances] = i;
+				drawLODWorkspace[numInstances] = curMID.LODIndex;
+				drawRecordWorkspace[numInstances] = new DrawSorter.DrawRecord {
+					Model = curMID.ModelIndex,
+					NumInstances = 1U
+				};
 				++numInstances;
 			}
 
-			// Concatenate & queue render commands
-			if (instanceConcatWorkspace == null || instanceConcatWorkspace.Length < numInstances) {
-				instanceConcatWorkspace = new Matrix[numInstances << 1]; // x2 so we don't create loads of garbage if the count keeps increasing by 1
+			// Cull those hidden behind the occluders (the order workspace is free until the sort below), keeping the survivors in order
+			if (currentOcclusionBuffer != null && currentCache.ModelBounds != null) {
+				uint numUnoccluded = currentOcclusionBuffer.CullInstances(
+					currentCache.ModelBounds,
+					drawTransformWorkspace,
+					drawModelWorkspace,
+					numInstances,
+					drawOrderWorkspace
+				);
+				for (uint i = 0U; i < numUnoccluded; ++i) {
+					uint unoccludedIndex = drawOrderWorkspace[i];
+					drawTransformWorkspace[i] = drawTransformWorkspace[unoccludedIndex];
+					drawModelWorkspace[i] = drawModelWorkspace[unoccludedIndex];
+					drawSlotWorkspace[i] = drawSlotWorkspace[unoccludedIndex];
+					drawLODWorkspace[i] = drawLODWorkspace[unoccludedIndex];
+					drawRecordWorkspace[i] = drawRecordWorkspace[unoccludedIndex];
+				}
+				numInstances = numUnoccluded;
+			}
+			if (numInstances == 0U) return;
+
+			// Pick each visible instance's level of detail, and draw it with that level's buffer range instead of the whole model's (so
+			// the sort below batches instances by model and level); remembering the choice for next frame's hysteresis and the shadow pass
+			if (currentCache.HasLODs && currentCache.ModelBounds != null) {
+				LODSelector.SelectLODs(
+					currentCache,
+					drawTransformWorkspace,
+					drawModelWorkspace,
+					numInstances,
+					Input.Position,
+					currentProjectionScale,
+					currentProjectionIsPerspective,
+					LODSelector.DEFAULT_HYSTERESIS,
+					drawLODWorkspace,
+					drawModelWorkspace
+				);
+				for (uint i = 0U; i < numInstances; ++i) {
+					drawRecordWorkspace[i].Model = drawModelWorkspace[i];
+					currentMID.Data[drawSlotWorkspace[i]].LODIndex = drawLODWorkspace[i];
+				}
 			}
 
-			uint instanceStartOffset = RenderCache_IterateMaterial_ConcatReserve(numInstances);
-			uint nextWorkspaceIndex = 0;
-			uint outVBStartIndex, outIBStartIndex, outVBCount, outIBCount;
-
-			for (uint mI = 0U; mI < materialFilteringWorkspace.Length; ++mI) {
-				FastClearList<Transform> filteredTransformList = materialFilteringWorkspace[mI];
-				int numFilteredTransforms = filteredTransformList.Count;
-				if (numFilteredTransforms == 0) continue;
-
-				currentCache.GetModelBufferValues(mI, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
-
-				QueueRenderCommand(RenderCommand.DrawIndexedInstanced(
-					(int) outVBStartIndex,
-					outIBStartIndex,
-					outIBCount,
-					nextWorkspaceIndex + instanceStartOffset,
-					(uint) numFilteredTransforms
-				));
-
-				for (int iI = 0; iI < numFilteredTransforms; ++iI) {
-					if (mI == __EGGHACK_MH.ModelIndex && currentCache.ID == __EGGHACK_MH.GeoCacheID) {
-						instanceConcatWorkspace[nextWorkspaceIndex++] = filteredTransformList[iI].RotateBy(__EGGHACK_ROT).AsMatrixTransposed;
+			// Move instances of clustered models (drawn at their finest level of detail) to the end: rather than being batched with the rest,
+			// they're drawn one at a time, a range of visible clusters at a time, after them
+			uint numBatched = numInstances;
+			if (currentCache.HasClusters) {
+				uint[] modelFirstClusters = currentCache.ModelFirstClusters;
+				for (uint i = 0U; i < numBatched;) {
+					uint model = currentMID.Data[drawSlotWorkspace[i]].ModelIndex;
+					if (drawLODWorkspace[i] != 0 || modelFirstClusters[model + 1U] == modelFirstClusters[model]) {
+						++i;
+						continue;
 					}
-					else instanceConcatWorkspace[nextWorkspaceIndex++] = filteredTransformList[iI].AsMatrixTransposed;
+					--numBatched;
+					SwapDrawWorkspaceEntries(i, numBatched);
 				}
 			}
 
-			RenderCache_IterateMaterial_Concat(instanceConcatWorkspace, instanceStartOffset, numInstances);
-		}
+			// Sort state-first (every record shares this material's one shader and material entry, so that comes down to level of detail,
+			// i.e. model) and then front-to-back from the camera, and turn that in to state and draw commands (contiguous instances of the
+			// same level are merged in to one draw)
+			DrawSorter.SetDepths(drawTransformWorkspace, drawRecordWorkspace, numBatched, Input.Position);
+			DrawSorter.Sort(DrawSorter.OpaqueStateFirst, drawRecordWorkspace, numBatched, drawOrderWorkspace);
+			for (uint i = numBatched; i < numInstances; ++i) drawOrderWorkspace[i] = i;
 
-		private uint RenderCache_IterateMaterial_ConcatReserve(uint numInstances) {
-			lock (InstanceMutationLock) {
-				cpuInstanceBufferCurIndex += numInstances;
-				return cpuInstanceBufferCurIndex - numInstances;
+			if (modelRangeWorkspaceCache != currentCache) {
+				DrawSorter.GetLODBufferRanges(currentCache, ref modelRangeWorkspace);
+				modelRangeWorkspaceCache = currentCache;
 			}
-		}
 
-		private void RenderCache_IterateMaterial_Concat(Matrix[] localInstanceData, uint offset, uint count) {
-			lock (InstanceMutationLock) {
-				if (offset + count > cpuInstanceBuffer.Length) {
-					// x2 (e.g. '<< 1') below to avoid excessive garbage when the limit keeps increasing by small amounts
-					Matrix[] newCPUInstanceBuffer = new Matrix[(offset + count) << 1];
-					Array.Copy(cpuInstanceBuffer, 0, newCPUInstanceBuffer, 0, cpuInstanceBuffer.Length);
-					cpuInstanceBuffer = newCPUInstanceBuffer;
+			uint numStateCommands = (switchesShader ? shaderCommandOffsetWorkspace[1] : 0U) + materialCommandOffsetWorkspace[1];
+			if (drawCommandWorkspace == null || drawCommandWorkspace.Length < numStateCommands + numInstances) {
+				drawCommandWorkspace = new RenderCommand[(numStateCommands + numInstances) << 1];
+			}
+
+			uint instanceStartOffset = RenderCache_IterateMaterial_ConcatReserve(numInstances);
+			uint numDrawCommands;
+			if (numBatched > 0U) {
+				numDrawCommands = DrawSorter.EmitCommands(
+					drawRecordWorkspace,
+					drawOrderWorkspace,
+					numBatched,
+					modelRangeWorkspace,
+					switchesShader ? shaderCommandWorkspace : null,
+					switchesShader ? shaderCommandOffsetWorkspace : null,
+					materialCommandWorkspace,
+					materialCommandOffsetWorkspace,
+					true,
+					instanceStartOffset,
+					drawCommandWorkspace
+				);
+			}
+			else {
+				// Only clustered instances are drawn, so the sorter has nowhere to put the state: it goes straight ahead of the clusters
+				numDrawCommands = 0U;
+				if (switchesShader) {
+					for (uint i = 0U; i < shaderCommandOffsetWorkspace[1]; ++i) drawCommandWorkspace[numDrawCommands++] = shaderCommandWorkspace[i];
 				}
+				for (uint i = 0U; i < materialCommandOffsetWorkspace[1]; ++i) drawCommandWorkspace[numDrawCommands++] = materialCommandWorkspace[i];
+			}
+			for (uint i = 0U; i < numDrawCommands; ++i) QueueRenderCommand(drawCommandWorkspace[i]);
+			if (switchesShader) {
+				lastSetFragmentShader = materialShader;
+				lastFrameNum = frameNum;
+			}
 
-				Array.Copy(localInstanceData, 0, cpuInstanceBuffer, offset, count);
+			// Draw each clustered instance's clusters that are in view (and, when back faces are culled anyway, that face the camera);
+			// cones only hold for a perspective camera's single eye point, and for the winding the rasterizer culls by
+			if (numBatched < numInstances) {
+				bool cullBackFacingClusters = currentProjectionIsPerspective
+					&& rsState.TriangleCulling == TriangleCullMode.BackfaceCulling
+					&& !rsState.FlipFaces;
+				if (clusterRangeWorkspace == null || clusterRangeWorkspace.Length < currentCache.Clusters.Length) {
+					clusterRangeWorkspace = new MeshClusterer.IndexRange[currentCache.Clusters.Length];
+				}
+				for (uint i = numBatched; i < numInstances; ++i) {
+					uint model = currentMID.Data[drawSlotWorkspace[i]].ModelIndex;
+					uint vbStart, ibStart, vbCount, ibCount;
+					currentCache.GetModelBufferValues(model, out vbStart, out ibStart, out vbCount, out ibCount);
+					uint firstCluster = currentCache.ModelFirstClusters[model];
+					uint numRanges = MeshClusterer.CullClusters(
+						currentFrustum,
+						Input.Position,
+						cullBackFacingClusters,
+						currentCache.Clusters,
+						firstCluster,
+						currentCache.ModelFirstClusters[model + 1U] - firstCluster,
+						drawTransformWorkspace[i],
+						ibStart,
+						clusterRangeWorkspace
+					);
+					for (uint r = 0U; r < numRanges; ++r) {
+						QueueRenderCommand(RenderCommand.DrawIndexedInstanced(
+							(int) vbStart,
+							clusterRangeWorkspace[r].FirstIndex,
+							clusterRangeWorkspace[r].NumIndices,
+							instanceStartOffset + i,
+							1U
+						));
+					}
+				}
 			}
-		}
 
-		private void SetInstanceBufferAndFlushCommands() {
-			QueueRenderCommand(
-				reservedSetIBCommandSlot,
-				RenderCommand.SetInstanceBuffer(gpuInstanceBuffer, currentVS.InstanceDataBinding.SlotIndex)
+			// Write instance data in draw order straight in to our reserved part of the instance buffer
+			InstanceMatrixWriter.WriteTransposedMatrices(
+				drawTransformWorkspace,
+				drawOrderWorkspace,
+				numInstances,
+				currentCPUInstanceBufferPtr + instanceStartOffset
 			);
-			FlushRenderCommands();
 		}
 
-		private void SortByProximityToCamera(ModelInstanceManager.MIDArray midArray) {
-			if (localMidComparer == null) localMidComparer = new MIDComparer();
-			if (sortedModelData == null || sortedModelData.Length < midArray.Length) sortedModelData = new ModelInstanceData[midArray.Length << 1];
-
-			for (int i = 0; i < midArray.Length; ++i) sortedModelData[i] = midArray.Data[i];
+		private static void SwapDrawWorkspaceEntries(uint a, uint b) {
+			Transform transform = drawTransformWorkspace[a];
+			drawTransformWorkspace[a] = drawTransformWorkspace[b];
+			drawTransformWorkspace[b] = transform;
+			uint model = drawModelWorkspace[a];
+			drawModelWorkspace[a] = drawModelWorkspace[b];
+			drawModelWorkspace[b] = model;
+			uint slot = drawSlotWorkspace[a];
+			drawSlotWorkspace[a] = drawSlotWorkspace[b];
+			drawSlotWorkspace[b] = slot;
+			byte lod = drawLODWorkspace[a];
+			drawLODWorkspace[a] = drawLODWorkspace[b];
+			drawLODWorkspace[b] = lod;
+			DrawSorter.DrawRecord record = drawRecordWorkspace[a];
+			drawRecordWorkspace[a] = drawRecordWorkspace[b];
+			drawRecordWorkspace[b] = record;
+		}
 
-			localMidComparer.CamPos = Input.Position;
-			Array.Sort(sortedModelData, 0, (int) midArray.Length, localMidComparer);
+		private uint RenderCache_IterateMaterial_ConcatReserve(uint numInstances) {
+			// The buffer was sized for every instance before iterating, so reserving is all that's needed (and no lock)
+			return (uint) (Interlocked.Add(ref cpuInstanceBufferCurIndex, (int) numInstances) - (int) numInstances);
 		}
 
-		private class MIDComparer : IComparer<ModelInstanceData> {
-			public Vector3 CamPos;
+		private void SetInstanceBuffer() {
+			QueueRenderCommand(
+				reservedSetIBCommandSlot,
+				RenderCommand.SetInstanceBuffer(gpuInstanceBuffer, currentVS.InstanceDataBinding.SlotIndex)
+			);
+		}
 
-			public int Compare(ModelInstanceData x, ModelInstanceData y) {
-				return Vector3.DistanceSquared(x.Transform.Translation, CamPos).CompareTo(Vector3.DistanceSquared(y.Transform.Translation, CamPos));
-			}
+		private void SetInstanceBufferAndFlushCommands() {
+			SetInstanceBuffer();
+			FlushRenderCommands();
 		}
 	}
 }
\ No newline at end of file
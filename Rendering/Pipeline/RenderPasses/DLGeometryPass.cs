@@ -23,6 +23,7 @@ namespace Ophidian.Losgap.Rendering {
 		private DepthStencilState dsState;
 		private BlendState blendState;
 		private ShadowPass shadowPass;
+		private OcclusionBuffer occlusionBuffer;
 		private bool clearOutputBeforePass;
 
 		public BlendState BlendState {
@@ -134,6 +135,23 @@ namespace Ophidian.Losgap.Rendering {
 			}
 		}
 
+		/// <summary>
+		/// A buffer whose occluders are drawn from the <see cref="Input"/> camera each frame, so that instances entirely hidden behind them
+		/// are not drawn; or null to draw everything in view. Must not be shared with another pass.
+		/// </summary>
+		public OcclusionBuffer OcclusionBuffer {
+			get {
+				lock (InstanceMutationLock) {
+					return occlusionBuffer;
+				}
+			}
+			set {
+				using (RenderingModule.RenderStateBarrier.AcquirePermit(withLock: InstanceMutationLock)) {
+					occlusionBuffer = value;
+				}
+			}
+		}
+
 		/// <summary>
 		/// The rasterizer state that will be used to generate pixels from rendered geometry.
 		/// </summary>
@@ -192,11 +210,11 @@ namespace Ophidian.Losgap.Rendering {
 		public DLGeometryPass(string name) : base(name) {
 			setUpCacheForLocalThreadAct = SetUpCacheForLocalThread;
 			renderCacheIterateMatAct = RenderCache_IterateMaterial;
-			setInstanceBufferAndFlushCommandsAct = () => {
+			setInstanceBufferAct = () => {
 				// Unbind shadow buffer
 				QueueShaderSwitch(geomFSWithShadowSupport);
 				QueueShaderResourceUpdate(geomFSWithShadowSupport, geomFSShadowUnbindPackage);
-				SetInstanceBufferAndFlushCommands();
+				SetInstanceBuffer();
 			};
 		}
 
@@ -14,7 +14,6 @@ namespace Ophidian.Losgap.Rendering {
 	public unsafe partial class DLLightPass {
 		private const int LIGHTING_TILE_GRANULARITY = 5;
 		private static readonly List<LightProperties[]> perTileLightPropsWorkspace = new List<LightProperties[]>();
-		private static readonly int[] perTileLightPropCounts = new int[LIGHTING_TILE_GRANULARITY * LIGHTING_TILE_GRANULARITY];
 		private static readonly float[] tileOffsetsX = new float[LIGHTING_TILE_GRANULARITY + 1];
 		private static readonly float[] tileOffsetsY = new float[LIGHTING_TILE_GRANULARITY + 1];
 		private static readonly VertexBufferBuilder<LightPlaneVertex> lightPlaneBuilder = BufferFactory.NewVertexBuffer<LightPlaneVertex>()
@@ -32,6 +31,10 @@ namespace Ophidian.Losgap.Rendering {
 			.WithUsage(ResourceUsage.Write);
 		private readonly Texture2D<TexelFormat.RGBA32Float>[] previousGBuffer = new Texture2D<TexelFormat.RGBA32Float>[DLGeometryPass.NUM_GBUFFER_TEXTURES];
 		private readonly LightProperties[] lightPropsWorkspace = new LightProperties[MAX_DYNAMIC_LIGHTS];
+		private readonly FrustumCuller.BoundingSphere[] lightBoundsWorkspace = new FrustumCuller.BoundingSphere[MAX_DYNAMIC_LIGHTS];
+		private readonly uint[] visibleLightWorkspace = new uint[MAX_DYNAMIC_LIGHTS];
+		private readonly uint[] tileLightOffsets = new uint[LIGHTING_TILE_GRANULARITY * LIGHTING_TILE_GRANULARITY + 1];
+		private readonly uint[] tileLightIndices = new uint[MAX_DYNAMIC_LIGHTS * LIGHTING_TILE_GRANULARITY * LIGHTING_TILE_GRANULARITY];
 		private Texture2D<TexelFormat.RGBA8UNorm> preBloomBuffer, reducedBloomBuffer, bloomTargetBuffer;
 		private Texture2D<TexelFormat.DepthStencil> bloomResizeCopyDSBuffer, dsThrowawayBuffer;
 		private Texture2D<TexelFormat.RGBA8UNorm> nonDepthOfFieldBackBuffer, reducedNonDepthOfFieldBackBuffer, depthOfFieldBackBuffer;
@@ -143,12 +146,21 @@ namespace Ophidian.Losgap.Rendering {
 			//input.Position = Vector3.ZERO;
 			//input.Orient(Vector3.FORWARD, Vector3.UP);
 
-			var frustum = input.GetFrustum(output);
+			var worldToProjMat = (*((Matrix*) input.GetRecalculatedViewMatrix()) * *((Matrix*) output.GetRecalculatedProjectionMatrix(input)));
 			int numLights = addedLights.Count;
-			int numLightsInFrustum = 0;
 			for (int i = 0; i < numLights; ++i) {
-				if (!frustum.IsWithinFrustum(new Sphere(addedLights[i].Position, addedLights[i].Radius))) continue;
-				lightPropsWorkspace[numLightsInFrustum++] = addedLights[i].Properties;
+				lightPropsWorkspace[i] = addedLights[i].Properties;
+				lightBoundsWorkspace[i] = new FrustumCuller.BoundingSphere(lightPropsWorkspace[i].Position, lightPropsWorkspace[i].Radius);
+			}
+			int numLightsInFrustum = (int) FrustumCuller.CullSpheres(
+				FrustumCuller.CreateFrustum(worldToProjMat),
+				lightBoundsWorkspace,
+				(uint) numLights,
+				visibleLightWorkspace
+			);
+			// Visible indices are ascending, so compacting in place never overwrites a light we still need
+			for (int i = 0; i < numLightsInFrustum; ++i) {
+				lightPropsWorkspace[i] = lightPropsWorkspace[visibleLightWorkspace[i]];
 			}
 			if (numLightsInFrustum > dynamicLightCap) {
 				dynamicLightComparer.CameraPosition = input.Position;
@@ -160,73 +172,33 @@ namespace Ophidian.Losgap.Rendering {
 			var lightMetaCBuffer = (ConstantBufferBinding) dlLightFS.GetBindingByIdentifier("LightMeta");
 			QueueShaderResourceUpdate(dlLightFS, fsResPackage);
 
-			Array.Clear(perTileLightPropCounts, 0, perTileLightPropCounts.Length);
-
-			
-
-			Vector3 upDir = input.UpDirection;
-			Vector3 downDir = -input.UpDirection;
-			Vector3 rightDir = upDir.Cross(input.Orientation);
-			Vector3 leftDir = -rightDir;
-			var worldToProjMat = (*((Matrix*) input.GetRecalculatedViewMatrix()) * *((Matrix*) output.GetRecalculatedProjectionMatrix(input)));
-
-			for (int i = 0; i < numLightsInFrustum; ++i) {
-				var lightProps = lightPropsWorkspace[i];
-				//lightProps = new LightProperties(
-				//	Vector3.LEFT + Vector3.BACKWARD, 3f, Vector3.ONE
-				//);
-				var lightCentre = lightProps.Position;
-				var lightTop = new Vector4(lightCentre + upDir * lightProps.Radius, w: 1f);
-				var lightBottom = new Vector4(lightCentre + downDir * lightProps.Radius, w: 1f);
-				var lightLeftmost = new Vector4(lightCentre + leftDir * lightProps.Radius, w: 1f);
-				var lightRightmost = new Vector4(lightCentre + rightDir * lightProps.Radius, w: 1f);
-
-				var lightTopProjspace = lightTop * worldToProjMat;
-				var lightBottomProjspace = lightBottom * worldToProjMat;
-				var lightLeftmostProjspace = lightLeftmost * worldToProjMat;
-				var lightRightmostProjspace = lightRightmost * worldToProjMat;
-
-				var lightTopScreenSpace = lightTopProjspace / Math.Abs(lightTopProjspace.W);
-				var lightBottomScreenSpace = lightBottomProjspace / Math.Abs(lightBottomProjspace.W);
-				var lightLeftmostScreenSpace = lightLeftmostProjspace / Math.Abs(lightLeftmostProjspace.W);
-				var lightRightmostScreenSpace = lightRightmostProjspace / Math.Abs(lightRightmostProjspace.W);
-
-				var xMin = ((float) MathUtils.Clamp(lightLeftmostScreenSpace.X, -1f, 1f) + 1f) * 0.5f;
-				var xMax = ((float) MathUtils.Clamp(lightRightmostScreenSpace.X, -1f, 1f) + 1f) * 0.5f;
-				var yMin = ((float) MathUtils.Clamp(lightBottomScreenSpace.Y, -1f, 1f) + 1f) * 0.5f;
-				var yMax = ((float) MathUtils.Clamp(lightTopScreenSpace.Y, -1f, 1f) + 1f) * 0.5f;
-
+			LightBinner.BinLights(
+				lightPropsWorkspace,
+				(uint) numLightsInFrustum,
+				worldToProjMat,
+				LIGHTING_TILE_GRANULARITY,
+				LIGHTING_TILE_GRANULARITY,
+				tileLightOffsets,
+				tileLightIndices
+			);
+
+			for (int y = 0; y < LIGHTING_TILE_GRANULARITY; ++y) {
 				for (int x = 0; x < LIGHTING_TILE_GRANULARITY; ++x) {
-					for (int y = 0; y < LIGHTING_TILE_GRANULARITY; ++y) {
-						var tileXMin = tileOffsetsX[x];
-						var tileXMax = tileOffsetsX[x + 1];
-						var tileYMin = tileOffsetsY[y];
-						var tileYMax = tileOffsetsY[y + 1];
-
-						if (xMax < tileXMin
-							|| xMin > tileXMax
-							|| yMax < tileYMin
-							|| yMin > tileYMax) {
-							continue;
-						}
-
-						var bucketIndex = x * LIGHTING_TILE_GRANULARITY + y;
-						perTileLightPropsWorkspace[bucketIndex][perTileLightPropCounts[bucketIndex]++] = lightProps;
-					}
-				}
-			}
-
-			for (int x = 0; x < LIGHTING_TILE_GRANULARITY; ++x) {
-				for (int y = 0; y < LIGHTING_TILE_GRANULARITY; ++y) {
-					var bucketIndex = x * LIGHTING_TILE_GRANULARITY + y;
-					var numLightsOnThisTile = perTileLightPropCounts[bucketIndex];
+					var tileIndex = y * LIGHTING_TILE_GRANULARITY + x;
+					var firstLightIndex = tileLightOffsets[tileIndex];
+					var numLightsOnThisTile = (int) (tileLightOffsets[tileIndex + 1] - firstLightIndex);
 
 					if (numLightsOnThisTile == 0) continue;
 
+					var tileLightProps = perTileLightPropsWorkspace[tileIndex];
+					for (int i = 0; i < numLightsOnThisTile; ++i) {
+						tileLightProps[i] = lightPropsWorkspace[tileLightIndices[firstLightIndex + i]];
+					}
+
 					var scalars = new Vector4(tileOffsetsX[x], tileOffsetsX[x + 1], tileOffsetsY[y], tileOffsetsY[y + 1]); // 0f to 1f, from bottom left corner
 					QueueRenderCommand(RenderCommand.DiscardWriteShaderConstantBuffer(
 						lightBuffer, 
-						new ArraySlice<LightProperties>(perTileLightPropsWorkspace[bucketIndex], 0U, (uint) numLightsOnThisTile), 
+						new ArraySlice<LightProperties>(tileLightProps, 0U, (uint) numLightsOnThisTile), 
 						(uint) sizeof(LightProperties)
 					));
 					int* numLightsWithPadding = stackalloc int[4];
@@ -239,9 +211,6 @@ namespace Ophidian.Losgap.Rendering {
 					QueueRenderCommand(RenderCommand.Draw(3, 3U));
 				}
 			}
-			
-			
-			
 
 			// Unbind gbuffer
 			QueueShaderResourceUpdate(dlLightFS, fsUnbindResPackage);
@@ -6,55 +6,126 @@ using System;
 using System.Linq;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Threading;
 using Ophidian.Losgap.Interop;
 
 namespace Ophidian.Losgap.Rendering {
-	internal sealed class DeferredRCQ : RenderCommandQueue {
+	internal sealed class DeferredRCQ : RenderCommandQueue, IDisposable {
+		private static readonly List<DeferredRCQ> createdQueues = new List<DeferredRCQ>();
+		private static readonly object createdQueuesLock = new object();
+		// Reused by every FlushParallel (under createdQueuesLock), so that neither the stack nor the heap grows with the number of queues
+		private static DeviceContextHandle[] flushContextWorkspace = new DeviceContextHandle[0];
+		private static IntPtr[] flushStreamWorkspace = new IntPtr[0];
+		private static uint[] flushStreamLenWorkspace = new uint[0];
+		private readonly DeviceContextHandle deferredContext;
 		private IntPtr lastCommandListHandle;
 		private readonly Action invokeOnMasterAction;
+		private bool isDisposed = false;
 
 		public DeferredRCQ() {
 			invokeOnMasterAction = InvokeOnMasterAction;
+			deferredContext = RenderingModule.DeviceContext; // Queues are created on the thread that owns them
+			lock (createdQueuesLock) {
+				createdQueues.Add(this);
+			}
+		}
+
+		/// <summary>
+		/// Unregisters this queue, so that <see cref="FlushParallel"/> no longer references or flushes it. Any commands still queued on
+		/// it are discarded. Call this once the owning thread will queue nothing more (e.g. when it has exited).
+		/// </summary>
+		public void Dispose() {
+			lock (createdQueuesLock) {
+				if (isDisposed) return;
+				createdQueues.Remove(this);
+				isDisposed = true;
+			}
+		}
+
+		/// <summary>
+		/// Records every deferred queue's pending commands on to that queue's deferred context in parallel (natively, on the job system),
+		/// and executes the resultant command lists on the immediate context in the order the queues were created.
+		/// </summary>
+		/// <remarks>
+		/// Must be called from the master thread, while the threads that own the queues are not queueing anything. Queues with
+		/// queued actions (see <see cref="RenderCommandQueue.QueueAction"/>) can not be flushed this way, as their actions must run on
+		/// the owning thread. Memory reserved from the owning threads' <see cref="FrameArena"/>s is not reset.
+		/// </remarks>
+		public static unsafe void FlushParallel() {
+			Assure.Equal(Thread.CurrentThread, LosgapSystem.MasterThread, "Deferred queues can only be flushed in parallel from the master thread.");
+			lock (createdQueuesLock) {
+				int numQueues = createdQueues.Count;
+				if (flushContextWorkspace.Length < numQueues) {
+					flushContextWorkspace = new DeviceContextHandle[numQueues << 1];
+					flushStreamWorkspace = new IntPtr[numQueues << 1];
+					flushStreamLenWorkspace = new uint[numQueues << 1];
+				}
+				uint numStreams = 0U;
+
+				for (int i = 0; i < numQueues; ++i) {
+					DeferredRCQ queue = createdQueues[i];
+					if (queue.CurStreamOffset == 0U) continue;
+					if (queue.DeferredActions.Count > 0) {
+						throw new InvalidOperationException("Render command queues with queued actions must be flushed on their own thread " +
+							"with FlushRenderCommands().");
+					}
+					flushContextWorkspace[numStreams] = queue.deferredContext;
+					flushStreamWorkspace[numStreams] = queue.CommandStream.AlignedPointer;
+					flushStreamLenWorkspace[numStreams] = queue.CurStreamOffset;
+					++numStreams;
+				}
+				if (numStreams == 0U) return;
+
+				fixed (DeviceContextHandle* deferredContexts = flushContextWorkspace) {
+					fixed (IntPtr* commandStreams = flushStreamWorkspace) {
+						fixed (uint* commandStreamLens = flushStreamLenWorkspace) {
+							NativeMethods.RenderPassManager_FlushParallel(
+								RenderingModule.DeviceContext,
+								(IntPtr) deferredContexts,
+								(IntPtr) commandStreams,
+								(IntPtr) commandStreamLens,
+								numStreams
+							).ThrowOnFailure();
+						}
+					}
+				}
+
+				for (int i = 0; i < numQueues; ++i) {
+					createdQueues[i].ClearStream();
+				}
+			}
 		}
 
 		public override unsafe void Flush() {
-			IntPtr commandListHandleMem = RenderCommandTempMemPool.GetLocalPool().Reserve((uint) IntPtr.Size);
+			IntPtr commandListHandleMem = FrameArena.Reserve((uint) IntPtr.Size);
 			QueueCommand(new RenderCommand(RenderCommandInstruction.FinishCommandList, (IntPtr) (&commandListHandleMem)));
 
 			uint offset = 0U;
-			bool success;
 
 			for (int i = 0; i < DeferredActions.Count; i++) {
 				KeyValuePair<uint, Action> curAction = DeferredActions[i];
-				char* failReason = stackalloc char[InteropUtils.MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
-				success = NativeMethods.RenderPassManager_FlushInstructions(
-					(IntPtr) failReason, 
-					RenderingModule.DeviceContext,
-					RenderCommandList.AlignedPointer + (int) offset * sizeof(RenderCommand),
+				NativeMethods.RenderPassManager_FlushCompactInstructions(
+					deferredContext,
+					CommandStream.AlignedPointer + (int) offset,
 					curAction.Key - offset
-				);
-				if (!success) throw new NativeOperationFailedException(Marshal.PtrToStringUni((IntPtr) failReason));
+				).ThrowOnFailure();
 				offset = curAction.Key;
 				curAction.Value();
 			}
 
-			char* failReason2 = stackalloc char[InteropUtils.MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
-			success = NativeMethods.RenderPassManager_FlushInstructions(
-				(IntPtr) failReason2, 
-				RenderingModule.DeviceContext,
-				RenderCommandList.AlignedPointer + (int) offset * sizeof(RenderCommand),
-				CurListIndex - offset
-			);
-			if (!success) throw new NativeOperationFailedException(Marshal.PtrToStringUni((IntPtr) failReason2));
+			NativeMethods.RenderPassManager_FlushCompactInstructions(
+				deferredContext,
+				CommandStream.AlignedPointer + (int) offset,
+				CurStreamOffset - offset
+			).ThrowOnFailure();
 
 			lastCommandListHandle = commandListHandleMem;
 
 			LosgapSystem.InvokeOnMaster(invokeOnMasterAction);
 
-			CurListIndex = 0U;
-			DeferredActions.Clear();
+			ClearStream();
 
-			RenderCommandTempMemPool.GetLocalPool().FreeAll();
+			FrameArena.Reset();
 		}
 
 		private unsafe void InvokeOnMasterAction() {
@@ -0,0 +1,281 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 22:58 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to the native draw sorter (DrawSorter in RenderingNative): draws are described as <see cref="DrawRecord"/>s, packed in
+	/// to 64-bit keys according to a <see cref="SortKeyLayout"/>, radix sorted, and then turned in to an ordered list of
+	/// <see cref="RenderCommand"/>s that only switches shader/material where the sorted order requires it. Instances can also be radix
+	/// sorted by their distance from the camera alone.
+	/// </summary>
+	internal static unsafe class DrawSorter {
+		public const int MAX_SORT_KEY_FIELDS = 6;
+
+		public enum SortKeyField : uint {
+			Pass = 0U,
+			Shader = 1U,
+			Material = 2U,
+			Model = 3U,
+			DepthFrontToBack = 4U,
+			DepthBackToFront = 5U
+		}
+
+		/// <summary>
+		/// Describes how a <see cref="DrawRecord"/> is packed in to its sort key; the first field added is the most significant.
+		/// Index fields keep their low bits, depth fields keep their most significant bits (up to 32).
+		/// </summary>
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct SortKeyLayout {
+			private fixed uint fields[MAX_SORT_KEY_FIELDS];
+			private fixed uint fieldBits[MAX_SORT_KEY_FIELDS];
+			private uint numFields;
+
+			public uint NumFields {
+				get {
+					return numFields;
+				}
+			}
+
+			public SortKeyLayout WithField(SortKeyField field, uint numBits) {
+				Assure.LessThan(numFields, MAX_SORT_KEY_FIELDS, "Too many sort key fields.");
+				Assure.GreaterThan(numBits, 0U, "Sort key fields must be at least one bit wide.");
+				Assure.LessThanOrEqualTo(numBits, 32U, "Sort key fields can be at most 32 bits wide.");
+				SortKeyLayout result = this;
+				result.fields[numFields] = (uint) field;
+				result.fieldBits[numFields] = numBits;
+				++result.numFields;
+				return result;
+			}
+		}
+
+		/// <summary>
+		/// A single draw: <see cref="Shader"/> and <see cref="Material"/> index in to the state command tables given to
+		/// <see cref="EmitCommands(DrawRecord[], uint[], uint, ModelBufferRange[], RenderCommand[], uint[], RenderCommand[], uint[], bool, uint, RenderCommand[])"/>,
+		/// <see cref="Model"/> in to the model buffer ranges. <see cref="Depth"/> is anything that orders draws by distance, usually as
+		/// written by <see cref="SetDepths"/>.
+		/// </summary>
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct DrawRecord {
+			public uint Pass;
+			public uint Shader;
+			public uint Material;
+			public uint Model;
+			public float Depth;
+			public uint FirstInstance;
+			public uint NumInstances;
+		}
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct ModelBufferRange {
+			public int FirstVertexIndex;
+			public uint FirstIndexIndex;
+			public uint NumIndices;
+		}
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		private struct DrawStateTables {
+			public IntPtr ShaderCommands; // RenderCommand*
+			public IntPtr ShaderCommandOffsets; // uint*
+			public IntPtr MaterialCommands; // RenderCommand*
+			public IntPtr MaterialCommandOffsets; // uint*
+			public IntPtr Models; // ModelBufferRange*
+		}
+
+		/// <summary>
+		/// Opaque geometry: minimise state changes first, and only then draw front-to-back to make the most of early depth rejection.
+		/// </summary>
+		public static readonly SortKeyLayout OpaqueStateFirst = new SortKeyLayout()
+			.WithField(SortKeyField.Pass, 4U)
+			.WithField(SortKeyField.Shader, 8U)
+			.WithField(SortKeyField.Material, 12U)
+			.WithField(SortKeyField.Model, 16U)
+			.WithField(SortKeyField.DepthFrontToBack, 24U);
+
+		/// <summary>
+		/// Alpha-blended geometry: correct blending needs strict back-to-front order, so state is only grouped among equal depths.
+		/// </summary>
+		public static readonly SortKeyLayout AlphaBackToFront = new SortKeyLayout()
+			.WithField(SortKeyField.Pass, 4U)
+			.WithField(SortKeyField.DepthBackToFront, 32U)
+			.WithField(SortKeyField.Shader, 8U)
+			.WithField(SortKeyField.Material, 12U)
+			.WithField(SortKeyField.Model, 8U);
+
+		/// <summary>
+		/// Writes the indices of the first <paramref name="numRecords"/> records, in sorted order, to <paramref name="outOrder"/>.
+		/// The sort is stable.
+		/// </summary>
+		public static void Sort(SortKeyLayout layout, DrawRecord[] records, uint numRecords, uint[] outOrder) {
+			Assure.NotNull(records);
+			Assure.NotNull(outOrder);
+			Assure.LessThanOrEqualTo(numRecords, records.Length);
+			Assure.LessThanOrEqualTo(numRecords, outOrder.Length);
+			if (numRecords == 0U) return;
+
+			fixed (DrawRecord* recordsPtr = records) {
+				fixed (uint* orderPtr = outOrder) {
+					NativeMethods.DrawSorter_Sort((IntPtr) (&layout), (IntPtr) recordsPtr, numRecords, (IntPtr) orderPtr).ThrowOnFailure();
+				}
+			}
+		}
+
+		/// <summary>
+		/// Sets the <see cref="DrawRecord.Depth"/> of each of the first <paramref name="numRecords"/> records to the squared distance of
+		/// the matching transform's translation from <paramref name="viewPosition"/>.
+		/// </summary>
+		public static void SetDepths(Transform[] transforms, DrawRecord[] records, uint numRecords, Vector3 viewPosition) {
+			Assure.NotNull(transforms);
+			Assure.NotNull(records);
+			Assure.LessThanOrEqualTo(numRecords, transforms.Length);
+			Assure.LessThanOrEqualTo(numRecords, records.Length);
+			if (numRecords == 0U) return;
+
+			fixed (Transform* transformsPtr = transforms) {
+				fixed (DrawRecord* recordsPtr = records) {
+					NativeMethods.DrawSorter_SetDepths((IntPtr) transformsPtr, numRecords, (IntPtr) (&viewPosition), (IntPtr) recordsPtr).ThrowOnFailure();
+				}
+			}
+		}
+
+		/// <summary>
+		/// Writes the indices of the first <paramref name="numInstances"/> transforms to <paramref name="outOrder"/>, ordered by the
+		/// distance of their translations from <paramref name="viewPosition"/> (nearest first, or furthest first if
+		/// <paramref name="backToFront"/> is true). If <paramref name="groups"/> is not null, instances are ordered by their group first
+		/// (e.g. their model index) and only by distance within each group. The sort is stable.
+		/// </summary>
+		public static void SortByDistance(Transform[] transforms, uint[] groups, uint numInstances, Vector3 viewPosition, bool backToFront,
+			uint[] outOrder) {
+			Assure.NotNull(transforms);
+			Assure.NotNull(outOrder);
+			Assure.LessThanOrEqualTo(numInstances, transforms.Length);
+			Assure.LessThanOrEqualTo(numInstances, outOrder.Length);
+			Assure.True(groups == null || numInstances <= groups.Length, "Group array is too short.");
+			if (numInstances == 0U) return;
+
+			fixed (Transform* transformsPtr = transforms) {
+				fixed (uint* groupsPtr = groups) {
+					fixed (uint* orderPtr = outOrder) {
+						NativeMethods.DrawSorter_SortByDistance(
+							(IntPtr) transformsPtr,
+							(IntPtr) groupsPtr,
+							numInstances,
+							(IntPtr) (&viewPosition),
+							backToFront,
+							(IntPtr) orderPtr
+						).ThrowOnFailure();
+					}
+				}
+			}
+		}
+
+		/// <summary>
+		/// Fills <paramref name="ranges"/> with the vertex and index buffer range of each model in <paramref name="cache"/>, growing it
+		/// if required.
+		/// </summary>
+		public static void GetModelBufferRanges(GeometryCache cache, ref ModelBufferRange[] ranges) {
+			Assure.NotNull(cache);
+			if (ranges == null || ranges.Length < cache.NumModels) ranges = new ModelBufferRange[cache.NumModels];
+
+			uint outVBStartIndex, outIBStartIndex, outVBCount, outIBCount;
+			for (uint mI = 0U; mI < cache.NumModels; ++mI) {
+				cache.GetModelBufferValues(mI, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
+				ranges[mI] = new ModelBufferRange {
+					FirstVertexIndex = (int) outVBStartIndex,
+					FirstIndexIndex = outIBStartIndex,
+					NumIndices = outIBCount
+				};
+			}
+		}
+
+		/// <summary>
+		/// Fills <paramref name="ranges"/> with the vertex and index buffer range of each level of detail in <paramref name="cache"/>
+		/// (indexed as <see cref="GeometryCache.ModelFirstLODs"/> describes), growing it if required. For caches without extra levels of
+		/// detail this is the same as <see cref="GetModelBufferRanges"/>.
+		/// </summary>
+		public static void GetLODBufferRanges(GeometryCache cache, ref ModelBufferRange[] ranges) {
+			Assure.NotNull(cache);
+			if (ranges == null || ranges.Length < cache.NumLODs) ranges = new ModelBufferRange[cache.NumLODs];
+
+			uint outVBStartIndex, outIBStartIndex, outVBCount, outIBCount;
+			for (uint lI = 0U; lI < cache.NumLODs; ++lI) {
+				cache.GetLODBufferValues(lI, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
+				ranges[lI] = new ModelBufferRange {
+					FirstVertexIndex = (int) outVBStartIndex,
+					FirstIndexIndex = outIBStartIndex,
+					NumIndices = outIBCount
+				};
+			}
+		}
+
+		/// <summary>
+		/// Writes the commands that draw the given records in the given order to <paramref name="outCommands"/>, and returns how many
+		/// were written. If <paramref name="packInstances"/> is true, each record's <see cref="DrawRecord.FirstInstance"/> is ignored and
+		/// its instances are assumed to be laid out in draw order starting at <paramref name="firstPackedInstance"/>. The caller sets
+		/// shader and material state itself.
+		/// </summary>
+		public static uint EmitCommands(DrawRecord[] records, uint[] order, uint numRecords, ModelBufferRange[] models,
+			bool packInstances, uint firstPackedInstance, RenderCommand[] outCommands) {
+			return EmitCommands(records, order, numRecords, models, null, null, null, null, packInstances, firstPackedInstance, outCommands);
+		}
+
+		/// <summary>
+		/// As <see cref="EmitCommands(DrawRecord[], uint[], uint, ModelBufferRange[], bool, uint, RenderCommand[])"/>, but also writes
+		/// the commands that switch to each record's shader and material ahead of its draw, wherever they differ from the previous
+		/// record's. The commands for shader <c>i</c> run from <c>shaderCommands[shaderCommandOffsets[i]]</c> up to
+		/// <c>shaderCommands[shaderCommandOffsets[i + 1]]</c>, and likewise for materials. Either pair of tables may be null if the caller
+		/// sets that state itself. Records with no instances change no state, so state that nothing is drawn with is never written.
+		/// </summary>
+		public static uint EmitCommands(DrawRecord[] records, uint[] order, uint numRecords, ModelBufferRange[] models,
+			RenderCommand[] shaderCommands, uint[] shaderCommandOffsets, RenderCommand[] materialCommands, uint[] materialCommandOffsets,
+			bool packInstances, uint firstPackedInstance, RenderCommand[] outCommands) {
+			Assure.NotNull(records);
+			Assure.NotNull(order);
+			Assure.NotNull(models);
+			Assure.NotNull(outCommands);
+			Assure.LessThanOrEqualTo(numRecords, records.Length);
+			Assure.LessThanOrEqualTo(numRecords, order.Length);
+			Assure.True((shaderCommands == null) == (shaderCommandOffsets == null), "Shader commands must be given with their offsets.");
+			Assure.True((materialCommands == null) == (materialCommandOffsets == null), "Material commands must be given with their offsets.");
+			if (numRecords == 0U) return 0U;
+
+			// Tables without any commands in them are as good as none (and fixing an empty array gives a null pointer anyway)
+			bool hasShaderTable = shaderCommands != null && shaderCommands.Length > 0;
+			bool hasMaterialTable = materialCommands != null && materialCommands.Length > 0;
+			uint numCommands;
+			fixed (DrawRecord* recordsPtr = records) {
+				fixed (uint* orderPtr = order) {
+					fixed (ModelBufferRange* modelsPtr = models) {
+						fixed (RenderCommand* shaderCommandsPtr = shaderCommands, materialCommandsPtr = materialCommands, outCommandsPtr = outCommands) {
+							fixed (uint* shaderCommandOffsetsPtr = shaderCommandOffsets, materialCommandOffsetsPtr = materialCommandOffsets) {
+								DrawStateTables tables = new DrawStateTables {
+									ShaderCommands = hasShaderTable ? (IntPtr) shaderCommandsPtr : IntPtr.Zero,
+									ShaderCommandOffsets = hasShaderTable ? (IntPtr) shaderCommandOffsetsPtr : IntPtr.Zero,
+									MaterialCommands = hasMaterialTable ? (IntPtr) materialCommandsPtr : IntPtr.Zero,
+									MaterialCommandOffsets = hasMaterialTable ? (IntPtr) materialCommandOffsetsPtr : IntPtr.Zero,
+									Models = (IntPtr) modelsPtr
+								};
+								NativeMethods.DrawSorter_EmitCommands(
+									(IntPtr) recordsPtr,
+									(IntPtr) orderPtr,
+									numRecords,
+									(IntPtr) (&tables),
+									packInstances,
+									firstPackedInstance,
+									(IntPtr) outCommandsPtr,
+									(uint) outCommands.Length,
+									(IntPtr) (&numCommands)
+								).ThrowOnFailure();
+							}
+						}
+					}
+				}
+			}
+			return numCommands;
+		}
+	}
+}
@@ -0,0 +1,221 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:31 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to the native frustum culler (FrustumCuller in RenderingNative): bounding spheres are tested against the six planes
+	/// of a camera's view frustum (four at a time), and the indices of those at least partially inside are written out in ascending order.
+	/// </summary>
+	internal static unsafe class FrustumCuller {
+		public const int NUM_FRUSTUM_PLANES = 6;
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct BoundingSphere {
+			public float X;
+			public float Y;
+			public float Z;
+			public float Radius;
+
+			public BoundingSphere(Vector3 center, float radius) {
+				X = center.X;
+				Y = center.Y;
+				Z = center.Z;
+				Radius = radius;
+			}
+		}
+
+		/// <summary>
+		/// The left, right, bottom, top, near and far planes of a view frustum, each as a unit normal facing in to the frustum followed
+		/// by its distance from the origin.
+		/// </summary>
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct FrustumPlanes {
+			private fixed float planes[NUM_FRUSTUM_PLANES * 4];
+		}
+
+		/// <summary>
+		/// Creates the frustum of the given (untransposed) view * projection matrix.
+		/// </summary>
+		public static FrustumPlanes CreateFrustum(Matrix viewProjMat) {
+			FrustumPlanes result;
+			NativeMethods.FrustumCuller_CreateFrustum((IntPtr) (&viewProjMat), (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Creates the frustum of the given (untransposed) light view * projection matrix, extended back towards the light so that
+		/// casters between the light and its near plane are kept.
+		/// </summary>
+		public static FrustumPlanes CreateShadowCasterFrustum(Matrix lightViewProjMat) {
+			FrustumPlanes result;
+			NativeMethods.FrustumCuller_CreateShadowCasterFrustum((IntPtr) (&lightViewProjMat), (IntPtr) (&result)).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Creates the frustum of the given (untransposed) receiving camera's view * projection matrix, pushed back against
+		/// <paramref name="lightDirection"/> so that it contains every caster whose shadow (up to <paramref name="shadowLength"/> long)
+		/// may fall in to the camera's view. Only valid for directional lights, which cast every shadow the same way.
+		/// </summary>
+		public static FrustumPlanes CreateShadowReceiverFrustum(Matrix receiverViewProjMat, Vector3 lightDirection, float shadowLength) {
+			Assure.GreaterThanOrEqualTo(shadowLength, 0f, "Shadow length must not be negative.");
+			lightDirection = lightDirection.ToUnit();
+			FrustumPlanes result;
+			NativeMethods.FrustumCuller_CreateShadowReceiverFrustum(
+				(IntPtr) (&receiverViewProjMat),
+				(IntPtr) (&lightDirection),
+				shadowLength,
+				(IntPtr) (&result)
+			).ThrowOnFailure();
+			return result;
+		}
+
+		/// <summary>
+		/// Writes the indices of the first <paramref name="numSpheres"/> spheres that are at least partially inside the
+		/// <paramref name="frustum"/> to <paramref name="outVisibleIndices"/>, and returns how many were written.
+		/// </summary>
+		public static uint CullSpheres(FrustumPlanes frustum, BoundingSphere[] spheres, uint numSpheres, uint[] outVisibleIndices) {
+			Assure.NotNull(spheres);
+			Assure.NotNull(outVisibleIndices);
+			Assure.LessThanOrEqualTo(numSpheres, spheres.Length);
+			Assure.LessThanOrEqualTo(numSpheres, outVisibleIndices.Length);
+			if (numSpheres == 0U) return 0U;
+
+			uint numVisible;
+			fixed (BoundingSphere* spheresPtr = spheres) {
+				fixed (uint* visibleIndicesPtr = outVisibleIndices) {
+					NativeMethods.FrustumCuller_CullSpheres(
+						(IntPtr) (&frustum),
+						(IntPtr) spheresPtr,
+						numSpheres,
+						(IntPtr) visibleIndicesPtr,
+						(IntPtr) (&numVisible)
+					).ThrowOnFailure();
+				}
+			}
+			return numVisible;
+		}
+
+		/// <summary>
+		/// Places <c>modelBounds[modelIndices[i]]</c> in the world with <c>transforms[i]</c> for each of the first
+		/// <paramref name="numInstances"/> instances, and culls the results as <see cref="CullSpheres"/> does.
+		/// </summary>
+		public static uint CullInstances(FrustumPlanes frustum, BoundingSphere[] modelBounds, Transform[] transforms, uint[] modelIndices,
+			uint numInstances, uint[] outVisibleIndices) {
+			Assure.NotNull(modelBounds);
+			Assure.NotNull(transforms);
+			Assure.NotNull(modelIndices);
+			Assure.NotNull(outVisibleIndices);
+			Assure.LessThanOrEqualTo(numInstances, transforms.Length);
+			Assure.LessThanOrEqualTo(numInstances, modelIndices.Length);
+			Assure.LessThanOrEqualTo(numInstances, outVisibleIndices.Length);
+			if (numInstances == 0U) return 0U;
+
+			uint numVisible;
+			fixed (BoundingSphere* modelBoundsPtr = modelBounds) {
+				fixed (Transform* transformsPtr = transforms) {
+					fixed (uint* modelIndicesPtr = modelIndices) {
+						fixed (uint* visibleIndicesPtr = outVisibleIndices) {
+							NativeMethods.FrustumCuller_CullInstances(
+								(IntPtr) (&frustum),
+								(IntPtr) modelBoundsPtr,
+								(uint) modelBounds.Length,
+								(IntPtr) transformsPtr,
+								(IntPtr) modelIndicesPtr,
+								numInstances,
+								(IntPtr) visibleIndicesPtr,
+								(IntPtr) (&numVisible)
+							).ThrowOnFailure();
+						}
+					}
+				}
+			}
+			return numVisible;
+		}
+
+		/// <summary>
+		/// As <see cref="CullInstances"/>, but against a <paramref name="casterFrustum"/> from <see cref="CreateShadowCasterFrustum"/>
+		/// and then (if one is given) a <paramref name="receiverFrustum"/> from <see cref="CreateShadowReceiverFrustum"/>, so that only
+		/// instances that may cast a visible shadow are kept.
+		/// </summary>
+		public static uint CullShadowCasters(FrustumPlanes casterFrustum, FrustumPlanes? receiverFrustum, BoundingSphere[] modelBounds,
+			Transform[] transforms, uint[] modelIndices, uint numInstances, uint[] outVisibleIndices) {
+			Assure.NotNull(modelBounds);
+			Assure.NotNull(transforms);
+			Assure.NotNull(modelIndices);
+			Assure.NotNull(outVisibleIndices);
+			Assure.LessThanOrEqualTo(numInstances, transforms.Length);
+			Assure.LessThanOrEqualTo(numInstances, modelIndices.Length);
+			Assure.LessThanOrEqualTo(numInstances, outVisibleIndices.Length);
+			if (numInstances == 0U) return 0U;
+
+			FrustumPlanes receiverFrustumValue = receiverFrustum.GetValueOrDefault();
+			uint numVisible;
+			fixed (BoundingSphere* modelBoundsPtr = modelBounds) {
+				fixed (Transform* transformsPtr = transforms) {
+					fixed (uint* modelIndicesPtr = modelIndices) {
+						fixed (uint* visibleIndicesPtr = outVisibleIndices) {
+							NativeMethods.FrustumCuller_CullShadowCasters(
+								(IntPtr) (&casterFrustum),
+								receiverFrustum.HasValue ? (IntPtr) (&receiverFrustumValue) : IntPtr.Zero,
+								(IntPtr) modelBoundsPtr,
+								(uint) modelBounds.Length,
+								(IntPtr) transformsPtr,
+								(IntPtr) modelIndicesPtr,
+								numInstances,
+								(IntPtr) visibleIndicesPtr,
+								(IntPtr) (&numVisible)
+							).ThrowOnFailure();
+						}
+					}
+				}
+			}
+			return numVisible;
+		}
+
+		/// <summary>
+		/// Finds a bounding sphere for each model in a vertex position list, where model <c>i</c> is made of the next
+		/// <c>vertexCounts[i]</c> positions. Each sphere is centred on the middle of its model's axis-aligned bounds.
+		/// </summary>
+		public static BoundingSphere[] CalculateModelBounds(Vector3[] positions, IList<uint> vertexCounts) {
+			Assure.NotNull(positions);
+			Assure.NotNull(vertexCounts);
+			BoundingSphere[] result = new BoundingSphere[vertexCounts.Count];
+
+			int firstVertex = 0;
+			for (int m = 0; m < vertexCounts.Count; ++m) {
+				int endVertex = firstVertex + (int) vertexCounts[m];
+				Assure.LessThanOrEqualTo(endVertex, positions.Length, "Vertex counts exceed the number of positions.");
+
+				float minX = Single.MaxValue, minY = Single.MaxValue, minZ = Single.MaxValue;
+				float maxX = Single.MinValue, maxY = Single.MinValue, maxZ = Single.MinValue;
+				for (int v = firstVertex; v < endVertex; ++v) {
+					Vector3 position = positions[v];
+					minX = Math.Min(minX, position.X);
+					minY = Math.Min(minY, position.Y);
+					minZ = Math.Min(minZ, position.Z);
+					maxX = Math.Max(maxX, position.X);
+					maxY = Math.Max(maxY, position.Y);
+					maxZ = Math.Max(maxZ, position.Z);
+				}
+
+				Vector3 center = new Vector3((minX + maxX) * 0.5f, (minY + maxY) * 0.5f, (minZ + maxZ) * 0.5f);
+				float radiusSq = 0f;
+				for (int v = firstVertex; v < endVertex; ++v) {
+					radiusSq = Math.Max(radiusSq, Vector3.DistanceSquared(positions[v], center));
+				}
+				result[m] = new BoundingSphere(center, (float) Math.Sqrt(radiusSq));
+
+				firstVertex = endVertex;
+			}
+
+			return result;
+		}
+	}
+}
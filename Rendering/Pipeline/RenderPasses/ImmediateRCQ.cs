@@ -10,39 +10,31 @@ using Ophidian.Losgap.Interop;
 
 namespace Ophidian.Losgap.Rendering {
 	internal sealed class ImmediateRCQ : RenderCommandQueue {
-		public override unsafe void Flush() {
+		public override void Flush() {
 			uint offset = 0U;
-			bool success;
 
 			for (int i = 0; i < DeferredActions.Count; i++) {
 				KeyValuePair<uint, Action> curAction = DeferredActions[i];
 
-				char* failReason = stackalloc char[InteropUtils.MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
-				success = NativeMethods.RenderPassManager_FlushInstructions(
-					(IntPtr) failReason,
+				NativeMethods.RenderPassManager_FlushCompactInstructions(
 					RenderingModule.DeviceContext,
-					RenderCommandList.AlignedPointer + (int) offset * sizeof(RenderCommand),
+					CommandStream.AlignedPointer + (int) offset,
 					curAction.Key - offset
-				);
-				if (!success) throw new NativeOperationFailedException(Marshal.PtrToStringUni((IntPtr) failReason));
+				).ThrowOnFailure();
 
 				offset = curAction.Key;
 				curAction.Value();
 			}
 
-			char* failReason2 = stackalloc char[InteropUtils.MAX_INTEROP_FAIL_REASON_STRING_LENGTH + 1];
-			success = NativeMethods.RenderPassManager_FlushInstructions(
-				(IntPtr) failReason2,
+			NativeMethods.RenderPassManager_FlushCompactInstructions(
 				RenderingModule.DeviceContext,
-				RenderCommandList.AlignedPointer + (int) offset * sizeof(RenderCommand),
-				CurListIndex - offset
-			);
-			if (!success) throw new NativeOperationFailedException(Marshal.PtrToStringUni((IntPtr) failReason2));
+				CommandStream.AlignedPointer + (int) offset,
+				CurStreamOffset - offset
+			).ThrowOnFailure();
 
-			CurListIndex = 0U;
-			DeferredActions.Clear();
+			ClearStream();
 
-			RenderCommandTempMemPool.GetLocalPool().FreeAll();
+			FrameArena.Reset();
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:52 by Ben Bowen
+
+using System;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to the native instance matrix writer (InstanceMatrixWriter in RenderingNative): transforms are turned in to the
+	/// transposed matrices that instance buffers hold (as <see cref="Transform.AsMatrixTransposed"/>), four at a time, and written
+	/// straight to wherever the caller points. Writes to disjoint ranges of the same destination may run in parallel.
+	/// </summary>
+	internal static unsafe class InstanceMatrixWriter {
+		/// <summary>
+		/// Writes the matrix of <c>transforms[order[i]]</c> to <c>destination[i]</c> for each of the first <paramref name="numInstances"/>
+		/// entries in <paramref name="order"/>. <paramref name="destination"/> must have room for <paramref name="numInstances"/> matrices.
+		/// </summary>
+		public static void WriteTransposedMatrices(Transform[] transforms, uint[] order, uint numInstances, Matrix* destination) {
+			Assure.NotNull(transforms);
+			Assure.NotNull(order);
+			Assure.LessThanOrEqualTo(numInstances, order.Length);
+			if (numInstances == 0U) return;
+			Assure.NotEqual((IntPtr) destination, IntPtr.Zero, "Destination must not be null.");
+
+			fixed (Transform* transformsPtr = transforms) {
+				fixed (uint* orderPtr = order) {
+					NativeMethods.InstanceMatrixWriter_WriteTransposedMatrices(
+						(IntPtr) transformsPtr,
+						(IntPtr) orderPtr,
+						numInstances,
+						(IntPtr) destination
+					).ThrowOnFailure();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,84 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 01:14 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to the native level of detail selector (LODSelector in RenderingNative): picks which of its model's levels of detail
+	/// (see <see cref="GeometryCacheBuilder{TVertex}.AddModelLOD"/>) each instance is drawn with, from the projected size of its bounding
+	/// sphere on screen.
+	/// </summary>
+	internal static unsafe class LODSelector {
+		/// <summary>
+		/// How far (as a fraction of the threshold) an instance's screen size must go past the threshold between two levels of detail
+		/// before it switches between them.
+		/// </summary>
+		public const float DEFAULT_HYSTERESIS = 0.1f;
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		private struct LODTable {
+			public IntPtr ModelFirstLODs; // uint*
+			public IntPtr LODMaxScreenSizes; // float*
+			public uint NumModels;
+		}
+
+		/// <summary>
+		/// Picks a level of detail for each of the first <paramref name="numInstances"/> instances (<c>cache.ModelBounds[modelIndices[i]]</c>
+		/// placed with <c>transforms[i]</c>), as seen from <paramref name="viewPosition"/> through a projection whose row 1, column 1 is
+		/// <paramref name="projectionScale"/>. <paramref name="lodStates"/> holds the level (relative to the model's first) each instance
+		/// was last drawn at, and is updated. <c>outDrawRanges[i]</c> is set to the instance's level in the cache's flattened list
+		/// (see <see cref="DrawSorter.GetLODBufferRanges"/>); <paramref name="outDrawRanges"/> may be <paramref name="modelIndices"/>.
+		/// </summary>
+		public static void SelectLODs(GeometryCache cache, Transform[] transforms, uint[] modelIndices, uint numInstances,
+			Vector3 viewPosition, float projectionScale, bool isPerspective, float hysteresis, byte[] lodStates, uint[] outDrawRanges) {
+			Assure.NotNull(cache);
+			Assure.NotNull(cache.ModelBounds, "Levels of detail can only be selected for caches with model bounds.");
+			Assure.NotNull(transforms);
+			Assure.NotNull(modelIndices);
+			Assure.NotNull(lodStates);
+			Assure.NotNull(outDrawRanges);
+			Assure.LessThanOrEqualTo(numInstances, transforms.Length);
+			Assure.LessThanOrEqualTo(numInstances, modelIndices.Length);
+			Assure.LessThanOrEqualTo(numInstances, lodStates.Length);
+			Assure.LessThanOrEqualTo(numInstances, outDrawRanges.Length);
+			if (numInstances == 0U) return;
+
+			fixed (uint* modelFirstLODsPtr = cache.ModelFirstLODs) {
+				fixed (float* lodMaxScreenSizesPtr = cache.LODMaxScreenSizes) {
+					fixed (FrustumCuller.BoundingSphere* modelBoundsPtr = cache.ModelBounds) {
+						fixed (Transform* transformsPtr = transforms) {
+							fixed (uint* modelIndicesPtr = modelIndices) {
+								fixed (byte* lodStatesPtr = lodStates) {
+									fixed (uint* drawRangesPtr = outDrawRanges) {
+										LODTable table = new LODTable {
+											ModelFirstLODs = (IntPtr) modelFirstLODsPtr,
+											LODMaxScreenSizes = (IntPtr) lodMaxScreenSizesPtr,
+											NumModels = cache.NumModels
+										};
+										NativeMethods.LODSelector_SelectLODs(
+											(IntPtr) (&table),
+											(IntPtr) modelBoundsPtr,
+											(IntPtr) transformsPtr,
+											(IntPtr) modelIndicesPtr,
+											numInstances,
+											(IntPtr) (&viewPosition),
+											projectionScale,
+											isPerspective,
+											hysteresis,
+											(IntPtr) lodStatesPtr,
+											(IntPtr) drawRangesPtr
+										).ThrowOnFailure();
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
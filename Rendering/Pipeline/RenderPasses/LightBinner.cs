@@ -0,0 +1,93 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 00:07 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Managed access to the native light binner (LightBinner in RenderingNative): point lights are projected to conservative
+	/// screen-space rectangles (four at a time) and binned in to a grid of screen tiles, giving a compact list of light indices per tile.
+	/// </summary>
+	internal static unsafe class LightBinner {
+		/// <summary>
+		/// The part of the screen a light may touch, from 0 to 1 on each axis starting at the bottom left corner. A light that can not
+		/// touch the screen at all has <see cref="MinX"/> greater than <see cref="MaxX"/>.
+		/// </summary>
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		public struct ScreenRect {
+			public float MinX;
+			public float MinY;
+			public float MaxX;
+			public float MaxY;
+
+			public bool IsEmpty {
+				get {
+					return MinX > MaxX || MinY > MaxY;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Writes the screen rect of each of the first <paramref name="numLights"/> lights to <paramref name="outRects"/>, as seen
+		/// through the given (untransposed) view * projection matrix. Lights that reach behind the camera cover the whole screen.
+		/// </summary>
+		public static void CalculateScreenRects(LightProperties[] lights, uint numLights, Matrix viewProjMat, ScreenRect[] outRects) {
+			Assure.NotNull(lights);
+			Assure.NotNull(outRects);
+			Assure.LessThanOrEqualTo(numLights, lights.Length);
+			Assure.LessThanOrEqualTo(numLights, outRects.Length);
+			if (numLights == 0U) return;
+
+			fixed (LightProperties* lightsPtr = lights) {
+				fixed (ScreenRect* rectsPtr = outRects) {
+					NativeMethods.LightBinner_CalculateScreenRects(
+						(IntPtr) lightsPtr,
+						numLights,
+						(IntPtr) (&viewProjMat),
+						(IntPtr) rectsPtr
+					).ThrowOnFailure();
+				}
+			}
+		}
+
+		/// <summary>
+		/// Bins the first <paramref name="numLights"/> lights in to a <paramref name="numTilesX"/> by <paramref name="numTilesY"/> grid
+		/// of screen tiles, numbered row by row from the bottom left (<c>y * numTilesX + x</c>). The indices of the lights on tile
+		/// <c>t</c> are written in ascending order to <paramref name="outLightIndices"/>, from <c>outTileOffsets[t]</c> up to
+		/// <c>outTileOffsets[t + 1]</c>. Returns the total number of indices written.
+		/// </summary>
+		public static uint BinLights(LightProperties[] lights, uint numLights, Matrix viewProjMat, uint numTilesX, uint numTilesY,
+			uint[] outTileOffsets, uint[] outLightIndices) {
+			Assure.NotNull(lights);
+			Assure.NotNull(outTileOffsets);
+			Assure.NotNull(outLightIndices);
+			Assure.LessThanOrEqualTo(numLights, lights.Length);
+			Assure.GreaterThan(numTilesX, 0U);
+			Assure.GreaterThan(numTilesY, 0U);
+			Assure.LessThanOrEqualTo(numTilesX * numTilesY + 1U, outTileOffsets.Length);
+
+			uint numIndices;
+			fixed (LightProperties* lightsPtr = lights) {
+				fixed (uint* tileOffsetsPtr = outTileOffsets) {
+					fixed (uint* lightIndicesPtr = outLightIndices) {
+						NativeMethods.LightBinner_BinLights(
+							(IntPtr) lightsPtr,
+							numLights,
+							(IntPtr) (&viewProjMat),
+							numTilesX,
+							numTilesY,
+							(IntPtr) tileOffsetsPtr,
+							(IntPtr) lightIndicesPtr,
+							(uint) outLightIndices.Length,
+							(IntPtr) (&numIndices)
+						).ThrowOnFailure();
+					}
+				}
+			}
+			return numIndices;
+		}
+	}
+}
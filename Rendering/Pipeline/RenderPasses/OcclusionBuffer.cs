@@ -0,0 +1,311 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 00:28 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// A low resolution software depth buffer that a set of designated occluder meshes (e.g. level walls and terrain) are drawn in to on
+	/// the CPU each frame, so that render passes can skip instances that are entirely hidden behind them before queueing any draws
+	/// (see <see cref="DLGeometryPass.OcclusionBuffer"/> and <see cref="ShadowPass.OcclusionBuffer"/>). Rasterisation and testing happen
+	/// natively (OcclusionCuller in RenderingNative) and are deterministic.
+	/// </summary>
+	/// <remarks>
+	/// Occluders should be simple, closed and slightly smaller than the geometry they stand in for. Coverage is inner-conservative: a
+	/// pixel is only covered when it is entirely inside an occluder's outline (triangles that share an edge are joined up across it).
+	/// Each render pass needs its own buffer, as the buffer holds the depth seen from that pass's camera.
+	/// </remarks>
+	public sealed unsafe class OcclusionBuffer : IDisposable {
+		/// <summary>
+		/// The width and height of an occlusion buffer must be a multiple of this.
+		/// </summary>
+		public const uint TILE_SIZE = 16U;
+		private const long BUFFER_ALIGNMENT = 16L;
+		private readonly object instanceMutationLock = new object();
+		private readonly List<Vector3> occluderVertices = new List<Vector3>();
+		private readonly List<uint> occluderIndices = new List<uint>();
+		private readonly AlignedAllocation<float> depthAlloc;
+		private readonly AlignedAllocation<float> hiZAlloc;
+		private readonly NativeBuffer nativeBuffer;
+		private Vector3[] occluderVertexArr = new Vector3[0];
+		private uint[] occluderIndexArr = new uint[0];
+		private uint[] occluderNeighbourArr = new uint[0];
+		private bool occludersChanged = false;
+		private Transform occluderTransform = Transform.DEFAULT_TRANSFORM;
+		private Matrix rasterizedViewProjMat;
+		private bool isRasterized = false;
+		private bool isDisposed = false;
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		private struct NativeBuffer {
+			public IntPtr DepthArr;
+			public IntPtr HiZArr;
+			public uint Width;
+			public uint Height;
+		}
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		internal struct OcclusionBox {
+			public float MinX;
+			public float MinY;
+			public float MinZ;
+			public float MaxX;
+			public float MaxY;
+			public float MaxZ;
+
+			public OcclusionBox(Vector3 min, Vector3 max) {
+				MinX = min.X;
+				MinY = min.Y;
+				MinZ = min.Z;
+				MaxX = max.X;
+				MaxY = max.Y;
+				MaxZ = max.Z;
+			}
+		}
+
+		/// <summary>
+		/// The width of the buffer, in pixels.
+		/// </summary>
+		public uint Width {
+			get {
+				return nativeBuffer.Width;
+			}
+		}
+
+		/// <summary>
+		/// The height of the buffer, in pixels.
+		/// </summary>
+		public uint Height {
+			get {
+				return nativeBuffer.Height;
+			}
+		}
+
+		/// <summary>
+		/// A transform applied to every occluder (after the one it was added with) when the buffer is next drawn, for occluders that all
+		/// move together, such as a level that tilts as a whole. Defaults to <see cref="Transform.DEFAULT_TRANSFORM"/>.
+		/// </summary>
+		public Transform OccluderTransform {
+			get {
+				lock (instanceMutationLock) {
+					return occluderTransform;
+				}
+			}
+			set {
+				lock (instanceMutationLock) {
+					occluderTransform = value;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Whether or not this buffer has been disposed.
+		/// </summary>
+		public bool IsDisposed {
+			get {
+				lock (instanceMutationLock) {
+					return isDisposed;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Creates a new, empty occlusion buffer. Low resolutions (e.g. 256x128) are usually plenty: the buffer only needs to be fine
+		/// enough to hide whole instances.
+		/// </summary>
+		/// <param name="width">The width of the buffer, in pixels. Must be a non-zero multiple of <see cref="TILE_SIZE"/>.</param>
+		/// <param name="height">The height of the buffer, in pixels. Must be a non-zero multiple of <see cref="TILE_SIZE"/>.</param>
+		public OcclusionBuffer(uint width, uint height) {
+			if (width == 0U || width % TILE_SIZE != 0U) throw new ArgumentOutOfRangeException("width", "Width must be a non-zero multiple of " + TILE_SIZE + ".");
+			if (height == 0U || height % TILE_SIZE != 0U) throw new ArgumentOutOfRangeException("height", "Height must be a non-zero multiple of " + TILE_SIZE + ".");
+
+			uint hiZLength;
+			NativeMethods.OcclusionCuller_GetHiZLength(width, height, (IntPtr) (&hiZLength)).ThrowOnFailure();
+			depthAlloc = AlignedAllocation<float>.AllocArray(BUFFER_ALIGNMENT, width * height);
+			hiZAlloc = AlignedAllocation<float>.AllocArray(BUFFER_ALIGNMENT, hiZLength);
+			nativeBuffer = new NativeBuffer {
+				DepthArr = depthAlloc.AlignedPointer,
+				HiZArr = hiZAlloc.AlignedPointer,
+				Width = width,
+				Height = height
+			};
+		}
+
+		/// <summary>
+		/// Adds an occluder mesh, given as world-space triangles (three indices in to <paramref name="positions"/> each).
+		/// </summary>
+		public void AddOccluder(IList<Vector3> positions, IList<uint> indices) {
+			AddOccluder(positions, indices, Transform.DEFAULT_TRANSFORM);
+		}
+
+		/// <summary>
+		/// Adds an occluder mesh, given as model-space triangles (three indices in to <paramref name="positions"/> each) placed in the
+		/// world with <paramref name="transform"/>.
+		/// </summary>
+		public void AddOccluder(IList<Vector3> positions, IList<uint> indices, Transform transform) {
+			Assure.NotNull(positions);
+			Assure.NotNull(indices);
+			if (indices.Count % 3 != 0) throw new ArgumentException("Occluder index count must be a multiple of 3.", "indices");
+			for (int i = 0; i < indices.Count; ++i) {
+				if (indices[i] >= positions.Count) throw new ArgumentException("Occluder index " + indices[i] + " is out of range.", "indices");
+			}
+
+			lock (instanceMutationLock) {
+				uint firstVertex = (uint) occluderVertices.Count;
+				for (int v = 0; v < positions.Count; ++v) occluderVertices.Add(positions[v] * transform);
+				for (int i = 0; i < indices.Count; ++i) occluderIndices.Add(firstVertex + indices[i]);
+				occludersChanged = true;
+			}
+		}
+
+		/// <summary>
+		/// Removes every occluder mesh. Nothing will be culled by this buffer until more are added.
+		/// </summary>
+		public void ClearOccluders() {
+			lock (instanceMutationLock) {
+				occluderVertices.Clear();
+				occluderIndices.Clear();
+				occludersChanged = true;
+			}
+		}
+
+		/// <summary>
+		/// Disposes the buffer, releasing the manually-managed memory that it contains.
+		/// </summary>
+		public void Dispose() {
+			lock (instanceMutationLock) {
+				if (isDisposed) return;
+				isDisposed = true;
+				depthAlloc.Dispose();
+				hiZAlloc.Dispose();
+			}
+		}
+
+		/// <summary>
+		/// Redraws the occluders as seen through the given (untransposed) view * projection matrix. Called once per frame by the owning
+		/// render pass, before any <see cref="CullInstances"/> calls (which are then made against the same matrix).
+		/// </summary>
+		internal void Rasterize(Matrix viewProjMat) {
+			lock (instanceMutationLock) {
+				if (isDisposed) throw new ObjectDisposedException(GetType().Name);
+				if (occludersChanged) {
+					occluderVertexArr = occluderVertices.ToArray();
+					occluderIndexArr = occluderIndices.ToArray();
+					occluderNeighbourArr = new uint[occluderIndexArr.Length];
+					fixed (Vector3* verticesPtr = occluderVertexArr) {
+						fixed (uint* indicesPtr = occluderIndexArr) {
+							fixed (uint* neighboursPtr = occluderNeighbourArr) {
+								NativeMethods.OcclusionCuller_FindEdgeNeighbours(
+									(IntPtr) verticesPtr,
+									(uint) occluderVertexArr.Length,
+									(IntPtr) indicesPtr,
+									(uint) occluderIndexArr.Length,
+									(IntPtr) neighboursPtr
+								).ThrowOnFailure();
+							}
+						}
+					}
+					occludersChanged = false;
+				}
+
+				NativeBuffer buffer = nativeBuffer;
+				Matrix occluderViewProjMat = occluderTransform.AsMatrix * viewProjMat;
+				fixed (Vector3* verticesPtr = occluderVertexArr) {
+					fixed (uint* indicesPtr = occluderIndexArr) {
+						fixed (uint* neighboursPtr = occluderNeighbourArr) {
+							NativeMethods.OcclusionCuller_RasterizeOccluders(
+								(IntPtr) (&buffer),
+								(IntPtr) (&occluderViewProjMat),
+								(IntPtr) verticesPtr,
+								(uint) occluderVertexArr.Length,
+								(IntPtr) indicesPtr,
+								(IntPtr) neighboursPtr,
+								(uint) occluderIndexArr.Length
+							).ThrowOnFailure();
+						}
+					}
+				}
+				rasterizedViewProjMat = viewProjMat;
+				isRasterized = true;
+			}
+		}
+
+		/// <summary>
+		/// Sets bit <c>i</c> of <paramref name="outVisibilityBits"/> (32 to a word) when <c>boxes[i]</c> may be visible, and clears it when
+		/// the box is entirely hidden behind the occluders drawn by the last <see cref="Rasterize"/> (or entirely off screen).
+		/// </summary>
+		/// <remarks>
+		/// May be called from several threads at once, but not at the same time as <see cref="Rasterize"/>.
+		/// </remarks>
+		internal void TestBoxes(OcclusionBox[] boxes, uint numBoxes, uint[] outVisibilityBits) {
+			Assure.NotNull(boxes);
+			Assure.NotNull(outVisibilityBits);
+			Assure.LessThanOrEqualTo(numBoxes, boxes.Length);
+			Assure.LessThanOrEqualTo((numBoxes + 31U) >> 5, outVisibilityBits.Length);
+			Assure.True(isRasterized, "Occlusion buffer must be rasterized before it is tested against.");
+
+			NativeBuffer buffer = nativeBuffer;
+			Matrix viewProjMat = rasterizedViewProjMat;
+			fixed (OcclusionBox* boxesPtr = boxes) {
+				fixed (uint* visibilityBitsPtr = outVisibilityBits) {
+					NativeMethods.OcclusionCuller_TestBoxes(
+						(IntPtr) (&buffer),
+						(IntPtr) (&viewProjMat),
+						(IntPtr) boxesPtr,
+						numBoxes,
+						(IntPtr) visibilityBitsPtr
+					).ThrowOnFailure();
+				}
+			}
+		}
+
+		/// <summary>
+		/// Places <c>modelBounds[modelIndices[i]]</c> in the world with <c>transforms[i]</c> for each of the first
+		/// <paramref name="numInstances"/> instances, tests the box around each as <see cref="TestBoxes"/> does, and writes the indices of
+		/// those that may be visible to <paramref name="outVisibleIndices"/> in ascending order. Returns how many were written.
+		/// </summary>
+		/// <remarks>
+		/// May be called from several threads at once, but not at the same time as <see cref="Rasterize"/>.
+		/// </remarks>
+		internal uint CullInstances(FrustumCuller.BoundingSphere[] modelBounds, Transform[] transforms, uint[] modelIndices,
+			uint numInstances, uint[] outVisibleIndices) {
+			Assure.NotNull(modelBounds);
+			Assure.NotNull(transforms);
+			Assure.NotNull(modelIndices);
+			Assure.NotNull(outVisibleIndices);
+			Assure.LessThanOrEqualTo(numInstances, transforms.Length);
+			Assure.LessThanOrEqualTo(numInstances, modelIndices.Length);
+			Assure.LessThanOrEqualTo(numInstances, outVisibleIndices.Length);
+			Assure.True(isRasterized, "Occlusion buffer must be rasterized before it is tested against.");
+			if (numInstances == 0U) return 0U;
+
+			NativeBuffer buffer = nativeBuffer;
+			Matrix viewProjMat = rasterizedViewProjMat;
+			uint numVisible;
+			fixed (FrustumCuller.BoundingSphere* modelBoundsPtr = modelBounds) {
+				fixed (Transform* transformsPtr = transforms) {
+					fixed (uint* modelIndicesPtr = modelIndices) {
+						fixed (uint* visibleIndicesPtr = outVisibleIndices) {
+							NativeMethods.OcclusionCuller_CullInstances(
+								(IntPtr) (&buffer),
+								(IntPtr) (&viewProjMat),
+								(IntPtr) modelBoundsPtr,
+								(uint) modelBounds.Length,
+								(IntPtr) transformsPtr,
+								(IntPtr) modelIndicesPtr,
+								numInstances,
+								(IntPtr) visibleIndicesPtr,
+								(IntPtr) (&numVisible)
+							).ThrowOnFailure();
+						}
+					}
+				}
+			}
+			return numVisible;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:16 by Ben Bowen
+
+using System;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Captures every render command flushed to the graphics API (and every command list executed) in to a file that can be replayed
+	/// later without a device, e.g. to benchmark changes to command translation against real frames.
+	/// </summary>
+	/// <remarks>
+	/// Device objects are written as stable ids, and the memory that commands point to (constant buffer data, resource arrays,
+	/// viewports) is copied in to the capture. While capturing, parallel flushes are serialised, so frame timings will suffer.
+	/// </remarks>
+	public static class RenderCapture {
+		private static bool isCapturing;
+
+		/// <summary>
+		/// Whether a capture started with <see cref="Begin"/> is in progress.
+		/// </summary>
+		public static bool IsCapturing {
+			get {
+				return isCapturing;
+			}
+		}
+
+		/// <summary>
+		/// Starts capturing all subsequently flushed render commands to the given file. Best called between frames.
+		/// </summary>
+		/// <param name="captureFilePath">The file to write to. Any existing file is overwritten.</param>
+		public static void Begin(string captureFilePath) {
+			Assure.NotNull(captureFilePath);
+			InteropUtils.CallNative(
+				NativeMethods.RenderCommandCapture_BeginCapture,
+				captureFilePath
+			).ThrowOnFailure();
+			isCapturing = true;
+		}
+
+		/// <summary>
+		/// Stops the capture started with <see cref="Begin"/> and flushes it to disk.
+		/// </summary>
+		public static void End() {
+			InteropUtils.CallNative(
+				NativeMethods.RenderCommandCapture_EndCapture
+			).ThrowOnFailure();
+			isCapturing = false;
+		}
+
+		/// <summary>
+		/// Replays a capture through the native command translator on to stand-in device contexts that only count what they are asked
+		/// to do. No device is required.
+		/// </summary>
+		/// <param name="captureFilePath">The capture to replay.</param>
+		/// <param name="numRepetitions">How many times to replay the whole capture (e.g. to get a stable timing).</param>
+		public static unsafe RenderCaptureReplayResult ReplayOnCountingContexts(string captureFilePath, uint numRepetitions = 1U) {
+			Assure.NotNull(captureFilePath);
+			RenderCaptureReplayResult result;
+			InteropUtils.CallNative(
+				NativeMethods.RenderCommandReplay_ReplayOnCountingContexts,
+				captureFilePath,
+				numRepetitions,
+				(IntPtr) (&result)
+			).ThrowOnFailure();
+			return result;
+		}
+	}
+}
\ No newline at end of file
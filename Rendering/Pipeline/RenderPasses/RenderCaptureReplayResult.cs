@@ -0,0 +1,33 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:18 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// The outcome of replaying a render capture with <see cref="RenderCapture.ReplayOnCountingContexts"/>. Every count is the total
+	/// over all captured device contexts and all repetitions.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+	public struct RenderCaptureReplayResult {
+		public readonly uint NumContexts;
+		public readonly ulong NumCommands;
+		public readonly ulong NumSkippedCommands;
+		public readonly ulong ReplayNanoseconds;
+		public readonly ulong NumContextCalls;
+		public readonly ulong NumDrawCalls;
+		public readonly ulong NumInstancesDrawn;
+		public readonly ulong NumMaps;
+		public readonly ulong NumCommandListsFinished;
+		public readonly ulong NumCommandListsExecuted;
+		public readonly ulong NumPresents;
+
+		public override string ToString() {
+			return NumCommands + " commands (" + NumSkippedCommands + " skipped) on " + NumContexts + " contexts in "
+				+ (ReplayNanoseconds / 1000000d) + "ms: " + NumContextCalls + " context calls, " + NumDrawCalls + " draw calls";
+		}
+	}
+}
\ No newline at end of file
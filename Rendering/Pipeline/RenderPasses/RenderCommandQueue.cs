@@ -12,98 +12,113 @@ using Ophidian.Losgap.Interop;
 
 namespace Ophidian.Losgap.Rendering {
 	internal abstract class RenderCommandQueue { // Assumed to be thread-local
-		protected const uint INITIAL_LIST_SIZE = 32U;
-		protected const uint LIST_SIZE_INCREMENT = 50U;
-		protected const long LIST_ALIGNMENT = 7L; // TODO see if misalignment is beneficial
+		protected const uint INITIAL_STREAM_SIZE_BYTES = 1024U;
+		protected const uint RESERVED_SLOT_SIZE_BYTES = CompactCommandStream.MAX_ENCODED_SIZE_BYTES;
 		protected readonly List<KeyValuePair<uint, Action>> DeferredActions = new List<KeyValuePair<uint, Action>>();
-		protected AlignedAllocation<RenderCommand> RenderCommandList = AlignedAllocation<RenderCommand>.AllocArray(LIST_ALIGNMENT, INITIAL_LIST_SIZE);
-		protected uint CurListLen = INITIAL_LIST_SIZE;
-		protected uint CurListIndex = 0U;
+		protected AlignedAllocation<byte> CommandStream = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, INITIAL_STREAM_SIZE_BYTES);
+		protected uint CurStreamLen = INITIAL_STREAM_SIZE_BYTES;
+		protected uint CurStreamOffset = 0U;
+		private uint numCommandsQueued = 0U;
 
 		public uint NumCommandsQueued {
 			get {
-				return CurListIndex;
+				return numCommandsQueued;
 			}
 		}
 
-		public unsafe string CommandTypeBreakdown {
+		public string CommandTypeBreakdown {
 			get {
-				return Enumerable.Range(0, (int) CurListIndex)
-					.Select(i => ((RenderCommand*) RenderCommandList.AlignedPointer)[i])
-					.Select(command => command.Instruction.ToString())
+				return GetCurrentQueue()
+					.Where(item => !item.IsDeferredAction)
+					.Select(item => item.RenderCommand.Value.Instruction.ToString())
 					.ToStringOfContents();
 			}
 		}
 
-		protected unsafe RenderCommandQueue() {
-			GC.AddMemoryPressure(sizeof(RenderCommand) * INITIAL_LIST_SIZE);
+		protected RenderCommandQueue() {
+			GC.AddMemoryPressure(INITIAL_STREAM_SIZE_BYTES);
 		}
 
-		unsafe ~RenderCommandQueue() {
-			GC.RemoveMemoryPressure(sizeof(RenderCommand) * CurListLen);
-			RenderCommandList.Dispose();
+		~RenderCommandQueue() {
+			GC.RemoveMemoryPressure(CurStreamLen);
+			CommandStream.Dispose();
 		}
 
-		public unsafe void QueueCommand(RenderCommand command) {
-			if (CurListIndex == CurListLen) ResizeList();
-			((RenderCommand*) RenderCommandList.AlignedPointer)[CurListIndex++] = command;
+		public void QueueCommand(RenderCommand command) {
+			if (CurStreamOffset + CompactCommandStream.MAX_ENCODED_SIZE_BYTES > CurStreamLen) ResizeStream();
+			CurStreamOffset = CompactCommandStream.Encode(command, CommandStream.AlignedPointer, CurStreamOffset);
+			++numCommandsQueued;
 		}
 
-		public unsafe void QueueCommand(uint reservedCommandSlot, RenderCommand command) {
-			Assure.LessThan(reservedCommandSlot, CurListIndex, "Reserved command slot is outside the range of the list.");
-			((RenderCommand*) RenderCommandList.AlignedPointer)[reservedCommandSlot] = command;
+		public void QueueCommand(uint reservedCommandSlot, RenderCommand command) {
+			Assure.LessThanOrEqualTo(reservedCommandSlot + RESERVED_SLOT_SIZE_BYTES, CurStreamOffset, "Reserved command slot is outside the range of the stream.");
+			uint commandEnd = CompactCommandStream.Encode(command, CommandStream.AlignedPointer, reservedCommandSlot);
+			uint slotEnd = reservedCommandSlot + RESERVED_SLOT_SIZE_BYTES;
+			if (commandEnd < slotEnd) CompactCommandStream.EncodeFiller(CommandStream.AlignedPointer, commandEnd, slotEnd - commandEnd);
 		}
 
 		public void QueueAction(Action action) {
-			DeferredActions.Add(new KeyValuePair<uint, Action>(CurListIndex, action));
+			DeferredActions.Add(new KeyValuePair<uint, Action>(CurStreamOffset, action));
 		}
 
+		/// <summary>
+		/// Reserves space for a single command to be written later with <see cref="QueueCommand(uint, RenderCommand)"/>. Until then,
+		/// the slot holds a <see cref="RenderCommandInstruction.NoOperation"/>.
+		/// </summary>
+		/// <returns>The byte offset of the reserved slot in the command stream.</returns>
 		public uint ReserveCommandSlot() {
-			if (CurListIndex == CurListLen) ResizeList();
-			uint result = CurListIndex;
-#if DEBUG
-			unsafe {
-				((RenderCommand*) RenderCommandList.AlignedPointer)[result] 
-					= new RenderCommand(RenderCommandInstruction.NoOperation, 12345678, 12345678, 12345678);
-			}
-#endif
-			++CurListIndex;
+			if (CurStreamOffset + RESERVED_SLOT_SIZE_BYTES > CurStreamLen) ResizeStream();
+			uint result = CurStreamOffset;
+			uint noOpEnd = CompactCommandStream.Encode(new RenderCommand(RenderCommandInstruction.NoOperation), CommandStream.AlignedPointer, result);
+			CompactCommandStream.EncodeFiller(CommandStream.AlignedPointer, noOpEnd, result + RESERVED_SLOT_SIZE_BYTES - noOpEnd);
+			CurStreamOffset += RESERVED_SLOT_SIZE_BYTES;
+			++numCommandsQueued;
 			return result;
 		}
 
-		public unsafe RCQItem[] GetCurrentQueue() {
-			RCQItem[] result = new RCQItem[CurListIndex + DeferredActions.Count];
+		public RCQItem[] GetCurrentQueue() {
+			RCQItem[] result = new RCQItem[numCommandsQueued + DeferredActions.Count];
 			int resultIndex = 0;
-			uint queueOffset = 0U;
+			uint streamOffset = 0U;
 
 			for (int i = 0; i < DeferredActions.Count; i++) {
 				KeyValuePair<uint, Action> curAction = DeferredActions[i];
-				while (queueOffset < curAction.Key) {
-					result[resultIndex++] = new RCQItem(((RenderCommand*) RenderCommandList.AlignedPointer)[queueOffset++]);
+				while (streamOffset < curAction.Key) {
+					RenderCommand? command = CompactCommandStream.Decode(CommandStream.AlignedPointer, ref streamOffset);
+					if (command.HasValue) result[resultIndex++] = new RCQItem(command.Value);
 				}
 				result[resultIndex++] = new RCQItem(curAction.Value);
 			}
 
-			while (queueOffset < CurListIndex) {
-				result[resultIndex++] = new RCQItem(((RenderCommand*) RenderCommandList.AlignedPointer)[queueOffset++]);
+			while (streamOffset < CurStreamOffset) {
+				RenderCommand? command = CompactCommandStream.Decode(CommandStream.AlignedPointer, ref streamOffset);
+				if (command.HasValue) result[resultIndex++] = new RCQItem(command.Value);
 			}
 
 			return result;
 		}
 
+		/// <summary>
+		/// Clears the stream after it has been flushed.
+		/// </summary>
+		protected void ClearStream() {
+			CurStreamOffset = 0U;
+			numCommandsQueued = 0U;
+			DeferredActions.Clear();
+		}
+
 		public abstract void Flush();
 
-		private unsafe void ResizeList() {
-			uint newListLen = CurListLen + LIST_SIZE_INCREMENT;
-			GC.RemoveMemoryPressure(sizeof(RenderCommand) * CurListLen);
-			AlignedAllocation<RenderCommand> newListSpace = AlignedAllocation<RenderCommand>.AllocArray(LIST_ALIGNMENT, newListLen);
-			GC.AddMemoryPressure(sizeof(RenderCommand) * CurListLen);
-			UnsafeUtils.MemCopy(RenderCommandList.AlignedPointer, newListSpace.AlignedPointer, (uint) sizeof(RenderCommand) * CurListLen);
-			CurListLen = newListLen;
+		private void ResizeStream() {
+			uint newStreamLen = CurStreamLen * 2U;
+			AlignedAllocation<byte> newStreamSpace = AlignedAllocation<byte>.AllocArray(CompactCommandStream.STREAM_ALIGNMENT, newStreamLen);
+			GC.AddMemoryPressure(newStreamLen - CurStreamLen);
+			UnsafeUtils.MemCopy(CommandStream.AlignedPointer, newStreamSpace.AlignedPointer, CurStreamOffset);
+			CurStreamLen = newStreamLen;
 
-			RenderCommandList.Dispose();
+			CommandStream.Dispose();
 
-			RenderCommandList = newListSpace;
+			CommandStream = newStreamSpace;
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 22:31 by Ben Bowen
+
+using System;
+using System.Collections.Generic;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Encodes <see cref="RenderCommand"/>s in to the compact variable-length stream format that is decoded natively (see
+	/// CompactCommandStream.h for the record layouts). Each record is a 4-byte header holding the instruction and a 24-bit immediate,
+	/// followed only by the operands that instruction actually uses, so most records are 4 to 16 bytes instead of 32.
+	/// </summary>
+	/// <remarks>
+	/// The stream must start at a pointer-aligned address, so that pointer operands are naturally aligned.
+	/// </remarks>
+	internal static unsafe class CompactCommandStream {
+		/// <summary>
+		/// Required alignment of the start of a stream.
+		/// </summary>
+		public const long STREAM_ALIGNMENT = 8L;
+		/// <summary>
+		/// The largest number of bytes any single command (including alignment padding) can encode to.
+		/// </summary>
+		public const uint MAX_ENCODED_SIZE_BYTES = 28U;
+		private const uint OPCODE_MASK = 0xFFU;
+		private const int IMMEDIATE_SHIFT = 8;
+		private const uint MAX_IMMEDIATE = 0xFFFFFFU;
+		private const uint FILLER_FLAG = 0x800000U;
+		private const uint FILLER_LENGTH_MASK = 0x7FFFFFU;
+		private const uint WIDE_FIRST_VERTEX_INDEX = 0x800000U;
+		private const int MIN_NARROW_FIRST_VERTEX_INDEX = -0x7FFFFF;
+		private const int MAX_NARROW_FIRST_VERTEX_INDEX = 0x7FFFFF;
+		private const int SLOT_RANGE_START_SHIFT = 12;
+		private const uint SLOT_RANGE_COUNT_MASK = 0xFFFU;
+
+		/// <summary>
+		/// Writes the given command at <paramref name="streamOffset"/> bytes in to the stream, and returns the offset just past it.
+		/// At least <see cref="MAX_ENCODED_SIZE_BYTES"/> bytes must be available.
+		/// </summary>
+		public static uint Encode(RenderCommand command, IntPtr stream, uint streamOffset) {
+			Assure.Equal(streamOffset & 3U, 0U, "Commands must be written at 4-byte aligned offsets.");
+			byte* cursor = (byte*) stream + streamOffset;
+			uint instruction = (uint) command.Instruction;
+
+			switch (command.Instruction) {
+				case RenderCommandInstruction.DrawIndexedInstanced: {
+					int firstVertexIndex = ArgAsInt(command.Arg1);
+					bool isNarrow = firstVertexIndex >= MIN_NARROW_FIRST_VERTEX_INDEX && firstVertexIndex <= MAX_NARROW_FIRST_VERTEX_INDEX;
+					WriteHeader(ref cursor, instruction, isNarrow ? (uint) firstVertexIndex & MAX_IMMEDIATE : WIDE_FIRST_VERTEX_INDEX);
+					WriteArg(ref cursor, command.Arg2);
+					WriteArg(ref cursor, command.Arg3);
+					if (!isNarrow) WriteUInt(ref cursor, (uint) firstVertexIndex);
+					break;
+				}
+				case RenderCommandInstruction.Draw:
+					WriteHeader(ref cursor, instruction, 0U);
+					WriteUInt(ref cursor, ArgAsUInt(command.Arg1));
+					WriteUInt(ref cursor, ArgAsUInt(command.Arg2));
+					break;
+				case RenderCommandInstruction.VSSetCBuffers:
+				case RenderCommandInstruction.FSSetCBuffers:
+				case RenderCommandInstruction.VSSetSamplers:
+				case RenderCommandInstruction.FSSetSamplers:
+				case RenderCommandInstruction.VSSetResources:
+				case RenderCommandInstruction.FSSetResources: {
+					uint numSlots = ArgAsUInt(command.Arg2);
+					uint startSlot = ArgAsUInt(command.Arg3);
+					Assure.LessThanOrEqualTo(numSlots, SLOT_RANGE_COUNT_MASK, "Too many slots for one command.");
+					Assure.LessThanOrEqualTo(startSlot, MAX_IMMEDIATE >> SLOT_RANGE_START_SHIFT, "Start slot too high.");
+					WriteHeader(ref cursor, instruction, numSlots | (startSlot << SLOT_RANGE_START_SHIFT));
+					WritePointer(ref cursor, stream, command.Arg1);
+					break;
+				}
+				case RenderCommandInstruction.SetInstanceBuffer:
+					WriteHeader(ref cursor, instruction, ArgAsUInt(command.Arg2));
+					WritePointer(ref cursor, stream, command.Arg1);
+					break;
+				case RenderCommandInstruction.SetVertexBuffers:
+				case RenderCommandInstruction.SetRenderTargets:
+					WriteHeader(ref cursor, instruction, ArgAsUInt(command.Arg3));
+					WritePointer(ref cursor, stream, command.Arg1);
+					WritePointer(ref cursor, stream, command.Arg2);
+					break;
+				case RenderCommandInstruction.CBDiscardWrite:
+				case RenderCommandInstruction.BufferWrite:
+					WriteHeader(ref cursor, instruction, 0U);
+					WriteUInt(ref cursor, ArgAsUInt(command.Arg3));
+					WritePointer(ref cursor, stream, command.Arg1);
+					WritePointer(ref cursor, stream, command.Arg2);
+					break;
+				case RenderCommandInstruction.SetPrimitiveTopology:
+					WriteHeader(ref cursor, instruction, ArgAsUInt(command.Arg1));
+					break;
+				case RenderCommandInstruction.NoOperation:
+					WriteHeader(ref cursor, instruction, 0U);
+					break;
+				default:
+					WriteHeader(ref cursor, instruction, 0U);
+					WritePointer(ref cursor, stream, command.Arg1);
+					break;
+			}
+
+			// Round up so that the next header is also 4-byte aligned
+			uint endOffset = (uint) (cursor - (byte*) stream);
+			return (endOffset + 3U) & ~3U;
+		}
+
+		/// <summary>
+		/// Writes a filler record covering exactly <paramref name="numBytes"/> bytes (a multiple of 4, at least 4) that the decoders skip
+		/// over without reporting a command.
+		/// </summary>
+		public static void EncodeFiller(IntPtr stream, uint streamOffset, uint numBytes) {
+			Assure.GreaterThanOrEqualTo(numBytes, 4U, "Filler must cover at least one header.");
+			Assure.Equal(numBytes & 3U, 0U, "Filler must be a multiple of 4 bytes.");
+			byte* cursor = (byte*) stream + streamOffset;
+			WriteHeader(ref cursor, (uint) RenderCommandInstruction.NoOperation, FILLER_FLAG | ((numBytes / 4U) - 1U));
+		}
+
+		/// <summary>
+		/// Reads the record at <paramref name="streamOffset"/> and moves the offset past it. Returns <c>null</c> for filler.
+		/// </summary>
+		public static RenderCommand? Decode(IntPtr stream, ref uint streamOffset) {
+			byte* cursor = (byte*) stream + streamOffset;
+			uint header = ReadUInt(ref cursor);
+			RenderCommandInstruction instruction = (RenderCommandInstruction) (header & OPCODE_MASK);
+			uint immediate = header >> IMMEDIATE_SHIFT;
+			RenderCommand? result;
+
+			switch (instruction) {
+				case RenderCommandInstruction.DrawIndexedInstanced: {
+					ulong arg23 = ReadULong(ref cursor);
+					ulong arg45 = ReadULong(ref cursor);
+					int firstVertexIndex = immediate == WIDE_FIRST_VERTEX_INDEX ? (int) ReadUInt(ref cursor) : ((int) (immediate << IMMEDIATE_SHIFT)) >> IMMEDIATE_SHIFT;
+					result = new RenderCommand(instruction, firstVertexIndex, arg23, arg45);
+					break;
+				}
+				case RenderCommandInstruction.Draw: {
+					int firstVertexIndex = (int) ReadUInt(ref cursor);
+					result = new RenderCommand(instruction, firstVertexIndex, ReadUInt(ref cursor));
+					break;
+				}
+				case RenderCommandInstruction.VSSetCBuffers:
+				case RenderCommandInstruction.FSSetCBuffers:
+				case RenderCommandInstruction.VSSetSamplers:
+				case RenderCommandInstruction.FSSetSamplers:
+				case RenderCommandInstruction.VSSetResources:
+				case RenderCommandInstruction.FSSetResources:
+					result = new RenderCommand(instruction, ReadPointer(ref cursor, stream), immediate & SLOT_RANGE_COUNT_MASK, immediate >> SLOT_RANGE_START_SHIFT);
+					break;
+				case RenderCommandInstruction.SetInstanceBuffer:
+					result = new RenderCommand(instruction, ReadPointer(ref cursor, stream), immediate);
+					break;
+				case RenderCommandInstruction.SetVertexBuffers:
+				case RenderCommandInstruction.SetRenderTargets: {
+					IntPtr arg1 = ReadPointer(ref cursor, stream);
+					result = new RenderCommand(instruction, arg1, ReadPointer(ref cursor, stream), immediate);
+					break;
+				}
+				case RenderCommandInstruction.CBDiscardWrite:
+				case RenderCommandInstruction.BufferWrite: {
+					uint numBytes = ReadUInt(ref cursor);
+					IntPtr arg1 = ReadPointer(ref cursor, stream);
+					result = new RenderCommand(instruction, arg1, ReadPointer(ref cursor, stream), numBytes);
+					break;
+				}
+				case RenderCommandInstruction.SetPrimitiveTopology:
+					result = new RenderCommand(instruction, (int) immediate);
+					break;
+				case RenderCommandInstruction.NoOperation:
+					cursor += (immediate & FILLER_LENGTH_MASK) * 4U;
+					result = (immediate & FILLER_FLAG) == 0U ? new RenderCommand(instruction) : (RenderCommand?) null;
+					break;
+				default:
+					result = new RenderCommand(instruction, ReadPointer(ref cursor, stream));
+					break;
+			}
+
+			streamOffset = ((uint) (cursor - (byte*) stream) + 3U) & ~3U;
+			return result;
+		}
+
+		private static void WriteHeader(ref byte* cursor, uint instruction, uint immediate) {
+			Assure.LessThanOrEqualTo(immediate, MAX_IMMEDIATE, "Immediate operand does not fit in the command header.");
+			WriteUInt(ref cursor, instruction | (immediate << IMMEDIATE_SHIFT));
+		}
+
+		private static void WriteUInt(ref byte* cursor, uint value) {
+			*((uint*) cursor) = value;
+			cursor += sizeof(uint);
+		}
+
+		private static void WriteArg(ref byte* cursor, RenderCommandArgument arg) {
+			WriteUInt(ref cursor, *((uint*) &arg));
+			WriteUInt(ref cursor, *((uint*) &arg + 1));
+		}
+
+		private static void WritePointer(ref byte* cursor, IntPtr stream, RenderCommandArgument arg) {
+			cursor = AlignToPointer(cursor, stream);
+			*((IntPtr*) cursor) = *((IntPtr*) &arg);
+			cursor += IntPtr.Size;
+		}
+
+		private static uint ReadUInt(ref byte* cursor) {
+			uint result = *((uint*) cursor);
+			cursor += sizeof(uint);
+			return result;
+		}
+
+		private static ulong ReadULong(ref byte* cursor) {
+			ulong result = ReadUInt(ref cursor);
+			return result | ((ulong) ReadUInt(ref cursor) << 32);
+		}
+
+		private static IntPtr ReadPointer(ref byte* cursor, IntPtr stream) {
+			cursor = AlignToPointer(cursor, stream);
+			IntPtr result = *((IntPtr*) cursor);
+			cursor += IntPtr.Size;
+			return result;
+		}
+
+		private static byte* AlignToPointer(byte* cursor, IntPtr stream) {
+			long offset = cursor - (byte*) stream;
+			return (byte*) stream + ((offset + IntPtr.Size - 1) & ~(long) (IntPtr.Size - 1));
+		}
+
+		private static uint ArgAsUInt(RenderCommandArgument arg) {
+			return *((uint*) &arg);
+		}
+
+		private static int ArgAsInt(RenderCommandArgument arg) {
+			return *((int*) &arg);
+		}
+	}
+}
@@ -43,7 +43,7 @@ namespace Ophidian.Losgap.Rendering {
 		}
 
 		private static IntPtr AllocAndZeroTemp(uint numBytes) {
-			IntPtr result = RenderCommandTempMemPool.GetLocalPool().Reserve(numBytes);
+			IntPtr result = FrameArena.Reserve(numBytes);
 			UnsafeUtils.ZeroMem(result, numBytes);
 			return result;
 		}
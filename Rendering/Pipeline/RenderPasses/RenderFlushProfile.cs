@@ -0,0 +1,128 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:05 by Ben Bowen
+
+using System;
+using System.Linq;
+using System.Text;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Everything flushed on to one device context since the last reset, as returned by <see cref="RenderFlushProfiler.Snapshot"/>.
+	/// </summary>
+	public struct RenderFlushProfile {
+		/// <summary>
+		/// The counts and CPU time for one kind of render command.
+		/// </summary>
+		public struct InstructionProfile {
+			/// <summary>
+			/// The name of the render instruction, e.g. "SetRSState".
+			/// </summary>
+			public readonly string Instruction;
+			/// <summary>
+			/// The number of commands of this kind that were passed on to the graphics API.
+			/// </summary>
+			public readonly ulong Count;
+			/// <summary>
+			/// The number of commands of this kind that were dropped because they would not have changed the pipeline state.
+			/// </summary>
+			public readonly ulong SkippedCount;
+			/// <summary>
+			/// The CPU time spent passing the <see cref="Count"/> commands on to the graphics API, in nanoseconds.
+			/// </summary>
+			public readonly ulong Nanoseconds;
+
+			internal InstructionProfile(string instruction, ulong count, ulong skippedCount, ulong nanoseconds) {
+				Instruction = instruction;
+				Count = count;
+				SkippedCount = skippedCount;
+				Nanoseconds = nanoseconds;
+			}
+
+			public override string ToString() {
+				return Instruction + ": " + Count + " (" + SkippedCount + " skipped), " + (Nanoseconds / 1000d).ToString("0.#") + "us";
+			}
+		}
+
+		/// <summary>
+		/// True if this profile is for the immediate context, false if it is for a deferred context (i.e. a slave thread).
+		/// </summary>
+		public readonly bool IsImmediateContext;
+		/// <summary>
+		/// The number of times commands were flushed on to the context.
+		/// </summary>
+		public readonly ulong NumFlushes;
+		/// <summary>
+		/// The total number of bytes written to constant buffers.
+		/// </summary>
+		public readonly ulong ConstantBufferBytesWritten;
+		/// <summary>
+		/// The total number of bytes written to other buffers (e.g. instance data).
+		/// </summary>
+		public readonly ulong BufferBytesWritten;
+		private readonly InstructionProfile[] instructionProfiles;
+
+		internal RenderFlushProfile(bool isImmediateContext, ulong numFlushes, ulong constantBufferBytesWritten, ulong bufferBytesWritten,
+			InstructionProfile[] instructionProfiles) {
+			IsImmediateContext = isImmediateContext;
+			NumFlushes = numFlushes;
+			ConstantBufferBytesWritten = constantBufferBytesWritten;
+			BufferBytesWritten = bufferBytesWritten;
+			this.instructionProfiles = instructionProfiles;
+		}
+
+		/// <summary>
+		/// The number of kinds of render command; the range of valid indices for <see cref="GetInstructionProfile"/>.
+		/// </summary>
+		public int NumInstructionProfiles {
+			get {
+				return instructionProfiles.Length;
+			}
+		}
+
+		/// <summary>
+		/// The total number of commands passed on to the graphics API.
+		/// </summary>
+		public ulong TotalCount {
+			get {
+				return instructionProfiles.Aggregate(0UL, (sum, profile) => sum + profile.Count);
+			}
+		}
+
+		/// <summary>
+		/// The total number of commands dropped because they would not have changed the pipeline state.
+		/// </summary>
+		public ulong TotalSkippedCount {
+			get {
+				return instructionProfiles.Aggregate(0UL, (sum, profile) => sum + profile.SkippedCount);
+			}
+		}
+
+		/// <summary>
+		/// Returns the profile for the given kind of render command.
+		/// </summary>
+		/// <param name="index">The instruction index, in [0, <see cref="NumInstructionProfiles"/>).</param>
+		/// <returns>The counts and time for that instruction.</returns>
+		public InstructionProfile GetInstructionProfile(int index) {
+			Assure.BetweenOrEqualTo(index, 0, NumInstructionProfiles - 1, "Invalid instruction index.");
+			return instructionProfiles[index];
+		}
+
+		public override string ToString() {
+			StringBuilder result = new StringBuilder();
+			result.Append(IsImmediateContext ? "Immediate" : "Deferred")
+				.Append(" context: ")
+				.Append(NumFlushes).Append(" flushes, ")
+				.Append(TotalCount).Append(" commands (")
+				.Append(TotalSkippedCount).Append(" skipped), ")
+				.Append(ConstantBufferBytesWritten).Append("B to cbuffers, ")
+				.Append(BufferBytesWritten).Append("B to buffers");
+			foreach (InstructionProfile profile in instructionProfiles
+				.Where(profile => profile.Count > 0UL || profile.SkippedCount > 0UL)
+				.OrderByDescending(profile => profile.Count + profile.SkippedCount)) {
+				result.AppendLine().Append('\t').Append(profile);
+			}
+			return result.ToString();
+		}
+	}
+}
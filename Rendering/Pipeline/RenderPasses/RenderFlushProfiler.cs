@@ -0,0 +1,91 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 19 10 2016 at 23:11 by Ben Bowen
+
+using System;
+using System.Runtime.InteropServices;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// Counts (and times) every render command as it is flushed to the graphics API, separately for each device context, so that
+	/// excessive state changes or buffer writes can be traced without a graphics debugger. Profiling is off until
+	/// <see cref="Enabled"/> is set; while off it costs one check per flush.
+	/// </summary>
+	public static unsafe class RenderFlushProfiler {
+		internal const int NUM_INSTRUCTIONS = (int) RenderCommandInstruction.BufferWrite + 1;
+		private const int MAX_CONTEXTS = 64;
+		private static bool enabled;
+
+		[StructLayout(LayoutKind.Sequential, Pack = (int) InteropUtils.StructPacking.Safe)]
+		internal struct FlushProfileSnapshot {
+			public DeviceContextHandle DeviceContext;
+			public InteropBool IsImmediateContext;
+			public ulong NumFlushes;
+			public fixed ulong InstructionCounts[NUM_INSTRUCTIONS];
+			public fixed ulong SkippedCounts[NUM_INSTRUCTIONS];
+			public fixed ulong InstructionNanoseconds[NUM_INSTRUCTIONS];
+			public ulong CBufferBytesWritten;
+			public ulong BufferBytesWritten;
+		}
+
+		/// <summary>
+		/// Whether render commands are currently being profiled. Off by default.
+		/// </summary>
+		public static bool Enabled {
+			get {
+				return enabled;
+			}
+			set {
+				InteropUtils.CallNative(NativeMethods.FlushProfiler_SetEnabled, (InteropBool) value).ThrowOnFailure();
+				enabled = value;
+			}
+		}
+
+		/// <summary>
+		/// Returns the profile of every device context that has been flushed to while <see cref="Enabled"/>.
+		/// </summary>
+		/// <remarks>
+		/// Must not be called while any render pass is executing (e.g. call it between frames).
+		/// </remarks>
+		/// <param name="resetAfterwards">If true, every returned profile starts again from zero for the next snapshot; use this once per
+		/// frame to get per-frame values.</param>
+		/// <returns>One <see cref="RenderFlushProfile"/> per device context.</returns>
+		public static RenderFlushProfile[] Snapshot(bool resetAfterwards = false) {
+			FlushProfileSnapshot[] snapshotArr = new FlushProfileSnapshot[MAX_CONTEXTS];
+			uint numProfiles;
+			fixed (FlushProfileSnapshot* snapshotArrPtr = snapshotArr) {
+				InteropUtils.CallNative(
+					NativeMethods.FlushProfiler_Snapshot,
+					(IntPtr) snapshotArrPtr,
+					(uint) MAX_CONTEXTS,
+					(InteropBool) resetAfterwards,
+					(IntPtr) (&numProfiles)
+				).ThrowOnFailure();
+
+				RenderFlushProfile[] result = new RenderFlushProfile[Math.Min(numProfiles, (uint) MAX_CONTEXTS)];
+				for (int i = 0; i < result.Length; ++i) result[i] = ToProfile(snapshotArrPtr + i);
+				return result;
+			}
+		}
+
+		internal static RenderFlushProfile ToProfile(FlushProfileSnapshot* snapshot) {
+			RenderFlushProfile.InstructionProfile[] instructionProfiles = new RenderFlushProfile.InstructionProfile[NUM_INSTRUCTIONS];
+			for (int i = 0; i < NUM_INSTRUCTIONS; ++i) {
+				instructionProfiles[i] = new RenderFlushProfile.InstructionProfile(
+					((RenderCommandInstruction) i).ToString(),
+					snapshot->InstructionCounts[i],
+					snapshot->SkippedCounts[i],
+					snapshot->InstructionNanoseconds[i]
+				);
+			}
+			return new RenderFlushProfile(
+				snapshot->IsImmediateContext,
+				snapshot->NumFlushes,
+				snapshot->CBufferBytesWritten,
+				snapshot->BufferBytesWritten,
+				instructionProfiles
+			);
+		}
+	}
+}
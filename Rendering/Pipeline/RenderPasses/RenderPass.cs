@@ -19,7 +19,10 @@ namespace Ophidian.Losgap.Rendering {
 	public abstract class RenderPass : IDisposable {
 		[ThreadStatic]
 		private static RenderCommandQueue threadLocalRCQ;
+		[ThreadStatic]
+		private static StateCommandRecorder threadLocalStateRecorder;
 		private static readonly ConcurrentDictionary<Thread, RenderCommandQueue> rcqMap = new ConcurrentDictionary<Thread, RenderCommandQueue>(); 
+		private static readonly Action resetFrameArenaAct = FrameArena.Reset;
 		/// <summary>
 		/// The name for this render pass.
 		/// </summary>
@@ -197,6 +200,36 @@ namespace Ophidian.Losgap.Rendering {
 			ThreadLocalRCQ.Flush();
 		}
 
+		/// <summary>
+		/// Flush all previously queued commands on every slave thread at once: each thread's commands are recorded on to its deferred
+		/// context in parallel, and the resultant command lists are then executed in a fixed order (the order the slave threads first
+		/// queued a command). Must be called from the master thread after the slaves have finished queueing.
+		/// </summary>
+		/// <remarks>
+		/// This replaces having each slave call <see cref="FlushRenderCommands"/> and then wait on the master to execute its command list.
+		/// Commands queued on the master thread itself are unaffected, and should still be flushed with <see cref="FlushRenderCommands"/>.
+		/// </remarks>
+		/// <param name="pp">The parallelization provider whose slave threads queued the commands. Must not be null.</param>
+		protected static void FlushDeferredRenderCommands(ParallelizationProvider pp) {
+			Assure.NotNull(pp);
+			Assure.Equal(Thread.CurrentThread, LosgapSystem.MasterThread, "Deferred render commands must be flushed from the master thread.");
+			DeferredRCQ.FlushParallel();
+			// The flushed commands' arguments live in each slave's arena, so those can only be reset now
+			pp.InvokeOnAll(resetFrameArenaAct, false);
+			DisposeQueuesOfExitedThreads();
+		}
+
+		private static void DisposeQueuesOfExitedThreads() {
+			// Otherwise every thread that ever queued a command would have its queue kept alive (and flushed) forever
+			foreach (KeyValuePair<Thread, RenderCommandQueue> kvp in rcqMap) {
+				if (kvp.Key.IsAlive) continue;
+				RenderCommandQueue exitedThreadQueue;
+				if (rcqMap.TryRemove(kvp.Key, out exitedThreadQueue) && exitedThreadQueue is DeferredRCQ) {
+					((DeferredRCQ) exitedThreadQueue).Dispose();
+				}
+			}
+		}
+
 		/// <summary>
 		/// Queues a switch to the given shader. Should usually be immediately followed by a call to
 		/// <see cref="QueueShaderResourceUpdate(Ophidian.Losgap.Rendering.Shader)"/> or
@@ -253,6 +286,53 @@ namespace Ophidian.Losgap.Rendering {
 			shader.RCQUpdateResources(ThreadLocalRCQ, resourcePackage);
 		}
 
+		/// <summary>
+		/// Records the commands that <see cref="QueueShaderSwitch"/> would queue in to <paramref name="commandTable"/> (starting at
+		/// <paramref name="tableOffset"/>) instead of queueing them, so that they can be handed to <see cref="DrawSorter"/> as a state table.
+		/// </summary>
+		/// <remarks>
+		/// The recorded commands must be queued on this thread before the end of the frame, as their arguments live in this thread's
+		/// <see cref="FrameArena"/>.
+		/// </remarks>
+		/// <param name="shader">The shader to switch to. Must not be null or disposed.</param>
+		/// <param name="commandTable">The table to write the commands to. Will be grown (or created) if required.</param>
+		/// <param name="tableOffset">The index in to the table to write the first command to.</param>
+		/// <returns>The index in to the table just past the last command written.</returns>
+		[System.Diagnostics.CodeAnalysis.SuppressMessage("Microsoft.Design", "CA1062:Validate arguments of public methods", MessageId = "0",
+			Justification = "The parameter is validated by the assurances.")]
+		protected static uint RecordShaderSwitch(Shader shader, ref RenderCommand[] commandTable, uint tableOffset) {
+			Assure.NotNull(shader);
+			Assure.False(shader.IsDisposed, "Shader was disposed.");
+			if (threadLocalStateRecorder == null) threadLocalStateRecorder = new StateCommandRecorder();
+			shader.RCQSwitchToShader(threadLocalStateRecorder);
+			return threadLocalStateRecorder.TakeCommands(ref commandTable, tableOffset);
+		}
+
+		/// <summary>
+		/// Records the commands that <see cref="QueueShaderResourceUpdate(Shader,ShaderResourcePackage)"/> would queue in to
+		/// <paramref name="commandTable"/> (starting at <paramref name="tableOffset"/>) instead of queueing them, so that they can be handed to
+		/// <see cref="DrawSorter"/> as a state table.
+		/// </summary>
+		/// <remarks>
+		/// The recorded commands must be queued on this thread before the end of the frame, as their arguments live in this thread's
+		/// <see cref="FrameArena"/>.
+		/// </remarks>
+		/// <param name="shader">The shader whose resources should be enabled. Must not be null or disposed.</param>
+		/// <param name="resourcePackage">The resources to set for the given <paramref name="shader"/>. Must not be null.</param>
+		/// <param name="commandTable">The table to write the commands to. Will be grown (or created) if required.</param>
+		/// <param name="tableOffset">The index in to the table to write the first command to.</param>
+		/// <returns>The index in to the table just past the last command written.</returns>
+		[System.Diagnostics.CodeAnalysis.SuppressMessage("Microsoft.Design", "CA1062:Validate arguments of public methods", MessageId = "0",
+			Justification = "The parameter is validated by the assurances.")]
+		protected static uint RecordShaderResourceUpdate(Shader shader, ShaderResourcePackage resourcePackage, ref RenderCommand[] commandTable, uint tableOffset) {
+			Assure.NotNull(shader);
+			Assure.False(shader.IsDisposed, "Shader was disposed.");
+			Assure.NotNull(resourcePackage);
+			if (threadLocalStateRecorder == null) threadLocalStateRecorder = new StateCommandRecorder();
+			shader.RCQUpdateResources(threadLocalStateRecorder, resourcePackage);
+			return threadLocalStateRecorder.TakeCommands(ref commandTable, tableOffset);
+		}
+
 		/// <summary>
 		/// Completes the pass by presenting the back buffer for the given <paramref name="window"/>. This call is not queued (it is
 		/// enacted immediately). Once the scene has been successfully rendered, this call must be made in order to show the result on the
@@ -11,6 +11,8 @@ using Ophidian.Losgap.Interop;
 namespace Ophidian.Losgap.Rendering {
 	public sealed class ShadowPass : RenderPass {
 		private Camera lightCam;
+		private Camera receiverCam;
+		private OcclusionBuffer occlusionBuffer;
 		private SceneViewport output;
 		private VertexShader shadowVS;
 		private FragmentShader shadowFS;
@@ -24,13 +26,32 @@ namespace Ophidian.Losgap.Rendering {
 		private readonly List<SceneLayer> addedSceneLayers = new List<SceneLayer>();
 
 		private const int INITIAL_TRANSFORM_BUF_LEN = 1;
+		private const int INITIAL_CASTER_KEY_BUF_LEN = 64;
 		private static readonly VertexBufferBuilder<Matrix> gpuInstanceBufferBuilder = BufferFactory.NewVertexBuffer<Matrix>().WithUsage(ResourceUsage.DiscardWrite);
 		private GeometryCache currentCache;
+		private FrustumCuller.FrustumPlanes currentCasterFrustum;
+		private FrustumCuller.FrustumPlanes? currentReceiverFrustum;
+		private ulong[] casterInstanceKeys = new ulong[INITIAL_CASTER_KEY_BUF_LEN];
+		private uint numCasterInstanceKeys;
+		private bool currentInstancesAreIndexed;
+		private OcclusionBuffer currentOcclusionBuffer;
 		private ArraySlice<KeyValuePair<Material, ModelInstanceManager.MIDArray>> currentInstanceData;
 		private SceneLayer[] currentSceneLayers = new SceneLayer[0];
 		private static byte frameNum;
 		[ThreadStatic]
-		private static FastClearList<Transform>[] materialFilteringWorkspace;
+		private static DrawSorter.DrawRecord[] drawRecordWorkspace;
+		[ThreadStatic]
+		private static Transform[] drawTransformWorkspace;
+		[ThreadStatic]
+		private static uint[] drawOrderWorkspace;
+		[ThreadStatic]
+		private static uint[] drawModelWorkspace;
+		[ThreadStatic]
+		private static RenderCommand[] drawCommandWorkspace;
+		[ThreadStatic]
+		private static DrawSorter.ModelBufferRange[] modelRangeWorkspace;
+		[ThreadStatic]
+		private static GeometryCache modelRangeWorkspaceCache;
 		[ThreadStatic]
 		private static Matrix[] instanceConcatWorkspace;
 		[ThreadStatic]
@@ -45,7 +66,7 @@ namespace Ophidian.Losgap.Rendering {
 
 		private readonly Action setUpCacheForLocalThreadAct;
 		private readonly Action<int> renderCacheIterateMatAct;
-		private readonly Action setInstanceBufferAndFlushCommandsAct;
+		private readonly Action setInstanceBufferAct;
 
 		public ShaderResourceView ShadowBufferSRV {
 			get {
@@ -68,6 +89,41 @@ namespace Ophidian.Losgap.Rendering {
 			}
 		}
 
+		/// <summary>
+		/// The camera that sees the shadows (usually the main camera, through <see cref="Output"/>), or null. When set (and the
+		/// <see cref="LightCam"/> is orthographic), instances whose shadow can not fall in to its view are not drawn in to the shadow map.
+		/// </summary>
+		public Camera ReceiverCam {
+			get {
+				lock (InstanceMutationLock) {
+					return receiverCam;
+				}
+			}
+			set {
+				lock (InstanceMutationLock) {
+					receiverCam = value;
+				}
+			}
+		}
+
+		/// <summary>
+		/// A buffer whose occluders are drawn from the <see cref="LightCam"/> each frame, so that casters entirely hidden from the light
+		/// behind them (whose shadows they would cover anyway) are not drawn in to the shadow map; or null to draw every caster. Must not be
+		/// shared with another pass.
+		/// </summary>
+		public OcclusionBuffer OcclusionBuffer {
+			get {
+				lock (InstanceMutationLock) {
+					return occlusionBuffer;
+				}
+			}
+			set {
+				lock (InstanceMutationLock) {
+					occlusionBuffer = value;
+				}
+			}
+		}
+
 		public SceneViewport Output {
 			get {
 				lock (InstanceMutationLock) {
@@ -120,7 +176,7 @@ namespace Ophidian.Losgap.Rendering {
 		public ShadowPass(string name) : base(name) {
 			setUpCacheForLocalThreadAct = SetUpCacheForLocalThread;
 			renderCacheIterateMatAct = RenderCache_IterateMaterial;
-			setInstanceBufferAndFlushCommandsAct = SetInstanceBufferAndFlushCommands;
+			setInstanceBufferAct = SetInstanceBuffer;
 		}
 
 		private readonly Texture2DBuilder<TexelFormat.R24G8Typeless> shadowBufferBuilder = TextureFactory.NewTexture2D<TexelFormat.R24G8Typeless>()
@@ -161,13 +217,32 @@ namespace Ophidian.Losgap.Rendering {
 			// Clear the depth buffer
 			QueueRenderCommand(RenderCommand.ClearDepthStencil(shadowBufferDSV));
 
+			// Draw the occluders once for the whole frame (every cache is seen from the same light)
+			currentOcclusionBuffer = occlusionBuffer != null && !occlusionBuffer.IsDisposed ? occlusionBuffer : null;
+			if (currentOcclusionBuffer != null) {
+				currentOcclusionBuffer.Rasterize(*((Matrix*) lightCam.GetRecalculatedViewMatrix()) * *((Matrix*) Output.GetRecalculatedProjectionMatrix(lightCam)));
+			}
+
 			List<GeometryCache> activeCaches = GeometryCache.ActiveCaches;
 			foreach (GeometryCache c in activeCaches) {
 				// Set view/proj matrix
-				Matrix vpMat = (*((Matrix*) lightCam.GetRecalculatedViewMatrix()) * *((Matrix*) Output.GetRecalculatedProjectionMatrix(lightCam))).Transpose;
+				Matrix lightVPMat = *((Matrix*) lightCam.GetRecalculatedViewMatrix()) * *((Matrix*) Output.GetRecalculatedProjectionMatrix(lightCam));
+				Matrix vpMat = lightVPMat.Transpose;
 				byte* vpMapPtr = (byte*) &vpMat;
 				shadowVS.ViewProjMatBinding.SetValue(vpMapPtr);
 
+				// Set up shadow caster culling (a directional light's shadows can be no longer than its camera is deep)
+				currentCasterFrustum = FrustumCuller.CreateShadowCasterFrustum(lightVPMat);
+				Vector3? lightOrthoDimensions = lightCam.OrthographicDimensions;
+				if (receiverCam != null && !receiverCam.IsDisposed && lightOrthoDimensions != null) {
+					currentReceiverFrustum = FrustumCuller.CreateShadowReceiverFrustum(
+						*((Matrix*) receiverCam.GetRecalculatedViewMatrix()) * *((Matrix*) Output.GetRecalculatedProjectionMatrix(receiverCam)),
+						lightCam.Orientation,
+						lightOrthoDimensions.Value.Z
+					);
+				}
+				else currentReceiverFrustum = null;
+
 				// Set state for current cache
 				cpuInstanceBufferCurIndex = 0;
 				List<SceneLayer> allEnabledLayers = Scene.EnabledLayers;
@@ -187,6 +262,11 @@ namespace Ophidian.Losgap.Rendering {
 				Thread.MemoryBarrier();
 				currentInstanceData = currentCache.GetModelInstanceData();
 
+				// Find the instances in the caster frustum once for the whole cache, from its spatial index, so that each material only visits its own
+				uint? numCasterKeys = currentCache.FindInstanceKeys(currentCasterFrustum, ref casterInstanceKeys);
+				currentInstancesAreIndexed = numCasterKeys.HasValue;
+				numCasterInstanceKeys = numCasterKeys.GetValueOrDefault();
+
 				// Set up each thread
 				pp.InvokeOnAll(setUpCacheForLocalThreadAct, true); // membar here
 
@@ -200,9 +280,10 @@ namespace Ophidian.Losgap.Rendering {
 				}
 				gpuInstanceBuffer.DiscardWrite(cpuInstanceBuffer); // Happens immediately (required)
 
-				// Set instance buffer and flush all commands, first on immediate context, then on each deferred
+				// Set instance buffer and flush all commands, first on immediate context, then on all deferred contexts at once
 				SetInstanceBufferAndFlushCommands();
-				pp.InvokeOnAll(setInstanceBufferAndFlushCommandsAct, false);
+				pp.InvokeOnAll(setInstanceBufferAct, false);
+				FlushDeferredRenderCommands(pp);
 			}
 		}
 
@@ -244,55 +325,117 @@ namespace Ophidian.Losgap.Rendering {
 			KeyValuePair<Material, ModelInstanceManager.MIDArray> currentKVP = currentInstanceData[materialIndex];
 			ModelInstanceManager.MIDArray currentMID = currentKVP.Value;
 
-			// Skip this material if it or its shader are disposed
+			// Skip this material if it or its shader are disposed, or if none of its instances are in the caster frustum
 			if (currentKVP.Key.IsDisposed) return;
+			uint firstCasterKey = 0U, endCasterKey = 0U;
+			if (currentInstancesAreIndexed) {
+				ModelInstanceManager.GetMaterialKeyRange(casterInstanceKeys, numCasterInstanceKeys, currentKVP.Key.Index, out firstCasterKey, out endCasterKey);
+				if (firstCasterKey == endCasterKey) return;
+			}
 
-			// Filter & sort
-			if (materialFilteringWorkspace == null || materialFilteringWorkspace.Length < currentCache.NumModels) {
-				materialFilteringWorkspace = new FastClearList<Transform>[currentCache.NumModels];
-				for (int i = 0; i < materialFilteringWorkspace.Length; ++i) materialFilteringWorkspace[i] = new FastClearList<Transform>();
+			// Filter
+			if (drawRecordWorkspace == null || drawRecordWorkspace.Length < currentMID.Length) {
+				drawRecordWorkspace = new DrawSorter.DrawRecord[currentMID.Length << 1];
+				drawTransformWorkspace = new Transform[currentMID.Length << 1];
+				drawOrderWorkspace = new uint[currentMID.Length << 1];
+				drawModelWorkspace = new uint[currentMID.Length << 1];
 			}
-			for (int i = 0; i < materialFilteringWorkspace.Length; ++i) materialFilteringWorkspace[i].Clear();
 
 			ModelInstanceData* midData = currentMID.Data;
+			uint[] modelFirstLODs = currentCache.ModelFirstLODs;
 			uint numInstances = 0U;
-			for (uint i = 0U; i < currentMID.Length; ++i) {
+			uint numCandidates = currentInstancesAreIndexed ? endCasterKey - firstCasterKey : currentMID.Length;
+			for (uint c = 0U; c < numCandidates; ++c) {
+				uint i = currentInstancesAreIndexed ? (uint) casterInstanceKeys[firstCasterKey + c] : c;
 				ModelInstanceData curMID = midData[i];
 				if (!curMID.InUse) continue;
 				SceneLayer layer = currentSceneLayers[curMID.SceneLayerIndex];
 				if (layer == null || !layer.GetRenderingEnabled() || !addedSceneLayers.Contains(layer)) continue;
 
-				materialFilteringWorkspace[curMID.ModelIndex].Add(curMID.Transform);
+				// Casters are drawn at the level of detail the geometry pass last picked for them
+				uint firstLOD = modelFirstLODs[curMID.ModelIndex];
+				uint lastLOD = modelFirstLODs[curMID.ModelIndex + 1U] - 1U;
+				drawTransformWorkspace[numInstances] = curMID.Transform;
+				drawModelWorkspace[numInstances] = curMID.ModelIndex;
+				drawRecordWorkspace[numInstances] = new DrawSorter.DrawRecord {
+					Model = Math.Min(firstLOD + curMID.LODIndex, lastLOD),
+					NumInstances = 1U
+				};
 				++numInstances;
 			}
 
-			// Concatenate & queue render commands
-			if (instanceConcatWorkspace == null || instanceConcatWorkspace.Length < numInstances) {
-				instanceConcatWorkspace = new Matrix[numInstances << 1]; // x2 so we don't create loads of garbage if the count keeps increasing by 1
+			// Cull instances that can't cast a visible shadow (the order workspace is free until the sort below), keeping the survivors in order;
+			// the spatial index has already checked the caster frustum, which leaves only the receiver frustum
+			if (currentCache.ModelBounds != null && (!currentInstancesAreIndexed || currentReceiverFrustum.HasValue)) {
+				uint numCasters = FrustumCuller.CullShadowCasters(
+					currentCasterFrustum,
+					currentReceiverFrustum,
+					currentCache.ModelBounds,
+					drawTransformWorkspace,
+					drawModelWorkspace,
+					numInstances,
+					drawOrderWorkspace
+				);
+				for (uint i = 0U; i < numCasters; ++i) {
+					uint casterIndex = drawOrderWorkspace[i];
+					drawTransformWorkspace[i] = drawTransformWorkspace[casterIndex];
+					drawModelWorkspace[i] = drawModelWorkspace[casterIndex];
+					drawRecordWorkspace[i] = drawRecordWorkspace[casterIndex];
+				}
+				numInstances = numCasters;
 			}
 
-			uint instanceStartOffset = RenderCache_IterateMaterial_ConcatReserve(numInstances);
-			uint nextWorkspaceIndex = 0;
-			uint outVBStartIndex, outIBStartIndex, outVBCount, outIBCount;
-
-			for (uint mI = 0U; mI < materialFilteringWorkspace.Length; ++mI) {
-				FastClearList<Transform> filteredTransformList = materialFilteringWorkspace[mI];
-				int numFilteredTransforms = filteredTransformList.Count;
-				if (numFilteredTransforms == 0) continue;
-
-				currentCache.GetModelBufferValues(mI, out outVBStartIndex, out outIBStartIndex, out outVBCount, out outIBCount);
-
-				QueueRenderCommand(RenderCommand.DrawIndexedInstanced(
-					(int) outVBStartIndex,
-					outIBStartIndex,
-					outIBCount,
-					nextWorkspaceIndex + instanceStartOffset,
-					(uint) numFilteredTransforms
-				));
-
-				for (int iI = 0; iI < numFilteredTransforms; ++iI) {
-					instanceConcatWorkspace[nextWorkspaceIndex++] = filteredTransformList[iI].AsMatrixTransposed;
+			// Then cull those hidden from the light behind the occluders, in the same way
+			if (currentOcclusionBuffer != null && currentCache.ModelBounds != null) {
+				uint numUnoccluded = currentOcclusionBuffer.CullInstances(
+					currentCache.ModelBounds,
+					drawTransformWorkspace,
+					drawModelWorkspace,
+					numInstances,
+					drawOrderWorkspace
+				);
+				for (uint i = 0U; i < numUnoccluded; ++i) {
+					uint unoccludedIndex = drawOrderWorkspace[i];
+					drawTransformWorkspace[i] = drawTransformWorkspace[unoccludedIndex];
+					drawModelWorkspace[i] = drawModelWorkspace[unoccludedIndex];
+					drawRecordWorkspace[i] = drawRecordWorkspace[unoccludedIndex];
 				}
+				numInstances = numUnoccluded;
+			}
+
+			// Sort state-first (the shadow shader is the only state, and is set once per thread, so that comes down to level of detail,
+			// i.e. model) and then front-to-back from the light, and turn that in to draw commands (contiguous instances of the same level
+			// are merged in to one draw)
+			DrawSorter.SetDepths(drawTransformWorkspace, drawRecordWorkspace, numInstances, lightCam.Position);
+			DrawSorter.Sort(DrawSorter.OpaqueStateFirst, drawRecordWorkspace, numInstances, drawOrderWorkspace);
+
+			if (modelRangeWorkspaceCache != currentCache) {
+				DrawSorter.GetLODBufferRanges(currentCache, ref modelRangeWorkspace);
+				modelRangeWorkspaceCache = currentCache;
+			}
+
+			if (drawCommandWorkspace == null || drawCommandWorkspace.Length < numInstances) {
+				drawCommandWorkspace = new RenderCommand[numInstances << 1];
+			}
+
+			uint instanceStartOffset = RenderCache_IterateMaterial_ConcatReserve(numInstances);
+			uint numDrawCommands = DrawSorter.EmitCommands(
+				drawRecordWorkspace,
+				drawOrderWorkspace,
+				numInstances,
+				modelRangeWorkspace,
+				true,
+				instanceStartOffset,
+				drawCommandWorkspace
+			);
+			for (uint i = 0U; i < numDrawCommands; ++i) QueueRenderCommand(drawCommandWorkspace[i]);
+
+			// Concatenate instance data in draw order
+			if (instanceConcatWorkspace == null || instanceConcatWorkspace.Length < numInstances) {
+				instanceConcatWorkspace = new Matrix[numInstances << 1]; // x2 so we don't create loads of garbage if the count keeps increasing by 1
+			}
+			fixed (Matrix* instanceConcatWorkspacePtr = instanceConcatWorkspace) {
+				InstanceMatrixWriter.WriteTransposedMatrices(drawTransformWorkspace, drawOrderWorkspace, numInstances, instanceConcatWorkspacePtr);
 			}
 
 			RenderCache_IterateMaterial_Concat(instanceConcatWorkspace, instanceStartOffset, numInstances);
@@ -318,11 +461,15 @@ namespace Ophidian.Losgap.Rendering {
 			}
 		}
 
-		private void SetInstanceBufferAndFlushCommands() {
+		private void SetInstanceBuffer() {
 			QueueRenderCommand(
 				reservedSetIBCommandSlot,
 				RenderCommand.SetInstanceBuffer(gpuInstanceBuffer, shadowVS.InstanceDataBinding.SlotIndex)
 			);
+		}
+
+		private void SetInstanceBufferAndFlushCommands() {
+			SetInstanceBuffer();
 			FlushRenderCommands();
 		}
 
@@ -0,0 +1,46 @@
+﻿// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created on 20 10 2016 at 03:14 by Ben Bowen
+
+using System;
+using Ophidian.Losgap.Interop;
+
+namespace Ophidian.Losgap.Rendering {
+	/// <summary>
+	/// A command queue that is never flushed: state is queued on to it with the same methods that queue it for the device (e.g.
+	/// <see cref="Shader.RCQSwitchToShader"/>), and the resultant commands are then taken back out as a table, so that
+	/// <see cref="DrawSorter"/> can write them only where they're needed.
+	/// </summary>
+	/// <remarks>
+	/// The memory the commands' arguments point to is reserved from the recording thread's <see cref="FrameArena"/>, so the taken
+	/// commands must be queued for real on the same thread before that arena is next reset.
+	/// </remarks>
+	internal sealed class StateCommandRecorder : RenderCommandQueue {
+		/// <summary>
+		/// Copies every command recorded so far in to <paramref name="commandTable"/> from <paramref name="tableOffset"/> onwards (growing
+		/// the table if required), clears the recorder, and returns the offset just past the last command copied.
+		/// </summary>
+		public uint TakeCommands(ref RenderCommand[] commandTable, uint tableOffset) {
+			Assure.Equal(DeferredActions.Count, 0, "Actions can not be recorded in to a command table.");
+			uint requiredTableLen = tableOffset + NumCommandsQueued;
+			if (commandTable == null || commandTable.Length < requiredTableLen) {
+				RenderCommand[] newTable = new RenderCommand[requiredTableLen << 1];
+				if (commandTable != null) Array.Copy(commandTable, newTable, tableOffset);
+				commandTable = newTable;
+			}
+
+			uint streamOffset = 0U;
+			while (streamOffset < CurStreamOffset) {
+				RenderCommand? command = CompactCommandStream.Decode(CommandStream.AlignedPointer, ref streamOffset);
+				if (command.HasValue) commandTable[tableOffset++] = command.Value;
+			}
+
+			ClearStream();
+			return tableOffset;
+		}
+
+		public override void Flush() {
+			throw new InvalidOperationException("A state command recorder can not be flushed; its commands must be taken instead.");
+		}
+	}
+}
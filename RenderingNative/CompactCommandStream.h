@@ -0,0 +1,146 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderCommand.h"
+
+namespace losgap {
+	/*
+	Decodes the compact render command stream written by the managed CompactCommandStream class.
+	Every record starts 4-byte aligned with a 32-bit header: the RenderCommandInstruction in the low byte and an instruction-specific
+	24-bit immediate above it. Any 32-bit operands follow the header, and any pointer operands follow those at the next pointer-aligned
+	address (the stream itself must start pointer-aligned):
+
+		NoOperation						imm = number of 4-byte words to skip (filler written by the queue sets FILLER_FLAG too)
+		SetPrimitiveTopology			imm = topology
+		Draw							u32 firstVertexIndex, u32 numVertices
+		DrawIndexedInstanced			imm = firstVertexIndex (signed) or WIDE_FIRST_VERTEX_INDEX; u32 firstIndexIndex, u32 numIndices,
+										u32 firstInstanceIndex, u32 numInstances; then u32 firstVertexIndex if it did not fit in imm
+		SetInstanceBuffer				imm = slot; ptr buffer
+		[VS|FS]Set[CBuffers|Samplers|Resources]		imm = numSlots | (startSlot << SLOT_RANGE_START_SHIFT); ptr array
+		SetVertexBuffers				imm = numBuffers; ptr buffer array, ptr stride array
+		SetRenderTargets				imm = numRTVs; ptr RTV array, ptr DSV
+		CBDiscardWrite, BufferWrite		u32 numBytes; ptr buffer, ptr data
+		(everything else)				ptr argument
+
+	Decoding yields the same RenderCommand that the legacy fixed-size format would have carried.
+	*/
+	class CompactCommandStream {
+	private:
+		static void CheckRemaining(const uint8_t* cursor, const uint8_t* streamEnd, size_t numBytes) {
+			if (streamEnd - cursor < static_cast<ptrdiff_t>(numBytes)) throw LosgapException { "Render command overruns the end of the stream." };
+		}
+
+		static uint32_t ReadUInt(const uint8_t*& cursor, const uint8_t* streamEnd) {
+			CheckRemaining(cursor, streamEnd, sizeof(uint32_t));
+			uint32_t result = *reinterpret_cast<const uint32_t*>(cursor);
+			cursor += sizeof(uint32_t);
+			return result;
+		}
+
+		static uint64_t ReadPointer(const uint8_t*& cursor, const uint8_t* streamEnd) {
+			cursor = reinterpret_cast<const uint8_t*>((reinterpret_cast<uintptr_t>(cursor) + sizeof(void*) - 1U) & ~(sizeof(void*) - 1U));
+			CheckRemaining(cursor, streamEnd, sizeof(void*));
+			uint64_t result = reinterpret_cast<uintptr_t>(*reinterpret_cast<void* const*>(cursor));
+			cursor += sizeof(void*);
+			return result;
+		}
+
+		static uint64_t PackUInts(uint32_t low, uint32_t high) {
+			return static_cast<uint64_t>(low) | (static_cast<uint64_t>(high) << 32);
+		}
+
+	public:
+		static const uint32_t OPCODE_MASK = 0xFFU;
+		static const uint32_t IMMEDIATE_SHIFT = 8U;
+		static const uint32_t FILLER_FLAG = 0x800000U;
+		static const uint32_t FILLER_LENGTH_MASK = 0x7FFFFFU;
+		static const uint32_t WIDE_FIRST_VERTEX_INDEX = 0x800000U;
+		static const uint32_t SLOT_RANGE_START_SHIFT = 12U;
+		static const uint32_t SLOT_RANGE_COUNT_MASK = 0xFFFU;
+
+		/*
+		Decodes the record at the cursor and moves the cursor past it. Throws rather than read (or skip) past streamEnd, so a truncated or
+		corrupt stream can't make the decoder read beyond it.
+		*/
+		static RenderCommand Decode(const uint8_t*& cursor, const uint8_t* streamEnd) {
+			uint32_t header = ReadUInt(cursor, streamEnd);
+			uint32_t immediate = header >> IMMEDIATE_SHIFT;
+			RenderCommand result = { static_cast<RenderCommandInstruction>(header & OPCODE_MASK), 0U, 0U, 0U };
+
+			switch (result.Instruction) {
+				case RenderCommandInstruction::DrawIndexedInstanced: {
+					uint32_t firstIndexIndex = ReadUInt(cursor, streamEnd);
+					uint32_t numIndices = ReadUInt(cursor, streamEnd);
+					uint32_t firstInstanceIndex = ReadUInt(cursor, streamEnd);
+					uint32_t numInstances = ReadUInt(cursor, streamEnd);
+					// Sign-extend the 24-bit immediate
+					uint32_t firstVertexIndex = immediate == WIDE_FIRST_VERTEX_INDEX
+						? ReadUInt(cursor, streamEnd)
+						: static_cast<uint32_t>(static_cast<int32_t>(immediate << IMMEDIATE_SHIFT) >> IMMEDIATE_SHIFT);
+					result.Arg1 = firstVertexIndex;
+					result.Arg2 = PackUInts(firstIndexIndex, numIndices);
+					result.Arg3 = PackUInts(firstInstanceIndex, numInstances);
+					break;
+				}
+				case RenderCommandInstruction::Draw:
+					result.Arg1 = ReadUInt(cursor, streamEnd);
+					result.Arg2 = ReadUInt(cursor, streamEnd);
+					break;
+				case RenderCommandInstruction::VSSetCBuffers:
+				case RenderCommandInstruction::FSSetCBuffers:
+				case RenderCommandInstruction::VSSetSamplers:
+				case RenderCommandInstruction::FSSetSamplers:
+				case RenderCommandInstruction::VSSetResources:
+				case RenderCommandInstruction::FSSetResources:
+					result.Arg1 = ReadPointer(cursor, streamEnd);
+					result.Arg2 = immediate & SLOT_RANGE_COUNT_MASK;
+					result.Arg3 = immediate >> SLOT_RANGE_START_SHIFT;
+					break;
+				case RenderCommandInstruction::SetInstanceBuffer:
+					result.Arg1 = ReadPointer(cursor, streamEnd);
+					result.Arg2 = immediate;
+					break;
+				case RenderCommandInstruction::SetVertexBuffers:
+				case RenderCommandInstruction::SetRenderTargets:
+					result.Arg1 = ReadPointer(cursor, streamEnd);
+					result.Arg2 = ReadPointer(cursor, streamEnd);
+					result.Arg3 = immediate;
+					break;
+				case RenderCommandInstruction::CBDiscardWrite:
+				case RenderCommandInstruction::BufferWrite:
+					result.Arg3 = ReadUInt(cursor, streamEnd);
+					result.Arg1 = ReadPointer(cursor, streamEnd);
+					result.Arg2 = ReadPointer(cursor, streamEnd);
+					break;
+				case RenderCommandInstruction::SetPrimitiveTopology:
+					result.Arg1 = immediate;
+					break;
+				case RenderCommandInstruction::NoOperation:
+					CheckRemaining(cursor, streamEnd, (immediate & FILLER_LENGTH_MASK) * sizeof(uint32_t));
+					cursor += (immediate & FILLER_LENGTH_MASK) * sizeof(uint32_t);
+					break;
+				case RenderCommandInstruction::SetInputLayout:
+				case RenderCommandInstruction::SetIndexBuffer:
+				case RenderCommandInstruction::VSSetShader:
+				case RenderCommandInstruction::FSSetShader:
+				case RenderCommandInstruction::SetRSState:
+				case RenderCommandInstruction::SetDSState:
+				case RenderCommandInstruction::SetBlendState:
+				case RenderCommandInstruction::SetViewport:
+				case RenderCommandInstruction::ClearRenderTarget:
+				case RenderCommandInstruction::ClearDepthStencil:
+				case RenderCommandInstruction::SwapChainPresent:
+				case RenderCommandInstruction::FinishCommandList:
+					result.Arg1 = ReadPointer(cursor, streamEnd);
+					break;
+				default:
+					throw LosgapException { "Unknown render instruction in compact stream: " + std::to_string(result.Instruction) };
+			}
+
+			return result;
+		}
+	};
+}
@@ -3,6 +3,8 @@
 // Created by Ben Bowen
 
 #include "ContextFactory.h"
+#include "RenderStateCache.h"
+#include "FlushProfiler.h"
 
 namespace losgap {
 #pragma region ::GetImmediateContext()
@@ -49,7 +51,9 @@ namespace losgap {
 			}
 
 			CHECK_CALL(deferredContextPtrArr[i]->FinishCommandList(FALSE, &outCommandList));
+			RenderStateCache::InvalidateContextCache(deferredContextPtrArr[i]);
 			immediateContextPtr->ExecuteCommandList(outCommandList, FALSE);
+			RenderStateCache::InvalidateContextCache(immediateContextPtr);
 		}
 	}
 	EXPORT(ContextFactory_ExecuteDeferredCommandLists, ID3D11DeviceContext* immediateContextPtr,
@@ -63,6 +67,8 @@ namespace losgap {
 	void ContextFactory::ReleaseContext(ID3D11DeviceContext* contextPtr) {
 		if (contextPtr == nullptr) throw LosgapException { "Context pointer must not be null." };
 
+		RenderStateCache::ReleaseContextCache(contextPtr);
+		FlushProfiler::ReleaseContextProfile(contextPtr);
 		RELEASE_COM(contextPtr);
 	}
 	EXPORT(ContextFactory_ReleaseContext, ID3D11DeviceContext* contextPtr) {
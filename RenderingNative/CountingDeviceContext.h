@@ -0,0 +1,113 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderStateCache.h"
+#include "FlushProfiler.h"
+#include "PortableD3D11.h"
+#include <vector>
+
+namespace losgap {
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	An interop struct detailing what a CountingDeviceContext was asked to do
+	*/
+	struct DeviceContextCallCounts {
+		uint64_t NumCalls;
+		uint64_t NumDrawCalls;
+		uint64_t NumInstancesDrawn;
+		uint64_t NumMaps;
+		uint64_t NumCommandListsFinished;
+		uint64_t NumCommandListsExecuted;
+		uint64_t NumPresents;
+	};
+#pragma pack(pop)
+
+	/*
+	A stand-in for ID3D11DeviceContext (see RenderCommandTranslator) that only counts the calls made on it. It never dereferences
+	the objects it is given, so it can be driven with the stable ids in a render capture (see RenderCommandReplay) instead of real
+	device objects, and needs no device (or Windows) to run. The command lists it finishes are opaque handles that are only valid
+	for passing back to ExecuteCommandList().
+	*/
+	class CountingDeviceContext {
+	private:
+		std::vector<uint8_t> mappedScratch;
+
+	public:
+		DeviceContextCallCounts Counts;
+		RenderStateCache StateCache;
+		FlushProfile Profile;
+
+		/*
+		mapScratchBytes must be at least the largest buffer write that will be translated on to this context.
+		*/
+		explicit CountingDeviceContext(size_t mapScratchBytes) : mappedScratch(mapScratchBytes > 0U ? mapScratchBytes : 1U), Counts(), StateCache(), Profile() { }
+		DISALLOW_COPY_ASSIGN_MOVE(CountingDeviceContext);
+
+		void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) { ++Counts.NumCalls; }
+		void IASetInputLayout(ID3D11InputLayout*) { ++Counts.NumCalls; }
+		void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) { ++Counts.NumCalls; }
+		void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) { ++Counts.NumCalls; }
+		void VSSetShader(ID3D11VertexShader*, ID3D11ClassInstance* const*, UINT) { ++Counts.NumCalls; }
+		void PSSetShader(ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) { ++Counts.NumCalls; }
+		void VSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) { ++Counts.NumCalls; }
+		void PSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) { ++Counts.NumCalls; }
+		void VSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) { ++Counts.NumCalls; }
+		void PSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) { ++Counts.NumCalls; }
+		void VSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) { ++Counts.NumCalls; }
+		void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) { ++Counts.NumCalls; }
+		void RSSetState(ID3D11RasterizerState*) { ++Counts.NumCalls; }
+		void RSSetViewports(UINT, const D3D11_VIEWPORT*) { ++Counts.NumCalls; }
+		void RSSetScissorRects(UINT, const D3D11_RECT*) { ++Counts.NumCalls; }
+		void OMSetDepthStencilState(ID3D11DepthStencilState*, UINT) { ++Counts.NumCalls; }
+		void OMSetBlendState(ID3D11BlendState*, const FLOAT*, UINT) { ++Counts.NumCalls; }
+		void OMSetRenderTargets(UINT, ID3D11RenderTargetView* const*, ID3D11DepthStencilView*) { ++Counts.NumCalls; }
+		HRESULT Map(ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE* outMappedSubresource) {
+			++Counts.NumCalls;
+			++Counts.NumMaps;
+			outMappedSubresource->pData = &mappedScratch.front();
+			outMappedSubresource->RowPitch = static_cast<UINT>(mappedScratch.size());
+			outMappedSubresource->DepthPitch = static_cast<UINT>(mappedScratch.size());
+			return S_OK;
+		}
+		void Unmap(ID3D11Resource*, UINT) { ++Counts.NumCalls; }
+		void DrawIndexedInstanced(UINT, UINT numInstances, UINT, INT, UINT) {
+			++Counts.NumCalls;
+			++Counts.NumDrawCalls;
+			Counts.NumInstancesDrawn += numInstances;
+		}
+		void Draw(UINT, UINT) {
+			++Counts.NumCalls;
+			++Counts.NumDrawCalls;
+			++Counts.NumInstancesDrawn;
+		}
+		void ClearRenderTargetView(ID3D11RenderTargetView*, const FLOAT*) { ++Counts.NumCalls; }
+		void ClearDepthStencilView(ID3D11DepthStencilView*, UINT, FLOAT, UINT8) { ++Counts.NumCalls; }
+
+		HRESULT FinishCommandList(BOOL, ID3D11CommandList** outCommandList) {
+			++Counts.NumCalls;
+			++Counts.NumCommandListsFinished;
+			*outCommandList = reinterpret_cast<ID3D11CommandList*>(static_cast<uintptr_t>(Counts.NumCommandListsFinished));
+			return S_OK;
+		}
+		void ExecuteCommandList(ID3D11CommandList*, BOOL) {
+			++Counts.NumCalls;
+			++Counts.NumCommandListsExecuted;
+		}
+	};
+
+	inline RenderStateCache* GetStateCache(CountingDeviceContext* deviceContextPtr) {
+		return &deviceContextPtr->StateCache;
+	}
+
+	inline FlushProfile* GetFlushProfile(CountingDeviceContext* deviceContextPtr) {
+		return &deviceContextPtr->Profile;
+	}
+
+	inline void PresentSwapChain(CountingDeviceContext* deviceContextPtr, IDXGISwapChain*) {
+		++deviceContextPtr->Counts.NumCalls;
+		++deviceContextPtr->Counts.NumPresents;
+	}
+}
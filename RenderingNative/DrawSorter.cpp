@@ -0,0 +1,274 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "DrawSorter.h"
+#include "../CoreNative/FrameArena.h"
+#include <cstring>
+#include <utility>
+
+#define DRAW_SORTER_SSE2
+#include <emmintrin.h>
+
+namespace losgap {
+	const uint32_t RADIX_BITS = 8U;
+	const uint32_t RADIX_SIZE = 1U << RADIX_BITS;
+	const uint32_t NUM_RADIX_PASSES = 64U / RADIX_BITS;
+	const uint32_t NO_STATE = 0xFFFFFFFFU;
+
+	/*
+	Maps a float to an unsigned integer with the same ordering (negatives flipped entirely, positives just get their sign bit set).
+	*/
+	uint32_t SortableDepthBits(float depth) {
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+		return (bits & 0x80000000U) != 0U ? ~bits : (bits | 0x80000000U);
+	}
+
+	void ValidateLayout(const SortKeyLayout& layout) {
+		if (layout.NumFields == 0U || layout.NumFields > MAX_SORT_KEY_FIELDS) {
+			throw LosgapException { "Sort key layout must have between 1 and " + std::to_string(MAX_SORT_KEY_FIELDS) + " fields." };
+		}
+		uint32_t totalBits = 0U;
+		for (uint32_t f = 0U; f < layout.NumFields; ++f) {
+			if (layout.FieldBits[f] == 0U || layout.FieldBits[f] > 32U) throw LosgapException { "Each sort key field must be 1 to 32 bits wide." };
+			if (layout.Fields[f] > SortKeyDepthBackToFront) throw LosgapException { "Unknown sort key field: " + std::to_string(layout.Fields[f]) };
+			totalBits += layout.FieldBits[f];
+		}
+		if (totalBits > 64U) throw LosgapException { "Sort key layout needs " + std::to_string(totalBits) + " bits; the maximum is 64." };
+	}
+
+	uint64_t DrawSorter::MakeSortKey(const SortKeyLayout& layout, const DrawRecord& record) {
+		uint64_t key = 0U;
+		for (uint32_t f = 0U; f < layout.NumFields; ++f) {
+			uint32_t numBits = layout.FieldBits[f];
+			uint32_t fieldMask = numBits == 32U ? 0xFFFFFFFFU : (1U << numBits) - 1U;
+			uint32_t value;
+			switch (layout.Fields[f]) {
+				case SortKeyPass: value = record.Pass & fieldMask; break;
+				case SortKeyShader: value = record.Shader & fieldMask; break;
+				case SortKeyMaterial: value = record.Material & fieldMask; break;
+				case SortKeyModel: value = record.Model & fieldMask; break;
+				case SortKeyDepthFrontToBack: value = SortableDepthBits(record.Depth) >> (32U - numBits); break;
+				default: value = ~SortableDepthBits(record.Depth) >> (32U - numBits); break;
+			}
+			key = (key << numBits) | value;
+		}
+		return key;
+	}
+
+	/*
+	Sorts keyArr (and orderArr along with it) with an LSD radix sort, given each pass's digit histogram. Both arrays must already be
+	filled in; the keys are left in an unspecified state afterwards.
+	*/
+	void RadixSortKeys(uint64_t* keyArr, uint32_t* orderArr, uint32_t numKeys, uint32_t (&histograms)[NUM_RADIX_PASSES][RADIX_SIZE]) {
+		// Scratch space only needs to last until we return, so the thread's frame arena is a good fit
+		FrameArena* arena = FrameArena::GetThreadArena();
+		uint64_t* scratchKeys = static_cast<uint64_t*>(arena->Allocate(numKeys * sizeof(uint64_t)));
+		uint32_t* scratchOrder = static_cast<uint32_t*>(arena->Allocate(numKeys * sizeof(uint32_t)));
+
+		uint64_t* srcKeys = keyArr;
+		uint32_t* srcOrder = orderArr;
+		uint64_t* dstKeys = scratchKeys;
+		uint32_t* dstOrder = scratchOrder;
+		for (uint32_t p = 0U; p < NUM_RADIX_PASSES; ++p) {
+			uint32_t shift = p * RADIX_BITS;
+			uint32_t* histogram = histograms[p];
+			// Most layouts (and ungrouped distance keys) leave the top bits empty, and every key sharing a digit makes a pass a no-op
+			if (histogram[(srcKeys[0] >> shift) & (RADIX_SIZE - 1U)] == numKeys) continue;
+
+			uint32_t digitOffset = 0U;
+			for (uint32_t d = 0U; d < RADIX_SIZE; ++d) {
+				uint32_t digitCount = histogram[d];
+				histogram[d] = digitOffset;
+				digitOffset += digitCount;
+			}
+			for (uint32_t i = 0U; i < numKeys; ++i) {
+				uint32_t destIndex = histogram[(srcKeys[i] >> shift) & (RADIX_SIZE - 1U)]++;
+				dstKeys[destIndex] = srcKeys[i];
+				dstOrder[destIndex] = srcOrder[i];
+			}
+
+			std::swap(srcKeys, dstKeys);
+			std::swap(srcOrder, dstOrder);
+		}
+
+		if (srcOrder != orderArr) memcpy(orderArr, srcOrder, numKeys * sizeof(uint32_t));
+	}
+
+	void DrawSorter::Sort(const SortKeyLayout& layout, const DrawRecord* recordArr, uint32_t numRecords, uint32_t* outOrder) {
+		ValidateLayout(layout);
+		if (numRecords == 0U) return;
+
+		uint64_t* keys = static_cast<uint64_t*>(FrameArena::GetThreadArena()->Allocate(numRecords * sizeof(uint64_t)));
+		uint32_t histograms[NUM_RADIX_PASSES][RADIX_SIZE] = { };
+		for (uint32_t i = 0U; i < numRecords; ++i) {
+			uint64_t key = MakeSortKey(layout, recordArr[i]);
+			keys[i] = key;
+			outOrder[i] = i;
+			for (uint32_t p = 0U; p < NUM_RADIX_PASSES; ++p) ++histograms[p][(key >> (p * RADIX_BITS)) & (RADIX_SIZE - 1U)];
+		}
+
+		RadixSortKeys(keys, outOrder, numRecords, histograms);
+	}
+	EXPORT_FAST(DrawSorter_Sort, const SortKeyLayout* layout, const DrawRecord* recordArr, uint32_t numRecords, uint32_t* outOrder) {
+		DrawSorter::Sort(*layout, recordArr, numRecords, outOrder);
+		EXPORT_FAST_END;
+	}
+
+	/*
+	Writes the squared distance of each transform's translation from viewPosition to outDistanceSqArr.
+	*/
+	void ComputeDistancesSq(const InstanceTransform* transformArr, uint32_t numInstances, const float* viewPosition, float* outDistanceSqArr) {
+		uint32_t i = 0U;
+#ifdef DRAW_SORTER_SSE2
+		const __m128 viewX = _mm_set1_ps(viewPosition[0]);
+		const __m128 viewY = _mm_set1_ps(viewPosition[1]);
+		const __m128 viewZ = _mm_set1_ps(viewPosition[2]);
+		for (; i + 4U <= numInstances; i += 4U) {
+			// Four translations in, four lanes each of X, Y and Z out (the fourth is just padding)
+			__m128 x = _mm_loadu_ps(&transformArr[i].TranslationX);
+			__m128 y = _mm_loadu_ps(&transformArr[i + 1U].TranslationX);
+			__m128 z = _mm_loadu_ps(&transformArr[i + 2U].TranslationX);
+			__m128 padding = _mm_loadu_ps(&transformArr[i + 3U].TranslationX);
+			_MM_TRANSPOSE4_PS(x, y, z, padding);
+
+			x = _mm_sub_ps(x, viewX);
+			y = _mm_sub_ps(y, viewY);
+			z = _mm_sub_ps(z, viewZ);
+			_mm_storeu_ps(outDistanceSqArr + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		}
+#endif
+		for (; i < numInstances; ++i) {
+			const InstanceTransform& transform = transformArr[i];
+			float x = transform.TranslationX - viewPosition[0];
+			float y = transform.TranslationY - viewPosition[1];
+			float z = transform.TranslationZ - viewPosition[2];
+			outDistanceSqArr[i] = (x * x + y * y) + z * z;
+		}
+	}
+
+	void DrawSorter::SetDepths(const InstanceTransform* transformArr, uint32_t numRecords, const float* viewPosition, DrawRecord* recordArr) {
+		if (viewPosition == nullptr) throw LosgapException { "View position must not be null." };
+		if (numRecords == 0U) return;
+
+		float* distancesSq = static_cast<float*>(FrameArena::GetThreadArena()->Allocate(numRecords * sizeof(float)));
+		ComputeDistancesSq(transformArr, numRecords, viewPosition, distancesSq);
+		for (uint32_t i = 0U; i < numRecords; ++i) recordArr[i].Depth = distancesSq[i];
+	}
+	EXPORT_FAST(DrawSorter_SetDepths, const InstanceTransform* transformArr, uint32_t numRecords, const float* viewPosition, DrawRecord* recordArr) {
+		DrawSorter::SetDepths(transformArr, numRecords, viewPosition, recordArr);
+		EXPORT_FAST_END;
+	}
+
+	void DrawSorter::SortByDistance(const InstanceTransform* transformArr, const uint32_t* groupArr, uint32_t numInstances, const float* viewPosition,
+		bool backToFront, uint32_t* outOrder) {
+		if (viewPosition == nullptr) throw LosgapException { "View position must not be null." };
+		if (numInstances == 0U) return;
+
+		FrameArena* arena = FrameArena::GetThreadArena();
+		float* distancesSq = static_cast<float*>(arena->Allocate(numInstances * sizeof(float)));
+		uint64_t* keys = static_cast<uint64_t*>(arena->Allocate(numInstances * sizeof(uint64_t)));
+		uint32_t histograms[NUM_RADIX_PASSES][RADIX_SIZE] = { };
+		const uint32_t distanceFlip = backToFront ? 0xFFFFFFFFU : 0U;
+		ComputeDistancesSq(transformArr, numInstances, viewPosition, distancesSq);
+
+		// Each key is the instance's group, then its distance bits: squared distances are never negative, so their bits already sort
+		// in the same order as their values
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			uint32_t distanceBits;
+			memcpy(&distanceBits, &distancesSq[i], sizeof(distanceBits));
+			uint64_t key = (groupArr != nullptr ? static_cast<uint64_t>(groupArr[i]) << 32 : 0U) | (distanceBits ^ distanceFlip);
+			keys[i] = key;
+			outOrder[i] = i;
+			for (uint32_t p = 0U; p < NUM_RADIX_PASSES; ++p) ++histograms[p][(key >> (p * RADIX_BITS)) & (RADIX_SIZE - 1U)];
+		}
+
+		RadixSortKeys(keys, outOrder, numInstances, histograms);
+	}
+	EXPORT_FAST(DrawSorter_SortByDistance, const InstanceTransform* transformArr, const uint32_t* groupArr, uint32_t numInstances,
+		const float* viewPosition, INTEROP_BOOL backToFront, uint32_t* outOrder) {
+		DrawSorter::SortByDistance(transformArr, groupArr, numInstances, viewPosition, INTEROP_BOOL_TO_CBOOL(backToFront), outOrder);
+		EXPORT_FAST_END;
+	}
+
+	void AppendCommand(const RenderCommand& command, RenderCommand* outCommandArr, uint32_t outCommandArrLen, uint32_t& numCommands) {
+		if (numCommands == outCommandArrLen) {
+			throw LosgapException { "Output command array (length " + std::to_string(outCommandArrLen) + ") is too small for the sorted draws." };
+		}
+		outCommandArr[numCommands++] = command;
+	}
+
+	void AppendStateCommands(const RenderCommand* commandTable, const uint32_t* offsetTable, uint32_t stateIndex,
+		RenderCommand* outCommandArr, uint32_t outCommandArrLen, uint32_t& numCommands) {
+		for (uint32_t c = offsetTable[stateIndex]; c < offsetTable[stateIndex + 1U]; ++c) {
+			AppendCommand(commandTable[c], outCommandArr, outCommandArrLen, numCommands);
+		}
+	}
+
+	uint32_t DrawSorter::EmitCommands(const DrawRecord* recordArr, const uint32_t* order, uint32_t numRecords, const DrawStateTables& tables,
+		bool packInstances, uint32_t firstPackedInstance, RenderCommand* outCommandArr, uint32_t outCommandArrLen) {
+		if (tables.Models == nullptr) throw LosgapException { "Model buffer range table must not be null." };
+		if ((tables.ShaderCommands == nullptr) != (tables.ShaderCommandOffsets == nullptr)
+			|| (tables.MaterialCommands == nullptr) != (tables.MaterialCommandOffsets == nullptr)) {
+			throw LosgapException { "State command tables must be given with their offset tables." };
+		}
+
+		uint32_t numCommands = 0U;
+		uint32_t lastShader = NO_STATE;
+		uint32_t lastMaterial = NO_STATE;
+		uint32_t lastDrawModel = NO_STATE;
+		uint32_t lastDrawCommandIndex = 0U;
+		uint32_t nextPackedInstance = firstPackedInstance;
+
+		for (uint32_t i = 0U; i < numRecords; ++i) {
+			const DrawRecord& record = recordArr[order[i]];
+			if (record.NumInstances == 0U) continue;
+
+			if (tables.ShaderCommands != nullptr && record.Shader != lastShader) {
+				AppendStateCommands(tables.ShaderCommands, tables.ShaderCommandOffsets, record.Shader, outCommandArr, outCommandArrLen, numCommands);
+				lastShader = record.Shader;
+				lastMaterial = NO_STATE;
+				lastDrawModel = NO_STATE;
+			}
+			if (tables.MaterialCommands != nullptr && record.Material != lastMaterial) {
+				AppendStateCommands(tables.MaterialCommands, tables.MaterialCommandOffsets, record.Material, outCommandArr, outCommandArrLen, numCommands);
+				lastMaterial = record.Material;
+				lastDrawModel = NO_STATE;
+			}
+
+			uint32_t firstInstance = packInstances ? nextPackedInstance : record.FirstInstance;
+			nextPackedInstance += record.NumInstances;
+
+			// Extend the previous draw if nothing changed in between and this record's instances follow straight on from its own
+			if (record.Model == lastDrawModel) {
+				RenderCommand& lastDraw = outCommandArr[lastDrawCommandIndex];
+				uint32_t lastFirstInstance = static_cast<uint32_t>(lastDraw.Arg3);
+				uint32_t lastNumInstances = static_cast<uint32_t>(lastDraw.Arg3 >> 32);
+				if (lastFirstInstance + lastNumInstances == firstInstance) {
+					lastDraw.Arg3 = lastFirstInstance | (static_cast<uint64_t>(lastNumInstances + record.NumInstances) << 32);
+					continue;
+				}
+			}
+
+			const ModelBufferRange& model = tables.Models[record.Model];
+			RenderCommand draw = {
+				RenderCommandInstruction::DrawIndexedInstanced,
+				static_cast<uint32_t>(model.FirstVertexIndex),
+				model.FirstIndexIndex | (static_cast<uint64_t>(model.NumIndices) << 32),
+				firstInstance | (static_cast<uint64_t>(record.NumInstances) << 32)
+			};
+			lastDrawCommandIndex = numCommands;
+			lastDrawModel = record.Model;
+			AppendCommand(draw, outCommandArr, outCommandArrLen, numCommands);
+		}
+
+		return numCommands;
+	}
+	EXPORT_FAST(DrawSorter_EmitCommands, const DrawRecord* recordArr, const uint32_t* order, uint32_t numRecords, const DrawStateTables* tables,
+		INTEROP_BOOL packInstances, uint32_t firstPackedInstance, RenderCommand* outCommandArr, uint32_t outCommandArrLen, uint32_t* outNumCommands) {
+		*outNumCommands = DrawSorter::EmitCommands(recordArr, order, numRecords, *tables, INTEROP_BOOL_TO_CBOOL(packInstances), firstPackedInstance,
+			outCommandArr, outCommandArrLen);
+		EXPORT_FAST_END;
+	}
+}
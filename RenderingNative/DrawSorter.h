@@ -0,0 +1,102 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderCommand.h"
+#include "InstanceTransform.h"
+
+namespace losgap {
+	enum SortKeyField : uint32_t {
+		SortKeyPass = 0U,
+		SortKeyShader = 1U,
+		SortKeyMaterial = 2U,
+		SortKeyModel = 3U,
+		SortKeyDepthFrontToBack = 4U,
+		SortKeyDepthBackToFront = 5U
+	};
+
+	const uint32_t MAX_SORT_KEY_FIELDS = 6U;
+
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	Describes how a DrawRecord is packed in to a 64-bit sort key: Fields[0] takes the most significant FieldBits[0] bits, and so on.
+	Index fields are truncated to their low bits; depth fields keep their most significant bits.
+	*/
+	struct SortKeyLayout {
+		SortKeyField Fields[MAX_SORT_KEY_FIELDS];
+		uint32_t FieldBits[MAX_SORT_KEY_FIELDS];
+		uint32_t NumFields;
+	};
+
+	/*
+	A single draw: Shader, Material and Model index in to the DrawStateTables, and NumInstances instances starting at FirstInstance.
+	Depth is anything that orders draws by distance (e.g. SetDepths() writes squared distances); it must not be NaN.
+	*/
+	struct DrawRecord {
+		uint32_t Pass;
+		uint32_t Shader;
+		uint32_t Material;
+		uint32_t Model;
+		float Depth;
+		uint32_t FirstInstance;
+		uint32_t NumInstances;
+	};
+
+	struct ModelBufferRange {
+		int32_t FirstVertexIndex;
+		uint32_t FirstIndexIndex;
+		uint32_t NumIndices;
+	};
+
+	/*
+	The commands that switch to each shader and material: those for shader i are ShaderCommands[ShaderCommandOffsets[i]] up to
+	ShaderCommands[ShaderCommandOffsets[i + 1]] (and likewise for materials). Either table may be null if the caller sets that state itself.
+	*/
+	struct DrawStateTables {
+		const RenderCommand* ShaderCommands;
+		const uint32_t* ShaderCommandOffsets;
+		const RenderCommand* MaterialCommands;
+		const uint32_t* MaterialCommandOffsets;
+		const ModelBufferRange* Models;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that orders draws by packed 64-bit keys (with an LSD radix sort), and turns the ordered draws in to render commands,
+	switching shader and material only where they change. Instances can also be ordered by distance from the camera alone.
+	*/
+	class DrawSorter {
+	public:
+		static uint64_t MakeSortKey(const SortKeyLayout& layout, const DrawRecord& record);
+
+		/*
+		Writes the indices of the given records, in sorted order, to outOrder. The sort is stable.
+		*/
+		static void Sort(const SortKeyLayout& layout, const DrawRecord* recordArr, uint32_t numRecords, uint32_t* outOrder);
+
+		/*
+		Sets the Depth of each record to the squared distance of the matching transform's translation from viewPosition (an XYZ triple).
+		*/
+		static void SetDepths(const InstanceTransform* transformArr, uint32_t numRecords, const float* viewPosition, DrawRecord* recordArr);
+
+		/*
+		Writes the indices of the given instances to outOrder, ordered by the squared distance of their translations from viewPosition
+		(an XYZ triple): nearest first, or furthest first if backToFront is true. If groupArr is not null, instances are first ordered by
+		groupArr[i] (e.g. their model index), and only by distance within each group. The sort is stable.
+		*/
+		static void SortByDistance(const InstanceTransform* transformArr, const uint32_t* groupArr, uint32_t numInstances, const float* viewPosition,
+			bool backToFront, uint32_t* outOrder);
+
+		/*
+		Writes the commands for drawing the records in the given order to outCommandArr, and returns the number written. Each shader's and
+		material's commands (where tables are given for them) are written before the first draw that uses them, and again only where the
+		shader or material changes; records with no instances change nothing. If packInstances is true, each record's FirstInstance is
+		ignored and its instances are assumed to be laid out in draw order from firstPackedInstance onwards. Consecutive draws of the same
+		model with contiguous instances and no state change in between are merged in to one.
+		*/
+		static uint32_t EmitCommands(const DrawRecord* recordArr, const uint32_t* order, uint32_t numRecords, const DrawStateTables& tables,
+			bool packInstances, uint32_t firstPackedInstance, RenderCommand* outCommandArr, uint32_t outCommandArrLen);
+	};
+}
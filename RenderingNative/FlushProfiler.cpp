@@ -0,0 +1,72 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "FlushProfiler.h"
+#include "../CoreNative/Platform.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace losgap {
+	std::atomic<bool> FlushProfiler::isEnabled { false };
+	std::mutex contextProfileLock;
+	std::unordered_map<ID3D11DeviceContext*, std::unique_ptr<FlushProfile>> contextProfiles;
+
+	FlushProfile* FlushProfiler::GetContextProfile(ID3D11DeviceContext* deviceContextPtr) {
+		std::lock_guard<std::mutex> lock { contextProfileLock };
+		std::unique_ptr<FlushProfile>& profile = contextProfiles[deviceContextPtr];
+		if (profile == nullptr) profile.reset(new FlushProfile);
+		return profile.get();
+	}
+
+	void FlushProfiler::ReleaseContextProfile(ID3D11DeviceContext* deviceContextPtr) {
+		std::lock_guard<std::mutex> lock { contextProfileLock };
+		contextProfiles.erase(deviceContextPtr);
+	}
+
+	void FlushProfiler::FillSnapshot(const FlushProfile& profile, FlushProfileSnapshot& outSnapshot) {
+		uint64_t ticksPerSecond = static_cast<uint64_t>(Platform::GetTicksPerSecond());
+
+		outSnapshot.NumFlushes = profile.NumFlushes;
+		for (uint32_t i = 0U; i < NUM_RENDER_COMMAND_INSTRUCTIONS; ++i) {
+			outSnapshot.InstructionCounts[i] = profile.InstructionCounts[i];
+			outSnapshot.SkippedCounts[i] = profile.SkippedCounts[i];
+			// Split in to whole seconds and remainder so that long-running totals can't overflow
+			uint64_t ticks = static_cast<uint64_t>(profile.InstructionTicks[i]);
+			outSnapshot.InstructionNanoseconds[i] = (ticks / ticksPerSecond) * 1000000000ULL + (ticks % ticksPerSecond) * 1000000000ULL / ticksPerSecond;
+		}
+		outSnapshot.CBufferBytesWritten = profile.CBufferBytesWritten;
+		outSnapshot.BufferBytesWritten = profile.BufferBytesWritten;
+	}
+
+	uint32_t FlushProfiler::Snapshot(FlushProfileSnapshot* outSnapshotArr, uint32_t arrLen, bool resetAfterwards) {
+		std::lock_guard<std::mutex> lock { contextProfileLock };
+		uint32_t numProfiles = 0U;
+		for (auto& contextProfile : contextProfiles) {
+			if (numProfiles < arrLen) {
+				FlushProfileSnapshot& snapshot = outSnapshotArr[numProfiles];
+				snapshot.DeviceContext = contextProfile.first;
+#ifdef _WIN32
+				snapshot.IsImmediateContext = CBOOL_TO_INTEROP_BOOL(contextProfile.first->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE);
+#else
+				snapshot.IsImmediateContext = INTEROP_BOOL_FALSE; // There are no real device contexts to profile off Windows
+#endif
+				FillSnapshot(*contextProfile.second, snapshot);
+				if (resetAfterwards) contextProfile.second->Reset();
+			}
+			++numProfiles;
+		}
+		return numProfiles;
+	}
+
+	EXPORT(FlushProfiler_SetEnabled, INTEROP_BOOL enabled) {
+		FlushProfiler::SetEnabled(INTEROP_BOOL_TO_CBOOL(enabled));
+		EXPORT_END;
+	}
+
+	EXPORT(FlushProfiler_Snapshot, FlushProfileSnapshot* outSnapshotArr, uint32_t arrLen, INTEROP_BOOL resetAfterwards, uint32_t* outNumProfiles) {
+		*outNumProfiles = FlushProfiler::Snapshot(outSnapshotArr, arrLen, INTEROP_BOOL_TO_CBOOL(resetAfterwards));
+		EXPORT_END;
+	}
+}
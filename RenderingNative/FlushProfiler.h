@@ -0,0 +1,77 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderCommand.h"
+#include <atomic>
+#include <cstring>
+#include "PortableD3D11.h"
+
+namespace losgap {
+	const uint32_t NUM_RENDER_COMMAND_INSTRUCTIONS = static_cast<uint32_t>(RenderCommandInstruction::BufferWrite) + 1U;
+
+	/*
+	Accounting for everything flushed on one device context since the profile was last reset, indexed by RenderCommandInstruction.
+	SkippedCounts are commands the context's RenderStateCache dropped as redundant; they are not included in InstructionCounts.
+	Like the state cache, a profile must only be updated by whichever thread is currently recording on its context.
+	*/
+	struct FlushProfile {
+		uint64_t NumFlushes;
+		uint64_t InstructionCounts[NUM_RENDER_COMMAND_INSTRUCTIONS];
+		uint64_t SkippedCounts[NUM_RENDER_COMMAND_INSTRUCTIONS];
+		int64_t InstructionTicks[NUM_RENDER_COMMAND_INSTRUCTIONS];
+		uint64_t CBufferBytesWritten;
+		uint64_t BufferBytesWritten;
+
+		FlushProfile() { Reset(); }
+		void Reset() { memset(this, 0, sizeof(FlushProfile)); }
+	};
+
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	An interop copy of one context's FlushProfile, with the ticks converted to nanoseconds of CPU time spent translating each
+	instruction on to the context.
+	*/
+	struct FlushProfileSnapshot {
+		ID3D11DeviceContext* DeviceContext;
+		INTEROP_BOOL IsImmediateContext;
+		uint64_t NumFlushes;
+		uint64_t InstructionCounts[NUM_RENDER_COMMAND_INSTRUCTIONS];
+		uint64_t SkippedCounts[NUM_RENDER_COMMAND_INSTRUCTIONS];
+		uint64_t InstructionNanoseconds[NUM_RENDER_COMMAND_INSTRUCTIONS];
+		uint64_t CBufferBytesWritten;
+		uint64_t BufferBytesWritten;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that owns the FlushProfile of every device context. Profiling is off by default; while it is, flushing costs
+	one flag check per stream and nothing per command.
+	*/
+	class FlushProfiler {
+	private:
+		static std::atomic<bool> isEnabled;
+
+	public:
+		static bool IsEnabled() { return isEnabled.load(std::memory_order_relaxed); }
+		static void SetEnabled(bool enabled) { isEnabled.store(enabled, std::memory_order_relaxed); }
+
+		/*
+		Returns the profile for the given context, creating it on first use. ReleaseContextProfile() must be called before the context
+		itself is released (as its address may then be reused by a new context).
+		*/
+		static FlushProfile* GetContextProfile(ID3D11DeviceContext* deviceContextPtr);
+		static void ReleaseContextProfile(ID3D11DeviceContext* deviceContextPtr);
+
+		static void FillSnapshot(const FlushProfile& profile, FlushProfileSnapshot& outSnapshot);
+
+		/*
+		Writes up to arrLen context profiles in to outSnapshotArr and returns the number of contexts profiled. If resetAfterwards is
+		true every profile that was written starts again from zero (e.g. to report per-frame values); any that didn't fit keep their
+		totals, so nothing is lost. Must not be called while any context is flushing.
+		*/
+		static uint32_t Snapshot(FlushProfileSnapshot* outSnapshotArr, uint32_t arrLen, bool resetAfterwards);
+	};
+}
@@ -0,0 +1,230 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "FrustumCuller.h"
+#include "../CoreNative/FrameArena.h"
+#include <cmath>
+
+#define FRUSTUM_CULLER_SSE2
+#include <emmintrin.h>
+
+namespace losgap {
+	FrustumPlanes FrustumCuller::CreateFrustum(const float* viewProjMat) {
+		if (viewProjMat == nullptr) throw LosgapException { "View/projection matrix must not be null." };
+
+		// Clip-space x, y and z are the dot products of the position with columns 0, 1 and 2 of the matrix, and w with column 3.
+		// Each plane is then w +/- one of x, y or z (except near, which is just z >= 0 with D3D's clip depth).
+		const float* m = viewProjMat;
+		const uint32_t PLANE_COLUMNS[NUM_FRUSTUM_PLANES] = { 0U, 0U, 1U, 1U, 2U, 2U };
+		const float PLANE_COLUMN_SIGNS[NUM_FRUSTUM_PLANES] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+		const float PLANE_W_WEIGHTS[NUM_FRUSTUM_PLANES] = { 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+
+		FrustumPlanes result;
+		for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+			float* plane = result.Planes[p];
+			for (uint32_t row = 0U; row < 4U; ++row) {
+				plane[row] = PLANE_W_WEIGHTS[p] * m[row * 4U + 3U] + PLANE_COLUMN_SIGNS[p] * m[row * 4U + PLANE_COLUMNS[p]];
+			}
+
+			float normalLength = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if (normalLength > 0.0f) {
+				for (uint32_t c = 0U; c < 4U; ++c) plane[c] /= normalLength;
+			}
+		}
+		return result;
+	}
+	EXPORT_FAST(FrustumCuller_CreateFrustum, const float* viewProjMat, FrustumPlanes* outFrustum) {
+		*outFrustum = FrustumCuller::CreateFrustum(viewProjMat);
+		EXPORT_FAST_END;
+	}
+
+	FrustumPlanes FrustumCuller::CreateShadowCasterFrustum(const float* lightViewProjMat) {
+		FrustumPlanes result = CreateFrustum(lightViewProjMat);
+
+		// A plane that every sphere is inside of (distance is always 1)
+		float* nearPlane = result.Planes[NEAR_FRUSTUM_PLANE];
+		nearPlane[0] = 0.0f;
+		nearPlane[1] = 0.0f;
+		nearPlane[2] = 0.0f;
+		nearPlane[3] = 1.0f;
+		return result;
+	}
+	EXPORT_FAST(FrustumCuller_CreateShadowCasterFrustum, const float* lightViewProjMat, FrustumPlanes* outFrustum) {
+		*outFrustum = FrustumCuller::CreateShadowCasterFrustum(lightViewProjMat);
+		EXPORT_FAST_END;
+	}
+
+	FrustumPlanes FrustumCuller::CreateShadowReceiverFrustum(const float* receiverViewProjMat, const float* lightDirection, float shadowLength) {
+		if (lightDirection == nullptr) throw LosgapException { "Light direction must not be null." };
+		if (shadowLength < 0.0f) throw LosgapException { "Shadow length must not be negative." };
+		FrustumPlanes result = CreateFrustum(receiverViewProjMat);
+
+		// A swept sphere is furthest inside a plane at one end of its sweep, so each plane only needs to move back by however far the
+		// far end gets in to it (if it gets further in at all)
+		for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+			float* plane = result.Planes[p];
+			float sweepReach = (plane[0] * lightDirection[0] + plane[1] * lightDirection[1] + plane[2] * lightDirection[2]) * shadowLength;
+			if (sweepReach > 0.0f) plane[3] += sweepReach;
+		}
+		return result;
+	}
+	EXPORT_FAST(FrustumCuller_CreateShadowReceiverFrustum, const float* receiverViewProjMat, const float* lightDirection, float shadowLength,
+		FrustumPlanes* outFrustum) {
+		*outFrustum = FrustumCuller::CreateShadowReceiverFrustum(receiverViewProjMat, lightDirection, shadowLength);
+		EXPORT_FAST_END;
+	}
+
+	/*
+	Writes the indices of the visible spheres in [firstIndex, endIndex) to outVisibleIndices, starting at numVisible, and returns the
+	new number visible. The distance is summed in the same order as the SSE2 path so that both agree exactly.
+	*/
+	uint32_t CullSphereRange(const FrustumPlanes& frustum, const BoundingSphere* sphereArr, uint32_t firstIndex, uint32_t endIndex,
+		uint32_t* outVisibleIndices, uint32_t numVisible) {
+		for (uint32_t i = firstIndex; i < endIndex; ++i) {
+			const BoundingSphere& sphere = sphereArr[i];
+			bool outside = false;
+			for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+				const float* plane = frustum.Planes[p];
+				float distance = plane[0] * sphere.X + plane[1] * sphere.Y + plane[2] * sphere.Z + plane[3];
+				if (distance + sphere.Radius < 0.0f) {
+					outside = true;
+					break;
+				}
+			}
+			if (!outside) outVisibleIndices[numVisible++] = i;
+		}
+		return numVisible;
+	}
+
+	uint32_t FrustumCuller::CullSpheresScalar(const FrustumPlanes& frustum, const BoundingSphere* sphereArr, uint32_t numSpheres, uint32_t* outVisibleIndices) {
+		return CullSphereRange(frustum, sphereArr, 0U, numSpheres, outVisibleIndices, 0U);
+	}
+
+	uint32_t FrustumCuller::CullSpheres(const FrustumPlanes& frustum, const BoundingSphere* sphereArr, uint32_t numSpheres, uint32_t* outVisibleIndices) {
+		uint32_t numVisible = 0U;
+		uint32_t i = 0U;
+#ifdef FRUSTUM_CULLER_SSE2
+		__m128 planeComponents[NUM_FRUSTUM_PLANES][4];
+		for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+			for (uint32_t c = 0U; c < 4U; ++c) planeComponents[p][c] = _mm_set1_ps(frustum.Planes[p][c]);
+		}
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; i + 4U <= numSpheres; i += 4U) {
+			// Four spheres in, four lanes each of X, Y, Z and Radius out
+			__m128 x = _mm_loadu_ps(&sphereArr[i].X);
+			__m128 y = _mm_loadu_ps(&sphereArr[i + 1U].X);
+			__m128 z = _mm_loadu_ps(&sphereArr[i + 2U].X);
+			__m128 radius = _mm_loadu_ps(&sphereArr[i + 3U].X);
+			_MM_TRANSPOSE4_PS(x, y, z, radius);
+
+			__m128 outside = zero;
+			for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+				__m128 distance = _mm_add_ps(_mm_mul_ps(planeComponents[p][0], x), _mm_mul_ps(planeComponents[p][1], y));
+				distance = _mm_add_ps(distance, _mm_mul_ps(planeComponents[p][2], z));
+				distance = _mm_add_ps(distance, planeComponents[p][3]);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			// Every index is written, but the count only moves past the visible ones
+			int visibleMask = ~_mm_movemask_ps(outside);
+			outVisibleIndices[numVisible] = i;
+			numVisible += visibleMask & 1;
+			outVisibleIndices[numVisible] = i + 1U;
+			numVisible += (visibleMask >> 1) & 1;
+			outVisibleIndices[numVisible] = i + 2U;
+			numVisible += (visibleMask >> 2) & 1;
+			outVisibleIndices[numVisible] = i + 3U;
+			numVisible += (visibleMask >> 3) & 1;
+		}
+#endif
+		return CullSphereRange(frustum, sphereArr, i, numSpheres, outVisibleIndices, numVisible);
+	}
+	EXPORT_FAST(FrustumCuller_CullSpheres, const FrustumPlanes* frustum, const BoundingSphere* sphereArr, uint32_t numSpheres,
+		uint32_t* outVisibleIndices, uint32_t* outNumVisible) {
+		*outNumVisible = FrustumCuller::CullSpheres(*frustum, sphereArr, numSpheres, outVisibleIndices);
+		EXPORT_FAST_END;
+	}
+
+	void FrustumCuller::TransformSpheres(const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+		const uint32_t* modelIndexArr, uint32_t numInstances, BoundingSphere* outWorldSphereArr) {
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			uint32_t modelIndex = modelIndexArr[i];
+			if (modelIndex >= numModels) {
+				throw LosgapException { "Model index " + std::to_string(modelIndex) + " is out of range (" + std::to_string(numModels) + " models)." };
+			}
+			const BoundingSphere& modelSphere = modelSphereArr[modelIndex];
+			const InstanceTransform& transform = transformArr[i];
+
+			float scaledX = modelSphere.X * transform.ScaleX;
+			float scaledY = modelSphere.Y * transform.ScaleY;
+			float scaledZ = modelSphere.Z * transform.ScaleZ;
+
+			// Transform.AsMatrix normalises the rotation first, so we do too (v' = v + 2w(q x v) + 2q x (q x v))
+			float qX = transform.RotationX, qY = transform.RotationY, qZ = transform.RotationZ, qW = transform.RotationW;
+			float rotationLengthSq = qX * qX + qY * qY + qZ * qZ + qW * qW;
+			if (rotationLengthSq > 0.0f) {
+				float invLength = 1.0f / std::sqrt(rotationLengthSq);
+				qX *= invLength;
+				qY *= invLength;
+				qZ *= invLength;
+				qW *= invLength;
+			}
+			float tX = 2.0f * (qY * scaledZ - qZ * scaledY);
+			float tY = 2.0f * (qZ * scaledX - qX * scaledZ);
+			float tZ = 2.0f * (qX * scaledY - qY * scaledX);
+
+			float maxScale = std::fabs(transform.ScaleX);
+			if (std::fabs(transform.ScaleY) > maxScale) maxScale = std::fabs(transform.ScaleY);
+			if (std::fabs(transform.ScaleZ) > maxScale) maxScale = std::fabs(transform.ScaleZ);
+
+			BoundingSphere& worldSphere = outWorldSphereArr[i];
+			worldSphere.X = transform.TranslationX + scaledX + qW * tX + (qY * tZ - qZ * tY);
+			worldSphere.Y = transform.TranslationY + scaledY + qW * tY + (qZ * tX - qX * tZ);
+			worldSphere.Z = transform.TranslationZ + scaledZ + qW * tZ + (qX * tY - qY * tX);
+			worldSphere.Radius = modelSphere.Radius * maxScale;
+		}
+	}
+
+	uint32_t FrustumCuller::CullInstances(const FrustumPlanes& frustum, const BoundingSphere* modelSphereArr, uint32_t numModels,
+		const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices) {
+		if (numInstances == 0U) return 0U;
+
+		BoundingSphere* worldSphereArr = static_cast<BoundingSphere*>(FrameArena::GetThreadArena()->Allocate(numInstances * sizeof(BoundingSphere)));
+		TransformSpheres(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, worldSphereArr);
+		return CullSpheres(frustum, worldSphereArr, numInstances, outVisibleIndices);
+	}
+	EXPORT_FAST(FrustumCuller_CullInstances, const FrustumPlanes* frustum, const BoundingSphere* modelSphereArr, uint32_t numModels,
+		const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices, uint32_t* outNumVisible) {
+		*outNumVisible = FrustumCuller::CullInstances(*frustum, modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, outVisibleIndices);
+		EXPORT_FAST_END;
+	}
+
+	uint32_t FrustumCuller::CullShadowCasters(const FrustumPlanes& casterFrustum, const FrustumPlanes* receiverFrustum, const BoundingSphere* modelSphereArr,
+		uint32_t numModels, const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices) {
+		if (numInstances == 0U) return 0U;
+
+		FrameArena* arena = FrameArena::GetThreadArena();
+		BoundingSphere* worldSphereArr = static_cast<BoundingSphere*>(arena->Allocate(numInstances * sizeof(BoundingSphere)));
+		TransformSpheres(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, worldSphereArr);
+		uint32_t numCasters = CullSpheres(casterFrustum, worldSphereArr, numInstances, outVisibleIndices);
+		if (receiverFrustum == nullptr || numCasters == 0U) return numCasters;
+
+		// Gather the casters' spheres so that the second test is four at a time too, then map its results back to instance indices
+		// (they're ascending, so mapping in place never overwrites an index we still need)
+		BoundingSphere* casterSphereArr = static_cast<BoundingSphere*>(arena->Allocate(numCasters * sizeof(BoundingSphere)));
+		for (uint32_t i = 0U; i < numCasters; ++i) casterSphereArr[i] = worldSphereArr[outVisibleIndices[i]];
+		uint32_t* reachingCasterArr = static_cast<uint32_t*>(arena->Allocate(numCasters * sizeof(uint32_t)));
+		uint32_t numReaching = CullSpheres(*receiverFrustum, casterSphereArr, numCasters, reachingCasterArr);
+		for (uint32_t i = 0U; i < numReaching; ++i) outVisibleIndices[i] = outVisibleIndices[reachingCasterArr[i]];
+		return numReaching;
+	}
+	EXPORT_FAST(FrustumCuller_CullShadowCasters, const FrustumPlanes* casterFrustum, const FrustumPlanes* receiverFrustum, const BoundingSphere* modelSphereArr,
+		uint32_t numModels, const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices,
+		uint32_t* outNumVisible) {
+		*outNumVisible = FrustumCuller::CullShadowCasters(*casterFrustum, receiverFrustum, modelSphereArr, numModels, transformArr, modelIndexArr,
+			numInstances, outVisibleIndices);
+		EXPORT_FAST_END;
+	}
+}
@@ -0,0 +1,81 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "InstanceTransform.h"
+
+namespace losgap {
+	const uint32_t NUM_FRUSTUM_PLANES = 6U;
+	const uint32_t NEAR_FRUSTUM_PLANE = 4U;
+
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct BoundingSphere {
+		float X;
+		float Y;
+		float Z;
+		float Radius;
+	};
+
+	/*
+	Left, right, bottom, top, near, far. Each plane is (Nx, Ny, Nz, D) with a unit normal facing in to the frustum, so a point P is on
+	the inside of a plane when dot(N, P) + D >= 0.
+	*/
+	struct FrustumPlanes {
+		float Planes[NUM_FRUSTUM_PLANES][4];
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that tests bounding spheres against a view frustum, four at a time with SSE2, and writes out the indices of the
+	ones that are at least partially inside (in ascending order). Output arrays must be at least as long as the input.
+	*/
+	class FrustumCuller {
+	public:
+		/*
+		viewProjMat is a row-major view * projection matrix for row vectors (i.e. not transposed), with D3D's 0 to 1 clip depth.
+		*/
+		static FrustumPlanes CreateFrustum(const float* viewProjMat);
+
+		/*
+		The frustum of a shadow-casting light camera, extended back towards the light: anything between the light and its near plane can
+		still throw a shadow in to view, so the near plane is dropped.
+		*/
+		static FrustumPlanes CreateShadowCasterFrustum(const float* lightViewProjMat);
+
+		/*
+		The frustum of a camera that receives shadows, pushed back against lightDirection (which must be unit length) by up to
+		shadowLength, so that it contains any sphere whose shadow (the sphere swept along lightDirection for shadowLength) reaches the
+		camera's view. Only directional lights (i.e. orthographic light cameras) cast shadows along one direction like this.
+		*/
+		static FrustumPlanes CreateShadowReceiverFrustum(const float* receiverViewProjMat, const float* lightDirection, float shadowLength);
+
+		static uint32_t CullSpheres(const FrustumPlanes& frustum, const BoundingSphere* sphereArr, uint32_t numSpheres, uint32_t* outVisibleIndices);
+
+		/*
+		The plain one-at-a-time version of CullSpheres(), kept as a reference for it.
+		*/
+		static uint32_t CullSpheresScalar(const FrustumPlanes& frustum, const BoundingSphere* sphereArr, uint32_t numSpheres, uint32_t* outVisibleIndices);
+
+		/*
+		Places modelSphereArr[modelIndexArr[i]] in the world with transformArr[i] (in the same way as Transform.AsMatrix), for every i.
+		Spheres grow by the instance's largest scale axis, so non-uniformly scaled instances get a conservative fit.
+		*/
+		static void TransformSpheres(const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+			const uint32_t* modelIndexArr, uint32_t numInstances, BoundingSphere* outWorldSphereArr);
+
+		/*
+		TransformSpheres() followed by CullSpheres(), with the world spheres kept in the calling thread's frame arena.
+		*/
+		static uint32_t CullInstances(const FrustumPlanes& frustum, const BoundingSphere* modelSphereArr, uint32_t numModels,
+			const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices);
+
+		/*
+		Like CullInstances(), but against a caster frustum from CreateShadowCasterFrustum() and then, if receiverFrustum is not null,
+		against one from CreateShadowReceiverFrustum() as well, so that only casters whose shadow may be seen are kept.
+		*/
+		static uint32_t CullShadowCasters(const FrustumPlanes& casterFrustum, const FrustumPlanes* receiverFrustum, const BoundingSphere* modelSphereArr,
+			uint32_t numModels, const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices);
+	};
+}
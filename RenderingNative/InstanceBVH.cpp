@@ -0,0 +1,535 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "InstanceBVH.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace losgap {
+	const uint32_t SUBTREE_INSIDE_FLAG = 0x80000000U; // Marks query stack entries whose whole subtree has already passed the test
+	const uint32_t QUERY_STACK_LENGTH = 64U;
+
+	enum BVHNodeTestResult {
+		NodeOutside = 0,
+		NodeIntersecting = 1,
+		NodeInside = 2
+	};
+
+	float HalfSurfaceArea(const float* min, const float* max) {
+		float x = max[0] - min[0];
+		float y = max[1] - min[1];
+		float z = max[2] - min[2];
+		return x * y + y * z + z * x;
+	}
+
+	void UnionBounds(const float* minA, const float* maxA, const float* minB, const float* maxB, float* outMin, float* outMax) {
+		for (uint32_t c = 0U; c < 3U; ++c) {
+			outMin[c] = minA[c] < minB[c] ? minA[c] : minB[c];
+			outMax[c] = maxA[c] > maxB[c] ? maxA[c] : maxB[c];
+		}
+	}
+
+	BoundingSphere PlaceSphere(const BoundingSphere& modelSphere, const InstanceTransform& transform) {
+		const uint32_t modelIndex = 0U;
+		BoundingSphere result;
+		FrustumCuller::TransformSpheres(&modelSphere, 1U, &transform, &modelIndex, 1U, &result);
+		return result;
+	}
+
+	InstanceBVH::InstanceBVH() : root(NULL_BVH_NODE), freeList(NULL_BVH_NODE) { }
+
+	uint32_t InstanceBVH::GetCount() const {
+		return static_cast<uint32_t>(leafMap.size());
+	}
+	EXPORT_FAST(InstanceBVH_GetCount, const InstanceBVH* bvh, uint32_t* outCount) {
+		*outCount = bvh->GetCount();
+		EXPORT_FAST_END;
+	}
+
+	uint32_t InstanceBVH::GetHeight() const {
+		return root == NULL_BVH_NODE ? 0U : static_cast<uint32_t>(nodes[root].Height);
+	}
+	EXPORT_FAST(InstanceBVH_GetHeight, const InstanceBVH* bvh, uint32_t* outHeight) {
+		*outHeight = bvh->GetHeight();
+		EXPORT_FAST_END;
+	}
+
+	InstanceBVH* CreateInstanceBVH() {
+		return new InstanceBVH { };
+	}
+	EXPORT_FAST(InstanceBVH_Create, InstanceBVH** outBVH) {
+		*outBVH = CreateInstanceBVH();
+		EXPORT_FAST_END;
+	}
+
+	EXPORT_FAST(InstanceBVH_Destroy, InstanceBVH* bvh) {
+		delete bvh;
+		EXPORT_FAST_END;
+	}
+
+	uint32_t InstanceBVH::AllocateNode() {
+		if (freeList == NULL_BVH_NODE) {
+			nodes.push_back(Node { });
+			return static_cast<uint32_t>(nodes.size() - 1U);
+		}
+		uint32_t result = freeList;
+		freeList = nodes[result].Parent;
+		return result;
+	}
+
+	void InstanceBVH::FreeNode(uint32_t node) {
+		nodes[node].Parent = freeList;
+		nodes[node].Height = -1;
+		freeList = node;
+	}
+
+	uint32_t InstanceBVH::CreateLeaf(uint64_t key, const BoundingSphere& worldSphere, float margin) {
+		uint32_t leaf = AllocateNode();
+		Node& node = nodes[leaf];
+		float extent = worldSphere.Radius * (1.0f + margin);
+		node.Bounds.Min[0] = worldSphere.X - extent;
+		node.Bounds.Min[1] = worldSphere.Y - extent;
+		node.Bounds.Min[2] = worldSphere.Z - extent;
+		node.Bounds.Max[0] = worldSphere.X + extent;
+		node.Bounds.Max[1] = worldSphere.Y + extent;
+		node.Bounds.Max[2] = worldSphere.Z + extent;
+		node.Sphere = worldSphere;
+		node.Key = key;
+		node.Parent = NULL_BVH_NODE;
+		node.ChildA = NULL_BVH_NODE;
+		node.ChildB = NULL_BVH_NODE;
+		node.Height = 0;
+		leafMap[key] = leaf;
+		return leaf;
+	}
+
+	void InstanceBVH::RefitNode(uint32_t node) {
+		Node& n = nodes[node];
+		const Node& a = nodes[n.ChildA];
+		const Node& b = nodes[n.ChildB];
+		UnionBounds(a.Bounds.Min, a.Bounds.Max, b.Bounds.Min, b.Bounds.Max, n.Bounds.Min, n.Bounds.Max);
+		n.Height = 1 + (a.Height > b.Height ? a.Height : b.Height);
+	}
+
+	uint32_t InstanceBVH::Balance(uint32_t node) {
+		/*
+		As in Box2D's dynamic tree: if one child is more than one level taller than the other, the taller child takes the node's place.
+		The node keeps its shorter child and takes the shorter of the taller child's children in its place; the taller child keeps its
+		own taller child alongside the node. Each rotation only moves two subtrees, and keeps incremental trees (e.g. of instances
+		added in a line) from degenerating in to lists.
+		*/
+		Node& n = nodes[node];
+		if (n.ChildA == NULL_BVH_NODE) return node;
+		int32_t balance = nodes[n.ChildB].Height - nodes[n.ChildA].Height;
+		if (balance >= -1 && balance <= 1) return node;
+
+		uint32_t up = balance > 1 ? n.ChildB : n.ChildA;
+		Node& upNode = nodes[up];
+		bool upChildAIsTaller = nodes[upNode.ChildA].Height > nodes[upNode.ChildB].Height;
+		uint32_t taller = upChildAIsTaller ? upNode.ChildA : upNode.ChildB;
+		uint32_t shorter = upChildAIsTaller ? upNode.ChildB : upNode.ChildA;
+
+		upNode.Parent = n.Parent;
+		if (n.Parent == NULL_BVH_NODE) root = up;
+		else if (nodes[n.Parent].ChildA == node) nodes[n.Parent].ChildA = up;
+		else nodes[n.Parent].ChildB = up;
+		upNode.ChildA = node;
+		upNode.ChildB = taller;
+		n.Parent = up;
+		if (n.ChildA == up) n.ChildA = shorter;
+		else n.ChildB = shorter;
+		nodes[shorter].Parent = node;
+
+		RefitNode(node);
+		RefitNode(up);
+		return up;
+	}
+
+	void InstanceBVH::RefitFrom(uint32_t node) {
+		while (node != NULL_BVH_NODE) {
+			node = Balance(node);
+			RefitNode(node);
+			node = nodes[node].Parent;
+		}
+	}
+
+	void InstanceBVH::InsertLeaf(uint32_t leaf) {
+		if (root == NULL_BVH_NODE) {
+			root = leaf;
+			nodes[leaf].Parent = NULL_BVH_NODE;
+			return;
+		}
+
+		/*
+		Find the sibling that adds the least surface area to the tree: the cost of pairing with a node is the area of the new parent
+		plus however much every ancestor grows by. Ancestors' growth is the same for a node's whole subtree, and the new parent can be
+		no smaller than the leaf, so subtrees that can't beat the best cost found so far are skipped.
+		*/
+		const NodeBounds leafBounds = nodes[leaf].Bounds;
+		float leafArea = HalfSurfaceArea(leafBounds.Min, leafBounds.Max);
+		float unionMin[3], unionMax[3];
+		uint32_t bestSibling = root;
+		float bestCost = FLT_MAX;
+		insertionWorkspace.clear();
+		insertionWorkspace.push_back(std::make_pair(root, 0.0f));
+		while (!insertionWorkspace.empty()) {
+			uint32_t candidate = insertionWorkspace.back().first;
+			float inheritedCost = insertionWorkspace.back().second;
+			insertionWorkspace.pop_back();
+
+			const Node& candidateNode = nodes[candidate];
+			UnionBounds(leafBounds.Min, leafBounds.Max, candidateNode.Bounds.Min, candidateNode.Bounds.Max, unionMin, unionMax);
+			float directCost = HalfSurfaceArea(unionMin, unionMax);
+			float cost = directCost + inheritedCost;
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestSibling = candidate;
+			}
+
+			if (candidateNode.ChildA == NULL_BVH_NODE) continue;
+			float childInheritedCost = inheritedCost + directCost - HalfSurfaceArea(candidateNode.Bounds.Min, candidateNode.Bounds.Max);
+			if (leafArea + childInheritedCost >= bestCost) continue;
+			insertionWorkspace.push_back(std::make_pair(candidateNode.ChildA, childInheritedCost));
+			insertionWorkspace.push_back(std::make_pair(candidateNode.ChildB, childInheritedCost));
+		}
+
+		// Put the leaf and its sibling under a new parent, where the sibling used to be, then refit and rebalance back to the root
+		uint32_t oldParent = nodes[bestSibling].Parent;
+		uint32_t newParent = AllocateNode();
+		nodes[newParent].Parent = oldParent;
+		nodes[newParent].ChildA = bestSibling;
+		nodes[newParent].ChildB = leaf;
+		nodes[bestSibling].Parent = newParent;
+		nodes[leaf].Parent = newParent;
+		if (oldParent == NULL_BVH_NODE) root = newParent;
+		else if (nodes[oldParent].ChildA == bestSibling) nodes[oldParent].ChildA = newParent;
+		else nodes[oldParent].ChildB = newParent;
+		RefitFrom(newParent);
+	}
+
+	void InstanceBVH::RemoveLeaf(uint32_t leaf) {
+		if (leaf == root) {
+			root = NULL_BVH_NODE;
+			return;
+		}
+
+		// The leaf's sibling takes its parent's place
+		uint32_t parent = nodes[leaf].Parent;
+		uint32_t grandparent = nodes[parent].Parent;
+		uint32_t sibling = nodes[parent].ChildA == leaf ? nodes[parent].ChildB : nodes[parent].ChildA;
+		nodes[sibling].Parent = grandparent;
+		if (grandparent == NULL_BVH_NODE) root = sibling;
+		else if (nodes[grandparent].ChildA == parent) nodes[grandparent].ChildA = sibling;
+		else nodes[grandparent].ChildB = sibling;
+		FreeNode(parent);
+		RefitFrom(grandparent);
+	}
+
+	void InstanceBVH::Insert(uint64_t key, const BoundingSphere& modelSphere, const InstanceTransform& transform) {
+		if (leafMap.find(key) != leafMap.end()) throw LosgapException { "Instance " + std::to_string(key) + " is already in the BVH." };
+		InsertLeaf(CreateLeaf(key, PlaceSphere(modelSphere, transform), DYNAMIC_BVH_MARGIN));
+	}
+	EXPORT_FAST(InstanceBVH_Insert, InstanceBVH* bvh, uint64_t key, const BoundingSphere* modelSphere, const InstanceTransform* transform) {
+		bvh->Insert(key, *modelSphere, *transform);
+		EXPORT_FAST_END;
+	}
+
+	bool InstanceBVH::Update(uint64_t key, const BoundingSphere& modelSphere, const InstanceTransform& transform) {
+		auto leafIt = leafMap.find(key);
+		if (leafIt == leafMap.end()) return false;
+		uint32_t leaf = leafIt->second;
+		BoundingSphere worldSphere = PlaceSphere(modelSphere, transform);
+
+		// Still inside its fattened bounds: only the exact sphere (which queries test leaves against) needs changing
+		const NodeBounds& bounds = nodes[leaf].Bounds;
+		if (worldSphere.X - worldSphere.Radius >= bounds.Min[0] && worldSphere.X + worldSphere.Radius <= bounds.Max[0]
+			&& worldSphere.Y - worldSphere.Radius >= bounds.Min[1] && worldSphere.Y + worldSphere.Radius <= bounds.Max[1]
+			&& worldSphere.Z - worldSphere.Radius >= bounds.Min[2] && worldSphere.Z + worldSphere.Radius <= bounds.Max[2]) {
+			nodes[leaf].Sphere = worldSphere;
+			return true;
+		}
+
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+		InsertLeaf(CreateLeaf(key, worldSphere, DYNAMIC_BVH_MARGIN));
+		return true;
+	}
+	EXPORT_FAST(InstanceBVH_Update, InstanceBVH* bvh, uint64_t key, const BoundingSphere* modelSphere, const InstanceTransform* transform,
+		INTEROP_BOOL* outFound) {
+		*outFound = CBOOL_TO_INTEROP_BOOL(bvh->Update(key, *modelSphere, *transform));
+		EXPORT_FAST_END;
+	}
+
+	bool InstanceBVH::Remove(uint64_t key) {
+		auto leafIt = leafMap.find(key);
+		if (leafIt == leafMap.end()) return false;
+		uint32_t leaf = leafIt->second;
+		leafMap.erase(leafIt);
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+		return true;
+	}
+	EXPORT_FAST(InstanceBVH_Remove, InstanceBVH* bvh, uint64_t key, INTEROP_BOOL* outRemoved) {
+		*outRemoved = CBOOL_TO_INTEROP_BOOL(bvh->Remove(key));
+		EXPORT_FAST_END;
+	}
+
+	uint32_t InstanceBVH::BuildRange(uint32_t* leafArr, uint32_t numLeaves, uint32_t* scratchArr) {
+		if (numLeaves == 1U) return leafArr[0];
+
+		// Split across the longest axis of the leaves' centres
+		float centreMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float centreMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t i = 0U; i < numLeaves; ++i) {
+			const BoundingSphere& sphere = nodes[leafArr[i]].Sphere;
+			const float centre[3] = { sphere.X, sphere.Y, sphere.Z };
+			UnionBounds(centreMin, centreMax, centre, centre, centreMin, centreMax);
+		}
+		uint32_t axis = 0U;
+		for (uint32_t c = 1U; c < 3U; ++c) {
+			if (centreMax[c] - centreMin[c] > centreMax[axis] - centreMin[axis]) axis = c;
+		}
+		float axisExtent = centreMax[axis] - centreMin[axis];
+
+		uint32_t numLeft = numLeaves >> 1;
+		if (axisExtent > 0.0f) {
+			// Bin the leaves by centre, then take the boundary between bins that gives the lowest SAH cost
+			uint32_t binCounts[SAH_BUILD_BINS] = { };
+			float binMin[SAH_BUILD_BINS][3], binMax[SAH_BUILD_BINS][3];
+			for (uint32_t b = 0U; b < SAH_BUILD_BINS; ++b) {
+				for (uint32_t c = 0U; c < 3U; ++c) {
+					binMin[b][c] = FLT_MAX;
+					binMax[b][c] = -FLT_MAX;
+				}
+			}
+			float binScale = static_cast<float>(SAH_BUILD_BINS) / axisExtent;
+			for (uint32_t i = 0U; i < numLeaves; ++i) {
+				const Node& leaf = nodes[leafArr[i]];
+				const float centre[3] = { leaf.Sphere.X, leaf.Sphere.Y, leaf.Sphere.Z };
+				uint32_t bin = static_cast<uint32_t>((centre[axis] - centreMin[axis]) * binScale);
+				if (bin >= SAH_BUILD_BINS) bin = SAH_BUILD_BINS - 1U;
+				scratchArr[i] = bin;
+				++binCounts[bin];
+				UnionBounds(binMin[bin], binMax[bin], leaf.Bounds.Min, leaf.Bounds.Max, binMin[bin], binMax[bin]);
+			}
+
+			float rightAreas[SAH_BUILD_BINS];
+			float sweepMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float sweepMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (uint32_t b = SAH_BUILD_BINS - 1U; b > 0U; --b) {
+				UnionBounds(sweepMin, sweepMax, binMin[b], binMax[b], sweepMin, sweepMax);
+				rightAreas[b] = HalfSurfaceArea(sweepMin, sweepMax); // Only read when there's at least one leaf on the right
+			}
+			float bestCost = FLT_MAX;
+			uint32_t bestBoundary = 1U;
+			uint32_t leftCount = 0U;
+			for (uint32_t c = 0U; c < 3U; ++c) {
+				sweepMin[c] = FLT_MAX;
+				sweepMax[c] = -FLT_MAX;
+			}
+			for (uint32_t boundary = 1U; boundary < SAH_BUILD_BINS; ++boundary) {
+				leftCount += binCounts[boundary - 1U];
+				UnionBounds(sweepMin, sweepMax, binMin[boundary - 1U], binMax[boundary - 1U], sweepMin, sweepMax);
+				if (leftCount == 0U || leftCount == numLeaves) continue;
+				float cost = leftCount * HalfSurfaceArea(sweepMin, sweepMax) + (numLeaves - leftCount) * rightAreas[boundary];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestBoundary = boundary;
+					numLeft = leftCount;
+				}
+			}
+
+			// Partition (keeping the leaves' relative order, so builds are repeatable)
+			uint32_t* partitioned = scratchArr + numLeaves;
+			uint32_t leftCursor = 0U, rightCursor = numLeft;
+			for (uint32_t i = 0U; i < numLeaves; ++i) {
+				if (scratchArr[i] < bestBoundary) partitioned[leftCursor++] = leafArr[i];
+				else partitioned[rightCursor++] = leafArr[i];
+			}
+			memcpy(leafArr, partitioned, numLeaves * sizeof(uint32_t));
+		}
+
+		uint32_t childA = BuildRange(leafArr, numLeft, scratchArr);
+		uint32_t childB = BuildRange(leafArr + numLeft, numLeaves - numLeft, scratchArr);
+		uint32_t result = AllocateNode();
+		nodes[result].ChildA = childA;
+		nodes[result].ChildB = childB;
+		nodes[result].Parent = NULL_BVH_NODE;
+		nodes[childA].Parent = result;
+		nodes[childB].Parent = result;
+		const Node& a = nodes[childA];
+		const Node& b = nodes[childB];
+		UnionBounds(a.Bounds.Min, a.Bounds.Max, b.Bounds.Min, b.Bounds.Max, nodes[result].Bounds.Min, nodes[result].Bounds.Max);
+		nodes[result].Height = 1 + (a.Height > b.Height ? a.Height : b.Height);
+		return result;
+	}
+
+	void InstanceBVH::Build(const uint64_t* keyArr, const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+		const uint32_t* modelIndexArr, uint32_t numInstances) {
+		nodes.clear();
+		leafMap.clear();
+		root = NULL_BVH_NODE;
+		freeList = NULL_BVH_NODE;
+		if (numInstances == 0U) return;
+
+		// Builds happen once per level load, usually away from the render thread, so these aren't worth taking from a FrameArena
+		std::vector<BoundingSphere> worldSpheres(numInstances);
+		FrustumCuller::TransformSpheres(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, worldSpheres.data());
+
+		nodes.reserve(numInstances * 2U - 1U);
+		leafMap.reserve(numInstances);
+		std::vector<uint32_t> leaves(numInstances);
+		std::vector<uint32_t> scratch(numInstances * 2U);
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			if (leafMap.find(keyArr[i]) != leafMap.end()) throw LosgapException { "Instance " + std::to_string(keyArr[i]) + " is given more than once." };
+			leaves[i] = CreateLeaf(keyArr[i], worldSpheres[i], 0.0f);
+		}
+		root = BuildRange(leaves.data(), numInstances, scratch.data());
+	}
+	EXPORT_FAST(InstanceBVH_Build, InstanceBVH* bvh, const uint64_t* keyArr, const BoundingSphere* modelSphereArr, uint32_t numModels,
+		const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances) {
+		bvh->Build(keyArr, modelSphereArr, numModels, transformArr, modelIndexArr, numInstances);
+		EXPORT_FAST_END;
+	}
+
+	template <typename TNodeTest, typename TLeafTest>
+	uint32_t InstanceBVH::Query(const TNodeTest& nodeTest, const TLeafTest& leafTest, uint64_t* outKeyArr, uint32_t outKeyArrLen) const {
+		if (root == NULL_BVH_NODE) return 0U;
+
+		// A depth-first walk never holds more than one entry per level (plus the one being split). Queries come from game logic as well
+		// as rendering, so the stack can't come from a FrameArena (only the render thread's is reset); it only touches the heap for
+		// unusually deep trees.
+		uint32_t localStack[QUERY_STACK_LENGTH];
+		std::vector<uint32_t> deepStack;
+		uint32_t* stack = localStack;
+		if (GetHeight() + 2U > QUERY_STACK_LENGTH) {
+			deepStack.resize(GetHeight() + 2U);
+			stack = deepStack.data();
+		}
+		uint32_t stackSize = 0U;
+		stack[stackSize++] = root;
+		uint32_t numMatches = 0U;
+		while (stackSize > 0U) {
+			uint32_t entry = stack[--stackSize];
+			uint32_t nodeIndex = entry & ~SUBTREE_INSIDE_FLAG;
+			uint32_t insideFlag = entry & SUBTREE_INSIDE_FLAG;
+			const Node& node = nodes[nodeIndex];
+
+			if (insideFlag == 0U) {
+				BVHNodeTestResult result = nodeTest(node.Bounds);
+				if (result == NodeOutside) continue;
+				if (result == NodeInside) insideFlag = SUBTREE_INSIDE_FLAG;
+			}
+
+			if (node.ChildA == NULL_BVH_NODE) {
+				if (insideFlag == 0U && !leafTest(node.Sphere)) continue;
+				if (numMatches < outKeyArrLen) outKeyArr[numMatches] = node.Key;
+				++numMatches;
+				continue;
+			}
+			stack[stackSize++] = node.ChildB | insideFlag;
+			stack[stackSize++] = node.ChildA | insideFlag;
+		}
+		return numMatches;
+	}
+
+	uint32_t InstanceBVH::QueryFrustum(const FrustumPlanes& frustum, uint64_t* outKeyArr, uint32_t outKeyArrLen) const {
+		return Query(
+			[&](const NodeBounds& bounds) {
+				BVHNodeTestResult result = NodeInside;
+				for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+					const float* plane = frustum.Planes[p];
+					// The corners farthest in to and out of the plane
+					float inner = plane[3], outer = plane[3];
+					for (uint32_t c = 0U; c < 3U; ++c) {
+						inner += plane[c] * (plane[c] >= 0.0f ? bounds.Max[c] : bounds.Min[c]);
+						outer += plane[c] * (plane[c] >= 0.0f ? bounds.Min[c] : bounds.Max[c]);
+					}
+					if (inner < 0.0f) return NodeOutside;
+					if (outer < 0.0f) result = NodeIntersecting;
+				}
+				return result;
+			},
+			[&](const BoundingSphere& sphere) {
+				for (uint32_t p = 0U; p < NUM_FRUSTUM_PLANES; ++p) {
+					const float* plane = frustum.Planes[p];
+					float distance = plane[0] * sphere.X + plane[1] * sphere.Y + plane[2] * sphere.Z + plane[3];
+					if (distance + sphere.Radius < 0.0f) return false;
+				}
+				return true;
+			},
+			outKeyArr,
+			outKeyArrLen
+		);
+	}
+	EXPORT_FAST(InstanceBVH_QueryFrustum, const InstanceBVH* bvh, const FrustumPlanes* frustum, uint64_t* outKeyArr, uint32_t outKeyArrLen,
+		uint32_t* outNumKeys) {
+		*outNumKeys = bvh->QueryFrustum(*frustum, outKeyArr, outKeyArrLen);
+		EXPORT_FAST_END;
+	}
+
+	uint32_t InstanceBVH::QuerySphere(const BoundingSphere& sphere, uint64_t* outKeyArr, uint32_t outKeyArrLen) const {
+		const float centre[3] = { sphere.X, sphere.Y, sphere.Z };
+		const float radiusSq = sphere.Radius * sphere.Radius;
+		return Query(
+			[&](const NodeBounds& bounds) {
+				float distanceSq = 0.0f;
+				for (uint32_t c = 0U; c < 3U; ++c) {
+					float outside = centre[c] < bounds.Min[c] ? bounds.Min[c] - centre[c] : (centre[c] > bounds.Max[c] ? centre[c] - bounds.Max[c] : 0.0f);
+					distanceSq += outside * outside;
+				}
+				return distanceSq <= radiusSq ? NodeIntersecting : NodeOutside;
+			},
+			[&](const BoundingSphere& instanceSphere) {
+				float x = instanceSphere.X - sphere.X;
+				float y = instanceSphere.Y - sphere.Y;
+				float z = instanceSphere.Z - sphere.Z;
+				float reach = instanceSphere.Radius + sphere.Radius;
+				return x * x + y * y + z * z <= reach * reach;
+			},
+			outKeyArr,
+			outKeyArrLen
+		);
+	}
+	EXPORT_FAST(InstanceBVH_QuerySphere, const InstanceBVH* bvh, const BoundingSphere* sphere, uint64_t* outKeyArr, uint32_t outKeyArrLen,
+		uint32_t* outNumKeys) {
+		*outNumKeys = bvh->QuerySphere(*sphere, outKeyArr, outKeyArrLen);
+		EXPORT_FAST_END;
+	}
+
+	uint32_t InstanceBVH::QueryRay(const float* origin, const float* direction, float maxDistance, uint64_t* outKeyArr, uint32_t outKeyArrLen) const {
+		const float inverseDirection[3] = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+		return Query(
+			[&](const NodeBounds& bounds) {
+				// Slab test (fmin/fmax drop the NaNs that axis-parallel rays give on a slab's edge)
+				float entry = 0.0f, exit = maxDistance;
+				for (uint32_t c = 0U; c < 3U; ++c) {
+					float toMin = (bounds.Min[c] - origin[c]) * inverseDirection[c];
+					float toMax = (bounds.Max[c] - origin[c]) * inverseDirection[c];
+					entry = std::fmax(entry, std::fmin(toMin, toMax));
+					exit = std::fmin(exit, std::fmax(toMin, toMax));
+				}
+				return entry <= exit ? NodeIntersecting : NodeOutside;
+			},
+			[&](const BoundingSphere& sphere) {
+				float toCentre[3] = { sphere.X - origin[0], sphere.Y - origin[1], sphere.Z - origin[2] };
+				float along = toCentre[0] * direction[0] + toCentre[1] * direction[1] + toCentre[2] * direction[2];
+				if (along < 0.0f) along = 0.0f;
+				else if (along > maxDistance) along = maxDistance;
+				float x = toCentre[0] - direction[0] * along;
+				float y = toCentre[1] - direction[1] * along;
+				float z = toCentre[2] - direction[2] * along;
+				return x * x + y * y + z * z <= sphere.Radius * sphere.Radius;
+			},
+			outKeyArr,
+			outKeyArrLen
+		);
+	}
+	EXPORT_FAST(InstanceBVH_QueryRay, const InstanceBVH* bvh, const float* origin, const float* direction, float maxDistance, uint64_t* outKeyArr,
+		uint32_t outKeyArrLen, uint32_t* outNumKeys) {
+		*outNumKeys = bvh->QueryRay(origin, direction, maxDistance, outKeyArr, outKeyArrLen);
+		EXPORT_FAST_END;
+	}
+}
@@ -0,0 +1,108 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "FrustumCuller.h"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace losgap {
+	const uint32_t NULL_BVH_NODE = 0xFFFFFFFFU;
+	const float DYNAMIC_BVH_MARGIN = 0.25f; // Fraction of an instance's radius its dynamic bounds are fattened by, so small moves don't touch the tree
+	const uint32_t SAH_BUILD_BINS = 16U;
+
+	/*
+	A bounding volume hierarchy over model instances, each keyed by a 64-bit value (ModelInstanceManager uses the material index in
+	the top 32 bits and the instance index in the bottom 32). Instances are bounded by their placed bounding spheres (see
+	FrustumCuller::TransformSpheres), and nodes by axis-aligned boxes.
+
+	Trees can be built all at once with Build(), which splits top-down by the surface area heuristic (SAH) over binned centroids, or
+	grown one instance at a time with Insert(), which picks the sibling that adds the least total surface area (SAH again, with a
+	branch-and-bound search). Inserted instances get slightly fattened bounds, so Update() only has to touch the tree once an instance
+	leaves them; every change refits just the boxes on the path back to the root, rotating any node whose children's heights differ by
+	more than one (as an AVL tree does) so that the tree stays balanced however instances arrive.
+
+	Queries return every matching key (in no particular order) and may run from several threads at once, but not at the same time as
+	any change to the tree. They write up to outKeyArrLen keys and return the total number of matches, so that callers can grow their
+	array and ask again when it was too small.
+	*/
+	class InstanceBVH {
+	public:
+		InstanceBVH();
+		DISALLOW_COPY_ASSIGN_MOVE(InstanceBVH);
+
+		uint32_t GetCount() const;
+		uint32_t GetHeight() const;
+
+		/*
+		Replaces the whole tree with the given instances: modelSphereArr[modelIndexArr[i]] placed with transformArr[i], keyed keyArr[i].
+		*/
+		void Build(const uint64_t* keyArr, const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+			const uint32_t* modelIndexArr, uint32_t numInstances);
+
+		void Insert(uint64_t key, const BoundingSphere& modelSphere, const InstanceTransform& transform);
+
+		/*
+		Moves an instance already in the tree. Returns false (and does nothing) if the key isn't in the tree.
+		*/
+		bool Update(uint64_t key, const BoundingSphere& modelSphere, const InstanceTransform& transform);
+
+		/*
+		Returns false if the key wasn't in the tree.
+		*/
+		bool Remove(uint64_t key);
+
+		/*
+		Instances whose sphere is at least partially inside the frustum (by the same test as FrustumCuller::CullSpheres).
+		*/
+		uint32_t QueryFrustum(const FrustumPlanes& frustum, uint64_t* outKeyArr, uint32_t outKeyArrLen) const;
+
+		/*
+		Instances whose sphere touches the given one.
+		*/
+		uint32_t QuerySphere(const BoundingSphere& sphere, uint64_t* outKeyArr, uint32_t outKeyArrLen) const;
+
+		/*
+		Instances whose sphere is touched by the ray from origin along direction (which must be unit length) for up to maxDistance.
+		*/
+		uint32_t QueryRay(const float* origin, const float* direction, float maxDistance, uint64_t* outKeyArr, uint32_t outKeyArrLen) const;
+
+	private:
+		struct NodeBounds {
+			float Min[3];
+			float Max[3];
+		};
+
+		struct Node {
+			NodeBounds Bounds;
+			BoundingSphere Sphere; // Leaves only: the instance's actual (unfattened) bounds
+			uint64_t Key; // Leaves only
+			uint32_t Parent; // Or the next free node, for nodes on the free list
+			uint32_t ChildA; // NULL_BVH_NODE for leaves
+			uint32_t ChildB;
+			int32_t Height; // 0 for leaves
+		};
+
+		std::vector<Node> nodes;
+		std::unordered_map<uint64_t, uint32_t> leafMap;
+		std::vector<std::pair<uint32_t, float>> insertionWorkspace; // Candidate siblings and their inherited costs, for InsertLeaf()
+		uint32_t root;
+		uint32_t freeList;
+
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t node);
+		uint32_t CreateLeaf(uint64_t key, const BoundingSphere& worldSphere, float margin);
+		void InsertLeaf(uint32_t leaf);
+		void RemoveLeaf(uint32_t leaf);
+		void RefitNode(uint32_t node);
+		uint32_t Balance(uint32_t node);
+		void RefitFrom(uint32_t node);
+		uint32_t BuildRange(uint32_t* leafArr, uint32_t numLeaves, uint32_t* scratchArr);
+
+		template <typename TNodeTest, typename TLeafTest>
+		uint32_t Query(const TNodeTest& nodeTest, const TLeafTest& leafTest, uint64_t* outKeyArr, uint32_t outKeyArrLen) const;
+	};
+}
@@ -0,0 +1,144 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "InstanceMatrixWriter.h"
+#include <cfloat>
+#include <cmath>
+
+#define INSTANCE_MATRIX_WRITER_SSE2
+#include <emmintrin.h>
+
+namespace losgap {
+	/*
+	Writes one transposed SRT matrix. Rotations are normalised with a square root and divide (rather than an estimate) so that the
+	result matches Matrix.FromSRTTransposed; a zero-length rotation is clamped so that it comes out as no rotation, not NaNs.
+	*/
+	void WriteTransposedMatrix(const InstanceTransform& transform, float* outMatrix) {
+		float rotationLengthSq = transform.RotationX * transform.RotationX + transform.RotationY * transform.RotationY
+			+ transform.RotationZ * transform.RotationZ + transform.RotationW * transform.RotationW;
+		float invLength = 1.0f / std::sqrt(rotationLengthSq > FLT_MIN ? rotationLengthSq : FLT_MIN);
+		float x = transform.RotationX * invLength;
+		float y = transform.RotationY * invLength;
+		float z = transform.RotationZ * invLength;
+		float w = transform.RotationW * invLength;
+
+		outMatrix[0] = (1.0f - 2.0f * y * y - 2.0f * z * z) * transform.ScaleX;
+		outMatrix[1] = (2.0f * x * y - 2.0f * z * w) * transform.ScaleY;
+		outMatrix[2] = (2.0f * x * z + 2.0f * y * w) * transform.ScaleZ;
+		outMatrix[3] = transform.TranslationX;
+		outMatrix[4] = (2.0f * x * y + 2.0f * z * w) * transform.ScaleX;
+		outMatrix[5] = (1.0f - 2.0f * x * x - 2.0f * z * z) * transform.ScaleY;
+		outMatrix[6] = (2.0f * y * z - 2.0f * x * w) * transform.ScaleZ;
+		outMatrix[7] = transform.TranslationY;
+		outMatrix[8] = (2.0f * x * z - 2.0f * y * w) * transform.ScaleX;
+		outMatrix[9] = (2.0f * y * z + 2.0f * x * w) * transform.ScaleY;
+		outMatrix[10] = (1.0f - 2.0f * x * x - 2.0f * y * y) * transform.ScaleZ;
+		outMatrix[11] = transform.TranslationZ;
+		outMatrix[12] = 0.0f;
+		outMatrix[13] = 0.0f;
+		outMatrix[14] = 0.0f;
+		outMatrix[15] = 1.0f;
+	}
+
+	void InstanceMatrixWriter::WriteTransposedMatricesScalar(const InstanceTransform* transformArr, const uint32_t* indexArr, uint32_t numIndices, float* outMatrixArr) {
+		for (uint32_t i = 0U; i < numIndices; ++i) {
+			WriteTransposedMatrix(transformArr[indexArr != nullptr ? indexArr[i] : i], outMatrixArr + i * INSTANCE_MATRIX_FLOATS);
+		}
+	}
+
+	void InstanceMatrixWriter::WriteTransposedMatrices(const InstanceTransform* transformArr, const uint32_t* indexArr, uint32_t numIndices, float* outMatrixArr) {
+		uint32_t i = 0U;
+#ifdef INSTANCE_MATRIX_WRITER_SSE2
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 minLengthSq = _mm_set1_ps(FLT_MIN);
+		const __m128 lastRow = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+		for (; i + 4U <= numIndices; i += 4U) {
+			const InstanceTransform* transforms[4];
+			for (uint32_t t = 0U; t < 4U; ++t) transforms[t] = &transformArr[indexArr != nullptr ? indexArr[i + t] : i + t];
+
+			// Load four transforms and transpose each member, so that every lane works on a different instance
+			__m128 scaleX = _mm_loadu_ps(&transforms[0]->ScaleX);
+			__m128 scaleY = _mm_loadu_ps(&transforms[1]->ScaleX);
+			__m128 scaleZ = _mm_loadu_ps(&transforms[2]->ScaleX);
+			__m128 scaleW = _mm_loadu_ps(&transforms[3]->ScaleX);
+			_MM_TRANSPOSE4_PS(scaleX, scaleY, scaleZ, scaleW);
+			__m128 x = _mm_loadu_ps(&transforms[0]->RotationX);
+			__m128 y = _mm_loadu_ps(&transforms[1]->RotationX);
+			__m128 z = _mm_loadu_ps(&transforms[2]->RotationX);
+			__m128 w = _mm_loadu_ps(&transforms[3]->RotationX);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			__m128 translationX = _mm_loadu_ps(&transforms[0]->TranslationX);
+			__m128 translationY = _mm_loadu_ps(&transforms[1]->TranslationX);
+			__m128 translationZ = _mm_loadu_ps(&transforms[2]->TranslationX);
+			__m128 translationW = _mm_loadu_ps(&transforms[3]->TranslationX);
+			_MM_TRANSPOSE4_PS(translationX, translationY, translationZ, translationW);
+
+			__m128 rotationLengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+			__m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(rotationLengthSq, minLengthSq)));
+			x = _mm_mul_ps(x, invLength);
+			y = _mm_mul_ps(y, invLength);
+			z = _mm_mul_ps(z, invLength);
+			w = _mm_mul_ps(w, invLength);
+
+			__m128 twoX = _mm_mul_ps(two, x);
+			__m128 twoY = _mm_mul_ps(two, y);
+			__m128 twoZ = _mm_mul_ps(two, z);
+			__m128 xx2 = _mm_mul_ps(twoX, x), yy2 = _mm_mul_ps(twoY, y), zz2 = _mm_mul_ps(twoZ, z);
+			__m128 xy2 = _mm_mul_ps(twoX, y), xz2 = _mm_mul_ps(twoX, z), yz2 = _mm_mul_ps(twoY, z);
+			__m128 xw2 = _mm_mul_ps(twoX, w), yw2 = _mm_mul_ps(twoY, w), zw2 = _mm_mul_ps(twoZ, w);
+
+			// Each of these holds one element of the matrix for all four instances; transposing a row's four elements gives that row of
+			// each instance's matrix
+			__m128 a0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy2), zz2), scaleX);
+			__m128 a1 = _mm_mul_ps(_mm_sub_ps(xy2, zw2), scaleY);
+			__m128 a2 = _mm_mul_ps(_mm_add_ps(xz2, yw2), scaleZ);
+			__m128 a3 = translationX;
+			_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+			__m128 b0 = _mm_mul_ps(_mm_add_ps(xy2, zw2), scaleX);
+			__m128 b1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx2), zz2), scaleY);
+			__m128 b2 = _mm_mul_ps(_mm_sub_ps(yz2, xw2), scaleZ);
+			__m128 b3 = translationY;
+			_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+			__m128 c0 = _mm_mul_ps(_mm_sub_ps(xz2, yw2), scaleX);
+			__m128 c1 = _mm_mul_ps(_mm_add_ps(yz2, xw2), scaleY);
+			__m128 c2 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx2), yy2), scaleZ);
+			__m128 c3 = translationZ;
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+			float* outMatrix = outMatrixArr + i * INSTANCE_MATRIX_FLOATS;
+			_mm_storeu_ps(outMatrix + 0U, a0);
+			_mm_storeu_ps(outMatrix + 4U, b0);
+			_mm_storeu_ps(outMatrix + 8U, c0);
+			_mm_storeu_ps(outMatrix + 12U, lastRow);
+			_mm_storeu_ps(outMatrix + 16U, a1);
+			_mm_storeu_ps(outMatrix + 20U, b1);
+			_mm_storeu_ps(outMatrix + 24U, c1);
+			_mm_storeu_ps(outMatrix + 28U, lastRow);
+			_mm_storeu_ps(outMatrix + 32U, a2);
+			_mm_storeu_ps(outMatrix + 36U, b2);
+			_mm_storeu_ps(outMatrix + 40U, c2);
+			_mm_storeu_ps(outMatrix + 44U, lastRow);
+			_mm_storeu_ps(outMatrix + 48U, a3);
+			_mm_storeu_ps(outMatrix + 52U, b3);
+			_mm_storeu_ps(outMatrix + 56U, c3);
+			_mm_storeu_ps(outMatrix + 60U, lastRow);
+		}
+#endif
+
+		// Without an index array the remaining transforms start at i too
+		WriteTransposedMatricesScalar(
+			indexArr != nullptr ? transformArr : transformArr + i,
+			indexArr != nullptr ? indexArr + i : nullptr,
+			numIndices - i,
+			outMatrixArr + i * INSTANCE_MATRIX_FLOATS
+		);
+	}
+	EXPORT_FAST(InstanceMatrixWriter_WriteTransposedMatrices, const InstanceTransform* transformArr, const uint32_t* indexArr, uint32_t numIndices,
+		float* outMatrixArr) {
+		InstanceMatrixWriter::WriteTransposedMatrices(transformArr, indexArr, numIndices, outMatrixArr);
+		EXPORT_FAST_END;
+	}
+}
@@ -0,0 +1,30 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "InstanceTransform.h"
+
+namespace losgap {
+	const uint32_t INSTANCE_MATRIX_FLOATS = 16U;
+
+	/*
+	A static class that turns instance transforms in to the transposed scale/rotation/translation matrices that the instance buffers
+	hold (exactly as Transform.AsMatrixTransposed does), four at a time with SSE2.
+	*/
+	class InstanceMatrixWriter {
+	public:
+		/*
+		Writes the matrix of transformArr[indexArr[i]] (or just transformArr[i] if indexArr is null) to
+		outMatrixArr[i * INSTANCE_MATRIX_FLOATS] for every i below numIndices. Nothing outside that output range is touched and no
+		state is shared, so any number of threads may write at once to disjoint ranges of the same array (e.g. a mapped instance buffer).
+		*/
+		static void WriteTransposedMatrices(const InstanceTransform* transformArr, const uint32_t* indexArr, uint32_t numIndices, float* outMatrixArr);
+
+		/*
+		The plain one-at-a-time version of WriteTransposedMatrices(), kept as a reference for it.
+		*/
+		static void WriteTransposedMatricesScalar(const InstanceTransform* transformArr, const uint32_t* indexArr, uint32_t numIndices, float* outMatrixArr);
+	};
+}
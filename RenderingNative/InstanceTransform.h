@@ -0,0 +1,19 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+
+namespace losgap {
+	/*
+	Mirrors Transform.cs (each member padded out to 16 bytes). The rotation need not be normalised; a zero rotation is no rotation.
+	*/
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	struct InstanceTransform {
+		float ScaleX, ScaleY, ScaleZ, ScalePadding;
+		float RotationX, RotationY, RotationZ, RotationW;
+		float TranslationX, TranslationY, TranslationZ, TranslationPadding;
+	};
+#pragma pack(pop)
+}
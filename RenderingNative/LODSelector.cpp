@@ -0,0 +1,110 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "LODSelector.h"
+#include "../CoreNative/FrameArena.h"
+#include <cfloat>
+#include <cmath>
+
+#define LOD_SELECTOR_SSE2
+#include <emmintrin.h>
+
+namespace losgap {
+	float InstanceScreenSize(const BoundingSphere& sphere, const float* viewPosition, float projectionScale, bool isPerspective) {
+		if (!isPerspective) return sphere.Radius * projectionScale;
+		float x = sphere.X - viewPosition[0];
+		float y = sphere.Y - viewPosition[1];
+		float z = sphere.Z - viewPosition[2];
+		float distance = std::sqrt(x * x + y * y + z * z);
+		return distance > sphere.Radius ? (sphere.Radius * projectionScale) / distance : FLT_MAX;
+	}
+
+	void LODSelector::CalculateScreenSizesScalar(const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+		const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, bool isPerspective,
+		float* outScreenSizeArr) {
+		if (numInstances == 0U) return;
+
+		BoundingSphere* worldSphereArr = static_cast<BoundingSphere*>(FrameArena::GetThreadArena()->Allocate(numInstances * sizeof(BoundingSphere)));
+		FrustumCuller::TransformSpheres(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, worldSphereArr);
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			outScreenSizeArr[i] = InstanceScreenSize(worldSphereArr[i], viewPosition, projectionScale, isPerspective);
+		}
+	}
+
+	void LODSelector::CalculateScreenSizes(const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+		const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, bool isPerspective,
+		float* outScreenSizeArr) {
+		if (numInstances == 0U) return;
+
+		BoundingSphere* worldSphereArr = static_cast<BoundingSphere*>(FrameArena::GetThreadArena()->Allocate(numInstances * sizeof(BoundingSphere)));
+		FrustumCuller::TransformSpheres(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, worldSphereArr);
+		uint32_t i = 0U;
+#ifdef LOD_SELECTOR_SSE2
+		if (isPerspective) {
+			const __m128 viewX = _mm_set1_ps(viewPosition[0]);
+			const __m128 viewY = _mm_set1_ps(viewPosition[1]);
+			const __m128 viewZ = _mm_set1_ps(viewPosition[2]);
+			const __m128 scale = _mm_set1_ps(projectionScale);
+			const __m128 insideSize = _mm_set1_ps(FLT_MAX);
+
+			for (; i + 4U <= numInstances; i += 4U) {
+				__m128 x = _mm_loadu_ps(&worldSphereArr[i].X);
+				__m128 y = _mm_loadu_ps(&worldSphereArr[i + 1U].X);
+				__m128 z = _mm_loadu_ps(&worldSphereArr[i + 2U].X);
+				__m128 radius = _mm_loadu_ps(&worldSphereArr[i + 3U].X);
+				_MM_TRANSPOSE4_PS(x, y, z, radius);
+
+				x = _mm_sub_ps(x, viewX);
+				y = _mm_sub_ps(y, viewY);
+				z = _mm_sub_ps(z, viewZ);
+				__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+				__m128 size = _mm_div_ps(_mm_mul_ps(radius, scale), distance);
+
+				// Lanes where the camera is inside the sphere (including those at a distance of 0, whose division gave inf or NaN) are
+				// always full size
+				__m128 outside = _mm_cmpgt_ps(distance, radius);
+				_mm_storeu_ps(outScreenSizeArr + i, _mm_or_ps(_mm_and_ps(outside, size), _mm_andnot_ps(outside, insideSize)));
+			}
+		}
+#endif
+		for (; i < numInstances; ++i) {
+			outScreenSizeArr[i] = InstanceScreenSize(worldSphereArr[i], viewPosition, projectionScale, isPerspective);
+		}
+	}
+
+	void LODSelector::SelectLODs(const LODTable& table, const BoundingSphere* modelSphereArr, const InstanceTransform* transformArr,
+		const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, bool isPerspective,
+		float hysteresis, uint8_t* lodStateArr, uint32_t* outDrawRangeArr) {
+		if (numInstances == 0U) return;
+
+		float* screenSizeArr = static_cast<float*>(FrameArena::GetThreadArena()->Allocate(numInstances * sizeof(float)));
+		CalculateScreenSizes(modelSphereArr, table.NumModels, transformArr, modelIndexArr, numInstances, viewPosition, projectionScale,
+			isPerspective, screenSizeArr);
+
+		const float coarserFactor = 1.0f - hysteresis;
+		const float finerFactor = 1.0f + hysteresis;
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			uint32_t modelIndex = modelIndexArr[i];
+			uint32_t firstLOD = table.ModelFirstLODArr[modelIndex];
+			uint32_t numLODs = table.ModelFirstLODArr[modelIndex + 1U] - firstLOD;
+			const float* maxScreenSizes = table.LODMaxScreenSizeArr + firstLOD;
+
+			// Step from the last LOD towards the right one, only crossing thresholds that the size is clearly past
+			float screenSize = screenSizeArr[i];
+			uint32_t lod = lodStateArr[i] < numLODs ? lodStateArr[i] : numLODs - 1U;
+			while (lod + 1U < numLODs && screenSize < maxScreenSizes[lod + 1U] * coarserFactor) ++lod;
+			while (lod > 0U && screenSize > maxScreenSizes[lod] * finerFactor) --lod;
+
+			lodStateArr[i] = static_cast<uint8_t>(lod);
+			outDrawRangeArr[i] = firstLOD + lod;
+		}
+	}
+	EXPORT_FAST(LODSelector_SelectLODs, const LODTable* table, const BoundingSphere* modelSphereArr, const InstanceTransform* transformArr,
+		const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, INTEROP_BOOL isPerspective,
+		float hysteresis, uint8_t* lodStateArr, uint32_t* outDrawRangeArr) {
+		LODSelector::SelectLODs(*table, modelSphereArr, transformArr, modelIndexArr, numInstances, viewPosition, projectionScale,
+			INTEROP_BOOL_TO_CBOOL(isPerspective), hysteresis, lodStateArr, outDrawRangeArr);
+		EXPORT_FAST_END;
+	}
+}
@@ -0,0 +1,59 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "FrustumCuller.h"
+
+namespace losgap {
+	const uint32_t MAX_LODS_PER_MODEL = 8U;
+
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	The levels of detail of every model in a geometry cache, flattened in to one list: model m's LODs are ModelFirstLODArr[m] up to
+	ModelFirstLODArr[m + 1] (finest first). LOD l is drawn while an instance's screen size is no more than LODMaxScreenSizeArr[l] (the
+	entry for each model's finest LOD is ignored). The flattened LOD index is also the index of its buffer range in DrawSorter's model
+	table.
+	*/
+	struct LODTable {
+		const uint32_t* ModelFirstLODArr; // NumModels + 1 entries
+		const float* LODMaxScreenSizeArr; // One per LOD
+		uint32_t NumModels;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that picks the level of detail to draw each instance with. An instance's screen size is the projected diameter of its
+	bounding sphere as a fraction of the viewport's height (so 1 fills the screen from top to bottom).
+	*/
+	class LODSelector {
+	public:
+		/*
+		Places modelSphereArr[modelIndexArr[i]] with transformArr[i] (as FrustumCuller::TransformSpheres does) and works out its screen
+		size from viewPosition. projectionScale is the projection matrix's row 1, column 1; for perspective projections the size falls
+		off with distance, and instances the camera is inside are always drawn at their finest LOD.
+		*/
+		static void CalculateScreenSizes(const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+			const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, bool isPerspective,
+			float* outScreenSizeArr);
+
+		/*
+		The plain one-at-a-time version of CalculateScreenSizes(), which the tests check it against (see TestExports.cpp).
+		*/
+		static void CalculateScreenSizesScalar(const BoundingSphere* modelSphereArr, uint32_t numModels, const InstanceTransform* transformArr,
+			const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, bool isPerspective,
+			float* outScreenSizeArr);
+
+		/*
+		Picks each instance's LOD from its screen size. lodStateArr holds the LOD (relative to the model's first) that each instance was
+		last drawn at, and is updated: an instance only moves to another LOD once its size is further than hysteresis (a fraction of
+		the threshold) past the threshold between them, so that instances sitting near a threshold don't flicker between the two.
+		outDrawRangeArr[i] is set to the instance's flattened LOD index, so that sorting instances by it batches them by model and LOD.
+		outDrawRangeArr may be modelIndexArr.
+		*/
+		static void SelectLODs(const LODTable& table, const BoundingSphere* modelSphereArr, const InstanceTransform* transformArr,
+			const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, bool isPerspective,
+			float hysteresis, uint8_t* lodStateArr, uint32_t* outDrawRangeArr);
+	};
+}
@@ -0,0 +1,225 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "LightBinner.h"
+#include "../CoreNative/FrameArena.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define LIGHT_BINNER_SSE2
+#include <emmintrin.h>
+
+namespace losgap {
+	const uint32_t NUM_LIGHT_BOUNDS_CORNERS = 8U;
+	const float MIN_CORNER_CLIP_W = 0.0001f;
+
+	/*
+	Returns the index of the lowest set bit in value, which must not be 0.
+	*/
+	inline uint32_t CountTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+		unsigned long result;
+		_BitScanForward(&result, value);
+		return static_cast<uint32_t>(result);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+
+	/*
+	The scalar version of the SSE2 loop in CalculateScreenRects(), used for the remainder. Everything is calculated in the same order
+	as there, so that both agree exactly.
+	*/
+	void CalculateScreenRectRange(const LightProperties* lightArr, uint32_t firstIndex, uint32_t endIndex, const float* m, LightScreenRect* outRectArr) {
+		for (uint32_t i = firstIndex; i < endIndex; ++i) {
+			const LightProperties& light = lightArr[i];
+			float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+			uint32_t numCornersBehind = 0U;
+			for (uint32_t corner = 0U; corner < NUM_LIGHT_BOUNDS_CORNERS; ++corner) {
+				float x = (corner & 1U) != 0U ? light.PositionX + light.Radius : light.PositionX - light.Radius;
+				float y = (corner & 2U) != 0U ? light.PositionY + light.Radius : light.PositionY - light.Radius;
+				float z = (corner & 4U) != 0U ? light.PositionZ + light.Radius : light.PositionZ - light.Radius;
+				float clipX = x * m[0] + y * m[4] + z * m[8] + m[12];
+				float clipY = x * m[1] + y * m[5] + z * m[9] + m[13];
+				float clipW = x * m[3] + y * m[7] + z * m[11] + m[15];
+				if (clipW <= MIN_CORNER_CLIP_W) {
+					++numCornersBehind;
+					continue;
+				}
+				float ndcX = clipX / clipW;
+				float ndcY = clipY / clipW;
+				minX = ndcX < minX ? ndcX : minX;
+				minY = ndcY < minY ? ndcY : minY;
+				maxX = ndcX > maxX ? ndcX : maxX;
+				maxY = ndcY > maxY ? ndcY : maxY;
+			}
+
+			LightScreenRect& rect = outRectArr[i];
+			if (numCornersBehind == NUM_LIGHT_BOUNDS_CORNERS) {
+				rect = LightScreenRect { 1.0f, 1.0f, 0.0f, 0.0f };
+			}
+			else if (numCornersBehind > 0U) {
+				rect = LightScreenRect { 0.0f, 0.0f, 1.0f, 1.0f };
+			}
+			else {
+				float* rectValues = &rect.MinX;
+				rectValues[0] = minX;
+				rectValues[1] = minY;
+				rectValues[2] = maxX;
+				rectValues[3] = maxY;
+				for (uint32_t v = 0U; v < 4U; ++v) {
+					float screenValue = (rectValues[v] + 1.0f) * 0.5f;
+					screenValue = screenValue > 0.0f ? screenValue : 0.0f;
+					rectValues[v] = screenValue < 1.0f ? screenValue : 1.0f;
+				}
+			}
+		}
+	}
+
+	void LightBinner::CalculateScreenRects(const LightProperties* lightArr, uint32_t numLights, const float* viewProjMat, LightScreenRect* outRectArr) {
+		if (viewProjMat == nullptr) throw LosgapException { "View/projection matrix must not be null." };
+		const float* m = viewProjMat;
+		uint32_t i = 0U;
+#ifdef LIGHT_BINNER_SSE2
+		// Clip-space x, y and w are the dot products of the position with columns 0, 1 and 3 of the matrix
+		const __m128 m0 = _mm_set1_ps(m[0]), m4 = _mm_set1_ps(m[4]), m8 = _mm_set1_ps(m[8]), m12 = _mm_set1_ps(m[12]);
+		const __m128 m1 = _mm_set1_ps(m[1]), m5 = _mm_set1_ps(m[5]), m9 = _mm_set1_ps(m[9]), m13 = _mm_set1_ps(m[13]);
+		const __m128 m3 = _mm_set1_ps(m[3]), m7 = _mm_set1_ps(m[7]), m11 = _mm_set1_ps(m[11]), m15 = _mm_set1_ps(m[15]);
+		const __m128 minClipW = _mm_set1_ps(MIN_CORNER_CLIP_W);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 allBits = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (; i + 4U <= numLights; i += 4U) {
+			// Four lights in, four lanes each of X, Y, Z and Radius out
+			__m128 x = _mm_loadu_ps(&lightArr[i].PositionX);
+			__m128 y = _mm_loadu_ps(&lightArr[i + 1U].PositionX);
+			__m128 z = _mm_loadu_ps(&lightArr[i + 2U].PositionX);
+			__m128 radius = _mm_loadu_ps(&lightArr[i + 3U].PositionX);
+			_MM_TRANSPOSE4_PS(x, y, z, radius);
+
+			__m128 minX = _mm_set1_ps(FLT_MAX), minY = _mm_set1_ps(FLT_MAX);
+			__m128 maxX = _mm_set1_ps(-FLT_MAX), maxY = _mm_set1_ps(-FLT_MAX);
+			__m128 anyCornerBehind = zero;
+			__m128 allCornersBehind = allBits;
+			for (uint32_t corner = 0U; corner < NUM_LIGHT_BOUNDS_CORNERS; ++corner) {
+				__m128 cornerX = (corner & 1U) != 0U ? _mm_add_ps(x, radius) : _mm_sub_ps(x, radius);
+				__m128 cornerY = (corner & 2U) != 0U ? _mm_add_ps(y, radius) : _mm_sub_ps(y, radius);
+				__m128 cornerZ = (corner & 4U) != 0U ? _mm_add_ps(z, radius) : _mm_sub_ps(z, radius);
+				__m128 clipX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, m0), _mm_mul_ps(cornerY, m4)), _mm_mul_ps(cornerZ, m8)), m12);
+				__m128 clipY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, m1), _mm_mul_ps(cornerY, m5)), _mm_mul_ps(cornerZ, m9)), m13);
+				__m128 clipW = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cornerX, m3), _mm_mul_ps(cornerY, m7)), _mm_mul_ps(cornerZ, m11)), m15);
+
+				__m128 behind = _mm_cmple_ps(clipW, minClipW);
+				anyCornerBehind = _mm_or_ps(anyCornerBehind, behind);
+				allCornersBehind = _mm_and_ps(allCornersBehind, behind);
+
+				// Lanes with a corner behind are overwritten below, so it doesn't matter what goes in to them here
+				__m128 ndcX = _mm_div_ps(clipX, clipW);
+				__m128 ndcY = _mm_div_ps(clipY, clipW);
+				minX = _mm_min_ps(ndcX, minX);
+				minY = _mm_min_ps(ndcY, minY);
+				maxX = _mm_max_ps(ndcX, maxX);
+				maxY = _mm_max_ps(ndcY, maxY);
+			}
+
+			__m128 rectValues[4] = { minX, minY, maxX, maxY };
+			__m128 partlyBehind = _mm_andnot_ps(allCornersBehind, anyCornerBehind);
+			for (uint32_t v = 0U; v < 4U; ++v) {
+				__m128 screenValue = _mm_mul_ps(_mm_add_ps(rectValues[v], one), half);
+				screenValue = _mm_min_ps(_mm_max_ps(screenValue, zero), one);
+				// Partly behind: the whole screen (0 to 1). Entirely behind: nothing (1 to 0).
+				__m128 behindValue = v < 2U ? _mm_and_ps(allCornersBehind, one) : _mm_and_ps(partlyBehind, one);
+				rectValues[v] = _mm_or_ps(_mm_andnot_ps(anyCornerBehind, screenValue), behindValue);
+			}
+
+			_MM_TRANSPOSE4_PS(rectValues[0], rectValues[1], rectValues[2], rectValues[3]);
+			for (uint32_t lane = 0U; lane < 4U; ++lane) _mm_storeu_ps(&outRectArr[i + lane].MinX, rectValues[lane]);
+		}
+#endif
+		CalculateScreenRectRange(lightArr, i, numLights, m, outRectArr);
+	}
+	EXPORT_FAST(LightBinner_CalculateScreenRects, const LightProperties* lightArr, uint32_t numLights, const float* viewProjMat,
+		LightScreenRect* outRectArr) {
+		LightBinner::CalculateScreenRects(lightArr, numLights, viewProjMat, outRectArr);
+		EXPORT_FAST_END;
+	}
+
+	/*
+	Tile t covers [t / numTiles, (t + 1) / numTiles], so a light starting exactly on an edge also touches the tile before it.
+	*/
+	uint32_t FirstTouchedTile(float rectMin, uint32_t numTiles) {
+		float firstTile = std::ceil(rectMin * numTiles) - 1.0f;
+		return firstTile > 0.0f ? static_cast<uint32_t>(firstTile) : 0U;
+	}
+
+	uint32_t LastTouchedTile(float rectMax, uint32_t numTiles) {
+		float lastTile = std::floor(rectMax * numTiles);
+		return lastTile < numTiles - 1U ? static_cast<uint32_t>(lastTile) : numTiles - 1U;
+	}
+
+	uint32_t LightBinner::BinLights(const LightProperties* lightArr, uint32_t numLights, const float* viewProjMat, uint32_t numTilesX, uint32_t numTilesY,
+		uint32_t* outTileOffsetArr, uint32_t* outLightIndexArr, uint32_t outLightIndexArrLen) {
+		if (numTilesX == 0U || numTilesY == 0U) throw LosgapException { "There must be at least one tile in each direction." };
+		uint32_t numTiles = numTilesX * numTilesY;
+		if (numLights == 0U) {
+			memset(outTileOffsetArr, 0, (numTiles + 1U) * sizeof(uint32_t));
+			return 0U;
+		}
+
+		// Scratch space only needs to last until we return, so the thread's frame arena is a good fit
+		FrameArena* arena = FrameArena::GetThreadArena();
+		LightScreenRect* rects = static_cast<LightScreenRect*>(arena->Allocate(numLights * sizeof(LightScreenRect)));
+		CalculateScreenRects(lightArr, numLights, viewProjMat, rects);
+
+		// One bitmask of lights per row of tiles and one per column: a light is on a tile exactly when it's on both
+		uint32_t numMaskWords = (numLights + 31U) >> 5;
+		uint32_t* rowMasks = static_cast<uint32_t*>(arena->Allocate((numTilesX + numTilesY) * numMaskWords * sizeof(uint32_t)));
+		uint32_t* columnMasks = rowMasks + numTilesY * numMaskWords;
+		memset(rowMasks, 0, (numTilesX + numTilesY) * numMaskWords * sizeof(uint32_t));
+		for (uint32_t l = 0U; l < numLights; ++l) {
+			const LightScreenRect& rect = rects[l];
+			if (rect.MinX > rect.MaxX || rect.MinY > rect.MaxY) continue;
+
+			uint32_t maskWord = l >> 5;
+			uint32_t maskBit = 1U << (l & 31U);
+			uint32_t lastX = LastTouchedTile(rect.MaxX, numTilesX);
+			for (uint32_t x = FirstTouchedTile(rect.MinX, numTilesX); x <= lastX; ++x) columnMasks[x * numMaskWords + maskWord] |= maskBit;
+			uint32_t lastY = LastTouchedTile(rect.MaxY, numTilesY);
+			for (uint32_t y = FirstTouchedTile(rect.MinY, numTilesY); y <= lastY; ++y) rowMasks[y * numMaskWords + maskWord] |= maskBit;
+		}
+
+		uint32_t numIndices = 0U;
+		for (uint32_t y = 0U; y < numTilesY; ++y) {
+			const uint32_t* rowMask = rowMasks + y * numMaskWords;
+			for (uint32_t x = 0U; x < numTilesX; ++x) {
+				const uint32_t* columnMask = columnMasks + x * numMaskWords;
+				outTileOffsetArr[y * numTilesX + x] = numIndices;
+				for (uint32_t w = 0U; w < numMaskWords; ++w) {
+					uint32_t tileBits = rowMask[w] & columnMask[w];
+					while (tileBits != 0U) {
+						uint32_t bitIndex = CountTrailingZeros(tileBits);
+						tileBits &= tileBits - 1U;
+						if (numIndices == outLightIndexArrLen) {
+							throw LosgapException { "Output light index array (length " + std::to_string(outLightIndexArrLen) + ") is too small for the binned lights." };
+						}
+						outLightIndexArr[numIndices++] = (w << 5) | bitIndex;
+					}
+				}
+			}
+		}
+		outTileOffsetArr[numTiles] = numIndices;
+		return numIndices;
+	}
+	EXPORT_FAST(LightBinner_BinLights, const LightProperties* lightArr, uint32_t numLights, const float* viewProjMat, uint32_t numTilesX,
+		uint32_t numTilesY, uint32_t* outTileOffsetArr, uint32_t* outLightIndexArr, uint32_t outLightIndexArrLen, uint32_t* outNumIndices) {
+		*outNumIndices = LightBinner::BinLights(lightArr, numLights, viewProjMat, numTilesX, numTilesY, outTileOffsetArr, outLightIndexArr, outLightIndexArrLen);
+		EXPORT_FAST_END;
+	}
+}
@@ -0,0 +1,52 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+
+namespace losgap {
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	Mirrors LightProperties in Light.cs.
+	*/
+	struct LightProperties {
+		float PositionX, PositionY, PositionZ, Radius;
+		float ColorR, ColorG, ColorB, ColorPadding;
+	};
+
+	/*
+	The part of the screen a light may touch, from 0 to 1 on each axis starting at the bottom left corner. A light that can not touch
+	the screen at all has MinX > MaxX.
+	*/
+	struct LightScreenRect {
+		float MinX;
+		float MinY;
+		float MaxX;
+		float MaxY;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that finds the screen-space bounds of point lights (four at a time with SSE2) and bins them in to a grid of
+	screen tiles, giving a compact list of light indices per tile.
+	*/
+	class LightBinner {
+	public:
+		/*
+		viewProjMat is a row-major view * projection matrix for row vectors (i.e. not transposed), with D3D's 0 to 1 clip depth. Each
+		rect bounds the projection of the corners of the light's bounding box, so it is conservative; a light that reaches behind the
+		camera's plane can not be bounded that way, so it gets the whole screen (or nothing, if it is entirely behind).
+		*/
+		static void CalculateScreenRects(const LightProperties* lightArr, uint32_t numLights, const float* viewProjMat, LightScreenRect* outRectArr);
+
+		/*
+		Writes the indices of the lights touching tile t (in ascending order) to outLightIndexArr[outTileOffsetArr[t]] up to
+		outLightIndexArr[outTileOffsetArr[t + 1]], and returns the total number of indices written. Tiles are numbered row by row
+		(t = y * numTilesX + x) from the bottom left, and outTileOffsetArr must have room for numTilesX * numTilesY + 1 entries. Tiles
+		share their edges, so a light touching an edge is binned in to both tiles.
+		*/
+		static uint32_t BinLights(const LightProperties* lightArr, uint32_t numLights, const float* viewProjMat, uint32_t numTilesX, uint32_t numTilesY,
+			uint32_t* outTileOffsetArr, uint32_t* outLightIndexArr, uint32_t outLightIndexArrLen);
+	};
+}
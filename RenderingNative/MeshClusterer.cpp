@@ -0,0 +1,323 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "MeshClusterer.h"
+#include "../CoreNative/FrameArena.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace losgap {
+	const float MIN_CONE_CULL_DOT = 0.1f; // Clusters whose triangles face further apart than this (~84 degrees from the axis) get no cone
+	const uint32_t MORTON_BITS_PER_AXIS = 10U;
+
+	uint32_t SpreadMortonBits(uint32_t value) {
+		value &= 0x3FFU;
+		value = (value | (value << 16U)) & 0x030000FFU;
+		value = (value | (value << 8U)) & 0x0300F00FU;
+		value = (value | (value << 4U)) & 0x030C30C3U;
+		value = (value | (value << 2U)) & 0x09249249U;
+		return value;
+	}
+
+	void RotateByUnitQuaternion(float qX, float qY, float qZ, float qW, float* v) {
+		float tX = 2.0f * (qY * v[2] - qZ * v[1]);
+		float tY = 2.0f * (qZ * v[0] - qX * v[2]);
+		float tZ = 2.0f * (qX * v[1] - qY * v[0]);
+		v[0] += qW * tX + (qY * tZ - qZ * tY);
+		v[1] += qW * tY + (qZ * tX - qX * tZ);
+		v[2] += qW * tZ + (qX * tY - qY * tX);
+	}
+
+	uint32_t MeshClusterer::GetNumClusters(uint32_t numIndices, uint32_t maxTrianglesPerCluster) {
+		uint32_t numTriangles = numIndices / 3U;
+		return (numTriangles + maxTrianglesPerCluster - 1U) / maxTrianglesPerCluster;
+	}
+
+	uint32_t MeshClusterer::BuildClusters(const float* positionArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices,
+		uint32_t maxTrianglesPerCluster, uint32_t* outIndexArr, MeshCluster* outClusterArr) {
+		if (numIndices % 3U != 0U) {
+			throw LosgapException { "Index count (" + std::to_string(numIndices) + ") is not a multiple of three." };
+		}
+		if (maxTrianglesPerCluster == 0U || maxTrianglesPerCluster > MAX_CLUSTER_TRIANGLES) {
+			throw LosgapException { "Clusters must hold between 1 and " + std::to_string(MAX_CLUSTER_TRIANGLES) + " triangles ("
+				+ std::to_string(maxTrianglesPerCluster) + " given)." };
+		}
+		for (uint32_t i = 0U; i < numIndices; ++i) {
+			if (indexArr[i] >= numVertices) {
+				throw LosgapException { "Index " + std::to_string(i) + " (" + std::to_string(indexArr[i]) + ") is out of range ("
+					+ std::to_string(numVertices) + " vertices)." };
+			}
+		}
+		uint32_t numTriangles = numIndices / 3U;
+		if (numTriangles == 0U) return 0U;
+
+		// Weld vertices that share a position (meshes split them on UV and normal seams), so that clusters can grow across seams
+		std::vector<uint32_t> vertexOrder(numVertices);
+		for (uint32_t v = 0U; v < numVertices; ++v) vertexOrder[v] = v;
+		std::sort(vertexOrder.begin(), vertexOrder.end(), [positionArr](uint32_t a, uint32_t b) {
+			const float* pA = positionArr + a * 3U;
+			const float* pB = positionArr + b * 3U;
+			if (pA[0] != pB[0]) return pA[0] < pB[0];
+			if (pA[1] != pB[1]) return pA[1] < pB[1];
+			return pA[2] < pB[2];
+		});
+		std::vector<uint32_t> weldedVertices(numVertices);
+		uint32_t numWelded = 0U;
+		for (uint32_t i = 0U; i < numVertices; ++i) {
+			const float* p = positionArr + vertexOrder[i] * 3U;
+			const float* prev = positionArr + vertexOrder[i == 0U ? 0U : i - 1U] * 3U;
+			if (i > 0U && (p[0] != prev[0] || p[1] != prev[1] || p[2] != prev[2])) ++numWelded;
+			weldedVertices[vertexOrder[i]] = numWelded;
+		}
+		++numWelded;
+
+		// Triangles around each welded vertex
+		std::vector<uint32_t> vertexTriangleStarts(numWelded + 1U, 0U);
+		for (uint32_t i = 0U; i < numIndices; ++i) ++vertexTriangleStarts[weldedVertices[indexArr[i]] + 1U];
+		for (uint32_t v = 0U; v < numWelded; ++v) vertexTriangleStarts[v + 1U] += vertexTriangleStarts[v];
+		std::vector<uint32_t> vertexTriangles(numIndices);
+		std::vector<uint32_t> vertexTriangleCursors(vertexTriangleStarts.begin(), vertexTriangleStarts.end() - 1);
+		for (uint32_t i = 0U; i < numIndices; ++i) vertexTriangles[vertexTriangleCursors[weldedVertices[indexArr[i]]]++] = i / 3U;
+
+		// Triangle centres and unit normals (zero for degenerate triangles); front faces wind clockwise, so the normal is (b - a) x (c - a)
+		std::vector<float> triangleCentres(numTriangles * 3U);
+		std::vector<float> triangleNormals(numTriangles * 3U);
+		float meshMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float meshMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t t = 0U; t < numTriangles; ++t) {
+			const float* a = positionArr + indexArr[t * 3U] * 3U;
+			const float* b = positionArr + indexArr[t * 3U + 1U] * 3U;
+			const float* c = positionArr + indexArr[t * 3U + 2U] * 3U;
+			float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float n[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+			float nLength = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			float invNLength = nLength > 0.0f ? 1.0f / nLength : 0.0f;
+			for (uint32_t axis = 0U; axis < 3U; ++axis) {
+				float centre = (a[axis] + b[axis] + c[axis]) * (1.0f / 3.0f);
+				triangleCentres[t * 3U + axis] = centre;
+				triangleNormals[t * 3U + axis] = n[axis] * invNLength;
+				if (centre < meshMin[axis]) meshMin[axis] = centre;
+				if (centre > meshMax[axis]) meshMax[axis] = centre;
+			}
+		}
+
+		// Seeds are taken in Morton order, so that each new cluster starts next to the last one and neighbouring clusters end up
+		// neighbours in the index buffer too (which lets CullClusters() merge more of them in to single draws)
+		std::vector<std::pair<uint32_t, uint32_t>> mortonOrder(numTriangles);
+		float mortonScale[3];
+		for (uint32_t axis = 0U; axis < 3U; ++axis) {
+			float extent = meshMax[axis] - meshMin[axis];
+			mortonScale[axis] = extent > 0.0f ? ((1U << MORTON_BITS_PER_AXIS) - 1U) / extent : 0.0f;
+		}
+		for (uint32_t t = 0U; t < numTriangles; ++t) {
+			uint32_t code = 0U;
+			for (uint32_t axis = 0U; axis < 3U; ++axis) {
+				uint32_t quantized = static_cast<uint32_t>((triangleCentres[t * 3U + axis] - meshMin[axis]) * mortonScale[axis]);
+				code |= SpreadMortonBits(quantized) << axis;
+			}
+			mortonOrder[t] = std::make_pair(code, t);
+		}
+		std::sort(mortonOrder.begin(), mortonOrder.end());
+
+		std::vector<uint32_t> clusteredTriangles(numTriangles); // Original triangle index of each output triangle
+		std::vector<bool> triangleAssigned(numTriangles, false);
+		std::vector<uint32_t> frontierStamps(numTriangles, 0U);
+		std::vector<uint32_t> frontier;
+		uint32_t mortonCursor = 0U;
+		uint32_t numAssigned = 0U;
+		uint32_t numClusters = 0U;
+
+		while (numAssigned < numTriangles) {
+			MeshCluster& cluster = outClusterArr[numClusters++];
+			uint32_t clusterStamp = numClusters;
+			uint32_t clusterFirstTriangle = numAssigned;
+			float centreSum[3] = { 0.0f, 0.0f, 0.0f };
+			float normalSum[3] = { 0.0f, 0.0f, 0.0f };
+			frontier.clear();
+
+			while (numAssigned - clusterFirstTriangle < maxTrianglesPerCluster && numAssigned < numTriangles) {
+				// Take the frontier triangle that keeps the cluster tightest and flattest; or, when it has run out (the cluster has
+				// covered a whole disconnected piece), carry on from the next unassigned triangle in Morton order
+				uint32_t numTaken = numAssigned - clusterFirstTriangle;
+				float invNumTaken = numTaken > 0U ? 1.0f / numTaken : 0.0f;
+				float clusterCentre[3] = { centreSum[0] * invNumTaken, centreSum[1] * invNumTaken, centreSum[2] * invNumTaken };
+				float normalSumLength = std::sqrt(normalSum[0] * normalSum[0] + normalSum[1] * normalSum[1] + normalSum[2] * normalSum[2]);
+				float invNormalSumLength = normalSumLength > 0.0f ? 1.0f / normalSumLength : 0.0f;
+				float clusterNormal[3] = { normalSum[0] * invNormalSumLength, normalSum[1] * invNormalSumLength, normalSum[2] * invNormalSumLength };
+
+				uint32_t bestTriangle = 0xFFFFFFFFU;
+				float bestScore = FLT_MAX;
+				for (uint32_t f = 0U; f < frontier.size();) {
+					uint32_t t = frontier[f];
+					if (triangleAssigned[t]) {
+						frontier[f] = frontier.back();
+						frontier.pop_back();
+						continue;
+					}
+					const float* centre = &triangleCentres[t * 3U];
+					const float* normal = &triangleNormals[t * 3U];
+					float dX = centre[0] - clusterCentre[0], dY = centre[1] - clusterCentre[1], dZ = centre[2] - clusterCentre[2];
+					float facing = normal[0] * clusterNormal[0] + normal[1] * clusterNormal[1] + normal[2] * clusterNormal[2];
+					float score = (dX * dX + dY * dY + dZ * dZ) * (2.0f - facing);
+					if (score < bestScore) {
+						bestScore = score;
+						bestTriangle = t;
+					}
+					++f;
+				}
+				if (bestTriangle == 0xFFFFFFFFU) {
+					while (triangleAssigned[mortonOrder[mortonCursor].second]) ++mortonCursor;
+					bestTriangle = mortonOrder[mortonCursor].second;
+				}
+
+				triangleAssigned[bestTriangle] = true;
+				clusteredTriangles[numAssigned] = bestTriangle;
+				for (uint32_t axis = 0U; axis < 3U; ++axis) {
+					centreSum[axis] += triangleCentres[bestTriangle * 3U + axis];
+					normalSum[axis] += triangleNormals[bestTriangle * 3U + axis];
+				}
+				for (uint32_t corner = 0U; corner < 3U; ++corner) {
+					uint32_t vertex = indexArr[bestTriangle * 3U + corner];
+					outIndexArr[numAssigned * 3U + corner] = vertex;
+
+					uint32_t weldedVertex = weldedVertices[vertex];
+					for (uint32_t i = vertexTriangleStarts[weldedVertex]; i < vertexTriangleStarts[weldedVertex + 1U]; ++i) {
+						uint32_t neighbour = vertexTriangles[i];
+						if (triangleAssigned[neighbour] || frontierStamps[neighbour] == clusterStamp) continue;
+						frontierStamps[neighbour] = clusterStamp;
+						frontier.push_back(neighbour);
+					}
+				}
+				++numAssigned;
+			}
+
+			// Bounding sphere: centred on the cluster's box, out to its furthest corner
+			const uint32_t* clusterIndices = outIndexArr + clusterFirstTriangle * 3U;
+			uint32_t clusterNumIndices = (numAssigned - clusterFirstTriangle) * 3U;
+			float boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (uint32_t i = 0U; i < clusterNumIndices; ++i) {
+				const float* p = positionArr + clusterIndices[i] * 3U;
+				for (uint32_t axis = 0U; axis < 3U; ++axis) {
+					if (p[axis] < boxMin[axis]) boxMin[axis] = p[axis];
+					if (p[axis] > boxMax[axis]) boxMax[axis] = p[axis];
+				}
+			}
+			cluster.CenterX = (boxMin[0] + boxMax[0]) * 0.5f;
+			cluster.CenterY = (boxMin[1] + boxMax[1]) * 0.5f;
+			cluster.CenterZ = (boxMin[2] + boxMax[2]) * 0.5f;
+			float radiusSq = 0.0f;
+			for (uint32_t i = 0U; i < clusterNumIndices; ++i) {
+				const float* p = positionArr + clusterIndices[i] * 3U;
+				float dX = p[0] - cluster.CenterX, dY = p[1] - cluster.CenterY, dZ = p[2] - cluster.CenterZ;
+				float distanceSq = dX * dX + dY * dY + dZ * dZ;
+				if (distanceSq > radiusSq) radiusSq = distanceSq;
+			}
+			cluster.Radius = std::sqrt(radiusSq);
+
+			// Normal cone: around the average facing, wide enough to take in every (non-degenerate) triangle
+			cluster.ConeAxisX = cluster.ConeAxisY = cluster.ConeAxisZ = 0.0f;
+			cluster.ConeCutoff = 1.0f;
+			float axisLength = std::sqrt(normalSum[0] * normalSum[0] + normalSum[1] * normalSum[1] + normalSum[2] * normalSum[2]);
+			if (axisLength > 1E-6f) {
+				float axis[3] = { normalSum[0] / axisLength, normalSum[1] / axisLength, normalSum[2] / axisLength };
+				float minDot = 1.0f;
+				for (uint32_t t = clusterFirstTriangle; t < numAssigned; ++t) {
+					const float* n = &triangleNormals[clusteredTriangles[t] * 3U];
+					if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) continue;
+					float dot = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+					if (dot < minDot) minDot = dot;
+				}
+				if (minDot > MIN_CONE_CULL_DOT) {
+					cluster.ConeAxisX = axis[0];
+					cluster.ConeAxisY = axis[1];
+					cluster.ConeAxisZ = axis[2];
+					cluster.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+				}
+			}
+
+			cluster.FirstIndex = clusterFirstTriangle * 3U;
+			cluster.NumIndices = clusterNumIndices;
+		}
+
+		return numClusters;
+	}
+	EXPORT_FAST(MeshClusterer_BuildClusters, const float* positionArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices,
+		uint32_t maxTrianglesPerCluster, uint32_t* outIndexArr, MeshCluster* outClusterArr, uint32_t* outNumClusters) {
+		*outNumClusters = MeshClusterer::BuildClusters(positionArr, numVertices, indexArr, numIndices, maxTrianglesPerCluster, outIndexArr, outClusterArr);
+		EXPORT_FAST_END;
+	}
+
+	uint32_t MeshClusterer::CullClusters(const FrustumPlanes& frustum, const float* viewPosition, bool cullBackFacing, const MeshCluster* clusterArr,
+		uint32_t numClusters, const InstanceTransform& transform, uint32_t firstIndex, IndexRange* outRangeArr) {
+		if (numClusters == 0U) return 0U;
+
+		float qX = transform.RotationX, qY = transform.RotationY, qZ = transform.RotationZ, qW = transform.RotationW;
+		float rotationLengthSq = qX * qX + qY * qY + qZ * qZ + qW * qW;
+		if (rotationLengthSq > 0.0f) {
+			float invLength = 1.0f / std::sqrt(rotationLengthSq);
+			qX *= invLength;
+			qY *= invLength;
+			qZ *= invLength;
+			qW *= invLength;
+		}
+		float maxScale = std::fabs(transform.ScaleX);
+		if (std::fabs(transform.ScaleY) > maxScale) maxScale = std::fabs(transform.ScaleY);
+		if (std::fabs(transform.ScaleZ) > maxScale) maxScale = std::fabs(transform.ScaleZ);
+		// Non-uniform scale bends normals, and mirroring flips winding; the cones hold for neither
+		bool testCones = cullBackFacing && transform.ScaleX > 0.0f && transform.ScaleX == transform.ScaleY && transform.ScaleY == transform.ScaleZ;
+
+		FrameArena* arena = FrameArena::GetThreadArena();
+		BoundingSphere* worldSphereArr = static_cast<BoundingSphere*>(arena->Allocate(numClusters * sizeof(BoundingSphere)));
+		for (uint32_t i = 0U; i < numClusters; ++i) {
+			const MeshCluster& cluster = clusterArr[i];
+			float centre[3] = { cluster.CenterX * transform.ScaleX, cluster.CenterY * transform.ScaleY, cluster.CenterZ * transform.ScaleZ };
+			RotateByUnitQuaternion(qX, qY, qZ, qW, centre);
+			worldSphereArr[i].X = transform.TranslationX + centre[0];
+			worldSphereArr[i].Y = transform.TranslationY + centre[1];
+			worldSphereArr[i].Z = transform.TranslationZ + centre[2];
+			worldSphereArr[i].Radius = cluster.Radius * maxScale;
+		}
+		uint32_t* visibleClusterArr = static_cast<uint32_t*>(arena->Allocate(numClusters * sizeof(uint32_t)));
+		uint32_t numVisible = FrustumCuller::CullSpheres(frustum, worldSphereArr, numClusters, visibleClusterArr);
+
+		uint32_t numRanges = 0U;
+		for (uint32_t v = 0U; v < numVisible; ++v) {
+			const MeshCluster& cluster = clusterArr[visibleClusterArr[v]];
+			const BoundingSphere& sphere = worldSphereArr[visibleClusterArr[v]];
+
+			if (testCones && cluster.ConeCutoff < 1.0f) {
+				// Every triangle faces away from the viewer when the direction to the cluster is further in to the cone than any of their
+				// normals are out of it, with the sphere's radius as slack for where on the cluster each triangle actually is
+				float axis[3] = { cluster.ConeAxisX, cluster.ConeAxisY, cluster.ConeAxisZ };
+				RotateByUnitQuaternion(qX, qY, qZ, qW, axis);
+				float dX = sphere.X - viewPosition[0], dY = sphere.Y - viewPosition[1], dZ = sphere.Z - viewPosition[2];
+				float distance = std::sqrt(dX * dX + dY * dY + dZ * dZ);
+				if (dX * axis[0] + dY * axis[1] + dZ * axis[2] >= cluster.ConeCutoff * distance + sphere.Radius) continue;
+			}
+
+			uint32_t rangeStart = firstIndex + cluster.FirstIndex;
+			if (numRanges > 0U && outRangeArr[numRanges - 1U].FirstIndex + outRangeArr[numRanges - 1U].NumIndices == rangeStart) {
+				outRangeArr[numRanges - 1U].NumIndices += cluster.NumIndices;
+			}
+			else {
+				outRangeArr[numRanges].FirstIndex = rangeStart;
+				outRangeArr[numRanges].NumIndices = cluster.NumIndices;
+				++numRanges;
+			}
+		}
+		return numRanges;
+	}
+	EXPORT_FAST(MeshClusterer_CullClusters, const FrustumPlanes* frustum, const float* viewPosition, INTEROP_BOOL cullBackFacing,
+		const MeshCluster* clusterArr, uint32_t numClusters, const InstanceTransform* transform, uint32_t firstIndex, IndexRange* outRangeArr,
+		uint32_t* outNumRanges) {
+		*outNumRanges = MeshClusterer::CullClusters(*frustum, viewPosition, INTEROP_BOOL_TO_CBOOL(cullBackFacing), clusterArr, numClusters,
+			*transform, firstIndex, outRangeArr);
+		EXPORT_FAST_END;
+	}
+}
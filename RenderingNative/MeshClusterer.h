@@ -0,0 +1,66 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "FrustumCuller.h"
+
+namespace losgap {
+	const uint32_t MAX_CLUSTER_TRIANGLES = 128U;
+
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	A small patch of neighbouring triangles from one model, bounded by a sphere (in model space) and a normal cone. Every triangle's
+	front face points at least partly along ConeAxis, so that the whole cluster faces away from any viewer standing in the cone behind
+	it (see CullClusters()). Clusters whose triangles face too many ways have a zero axis and a cutoff of 1, and are never cone-culled.
+	*/
+	struct MeshCluster {
+		float CenterX;
+		float CenterY;
+		float CenterZ;
+		float Radius;
+		float ConeAxisX;
+		float ConeAxisY;
+		float ConeAxisZ;
+		float ConeCutoff; // Sine of the cone's half-angle
+		uint32_t FirstIndex; // Relative to the model's first index
+		uint32_t NumIndices;
+	};
+
+	struct IndexRange {
+		uint32_t FirstIndex;
+		uint32_t NumIndices;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that splits large meshes in to clusters of up to MAX_CLUSTER_TRIANGLES triangles, and picks which clusters of a
+	placed mesh need drawing each frame.
+	*/
+	class MeshClusterer {
+	public:
+		/*
+		The number of clusters BuildClusters() makes for a mesh of numIndices indices.
+		*/
+		static uint32_t GetNumClusters(uint32_t numIndices, uint32_t maxTrianglesPerCluster);
+
+		/*
+		Reorders the mesh's triangles (positionArr is three floats per vertex) so that each cluster's are contiguous, writing them to
+		outIndexArr (which must be numIndices long, and must not be indexArr), and writes GetNumClusters() clusters to outClusterArr.
+		Clusters are grown outwards from seeds taken in Morton order of the triangles' centres, preferring triangles that are close by and
+		face the same way as those already taken, so that they come out both tight and flat. Winding order is kept as it is.
+		*/
+		static uint32_t BuildClusters(const float* positionArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices,
+			uint32_t maxTrianglesPerCluster, uint32_t* outIndexArr, MeshCluster* outClusterArr);
+
+		/*
+		Culls the clusters of one instance (placed with transform) against the frustum and, if cullBackFacing is set, drops any cluster
+		that faces entirely away from viewPosition. The cone test is skipped for instances that are not scaled uniformly, or are
+		mirrored. Runs of visible clusters that are next to each other in the index buffer are merged, and written to outRangeArr (which
+		must be numClusters long) with firstIndex added on. Returns the number of ranges written.
+		*/
+		static uint32_t CullClusters(const FrustumPlanes& frustum, const float* viewPosition, bool cullBackFacing, const MeshCluster* clusterArr,
+			uint32_t numClusters, const InstanceTransform& transform, uint32_t firstIndex, IndexRange* outRangeArr);
+	};
+}
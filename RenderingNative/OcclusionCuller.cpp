@@ -0,0 +1,572 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "OcclusionCuller.h"
+#include "../CoreNative/FrameArena.h"
+#include "../CoreNative/JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#define OCCLUSION_CULLER_SSE2
+#include <emmintrin.h>
+
+namespace losgap {
+	const float OCCLUSION_CLEAR_DEPTH = 1.0f;
+	const uint32_t OCCLUSION_SETUP_BLOCK_SIZE = 256U;
+	const uint32_t MAX_OCCLUSION_LEVELS = 32U;
+
+	/*
+	One occluder triangle, set up for the rasteriser in pixel space (pixel (x, y) covers [x, x + 1] by [y, y + 1]). The edge functions
+	are positive inside the triangle, and each one on the outline of the occluder is pulled in by half a pixel's extent along its
+	normal, so that a pixel's centre only passes it when the whole pixel is inside. The depth plane is offset so that evaluating it at
+	a pixel's centre gives its farthest value anywhere in that pixel. The pixel bounds are inclusive, and empty (MinPixelX > MaxPixelX)
+	for skipped triangles.
+	*/
+	struct OccluderTriangle {
+		float EdgeA[3];
+		float EdgeB[3];
+		float EdgeC[3];
+		float DepthA;
+		float DepthB;
+		float DepthC;
+		int32_t MinPixelX;
+		int32_t MinPixelY;
+		int32_t MaxPixelX;
+		int32_t MaxPixelY;
+	};
+
+	struct OcclusionLevel {
+		const float* Data;
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	void CheckOcclusionBuffer(const OcclusionBuffer& buffer, const float* viewProjMat) {
+		if (viewProjMat == nullptr) throw LosgapException { "View/projection matrix must not be null." };
+		if (buffer.DepthArr == nullptr || buffer.HiZArr == nullptr) throw LosgapException { "Occlusion buffer memory must not be null." };
+		if (buffer.Width == 0U || buffer.Height == 0U || buffer.Width % OCCLUSION_TILE_SIZE != 0U || buffer.Height % OCCLUSION_TILE_SIZE != 0U) {
+			throw LosgapException { "Occlusion buffer size (" + std::to_string(buffer.Width) + "x" + std::to_string(buffer.Height)
+				+ ") must be a non-zero multiple of " + std::to_string(OCCLUSION_TILE_SIZE) + " in each direction." };
+		}
+	}
+
+	uint32_t HalveLevelSize(uint32_t size) {
+		return (size + 1U) >> 1;
+	}
+
+	uint32_t OcclusionCuller::GetHiZLength(uint32_t width, uint32_t height) {
+		uint32_t result = 0U;
+		while (width > 1U || height > 1U) {
+			width = HalveLevelSize(width);
+			height = HalveLevelSize(height);
+			result += width * height;
+		}
+		return result;
+	}
+	EXPORT_FAST(OcclusionCuller_GetHiZLength, uint32_t width, uint32_t height, uint32_t* outHiZLength) {
+		*outHiZLength = OcclusionCuller::GetHiZLength(width, height);
+		EXPORT_FAST_END;
+	}
+
+	/*
+	Fills outLevelArr with every level of the buffer's pyramid (level 0 being the depth buffer itself) and returns how many there are.
+	*/
+	uint32_t GetOcclusionLevels(const OcclusionBuffer& buffer, OcclusionLevel* outLevelArr) {
+		OcclusionLevel level = { buffer.DepthArr, buffer.Width, buffer.Height };
+		outLevelArr[0] = level;
+		uint32_t numLevels = 1U;
+		const float* nextLevelData = buffer.HiZArr;
+		while (level.Width > 1U || level.Height > 1U) {
+			level.Data = nextLevelData;
+			level.Width = HalveLevelSize(level.Width);
+			level.Height = HalveLevelSize(level.Height);
+			nextLevelData += level.Width * level.Height;
+			outLevelArr[numLevels++] = level;
+		}
+		return numLevels;
+	}
+
+	/*
+	Projects a world-space position to pixel space and depth. Returns false if it is in front of the near plane.
+	*/
+	bool ProjectOccluderVertex(const float* m, const float* position, float width, float height, float& outScreenX, float& outScreenY, float& outDepth) {
+		float clipX = position[0] * m[0] + position[1] * m[4] + position[2] * m[8] + m[12];
+		float clipY = position[0] * m[1] + position[1] * m[5] + position[2] * m[9] + m[13];
+		float clipZ = position[0] * m[2] + position[1] * m[6] + position[2] * m[10] + m[14];
+		float clipW = position[0] * m[3] + position[1] * m[7] + position[2] * m[11] + m[15];
+		if (clipZ < 0.0f || clipW <= 0.0f) return false;
+		float invW = 1.0f / clipW;
+		outScreenX = (clipX * invW + 1.0f) * 0.5f * width;
+		outScreenY = (1.0f - clipY * invW) * 0.5f * height;
+		outDepth = clipZ * invW;
+		return true;
+	}
+
+	void SetUpOccluderTriangle(const float* m, const float* vertexArr, const uint32_t* triangleIndices, const uint32_t* triangleNeighbours,
+		float width, float height, OccluderTriangle& outTriangle) {
+		outTriangle.MinPixelX = 1;
+		outTriangle.MaxPixelX = 0;
+
+		float screenX[3], screenY[3], depth[3];
+		for (uint32_t v = 0U; v < 3U; ++v) {
+			if (!ProjectOccluderVertex(m, vertexArr + triangleIndices[v] * 3U, width, height, screenX[v], screenY[v], depth[v])) return;
+		}
+
+		// Wind every triangle the same way (so that the edge functions are positive inside) by swapping its last two vertices
+		uint32_t neighbours[3];
+		for (uint32_t e = 0U; e < 3U; ++e) neighbours[e] = triangleNeighbours != nullptr ? triangleNeighbours[e] : OCCLUSION_NO_NEIGHBOUR;
+		float doubleArea = (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) - (screenY[1] - screenY[0]) * (screenX[2] - screenX[0]);
+		if (doubleArea < 0.0f) {
+			std::swap(screenX[1], screenX[2]);
+			std::swap(screenY[1], screenY[2]);
+			std::swap(depth[1], depth[2]);
+			std::swap(neighbours[0], neighbours[2]); // Edge 0 (0 to 1) is now edge 2 (1 to 0) and vice versa
+			doubleArea = -doubleArea;
+		}
+		if (!(doubleArea > 0.0f)) return;
+
+		// Pixels are covered when their centre is inside the triangle's (pulled in) edges, or on one of them
+		float minX = std::fmin(std::fmin(screenX[0], screenX[1]), screenX[2]);
+		float minY = std::fmin(std::fmin(screenY[0], screenY[1]), screenY[2]);
+		float maxX = std::fmax(std::fmax(screenX[0], screenX[1]), screenX[2]);
+		float maxY = std::fmax(std::fmax(screenY[0], screenY[1]), screenY[2]);
+		outTriangle.MinPixelX = static_cast<int32_t>(std::ceil(std::fmax(minX - 0.5f, 0.0f)));
+		outTriangle.MinPixelY = static_cast<int32_t>(std::ceil(std::fmax(minY - 0.5f, 0.0f)));
+		outTriangle.MaxPixelX = static_cast<int32_t>(std::floor(std::fmin(maxX, width) - 0.5f));
+		outTriangle.MaxPixelY = static_cast<int32_t>(std::floor(std::fmin(maxY, height) - 0.5f));
+
+		for (uint32_t e = 0U; e < 3U; ++e) {
+			uint32_t start = e;
+			uint32_t end = (e + 1U) % 3U;
+			float a = screenY[start] - screenY[end];
+			float b = screenX[end] - screenX[start];
+			float c = -(a * screenX[start] + b * screenY[start]);
+
+			// Pulling in every edge would also leave a crack down each edge shared with the rest of the occluder (e.g. the diagonal of
+			// a wall), so an edge is left where it is when the neighbouring triangle carries on beyond it on screen, and that pixel is
+			// covered by whichever of the two has its centre
+			bool isOutline = true;
+			float neighbourX, neighbourY, neighbourDepth;
+			if (neighbours[e] != OCCLUSION_NO_NEIGHBOUR
+				&& ProjectOccluderVertex(m, vertexArr + neighbours[e] * 3U, width, height, neighbourX, neighbourY, neighbourDepth)) {
+				isOutline = a * neighbourX + b * neighbourY + c >= 0.0f;
+			}
+			if (isOutline) c -= 0.5f * (std::fabs(a) + std::fabs(b));
+
+			outTriangle.EdgeA[e] = a;
+			outTriangle.EdgeB[e] = b;
+			outTriangle.EdgeC[e] = c;
+		}
+
+		// The farthest depth over a pixel is at the corner the plane slopes away towards
+		float depthPerX = ((depth[1] - depth[0]) * (screenY[2] - screenY[0]) - (depth[2] - depth[0]) * (screenY[1] - screenY[0])) / doubleArea;
+		float depthPerY = ((depth[2] - depth[0]) * (screenX[1] - screenX[0]) - (depth[1] - depth[0]) * (screenX[2] - screenX[0])) / doubleArea;
+		outTriangle.DepthA = depthPerX;
+		outTriangle.DepthB = depthPerY;
+		outTriangle.DepthC = depth[0] - depthPerX * screenX[0] - depthPerY * screenY[0] + 0.5f * (std::fabs(depthPerX) + std::fabs(depthPerY));
+	}
+
+	void RasterizeTriangleInTile(const OccluderTriangle& triangle, float* depthArr, uint32_t width, int32_t tileMinX, int32_t tileMinY) {
+		// Rows are covered four pixels at a time from a multiple of four, which never crosses the tile's edge
+		int32_t minX = (triangle.MinPixelX > tileMinX ? triangle.MinPixelX : tileMinX) & ~3;
+		int32_t tileMaxX = tileMinX + static_cast<int32_t>(OCCLUSION_TILE_SIZE) - 1;
+		int32_t tileMaxY = tileMinY + static_cast<int32_t>(OCCLUSION_TILE_SIZE) - 1;
+		int32_t maxX = triangle.MaxPixelX < tileMaxX ? triangle.MaxPixelX : tileMaxX;
+		int32_t minY = triangle.MinPixelY > tileMinY ? triangle.MinPixelY : tileMinY;
+		int32_t maxY = triangle.MaxPixelY < tileMaxY ? triangle.MaxPixelY : tileMaxY;
+
+#ifdef OCCLUSION_CULLER_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 pixelCentreOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 edgeA0 = _mm_set1_ps(triangle.EdgeA[0]), edgeA1 = _mm_set1_ps(triangle.EdgeA[1]), edgeA2 = _mm_set1_ps(triangle.EdgeA[2]);
+		const __m128 depthA = _mm_set1_ps(triangle.DepthA);
+		for (int32_t y = minY; y <= maxY; ++y) {
+			float centreY = static_cast<float>(y) + 0.5f;
+			const __m128 rowEdge0 = _mm_set1_ps(triangle.EdgeB[0] * centreY + triangle.EdgeC[0]);
+			const __m128 rowEdge1 = _mm_set1_ps(triangle.EdgeB[1] * centreY + triangle.EdgeC[1]);
+			const __m128 rowEdge2 = _mm_set1_ps(triangle.EdgeB[2] * centreY + triangle.EdgeC[2]);
+			const __m128 rowDepth = _mm_set1_ps(triangle.DepthB * centreY + triangle.DepthC);
+			float* row = depthArr + y * width;
+			for (int32_t x = minX; x <= maxX; x += 4) {
+				__m128 centreX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelCentreOffsets);
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, centreX), rowEdge0), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, centreX), rowEdge1), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, centreX), rowEdge2), zero));
+				__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, centreX), rowDepth);
+
+				__m128 previousDepth = _mm_loadu_ps(row + x);
+				__m128 newDepth = _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(depth, previousDepth)), _mm_andnot_ps(inside, previousDepth));
+				_mm_storeu_ps(row + x, newDepth);
+			}
+		}
+#else
+		for (int32_t y = minY; y <= maxY; ++y) {
+			float centreY = static_cast<float>(y) + 0.5f;
+			float rowEdge[3];
+			for (uint32_t e = 0U; e < 3U; ++e) rowEdge[e] = triangle.EdgeB[e] * centreY + triangle.EdgeC[e];
+			float rowDepth = triangle.DepthB * centreY + triangle.DepthC;
+			float* row = depthArr + y * width;
+			for (int32_t x = minX; x <= (maxX | 3); ++x) {
+				float centreX = static_cast<float>(x) + 0.5f;
+				if (triangle.EdgeA[0] * centreX + rowEdge[0] < 0.0f
+					|| triangle.EdgeA[1] * centreX + rowEdge[1] < 0.0f
+					|| triangle.EdgeA[2] * centreX + rowEdge[2] < 0.0f) {
+					continue;
+				}
+				float depth = triangle.DepthA * centreX + rowDepth;
+				if (depth < row[x]) row[x] = depth;
+			}
+		}
+#endif
+	}
+
+	float MaxDepthOf2x2(const float* source, uint32_t sourceWidth, uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1) {
+		float result = std::fmax(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]);
+		result = std::fmax(result, source[y1 * sourceWidth + x0]);
+		return std::fmax(result, source[y1 * sourceWidth + x1]);
+	}
+
+	/*
+	Builds the first OCCLUSION_TILE_LEVELS pyramid levels over one tile, which only ever read from that tile.
+	*/
+	void BuildTileHiZ(const OcclusionLevel* levelArr, uint32_t tileX, uint32_t tileY) {
+		uint32_t tileSize = OCCLUSION_TILE_SIZE;
+		for (uint32_t l = 1U; l <= OCCLUSION_TILE_LEVELS; ++l) {
+			tileSize >>= 1;
+			const OcclusionLevel& source = levelArr[l - 1U];
+			float* dest = const_cast<float*>(levelArr[l].Data);
+			uint32_t destWidth = levelArr[l].Width;
+			for (uint32_t y = tileY * tileSize; y < (tileY + 1U) * tileSize; ++y) {
+				for (uint32_t x = tileX * tileSize; x < (tileX + 1U) * tileSize; ++x) {
+					dest[y * destWidth + x] = MaxDepthOf2x2(source.Data, source.Width, x << 1, (x << 1) + 1U, y << 1, (y << 1) + 1U);
+				}
+			}
+		}
+	}
+
+	/*
+	Builds the rest of the pyramid, where levels may be odd-sized (so the last row or column only has itself to take the max of).
+	*/
+	void BuildUpperHiZ(const OcclusionLevel* levelArr, uint32_t numLevels) {
+		for (uint32_t l = OCCLUSION_TILE_LEVELS + 1U; l < numLevels; ++l) {
+			const OcclusionLevel& source = levelArr[l - 1U];
+			float* dest = const_cast<float*>(levelArr[l].Data);
+			for (uint32_t y = 0U; y < levelArr[l].Height; ++y) {
+				uint32_t y1 = (y << 1) + 1U < source.Height ? (y << 1) + 1U : y << 1;
+				for (uint32_t x = 0U; x < levelArr[l].Width; ++x) {
+					uint32_t x1 = (x << 1) + 1U < source.Width ? (x << 1) + 1U : x << 1;
+					dest[y * levelArr[l].Width + x] = MaxDepthOf2x2(source.Data, source.Width, x << 1, x1, y << 1, y1);
+				}
+			}
+		}
+	}
+
+	void CheckOccluderTriangles(const float* vertexArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices) {
+		if (numIndices % 3U != 0U) throw LosgapException { "Occluder index count (" + std::to_string(numIndices) + ") must be a multiple of 3." };
+		if (numIndices > 0U && (vertexArr == nullptr || indexArr == nullptr)) throw LosgapException { "Occluder vertices and indices must not be null." };
+		for (uint32_t i = 0U; i < numIndices; ++i) {
+			if (indexArr[i] >= numVertices) {
+				throw LosgapException { "Occluder index " + std::to_string(indexArr[i]) + " is out of range (" + std::to_string(numVertices) + " vertices)." };
+			}
+		}
+	}
+
+	/*
+	An edge keyed by its two end positions (bit for bit, lowest first), so that edges match across vertices that are duplicated for
+	the sake of normals or texture coordinates.
+	*/
+	struct OccluderEdgeKey {
+		uint32_t PositionBits[6];
+
+		bool operator==(const OccluderEdgeKey& other) const {
+			return memcmp(PositionBits, other.PositionBits, sizeof(PositionBits)) == 0;
+		}
+	};
+
+	struct OccluderEdgeUses {
+		uint32_t FirstIndex;
+		uint32_t SecondIndex;
+		uint32_t NumUses;
+	};
+
+	struct OccluderEdgeKeyHash {
+		size_t operator()(const OccluderEdgeKey& key) const {
+			size_t result = 0U;
+			for (uint32_t i = 0U; i < 6U; ++i) result = result * 31U + key.PositionBits[i];
+			return result;
+		}
+	};
+
+	void OcclusionCuller::FindEdgeNeighbours(const float* vertexArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices,
+		uint32_t* outNeighbourArr) {
+		CheckOccluderTriangles(vertexArr, numVertices, indexArr, numIndices);
+		if (numIndices > 0U && outNeighbourArr == nullptr) throw LosgapException { "Neighbour array must not be null." };
+
+		// Edges are identified by the index (triangle * 3 + edge) they start at
+		std::unordered_map<OccluderEdgeKey, OccluderEdgeUses, OccluderEdgeKeyHash> edgeUses;
+		edgeUses.reserve(numIndices);
+		for (uint32_t i = 0U; i < numIndices; ++i) {
+			outNeighbourArr[i] = OCCLUSION_NO_NEIGHBOUR;
+			uint32_t triangleStart = i - i % 3U;
+			const float* start = vertexArr + indexArr[i] * 3U;
+			const float* end = vertexArr + indexArr[triangleStart + (i + 1U) % 3U] * 3U;
+			if (memcmp(start, end, 3U * sizeof(float)) == 0) continue;
+			if (memcmp(start, end, 3U * sizeof(float)) > 0) std::swap(start, end);
+			OccluderEdgeKey key;
+			memcpy(key.PositionBits, start, 3U * sizeof(float));
+			memcpy(key.PositionBits + 3U, end, 3U * sizeof(float));
+
+			OccluderEdgeUses newUses = { i, OCCLUSION_NO_NEIGHBOUR, 1U };
+			auto inserted = edgeUses.insert(std::make_pair(key, newUses));
+			if (!inserted.second && inserted.first->second.NumUses++ == 1U) inserted.first->second.SecondIndex = i;
+		}
+
+		for (const auto& edge : edgeUses) {
+			if (edge.second.NumUses != 2U) continue;
+			uint32_t first = edge.second.FirstIndex;
+			uint32_t second = edge.second.SecondIndex;
+			outNeighbourArr[first] = indexArr[second - second % 3U + (second + 2U) % 3U];
+			outNeighbourArr[second] = indexArr[first - first % 3U + (first + 2U) % 3U];
+		}
+	}
+	EXPORT_FAST(OcclusionCuller_FindEdgeNeighbours, const float* vertexArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices,
+		uint32_t* outNeighbourArr) {
+		OcclusionCuller::FindEdgeNeighbours(vertexArr, numVertices, indexArr, numIndices, outNeighbourArr);
+		EXPORT_FAST_END;
+	}
+
+	void OcclusionCuller::RasterizeOccluders(const OcclusionBuffer& buffer, const float* viewProjMat, const float* vertexArr, uint32_t numVertices,
+		const uint32_t* indexArr, const uint32_t* edgeNeighbourArr, uint32_t numIndices) {
+		CheckOcclusionBuffer(buffer, viewProjMat);
+		CheckOccluderTriangles(vertexArr, numVertices, indexArr, numIndices);
+		if (edgeNeighbourArr != nullptr) {
+			for (uint32_t i = 0U; i < numIndices; ++i) {
+				if (edgeNeighbourArr[i] != OCCLUSION_NO_NEIGHBOUR && edgeNeighbourArr[i] >= numVertices) {
+					throw LosgapException { "Occluder edge neighbour " + std::to_string(edgeNeighbourArr[i]) + " is out of range ("
+						+ std::to_string(numVertices) + " vertices)." };
+				}
+			}
+		}
+
+		OcclusionLevel levelArr[MAX_OCCLUSION_LEVELS];
+		uint32_t numLevels = GetOcclusionLevels(buffer, levelArr);
+		uint32_t numTriangles = numIndices / 3U;
+		uint32_t numTilesX = buffer.Width / OCCLUSION_TILE_SIZE;
+		uint32_t numTiles = numTilesX * (buffer.Height / OCCLUSION_TILE_SIZE);
+
+		// Everything the jobs share is allocated up front, from this thread's arena
+		FrameArena* arena = FrameArena::GetThreadArena();
+		OccluderTriangle* triangleArr = static_cast<OccluderTriangle*>(arena->Allocate(numTriangles * sizeof(OccluderTriangle)));
+		uint32_t* tileOffsetArr = static_cast<uint32_t*>(arena->Allocate((numTiles + 1U) * sizeof(uint32_t)));
+		uint32_t* tileCursorArr = static_cast<uint32_t*>(arena->Allocate(numTiles * sizeof(uint32_t)));
+
+		// Set up
+		float width = static_cast<float>(buffer.Width);
+		float height = static_cast<float>(buffer.Height);
+		JobSystem::ParallelFor(numTriangles, OCCLUSION_SETUP_BLOCK_SIZE, [&](uint32_t t) {
+			SetUpOccluderTriangle(viewProjMat, vertexArr, indexArr + t * 3U, edgeNeighbourArr != nullptr ? edgeNeighbourArr + t * 3U : nullptr,
+				width, height, triangleArr[t]);
+		});
+
+		// Bin (counting first, so each tile's list is contiguous, and in triangle order)
+		const int32_t tileSize = static_cast<int32_t>(OCCLUSION_TILE_SIZE);
+		memset(tileCursorArr, 0, numTiles * sizeof(uint32_t));
+		for (uint32_t t = 0U; t < numTriangles; ++t) {
+			const OccluderTriangle& triangle = triangleArr[t];
+			if (triangle.MinPixelX > triangle.MaxPixelX || triangle.MinPixelY > triangle.MaxPixelY) continue;
+			for (int32_t tileY = triangle.MinPixelY / tileSize; tileY <= triangle.MaxPixelY / tileSize; ++tileY) {
+				for (int32_t tileX = triangle.MinPixelX / tileSize; tileX <= triangle.MaxPixelX / tileSize; ++tileX) {
+					++tileCursorArr[tileY * numTilesX + tileX];
+				}
+			}
+		}
+		uint32_t numBinnedTriangles = 0U;
+		for (uint32_t tile = 0U; tile < numTiles; ++tile) {
+			tileOffsetArr[tile] = numBinnedTriangles;
+			numBinnedTriangles += tileCursorArr[tile];
+			tileCursorArr[tile] = tileOffsetArr[tile];
+		}
+		tileOffsetArr[numTiles] = numBinnedTriangles;
+		uint32_t* tileTriangleArr = static_cast<uint32_t*>(arena->Allocate(numBinnedTriangles * sizeof(uint32_t)));
+		for (uint32_t t = 0U; t < numTriangles; ++t) {
+			const OccluderTriangle& triangle = triangleArr[t];
+			if (triangle.MinPixelX > triangle.MaxPixelX || triangle.MinPixelY > triangle.MaxPixelY) continue;
+			for (int32_t tileY = triangle.MinPixelY / tileSize; tileY <= triangle.MaxPixelY / tileSize; ++tileY) {
+				for (int32_t tileX = triangle.MinPixelX / tileSize; tileX <= triangle.MaxPixelX / tileSize; ++tileX) {
+					tileTriangleArr[tileCursorArr[tileY * numTilesX + tileX]++] = t;
+				}
+			}
+		}
+
+		// Rasterise (each tile is cleared, drawn and reduced by one job, and no two jobs touch the same pixels)
+		JobSystem::ParallelFor(numTiles, 1U, [&](uint32_t tile) {
+			uint32_t tileX = tile % numTilesX;
+			uint32_t tileY = tile / numTilesX;
+			int32_t tileMinX = static_cast<int32_t>(tileX * OCCLUSION_TILE_SIZE);
+			int32_t tileMinY = static_cast<int32_t>(tileY * OCCLUSION_TILE_SIZE);
+			for (uint32_t y = 0U; y < OCCLUSION_TILE_SIZE; ++y) {
+				float* row = buffer.DepthArr + (tileMinY + y) * buffer.Width + tileMinX;
+				for (uint32_t x = 0U; x < OCCLUSION_TILE_SIZE; ++x) row[x] = OCCLUSION_CLEAR_DEPTH;
+			}
+			for (uint32_t i = tileOffsetArr[tile]; i < tileOffsetArr[tile + 1U]; ++i) {
+				RasterizeTriangleInTile(triangleArr[tileTriangleArr[i]], buffer.DepthArr, buffer.Width, tileMinX, tileMinY);
+			}
+			BuildTileHiZ(levelArr, tileX, tileY);
+		});
+		BuildUpperHiZ(levelArr, numLevels);
+	}
+	EXPORT_FAST(OcclusionCuller_RasterizeOccluders, const OcclusionBuffer* buffer, const float* viewProjMat, const float* vertexArr, uint32_t numVertices,
+		const uint32_t* indexArr, const uint32_t* edgeNeighbourArr, uint32_t numIndices) {
+		OcclusionCuller::RasterizeOccluders(*buffer, viewProjMat, vertexArr, numVertices, indexArr, edgeNeighbourArr, numIndices);
+		EXPORT_FAST_END;
+	}
+
+	bool IsBoxVisible(const OcclusionBox& box, const float* m, const OcclusionLevel* levelArr, uint32_t numLevels) {
+		float width = static_cast<float>(levelArr[0].Width);
+		float height = static_cast<float>(levelArr[0].Height);
+		float minScreenX, minScreenY, maxScreenX, maxScreenY, minDepth;
+
+#ifdef OCCLUSION_CULLER_SSE2
+		// The eight corners, as two sets of four (near Z then far Z)
+		const __m128 cornerX = _mm_set_ps(box.MaxX, box.MinX, box.MaxX, box.MinX);
+		const __m128 cornerY = _mm_set_ps(box.MaxY, box.MaxY, box.MinY, box.MinY);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		__m128 partialX = _mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m[0])), _mm_mul_ps(cornerY, _mm_set1_ps(m[4])));
+		__m128 partialY = _mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m[1])), _mm_mul_ps(cornerY, _mm_set1_ps(m[5])));
+		__m128 partialZ = _mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m[2])), _mm_mul_ps(cornerY, _mm_set1_ps(m[6])));
+		__m128 partialW = _mm_add_ps(_mm_mul_ps(cornerX, _mm_set1_ps(m[3])), _mm_mul_ps(cornerY, _mm_set1_ps(m[7])));
+
+		__m128 minX = _mm_set1_ps(FLT_MAX), minY = _mm_set1_ps(FLT_MAX), minZ = _mm_set1_ps(FLT_MAX);
+		__m128 maxX = _mm_set1_ps(-FLT_MAX), maxY = _mm_set1_ps(-FLT_MAX);
+		const float cornerZs[2] = { box.MinZ, box.MaxZ };
+		for (uint32_t zIndex = 0U; zIndex < 2U; ++zIndex) {
+			__m128 z = _mm_set1_ps(cornerZs[zIndex]);
+			__m128 clipX = _mm_add_ps(_mm_add_ps(partialX, _mm_mul_ps(z, _mm_set1_ps(m[8]))), _mm_set1_ps(m[12]));
+			__m128 clipY = _mm_add_ps(_mm_add_ps(partialY, _mm_mul_ps(z, _mm_set1_ps(m[9]))), _mm_set1_ps(m[13]));
+			__m128 clipZ = _mm_add_ps(_mm_add_ps(partialZ, _mm_mul_ps(z, _mm_set1_ps(m[10]))), _mm_set1_ps(m[14]));
+			__m128 clipW = _mm_add_ps(_mm_add_ps(partialW, _mm_mul_ps(z, _mm_set1_ps(m[11]))), _mm_set1_ps(m[15]));
+			if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(clipZ, zero), _mm_cmple_ps(clipW, zero))) != 0) return true;
+
+			__m128 invW = _mm_div_ps(one, clipW);
+			__m128 screenX = _mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(clipX, invW), one), half), _mm_set1_ps(width));
+			__m128 screenY = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(clipY, invW)), half), _mm_set1_ps(height));
+			minX = _mm_min_ps(minX, screenX);
+			minY = _mm_min_ps(minY, screenY);
+			maxX = _mm_max_ps(maxX, screenX);
+			maxY = _mm_max_ps(maxY, screenY);
+			minZ = _mm_min_ps(minZ, _mm_mul_ps(clipZ, invW));
+		}
+
+		// Reduce across the lanes
+		minX = _mm_min_ps(minX, _mm_shuffle_ps(minX, minX, _MM_SHUFFLE(1, 0, 3, 2)));
+		minY = _mm_min_ps(minY, _mm_shuffle_ps(minY, minY, _MM_SHUFFLE(1, 0, 3, 2)));
+		minZ = _mm_min_ps(minZ, _mm_shuffle_ps(minZ, minZ, _MM_SHUFFLE(1, 0, 3, 2)));
+		maxX = _mm_max_ps(maxX, _mm_shuffle_ps(maxX, maxX, _MM_SHUFFLE(1, 0, 3, 2)));
+		maxY = _mm_max_ps(maxY, _mm_shuffle_ps(maxY, maxY, _MM_SHUFFLE(1, 0, 3, 2)));
+		minScreenX = _mm_cvtss_f32(_mm_min_ps(minX, _mm_shuffle_ps(minX, minX, _MM_SHUFFLE(2, 3, 0, 1))));
+		minScreenY = _mm_cvtss_f32(_mm_min_ps(minY, _mm_shuffle_ps(minY, minY, _MM_SHUFFLE(2, 3, 0, 1))));
+		minDepth = _mm_cvtss_f32(_mm_min_ps(minZ, _mm_shuffle_ps(minZ, minZ, _MM_SHUFFLE(2, 3, 0, 1))));
+		maxScreenX = _mm_cvtss_f32(_mm_max_ps(maxX, _mm_shuffle_ps(maxX, maxX, _MM_SHUFFLE(2, 3, 0, 1))));
+		maxScreenY = _mm_cvtss_f32(_mm_max_ps(maxY, _mm_shuffle_ps(maxY, maxY, _MM_SHUFFLE(2, 3, 0, 1))));
+#else
+		minScreenX = minScreenY = minDepth = FLT_MAX;
+		maxScreenX = maxScreenY = -FLT_MAX;
+		for (uint32_t corner = 0U; corner < 8U; ++corner) {
+			float x = (corner & 1U) != 0U ? box.MaxX : box.MinX;
+			float y = (corner & 2U) != 0U ? box.MaxY : box.MinY;
+			float z = (corner & 4U) != 0U ? box.MaxZ : box.MinZ;
+			float clipX = (x * m[0] + y * m[4]) + z * m[8] + m[12];
+			float clipY = (x * m[1] + y * m[5]) + z * m[9] + m[13];
+			float clipZ = (x * m[2] + y * m[6]) + z * m[10] + m[14];
+			float clipW = (x * m[3] + y * m[7]) + z * m[11] + m[15];
+			if (clipZ < 0.0f || clipW <= 0.0f) return true;
+
+			float invW = 1.0f / clipW;
+			float screenX = (clipX * invW + 1.0f) * 0.5f * width;
+			float screenY = (1.0f - clipY * invW) * 0.5f * height;
+			minScreenX = std::fmin(minScreenX, screenX);
+			minScreenY = std::fmin(minScreenY, screenY);
+			maxScreenX = std::fmax(maxScreenX, screenX);
+			maxScreenY = std::fmax(maxScreenY, screenY);
+			minDepth = std::fmin(minDepth, clipZ * invW);
+		}
+#endif
+
+		if (maxScreenX <= 0.0f || minScreenX >= width || maxScreenY <= 0.0f || minScreenY >= height) return false;
+		int32_t x0 = static_cast<int32_t>(std::floor(std::fmax(minScreenX, 0.0f)));
+		int32_t y0 = static_cast<int32_t>(std::floor(std::fmax(minScreenY, 0.0f)));
+		int32_t x1 = static_cast<int32_t>(std::ceil(std::fmin(maxScreenX, width))) - 1;
+		int32_t y1 = static_cast<int32_t>(std::ceil(std::fmin(maxScreenY, height))) - 1;
+		if (x1 < x0) x1 = x0;
+		if (y1 < y0) y1 = y0;
+
+		// The first level where the box's bounds fit in 2x2 texels; every texel there is the farthest occluder over its pixels
+		uint32_t level = 0U;
+		while (level + 1U < numLevels && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) ++level;
+		const OcclusionLevel& levelData = levelArr[level];
+		for (int32_t y = y0 >> level; y <= y1 >> level; ++y) {
+			for (int32_t x = x0 >> level; x <= x1 >> level; ++x) {
+				if (levelData.Data[y * levelData.Width + x] >= minDepth) return true;
+			}
+		}
+		return false;
+	}
+
+	void OcclusionCuller::TestBoxes(const OcclusionBuffer& buffer, const float* viewProjMat, const OcclusionBox* boxArr, uint32_t numBoxes,
+		uint32_t* outVisibilityBits) {
+		CheckOcclusionBuffer(buffer, viewProjMat);
+		OcclusionLevel levelArr[MAX_OCCLUSION_LEVELS];
+		uint32_t numLevels = GetOcclusionLevels(buffer, levelArr);
+
+		memset(outVisibilityBits, 0, ((numBoxes + 31U) >> 5) * sizeof(uint32_t));
+		for (uint32_t i = 0U; i < numBoxes; ++i) {
+			if (IsBoxVisible(boxArr[i], viewProjMat, levelArr, numLevels)) outVisibilityBits[i >> 5] |= 1U << (i & 31U);
+		}
+	}
+	EXPORT_FAST(OcclusionCuller_TestBoxes, const OcclusionBuffer* buffer, const float* viewProjMat, const OcclusionBox* boxArr, uint32_t numBoxes,
+		uint32_t* outVisibilityBits) {
+		OcclusionCuller::TestBoxes(*buffer, viewProjMat, boxArr, numBoxes, outVisibilityBits);
+		EXPORT_FAST_END;
+	}
+
+	uint32_t OcclusionCuller::CullInstances(const OcclusionBuffer& buffer, const float* viewProjMat, const BoundingSphere* modelSphereArr, uint32_t numModels,
+		const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices) {
+		if (numInstances == 0U) return 0U;
+
+		FrameArena* arena = FrameArena::GetThreadArena();
+		BoundingSphere* worldSphereArr = static_cast<BoundingSphere*>(arena->Allocate(numInstances * sizeof(BoundingSphere)));
+		FrustumCuller::TransformSpheres(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, worldSphereArr);
+		OcclusionBox* boxArr = static_cast<OcclusionBox*>(arena->Allocate(numInstances * sizeof(OcclusionBox)));
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			const BoundingSphere& sphere = worldSphereArr[i];
+			OcclusionBox& box = boxArr[i];
+			box.MinX = sphere.X - sphere.Radius;
+			box.MinY = sphere.Y - sphere.Radius;
+			box.MinZ = sphere.Z - sphere.Radius;
+			box.MaxX = sphere.X + sphere.Radius;
+			box.MaxY = sphere.Y + sphere.Radius;
+			box.MaxZ = sphere.Z + sphere.Radius;
+		}
+		uint32_t* visibilityBits = static_cast<uint32_t*>(arena->Allocate(((numInstances + 31U) >> 5) * sizeof(uint32_t)));
+		TestBoxes(buffer, viewProjMat, boxArr, numInstances, visibilityBits);
+
+		// Every index is written, but the count only moves past the visible ones
+		uint32_t numVisible = 0U;
+		for (uint32_t i = 0U; i < numInstances; ++i) {
+			outVisibleIndices[numVisible] = i;
+			numVisible += (visibilityBits[i >> 5] >> (i & 31U)) & 1U;
+		}
+		return numVisible;
+	}
+	EXPORT_FAST(OcclusionCuller_CullInstances, const OcclusionBuffer* buffer, const float* viewProjMat, const BoundingSphere* modelSphereArr, uint32_t numModels,
+		const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices, uint32_t* outNumVisible) {
+		*outNumVisible = OcclusionCuller::CullInstances(*buffer, viewProjMat, modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, outVisibleIndices);
+		EXPORT_FAST_END;
+	}
+}
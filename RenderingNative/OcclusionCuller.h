@@ -0,0 +1,88 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "FrustumCuller.h"
+
+namespace losgap {
+	const uint32_t OCCLUSION_TILE_SIZE = 16U;
+	const uint32_t OCCLUSION_TILE_LEVELS = 4U; // log2(OCCLUSION_TILE_SIZE): the pyramid levels that are built tile by tile
+	const uint32_t OCCLUSION_NO_NEIGHBOUR = 0xFFFFFFFFU;
+
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	A software depth buffer and its hierarchical-Z pyramid, in memory owned by the caller (see OcclusionBuffer.cs). Depth runs from 0
+	(near) to 1 (far) as with D3D, and rows start at the top of the screen. Level 0 of the pyramid is DepthArr itself; HiZArr holds
+	levels 1 upwards back to back, each half the size of the one before (rounding up) down to a single texel, where every texel is
+	the farthest depth of the (up to) 2x2 texels under it. Width and Height must be non-zero multiples of OCCLUSION_TILE_SIZE.
+	*/
+	struct OcclusionBuffer {
+		float* DepthArr;
+		float* HiZArr;
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	struct OcclusionBox {
+		float MinX;
+		float MinY;
+		float MinZ;
+		float MaxX;
+		float MaxY;
+		float MaxZ;
+	};
+#pragma pack(pop)
+
+	/*
+	A static class that rasterises occluder triangles in to a low resolution OcclusionBuffer and tests bounding boxes against it. Both
+	are CPU-only and deterministic: the result never depends on how many threads the job system has, or on the order triangles finish.
+	viewProjMat is always a row-major view * projection matrix for row vectors (i.e. not transposed), with D3D's 0 to 1 clip depth,
+	and must be the same for the tests as for the rasterisation they test against.
+	*/
+	class OcclusionCuller {
+	public:
+		/*
+		The number of floats HiZArr must have room for.
+		*/
+		static uint32_t GetHiZLength(uint32_t width, uint32_t height);
+
+		/*
+		For each edge of the given triangles (edge e of triangle t running from index t * 3 + e to the next), writes the vertex
+		opposite that edge in the one other triangle that shares it to outNeighbourArr (numIndices long), or OCCLUSION_NO_NEIGHBOUR if
+		no other triangle (or more than one) does. Edges are matched by position, so duplicated vertices still join up. The result
+		only depends on the occluders, so it is worked out once when they change rather than every frame.
+		*/
+		static void FindEdgeNeighbours(const float* vertexArr, uint32_t numVertices, const uint32_t* indexArr, uint32_t numIndices,
+			uint32_t* outNeighbourArr);
+
+		/*
+		Clears the buffer to the far plane and rasterises the given world-space triangles (three indices each) in to it, then builds
+		the pyramid. Coverage is inner-conservative: a pixel is only covered when it lies entirely inside the occluder, which is
+		tested at its centre against edges pulled in by half a pixel. Edges that a neighbour in edgeNeighbourArr (from
+		FindEdgeNeighbours(), or null to treat every edge as the outline) carries on beyond on screen are not pulled in, so that the
+		inside of a mesh does not crack along its triangles' seams. Covered pixels are written with the farthest depth the triangle's
+		plane has anywhere over them, so that a low resolution buffer never pulls an occluder closer. Triangles that reach in front of
+		the near plane are skipped rather than clipped. Triangles are set up in parallel, binned in to tiles of OCCLUSION_TILE_SIZE
+		pixels square, and then each tile is rasterised (four pixels at a time with SSE2) as its own job.
+		*/
+		static void RasterizeOccluders(const OcclusionBuffer& buffer, const float* viewProjMat, const float* vertexArr, uint32_t numVertices,
+			const uint32_t* indexArr, const uint32_t* edgeNeighbourArr, uint32_t numIndices);
+
+		/*
+		Sets bit i of outVisibilityBits ((numBoxes + 31) / 32 words) when boxArr[i] may be visible, and clears it when the box is
+		entirely hidden behind the buffer's occluders (or entirely off screen). Boxes that reach in front of the near plane are always
+		visible. Each box is tested against the smallest pyramid level that covers its screen bounds with 2x2 texels.
+		*/
+		static void TestBoxes(const OcclusionBuffer& buffer, const float* viewProjMat, const OcclusionBox* boxArr, uint32_t numBoxes,
+			uint32_t* outVisibilityBits);
+
+		/*
+		Places the instances' bounding spheres (as FrustumCuller::TransformSpheres does), tests the box around each, and writes the
+		indices of those that may be visible to outVisibleIndices in ascending order. Returns how many were written.
+		*/
+		static uint32_t CullInstances(const OcclusionBuffer& buffer, const float* viewProjMat, const BoundingSphere* modelSphereArr, uint32_t numModels,
+			const InstanceTransform* transformArr, const uint32_t* modelIndexArr, uint32_t numInstances, uint32_t* outVisibleIndices);
+	};
+}
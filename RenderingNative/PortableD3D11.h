@@ -0,0 +1,104 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+
+/*
+The D3D11 declarations that the render command translator, state cache, flush profiler and capture replay use. On Windows this is
+just d3d11.h. Everywhere else (see CMakeLists.txt) those files only ever drive stand-in contexts such as CountingDeviceContext, which
+never dereference a device object, so the interfaces are declared opaquely and only the plain structs, enums and constants the
+translator passes by value are defined, with the same layouts and values as in d3d11.h.
+*/
+#ifdef _WIN32
+#include <d3d11.h>
+#else
+#include <cstdint>
+
+typedef uint8_t UINT8;
+typedef int32_t INT;
+typedef uint32_t UINT;
+typedef int32_t BOOL;
+typedef int32_t LONG;
+typedef float FLOAT;
+typedef int32_t HRESULT;
+
+#define FALSE 0
+#define TRUE 1
+#define S_OK ((HRESULT) 0L)
+#define SUCCEEDED(hr) (((HRESULT) (hr)) >= 0)
+#define FAILED(hr) (((HRESULT) (hr)) < 0)
+
+#define D3D11_VS_INPUT_REGISTER_COUNT ( 32 )
+#define D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT ( 32 )
+#define D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT ( 8 )
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT ( 14 )
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT ( 16 )
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT ( 128 )
+
+struct ID3D11DeviceContext;
+struct ID3D11CommandList;
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11ClassInstance;
+struct ID3D11RasterizerState;
+struct ID3D11DepthStencilState;
+struct ID3D11BlendState;
+struct ID3D11SamplerState;
+struct ID3D11ShaderResourceView;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+struct ID3D11Resource { };
+struct ID3D11Buffer : public ID3D11Resource { };
+struct IDXGISwapChain;
+
+enum DXGI_FORMAT {
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32_UINT = 42
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY {
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D11_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5
+};
+
+enum D3D11_MAP {
+	D3D11_MAP_READ = 1,
+	D3D11_MAP_WRITE = 2,
+	D3D11_MAP_READ_WRITE = 3,
+	D3D11_MAP_WRITE_DISCARD = 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE = 5
+};
+
+enum D3D11_CLEAR_FLAG {
+	D3D11_CLEAR_DEPTH = 0x1L,
+	D3D11_CLEAR_STENCIL = 0x2L
+};
+
+struct D3D11_VIEWPORT {
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+struct D3D11_RECT {
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE {
+	void* pData;
+	UINT RowPitch;
+	UINT DepthPitch;
+};
+#endif
@@ -0,0 +1,141 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderStateCache.h"
+#include "FlushProfiler.h"
+#include <d3d11.h>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace losgap {
+	/*
+	What a RecordingDeviceContext hands back from FinishCommandList(): the calls recorded since the last one.
+	*/
+	class RecordingCommandList {
+	public:
+		std::string Log;
+
+		explicit RecordingCommandList(std::string log) : Log(std::move(log)) { }
+		DISALLOW_COPY_ASSIGN_MOVE(RecordingCommandList);
+
+		void Release() { delete this; }
+	};
+
+	/*
+	A stand-in for ID3D11DeviceContext with the subset of members that RenderCommandTranslator uses. Instead of talking to a device,
+	every call is appended to Log as one "Name(arg, arg, ...)" line, with pointers written as plain integers. Executing a command list
+	appends that list's log, so the immediate context's log shows the order that deferred work would have reached the GPU in.
+	*/
+	class RecordingDeviceContext {
+	private:
+		uint8_t mappedScratch[1024];
+
+		void Record(const char* name, std::initializer_list<uint64_t> args) {
+			Log += name;
+			Log += '(';
+			bool isFirstArg = true;
+			for (uint64_t arg : args) {
+				if (!isFirstArg) Log += ", ";
+				Log += std::to_string(arg);
+				isFirstArg = false;
+			}
+			Log += ")\n";
+		}
+
+		static uint64_t Ptr(const void* pointer) {
+			return reinterpret_cast<uintptr_t>(pointer);
+		}
+
+		static uint64_t FirstPtr(const void* const* pointerArr, uint32_t numPointers) {
+			return numPointers > 0U && pointerArr != nullptr ? Ptr(pointerArr[0]) : 0U;
+		}
+
+	public:
+		std::string Log;
+		RenderStateCache StateCache;
+		FlushProfile Profile;
+
+		RecordingDeviceContext() : Log(), StateCache(), Profile() { }
+		DISALLOW_COPY_ASSIGN_MOVE(RecordingDeviceContext);
+
+		void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) { Record("IASetPrimitiveTopology", { static_cast<uint64_t>(topology) }); }
+		void IASetInputLayout(ID3D11InputLayout* layout) { Record("IASetInputLayout", { Ptr(layout) }); }
+		void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT, UINT) { Record("IASetIndexBuffer", { Ptr(buffer) }); }
+		void IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* bufferArr, const UINT* strideArr, const UINT*) {
+			Record("IASetVertexBuffers", { startSlot, numBuffers, FirstPtr(reinterpret_cast<const void* const*>(bufferArr), numBuffers),
+				numBuffers > 0U ? strideArr[0] : 0U });
+		}
+		void VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const*, UINT) { Record("VSSetShader", { Ptr(shader) }); }
+		void PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const*, UINT) { Record("PSSetShader", { Ptr(shader) }); }
+		void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* bufferArr) {
+			Record("VSSetConstantBuffers", { startSlot, numBuffers, FirstPtr(reinterpret_cast<const void* const*>(bufferArr), numBuffers) });
+		}
+		void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* bufferArr) {
+			Record("PSSetConstantBuffers", { startSlot, numBuffers, FirstPtr(reinterpret_cast<const void* const*>(bufferArr), numBuffers) });
+		}
+		void VSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplerArr) {
+			Record("VSSetSamplers", { startSlot, numSamplers, FirstPtr(reinterpret_cast<const void* const*>(samplerArr), numSamplers) });
+		}
+		void PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplerArr) {
+			Record("PSSetSamplers", { startSlot, numSamplers, FirstPtr(reinterpret_cast<const void* const*>(samplerArr), numSamplers) });
+		}
+		void VSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* srvArr) {
+			Record("VSSetShaderResources", { startSlot, numViews, FirstPtr(reinterpret_cast<const void* const*>(srvArr), numViews) });
+		}
+		void PSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* srvArr) {
+			Record("PSSetShaderResources", { startSlot, numViews, FirstPtr(reinterpret_cast<const void* const*>(srvArr), numViews) });
+		}
+		void RSSetState(ID3D11RasterizerState* rs) { Record("RSSetState", { Ptr(rs) }); }
+		void RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* viewportArr) {
+			Record("RSSetViewports", { numViewports, static_cast<uint64_t>(viewportArr[0].Width), static_cast<uint64_t>(viewportArr[0].Height) });
+		}
+		void RSSetScissorRects(UINT numRects, const D3D11_RECT*) { Record("RSSetScissorRects", { numRects }); }
+		void OMSetDepthStencilState(ID3D11DepthStencilState* ds, UINT) { Record("OMSetDepthStencilState", { Ptr(ds) }); }
+		void OMSetBlendState(ID3D11BlendState* bs, const FLOAT*, UINT) { Record("OMSetBlendState", { Ptr(bs) }); }
+		void OMSetRenderTargets(UINT numRTVs, ID3D11RenderTargetView* const* rtvArr, ID3D11DepthStencilView* dsv) {
+			Record("OMSetRenderTargets", { numRTVs, FirstPtr(reinterpret_cast<const void* const*>(rtvArr), numRTVs), Ptr(dsv) });
+		}
+		HRESULT Map(ID3D11Resource* resource, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE* outMappedSubresource) {
+			Record("Map", { Ptr(resource) });
+			outMappedSubresource->pData = mappedScratch;
+			outMappedSubresource->RowPitch = sizeof(mappedScratch);
+			outMappedSubresource->DepthPitch = sizeof(mappedScratch);
+			return S_OK;
+		}
+		void Unmap(ID3D11Resource* resource, UINT) { Record("Unmap", { Ptr(resource) }); }
+		void DrawIndexedInstanced(UINT numIndices, UINT numInstances, UINT firstIndex, INT firstVertex, UINT firstInstance) {
+			Record("DrawIndexedInstanced", { numIndices, numInstances, firstIndex, static_cast<uint64_t>(static_cast<int64_t>(firstVertex)), firstInstance });
+		}
+		void Draw(UINT numVertices, UINT firstVertex) { Record("Draw", { numVertices, firstVertex }); }
+		void ClearRenderTargetView(ID3D11RenderTargetView* rtv, const FLOAT*) { Record("ClearRenderTargetView", { Ptr(rtv) }); }
+		void ClearDepthStencilView(ID3D11DepthStencilView* dsv, UINT, FLOAT, UINT8) { Record("ClearDepthStencilView", { Ptr(dsv) }); }
+
+		HRESULT FinishCommandList(BOOL, RecordingCommandList** outCommandList) {
+			*outCommandList = new RecordingCommandList(std::move(Log));
+			Log.clear();
+			return S_OK;
+		}
+		HRESULT FinishCommandList(BOOL, ID3D11CommandList**) {
+			throw LosgapException { "RecordingDeviceContext can only finish in to a RecordingCommandList." };
+		}
+		void ExecuteCommandList(RecordingCommandList* commandList, BOOL) {
+			Log += commandList->Log;
+		}
+	};
+
+	inline RenderStateCache* GetStateCache(RecordingDeviceContext* deviceContextPtr) {
+		return &deviceContextPtr->StateCache;
+	}
+
+	inline FlushProfile* GetFlushProfile(RecordingDeviceContext* deviceContextPtr) {
+		return &deviceContextPtr->Profile;
+	}
+
+	inline void PresentSwapChain(RecordingDeviceContext* deviceContextPtr, IDXGISwapChain* swapChainPtr) {
+		deviceContextPtr->Log += "Present(" + std::to_string(reinterpret_cast<uintptr_t>(swapChainPtr)) + ")\n";
+	}
+}
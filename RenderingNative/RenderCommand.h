@@ -5,9 +5,12 @@
 #pragma once
 #include "../CoreNative/LosgapCore.h"
 #include "RenderCommandInstruction.h"
-#include <d3d11.h>
+#include "PortableD3D11.h"
 
 namespace losgap {
+	// The format of every index buffer ResourceFactory creates, and so the format RenderCommandTranslator binds them with
+	const DXGI_FORMAT INDEX_BUFFER_FORMAT = DXGI_FORMAT::DXGI_FORMAT_R32_UINT;
+
 	/*
 	An interop struct detailing a single render command
 	*/
@@ -0,0 +1,226 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "RenderCommandCapture.h"
+#include "CompactCommandStream.h"
+#include <fstream>
+#include <unordered_map>
+
+namespace losgap {
+	const size_t CAPTURE_FLUSH_THRESHOLD_BYTES = 1024U * 1024U;
+
+	std::atomic<bool> RenderCommandCapture::isCapturing { false };
+	std::mutex RenderCommandCapture::captureLock;
+	std::vector<char> RenderCommandCapture::writeBuffer;
+
+	std::ofstream captureFile;
+	std::unordered_map<const void*, uint64_t> capturedObjectIds;
+	uint64_t nextCapturedObjectId = 1U;
+
+	void RenderCommandCapture::WriteBytes(const void* data, size_t numBytes) {
+		const char* dataAsChars = static_cast<const char*>(data);
+		writeBuffer.insert(writeBuffer.end(), dataAsChars, dataAsChars + numBytes);
+	}
+
+	uint64_t RenderCommandCapture::GetObjectId(const void* objectPtr) {
+		if (objectPtr == nullptr) return 0U;
+		uint64_t& id = capturedObjectIds[objectPtr];
+		if (id == 0U) id = nextCapturedObjectId++;
+		return id;
+	}
+
+	uint64_t RenderCommandCapture::CreateCommandListId(const void* commandListPtr) {
+		// Command lists are released as soon as they're executed, so a new list may well reuse an old one's address
+		uint64_t id = nextCapturedObjectId++;
+		if (commandListPtr != nullptr) capturedObjectIds[commandListPtr] = id;
+		return id;
+	}
+
+	void RenderCommandCapture::WriteObjectIds(const void* const* objectPtrArr, uint32_t numObjects) {
+		for (uint32_t i = 0U; i < numObjects; ++i) {
+			WriteUInt64(GetObjectId(objectPtrArr != nullptr ? objectPtrArr[i] : nullptr));
+		}
+	}
+
+	void RenderCommandCapture::WriteCommand(const RenderCommand& command) {
+		WriteUInt8(static_cast<uint8_t>(command.Instruction));
+		const void* arg1AsPtr = reinterpret_cast<const void*>(static_cast<uintptr_t>(command.Arg1));
+
+		switch (command.Instruction) {
+			case RenderCommandInstruction::VSSetCBuffers:
+			case RenderCommandInstruction::FSSetCBuffers:
+			case RenderCommandInstruction::VSSetSamplers:
+			case RenderCommandInstruction::FSSetSamplers:
+			case RenderCommandInstruction::VSSetResources:
+			case RenderCommandInstruction::FSSetResources:
+				WriteUInt64(0U);
+				WriteUInt64(command.Arg2);
+				WriteUInt64(command.Arg3);
+				WriteObjectIds(static_cast<const void* const*>(arg1AsPtr), static_cast<uint32_t>(command.Arg2));
+				break;
+			case RenderCommandInstruction::SetVertexBuffers: {
+				uint32_t numBuffers = static_cast<uint32_t>(command.Arg3);
+				WriteUInt64(0U);
+				WriteUInt64(0U);
+				WriteUInt64(command.Arg3);
+				WriteObjectIds(static_cast<const void* const*>(arg1AsPtr), numBuffers);
+				WriteBytes(reinterpret_cast<const void*>(static_cast<uintptr_t>(command.Arg2)), numBuffers * sizeof(uint32_t));
+				break;
+			}
+			case RenderCommandInstruction::SetRenderTargets:
+				WriteUInt64(0U);
+				WriteUInt64(GetObjectId(reinterpret_cast<const void*>(static_cast<uintptr_t>(command.Arg2))));
+				WriteUInt64(command.Arg3);
+				WriteObjectIds(static_cast<const void* const*>(arg1AsPtr), static_cast<uint32_t>(command.Arg3));
+				break;
+			case RenderCommandInstruction::CBDiscardWrite:
+			case RenderCommandInstruction::BufferWrite:
+				WriteUInt64(GetObjectId(arg1AsPtr));
+				WriteUInt64(0U);
+				WriteUInt64(command.Arg3);
+				WriteBytes(reinterpret_cast<const void*>(static_cast<uintptr_t>(command.Arg2)), static_cast<uint32_t>(command.Arg3));
+				break;
+			case RenderCommandInstruction::SetViewport:
+				WriteUInt64(0U);
+				WriteUInt64(0U);
+				WriteUInt64(0U);
+				WriteBytes(arg1AsPtr, sizeof(D3D11_VIEWPORT));
+				break;
+			case RenderCommandInstruction::FinishCommandList:
+				// Only captured after a successful flush, so the list has already been written out
+				WriteUInt64(CreateCommandListId(*static_cast<ID3D11CommandList* const*>(arg1AsPtr)));
+				WriteUInt64(0U);
+				WriteUInt64(0U);
+				break;
+			case RenderCommandInstruction::SetInputLayout:
+			case RenderCommandInstruction::SetIndexBuffer:
+			case RenderCommandInstruction::SetInstanceBuffer:
+			case RenderCommandInstruction::VSSetShader:
+			case RenderCommandInstruction::FSSetShader:
+			case RenderCommandInstruction::SetRSState:
+			case RenderCommandInstruction::SetDSState:
+			case RenderCommandInstruction::SetBlendState:
+			case RenderCommandInstruction::ClearRenderTarget:
+			case RenderCommandInstruction::ClearDepthStencil:
+			case RenderCommandInstruction::SwapChainPresent:
+				WriteUInt64(GetObjectId(arg1AsPtr));
+				WriteUInt64(command.Arg2);
+				WriteUInt64(command.Arg3);
+				break;
+			default:
+				WriteUInt64(command.Arg1);
+				WriteUInt64(command.Arg2);
+				WriteUInt64(command.Arg3);
+				break;
+		}
+	}
+
+	void RenderCommandCapture::WriteStreamHeader(ID3D11DeviceContext* deviceContextPtr, uint32_t numCommands) {
+		WriteUInt8(CaptureRecordStream);
+		WriteUInt64(GetObjectId(deviceContextPtr));
+		WriteUInt32(numCommands);
+	}
+
+	void RenderCommandCapture::FlushBufferIfFull() {
+		if (writeBuffer.size() < CAPTURE_FLUSH_THRESHOLD_BYTES) return;
+		captureFile.write(&writeBuffer.front(), writeBuffer.size());
+		writeBuffer.clear();
+	}
+
+	void RenderCommandCapture::BeginCapture(const char* captureFilePath) {
+		if (captureFilePath == nullptr) throw LosgapException { "Capture file path must not be null." };
+		std::lock_guard<std::mutex> lock { captureLock };
+		if (IsCapturing()) throw LosgapException { "A render capture is already in progress." };
+
+		captureFile.open(captureFilePath, std::ofstream::binary | std::ofstream::trunc);
+		if (!captureFile) throw LosgapException { "Could not open render capture file for writing." };
+
+		writeBuffer.reserve(CAPTURE_FLUSH_THRESHOLD_BYTES * 2U);
+		WriteUInt32(RENDER_CAPTURE_MAGIC);
+		WriteUInt32(RENDER_CAPTURE_VERSION);
+		capturedObjectIds.clear();
+		nextCapturedObjectId = 1U;
+		isCapturing.store(true);
+	}
+	EXPORT(RenderCommandCapture_BeginCapture, INTEROP_STRING captureFilePath) {
+		if (captureFilePath == nullptr) throw LosgapException { "Capture file path must not be null." };
+		auto stringPtr = LosgapString::AsNewCString(captureFilePath);
+		RenderCommandCapture::BeginCapture(stringPtr.get());
+		EXPORT_END;
+	}
+
+	void RenderCommandCapture::EndCapture() {
+		std::lock_guard<std::mutex> lock { captureLock };
+		if (!IsCapturing()) return;
+		isCapturing.store(false);
+		if (!writeBuffer.empty()) captureFile.write(&writeBuffer.front(), writeBuffer.size());
+		writeBuffer.clear();
+		captureFile.close();
+		capturedObjectIds.clear();
+	}
+	EXPORT(RenderCommandCapture_EndCapture) {
+		RenderCommandCapture::EndCapture();
+		EXPORT_END;
+	}
+
+	void RenderCommandCapture::CaptureCommands(ID3D11DeviceContext* deviceContextPtr, const RenderCommand* commandArr, uint32_t commandArrLen) {
+		uint32_t numCommands = 0U;
+		for (uint32_t i = 0U; i < commandArrLen; ++i) {
+			if (commandArr[i].Instruction != RenderCommandInstruction::NoOperation) ++numCommands;
+		}
+
+		std::lock_guard<std::mutex> lock { captureLock };
+		if (!IsCapturing()) return;
+		WriteStreamHeader(deviceContextPtr, numCommands);
+		for (uint32_t i = 0U; i < commandArrLen; ++i) {
+			if (commandArr[i].Instruction != RenderCommandInstruction::NoOperation) WriteCommand(commandArr[i]);
+		}
+		FlushBufferIfFull();
+	}
+
+	void RenderCommandCapture::CaptureCompactStream(ID3D11DeviceContext* deviceContextPtr, const uint8_t* commandStream, uint32_t commandStreamLenBytes) {
+		std::vector<RenderCommand> decodedCommands { };
+		const uint8_t* cursor = commandStream;
+		const uint8_t* streamEnd = commandStream + commandStreamLenBytes;
+		while (cursor < streamEnd) {
+			RenderCommand command = CompactCommandStream::Decode(cursor, streamEnd);
+			if (command.Instruction != RenderCommandInstruction::NoOperation) decodedCommands.push_back(command);
+		}
+		CaptureCommands(deviceContextPtr, decodedCommands.empty() ? nullptr : &decodedCommands.front(), static_cast<uint32_t>(decodedCommands.size()));
+	}
+
+	void RenderCommandCapture::CaptureExecute(ID3D11DeviceContext* immedContextPtr, ID3D11CommandList* commandListPtr) {
+		std::lock_guard<std::mutex> lock { captureLock };
+		if (!IsCapturing()) return;
+		WriteUInt8(CaptureRecordExecute);
+		WriteUInt64(GetObjectId(immedContextPtr));
+		WriteUInt64(GetObjectId(commandListPtr));
+	}
+
+	void RenderCommandCapture::CaptureParallelFlush(ID3D11DeviceContext* immedContextPtr, ID3D11DeviceContext* const* deferredContextPtrArr,
+		const uint8_t* const* commandStreamArr, const uint32_t* commandStreamLenArr, uint32_t numStreams) {
+		for (uint32_t i = 0U; i < numStreams; ++i) {
+			CaptureCompactStream(deferredContextPtrArr[i], commandStreamArr[i], commandStreamLenArr[i]);
+		}
+
+		std::lock_guard<std::mutex> lock { captureLock };
+		if (!IsCapturing()) return;
+		// The lists themselves were released inside the flush, so they're identified by id alone
+		uint64_t firstCommandListId = nextCapturedObjectId;
+		nextCapturedObjectId += numStreams;
+		for (uint32_t i = 0U; i < numStreams; ++i) {
+			WriteStreamHeader(deferredContextPtrArr[i], 1U);
+			WriteUInt8(static_cast<uint8_t>(RenderCommandInstruction::FinishCommandList));
+			WriteUInt64(firstCommandListId + i);
+			WriteUInt64(0U);
+			WriteUInt64(0U);
+		}
+		for (uint32_t i = 0U; i < numStreams; ++i) {
+			WriteUInt8(CaptureRecordExecute);
+			WriteUInt64(GetObjectId(immedContextPtr));
+			WriteUInt64(firstCommandListId + i);
+		}
+		FlushBufferIfFull();
+	}
+}
@@ -0,0 +1,79 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderCommand.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "PortableD3D11.h"
+
+namespace losgap {
+	const uint32_t RENDER_CAPTURE_MAGIC = 0x43524C4CU; // "LLRC"
+	const uint32_t RENDER_CAPTURE_VERSION = 1U;
+
+	/*
+	The record types that can appear in a render capture. These values are written to disk, so only ever append new ones.
+
+		CaptureRecordStream		u64 context id, u32 number of commands, then per command: u8 instruction, u64 Arg1, u64 Arg2, u64 Arg3, payload
+		CaptureRecordExecute	u64 immediate context id, u64 command list id
+
+	Every device object, device context and command list is written as a stable id (never a pointer); id 0 is always null. Arguments
+	that pointed at memory are written as 0 and the memory follows as the command's payload:
+
+		[VS|FS]Set[CBuffers|Samplers|Resources]		Arg2 object ids
+		SetVertexBuffers							Arg3 buffer ids, then Arg3 u32 strides
+		SetRenderTargets							Arg3 RTV ids (Arg2 is the DSV id)
+		CBDiscardWrite, BufferWrite					Arg3 bytes (Arg1 is the buffer id)
+		SetViewport									one D3D11_VIEWPORT
+		FinishCommandList							none (Arg1 is the id of the resultant command list)
+	*/
+	enum RenderCaptureRecord : uint8_t {
+		CaptureRecordStream = 1U,
+		CaptureRecordExecute,
+	};
+
+	/*
+	A static class that, while capturing, serialises every render command flushed through RenderPassManager (along with the command
+	lists executed from them) in to a capture file that RenderCommandReplay can play back without a device. Only commands that were
+	flushed successfully are captured. Capturing takes a lock per flushed stream, so parallel flushes are serialised while it is on.
+	*/
+	class RenderCommandCapture {
+	private:
+		static std::atomic<bool> isCapturing;
+		static std::mutex captureLock;
+		static std::vector<char> writeBuffer;
+
+		static void WriteBytes(const void* data, size_t numBytes);
+		static void WriteUInt8(uint8_t value) { WriteBytes(&value, sizeof(value)); }
+		static void WriteUInt32(uint32_t value) { WriteBytes(&value, sizeof(value)); }
+		static void WriteUInt64(uint64_t value) { WriteBytes(&value, sizeof(value)); }
+		static uint64_t GetObjectId(const void* objectPtr);
+		static uint64_t CreateCommandListId(const void* commandListPtr);
+		static void WriteObjectIds(const void* const* objectPtrArr, uint32_t numObjects);
+		static void WriteCommand(const RenderCommand& command);
+		static void WriteStreamHeader(ID3D11DeviceContext* deviceContextPtr, uint32_t numCommands);
+		static void FlushBufferIfFull();
+
+	public:
+		static void BeginCapture(const char* captureFilePath);
+		static void EndCapture();
+		static bool IsCapturing() { return isCapturing.load(std::memory_order_relaxed); }
+
+		/*
+		The Capture*() functions write one record each and do nothing when capture is off; callers should check IsCapturing() first
+		so that flushing costs nothing more than that when it is.
+		*/
+		static void CaptureCommands(ID3D11DeviceContext* deviceContextPtr, const RenderCommand* commandArr, uint32_t commandArrLen);
+		static void CaptureCompactStream(ID3D11DeviceContext* deviceContextPtr, const uint8_t* commandStream, uint32_t commandStreamLenBytes);
+		static void CaptureExecute(ID3D11DeviceContext* immedContextPtr, ID3D11CommandList* commandListPtr);
+		/*
+		Captures a whole RenderPassManager::FlushParallel(): each deferred stream followed by a FinishCommandList, then the execution
+		of each resultant command list on the immediate context in order.
+		*/
+		static void CaptureParallelFlush(ID3D11DeviceContext* immedContextPtr, ID3D11DeviceContext* const* deferredContextPtrArr,
+			const uint8_t* const* commandStreamArr, const uint32_t* commandStreamLenArr, uint32_t numStreams);
+	};
+}
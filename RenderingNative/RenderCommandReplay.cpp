@@ -0,0 +1,240 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "RenderCommandReplay.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+
+namespace losgap {
+	/*
+	Reads values back out of an in-memory render capture, in the same encoding that RenderCommandCapture writes them
+	*/
+	class CaptureReader {
+	private:
+		const std::vector<char>& data;
+		size_t cursor;
+
+	public:
+		CaptureReader(const std::vector<char>& data) : data(data), cursor(0U) { }
+
+		bool AtEnd() const { return cursor >= data.size(); }
+		size_t BytesRemaining() const { return data.size() - cursor; }
+
+		void ReadBytes(void* dest, size_t numBytes) {
+			if (numBytes > data.size() - cursor) throw LosgapException { "Render capture is truncated or corrupt." };
+			if (numBytes > 0U) memcpy(dest, &data[cursor], numBytes);
+			cursor += numBytes;
+		}
+
+		uint8_t ReadByte() { uint8_t result; ReadBytes(&result, sizeof(result)); return result; }
+		uint32_t ReadUInt() { uint32_t result; ReadBytes(&result, sizeof(result)); return result; }
+		uint64_t ReadUInt64() { uint64_t result; ReadBytes(&result, sizeof(result)); return result; }
+	};
+
+	RenderCommandReplay::RenderCommandReplay(const std::vector<char>& captureData)
+		: commands(), payloadWords(), commandListSlots(), records(), numContexts(0U), largestWriteBytes(0U) {
+		Parse(captureData);
+	}
+
+	RenderCommandReplay::RenderCommandReplay(const char* captureFilePath)
+		: commands(), payloadWords(), commandListSlots(), records(), numContexts(0U), largestWriteBytes(0U) {
+		if (captureFilePath == nullptr) throw LosgapException { "Capture file path must not be null." };
+		if (RenderCommandCapture::IsCapturing()) throw LosgapException { "Can not replay a render capture while one is being captured." };
+
+		std::ifstream captureFileR { captureFilePath, std::ifstream::binary | std::ifstream::ate };
+		if (!captureFileR) throw LosgapException { "Could not open render capture file for reading." };
+		std::vector<char> captureData(static_cast<size_t>(captureFileR.tellg()));
+		captureFileR.seekg(0, std::ifstream::beg);
+		if (!captureData.empty()) captureFileR.read(&captureData.front(), captureData.size());
+
+		Parse(captureData);
+	}
+
+	void RenderCommandReplay::Parse(const std::vector<char>& captureData) {
+		CaptureReader reader { captureData };
+		if (reader.ReadUInt() != RENDER_CAPTURE_MAGIC) throw LosgapException { "Given file is not a render capture." };
+		if (reader.ReadUInt() != RENDER_CAPTURE_VERSION) throw LosgapException { "Render capture was written by an incompatible version." };
+
+		std::unordered_map<uint64_t, uint32_t> contextIndices;
+		std::unordered_map<uint64_t, uint32_t> commandListSlotIndices;
+		auto getContextIndex = [&](uint64_t contextId) {
+			return contextIndices.emplace(contextId, static_cast<uint32_t>(contextIndices.size())).first->second;
+		};
+		auto getCommandListSlot = [&](uint64_t commandListId) {
+			return commandListSlotIndices.emplace(commandListId, static_cast<uint32_t>(commandListSlotIndices.size())).first->second;
+		};
+		// Payloads are stored as word offsets until everything is loaded, as payloadWords may move while it grows
+		auto readPayload = [&](size_t numBytes) {
+			if (numBytes > reader.BytesRemaining()) throw LosgapException { "Render capture is truncated or corrupt." };
+			size_t offset = payloadWords.size();
+			payloadWords.resize(offset + (numBytes + sizeof(uintptr_t) - 1U) / sizeof(uintptr_t));
+			reader.ReadBytes(payloadWords.data() + offset, numBytes);
+			return static_cast<uint64_t>(offset);
+		};
+		auto readObjectIds = [&](uint64_t numObjects) {
+			if (numObjects > D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT) throw LosgapException { "Render capture is truncated or corrupt." };
+			size_t offset = payloadWords.size();
+			for (uint64_t i = 0U; i < numObjects; ++i) payloadWords.push_back(static_cast<uintptr_t>(reader.ReadUInt64()));
+			return static_cast<uint64_t>(offset);
+		};
+
+		while (!reader.AtEnd()) {
+			RenderCaptureRecord recordType = static_cast<RenderCaptureRecord>(reader.ReadByte());
+			switch (recordType) {
+				case CaptureRecordStream: {
+					uint32_t contextIndex = getContextIndex(reader.ReadUInt64());
+					uint32_t numCommands = reader.ReadUInt();
+					ReplayRecord record = { CaptureRecordStream, contextIndex, static_cast<uint32_t>(commands.size()), numCommands };
+					for (uint32_t i = 0U; i < record.NumCommands; ++i) {
+						RenderCommand command;
+						command.Instruction = static_cast<RenderCommandInstruction>(reader.ReadByte());
+						command.Arg1 = reader.ReadUInt64();
+						command.Arg2 = reader.ReadUInt64();
+						command.Arg3 = reader.ReadUInt64();
+						switch (command.Instruction) {
+							case RenderCommandInstruction::VSSetCBuffers:
+							case RenderCommandInstruction::FSSetCBuffers:
+							case RenderCommandInstruction::VSSetSamplers:
+							case RenderCommandInstruction::FSSetSamplers:
+							case RenderCommandInstruction::VSSetResources:
+							case RenderCommandInstruction::FSSetResources:
+								command.Arg1 = readObjectIds(command.Arg2);
+								break;
+							case RenderCommandInstruction::SetVertexBuffers:
+								command.Arg1 = readObjectIds(command.Arg3);
+								command.Arg2 = readPayload(static_cast<size_t>(command.Arg3) * sizeof(uint32_t));
+								break;
+							case RenderCommandInstruction::SetRenderTargets:
+								command.Arg1 = readObjectIds(command.Arg3);
+								break;
+							case RenderCommandInstruction::CBDiscardWrite:
+							case RenderCommandInstruction::BufferWrite:
+								if (command.Arg3 > reader.BytesRemaining()) throw LosgapException { "Render capture is truncated or corrupt." };
+								command.Arg2 = readPayload(static_cast<size_t>(command.Arg3));
+								if (command.Arg3 > largestWriteBytes) largestWriteBytes = static_cast<uint32_t>(command.Arg3);
+								break;
+							case RenderCommandInstruction::SetViewport:
+								command.Arg1 = readPayload(sizeof(D3D11_VIEWPORT));
+								break;
+							case RenderCommandInstruction::FinishCommandList:
+								command.Arg1 = getCommandListSlot(command.Arg1);
+								break;
+							default:
+								if (command.Instruction >= NUM_RENDER_COMMAND_INSTRUCTIONS) {
+									throw LosgapException { "Unknown render instruction in capture: " + std::to_string(command.Instruction) };
+								}
+								break;
+						}
+						commands.push_back(command);
+					}
+					records.push_back(record);
+					break;
+				}
+				case CaptureRecordExecute: {
+					uint32_t contextIndex = getContextIndex(reader.ReadUInt64());
+					uint32_t commandListSlot = getCommandListSlot(reader.ReadUInt64());
+					ReplayRecord record = { CaptureRecordExecute, contextIndex, commandListSlot, 0U };
+					records.push_back(record);
+					break;
+				}
+				default:
+					throw LosgapException { "Unknown record type in render capture: " + std::to_string(recordType) };
+			}
+		}
+
+		numContexts = static_cast<uint32_t>(contextIndices.size());
+		commandListSlots.resize(commandListSlotIndices.size(), nullptr);
+		FixUpPayloadPointers();
+	}
+
+	void RenderCommandReplay::FixUpPayloadPointers() {
+		uintptr_t payloadBase = reinterpret_cast<uintptr_t>(payloadWords.data());
+		uintptr_t commandListSlotBase = reinterpret_cast<uintptr_t>(commandListSlots.data());
+		for (RenderCommand& command : commands) {
+			switch (command.Instruction) {
+				case RenderCommandInstruction::VSSetCBuffers:
+				case RenderCommandInstruction::FSSetCBuffers:
+				case RenderCommandInstruction::VSSetSamplers:
+				case RenderCommandInstruction::FSSetSamplers:
+				case RenderCommandInstruction::VSSetResources:
+				case RenderCommandInstruction::FSSetResources:
+				case RenderCommandInstruction::SetRenderTargets:
+				case RenderCommandInstruction::SetViewport:
+					command.Arg1 = payloadBase + command.Arg1 * sizeof(uintptr_t);
+					break;
+				case RenderCommandInstruction::SetVertexBuffers:
+					command.Arg1 = payloadBase + command.Arg1 * sizeof(uintptr_t);
+					command.Arg2 = payloadBase + command.Arg2 * sizeof(uintptr_t);
+					break;
+				case RenderCommandInstruction::CBDiscardWrite:
+				case RenderCommandInstruction::BufferWrite:
+					command.Arg2 = payloadBase + command.Arg2 * sizeof(uintptr_t);
+					break;
+				case RenderCommandInstruction::FinishCommandList:
+					command.Arg1 = commandListSlotBase + command.Arg1 * sizeof(ID3D11CommandList*);
+					break;
+				case RenderCommandInstruction::NoOperation:
+				case RenderCommandInstruction::SetPrimitiveTopology:
+				case RenderCommandInstruction::SetInputLayout:
+				case RenderCommandInstruction::SetInstanceBuffer:
+				case RenderCommandInstruction::SetIndexBuffer:
+				case RenderCommandInstruction::VSSetShader:
+				case RenderCommandInstruction::SetRSState:
+				case RenderCommandInstruction::SetDSState:
+				case RenderCommandInstruction::SetBlendState:
+				case RenderCommandInstruction::FSSetShader:
+				case RenderCommandInstruction::DrawIndexedInstanced:
+				case RenderCommandInstruction::Draw:
+				case RenderCommandInstruction::ClearRenderTarget:
+				case RenderCommandInstruction::ClearDepthStencil:
+				case RenderCommandInstruction::SwapChainPresent:
+					break; // Nothing in to the payload or command list slots
+				default:
+					throw LosgapException { "Unknown render instruction in capture: " + std::to_string(command.Instruction) };
+			}
+		}
+	}
+
+	RenderCaptureReplayResult RenderCommandReplay::ReplayOnCountingContexts(const char* captureFilePath, uint32_t numRepetitions) {
+		RenderCommandReplay replay { captureFilePath };
+		std::vector<std::unique_ptr<CountingDeviceContext>> contexts { };
+		std::vector<CountingDeviceContext*> contextPtrs { };
+		for (uint32_t i = 0U; i < replay.GetNumContexts(); ++i) {
+			contexts.emplace_back(new CountingDeviceContext(replay.GetLargestWriteBytes()));
+			contextPtrs.push_back(contexts.back().get());
+		}
+
+		RenderCaptureReplayResult result;
+		memset(&result, 0, sizeof(result));
+		result.NumContexts = replay.GetNumContexts();
+		result.NumCommands = replay.GetNumCommands() * numRepetitions;
+
+		// Deliberately not QueryPerformanceCounter, so that replays can be timed off Windows too
+		auto startTime = std::chrono::steady_clock::now();
+		for (uint32_t i = 0U; i < numRepetitions; ++i) {
+			result.NumSkippedCommands += replay.Run(contextPtrs.data(), static_cast<uint32_t>(contextPtrs.size()));
+		}
+		result.ReplayNanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+
+		for (CountingDeviceContext* contextPtr : contextPtrs) {
+			const DeviceContextCallCounts& counts = contextPtr->Counts;
+			result.Counts.NumCalls += counts.NumCalls;
+			result.Counts.NumDrawCalls += counts.NumDrawCalls;
+			result.Counts.NumInstancesDrawn += counts.NumInstancesDrawn;
+			result.Counts.NumMaps += counts.NumMaps;
+			result.Counts.NumCommandListsFinished += counts.NumCommandListsFinished;
+			result.Counts.NumCommandListsExecuted += counts.NumCommandListsExecuted;
+			result.Counts.NumPresents += counts.NumPresents;
+		}
+		return result;
+	}
+	EXPORT(RenderCommandReplay_ReplayOnCountingContexts, INTEROP_STRING captureFilePath, uint32_t numRepetitions, RenderCaptureReplayResult* outResult) {
+		if (captureFilePath == nullptr) throw LosgapException { "Capture file path must not be null." };
+		auto stringPtr = LosgapString::AsNewCString(captureFilePath);
+		*outResult = RenderCommandReplay::ReplayOnCountingContexts(stringPtr.get(), numRepetitions);
+		EXPORT_END;
+	}
+}
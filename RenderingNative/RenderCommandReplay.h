@@ -0,0 +1,99 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderCommandCapture.h"
+#include "RenderCommandTranslator.h"
+#include "CountingDeviceContext.h"
+#include <vector>
+
+namespace losgap {
+#pragma pack(push, STRUCT_PACKING_SAFE)
+	/*
+	An interop struct detailing the outcome of replaying a render capture on CountingDeviceContexts
+	*/
+	struct RenderCaptureReplayResult {
+		uint32_t NumContexts;
+		uint64_t NumCommands;
+		uint64_t NumSkippedCommands;
+		uint64_t ReplayNanoseconds;
+		DeviceContextCallCounts Counts;
+	};
+#pragma pack(pop)
+
+	/*
+	A render capture (written by RenderCommandCapture) loaded back in to memory, ready to be replayed through RenderCommandTranslator
+	on to any TContext that RenderCommandTranslator supports. Everything the captured commands pointed at is restored in to memory owned
+	by this object; device objects are handed to the context as their capture ids (cast to pointers), so the context must not
+	dereference them (see CountingDeviceContext). Captured contexts are numbered in the order they first appear in the capture.
+	*/
+	class RenderCommandReplay {
+	private:
+		struct ReplayRecord {
+			RenderCaptureRecord Type;
+			uint32_t ContextIndex;
+			uint32_t FirstCommandOrCommandListSlot;
+			uint32_t NumCommands;
+		};
+
+		std::vector<RenderCommand> commands;
+		std::vector<uintptr_t> payloadWords;
+		std::vector<ID3D11CommandList*> commandListSlots;
+		std::vector<ReplayRecord> records;
+		uint32_t numContexts;
+		uint32_t largestWriteBytes;
+
+		void Parse(const std::vector<char>& captureData);
+		void FixUpPayloadPointers();
+
+	public:
+		explicit RenderCommandReplay(const std::vector<char>& captureData);
+		explicit RenderCommandReplay(const char* captureFilePath);
+		DISALLOW_COPY_ASSIGN_MOVE(RenderCommandReplay);
+
+		uint32_t GetNumContexts() const { return numContexts; }
+		uint64_t GetNumCommands() const { return commands.size(); }
+		uint32_t GetLargestWriteBytes() const { return largestWriteBytes; }
+
+		/*
+		Replays the whole capture, translating each captured context's commands on to contextArr[contextIndex] (filtered through that
+		context's state cache, as a live flush would be), and returns the number of commands skipped as redundant. May be called
+		repeatedly, e.g. to benchmark the translator.
+		*/
+		template <typename TContext>
+		uint64_t Run(TContext* const* contextArr, uint32_t contextArrLen) {
+			if (contextArr == nullptr) throw LosgapException { "Context array must not be null." };
+			if (contextArrLen < numContexts) {
+				throw LosgapException { "Render capture uses " + std::to_string(numContexts) + " contexts, but only "
+					+ std::to_string(contextArrLen) + " were supplied." };
+			}
+
+			uint64_t numSkipped = 0U;
+			for (const ReplayRecord& record : records) {
+				TContext* deviceContextPtr = contextArr[record.ContextIndex];
+				if (record.Type == CaptureRecordExecute) {
+					deviceContextPtr->ExecuteCommandList(commandListSlots[record.FirstCommandOrCommandListSlot], FALSE);
+					GetStateCache(deviceContextPtr)->Invalidate();
+					continue;
+				}
+
+				RenderStateCache* stateCache = GetStateCache(deviceContextPtr);
+				FlushProfile* profile = FlushProfiler::IsEnabled() ? GetFlushProfile(deviceContextPtr) : nullptr;
+				if (profile != nullptr) ++profile->NumFlushes;
+				const RenderCommand* streamCommands = commands.data() + record.FirstCommandOrCommandListSlot;
+				for (uint32_t i = 0U; i < record.NumCommands; ++i) {
+					if (RenderCommandTranslator<TContext>::TranslateCommand(deviceContextPtr, stateCache, profile, streamCommands[i])) ++numSkipped;
+				}
+			}
+			return numSkipped;
+		}
+
+		/*
+		Loads the given capture and replays it numRepetitions times on fresh CountingDeviceContexts (one per captured context, kept for
+		every repetition), timing only the replays themselves.
+		*/
+		static RenderCaptureReplayResult ReplayOnCountingContexts(const char* captureFilePath, uint32_t numRepetitions);
+	};
+}
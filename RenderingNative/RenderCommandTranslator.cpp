@@ -0,0 +1,12 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "RenderCommandTranslator.h"
+
+namespace losgap {
+	const MetricID METRIC_COMMANDS_FLUSHED = Metrics::Register("Rendering.CommandsFlushed", MetricCounter);
+	const MetricID METRIC_DRAW_CALLS = Metrics::Register("Rendering.DrawCalls", MetricCounter);
+	const MetricID METRIC_INSTANCES_DRAWN = Metrics::Register("Rendering.InstancesDrawn", MetricCounter);
+	const MetricID METRIC_STATE_CHANGES_SKIPPED = Metrics::Register("Rendering.StateChangesSkipped", MetricCounter);
+}
@@ -0,0 +1,478 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "../CoreNative/JobSystem.h"
+#include "../CoreNative/FrameArena.h"
+#include "../CoreNative/Platform.h"
+#include "CompactCommandStream.h"
+#include "RenderStateCache.h"
+#include "FlushProfiler.h"
+#include "PortableD3D11.h"
+#include <cstring>
+
+namespace losgap {
+	/*
+	Reinterprets the low bytes of a command argument as the given (no wider) type. Copies rather than dereferencing a cast pointer, which
+	would break strict aliasing; the copy compiles down to a plain register move.
+	*/
+	template <typename T>
+	inline T ArgAs(uint64_t arg) {
+		static_assert(sizeof(T) <= sizeof(uint64_t), "Render command arguments are only 64 bits wide.");
+		T result;
+		memcpy(&result, &arg, sizeof(T));
+		return result;
+	}
+
+	// Defined (and so registered) once, in RenderCommandTranslator.cpp
+	extern const MetricID METRIC_COMMANDS_FLUSHED;
+	extern const MetricID METRIC_DRAW_CALLS;
+	extern const MetricID METRIC_INSTANCES_DRAWN;
+	extern const MetricID METRIC_STATE_CHANGES_SKIPPED;
+
+	inline RenderStateCache* GetStateCache(ID3D11DeviceContext* deviceContextPtr) {
+		return RenderStateCache::GetContextCache(deviceContextPtr);
+	}
+
+	inline FlushProfile* GetFlushProfile(ID3D11DeviceContext* deviceContextPtr) {
+		return FlushProfiler::GetContextProfile(deviceContextPtr);
+	}
+
+	// Defined alongside RenderPassManager::PresentBackBuffer(), so that the translator itself builds without the rest of the renderer
+	void PresentSwapChain(ID3D11DeviceContext* deviceContextPtr, IDXGISwapChain* swapChainPtr);
+
+	/*
+	Translates RenderCommands in to calls on a device context. TContext is ID3D11DeviceContext everywhere except the tests, which
+	substitute a stand-in (see RecordingDeviceContext) that logs each call instead; it needs the same member functions, plus
+	GetStateCache(), GetFlushProfile() and PresentSwapChain() overloads.
+	*/
+	template <typename TContext>
+	class RenderCommandTranslator {
+	private:
+		static const uint32_t VERTEX_BUFFER_OFFSETS[D3D11_VS_INPUT_REGISTER_COUNT];
+		static const FLOAT BACK_BUFFER_CLEAR_COLOR[4];
+
+#pragma region Instructions: Set Pipeline State
+		static void Instr_SetPrimitiveTopology(TContext* deviceContextPtr, D3D11_PRIMITIVE_TOPOLOGY topology) {
+			deviceContextPtr->IASetPrimitiveTopology(topology);
+		}
+
+		static void Instr_SetInputLayout(TContext* deviceContextPtr, ID3D11InputLayout* layout) {
+			deviceContextPtr->IASetInputLayout(layout);
+		}
+
+		static void Instr_SetShader(RenderCommandInstruction instruction, TContext* deviceContextPtr, uint64_t shaderPtr) {
+			switch (instruction) {
+				case FSSetShader:
+					deviceContextPtr->PSSetShader(ArgAs<ID3D11PixelShader*>(shaderPtr), nullptr, 0U);
+					break;
+				case VSSetShader:
+					deviceContextPtr->VSSetShader(ArgAs<ID3D11VertexShader*>(shaderPtr), nullptr, 0U);
+					break;
+				default:
+					throw LosgapException { "Not a set shader instruction: " + std::to_string(instruction) };
+			}
+		}
+
+		static void Instr_SetRSState(TContext* deviceContextPtr, ID3D11RasterizerState* rs) {
+			deviceContextPtr->RSSetState(rs);
+		}
+
+		static void Instr_SetDSState(TContext* deviceContextPtr, ID3D11DepthStencilState* ds) {
+			deviceContextPtr->OMSetDepthStencilState(ds, 0xFF);
+		}
+
+		static void Instr_SetBlendState(TContext* deviceContextPtr, ID3D11BlendState* bs) {
+			deviceContextPtr->OMSetBlendState(bs, nullptr, 0xFFFFFFFF);
+		}
+
+		static void Instr_SetViewport(TContext* deviceContextPtr, D3D11_VIEWPORT* vp) {
+			deviceContextPtr->RSSetViewports(1U, vp);
+
+			D3D11_RECT scissorRect;
+			scissorRect.left = 0U;
+			scissorRect.right = static_cast<LONG>(vp->Width);
+			scissorRect.top = 0U;
+			scissorRect.bottom = static_cast<LONG>(vp->Height);
+
+			deviceContextPtr->RSSetScissorRects(1U, &scissorRect);
+		}
+
+		static void Instr_SetRenderTargets(TContext* deviceContextPtr, ID3D11RenderTargetView** rtvPtrArr, ID3D11DepthStencilView* dsvPtr, uint32_t numRTVs) {
+			deviceContextPtr->OMSetRenderTargets(numRTVs, rtvPtrArr, dsvPtr);
+		}
+#pragma endregion
+#pragma region Instructions: Set Resources
+		static void Instr_SetVertexBuffers(TContext* deviceContextPtr, ID3D11Buffer** vBufferArr, uint32_t* strideArr, uint32_t numBuffers) {
+			deviceContextPtr->IASetVertexBuffers(
+				0U,
+				numBuffers,
+				vBufferArr,
+				strideArr,
+				VERTEX_BUFFER_OFFSETS
+				);
+		}
+
+		static void Instr_SetIndexBuffer(TContext* deviceContextPtr, ID3D11Buffer* indexBufferPtr) {
+			deviceContextPtr->IASetIndexBuffer(indexBufferPtr, INDEX_BUFFER_FORMAT, 0U);
+		}
+
+		static void Instr_SetInstanceBuffer(TContext* deviceContextPtr, ID3D11Buffer* instanceBufferPtr,
+			uint32_t slotIndex) {
+			uint32_t stride = 64U; // Vector4 size (4x4 float == 4x4x4 == 64)
+			uint32_t offset = 0U;
+			deviceContextPtr->IASetVertexBuffers(
+				slotIndex,
+				1U,
+				&instanceBufferPtr,
+				&stride,
+				&offset
+				);
+		}
+
+		static void Instr_SetCBuffers(RenderCommandInstruction instruction, TContext* deviceContextPtr,
+			ID3D11Buffer** cBufferArr, uint32_t numBuffers, uint32_t startSlot) {
+			switch (instruction) {
+				case FSSetCBuffers:
+					deviceContextPtr->PSSetConstantBuffers(startSlot, numBuffers, cBufferArr);
+					break;
+				case VSSetCBuffers:
+					deviceContextPtr->VSSetConstantBuffers(startSlot, numBuffers, cBufferArr);
+					break;
+				default:
+					throw LosgapException { "Not a set constant buffers instruction: " + std::to_string(instruction) };
+			}
+		}
+
+		static void Instr_SetSamplers(RenderCommandInstruction instruction, TContext* deviceContextPtr,
+			ID3D11SamplerState** samplerArr, uint32_t numSamplers, uint32_t startSlot) {
+			switch (instruction) {
+				case FSSetSamplers:
+					deviceContextPtr->PSSetSamplers(startSlot, numSamplers, samplerArr);
+					break;
+				case VSSetSamplers:
+					deviceContextPtr->VSSetSamplers(startSlot, numSamplers, samplerArr);
+					break;
+				default:
+					throw LosgapException { "Not a set samplers instruction: " + std::to_string(instruction) };
+			}
+		}
+
+		static void Instr_SetResources(RenderCommandInstruction instruction, TContext* deviceContextPtr,
+			ID3D11ShaderResourceView** srvArr, uint32_t numViews, uint32_t startSlot) {
+			switch (instruction) {
+				case FSSetResources:
+					deviceContextPtr->PSSetShaderResources(startSlot, numViews, srvArr);
+					break;
+				case VSSetResources:
+					deviceContextPtr->VSSetShaderResources(startSlot, numViews, srvArr);
+					break;
+				default:
+					throw LosgapException { "Not a set resources instruction: " + std::to_string(instruction) };
+			}
+		}
+
+		static void Instr_CBDiscardWrite(TContext* deviceContextPtr,
+			ID3D11Buffer* cBufferPtr, void* dataPtr, uint32_t numBytes) {
+			D3D11_MAPPED_SUBRESOURCE outMappedSubresource;
+			CHECK_CALL(deviceContextPtr->Map(cBufferPtr, 0U, D3D11_MAP::D3D11_MAP_WRITE_DISCARD, 0U, &outMappedSubresource));
+			memcpy(outMappedSubresource.pData, dataPtr, numBytes);
+			deviceContextPtr->Unmap(cBufferPtr, 0U);
+		}
+
+		static void Instr_BufferWrite(TContext* deviceContextPtr,
+			ID3D11Buffer* bufferPtr, void* dataPtr, uint32_t numBytes) {
+			D3D11_MAPPED_SUBRESOURCE outMappedSubresource;
+			CHECK_CALL(deviceContextPtr->Map(bufferPtr, 0U, D3D11_MAP::D3D11_MAP_WRITE_DISCARD, 0U, &outMappedSubresource));
+			memcpy(outMappedSubresource.pData, dataPtr, numBytes);
+			deviceContextPtr->Unmap(bufferPtr, 0U);
+		}
+#pragma endregion
+#pragma region Instructions: Dispatch
+		static void Instr_DrawIndexedInstanced(TContext* deviceContextPtr,
+			int32_t firstVertexIndex, uint32_t firstIndexIndex, uint32_t numIndices, uint32_t firstInstanceIndex, uint32_t numInstances) {
+			deviceContextPtr->DrawIndexedInstanced(numIndices, numInstances, firstIndexIndex, firstVertexIndex, firstInstanceIndex);
+			Metrics::Increment(METRIC_DRAW_CALLS);
+			Metrics::Increment(METRIC_INSTANCES_DRAWN, numInstances);
+		}
+
+		static void Instr_Draw(TContext* deviceContextPtr, int32_t firstVertexIndex, uint32_t numVertices) {
+			deviceContextPtr->Draw(numVertices, firstVertexIndex);
+			Metrics::Increment(METRIC_DRAW_CALLS);
+		}
+
+		static void Instr_ClearRenderTarget(TContext* deviceContextPtr, ID3D11RenderTargetView* rtv) {
+			deviceContextPtr->ClearRenderTargetView(rtv, BACK_BUFFER_CLEAR_COLOR);
+		}
+
+		static void Instr_ClearDepthStencil(TContext* deviceContextPtr, ID3D11DepthStencilView* dsv) {
+			deviceContextPtr->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0xFF);
+		}
+
+		static void Instr_SwapChainPresent(TContext* deviceContextPtr, IDXGISwapChain* swapChainPtr) {
+			PresentSwapChain(deviceContextPtr, swapChainPtr);
+		}
+
+		static void Instr_FinishCommandList(TContext* deferredContextPtr, ID3D11CommandList** outCommandListPtr) {
+			deferredContextPtr->FinishCommandList(FALSE, outCommandListPtr);
+		}
+#pragma endregion
+
+	public:
+#pragma region Instruction Switch
+		static void SwitchOverCommand(TContext* deviceContextPtr, RenderCommand command) {
+			switch (command.Instruction) { // Ordered roughly by frequency
+				case RenderCommandInstruction::DrawIndexedInstanced: {
+					Instr_DrawIndexedInstanced(
+						deviceContextPtr,
+						ArgAs<int32_t>(command.Arg1),
+						static_cast<uint32_t>(command.Arg2),
+						static_cast<uint32_t>(command.Arg2 >> 32),
+						static_cast<uint32_t>(command.Arg3),
+						static_cast<uint32_t>(command.Arg3 >> 32)
+						);
+					break;
+				}
+				case RenderCommandInstruction::Draw: {
+					Instr_Draw(
+						deviceContextPtr,
+						ArgAs<int32_t>(command.Arg1),
+						ArgAs<int32_t>(command.Arg2)
+					);
+					break;
+				}
+				case RenderCommandInstruction::VSSetCBuffers:
+				case RenderCommandInstruction::FSSetCBuffers: {
+					Instr_SetCBuffers(
+						command.Instruction,
+						deviceContextPtr,
+						ArgAs<ID3D11Buffer**>(command.Arg1),
+						ArgAs<uint32_t>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::VSSetResources:
+				case RenderCommandInstruction::FSSetResources: {
+					Instr_SetResources(
+						command.Instruction,
+						deviceContextPtr,
+						ArgAs<ID3D11ShaderResourceView**>(command.Arg1),
+						ArgAs<uint32_t>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::CBDiscardWrite: {
+					Instr_CBDiscardWrite(
+						deviceContextPtr,
+						ArgAs<ID3D11Buffer*>(command.Arg1),
+						ArgAs<void*>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::BufferWrite: {
+					Instr_BufferWrite(
+						deviceContextPtr,
+						ArgAs<ID3D11Buffer*>(command.Arg1),
+						ArgAs<void*>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::VSSetSamplers:
+				case RenderCommandInstruction::FSSetSamplers: {
+					Instr_SetSamplers(
+						command.Instruction,
+						deviceContextPtr,
+						ArgAs<ID3D11SamplerState**>(command.Arg1),
+						ArgAs<uint32_t>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::VSSetShader:
+				case RenderCommandInstruction::FSSetShader: {
+					Instr_SetShader(
+						command.Instruction,
+						deviceContextPtr,
+						command.Arg1
+						);
+					break;
+				}
+				case RenderCommandInstruction::SetVertexBuffers: {
+					Instr_SetVertexBuffers(
+						deviceContextPtr,
+						ArgAs<ID3D11Buffer**>(command.Arg1),
+						ArgAs<uint32_t*>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::SetIndexBuffer: {
+					Instr_SetIndexBuffer(deviceContextPtr, ArgAs<ID3D11Buffer*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetInstanceBuffer: {
+					Instr_SetInstanceBuffer(deviceContextPtr, ArgAs<ID3D11Buffer*>(command.Arg1), ArgAs<uint32_t>(command.Arg2));
+					break;
+				}
+				case RenderCommandInstruction::SetInputLayout: {
+					Instr_SetInputLayout(deviceContextPtr, ArgAs<ID3D11InputLayout*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetRSState: {
+					Instr_SetRSState(deviceContextPtr, ArgAs<ID3D11RasterizerState*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetDSState: {
+					Instr_SetDSState(deviceContextPtr, ArgAs<ID3D11DepthStencilState*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetBlendState: {
+					Instr_SetBlendState(deviceContextPtr, ArgAs<ID3D11BlendState*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetViewport: {
+					Instr_SetViewport(deviceContextPtr, ArgAs<D3D11_VIEWPORT*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetRenderTargets: {
+					Instr_SetRenderTargets(
+						deviceContextPtr,
+						ArgAs<ID3D11RenderTargetView**>(command.Arg1),
+						ArgAs<ID3D11DepthStencilView*>(command.Arg2),
+						ArgAs<uint32_t>(command.Arg3)
+						);
+					break;
+				}
+				case RenderCommandInstruction::ClearRenderTarget: {
+					Instr_ClearRenderTarget(deviceContextPtr, ArgAs<ID3D11RenderTargetView*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::ClearDepthStencil: {
+					Instr_ClearDepthStencil(deviceContextPtr, ArgAs<ID3D11DepthStencilView*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SwapChainPresent: {
+					Instr_SwapChainPresent(deviceContextPtr, ArgAs<IDXGISwapChain*>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::FinishCommandList: {
+					Instr_FinishCommandList(deviceContextPtr, ArgAs<ID3D11CommandList**>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::SetPrimitiveTopology: {
+					Instr_SetPrimitiveTopology(deviceContextPtr, ArgAs<D3D11_PRIMITIVE_TOPOLOGY>(command.Arg1));
+					break;
+				}
+				case RenderCommandInstruction::NoOperation: {
+					break;
+				}
+				default: {
+					throw LosgapException { "Unknown render instruction: " + std::to_string(command.Instruction) };
+				}
+			}
+		}
+#pragma endregion
+
+		/*
+		Translates the given command unless the state cache says it is redundant, and returns true if it was skipped. If profile is
+		not null, the command is also counted (and if translated, timed) in it.
+		*/
+		static bool TranslateCommand(TContext* deviceContextPtr, RenderStateCache* stateCache, FlushProfile* profile, const RenderCommand& command) {
+			if (stateCache->IsRedundant(command)) {
+				if (profile != nullptr) ++profile->SkippedCounts[command.Instruction];
+				return true;
+			}
+			if (profile == nullptr) {
+				SwitchOverCommand(deviceContextPtr, command);
+				return false;
+			}
+
+			int64_t startTicks = Platform::GetTicks();
+			SwitchOverCommand(deviceContextPtr, command); // Throws on unknown instructions, so the index below is always in range
+			profile->InstructionTicks[command.Instruction] += Platform::GetTicks() - startTicks;
+			++profile->InstructionCounts[command.Instruction];
+			if (command.Instruction == RenderCommandInstruction::CBDiscardWrite) profile->CBufferBytesWritten += static_cast<uint32_t>(command.Arg3);
+			else if (command.Instruction == RenderCommandInstruction::BufferWrite) profile->BufferBytesWritten += static_cast<uint32_t>(command.Arg3);
+			return false;
+		}
+
+		/*
+		Decodes and translates a whole compact command stream, skipping anything the context's state cache says is redundant.
+		*/
+		static void FlushCompactStream(TContext* deviceContextPtr, const uint8_t* commandStream, uint32_t commandStreamLenBytes) {
+			RenderStateCache* stateCache = GetStateCache(deviceContextPtr);
+			FlushProfile* profile = FlushProfiler::IsEnabled() ? GetFlushProfile(deviceContextPtr) : nullptr;
+			if (profile != nullptr) ++profile->NumFlushes;
+			const uint8_t* cursor = commandStream;
+			const uint8_t* streamEnd = commandStream + commandStreamLenBytes;
+			uint32_t numCommands = 0U;
+			uint32_t numSkipped = 0U;
+			try {
+				while (cursor < streamEnd) {
+					RenderCommand command = CompactCommandStream::Decode(cursor, streamEnd);
+					++numCommands;
+					if (TranslateCommand(deviceContextPtr, stateCache, profile, command)) ++numSkipped;
+				}
+			}
+			catch (...) {
+				// The cache already holds the failed command's state, which may or may not have made it to the context
+				stateCache->Invalidate();
+				throw;
+			}
+			Metrics::Increment(METRIC_COMMANDS_FLUSHED, numCommands);
+			Metrics::Increment(METRIC_STATE_CHANGES_SKIPPED, numSkipped);
+		}
+
+		/*
+		Records commandStreamArr[i] on deferredContextPtrArr[i] for every i, as parallel jobs, and finishes a command list on each; then
+		executes those command lists on the immediate context in array order. The streams must not contain FinishCommandList themselves.
+		If any stream fails, every recorded command list is released and nothing is executed.
+		*/
+		template <typename TCommandList>
+		static void FlushParallel(TContext* immedContextPtr, TContext* const* deferredContextPtrArr,
+			const uint8_t* const* commandStreamArr, const uint32_t* commandStreamLenArr, uint32_t numStreams) {
+			TCommandList** commandListArr = static_cast<TCommandList**>(FrameArena::GetThreadArena()->Allocate(numStreams * sizeof(TCommandList*)));
+			for (uint32_t i = 0U; i < numStreams; ++i) commandListArr[i] = nullptr;
+
+			try {
+				JobSystem::ParallelFor(numStreams, 1U, [=](uint32_t streamIndex) {
+					TContext* deferredContextPtr = deferredContextPtrArr[streamIndex];
+					FlushCompactStream(deferredContextPtr, commandStreamArr[streamIndex], commandStreamLenArr[streamIndex]);
+					CHECK_CALL(deferredContextPtr->FinishCommandList(FALSE, &commandListArr[streamIndex]));
+					GetStateCache(deferredContextPtr)->Invalidate();
+				});
+			}
+			catch (...) {
+				for (uint32_t i = 0U; i < numStreams; ++i) {
+					if (commandListArr[i] != nullptr) {
+						commandListArr[i]->Release();
+						continue;
+					}
+					// Throw away whatever was partially recorded, so the context starts clean next time
+					TCommandList* discardedCommandList = nullptr;
+					deferredContextPtrArr[i]->FinishCommandList(FALSE, &discardedCommandList);
+					if (discardedCommandList != nullptr) discardedCommandList->Release();
+					GetStateCache(deferredContextPtrArr[i])->Invalidate();
+				}
+				throw;
+			}
+
+			for (uint32_t i = 0U; i < numStreams; ++i) {
+				immedContextPtr->ExecuteCommandList(commandListArr[i], FALSE);
+				commandListArr[i]->Release();
+			}
+			GetStateCache(immedContextPtr)->Invalidate();
+		}
+	};
+
+	template <typename TContext>
+	const uint32_t RenderCommandTranslator<TContext>::VERTEX_BUFFER_OFFSETS[D3D11_VS_INPUT_REGISTER_COUNT] = { };
+	template <typename TContext>
+	const FLOAT RenderCommandTranslator<TContext>::BACK_BUFFER_CLEAR_COLOR[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+}
@@ -14,7 +14,26 @@ namespace losgap {
 	class RenderPassManager {
 	public:
 		static void FlushInstructions(ID3D11DeviceContext* deviceContextPtr, RenderCommand* commandArr, uint32_t commandArrLen);
+		static void FlushCompactInstructions(ID3D11DeviceContext* deviceContextPtr, const uint8_t* commandStream, uint32_t commandStreamLenBytes);
+		/*
+		Decodes a compact command stream (see CompactCommandStream) in to up to outCommandArrLen legacy RenderCommands, and returns the
+		total number of commands in the stream.
+		*/
+		static uint32_t DecodeCompactInstructions(const uint8_t* commandStream, uint32_t commandStreamLenBytes,
+			RenderCommand* outCommandArr, uint32_t outCommandArrLen);
 		static void ExecuteCommandList(ID3D11DeviceContext* immedContextPtr, ID3D11CommandList* commandListPtr);
+		/*
+		Records each compact command stream on to its own deferred context in parallel (on the job system), finishes each one in to a
+		command list, and then executes those lists on the immediate context in the order given.
+		*/
+		static void FlushParallel(ID3D11DeviceContext* immedContextPtr, ID3D11DeviceContext* const* deferredContextPtrArr,
+			const uint8_t* const* commandStreamArr, const uint32_t* commandStreamLenArr, uint32_t numStreams);
 		static void PresentBackBuffer(IDXGISwapChain* swapChainPtr);
+
+		/*
+		Runs the given commands through a fresh redundant-state filter (the same one FlushInstructions() applies per context),
+		replacing every command that would not change the pipeline state with NoOperation. Returns the number replaced.
+		*/
+		static uint32_t FilterRedundantState(RenderCommand* commandArr, uint32_t commandArrLen);
 	};
 }
\ No newline at end of file
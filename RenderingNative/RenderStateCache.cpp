@@ -0,0 +1,219 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "RenderStateCache.h"
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace losgap {
+	std::mutex contextCacheLock;
+	std::unordered_map<ID3D11DeviceContext*, std::unique_ptr<RenderStateCache>> contextCaches;
+
+	uintptr_t ArgAsBinding(uint64_t arg) {
+		return static_cast<uintptr_t>(arg);
+	}
+
+	uint32_t ArgAsUInt(uint64_t arg) {
+		return static_cast<uint32_t>(arg);
+	}
+
+	template <uint32_t NUM_SLOTS>
+	void InvalidateSlots(uintptr_t (&slots)[NUM_SLOTS]) {
+		for (uint32_t s = 0U; s < NUM_SLOTS; ++s) slots[s] = RenderStateCache::UNKNOWN_BINDING;
+	}
+
+	bool RebindsValue(uintptr_t& cachedValue, uintptr_t newValue) {
+		if (cachedValue == newValue) return true;
+		cachedValue = newValue;
+		return false;
+	}
+
+	/*
+	The slot-range Set* instructions pass an array of pointers in Arg1, the number of slots in Arg2 and the first slot in Arg3.
+	*/
+	template <uint32_t NUM_SLOTS>
+	bool RebindsSlotRange(uintptr_t (&slots)[NUM_SLOTS], const RenderCommand& command) {
+		void** bindingArr = reinterpret_cast<void**>(ArgAsBinding(command.Arg1));
+		uint32_t numBindings = ArgAsUInt(command.Arg2);
+		uint32_t startSlot = ArgAsUInt(command.Arg3);
+		if (numBindings == 0U) return true;
+		if (bindingArr == nullptr || startSlot >= NUM_SLOTS || numBindings > NUM_SLOTS - startSlot) {
+			InvalidateSlots(slots);
+			return false;
+		}
+
+		bool isRedundant = true;
+		for (uint32_t b = 0U; b < numBindings; ++b) {
+			isRedundant &= RebindsValue(slots[startSlot + b], reinterpret_cast<uintptr_t>(bindingArr[b]));
+		}
+		return isRedundant;
+	}
+
+	uint32_t StageIndex(RenderCommandInstruction instruction) {
+		switch (instruction) {
+			case FSSetCBuffers:
+			case FSSetSamplers:
+			case FSSetResources:
+			case FSSetShader:
+				return 1U;
+			default:
+				return 0U;
+		}
+	}
+
+	RenderStateCache::RenderStateCache() {
+		Invalidate();
+	}
+
+	void RenderStateCache::Invalidate() {
+		primitiveTopology = UNKNOWN_BINDING;
+		inputLayout = UNKNOWN_BINDING;
+		indexBuffer = UNKNOWN_BINDING;
+		rsState = UNKNOWN_BINDING;
+		dsState = UNKNOWN_BINDING;
+		blendState = UNKNOWN_BINDING;
+		viewportIsKnown = false;
+		depthStencil = UNKNOWN_BINDING;
+		InvalidateSlots(shaders);
+		InvalidateSlots(vertexBuffers);
+		InvalidateSlots(vertexBufferStrides);
+		InvalidateSlots(renderTargets);
+		for (uint32_t stage = 0U; stage < NUM_SHADER_STAGES; ++stage) {
+			InvalidateSlots(cbuffers[stage]);
+			InvalidateSlots(samplers[stage]);
+		}
+		InvalidateResources();
+	}
+
+	void RenderStateCache::InvalidateResources() {
+		for (uint32_t stage = 0U; stage < NUM_SHADER_STAGES; ++stage) InvalidateSlots(resources[stage]);
+	}
+
+	bool RenderStateCache::RebindsRenderTargets(const RenderCommand& command) {
+		void** rtvArr = reinterpret_cast<void**>(ArgAsBinding(command.Arg1));
+		uintptr_t dsv = ArgAsBinding(command.Arg2);
+		uint32_t numRTVs = ArgAsUInt(command.Arg3);
+		if (numRTVs > NUM_RENDER_TARGET_SLOTS || (numRTVs > 0U && rtvArr == nullptr)) {
+			InvalidateSlots(renderTargets);
+			depthStencil = UNKNOWN_BINDING;
+			InvalidateResources();
+			return false;
+		}
+
+		// OMSetRenderTargets() also unbinds every slot past numRTVs
+		bool isRedundant = RebindsValue(depthStencil, dsv);
+		for (uint32_t s = 0U; s < NUM_RENDER_TARGET_SLOTS; ++s) {
+			isRedundant &= RebindsValue(renderTargets[s], s < numRTVs ? reinterpret_cast<uintptr_t>(rtvArr[s]) : 0U);
+		}
+
+		// Binding an output silently unbinds any shader resource views of the same resource, so we can no longer trust those
+		if (!isRedundant) InvalidateResources();
+		return isRedundant;
+	}
+
+	bool RenderStateCache::RebindsVertexBuffers(const RenderCommand& command) {
+		void** vBufferArr = reinterpret_cast<void**>(ArgAsBinding(command.Arg1));
+		uint32_t* strideArr = reinterpret_cast<uint32_t*>(ArgAsBinding(command.Arg2));
+		uint32_t numBuffers = ArgAsUInt(command.Arg3);
+		if (numBuffers == 0U) return true;
+		if (vBufferArr == nullptr || strideArr == nullptr || numBuffers > NUM_VERTEX_BUFFER_SLOTS) {
+			InvalidateSlots(vertexBuffers);
+			InvalidateSlots(vertexBufferStrides);
+			return false;
+		}
+
+		bool isRedundant = true;
+		for (uint32_t b = 0U; b < numBuffers; ++b) {
+			isRedundant &= RebindsValue(vertexBuffers[b], reinterpret_cast<uintptr_t>(vBufferArr[b]));
+			isRedundant &= RebindsValue(vertexBufferStrides[b], strideArr[b]);
+		}
+		return isRedundant;
+	}
+
+	bool RenderStateCache::IsRedundant(const RenderCommand& command) {
+		switch (command.Instruction) {
+			case RenderCommandInstruction::VSSetCBuffers:
+			case RenderCommandInstruction::FSSetCBuffers:
+				return RebindsSlotRange(cbuffers[StageIndex(command.Instruction)], command);
+			case RenderCommandInstruction::VSSetResources:
+			case RenderCommandInstruction::FSSetResources:
+				return RebindsSlotRange(resources[StageIndex(command.Instruction)], command);
+			case RenderCommandInstruction::VSSetSamplers:
+			case RenderCommandInstruction::FSSetSamplers:
+				return RebindsSlotRange(samplers[StageIndex(command.Instruction)], command);
+			case RenderCommandInstruction::VSSetShader:
+			case RenderCommandInstruction::FSSetShader:
+				return RebindsValue(shaders[StageIndex(command.Instruction)], ArgAsBinding(command.Arg1));
+			case RenderCommandInstruction::SetVertexBuffers:
+				return RebindsVertexBuffers(command);
+			case RenderCommandInstruction::SetInstanceBuffer: {
+				uint32_t slotIndex = ArgAsUInt(command.Arg2);
+				if (slotIndex >= NUM_VERTEX_BUFFER_SLOTS) return false;
+				bool bufferIsBound = RebindsValue(vertexBuffers[slotIndex], ArgAsBinding(command.Arg1));
+				bool strideIsSet = RebindsValue(vertexBufferStrides[slotIndex], 64U);
+				return bufferIsBound && strideIsSet;
+			}
+			case RenderCommandInstruction::SetIndexBuffer:
+				return RebindsValue(indexBuffer, ArgAsBinding(command.Arg1));
+			case RenderCommandInstruction::SetInputLayout:
+				return RebindsValue(inputLayout, ArgAsBinding(command.Arg1));
+			case RenderCommandInstruction::SetPrimitiveTopology:
+				return RebindsValue(primitiveTopology, ArgAsUInt(command.Arg1));
+			case RenderCommandInstruction::SetRSState:
+				return RebindsValue(rsState, ArgAsBinding(command.Arg1));
+			case RenderCommandInstruction::SetDSState:
+				return RebindsValue(dsState, ArgAsBinding(command.Arg1));
+			case RenderCommandInstruction::SetBlendState:
+				return RebindsValue(blendState, ArgAsBinding(command.Arg1));
+			case RenderCommandInstruction::SetViewport: {
+				const D3D11_VIEWPORT* newViewport = reinterpret_cast<const D3D11_VIEWPORT*>(ArgAsBinding(command.Arg1));
+				if (newViewport == nullptr) {
+					viewportIsKnown = false;
+					return false;
+				}
+				if (viewportIsKnown && memcmp(&viewport, newViewport, sizeof(D3D11_VIEWPORT)) == 0) return true;
+				viewport = *newViewport;
+				viewportIsKnown = true;
+				return false;
+			}
+			case RenderCommandInstruction::SetRenderTargets:
+				return RebindsRenderTargets(command);
+			case RenderCommandInstruction::FinishCommandList:
+				Invalidate();
+				return false;
+			default:
+				return false;
+		}
+	}
+
+	uint32_t RenderStateCache::FilterRedundantCommands(RenderStateCache& cache, RenderCommand* commandArr, uint32_t commandArrLen) {
+		uint32_t numFiltered = 0U;
+		for (uint32_t i = 0U; i < commandArrLen; ++i) {
+			if (!cache.IsRedundant(commandArr[i])) continue;
+			commandArr[i].Instruction = RenderCommandInstruction::NoOperation;
+			++numFiltered;
+		}
+		return numFiltered;
+	}
+
+	RenderStateCache* RenderStateCache::GetContextCache(ID3D11DeviceContext* deviceContextPtr) {
+		std::lock_guard<std::mutex> lock { contextCacheLock };
+		std::unique_ptr<RenderStateCache>& cache = contextCaches[deviceContextPtr];
+		if (cache == nullptr) cache.reset(new RenderStateCache);
+		return cache.get();
+	}
+
+	void RenderStateCache::InvalidateContextCache(ID3D11DeviceContext* deviceContextPtr) {
+		std::lock_guard<std::mutex> lock { contextCacheLock };
+		auto cacheIter = contextCaches.find(deviceContextPtr);
+		if (cacheIter != contextCaches.end()) cacheIter->second->Invalidate();
+	}
+
+	void RenderStateCache::ReleaseContextCache(ID3D11DeviceContext* deviceContextPtr) {
+		std::lock_guard<std::mutex> lock { contextCacheLock };
+		contextCaches.erase(deviceContextPtr);
+	}
+}
@@ -0,0 +1,76 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#pragma once
+#include "../CoreNative/LosgapCore.h"
+#include "RenderCommand.h"
+#include "PortableD3D11.h"
+
+namespace losgap {
+	/*
+	A shadow copy of the pipeline state bound on a single device context, used to drop Set* render commands that would only rebind
+	what is already bound. Every binding starts out (and is reset to) UNKNOWN_BINDING, which never matches a real value, so nothing is
+	filtered until the cache has seen it set.
+	A cache must only be used by whichever thread is currently recording on its context.
+	*/
+	class RenderStateCache {
+	private:
+		static const uint32_t NUM_SHADER_STAGES = 2U;
+		static const uint32_t NUM_VERTEX_BUFFER_SLOTS = D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+		static const uint32_t NUM_RENDER_TARGET_SLOTS = D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT;
+		static const uint32_t NUM_CBUFFER_SLOTS = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+		static const uint32_t NUM_SAMPLER_SLOTS = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+		static const uint32_t NUM_RESOURCE_SLOTS = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+
+		uintptr_t primitiveTopology;
+		uintptr_t inputLayout;
+		uintptr_t indexBuffer;
+		uintptr_t rsState;
+		uintptr_t dsState;
+		uintptr_t blendState;
+		bool viewportIsKnown;
+		D3D11_VIEWPORT viewport;
+		uintptr_t shaders[NUM_SHADER_STAGES];
+		uintptr_t vertexBuffers[NUM_VERTEX_BUFFER_SLOTS];
+		uintptr_t vertexBufferStrides[NUM_VERTEX_BUFFER_SLOTS];
+		uintptr_t renderTargets[NUM_RENDER_TARGET_SLOTS];
+		uintptr_t depthStencil;
+		uintptr_t cbuffers[NUM_SHADER_STAGES][NUM_CBUFFER_SLOTS];
+		uintptr_t samplers[NUM_SHADER_STAGES][NUM_SAMPLER_SLOTS];
+		uintptr_t resources[NUM_SHADER_STAGES][NUM_RESOURCE_SLOTS];
+
+		bool RebindsRenderTargets(const RenderCommand& command);
+		bool RebindsVertexBuffers(const RenderCommand& command);
+		void InvalidateResources();
+
+	public:
+		static const uintptr_t UNKNOWN_BINDING = UINTPTR_MAX;
+
+		RenderStateCache();
+
+		/*
+		Forgets everything, e.g. after FinishCommandList() or ExecuteCommandList() have reset the context's state.
+		*/
+		void Invalidate();
+
+		/*
+		Returns true if executing the given command would leave the context's state exactly as it is; otherwise updates the cache to
+		reflect the state after executing the command and returns false. Commands that do not set state always return false.
+		*/
+		bool IsRedundant(const RenderCommand& command);
+
+		/*
+		Replaces every redundant command in the given array with NoOperation and returns the number replaced.
+		*/
+		static uint32_t FilterRedundantCommands(RenderStateCache& cache, RenderCommand* commandArr, uint32_t commandArrLen);
+
+		/*
+		Returns the cache for the given context, creating it on first use. ReleaseContextCache() must be called before the context
+		itself is released (as its address may then be reused by a new context).
+		*/
+		static RenderStateCache* GetContextCache(ID3D11DeviceContext* deviceContextPtr);
+		static void InvalidateContextCache(ID3D11DeviceContext* deviceContextPtr);
+		static void ReleaseContextCache(ID3D11DeviceContext* deviceContextPtr);
+	};
+}
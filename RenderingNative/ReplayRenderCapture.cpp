@@ -0,0 +1,43 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "RenderCommandReplay.h"
+#include <cstdlib>
+#include <iostream>
+
+/*
+Command-line front end for RenderCommandReplay::ReplayOnCountingContexts(), built by the portable CMake target only:
+	ReplayRenderCapture <capture file> [repetitions]
+Prints what was replayed and how long the translator took, for comparing translator changes on the same captured frames.
+*/
+int main(int argc, char** argv) {
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage: ReplayRenderCapture <capture file> [repetitions]" << std::endl;
+		return 2;
+	}
+	uint32_t numRepetitions = argc == 3 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 1U;
+	if (numRepetitions == 0U) {
+		std::cerr << "Repetitions must be a positive integer." << std::endl;
+		return 2;
+	}
+
+	try {
+		losgap::RenderCaptureReplayResult result = losgap::RenderCommandReplay::ReplayOnCountingContexts(argv[1], numRepetitions);
+		std::cout << "Contexts: " << result.NumContexts << std::endl
+			<< "Commands: " << result.NumCommands << " (" << result.NumSkippedCommands << " skipped as redundant)" << std::endl
+			<< "Device calls: " << result.Counts.NumCalls << std::endl
+			<< "Draw calls: " << result.Counts.NumDrawCalls << " (" << result.Counts.NumInstancesDrawn << " instances)" << std::endl
+			<< "Maps: " << result.Counts.NumMaps << std::endl
+			<< "Command lists finished / executed: " << result.Counts.NumCommandListsFinished << " / "
+				<< result.Counts.NumCommandListsExecuted << std::endl
+			<< "Presents: " << result.Counts.NumPresents << std::endl
+			<< "Replay time: " << (result.ReplayNanoseconds / 1000ULL) << "us total, "
+				<< (result.ReplayNanoseconds / numRepetitions) << "ns per repetition" << std::endl;
+	}
+	catch (const losgap::LosgapException& e) {
+		std::cerr << e.Message << std::endl;
+		return 1;
+	}
+	return 0;
+}
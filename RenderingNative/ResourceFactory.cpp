@@ -9,6 +9,8 @@
 #include "WICTextureLoader.h"
 
 namespace losgap {
+	const MetricID METRIC_TEXTURE_LOAD_TIME = Metrics::Register("Rendering.TextureLoadTimeUs", MetricHistogram);
+
 #pragma region Resource View Creation
 #pragma region ::CreateRTV[ToTexArr]()
 	ID3D11RenderTargetView* ResourceFactory::CreateRTV(ID3D11Device* devicePtr, ID3D11Texture2D* resPtr, uint32_t mipIndex, DXGI_FORMAT format, bool isMS) {
@@ -987,13 +989,15 @@ namespace losgap {
 
 	ID3D11Texture2D* ResourceFactory::LoadTexture2D(ID3D11Device* devicePtr, LosgapString filePath, bool allocateMipmaps,
 		D3D11_USAGE usage, D3D11_CPU_ACCESS_FLAG cpuUsage, D3D11_BIND_FLAG pipelineBindings, bool allowMipGeneration, bool allowLODClamping) {
+		ScopedTrace trace { "ResourceFactory::LoadTexture2D" };
+		ScopedMetricTimer loadTimer { METRIC_TEXTURE_LOAD_TIME };
 		if (devicePtr == nullptr) throw LosgapException { "Device pointer was null!" };
 		if (allowLODClamping && !allocateMipmaps) {
 			throw LosgapException { "Invalid configuration: Allowing LOD clamping has no effect when not allocating for mip mapping." };
 		}
 		
 		ID3D11Resource* outResult;
-		std::unique_ptr<const wchar_t> filePathAsCWStr = LosgapString::AsNewCWString(filePath);
+		std::unique_ptr<const wchar_t[]> filePathAsCWStr = LosgapString::AsNewCWString(filePath);
 
 		CHECK_CALL(DirectX::CreateWICTextureFromFileEx(
 			devicePtr,
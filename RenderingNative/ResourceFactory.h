@@ -4,7 +4,7 @@
 
 #pragma once
 #include "../CoreNative/LosgapCore.h"
-
+#include "RenderCommand.h"
 #include <d3d11.h>
 
 namespace losgap {
@@ -13,7 +13,7 @@ namespace losgap {
 	*/
 	class ResourceFactory {
 	public:
-		static const DXGI_FORMAT INDEX_BUFFER_FORMAT = DXGI_FORMAT::DXGI_FORMAT_R32_UINT;
+		static const DXGI_FORMAT INDEX_BUFFER_FORMAT = losgap::INDEX_BUFFER_FORMAT;
 
 #pragma region Resource View Creation
 		static ID3D11RenderTargetView* CreateRTV(ID3D11Device* devicePtr, ID3D11Texture2D* resPtr, uint32_t mipIndex, DXGI_FORMAT format, bool isMS);
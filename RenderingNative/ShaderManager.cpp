@@ -11,8 +11,10 @@ namespace losgap {
 	std::mutex VS_BINARY_MAP_MUTEX { };
 	std::map<ID3D11VertexShader*, const void*> VERTEX_SHADER_BINARIES { };
 	std::map<ID3D11VertexShader*, UINT> VERTEX_SHADER_BINARY_SIZES { };
+	const MetricID METRIC_SHADER_LOAD_TIME = Metrics::Register("Rendering.ShaderLoadTimeUs", MetricHistogram);
 
 	ID3D11DeviceChild* ShaderManager::LoadShader(ID3D11Device* devicePtr, LosgapString shaderFilePath, ShaderType shaderType) {
+		ScopedMetricTimer loadTimer { METRIC_SHADER_LOAD_TIME };
 		if (devicePtr == nullptr) throw LosgapException { "Device pointer must not be null." };
 		std::ifstream shaderFileInputStream { LosgapString::AsNewCString(shaderFilePath).get(), std::ios_base::in | std::ios_base::binary };
 		if (!shaderFileInputStream.is_open() || shaderFileInputStream.bad()) {
@@ -81,7 +83,7 @@ namespace losgap {
 		if (devicePtr == nullptr) throw LosgapException { "Device pointer must not be null." };
 		if (shaderPtr == nullptr) throw LosgapException { "Shader pointer must not be null." };
 		D3D11_INPUT_ELEMENT_DESC* inputElements = new D3D11_INPUT_ELEMENT_DESC[static_cast<size_t>(inputElementDescArrLen)];
-		std::unique_ptr<const char>* convertedNameArr = new std::unique_ptr<const char>[static_cast<size_t>(inputElementDescArrLen)];
+		std::unique_ptr<const char[]>* convertedNameArr = new std::unique_ptr<const char[]>[static_cast<size_t>(inputElementDescArrLen)];
 		for (uint32_t i = 0; i < inputElementDescArrLen; ++i) {
 			inputElements[i].Format = inputElementDescArr[i].ElementFormat;
 			inputElements[i].InputSlot = inputElementDescArr[i].InputSlot;
@@ -0,0 +1,137 @@
+// All code copyright (c) 2015 Ophidian Games || http://www.ophidian-games.com
+// See http://www.losgap.com/ for licensing information
+// Created by Ben Bowen
+
+#include "../CoreNative/LosgapCore.h"
+
+#ifdef LOSGAP_TEST_EXPORTS
+#include "RenderCommandTranslator.h"
+#include "RecordingDeviceContext.h"
+#include "RenderCommandCapture.h"
+#include "FrustumCuller.h"
+#include "LODSelector.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/*
+Runs the given compact command streams through the same parallel record-and-execute path as RenderPassManager::FlushParallel(), but
+against RecordingDeviceContexts, and copies the immediate context's resultant log to outLog.
+*/
+EXPORT(RecordParallelCommandStreams, const uint8_t* const* commandStreamArr, const uint32_t* commandStreamLenArr, uint32_t numStreams,
+	char16_t* outLog, uint32_t outLogLen) {
+	losgap::RecordingDeviceContext immedContext { };
+	std::vector<std::unique_ptr<losgap::RecordingDeviceContext>> deferredContexts { };
+	std::vector<losgap::RecordingDeviceContext*> deferredContextPtrs { };
+	for (uint32_t i = 0U; i < numStreams; ++i) {
+		deferredContexts.emplace_back(new losgap::RecordingDeviceContext());
+		deferredContextPtrs.push_back(deferredContexts.back().get());
+	}
+
+	losgap::RenderCommandTranslator<losgap::RecordingDeviceContext>::FlushParallel<losgap::RecordingCommandList>(
+		&immedContext, deferredContextPtrs.data(), commandStreamArr, commandStreamLenArr, numStreams
+	);
+
+	losgap::LosgapString { immedContext.Log }.CopyTo(outLog, outLogLen);
+	EXPORT_END;
+}
+
+/*
+Flushes the given compact command stream on to a RecordingDeviceContext with flush profiling enabled, and writes out its profile.
+*/
+EXPORT(ProfileCommandStream, const uint8_t* commandStream, uint32_t commandStreamLenBytes, losgap::FlushProfileSnapshot* outSnapshot) {
+	losgap::RecordingDeviceContext context { };
+	bool profilingWasEnabled = losgap::FlushProfiler::IsEnabled();
+	losgap::FlushProfiler::SetEnabled(true);
+	try {
+		losgap::RenderCommandTranslator<losgap::RecordingDeviceContext>::FlushCompactStream(&context, commandStream, commandStreamLenBytes);
+	}
+	catch (...) {
+		losgap::FlushProfiler::SetEnabled(profilingWasEnabled);
+		throw;
+	}
+	losgap::FlushProfiler::SetEnabled(profilingWasEnabled);
+
+	outSnapshot->DeviceContext = nullptr;
+	outSnapshot->IsImmediateContext = INTEROP_BOOL_FALSE;
+	losgap::FlushProfiler::FillSnapshot(context.Profile, *outSnapshot);
+	EXPORT_END;
+}
+
+/*
+Captures the given compact command stream as though it had just been flushed on to deviceContextPtr. The context is only used as an
+id, so any non-null value will do.
+*/
+EXPORT(CaptureCommandStream, ID3D11DeviceContext* deviceContextPtr, const uint8_t* commandStream, uint32_t commandStreamLenBytes) {
+	losgap::RenderCommandCapture::CaptureCompactStream(deviceContextPtr, commandStream, commandStreamLenBytes);
+	EXPORT_END;
+}
+
+/*
+Captures the given compact command streams as though RenderPassManager::FlushParallel() had just flushed them. As above, the contexts
+are only used as ids.
+*/
+EXPORT(CaptureParallelCommandStreams, ID3D11DeviceContext* immedContextPtr, ID3D11DeviceContext* const* deferredContextPtrArr,
+	const uint8_t* const* commandStreamArr, const uint32_t* commandStreamLenArr, uint32_t numStreams) {
+	losgap::RenderCommandCapture::CaptureParallelFlush(immedContextPtr, deferredContextPtrArr, commandStreamArr, commandStreamLenArr, numStreams);
+	EXPORT_END;
+}
+
+/*
+Culls the given spheres one at a time, as the reference for FrustumCuller::CullSpheres().
+*/
+EXPORT(CullSpheresScalar, const losgap::FrustumPlanes* frustum, const losgap::BoundingSphere* sphereArr, uint32_t numSpheres,
+	uint32_t* outVisibleIndices, uint32_t* outNumVisible) {
+	*outNumVisible = losgap::FrustumCuller::CullSpheresScalar(*frustum, sphereArr, numSpheres, outVisibleIndices);
+	EXPORT_END;
+}
+
+/*
+Times numIterations culls of the given spheres with both the scalar and SSE2 paths.
+*/
+EXPORT(BenchmarkFrustumCuller, const losgap::FrustumPlanes* frustum, const losgap::BoundingSphere* sphereArr, uint32_t numSpheres,
+	uint32_t numIterations, double* outScalarMs, double* outSIMDMs) {
+	std::vector<uint32_t> visibleIndices(numSpheres > 0U ? numSpheres : 1U);
+	uint64_t checksum = 0U;
+
+	auto scalarStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0U; i < numIterations; ++i) {
+		checksum += losgap::FrustumCuller::CullSpheresScalar(*frustum, sphereArr, numSpheres, visibleIndices.data());
+	}
+	auto scalarEnd = std::chrono::high_resolution_clock::now();
+
+	auto simdStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0U; i < numIterations; ++i) {
+		checksum -= losgap::FrustumCuller::CullSpheres(*frustum, sphereArr, numSpheres, visibleIndices.data());
+	}
+	auto simdEnd = std::chrono::high_resolution_clock::now();
+
+	if (checksum != 0U) throw losgap::LosgapException { "Scalar and SIMD culls disagreed on the number of visible spheres." };
+	*outScalarMs = std::chrono::duration<double, std::milli>(scalarEnd - scalarStart).count();
+	*outSIMDMs = std::chrono::duration<double, std::milli>(simdEnd - simdStart).count();
+	EXPORT_END;
+}
+
+/*
+Works out the given instances' screen sizes with LODSelector::CalculateScreenSizes(), as LODSelector::SelectLODs() does.
+*/
+EXPORT(CalculateScreenSizes, const losgap::BoundingSphere* modelSphereArr, uint32_t numModels, const losgap::InstanceTransform* transformArr,
+	const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, INTEROP_BOOL isPerspective,
+	float* outScreenSizeArr) {
+	losgap::LODSelector::CalculateScreenSizes(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, viewPosition,
+		projectionScale, INTEROP_BOOL_TO_CBOOL(isPerspective), outScreenSizeArr);
+	EXPORT_END;
+}
+
+/*
+Works out the given instances' screen sizes one at a time, as the reference for LODSelector::CalculateScreenSizes().
+*/
+EXPORT(CalculateScreenSizesScalar, const losgap::BoundingSphere* modelSphereArr, uint32_t numModels, const losgap::InstanceTransform* transformArr,
+	const uint32_t* modelIndexArr, uint32_t numInstances, const float* viewPosition, float projectionScale, INTEROP_BOOL isPerspective,
+	float* outScreenSizeArr) {
+	losgap::LODSelector::CalculateScreenSizesScalar(modelSphereArr, numModels, transformArr, modelIndexArr, numInstances, viewPosition,
+		projectionScale, INTEROP_BOOL_TO_CBOOL(isPerspective), outScreenSizeArr);
+	EXPORT_END;
+}
+
+#endif
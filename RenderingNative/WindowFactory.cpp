@@ -46,7 +46,7 @@ namespace losgap {
 		windowDesc.hCursor = nullptr;
 		windowDesc.hbrBackground = (HBRUSH) GetStockObject(BLACK_BRUSH);
 		windowDesc.lpszMenuName = nullptr;
-		std::unique_ptr<const wchar_t> className = LosgapString::AsNewCWString(WINDOW_CLASS_NAME + std::to_string(windowClassIncrementer++));
+		std::unique_ptr<const wchar_t[]> className = LosgapString::AsNewCWString(WINDOW_CLASS_NAME + std::to_string(windowClassIncrementer++));
 		windowDesc.lpszClassName = className.get();
 		windowDesc.hIconSm = nullptr;
 